@@ -16,26 +16,14 @@
 #include <framework/datastore/StoreArray.h>
 #include <framework/datastore/StoreObjPtr.h>
 
+#include <Math/LorentzRotation.h>
+#include <Math/Vector4D.h>
+
+#include <cstdint>
 #include <vector>
-#include <set>
-#include <unordered_set>
-#include <unordered_map>
 
 #include <utility>
 
-#include <boost/functional/hash/extensions.hpp>
-
-namespace std {
-  /** Hash function used by unordered_set. */
-  template<> struct hash<std::set<int>> {
-    /** Actual work done by boost. */
-    std::size_t operator()(const std::set<int>& v) const
-    {
-      return boost::hash_value(v);
-    }
-  };
-}
-
 namespace Belle2 {
 
   /**
@@ -66,6 +54,13 @@ namespace Belle2 {
      */
     const std::vector<unsigned int>& getCurrentIndices() const;
 
+    /**
+     * Skips the remaining combinations which differ from the current one only in the indices of the lists
+     * before the given one, so the next loaded combination has a different index in the given or a later list.
+     * @param list index of the list whose current index is kept
+     */
+    void skipInnerLists(unsigned int list);
+
 
   private:
 
@@ -116,11 +111,62 @@ namespace Belle2 {
 
   };
 
+  /**
+   * CombinationSet keeps track of the combinations of daughter IDs accepted by the ParticleGenerator.
+   * All combinations have the same number of IDs, which are sorted before they are compared, so the
+   * order of the daughters does not matter. The IDs of all combinations are stored contiguously and
+   * found with an open addressing hash table. Clearing the set keeps the allocated memory, so no
+   * allocations are needed once the set has grown to the size needed by the largest event.
+   */
+  class CombinationSet {
+  public:
+    /**
+     * Removes all combinations and sets the number of IDs per combination
+     * @param combinationSize number of IDs per combination
+     */
+    void init(unsigned int combinationSize);
+
+    /**
+     * Inserts the combination of the given IDs, which are sorted in place.
+     * @param ids pointer to the IDs, the number of IDs is given by init()
+     * @return false if the combination was already in the set
+     */
+    bool insert(int* ids);
+
+    /**
+     * Returns the number of combinations in the set
+     */
+    size_t size() const { return m_hashes.size(); }
+
+  private:
+    /** One slot of the hash table */
+    struct Slot {
+      uint32_t generation; /**< Slot is empty unless this is equal to the current generation */
+      uint32_t combination; /**< Index of the combination in the slot */
+    };
+
+    /** Doubles the number of slots and inserts all combinations again */
+    void grow();
+
+    unsigned int m_combinationSize = 0; /**< Number of IDs per combination */
+    uint32_t m_generation = 1; /**< Incremented by init() to empty all slots at once */
+    std::vector<int> m_ids; /**< IDs of all combinations, m_combinationSize per combination */
+    std::vector<uint64_t> m_hashes; /**< Hashes of all combinations */
+    std::vector<Slot> m_slots; /**< Hash table, number of slots is a power of two */
+  };
+
   /**
    * ParticleGenerator is a generator for all the particles combined from the given ParticleLists.
+   *
+   * Comparisons of the mass (M, InvM) or momentum (p, useCMSFrame(p)) with constants, which have to be
+   * true for a particle to pass the cut, are checked on the sum of the daughter 4-vectors before the
+   * Particle object is created. The masses and momenta of the daughters are used to skip whole blocks of
+   * index combinations which cannot pass them, the order of the generated particles is not changed.
    */
   class ParticleGenerator {
   public:
+    /** Relative tolerance added to the ranges of the kinematic pre-cuts to cover rounding differences */
+    static constexpr double c_preCutTolerance = 1e-6;
 
   public:
     /**
@@ -180,8 +226,33 @@ namespace Belle2 {
   private:
     /**
      * Create current particle object
+     * @param momentum sum of the 4-vectors of the daughters, see getCurrentMomentum()
+     */
+    Particle createCurrentParticle(const ROOT::Math::PxPyPzEVector& momentum) const;
+
+    /**
+     * Returns the sum of the 4-vectors of the particles of the current combination
      */
-    Particle createCurrentParticle() const;
+    ROOT::Math::PxPyPzEVector getCurrentMomentum() const;
+
+    /**
+     * Reads the ranges of mass and momentum required by the cut, which are checked before the particle is created.
+     */
+    void initPreCuts();
+
+    /**
+     * Initialises the ParticleIndexGenerator to combine the given sublists of the ParticleLists
+     * and stores the masses and momenta of their particles if they are used to skip combinations.
+     * @param types type of the sublist of each ParticleList
+     * @param useAntiParticle use the anti-particle sublist of flavor specific particles
+     */
+    void initParticleIndexGenerator(const std::vector<ParticleList::EParticleType>& types, bool useAntiParticle);
+
+    /**
+     * Loads the next combination of the current sublists which passes all checks.
+     * Returns false if there is no next combination
+     */
+    bool loadNextCombination();
 
     /**
      * Loads the next combination. Returns false if there is no next combination
@@ -203,6 +274,22 @@ namespace Belle2 {
      */
     bool currentCombinationHasDifferentSources();
 
+    /**
+     * Check the mass and momentum of the sum of the daughter 4-vectors against the ranges required by the cut.
+     * @param momentum sum of the 4-vectors of the daughters
+     * @return false if the combined particle cannot pass the cut
+     */
+    bool currentCombinationPassesPreCuts(const ROOT::Math::PxPyPzEVector& momentum) const;
+
+    /**
+     * If the current combination is the first of a block of combinations which differ only in the indices of the
+     * first lists, check whether the sums of the daughter masses or momenta exclude the whole block.
+     * In this case the block is skipped in the ParticleIndexGenerator.
+     *
+     * @return true if the current combination and the rest of its block were skipped
+     */
+    bool currentBlockIsPruned();
+
     /**
      * Check that the combination is unique. Especially in the case of reconstructing
      * self conjugated decays we get combinations like M -> A B and M -> B A. These two
@@ -266,15 +353,33 @@ namespace Belle2 {
     const StoreArray<Particle> m_particleArray; /**< Global list of particles. */
     std::vector<Particle*> m_particles; /**< Pointers to the particle objects of the current combination */
     std::vector<int> m_indices;         /**< Indices stored in the ParticleLists of the current combination */
-    std::unordered_set<std::set<int>> m_usedCombinations; /**< already used combinations (as sets of indices or unique IDs). */
+    std::vector<int> m_combinationIDs;  /**< Indices or unique IDs of the current combination, sorted by CombinationSet */
+    CombinationSet m_usedCombinations;  /**< already used combinations (as sorted indices or unique IDs). */
 
     bool m_inputListsCollide; /**< True if the daughter lists can contain copies of Particles */
     std::vector<std::pair<unsigned, unsigned>> m_collidingLists; /**< pairs of lists that can contain copies. */
-    std::unordered_map<int, int>
-    m_indicesToUniqueIDs; /**< map of store array indices of input Particles to their unique IDs. Necessary if input lists collide. */
+    std::vector<int>
+    m_indicesToUniqueIDs; /**< unique IDs of input Particles by store array index - m_uniqueIDsOffset, 0 if not assigned. Necessary if input lists collide. */
+    int m_uniqueIDsOffset{0}; /**< smallest store array index in the input lists, first index covered by m_indicesToUniqueIDs */
 
     std::unique_ptr<Variable::Cut> m_cut; /**< cut object which performs the cuts */
 
+    std::pair<double, double> m_massRange; /**< range of the mass required by the cut */
+    std::pair<double, double> m_momentumRange; /**< range of the momentum in the current frame required by the cut */
+    std::pair<double, double> m_cmsMomentumRange; /**< range of the momentum in the CMS frame required by the cut */
+    bool m_hasMassPreCut{false}; /**< True if the cut constrains the mass */
+    bool m_hasMomentumPreCut{false}; /**< True if the cut constrains the momentum in the current frame */
+    bool m_hasCMSMomentumPreCut{false}; /**< True if the cut constrains the momentum in the CMS frame */
+    ROOT::Math::LorentzRotation m_labToCms; /**< transformation to the CMS frame in the current event */
+
+    std::vector<const std::vector<int>*> m_currentLists; /**< sublists of the ParticleLists which are currently combined */
+    bool m_pruneMass{false}; /**< True if the daughter masses are used to skip combinations of the current sublists */
+    bool m_pruneMomentum{false}; /**< True if the daughter momenta are used to skip combinations of the current sublists */
+    std::vector<std::vector<double>> m_daughterMasses; /**< masses of the particles in the current sublists */
+    std::vector<std::vector<double>> m_daughterMomenta; /**< momenta of the particles in the current sublists */
+    std::vector<double> m_innerMinMass; /**< sum of the smallest masses in the current sublists before each list */
+    std::vector<double> m_innerMaxMomentum; /**< sum of the largest momenta in the current sublists before each list */
+
     Particle m_current_particle; /**< The current Particle object generated by this combiner */
   };
 
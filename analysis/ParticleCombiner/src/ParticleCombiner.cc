@@ -10,7 +10,11 @@
 
 #include <analysis/DecayDescriptor/DecayDescriptor.h>
 #include <analysis/DecayDescriptor/DecayDescriptorParticle.h>
+#include <analysis/VariableManager/Manager.h>
+#include <analysis/utility/PCmsLabTransform.h>
+#include <analysis/utility/ReferenceFrame.h>
 
+#include <framework/gearbox/Const.h>
 #include <framework/logging/Logger.h>
 
 #include <mdst/dataobjects/ECLCluster.h>
@@ -18,6 +22,8 @@
 #include <Math/Vector4D.h>
 
 #include <algorithm>
+#include <cmath>
+#include <limits>
 
 namespace Belle2 {
 
@@ -73,6 +79,19 @@ namespace Belle2 {
     return indices;
   }
 
+  void ParticleIndexGenerator::skipInnerLists(unsigned int list)
+  {
+    // move the inner lists to their last index, loadNext then continues with the next index of the given list
+    unsigned int position = 0;
+    unsigned int stride = 1;
+    for (unsigned int i = 0; i < m_numberOfLists; ++i) {
+      if (i < list) indices[i] = sizes[i] - 1;
+      position += indices[i] * stride;
+      stride *= sizes[i];
+    }
+    m_iCombination = position + 1;
+  }
+
   void ListIndexGenerator::init(unsigned int _numberOfLists)
   {
     m_numberOfLists = _numberOfLists;
@@ -103,6 +122,57 @@ namespace Belle2 {
     return m_types;
   }
 
+  void CombinationSet::init(unsigned int combinationSize)
+  {
+    m_combinationSize = combinationSize;
+    m_ids.clear();
+    m_hashes.clear();
+    // empty all slots without touching them, unless the generation counter wraps around
+    if (++m_generation == 0) {
+      std::fill(m_slots.begin(), m_slots.end(), Slot{0, 0});
+      m_generation = 1;
+    }
+  }
+
+  bool CombinationSet::insert(int* ids)
+  {
+    std::sort(ids, ids + m_combinationSize);
+    uint64_t hash = m_combinationSize;
+    for (unsigned int i = 0; i < m_combinationSize; ++i) {
+      hash = (hash ^ static_cast<uint32_t>(ids[i])) * 0xff51afd7ed558ccdULL;
+      hash ^= hash >> 32;
+    }
+
+    // keep at most half of the slots occupied
+    if (2 * (m_hashes.size() + 1) > m_slots.size()) grow();
+
+    const size_t mask = m_slots.size() - 1;
+    for (size_t index = hash & mask;; index = (index + 1) & mask) {
+      Slot& slot = m_slots[index];
+      if (slot.generation != m_generation) {
+        slot = Slot{m_generation, static_cast<uint32_t>(m_hashes.size())};
+        m_hashes.push_back(hash);
+        m_ids.insert(m_ids.end(), ids, ids + m_combinationSize);
+        return true;
+      }
+      if (m_hashes[slot.combination] == hash and
+          std::equal(ids, ids + m_combinationSize, m_ids.begin() + slot.combination * m_combinationSize))
+        return false;
+    }
+  }
+
+  void CombinationSet::grow()
+  {
+    m_slots.assign(std::max<size_t>(64, 2 * m_slots.size()), Slot{0, 0});
+    m_generation = 1;
+    const size_t mask = m_slots.size() - 1;
+    for (uint32_t combination = 0; combination < m_hashes.size(); ++combination) {
+      size_t index = m_hashes[combination] & mask;
+      while (m_slots[index].generation == m_generation) index = (index + 1) & mask;
+      m_slots[index] = Slot{m_generation, combination};
+    }
+  }
+
   ParticleGenerator::ParticleGenerator(const std::string& decayString, const std::string& cutParameter) : m_iParticleType(0),
     m_listIndexGenerator(),
     m_particleIndexGenerator()
@@ -135,6 +205,7 @@ namespace Belle2 {
     }
 
     m_cut = Variable::Cut::compile(cutParameter);
+    initPreCuts();
 
     m_isSelfConjugated = decaydescriptor.isSelfConjugated();
 
@@ -190,6 +261,7 @@ namespace Belle2 {
     }
 
     m_cut = Variable::Cut::compile(cutParameter);
+    initPreCuts();
 
     m_isSelfConjugated = decaydescriptor.isSelfConjugated();
 
@@ -214,15 +286,62 @@ namespace Belle2 {
 
   }
 
+  void ParticleGenerator::initPreCuts()
+  {
+    const double inf = std::numeric_limits<double>::infinity();
+    m_massRange = m_momentumRange = m_cmsMomentumRange = {-inf, inf};
+    m_hasMassPreCut = m_hasMomentumPreCut = m_hasCMSMomentumPreCut = false;
+
+    // the mass of stable charged particles is set to the nominal value, so their
+    // kinematics differ from the sum of the daughter 4-vectors
+    if (Const::chargedStableSet.find(abs(m_pdgCode)) == Const::ParticleType(abs(m_pdgCode)))
+      return;
+
+    // InvM of a newly combined particle is the mass of the sum of the daughter 4-vectors
+    auto restrictRange = [this](const std::string & name, std::pair<double, double>& range) {
+      const Variable::Manager::Var* var = Variable::Manager::Instance().getVariable(name);
+      if (not var) return;
+      const std::pair<double, double> required = m_cut->getRequiredRange(var);
+      range.first = std::max(range.first, required.first);
+      range.second = std::min(range.second, required.second);
+    };
+    restrictRange("M", m_massRange);
+    restrictRange("InvM", m_massRange);
+    restrictRange("p", m_momentumRange);
+    restrictRange("useCMSFrame(p)", m_cmsMomentumRange);
+
+    // widen the ranges, the particle is only rejected if it certainly fails the cut
+    for (auto* range : {&m_massRange, &m_momentumRange, &m_cmsMomentumRange}) {
+      range->first -= c_preCutTolerance * std::max(1.0, std::abs(range->first));
+      range->second += c_preCutTolerance * std::max(1.0, std::abs(range->second));
+    }
+    m_hasMassPreCut = m_massRange.first > -inf or m_massRange.second < inf;
+    m_hasMomentumPreCut = m_momentumRange.first > -inf or m_momentumRange.second < inf;
+    m_hasCMSMomentumPreCut = m_cmsMomentumRange.first > -inf or m_cmsMomentumRange.second < inf;
+  }
+
   void ParticleGenerator::init()
   {
     m_iParticleType = 0;
 
     m_particleIndexGenerator.init(std::vector<unsigned int> {}); // ParticleIndexGenerator will be initialised on first call
     m_listIndexGenerator.init(m_numberOfLists); // ListIndexGenerator must be initialised here!
-    m_usedCombinations.clear();
+    m_usedCombinations.init(m_numberOfLists);
     m_indices.resize(m_numberOfLists);
+    m_combinationIDs.resize(m_numberOfLists);
     m_particles.resize(m_numberOfLists);
+    m_currentLists.resize(m_numberOfLists);
+    m_daughterMasses.resize(m_numberOfLists);
+    m_daughterMomenta.resize(m_numberOfLists);
+    m_innerMinMass.resize(m_numberOfLists);
+    m_innerMaxMomentum.resize(m_numberOfLists);
+    m_pruneMass = m_pruneMomentum = false;
+
+    // the beam parameters can change between events
+    if (m_hasCMSMomentumPreCut) {
+      PCmsLabTransform T;
+      m_labToCms = T.rotateLabToCms();
+    }
 
     if (m_inputListsCollide)
       initIndicesToUniqueIDMap();
@@ -230,13 +349,22 @@ namespace Belle2 {
 
   void ParticleGenerator::initIndicesToUniqueIDMap()
   {
-    m_indicesToUniqueIDs.clear();
-
-    unsigned inputParticlesCount = 0;
-    for (unsigned int i = 0; i < m_numberOfLists; ++i)
-      inputParticlesCount +=  m_plists[i]->getListSize();
-
-    m_indicesToUniqueIDs.reserve(inputParticlesCount);
+    // the map only covers the range of store array indices in the input lists, not all Particles of the event
+    int minIndex = std::numeric_limits<int>::max();
+    int maxIndex = -1;
+    for (unsigned i = 0; i < m_numberOfLists; i++) {
+      for (const std::vector<int>* indices : {&m_plists[i]->getList(ParticleList::c_FlavorSpecificParticle, false),
+                                             &m_plists[i]->getList(ParticleList::c_FlavorSpecificParticle, true),
+                                             &m_plists[i]->getList(ParticleList::c_SelfConjugatedParticle)
+                                            }) {
+        for (int index : *indices) {
+          minIndex = std::min(minIndex, index);
+          maxIndex = std::max(maxIndex, index);
+        }
+      }
+    }
+    m_uniqueIDsOffset = maxIndex < 0 ? 0 : minIndex;
+    m_indicesToUniqueIDs.assign(maxIndex + 1 - m_uniqueIDsOffset, 0);
 
     int uniqueID = 1;
 
@@ -285,13 +413,13 @@ namespace Belle2 {
     const Particle* A, *B;
     bool copies = false;
     for (int i : listA) {
-      bool aIsAlreadyIn = m_indicesToUniqueIDs.count(i) ? true : false;
+      bool aIsAlreadyIn = m_indicesToUniqueIDs[ i - m_uniqueIDsOffset ] != 0;
 
       if (not aIsAlreadyIn)
-        m_indicesToUniqueIDs[ i ] = uniqueID++;
+        m_indicesToUniqueIDs[ i - m_uniqueIDsOffset ] = uniqueID++;
 
       for (int j : listB) {
-        bool bIsAlreadyIn = m_indicesToUniqueIDs.count(j) ? true : false;
+        bool bIsAlreadyIn = m_indicesToUniqueIDs[ j - m_uniqueIDsOffset ] != 0;
 
         if (bIsAlreadyIn)
           continue;
@@ -302,7 +430,7 @@ namespace Belle2 {
         copies = B->isCopyOf(A);
 
         if (copies)
-          m_indicesToUniqueIDs[ j ] = m_indicesToUniqueIDs[ i ];
+          m_indicesToUniqueIDs[ j - m_uniqueIDsOffset ] = m_indicesToUniqueIDs[ i - m_uniqueIDsOffset ];
       }
     }
   }
@@ -311,10 +439,10 @@ namespace Belle2 {
   void ParticleGenerator::fillIndicesToUniqueIDMap(const std::vector<int>& listA, int& uniqueID)
   {
     for (int i : listA) {
-      bool aIsAlreadyIn = m_indicesToUniqueIDs.count(i) ? true : false;
+      bool aIsAlreadyIn = m_indicesToUniqueIDs[ i - m_uniqueIDsOffset ] != 0;
 
       if (not aIsAlreadyIn)
-        m_indicesToUniqueIDs[ i ] = uniqueID++;
+        m_indicesToUniqueIDs[ i - m_uniqueIDsOffset ] = uniqueID++;
     }
   }
 
@@ -344,11 +472,7 @@ namespace Belle2 {
       else ++m_iParticleType;
 
       if (m_iParticleType == 2) {
-        std::vector<unsigned int> sizes(m_numberOfLists);
-        for (unsigned int i = 0; i < m_numberOfLists; ++i) {
-          sizes[i] = m_plists[i]->getList(ParticleList::c_SelfConjugatedParticle, false).size();
-        }
-        m_particleIndexGenerator.init(sizes);
+        initParticleIndexGenerator(std::vector<ParticleList::EParticleType>(m_numberOfLists, ParticleList::c_SelfConjugatedParticle), false);
       } else {
         m_listIndexGenerator.init(m_numberOfLists);
       }
@@ -356,83 +480,106 @@ namespace Belle2 {
     }
   }
 
-  bool ParticleGenerator::loadNextParticle(bool useAntiParticle)
+  void ParticleGenerator::initParticleIndexGenerator(const std::vector<ParticleList::EParticleType>& types, bool useAntiParticle)
   {
-    while (true) {
+    std::vector<unsigned int> sizes(m_numberOfLists);
+    for (unsigned int i = 0; i < m_numberOfLists; ++i) {
+      m_currentLists[i] = &m_plists[i]->getList(types[i], types[i] == ParticleList::c_FlavorSpecificParticle ? useAntiParticle : false);
+      sizes[i] = m_currentLists[i]->size();
+    }
+    m_particleIndexGenerator.init(sizes);
 
-      // Load next index combination if available
-      if (m_particleIndexGenerator.loadNext()) {
+    // skipping blocks of combinations needs at least two lists and a bound which the sums of daughter masses or momenta can exceed
+    const bool nonEmpty = std::find(sizes.begin(), sizes.end(), 0u) == sizes.end();
+    m_pruneMass = m_hasMassPreCut and m_massRange.second < std::numeric_limits<double>::infinity() and m_numberOfLists > 1 and nonEmpty;
+    m_pruneMomentum = m_hasMomentumPreCut and m_momentumRange.first > 0 and m_numberOfLists > 1 and nonEmpty;
+    if (not m_pruneMass and not m_pruneMomentum) return;
 
-        const auto& m_types = m_listIndexGenerator.getCurrentIndices();
-        const auto& indices = m_particleIndexGenerator.getCurrentIndices();
+    const ReferenceFrame& frame = ReferenceFrame::GetCurrent();
+    double innerMass = 0;
+    double innerMomentum = 0;
+    for (unsigned int i = 0; i < m_numberOfLists; ++i) {
+      m_innerMinMass[i] = innerMass;
+      m_innerMaxMomentum[i] = innerMomentum;
+
+      const std::vector<int>& list = *m_currentLists[i];
+      std::vector<double>& masses = m_daughterMasses[i];
+      std::vector<double>& momenta = m_daughterMomenta[i];
+      masses.resize(list.size());
+      momenta.resize(list.size());
+      double minMass = std::numeric_limits<double>::infinity();
+      double maxMomentum = 0;
+      for (size_t j = 0; j < list.size(); ++j) {
+        const Particle* d = m_particleArray[list[j]];
+        const ROOT::Math::PxPyPzEVector vec(d->getPx(), d->getPy(), d->getPz(), d->getEnergy());
+        // the mass of a sum is only bounded by the sum of the masses for 4-vectors with E >= |p|
+        if (not(vec.E() >= vec.P())) m_pruneMass = false;
+        masses[j] = vec.M();
+        momenta[j] = frame.getMomentum(vec).P();
+        minMass = std::min(minMass, masses[j]);
+        maxMomentum = std::max(maxMomentum, momenta[j]);
+      }
+      innerMass += minMass;
+      innerMomentum += maxMomentum;
+    }
+  }
 
-        for (unsigned int i = 0; i < m_numberOfLists; i++) {
-          const auto& list = m_plists[i]->getList(m_types[i], m_types[i] == ParticleList::c_FlavorSpecificParticle ? useAntiParticle : false);
-          m_indices[i] =  list[ indices[i] ];
-          m_particles[i] = m_particleArray[ m_indices[i] ];
-        }
+  bool ParticleGenerator::loadNextCombination()
+  {
+    while (m_particleIndexGenerator.loadNext()) {
 
-        if (not currentCombinationHasDifferentSources()) continue;
+      if ((m_pruneMass or m_pruneMomentum) and currentBlockIsPruned()) continue;
 
-        m_current_particle = createCurrentParticle();
-        if (!m_cut->check(&m_current_particle))
-          continue;
+      const auto& indices = m_particleIndexGenerator.getCurrentIndices();
 
-        if (not currentCombinationIsUnique()) continue;
+      for (unsigned int i = 0; i < m_numberOfLists; i++) {
+        m_indices[i] = (*m_currentLists[i])[ indices[i] ];
+        m_particles[i] = m_particleArray[ m_indices[i] ];
+      }
 
-        if (not currentCombinationIsECLCRUnique()) continue;
+      // the kinematics are checked on the stack before the particle is created
+      const ROOT::Math::PxPyPzEVector momentum = getCurrentMomentum();
+      if (not currentCombinationPassesPreCuts(momentum)) continue;
 
-        return true;
-      }
+      if (not currentCombinationHasDifferentSources()) continue;
 
-      // Load next list combination if available and reset indexCombiner
-      if (m_listIndexGenerator.loadNext()) {
-        const auto& m_types = m_listIndexGenerator.getCurrentIndices();
-        std::vector<unsigned int> sizes(m_numberOfLists);
-        for (unsigned int i = 0; i < m_numberOfLists; ++i) {
-          sizes[i] = m_plists[i]->getList(m_types[i], m_types[i] == ParticleList::c_FlavorSpecificParticle ? useAntiParticle : false).size();
-        }
-        m_particleIndexGenerator.init(sizes);
+      m_current_particle = createCurrentParticle(momentum);
+      if (!m_cut->check(&m_current_particle))
         continue;
-      }
-      return false;
+
+      if (not currentCombinationIsUnique()) continue;
+
+      if (not currentCombinationIsECLCRUnique()) continue;
+
+      return true;
     }
 
+    return false;
   }
 
-  bool ParticleGenerator::loadNextSelfConjugatedParticle()
+  bool ParticleGenerator::loadNextParticle(bool useAntiParticle)
   {
     while (true) {
 
       // Load next index combination if available
-      if (m_particleIndexGenerator.loadNext()) {
-
-        const auto& indices = m_particleIndexGenerator.getCurrentIndices();
-
-        for (unsigned int i = 0; i < m_numberOfLists; i++) {
-          m_indices[i] = m_plists[i]->getList(ParticleList::c_SelfConjugatedParticle, false) [ indices[i] ];
-          m_particles[i] = m_particleArray[ m_indices[i] ];
-        }
-
-        if (not currentCombinationHasDifferentSources()) continue;
-
-        m_current_particle = createCurrentParticle();
-        if (!m_cut->check(&m_current_particle))
-          continue;
-
-        if (not currentCombinationIsUnique()) continue;
+      if (loadNextCombination()) return true;
 
-        if (not currentCombinationIsECLCRUnique()) continue;
-
-        return true;
+      // Load next list combination if available and reset indexCombiner
+      if (m_listIndexGenerator.loadNext()) {
+        initParticleIndexGenerator(m_listIndexGenerator.getCurrentIndices(), useAntiParticle);
+        continue;
       }
-
       return false;
     }
 
   }
 
-  Particle ParticleGenerator::createCurrentParticle() const
+  bool ParticleGenerator::loadNextSelfConjugatedParticle()
+  {
+    return loadNextCombination();
+  }
+
+  ROOT::Math::PxPyPzEVector ParticleGenerator::getCurrentMomentum() const
   {
     double px = 0;
     double py = 0;
@@ -444,8 +591,11 @@ namespace Belle2 {
       pz += d->getPz();
       E += d->getEnergy();
     }
-    const ROOT::Math::PxPyPzEVector vec(px, py, pz, E);
+    return ROOT::Math::PxPyPzEVector(px, py, pz, E);
+  }
 
+  Particle ParticleGenerator::createCurrentParticle(const ROOT::Math::PxPyPzEVector& vec) const
+  {
     switch (m_iParticleType) {
       case 0: return Particle(vec, m_pdgCode, m_isSelfConjugated ? Particle::c_Unflavored : Particle::c_Flavored, m_indices,
                                 m_properties, m_daughterProperties,
@@ -493,17 +643,53 @@ namespace Belle2 {
   }
 
 
+  bool ParticleGenerator::currentCombinationPassesPreCuts(const ROOT::Math::PxPyPzEVector& momentum) const
+  {
+    auto outside = [](double value, const std::pair<double, double>& range) {
+      return value < range.first or value > range.second;
+    };
+    if (m_hasMassPreCut and outside(momentum.M(), m_massRange)) return false;
+    if (m_hasMomentumPreCut and outside(ReferenceFrame::GetCurrent().getMomentum(momentum).P(), m_momentumRange)) return false;
+    if (m_hasCMSMomentumPreCut and outside((m_labToCms * momentum).P(), m_cmsMomentumRange)) return false;
+    return true;
+  }
+
+  bool ParticleGenerator::currentBlockIsPruned()
+  {
+    const auto& indices = m_particleIndexGenerator.getCurrentIndices();
+
+    // the block of combinations with fixed indices in the lists k, ..., n-1 starts
+    // when the indices of all lists before k are 0
+    unsigned int nLeadingZeros = 0;
+    while (nLeadingZeros < m_numberOfLists and indices[nLeadingZeros] == 0) ++nLeadingZeros;
+    if (nLeadingZeros == 0) return false;
+
+    // check the largest block first: the mass of the combination is at least
+    // the sum of the daughter masses, its momentum at most the sum of the daughter momenta
+    double outerMass = 0;
+    double outerMomentum = 0;
+    for (unsigned int k = m_numberOfLists - 1; k > 0; --k) {
+      outerMass += m_daughterMasses[k][indices[k]];
+      outerMomentum += m_daughterMomenta[k][indices[k]];
+      if (k > nLeadingZeros) continue;
+      if ((m_pruneMass and outerMass + m_innerMinMass[k] > m_massRange.second) or
+          (m_pruneMomentum and outerMomentum + m_innerMaxMomentum[k] < m_momentumRange.first)) {
+        m_particleIndexGenerator.skipInnerLists(k);
+        return true;
+      }
+    }
+    return false;
+  }
+
   bool ParticleGenerator::currentCombinationIsUnique()
   {
-    std::set<int> indexSet;
     if (not m_inputListsCollide)
-      indexSet.insert(m_indices.begin(), m_indices.end());
+      std::copy(m_indices.begin(), m_indices.end(), m_combinationIDs.begin());
     else
       for (unsigned int i = 0; i < m_numberOfLists; i++)
-        indexSet.insert(m_indicesToUniqueIDs.at(m_indices[i]));
+        m_combinationIDs[i] = m_indicesToUniqueIDs[m_indices[i] - m_uniqueIDsOffset];
 
-    bool elementInserted = m_usedCombinations.insert(indexSet).second;
-    return elementInserted;
+    return m_usedCombinations.insert(m_combinationIDs.data());
   }
 
   bool ParticleGenerator::inputListsCollide(const std::pair<unsigned, unsigned>& pair) const
@@ -572,9 +758,10 @@ namespace Belle2 {
     if (not m_inputListsCollide)
       return 0;
 
-    if (not m_indicesToUniqueIDs.count(index))
+    index -= m_uniqueIDsOffset;
+    if (index < 0 or index >= (int)m_indicesToUniqueIDs.size() or m_indicesToUniqueIDs[index] == 0)
       return -1;
 
-    return m_indicesToUniqueIDs.at(index);
+    return m_indicesToUniqueIDs[index];
   }
 }
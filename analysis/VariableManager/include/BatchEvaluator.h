@@ -0,0 +1,95 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <analysis/VariableManager/Manager.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace Belle2 {
+  class Particle;
+  class ParticleList;
+
+  namespace Variable {
+    /**
+     * Evaluate a list of variables for many particles at once and store the results in one column per variable.
+     *
+     * Variables of the form daughter(i, daughter(j, var)) are split into the path to the daughter and
+     * the variable evaluated on it. Variables with the same path share one lookup of the daughter, and the
+     * variables of a daughter which appears in several candidates (e.g. the same D0 in many B candidates)
+     * are evaluated only once per call of evaluate(). This assumes that a variable only depends on the
+     * particle it is evaluated for, which holds for all variables except the ones returning random numbers.
+     *
+     * Example:
+        \code
+        BatchEvaluator evaluator(Manager::Instance().getVariables({"M", "daughter(0, p)", "daughter(0, E)"}));
+        evaluator.evaluate(*particleList);
+        for (size_t row = 0; row < evaluator.getNumberOfRows(); ++row)
+          B2INFO(std::get<double>(evaluator.getValue(1, row)));
+        \endcode
+     */
+    class BatchEvaluator {
+    public:
+      /**
+       * Prepare the evaluation of the given variables.
+       * @param variables variables to evaluate, each of them is a column of the result. Must not contain nullptr.
+       */
+      explicit BatchEvaluator(const std::vector<const Manager::Var*>& variables);
+
+      /** Evaluate all variables for the given particles, each particle is a row of the result. nullptr is allowed. */
+      void evaluate(const std::vector<const Particle*>& particles);
+
+      /** Evaluate all variables for all candidates of the given list, in the order of the list. */
+      void evaluate(const ParticleList& list);
+
+      /** Number of particles in the last evaluation. */
+      size_t getNumberOfRows() const { return m_nRows; }
+
+      /** Number of variables. */
+      size_t getNumberOfColumns() const { return m_columns.size(); }
+
+      /** Values of one variable for all particles of the last evaluation. */
+      const std::vector<Manager::VarVariant>& getColumn(size_t column) const { return m_columns[column]; }
+
+      /** Value of one variable for one particle of the last evaluation. */
+      const Manager::VarVariant& getValue(size_t column, size_t row) const { return m_columns[column][row]; }
+
+      /** Number of distinct daughter paths including the particle itself, mainly for testing. */
+      size_t getNumberOfNodes() const { return m_nodes.size(); }
+
+    private:
+      /** A particle reached from the candidate by following a path of daughter indices. */
+      struct Node {
+        int parent; /**< index of the node this one is a daughter of, -1 for the candidate itself */
+        int daughter; /**< index of the daughter in the parent */
+        std::vector<size_t> columns; /**< columns evaluated for the particle of this node */
+      };
+
+      /** Return the node for the given daughter of a parent node, create it if needed. */
+      int getNode(int parent, int daughter);
+
+      /** Evaluate the columns of a daughter node, reusing the values of an earlier row if the particle was seen before. */
+      void evaluateDaughterNode(int node, const Particle* particle, size_t row);
+
+      /** Paths to the daughters, parents come before their daughters. */
+      std::vector<Node> m_nodes;
+      /** Variable evaluated on the particle of the node for each column. */
+      std::vector<const Manager::Var*> m_leaves;
+      /** Values of each column. */
+      std::vector<std::vector<Manager::VarVariant>> m_columns;
+      /** Number of rows of the last evaluation. */
+      size_t m_nRows{0};
+      /** Particle of each node for the current row. */
+      std::vector<const Particle*> m_nodeParticles;
+      /** First row in which each particle was seen, for each node. */
+      std::vector<std::unordered_map<const Particle*, size_t>> m_firstRows;
+    };
+  }
+}
@@ -257,6 +257,7 @@ namespace Belle2 {
 
       /** Evaluate each variable in the vector 'varNames' on given ParticleList and return a flattened vector of values.
        *
+       * The variables are evaluated with a BatchEvaluator, so daughters shared between candidates are evaluated only once.
        * Throws exception if one of the variables isn't found. Assumes 'plist' is != NULL.
        */
       std::vector<double> evaluateVariables(const std::vector<std::string>& varNames, const ParticleList* plist);
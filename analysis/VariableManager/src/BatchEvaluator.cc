@@ -0,0 +1,141 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <analysis/VariableManager/BatchEvaluator.h>
+#include <analysis/dataobjects/Particle.h>
+#include <analysis/dataobjects/ParticleList.h>
+
+#include <framework/gearbox/Const.h>
+#include <framework/utilities/Conversion.h>
+#include <framework/utilities/CutHelpers.h>
+
+#include <boost/algorithm/string.hpp>
+
+#include <regex>
+
+using namespace Belle2;
+using namespace Belle2::Variable;
+
+namespace {
+  /**
+   * If the variable is daughter(N, var) return var and set daughterNumber to N, otherwise return nullptr.
+   * Uses the same variable lookup as the daughter meta variable.
+   */
+  const Manager::Var* splitDaughterVariable(const Manager::Var* var, int& daughterNumber)
+  {
+    static const std::regex daughterRegex("^\\s*daughter\\s*\\((.*)\\)\\s*$");
+    std::smatch results;
+    if (!std::regex_match(var->name, results, daughterRegex)) return nullptr;
+
+    std::vector<std::string> arguments = splitOnDelimiterAndConserveParenthesis(results[1], ',', '(', ')');
+    if (arguments.size() != 2) return nullptr;
+    for (auto& argument : arguments) {
+      boost::algorithm::trim(argument);
+    }
+    try {
+      daughterNumber = convertString<int>(arguments[0]);
+    } catch (std::invalid_argument&) {
+      return nullptr;
+    }
+    if (daughterNumber < 0) return nullptr;
+    return Manager::Instance().getVariable(arguments[1]);
+  }
+
+  /** The daughter meta variable converts all values to double */
+  Manager::VarVariant convertToDouble(const Manager::VarVariant& value)
+  {
+    return std::visit([](auto v) { return static_cast<double>(v); }, value);
+  }
+}
+
+BatchEvaluator::BatchEvaluator(const std::vector<const Manager::Var*>& variables) :
+  m_columns(variables.size())
+{
+  m_nodes.push_back({ -1, 0, {}});
+  for (size_t column = 0; column < variables.size(); ++column) {
+    const Manager::Var* var = variables[column];
+    int node = 0;
+    int daughterNumber = 0;
+    while (const Manager::Var* inner = splitDaughterVariable(var, daughterNumber)) {
+      node = getNode(node, daughterNumber);
+      var = inner;
+    }
+    m_nodes[node].columns.push_back(column);
+    m_leaves.push_back(var);
+  }
+  m_nodeParticles.resize(m_nodes.size());
+  m_firstRows.resize(m_nodes.size());
+}
+
+int BatchEvaluator::getNode(int parent, int daughter)
+{
+  for (size_t node = 0; node < m_nodes.size(); ++node) {
+    if (m_nodes[node].parent == parent and m_nodes[node].daughter == daughter) return node;
+  }
+  m_nodes.push_back({parent, daughter, {}});
+  return m_nodes.size() - 1;
+}
+
+void BatchEvaluator::evaluate(const ParticleList& list)
+{
+  std::vector<const Particle*> particles(list.getListSize());
+  for (size_t i = 0; i < particles.size(); ++i) {
+    particles[i] = list.getParticle(i);
+  }
+  evaluate(particles);
+}
+
+void BatchEvaluator::evaluate(const std::vector<const Particle*>& particles)
+{
+  m_nRows = particles.size();
+  for (auto& column : m_columns) {
+    column.resize(m_nRows);
+  }
+  for (auto& firstRows : m_firstRows) {
+    firstRows.clear();
+  }
+
+  for (size_t row = 0; row < m_nRows; ++row) {
+    m_nodeParticles[0] = particles[row];
+    for (size_t column : m_nodes[0].columns) {
+      m_columns[column][row] = m_leaves[column]->function(particles[row]);
+    }
+    for (size_t node = 1; node < m_nodes.size(); ++node) {
+      const Particle* parent = m_nodeParticles[m_nodes[node].parent];
+      const Particle* particle = nullptr;
+      if (parent and m_nodes[node].daughter < int(parent->getNDaughters()))
+        particle = parent->getDaughter(m_nodes[node].daughter);
+      m_nodeParticles[node] = particle;
+      evaluateDaughterNode(node, particle, row);
+    }
+  }
+}
+
+void BatchEvaluator::evaluateDaughterNode(int node, const Particle* particle, size_t row)
+{
+  const std::vector<size_t>& columns = m_nodes[node].columns;
+  if (columns.empty()) return;
+
+  if (!particle) {
+    for (size_t column : columns) {
+      m_columns[column][row] = Const::doubleNaN;
+    }
+    return;
+  }
+
+  const auto [it, added] = m_firstRows[node].emplace(particle, row);
+  if (!added) {
+    for (size_t column : columns) {
+      m_columns[column][row] = m_columns[column][it->second];
+    }
+    return;
+  }
+  for (size_t column : columns) {
+    m_columns[column][row] = convertToDouble(m_leaves[column]->function(particle));
+  }
+}
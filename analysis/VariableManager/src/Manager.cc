@@ -7,6 +7,7 @@
  **************************************************************************/
 
 #include <analysis/VariableManager/Manager.h>
+#include <analysis/VariableManager/BatchEvaluator.h>
 #include <analysis/dataobjects/Particle.h>
 #include <analysis/dataobjects/ParticleList.h>
 
@@ -492,12 +493,23 @@ double Variable::Manager::evaluate(const std::string& varName, const Particle* p
 
 std::vector<double> Variable::Manager::evaluateVariables(const std::vector<std::string>& varNames, const ParticleList* plist)
 {
+  std::vector<const Var*> variables;
+  for (const std::string& varName : varNames) {
+    const Var* var = getVariable(varName);
+    if (!var) {
+      throw std::runtime_error("Variable::Manager::evaluateVariables(): variable '" + varName + "' not found!");
+    }
+    variables.push_back(var);
+  }
+
+  BatchEvaluator evaluator(variables);
+  evaluator.evaluate(*plist);
+
   std::vector<double> values;
-  values.reserve(varNames.size() * plist->getListSize());
-  for (size_t iPart = 0; iPart < plist->getListSize(); ++iPart) {
-    const Particle* p = plist->getParticle(iPart);
+  values.reserve(varNames.size() * evaluator.getNumberOfRows());
+  for (size_t iPart = 0; iPart < evaluator.getNumberOfRows(); ++iPart) {
     for (size_t iVar = 0; iVar < varNames.size(); ++iVar)
-      values.push_back(evaluate(varNames[iVar], p));
+      values.push_back(std::visit([](auto value) { return static_cast<double>(value); }, evaluator.getValue(iVar, iPart)));
   }
   return values;
 }
@@ -75,6 +75,14 @@ namespace Belle2 {
        * @return error code (zero if success)
        */
       enum KFitError::ECode               setMagneticField(const double mf);
+      /** Tell the object to perform the fit on Eigen matrices instead of CLHEP ones.
+       *  The result is the same, only the matrix algebra of the iteration differs.
+       *  All fits use it except the vertex fits of VertexFitKFit with IP profile or known vertex,
+       *  and its standard vertex fit with more than 4 tracks.
+       * @param flag true for the Eigen implementation, false for the CLHEP one
+       * @return error code (zero if success)
+       */
+      enum KFitError::ECode               setEigenBackend(const bool flag = true);
 
 
       /** Get a code of the last error.
@@ -216,10 +224,22 @@ namespace Belle2 {
        * @return error code (zero if success)
        */
       enum KFitError::ECode doFit1(void);
+      /** Perform the iteration of doFit1() on dynamic-size Eigen matrices.
+       *  The CLHEP members are converted once before and after the iteration,
+       *  only m_al_1 is copied back in each iteration for makeCoreMatrix().
+       * @return error code (zero if success)
+       */
+      enum KFitError::ECode doFit1Eigen(void);
       /** Perform a fit (used in VertexFitKFit::doFit() and MassVertexFitKFit::doFit()).
        * @return error code (zero if success)
        */
       enum KFitError::ECode doFit2(void);
+      /** Perform the iteration of doFit2() on dynamic-size Eigen matrices.
+       *  Like doFit1Eigen(), only m_v_a and m_al_1 are copied back in each iteration
+       *  for prepareInputSubMatrix() and makeCoreMatrix().
+       * @return error code (zero if success)
+       */
+      enum KFitError::ECode doFit2Eigen(void);
 
 
     protected:
@@ -302,6 +322,8 @@ namespace Belle2 {
       bool     m_FlagCorrelation;
       /** Flag whether the iteration count exceeds the limit. */
       bool     m_FlagOverIteration;
+      /** Flag controlled by setEigenBackend(). */
+      bool     m_EigenBackend;
 
       /** Magnetic field. */
       double   m_MagneticField;
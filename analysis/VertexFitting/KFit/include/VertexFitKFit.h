@@ -130,6 +130,11 @@ namespace Belle2 {
        * @return error code (zero if success)
        */
       enum KFitError::ECode doFit5(void);
+      /** Perform the standard vertex-constraint fit of doFit3() with VertexFitKFitKernel.
+       * @return error code (zero if success)
+       */
+      template <int NTracks>
+      enum KFitError::ECode doFit3Eigen(void);
 
 
     private:
@@ -0,0 +1,149 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <analysis/VertexFitting/KFit/KFitConst.h>
+#include <analysis/VertexFitting/KFit/KFitError.h>
+
+#include <Eigen/Core>
+
+namespace Belle2 {
+
+  namespace analysis {
+
+    /**
+     * Vertex-constraint fit without track correlations on fixed-size Eigen matrices.
+     *
+     * This is the algorithm of VertexFitKFit::doFit3() for a number of tracks known at compile time,
+     * so all matrices live on the stack. The interface does not depend on CLHEP, VertexFitKFit converts
+     * the input tracks and the results. Explicit instantiations exist for 2, 3 and 4 tracks.
+     */
+    template <int NTracks>
+    class VertexFitKFitKernel {
+    public:
+      /** Number of track parameters: momentum and position of each track. */
+      static constexpr int c_NPar = KFitConst::kNumber6 * NTracks;
+      /** Number of constraints: two per track. */
+      static constexpr int c_NCon = 2 * NTracks;
+
+      /** Track parameters of all tracks. */
+      typedef Eigen::Matrix<double, c_NPar, 1> ParVector;
+      /** Error matrix of the track parameters. */
+      typedef Eigen::Matrix<double, c_NPar, c_NPar> ParMatrix;
+      /** Vertex position. */
+      typedef Eigen::Matrix<double, 3, 1> VertexVector;
+      /** Vertex error matrix. */
+      typedef Eigen::Matrix<double, 3, 3> VertexMatrix;
+      /** Covariance between the vertex and the track parameters. */
+      typedef Eigen::Matrix<double, 3, c_NPar> VertexParMatrix;
+
+      /** Construct a kernel without tracks. */
+      VertexFitKFitKernel();
+
+      /** Set the parameters of a track.
+       * @param id track id
+       * @param par momentum x,y,z and position x,y,z of the track
+       * @param error (6x6) error matrix of the track parameters
+       * @param a product of -c, the magnetic field and the charge of the track
+       */
+      void setTrack(int id, const Eigen::Matrix<double, 6, 1>& par, const Eigen::Matrix<double, 6, 6>& error, double a);
+
+      /** Set the initial vertex point.
+       * @param v initial vertex point
+       */
+      void setInitialVertex(const VertexVector& v) { m_v_a = v; }
+
+      /** Perform the fit.
+       * @return error code (zero if success)
+       */
+      enum KFitError::ECode doFit();
+
+      /** Get the track parameters after the fit. */
+      const ParVector& getParameters() const { return m_al_1; }
+      /** Get the error matrix of the track parameters after the fit. */
+      const ParMatrix& getParameterError() const { return m_V_al_1; }
+      /** Get the vertex position after the fit. */
+      const VertexVector& getVertex() const { return m_v_a; }
+      /** Get the vertex error matrix after the fit. */
+      const VertexMatrix& getVertexError() const { return m_V_E; }
+      /** Get the covariance between the vertex and the track parameters after the fit. */
+      const VertexParMatrix& getVertexParameterCovariance() const { return m_Cov_v_al_1; }
+      /** Get the chi-square of the fit. */
+      double getCHIsq() const { return m_CHIsq; }
+      /** Get the chi-square of a track.
+       * @param id track id
+       */
+      double getTrackCHIsq(int id) const { return m_EachCHIsq[id]; }
+      /** Return true if the fit reached the maximum number of iterations. */
+      bool isOverIteration() const { return m_FlagOverIteration; }
+
+    private:
+      /** Constraint matrix D. */
+      typedef Eigen::Matrix<double, c_NCon, c_NPar> DMatrix;
+      /** Derivative of the constraints with respect to the vertex. */
+      typedef Eigen::Matrix<double, c_NCon, 3> EMatrix;
+      /** Constraint values or Lagrange multipliers. */
+      typedef Eigen::Matrix<double, c_NCon, 1> ConVector;
+      /** Matrix in the space of the constraints. */
+      typedef Eigen::Matrix<double, c_NCon, c_NCon> ConMatrix;
+
+      /** Calculate m_D, m_E and m_d at the current parameters, see VertexFitKFit::makeCoreMatrix(). */
+      enum KFitError::ECode makeCoreMatrix();
+
+      /** Track parameters before the fit. */
+      ParVector m_al_0;
+      /** Track parameters after the fit. */
+      ParVector m_al_1;
+      /** Error matrix of the track parameters before the fit. */
+      ParMatrix m_V_al_0;
+      /** Error matrix of the track parameters after the fit. */
+      ParMatrix m_V_al_1;
+      /** Product of -c, the magnetic field and the charge of each track. */
+      double m_a[NTracks];
+
+      /** Constraint matrix. */
+      DMatrix m_D;
+      /** Constraint values. */
+      ConVector m_d;
+      /** Inverse of the constraint errors, block diagonal. */
+      ConMatrix m_V_D;
+      /** Derivative of the constraints with respect to the vertex. */
+      EMatrix m_E;
+      /** Lagrange multipliers before the vertex update. */
+      ConVector m_lam0;
+      /** Lagrange multipliers. */
+      ConVector m_lam;
+
+      /** Vertex position. */
+      VertexVector m_v_a;
+      /** Vertex position at the beginning of an iteration. */
+      VertexVector m_v;
+      /** Vertex error matrix. */
+      VertexMatrix m_V_E;
+      /** Covariance between the vertex and the track parameters. */
+      VertexParMatrix m_Cov_v_al_1;
+
+      /** Chi-square of each track. */
+      double m_EachCHIsq[NTracks];
+      /** Chi-square of the fit. */
+      double m_CHIsq;
+      /** Flag if the fit reached the maximum number of iterations. */
+      bool m_FlagOverIteration;
+    };
+
+    /** Explicit instantiations are in VertexFitKFitKernel.cc. */
+    extern template class VertexFitKFitKernel<2>;
+    /** Explicit instantiations are in VertexFitKFitKernel.cc. */
+    extern template class VertexFitKFitKernel<3>;
+    /** Explicit instantiations are in VertexFitKFitKernel.cc. */
+    extern template class VertexFitKFitKernel<4>;
+
+  } // namespace analysis
+
+} // namespace Belle2
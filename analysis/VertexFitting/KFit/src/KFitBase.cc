@@ -12,17 +12,53 @@
 #include <analysis/utility/ROOTToCLHEP.h>
 #include <analysis/VertexFitting/KFit/KFitBase.h>
 
+#include <Eigen/LU>
+
 using namespace std;
 using namespace Belle2;
 using namespace Belle2::analysis;
 using namespace CLHEP;
 
+namespace {
+  /** Copy a CLHEP matrix to an Eigen matrix. */
+  template <typename Matrix>
+  Eigen::MatrixXd toEigen(const Matrix& m)
+  {
+    Eigen::MatrixXd out(m.num_row(), m.num_col());
+    for (int i = 0; i < m.num_row(); i++)
+      for (int j = 0; j < m.num_col(); j++) out(i, j) = m[i][j];
+    return out;
+  }
+
+  /** Copy an Eigen matrix to a CLHEP matrix. */
+  HepMatrix toCLHEP(const Eigen::MatrixXd& m)
+  {
+    HepMatrix out(m.rows(), m.cols(), 0);
+    for (int i = 0; i < m.rows(); i++)
+      for (int j = 0; j < m.cols(); j++) out[i][j] = m(i, j);
+    return out;
+  }
+
+  /** Invert a matrix, like CLHEP only an exactly vanishing pivot is treated as singular.
+   * @return false if the matrix is singular
+   */
+  bool invert(const Eigen::MatrixXd& m, Eigen::MatrixXd& inverse)
+  {
+    Eigen::FullPivLU<Eigen::MatrixXd> lu(m);
+    lu.setThreshold(0.);
+    if (!lu.isInvertible()) return false;
+    inverse = lu.inverse();
+    return true;
+  }
+}
+
 KFitBase::KFitBase()
 {
   m_ErrorCode = KFitError::kNoError;
   m_FlagFitted = false;
   m_FlagCorrelation = false;
   m_FlagOverIteration = false;
+  m_EigenBackend = false;
   m_MagneticField = KFitConst::kDefaultMagneticField;
   m_NDF = 0;
   m_CHIsq = -1;
@@ -97,6 +133,14 @@ KFitBase::setMagneticField(const double mf) {
 }
 
 
+enum KFitError::ECode
+KFitBase::setEigenBackend(const bool flag) {
+  m_EigenBackend = flag;
+
+  return m_ErrorCode = KFitError::kNoError;
+}
+
+
 enum KFitError::ECode
 KFitBase::getErrorCode() const {
   return m_ErrorCode;
@@ -512,6 +556,8 @@ KFitBase::doFit1() {
   if (prepareInputMatrix() != KFitError::kNoError) return m_ErrorCode;
   if (calculateNDF() != KFitError::kNoError)       return m_ErrorCode;
 
+  if (m_EigenBackend) return this->doFit1Eigen();
+
 
   double chisq = 0;
   double tmp_chisq = KFitConst::kInitialCHIsq;
@@ -574,6 +620,82 @@ KFitBase::doFit1() {
 }
 
 
+enum KFitError::ECode
+KFitBase::doFit1Eigen() {
+  // same as doFit1() after the input matrices are prepared
+  const Eigen::MatrixXd al_0 = toEigen(m_al_0);
+  const Eigen::MatrixXd V_al_0 = toEigen(m_V_al_0);
+  Eigen::MatrixXd al_1 = toEigen(m_al_1);
+  Eigen::MatrixXd V_al_1 = toEigen(m_V_al_1);
+  Eigen::MatrixXd al_a = al_0;
+  Eigen::MatrixXd V_D, lam;
+
+  double chisq = 0;
+  double tmp_chisq = KFitConst::kInitialCHIsq;
+
+  Eigen::MatrixXd tmp_al_1(al_1);
+  Eigen::MatrixXd tmp_V_al_1(V_al_1);
+  Eigen::MatrixXd tmp_al_a(al_a);
+
+
+  for (int i = 0; i < KFitConst::kMaxIterationCount; i++)
+  {
+    // makeCoreMatrix() evaluates the constraints at m_al_1
+    m_al_1 = toCLHEP(al_1);
+    if (makeCoreMatrix() != KFitError::kNoError) return m_ErrorCode;
+    const Eigen::MatrixXd D = toEigen(m_D);
+
+    const Eigen::MatrixXd V_al_0_Dt = V_al_0 * D.transpose();
+    if (!invert(D * V_al_0_Dt, V_D)) {
+      m_ErrorCode = KFitError::kCannotGetMatrixInverse;
+      return m_ErrorCode;
+    }
+
+    const Eigen::MatrixXd r = D * (al_0 - al_1) + toEigen(m_d);
+    lam    = V_D * r;
+    chisq  = (lam.transpose() * r)(0, 0);
+    al_1   = al_0 - V_al_0_Dt * lam;
+    V_al_1 = V_al_0 - V_al_0_Dt * V_D * V_al_0_Dt.transpose();
+
+    if (tmp_chisq <= chisq) {
+      if (i == 0) {
+        m_ErrorCode = KFitError::kBadInitialCHIsq;
+        return m_ErrorCode;
+      } else {
+        chisq  = tmp_chisq;
+        al_1   = tmp_al_1;
+        al_a   = tmp_al_a;
+        V_al_1 = tmp_V_al_1;
+        break;
+      }
+    } else {
+      tmp_chisq  = chisq;
+      tmp_al_a   = tmp_al_1;
+      tmp_al_1   = al_1;
+      tmp_V_al_1 = V_al_1;
+      if (i == KFitConst::kMaxIterationCount - 1) {
+        al_a = tmp_al_1;
+        m_FlagOverIteration = true;
+      }
+    }
+  }
+
+  m_al_1   = toCLHEP(al_1);
+  m_al_a   = toCLHEP(al_a);
+  m_V_al_1 = toCLHEP(V_al_1);
+  m_V_D    = toCLHEP(V_D);
+  m_lam    = toCLHEP(lam);
+
+  if (prepareOutputMatrix() != KFitError::kNoError) return m_ErrorCode;
+
+  m_CHIsq = chisq;
+
+  m_FlagFitted = true;
+
+  return m_ErrorCode = KFitError::kNoError;
+}
+
+
 enum KFitError::ECode
 KFitBase::doFit2() {
   if (m_ErrorCode != KFitError::kNoError) return m_ErrorCode;
@@ -588,6 +710,8 @@ KFitBase::doFit2() {
   if (prepareInputMatrix() != KFitError::kNoError) return m_ErrorCode;
   if (calculateNDF() != KFitError::kNoError)       return m_ErrorCode;
 
+  if (m_EigenBackend) return this->doFit2Eigen();
+
 
   double chisq = 0;
   double tmp2_chisq = KFitConst::kInitialCHIsq;
@@ -724,6 +848,167 @@ KFitBase::doFit2() {
 }
 
 
+enum KFitError::ECode
+KFitBase::doFit2Eigen() {
+  // same as doFit2() after the input matrices are prepared
+  const Eigen::MatrixXd al_0 = toEigen(m_al_0);
+  const Eigen::MatrixXd V_al_0 = toEigen(m_V_al_0);
+  Eigen::MatrixXd al_1 = toEigen(m_al_1);
+  Eigen::MatrixXd al_a = al_0;
+  Eigen::MatrixXd D = toEigen(m_D), E = toEigen(m_E);
+  Eigen::MatrixXd V_D = toEigen(m_V_D), V_E = toEigen(m_V_E);
+  Eigen::MatrixXd lam0 = toEigen(m_lam0), v_a = toEigen(m_v_a), v = toEigen(m_v);
+
+  double chisq = 0;
+  double tmp2_chisq = KFitConst::kInitialCHIsq;
+
+  Eigen::MatrixXd tmp_al_a(al_a);
+
+  Eigen::MatrixXd tmp_D(D), tmp_E(E);
+  Eigen::MatrixXd tmp_V_D(V_D), tmp_V_E(V_E);
+  Eigen::MatrixXd tmp_lam0(lam0), tmp_v_a(v_a);
+
+  Eigen::MatrixXd tmp2_D(D), tmp2_E(E);
+  Eigen::MatrixXd tmp2_V_D(V_D), tmp2_V_E(V_E);
+  Eigen::MatrixXd tmp2_lam0(lam0), tmp2_v_a(v_a), tmp2_v(v_a);
+
+
+  for (int j = 0; j < KFitConst::kMaxIterationCount; j++)   // j'th loop start
+  {
+
+    double tmp_chisq = KFitConst::kInitialCHIsq;
+
+    for (int i = 0; i < KFitConst::kMaxIterationCount; i++) { // i'th loop start
+
+      // prepareInputSubMatrix() and makeCoreMatrix() work on m_v_a and m_al_1
+      m_v_a = toCLHEP(v_a);
+      if (prepareInputSubMatrix() != KFitError::kNoError) return m_ErrorCode;
+      if (makeCoreMatrix() != KFitError::kNoError)        return m_ErrorCode;
+      D = toEigen(m_D);
+      E = toEigen(m_E);
+      v = toEigen(m_v);
+
+      if (!invert(D * V_al_0 * D.transpose(), V_D)) {
+        m_ErrorCode = KFitError::kCannotGetMatrixInverse;
+        return m_ErrorCode;
+      }
+
+      if (!invert(E.transpose() * V_D * E, V_E)) {
+        m_ErrorCode = KFitError::kCannotGetMatrixInverse;
+        return m_ErrorCode;
+      }
+      const Eigen::MatrixXd r = D * (al_0 - al_1) + toEigen(m_d);
+      lam0  = V_D * r;
+      chisq = (lam0.transpose() * (r + E * (v - v_a)))(0, 0);
+      v_a   = v_a - V_E * E.transpose() * lam0;
+
+      if (tmp_chisq <= chisq) {
+        if (i == 0) {
+          m_ErrorCode = KFitError::kBadInitialCHIsq;
+          return m_ErrorCode;
+        } else {
+          chisq = tmp_chisq;
+          v_a   = tmp_v_a;
+          V_E   = tmp_V_E;
+          V_D   = tmp_V_D;
+          lam0  = tmp_lam0;
+          E     = tmp_E;
+          D     = tmp_D;
+          break;
+        }
+      } else {
+        tmp_chisq = chisq;
+        tmp_v_a   = v_a;
+        tmp_V_E   = V_E;
+        tmp_V_D   = V_D;
+        tmp_lam0  = lam0;
+        tmp_E     = E;
+        tmp_D     = D;
+        if (i == KFitConst::kMaxIterationCount - 1) {
+          m_FlagOverIteration = true;
+        }
+      }
+    } // i'th loop over
+
+
+    al_a = al_1;
+    const Eigen::MatrixXd lam = lam0 - V_D * E * V_E * E.transpose() * lam0;
+    al_1 = al_0 - V_al_0 * D.transpose() * lam;
+    m_al_1 = toCLHEP(al_1);
+
+    if (j == 0) {
+
+      tmp2_chisq = chisq;
+      tmp2_v_a   = v_a;
+      tmp2_v     = v;
+      tmp2_V_E   = V_E;
+      tmp2_V_D   = V_D;
+      tmp2_lam0  = lam0;
+      tmp2_E     = E;
+      tmp2_D     = D;
+      tmp_al_a   = al_a;
+
+    } else {
+
+      if (tmp2_chisq <= chisq) {
+        chisq = tmp2_chisq;
+        v_a   = tmp2_v_a;
+        v     = tmp2_v;
+        V_E   = tmp2_V_E;
+        V_D   = tmp2_V_D;
+        lam0  = tmp2_lam0;
+        E     = tmp2_E;
+        D     = tmp2_D;
+        al_a  = tmp_al_a;
+        break;
+      } else {
+        tmp2_chisq = chisq;
+        tmp2_v_a   = v_a;
+        tmp2_v     = v;
+        tmp2_V_E   = V_E;
+        tmp2_V_D   = V_D;
+        tmp2_lam0  = lam0;
+        tmp2_E     = E;
+        tmp2_D     = D;
+        tmp_al_a   = al_a;
+        if (j == KFitConst::kMaxIterationCount - 1) {
+          m_FlagOverIteration = true;
+        }
+      }
+    }
+  } // j'th loop over
+
+
+  const Eigen::MatrixXd V_D_E_V_E = V_D * E * V_E;
+  const Eigen::MatrixXd V_al_0_Dt = V_al_0 * D.transpose();
+  const Eigen::MatrixXd lam  = lam0 - V_D_E_V_E * E.transpose() * lam0;
+  const Eigen::MatrixXd V_Dt = V_D - V_D_E_V_E * E.transpose() * V_D;
+  al_1 = al_0 - V_al_0_Dt * lam;
+
+  m_al_1       = toCLHEP(al_1);
+  m_al_a       = toCLHEP(al_a);
+  m_V_al_1     = toCLHEP(V_al_0 - V_al_0_Dt * V_Dt * V_al_0_Dt.transpose());
+  m_Cov_v_al_1 = toCLHEP(-V_E * E.transpose() * V_D * D * V_al_0);
+  m_D          = toCLHEP(D);
+  m_E          = toCLHEP(E);
+  m_V_D        = toCLHEP(V_D);
+  m_V_E        = toCLHEP(V_E);
+  m_V_Dt       = toCLHEP(V_Dt);
+  m_lam0       = toCLHEP(lam0);
+  m_lam        = toCLHEP(lam);
+  m_v_a        = toCLHEP(v_a);
+  m_v          = toCLHEP(v);
+
+  if (prepareOutputMatrix() != KFitError::kNoError) return m_ErrorCode;
+
+  m_CHIsq = chisq;
+
+  m_FlagFitted = true;
+
+  return m_ErrorCode = KFitError::kNoError;
+}
+
+
 bool
 KFitBase::isFitted() const
 {
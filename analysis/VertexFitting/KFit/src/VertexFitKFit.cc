@@ -15,6 +15,7 @@
 
 #include <analysis/VertexFitting/KFit/MakeMotherKFit.h>
 #include <analysis/VertexFitting/KFit/VertexFitKFit.h>
+#include <analysis/VertexFitting/KFit/VertexFitKFitKernel.h>
 #include <analysis/utility/CLHEPToROOT.h>
 #include <framework/gearbox/Const.h>
 
@@ -218,6 +219,9 @@ VertexFitKFit::doFit() {
   if (m_FlagBeam) m_ErrorCode = this->doFit4();
   else if (m_FlagKnownVertex) m_ErrorCode = this->doFit5();
   else if (m_CorrelationMode) m_ErrorCode = this->doFit2();
+  else if (m_EigenBackend && m_TrackCount == 2) m_ErrorCode = this->doFit3Eigen<2>();
+  else if (m_EigenBackend && m_TrackCount == 3) m_ErrorCode = this->doFit3Eigen<3>();
+  else if (m_EigenBackend && m_TrackCount == 4) m_ErrorCode = this->doFit3Eigen<4>();
   else
     m_ErrorCode = this->doFit3();
 
@@ -398,6 +402,56 @@ VertexFitKFit::doFit3() {
 }
 
 
+template <int NTracks>
+enum KFitError::ECode
+VertexFitKFit::doFit3Eigen() {
+  // same as doFit3() but with fixed-size matrices, only the results are converted to CLHEP
+  if (m_ErrorCode != KFitError::kNoError) return m_ErrorCode;
+
+  if (calculateNDF() != KFitError::kNoError) return m_ErrorCode;
+
+  VertexFitKFitKernel<NTracks> kernel;
+  const double c = Belle2::Const::speedOfLight * 1e-4;
+  for (int k = 0; k < NTracks; k++) {
+    const KFitTrack& track = m_Tracks[k];
+    const HepSymMatrix error = track.getFitError(KFitConst::kBeforeFit);
+    Eigen::Matrix<double, 6, 1> par;
+    Eigen::Matrix<double, 6, 6> parError;
+    for (int i = 0; i < KFitConst::kNumber6; i++) {
+      par(i) = track.getFitParameter(i, KFitConst::kBeforeFit);
+      for (int j = 0; j < KFitConst::kNumber6; j++) parError(i, j) = error[i][j];
+    }
+    kernel.setTrack(k, par, parError, -c * m_MagneticField * track.getCharge());
+  }
+  kernel.setInitialVertex(Eigen::Matrix<double, 3, 1>(m_BeforeVertex.x(), m_BeforeVertex.y(), m_BeforeVertex.z()));
+
+  m_ErrorCode = kernel.doFit();
+  if (kernel.isOverIteration()) m_FlagOverIteration = true;
+  if (m_ErrorCode != KFitError::kNoError) return m_ErrorCode;
+
+  const int nPar = KFitConst::kNumber6 * NTracks;
+  m_al_1 = HepMatrix(nPar, 1, 0);
+  m_V_al_1 = HepMatrix(nPar, nPar, 0);
+  m_Cov_v_al_1 = HepMatrix(3, nPar, 0);
+  for (int i = 0; i < nPar; i++) {
+    m_al_1[i][0] = kernel.getParameters()(i);
+    for (int j = 0; j < nPar; j++) m_V_al_1[i][j] = kernel.getParameterError()(i, j);
+    for (int j = 0; j < 3; j++) m_Cov_v_al_1[j][i] = kernel.getVertexParameterCovariance()(j, i);
+  }
+  for (int i = 0; i < 3; i++) {
+    m_v_a[i][0] = kernel.getVertex()(i);
+    for (int j = 0; j < 3; j++) m_V_E[i][j] = kernel.getVertexError()(i, j);
+  }
+  for (int k = 0; k < NTracks; k++) m_EachCHIsq[k] = kernel.getTrackCHIsq(k);
+
+  if (prepareOutputMatrix() != KFitError::kNoError) return m_ErrorCode;
+
+  m_CHIsq = kernel.getCHIsq();
+
+  return m_ErrorCode = KFitError::kNoError;
+}
+
+
 enum KFitError::ECode
 VertexFitKFit::doFit4() {
   // included beam position constraint (only no correlation)
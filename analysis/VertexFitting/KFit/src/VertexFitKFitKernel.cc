@@ -0,0 +1,297 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <analysis/VertexFitting/KFit/VertexFitKFitKernel.h>
+
+#include <Eigen/LU>
+
+#include <cmath>
+
+using namespace Belle2;
+using namespace Belle2::analysis;
+
+namespace {
+  /** Invert a small fixed-size matrix, return false if it is singular. */
+  template <typename Matrix>
+  bool invert(const Matrix& in, Matrix& out)
+  {
+    bool invertible = false;
+    // Like CLHEP only an exactly vanishing determinant is treated as singular.
+    in.computeInverseWithCheck(out, invertible, 0.);
+    return invertible;
+  }
+}
+
+template <int NTracks>
+VertexFitKFitKernel<NTracks>::VertexFitKFitKernel():
+  m_al_0(ParVector::Zero()),
+  m_al_1(ParVector::Zero()),
+  m_V_al_0(ParMatrix::Zero()),
+  m_V_al_1(ParMatrix::Zero()),
+  m_D(DMatrix::Zero()),
+  m_d(ConVector::Zero()),
+  m_V_D(ConMatrix::Zero()),
+  m_E(EMatrix::Zero()),
+  m_lam0(ConVector::Zero()),
+  m_lam(ConVector::Zero()),
+  m_v_a(VertexVector::Zero()),
+  m_v(VertexVector::Zero()),
+  m_V_E(VertexMatrix::Zero()),
+  m_Cov_v_al_1(VertexParMatrix::Zero()),
+  m_CHIsq(0),
+  m_FlagOverIteration(false)
+{
+  for (int k = 0; k < NTracks; k++) {
+    m_a[k] = 0;
+    m_EachCHIsq[k] = 0;
+  }
+}
+
+
+template <int NTracks>
+void VertexFitKFitKernel<NTracks>::setTrack(int id, const Eigen::Matrix<double, 6, 1>& par,
+                                            const Eigen::Matrix<double, 6, 6>& error, double a)
+{
+  m_al_0.template segment<6>(KFitConst::kNumber6 * id) = par;
+  m_V_al_0.template block<6, 6>(KFitConst::kNumber6 * id, KFitConst::kNumber6 * id) = error;
+  m_a[id] = a;
+}
+
+
+template <int NTracks>
+enum KFitError::ECode VertexFitKFitKernel<NTracks>::doFit()
+{
+  // Same iteration scheme and bookkeeping as VertexFitKFit::doFit3(), including
+  // the error code being reset by each evaluation of the core matrices.
+  enum KFitError::ECode errorCode = KFitError::kNoError;
+
+  double chisq = 0;
+  double tmp2_chisq = KFitConst::kInitialCHIsq;
+
+  m_al_1 = m_al_0;
+
+  DMatrix tmp_D(m_D), tmp2_D(m_D);
+  EMatrix tmp_E(m_E), tmp2_E(m_E);
+  ConMatrix tmp_V_D(m_V_D), tmp2_V_D(m_V_D);
+  VertexMatrix tmp_V_E(m_V_E), tmp2_V_E(m_V_E);
+  ConVector tmp_lam0(m_lam0), tmp2_lam0(m_lam0);
+  VertexVector tmp_v_a(m_v_a), tmp2_v_a(m_v_a);
+
+  double tmp_each_chisq[NTracks] = {};
+  double tmp2_each_chisq[NTracks] = {};
+
+  for (int j = 0; j < KFitConst::kMaxIterationCount; j++) {
+
+    double tmp_chisq = KFitConst::kInitialCHIsq;
+
+    for (int i = 0; i < KFitConst::kMaxIterationCount; i++) {
+
+      m_v = m_v_a;
+      if ((errorCode = makeCoreMatrix()) != KFitError::kNoError) return errorCode;
+
+      VertexMatrix tV_Ein = VertexMatrix::Zero();
+      chisq = 0;
+
+      for (int k = 0; k < NTracks; k++) {
+        const int iPar = KFitConst::kNumber6 * k;
+        const auto tD = m_D.template block<2, 6>(2 * k, iPar);
+        const Eigen::Matrix<double, 2, 2> tV_Din = tD * m_V_al_0.template block<6, 6>(iPar, iPar) * tD.transpose();
+        Eigen::Matrix<double, 2, 2> tV_D;
+        if (!invert(tV_Din, tV_D)) {
+          errorCode = KFitError::kCannotGetMatrixInverse;
+          KFitError::displayError(__FILE__, __LINE__, __func__, errorCode);
+          return errorCode;
+        }
+
+        m_V_D.template block<2, 2>(2 * k, 2 * k) = tV_D;
+        const auto tE = m_E.template block<2, 3>(2 * k, 0);
+        tV_Ein += tE.transpose() * tV_D * tE;
+        const Eigen::Matrix<double, 2, 1> tDd = tD * (m_al_0 - m_al_1).template segment<6>(iPar) + m_d.template segment<2>(2 * k);
+        const Eigen::Matrix<double, 2, 1> tlam0 = tV_D * tDd;
+        m_lam0.template segment<2>(2 * k) = tlam0;
+        m_EachCHIsq[k] = tlam0.dot(tDd + tE * (m_v - m_v_a));
+        chisq += m_EachCHIsq[k];
+      }
+
+      if (!invert(tV_Ein, m_V_E)) {
+        errorCode = KFitError::kCannotGetMatrixInverse;
+        KFitError::displayError(__FILE__, __LINE__, __func__, errorCode);
+        return errorCode;
+      }
+
+      m_v_a -= m_V_E * (m_E.transpose() * m_lam0);
+
+      if (tmp_chisq <= chisq) {
+        if (i == 0) {
+          errorCode = KFitError::kBadInitialCHIsq;
+        } else {
+          for (int k = 0; k < NTracks; k++) m_EachCHIsq[k] = tmp_each_chisq[k];
+          chisq  = tmp_chisq;
+          m_v_a  = tmp_v_a;
+          m_V_E  = tmp_V_E;
+          m_V_D  = tmp_V_D;
+          m_lam0 = tmp_lam0;
+          m_E    = tmp_E;
+          m_D    = tmp_D;
+        }
+        break;
+      } else {
+        for (int k = 0; k < NTracks; k++) tmp_each_chisq[k] = m_EachCHIsq[k];
+        tmp_chisq = chisq;
+        tmp_v_a   = m_v_a;
+        tmp_V_E   = m_V_E;
+        tmp_V_D   = m_V_D;
+        tmp_lam0  = m_lam0;
+        tmp_E     = m_E;
+        tmp_D     = m_D;
+        if (i == KFitConst::kMaxIterationCount - 1) {
+          m_FlagOverIteration = true;
+        }
+      }
+    }
+
+    m_lam  = m_lam0 - m_V_D * m_E * (m_V_E * (m_E.transpose() * m_lam0));
+    m_al_1 = m_al_0 - m_V_al_0 * (m_D.transpose() * m_lam);
+
+    if (j == 0 || tmp2_chisq > chisq) {
+      for (int k = 0; k < NTracks; k++) tmp2_each_chisq[k] = m_EachCHIsq[k];
+      tmp2_chisq = chisq;
+      tmp2_v_a   = m_v_a;
+      tmp2_V_E   = m_V_E;
+      tmp2_V_D   = m_V_D;
+      tmp2_lam0  = m_lam0;
+      tmp2_E     = m_E;
+      tmp2_D     = m_D;
+    } else {
+      for (int k = 0; k < NTracks; k++) m_EachCHIsq[k] = tmp2_each_chisq[k];
+      chisq  = tmp2_chisq;
+      m_v_a  = tmp2_v_a;
+      m_V_E  = tmp2_V_E;
+      m_V_D  = tmp2_V_D;
+      m_lam0 = tmp2_lam0;
+      m_E    = tmp2_E;
+      m_D    = tmp2_D;
+      break;
+    }
+  }
+
+  if (errorCode != KFitError::kNoError) return errorCode;
+
+  m_lam  = m_lam0 - m_V_D * m_E * (m_V_E * (m_E.transpose() * m_lam0));
+  m_al_1 = m_al_0 - m_V_al_0 * (m_D.transpose() * m_lam);
+
+  // D V_al_0 and V_D E appear in all error matrices.
+  const Eigen::Matrix<double, c_NCon, c_NPar> DV_al_0 = m_D * m_V_al_0;
+  const EMatrix V_DE = m_V_D * m_E;
+  const ConMatrix V_Dt = m_V_D - V_DE * m_V_E * V_DE.transpose();
+  m_V_al_1 = m_V_al_0 - DV_al_0.transpose() * V_Dt * DV_al_0;
+  m_Cov_v_al_1 = -m_V_E * V_DE.transpose() * DV_al_0;
+
+  m_CHIsq = chisq;
+
+  return KFitError::kNoError;
+}
+
+
+template <int NTracks>
+enum KFitError::ECode VertexFitKFitKernel<NTracks>::makeCoreMatrix()
+{
+  for (int i = 0; i < NTracks; i++) {
+    double S, U;
+    double sininv;
+
+    const int iPar = KFitConst::kNumber6 * i;
+    double px = m_al_1(iPar + 0);
+    double py = m_al_1(iPar + 1);
+    double pz = m_al_1(iPar + 2);
+    double x  = m_al_1(iPar + 3);
+    double y  = m_al_1(iPar + 4);
+    double z  = m_al_1(iPar + 5);
+    double a  = m_a[i];
+
+    double pt =  sqrt(px * px + py * py);
+    if (pt == 0) {
+      KFitError::displayError(__FILE__, __LINE__, __func__, KFitError::kDivisionByZero);
+      return KFitError::kDivisionByZero;
+    }
+
+    double invPt   = 1. / pt;
+    double invPt2  = invPt * invPt;
+    double dlx  =  m_v_a(0) - x;
+    double dly  =  m_v_a(1) - y;
+    double dlz  =  m_v_a(2) - z;
+    double a1   = -dlx * py + dly * px;
+    double a2   =  dlx * px + dly * py;
+    double r2d2 =  dlx * dlx + dly * dly;
+    double Rx   =  dlx - 2.*px * a2 * invPt2;
+    double Ry   =  dly - 2.*py * a2 * invPt2;
+
+    if (a != 0) { // charged
+
+      double B = a * a2 * invPt2;
+      if (fabs(B) > 1) {
+        B2DEBUG(10, "KFitError: Cannot calculate arcsin");
+        return KFitError::kCannotGetARCSIN;
+      }
+      // sin^(-1)(B)
+      sininv = asin(B);
+      double tmp0 = 1.0 - B * B;
+      if (tmp0 == 0) {
+        KFitError::displayError(__FILE__, __LINE__, __func__, KFitError::kDivisionByZero);
+        return KFitError::kDivisionByZero;
+      }
+      // 1/sqrt(1-B^2)
+      double sqrtag = 1.0 / sqrt(tmp0);
+      S = sqrtag * invPt2;
+      U = dlz - pz * sininv / a;
+
+    } else { // neutral
+
+      sininv = 0.0;
+      S = invPt2;
+      U = dlz - pz * a2 * invPt2;
+    }
+
+    // d
+    m_d(i * 2 + 0) = a1 - 0.5 * a * r2d2;
+    m_d(i * 2 + 1) = U * pt;
+
+    // D
+    m_D(i * 2 + 0, iPar + 0) =  dly;
+    m_D(i * 2 + 0, iPar + 1) = -dlx;
+    m_D(i * 2 + 0, iPar + 2) =  0.0;
+    m_D(i * 2 + 0, iPar + 3) =  py + a * dlx;
+    m_D(i * 2 + 0, iPar + 4) = -px + a * dly;
+    m_D(i * 2 + 0, iPar + 5) =  0.0;
+    m_D(i * 2 + 1, iPar + 0) = -pz * pt * S * Rx + U * px * invPt;
+    m_D(i * 2 + 1, iPar + 1) = -pz * pt * S * Ry + U * py * invPt;
+    m_D(i * 2 + 1, iPar + 2) = a != 0 ? -sininv * pt / a : -a2 * invPt;
+    m_D(i * 2 + 1, iPar + 3) =  px * pz * pt * S;
+    m_D(i * 2 + 1, iPar + 4) =  py * pz * pt * S;
+    m_D(i * 2 + 1, iPar + 5) = -pt;
+
+    // E
+    m_E(i * 2 + 0, 0) = -py - a * dlx;
+    m_E(i * 2 + 0, 1) =  px - a * dly;
+    m_E(i * 2 + 0, 2) =  0.0;
+    m_E(i * 2 + 1, 0) = -px * pz * pt * S;
+    m_E(i * 2 + 1, 1) = -py * pz * pt * S;
+    m_E(i * 2 + 1, 2) =  pt;
+  }
+
+  return KFitError::kNoError;
+}
+
+
+namespace Belle2 {
+  namespace analysis {
+    template class VertexFitKFitKernel<2>;
+    template class VertexFitKFitKernel<3>;
+    template class VertexFitKFitKernel<4>;
+  }
+}
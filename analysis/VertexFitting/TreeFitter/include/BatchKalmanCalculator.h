@@ -0,0 +1,130 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#pragma once
+
+#include <analysis/VertexFitting/TreeFitter/EigenStackConfig.h>
+
+#include <analysis/VertexFitting/TreeFitter/FitParams.h>
+#include <analysis/VertexFitting/TreeFitter/ErrCode.h>
+
+#include <Eigen/Core>
+#include <vector>
+
+namespace TreeFitter {
+
+  /** Kalman filter for a batch of candidates with the same decay topology.
+   *
+   * It does the same as KalmanCalculator::calculateGainMatrix(), updateState() and
+   * updateCovariance() for all candidates at once. The state vectors and the lower
+   * triangles of the covariances are stored with the candidate as innermost index,
+   * so every element of the update is computed for all candidates in one vectorized
+   * loop. C G^t only uses the columns of G which are non-zero for any candidate.
+   */
+  class BatchKalmanCalculator {
+  public:
+
+    /** constructor for at most sizeBatch candidates with sizeState fit parameters */
+    BatchKalmanCalculator(int sizeState, int sizeBatch);
+
+    /** number of candidates in the batch */
+    int size() const { return m_size; }
+
+    /** copy the state vector and covariance of a candidate into the batch */
+    void setState(int candidate, const FitParams& fitparams);
+
+    /** copy the state vector and the lower triangle of the covariance of a candidate out of the batch */
+    void getState(int candidate, FitParams& fitparams) const;
+
+    /** start the filtering of a constraint with dimension sizeRes */
+    void beginConstraint(int sizeRes);
+
+    /**
+     * set the projection of the constraint for a candidate
+     *
+     * The constraint was projected at the reference state, the residuals are
+     * corrected for the change of the state with respect to it.
+     */
+    void setProjection(int candidate,
+                       const Eigen::Matrix < double, -1, 1, 0, 7, 1 > & residuals,
+                       const Eigen::Matrix < double, -1, -1, 0, 7, MAX_MATRIX_SIZE > & G,
+                       const Eigen::Matrix < double, -1, -1, 0, 7, 7 > & V,
+                       const FitParams& reference,
+                       const ErrCode& status);
+
+    /** update the state vectors and covariances of all candidates with the constraint */
+    void filter();
+
+    /** get chi2 of the constraint for a candidate */
+    double getChiSquare(int candidate) const { return m_chisq[candidate]; }
+
+    /** get the status of the constraint for a candidate */
+    const ErrCode& getErrCode(int candidate) const { return m_status[candidate]; }
+
+    /** remove a candidate, the last candidate takes its place */
+    void remove(int candidate);
+
+  private:
+
+    /** index of the element (row, col) of the packed lower triangle of the covariance */
+    int packedIndex(int row, int col) const
+    {
+      return row >= col ? m_columnOffset[col] + row : m_columnOffset[row] + col;
+    }
+
+    /** elements in rows, candidates in columns */
+    typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> BatchArray;
+
+    /** dimension of the state */
+    int m_sizeState;
+
+    /** dimension of the current constraint */
+    int m_sizeRes;
+
+    /** number of candidates */
+    int m_size;
+
+    /** offset of each column in the packed lower triangle, minus the column index */
+    std::vector<int> m_columnOffset;
+
+    /** columns of G which are non-zero for any candidate */
+    std::vector<bool> m_usedColumn;
+
+    /** state vectors */
+    BatchArray m_state;
+
+    /** lower triangles of the covariances, packed column by column */
+    BatchArray m_cov;
+
+    /** residuals */
+    BatchArray m_res;
+
+    /** G, row-major */
+    BatchArray m_G;
+
+    /** lower triangle of V, zero if V is not used */
+    BatchArray m_V;
+
+    /** C times G^t, row-major */
+    BatchArray m_CGt;
+
+    /** lower triangle of R */
+    BatchArray m_R;
+
+    /** R inverse */
+    BatchArray m_Rinverse;
+
+    /** Kalman gain matrix, row-major */
+    BatchArray m_K;
+
+    /** chi2 of the current constraint */
+    std::vector<double> m_chisq;
+
+    /** status of the current constraint */
+    std::vector<ErrCode> m_status;
+  };
+}
@@ -39,6 +39,9 @@ namespace TreeFitter {
     /** initialize the chain */
     ErrCode initialize(FitParams& par);
 
+    /** reset the covariance and the chi2 before filtering the chain */
+    ErrCode initCovariance(FitParams& par) const;
+
     /** filter down the chain */
     ErrCode filter(FitParams& par);
 
@@ -54,6 +57,15 @@ namespace TreeFitter {
     /** remove constraints from list */
     void removeConstraintFromList();
 
+    /** get the constraints in the order in which they are filtered */
+    const ParticleBase::constraintlist& getConstraintList() const { return m_constraintlist; }
+
+    /**
+     * get the dimension of the state followed by the type and dimension of each constraint.
+     * Chains with the same topology can be filtered together, see FitManager::fitBatch().
+     */
+    std::vector<int> getTopology() const;
+
     /** get the chi2 for the head of the chain */
     double chiSquare(const FitParams& par) const;
 
@@ -12,6 +12,8 @@
 #include <analysis/VertexFitting/TreeFitter/ErrCode.h>
 #include <analysis/VertexFitting/TreeFitter/ConstraintConfiguration.h>
 
+#include <vector>
+
 namespace TreeFitter {
   class DecayChain;
   class FitParams;
@@ -28,7 +30,7 @@ namespace TreeFitter {
     /** constructor  */
     FitManager() : m_particle(0), m_decaychain(0), m_status(VertexStatus::UnFitted),
       m_chiSquare(-1), m_prec(0.01), m_updateDaugthers(false), m_ndf(0),
-      m_fitparams(0)
+      m_fitparams(0), m_niter(0), m_ndiverging(0), m_finished(false)
     {}
 
     /** constructor  */
@@ -50,6 +52,29 @@ namespace TreeFitter {
     /** main fit function that uses the kalman filter */
     bool fit();
 
+    /**
+     * Initialize the decay chain and do the first iteration of the fit.
+     * The remaining iterations are done by fitBatch(), then finishFit() has to be called.
+     */
+    void startFit();
+
+    /** true if no further iteration of the fit is needed */
+    bool isFinished() const { return m_finished; }
+
+    /** check the result of the fit and update the particles */
+    bool finishFit();
+
+    /** get the dimension of the state and the constraints, see DecayChain::getTopology() */
+    std::vector<int> getTopology() const;
+
+    /**
+     * Do the remaining iterations of several fits with the same topology together.
+     * The Kalman filter of each constraint is applied to all candidates at once, see
+     * BatchKalmanCalculator. Each fit stops after the same iteration as with fit().
+     * startFit() has to be called for all fits before.
+     */
+    static void fitBatch(const std::vector<FitManager*>& fits);
+
     /** update particles parameters with the fit results */
     bool updateCand(Belle2::Particle& particle, const bool isTreeHead) const;
 
@@ -78,6 +103,9 @@ namespace TreeFitter {
     Belle2::Particle* particle() { return m_particle; }
 
   private:
+    /** evaluate the chi2 of the last iteration and decide whether the fit is finished */
+    void endIteration(const ErrCode& status);
+
     /** head of the tree  */
     Belle2::Particle* m_particle;
 
@@ -107,5 +135,14 @@ namespace TreeFitter {
 
     /** config container */
     const ConstraintConfiguration m_config;
+
+    /** number of iterations done */
+    int m_niter;
+
+    /** number of iterations in a row in which the chi2 increased */
+    int m_ndiverging;
+
+    /** true if no further iteration is needed */
+    bool m_finished;
   };
 }
@@ -52,6 +52,9 @@ namespace TreeFitter {
     /** get dimension of the constraint */
     double getConstraintDim() const { return m_constrDim; }
 
+    /** inverse of the residual covariance R, with fixed size kernels for the dimension of the constraint */
+    static Eigen::Matrix < double, -1, -1, 0, 7, 7 > invertResidualCovariance(const Eigen::Matrix < double, -1, -1, 0, 7, 7 > & R);
+
   private:
     /** dimension of the constraint  */
     int m_constrDim;
@@ -0,0 +1,209 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <analysis/VertexFitting/TreeFitter/BatchKalmanCalculator.h>
+#include <analysis/VertexFitting/TreeFitter/KalmanCalculator.h>
+
+namespace TreeFitter {
+
+  BatchKalmanCalculator::BatchKalmanCalculator(int sizeState, int sizeBatch) :
+    m_sizeState(sizeState),
+    m_sizeRes(0),
+    m_size(sizeBatch),
+    m_columnOffset(sizeState),
+    m_usedColumn(sizeState, false),
+    m_state(sizeState, sizeBatch),
+    m_cov(sizeState * (sizeState + 1) / 2, sizeBatch),
+    m_res(7, sizeBatch),
+    m_G(7 * sizeState, sizeBatch),
+    m_V(7 * 7, sizeBatch),
+    m_CGt(sizeState * 7, sizeBatch),
+    m_R(7 * 7, sizeBatch),
+    m_Rinverse(7 * 7, sizeBatch),
+    m_K(sizeState * 7, sizeBatch),
+    m_chisq(sizeBatch, 0),
+    m_status(sizeBatch)
+  {
+    for (int col = 0; col < sizeState; ++col) {
+      m_columnOffset[col] = col * sizeState - col * (col + 1) / 2;
+    }
+  }
+
+  void BatchKalmanCalculator::setState(int candidate, const FitParams& fitparams)
+  {
+    const auto& state = fitparams.getStateVector();
+    const auto& cov = fitparams.getCovariance();
+    for (int row = 0; row < m_sizeState; ++row) {
+      m_state(row, candidate) = state(row);
+    }
+    for (int col = 0; col < m_sizeState; ++col) {
+      for (int row = col; row < m_sizeState; ++row) {
+        m_cov(m_columnOffset[col] + row, candidate) = cov(row, col);
+      }
+    }
+  }
+
+  void BatchKalmanCalculator::getState(int candidate, FitParams& fitparams) const
+  {
+    auto& state = fitparams.getStateVector();
+    auto& cov = fitparams.getCovariance();
+    for (int row = 0; row < m_sizeState; ++row) {
+      state(row) = m_state(row, candidate);
+    }
+    // like KalmanCalculator::updateCovariance() only the lower triangle is written
+    for (int col = 0; col < m_sizeState; ++col) {
+      for (int row = col; row < m_sizeState; ++row) {
+        cov(row, col) = m_cov(m_columnOffset[col] + row, candidate);
+      }
+    }
+  }
+
+  void BatchKalmanCalculator::beginConstraint(int sizeRes)
+  {
+    m_sizeRes = sizeRes;
+    std::fill(m_usedColumn.begin(), m_usedColumn.end(), false);
+  }
+
+  void BatchKalmanCalculator::setProjection(int candidate,
+                                            const Eigen::Matrix < double, -1, 1, 0, 7, 1 > & residuals,
+                                            const Eigen::Matrix < double, -1, -1, 0, 7, MAX_MATRIX_SIZE > & G,
+                                            const Eigen::Matrix < double, -1, -1, 0, 7, 7 > & V,
+                                            const FitParams& reference,
+                                            const ErrCode& status)
+  {
+    const int k = m_sizeRes;
+    const auto& referenceState = reference.getStateVector();
+    for (int a = 0; a < k; ++a) {
+      double res = residuals(a);
+      for (int j = 0; j < m_sizeState; ++j) {
+        const double g = G(a, j);
+        m_G(a * m_sizeState + j, candidate) = g;
+        if (g != 0) {
+          res += g * (m_state(j, candidate) - referenceState(j));
+          m_usedColumn[j] = true;
+        }
+      }
+      m_res(a, candidate) = res;
+    }
+    // see KalmanCalculator::calculateGainMatrix(), V is only used if all its diagonal elements are set
+    const bool useV = (V.diagonal().array() != 0).all();
+    for (int a = 0; a < k; ++a) {
+      for (int b = 0; b <= a; ++b) {
+        m_V(a * k + b, candidate) = useV ? V(a, b) : 0.;
+      }
+    }
+    m_status[candidate] = status;
+  }
+
+  void BatchKalmanCalculator::filter()
+  {
+    const int n = m_size;
+    const int d = m_sizeState;
+    const int k = m_sizeRes;
+    std::vector<int> columns;
+    for (int j = 0; j < d; ++j) {
+      if (m_usedColumn[j]) columns.push_back(j);
+    }
+
+    // C G^t, only the used columns of G contribute
+    m_CGt.topRows(d * k).leftCols(n).setZero();
+    for (int j : columns) {
+      for (int i = 0; i < d; ++i) {
+        const auto cov = m_cov.row(packedIndex(i, j)).head(n);
+        for (int a = 0; a < k; ++a) {
+          m_CGt.row(i * k + a).head(n) += cov * m_G.row(a * d + j).head(n);
+        }
+      }
+    }
+
+    // lower triangle of R = G C G^t + V
+    for (int a = 0; a < k; ++a) {
+      for (int b = 0; b <= a; ++b) {
+        auto R = m_R.row(a * k + b).head(n);
+        R = m_V.row(a * k + b).head(n);
+        for (int j : columns) {
+          R += m_G.row(a * d + j).head(n) * m_CGt.row(j * k + b).head(n);
+        }
+      }
+    }
+
+    // R is inverted for each candidate with the fixed size kernels of the KalmanCalculator
+    Eigen::Matrix < double, -1, -1, 0, 7, 7 > R(k, k);
+    for (int candidate = 0; candidate < n; ++candidate) {
+      for (int a = 0; a < k; ++a) {
+        for (int b = 0; b <= a; ++b) {
+          R(a, b) = R(b, a) = m_R(a * k + b, candidate);
+        }
+      }
+      const Eigen::Matrix < double, -1, -1, 0, 7, 7 > Rinverse = KalmanCalculator::invertResidualCovariance(R);
+      for (int a = 0; a < k; ++a) {
+        for (int b = 0; b < k; ++b) {
+          m_Rinverse(a * k + b, candidate) = Rinverse(a, b);
+        }
+      }
+      if (!Rinverse.allFinite()) {
+        m_status[candidate] |= ErrCode(ErrCode::Status::inversionerror);
+      }
+    }
+
+    // K = C G^t R^-1
+    for (int i = 0; i < d; ++i) {
+      for (int a = 0; a < k; ++a) {
+        auto K = m_K.row(i * k + a).head(n);
+        K.setZero();
+        for (int b = 0; b < k; ++b) {
+          K += m_CGt.row(i * k + b).head(n) * m_Rinverse.row(b * k + a).head(n);
+        }
+      }
+    }
+
+    // the state is only updated if the gain matrix could be calculated, see Constraint::filterWithReference()
+    const double eps = Eigen::NumTraits<double>::epsilon();
+    for (int candidate = 0; candidate < n; ++candidate) {
+      if (m_status[candidate].failure()) {
+        m_chisq[candidate] = 1e10;
+        continue;
+      }
+      double chisq = 0;
+      for (int a = 0; a < k; ++a) {
+        for (int b = 0; b < k; ++b) {
+          chisq += m_res(a, candidate) * m_Rinverse(a * k + b, candidate) * m_res(b, candidate);
+        }
+      }
+      m_chisq[candidate] = chisq;
+      for (int i = 0; i < d; ++i) {
+        double update = 0;
+        for (int a = 0; a < k; ++a) {
+          update += m_K(i * k + a, candidate) * m_res(a, candidate);
+        }
+        m_state(i, candidate) -= update;
+      }
+      m_state(0, candidate) += eps;
+    }
+
+    // C' = C - K (C G^t)^t for the lower triangle, see KalmanCalculator::updateCovariance()
+    for (int j = 0; j < d; ++j) {
+      for (int i = j; i < d; ++i) {
+        auto cov = m_cov.row(m_columnOffset[j] + i).head(n);
+        for (int a = 0; a < k; ++a) {
+          cov -= m_K.row(i * k + a).head(n) * m_CGt.row(j * k + a).head(n);
+        }
+      }
+      m_cov.row(m_columnOffset[j] + j).head(n) += eps;
+    }
+  }
+
+  void BatchKalmanCalculator::remove(int candidate)
+  {
+    const int last = --m_size;
+    if (candidate != last) {
+      m_state.col(candidate) = m_state.col(last);
+      m_cov.col(candidate) = m_cov.col(last);
+    }
+  }
+}
@@ -78,13 +78,28 @@ namespace TreeFitter {
     return status;
   }
 
-  ErrCode DecayChain::filter(FitParams& par)
+  ErrCode DecayChain::initCovariance(FitParams& par) const
   {
-    ErrCode status;
     par.resetCovariance();
-    status |= m_headOfChain->initCovariance(par);
+    const ErrCode status = m_headOfChain->initCovariance(par);
     par.resetChiSquare();
-    for (auto constraint : m_constraintlist) {
+    return status;
+  }
+
+  std::vector<int> DecayChain::getTopology() const
+  {
+    std::vector<int> topology{m_dim};
+    for (const auto& constraint : m_constraintlist) {
+      topology.push_back(constraint.type());
+      topology.push_back(constraint.dim());
+    }
+    return topology;
+  }
+
+  ErrCode DecayChain::filter(FitParams& par)
+  {
+    ErrCode status = initCovariance(par);
+    for (auto& constraint : m_constraintlist) {
       status |= constraint.filter(par);
     }
     return status;
@@ -92,11 +107,8 @@ namespace TreeFitter {
 
   ErrCode DecayChain::filterWithReference(FitParams& par, const FitParams& ref)
   {
-    ErrCode status;
-    par.resetCovariance();
-    status |= m_headOfChain->initCovariance(par);
-    par.resetChiSquare();
-    for (auto constraint : m_constraintlist) {
+    ErrCode status = initCovariance(par);
+    for (auto& constraint : m_constraintlist) {
       status |= constraint.filterWithReference(par, ref);
     }
     return status;
@@ -15,10 +15,17 @@
 #include <framework/gearbox/Const.h>
 
 #include <analysis/VertexFitting/TreeFitter/FitManager.h>
+#include <analysis/VertexFitting/TreeFitter/BatchKalmanCalculator.h>
 #include <analysis/VertexFitting/TreeFitter/FitParams.h>
+#include <analysis/VertexFitting/TreeFitter/Projection.h>
 #include <analysis/VertexFitting/TreeFitter/DecayChain.h>
 #include <analysis/VertexFitting/TreeFitter/ParticleBase.h>
 
+namespace {
+  /** maximum number of iterations of the fit */
+  constexpr int nitermax = 100;
+}
+
 namespace TreeFitter {
 
   FitManager::FitManager(Belle2::Particle* particle,
@@ -34,7 +41,10 @@ namespace TreeFitter {
     m_updateDaugthers(updateDaughters),
     m_ndf(0),
     m_fitparams(nullptr),
-    m_config(config)
+    m_config(config),
+    m_niter(0),
+    m_ndiverging(0),
+    m_finished(false)
   {
     m_decaychain = new DecayChain(particle, config, false);
     m_fitparams  = new FitParams(m_decaychain->dim());
@@ -48,11 +58,23 @@ namespace TreeFitter {
 
   bool FitManager::fit()
   {
-    const int nitermax = 100;
-    const int maxndiverging = 3;
-    const double dChisqConv = m_prec;
+    startFit();
+    // state of the previous iteration, the storage is reused in all iterations
+    FitParams referenceState(m_fitparams->getDimensionOfState());
+    while (!m_finished) {
+      referenceState = *m_fitparams;
+      endIteration(m_decaychain->filterWithReference(*m_fitparams, referenceState));
+    }
+    return finishFit();
+  }
+
+  void FitManager::startFit()
+  {
     m_chiSquare = -1;
     m_errCode.reset();
+    m_niter = 0;
+    m_ndiverging = 0;
+    m_finished = false;
 
     if (m_status == VertexStatus::UnFitted) {
       m_errCode = m_decaychain->initialize(*m_fitparams);
@@ -60,47 +82,54 @@ namespace TreeFitter {
 
     if (m_errCode.failure()) {
       m_status = VertexStatus::BadInput;
+      m_finished = true;
     } else {
       m_status = VertexStatus::UnFitted;
-      int ndiverging = 0;
-      bool finished = false;
-      int niter = 0;
-      for (niter = 0; niter < nitermax && !finished; ++niter) {
-        if (niter == 0) {
-          m_errCode = m_decaychain->filter(*m_fitparams);
-        } else {
-          auto* tempState = new FitParams(*m_fitparams);
-          m_errCode = m_decaychain->filterWithReference(*m_fitparams, *tempState);
-          delete tempState;
-        }
-        m_ndf = m_fitparams->nDof();
-        double chisq = m_fitparams->chiSquare();
-        double deltachisq = chisq - m_chiSquare;
-        if (m_errCode.failure()) {
-          finished = true ;
-          m_status = VertexStatus::Failed;
-          m_particle->writeExtraInfo("failed", 1);
-        } else {
-          if (niter > 0) {
-            if ((std::abs(deltachisq) / m_chiSquare < dChisqConv)) {
-              m_chiSquare = chisq;
-              m_status = VertexStatus::Success;
-              finished = true ;
-              m_particle->writeExtraInfo("failed", 0);
-            } else if (deltachisq > 0 && ++ndiverging >= maxndiverging) {
-              m_particle->writeExtraInfo("failed", 2);
-              m_status = VertexStatus::NonConverged;
-              m_errCode = ErrCode(ErrCode::Status::slowdivergingfit);
-              finished = true ;
-            }
-          }
-          if (deltachisq < 0) {
-            ndiverging = 0;
-          }
+      endIteration(m_decaychain->filter(*m_fitparams));
+    }
+  }
+
+  void FitManager::endIteration(const ErrCode& status)
+  {
+    const int maxndiverging = 3;
+    const double dChisqConv = m_prec;
+
+    m_errCode = status;
+    m_ndf = m_fitparams->nDof();
+    double chisq = m_fitparams->chiSquare();
+    double deltachisq = chisq - m_chiSquare;
+    if (m_errCode.failure()) {
+      m_finished = true ;
+      m_status = VertexStatus::Failed;
+      m_particle->writeExtraInfo("failed", 1);
+    } else {
+      if (m_niter > 0) {
+        if ((std::abs(deltachisq) / m_chiSquare < dChisqConv)) {
           m_chiSquare = chisq;
+          m_status = VertexStatus::Success;
+          m_finished = true ;
+          m_particle->writeExtraInfo("failed", 0);
+        } else if (deltachisq > 0 && ++m_ndiverging >= maxndiverging) {
+          m_particle->writeExtraInfo("failed", 2);
+          m_status = VertexStatus::NonConverged;
+          m_errCode = ErrCode(ErrCode::Status::slowdivergingfit);
+          m_finished = true ;
         }
       }
-      if (niter == nitermax && m_status != VertexStatus::Success) {
+      if (deltachisq < 0) {
+        m_ndiverging = 0;
+      }
+      m_chiSquare = chisq;
+    }
+    if (++m_niter == nitermax) {
+      m_finished = true;
+    }
+  }
+
+  bool FitManager::finishFit()
+  {
+    if (m_status != VertexStatus::BadInput) {
+      if (m_niter == nitermax && m_status != VertexStatus::Success) {
         m_particle->writeExtraInfo("failed", 3);
         m_status = VertexStatus::NonConverged;
       }
@@ -122,6 +151,71 @@ namespace TreeFitter {
     return (m_status == VertexStatus::Success);
   }
 
+  std::vector<int> FitManager::getTopology() const
+  {
+    return m_decaychain->getTopology();
+  }
+
+  void FitManager::fitBatch(const std::vector<FitManager*>& fits)
+  {
+    std::vector<FitManager*> active;
+    for (FitManager* fit : fits) {
+      if (!fit->m_finished) active.push_back(fit);
+    }
+    if (active.empty()) return;
+
+    const std::vector<int> topology = active.front()->getTopology();
+    for (const FitManager* fit : active) {
+      if (fit->getTopology() != topology) {
+        B2FATAL("Only candidates with the same decay topology can be fitted together.");
+      }
+    }
+
+    const int dim = active.front()->m_fitparams->getDimensionOfState();
+    BatchKalmanCalculator kalman(dim, active.size());
+    std::vector<ErrCode> status(active.size());
+    while (!active.empty()) {
+      // The constraints are linearised around the state of the previous iteration like in
+      // DecayChain::filterWithReference(). That state stays in the FitParams of each
+      // candidate until the end of the iteration, the new state is kept in the batch.
+      for (size_t i = 0; i < active.size(); ++i) {
+        FitManager& fit = *active[i];
+        status[i] = fit.m_decaychain->initCovariance(*fit.m_fitparams);
+        kalman.setState(i, *fit.m_fitparams);
+      }
+      const auto& constraints = active.front()->m_decaychain->getConstraintList();
+      for (size_t iConstraint = 0; iConstraint < constraints.size(); ++iConstraint) {
+        const unsigned int constraintDim = constraints[iConstraint].dim();
+        Projection p(dim, constraintDim);
+        kalman.beginConstraint(constraintDim);
+        for (size_t i = 0; i < active.size(); ++i) {
+          const FitManager& fit = *active[i];
+          p.resetProjection();
+          const ErrCode projectionStatus = fit.m_decaychain->getConstraintList()[iConstraint].project(*fit.m_fitparams, p);
+          kalman.setProjection(i, p.getResiduals(), p.getH(), p.getV(), *fit.m_fitparams, projectionStatus);
+        }
+        kalman.filter();
+        for (size_t i = 0; i < active.size(); ++i) {
+          status[i] |= kalman.getErrCode(i);
+          active[i]->m_fitparams->addChiSquare(kalman.getChiSquare(i), constraintDim);
+        }
+      }
+      // backwards, so that the candidate which replaces a finished one has already been handled
+      for (size_t i = active.size(); i-- > 0;) {
+        FitManager& fit = *active[i];
+        kalman.getState(i, *fit.m_fitparams);
+        fit.endIteration(status[i]);
+        if (fit.m_finished) {
+          kalman.remove(i);
+          active[i] = active.back();
+          active.pop_back();
+          status[i] = status.back();
+          status.pop_back();
+        }
+      }
+    }
+  }
+
   void FitManager::getCovFromPB(const ParticleBase* pb, TMatrixFSym& returncov) const
   {
 
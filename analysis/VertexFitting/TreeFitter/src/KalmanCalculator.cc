@@ -9,6 +9,32 @@
 
 #include <analysis/VertexFitting/TreeFitter/KalmanCalculator.h>
 
+namespace {
+
+  /** Inverse of the N x N matrix R, evaluated with the fixed size kernels of Eigen (closed form up to 4x4). */
+  template <int N>
+  Eigen::Matrix < double, -1, -1, 0, 7, 7 > fixedSizeInverse(const Eigen::Matrix < double, -1, -1, 0, 7, 7 > & R)
+  {
+    const Eigen::Matrix<double, N, N> fixedR = R;
+    return fixedR.inverse();
+  }
+
+  /** Inverse of R, dispatched to a fixed size kernel for the dimension of the constraint. */
+  Eigen::Matrix < double, -1, -1, 0, 7, 7 > constraintInverse(const Eigen::Matrix < double, -1, -1, 0, 7, 7 > & R)
+  {
+    switch (R.rows()) {
+      case 1: return fixedSizeInverse<1>(R);
+      case 2: return fixedSizeInverse<2>(R);
+      case 3: return fixedSizeInverse<3>(R);
+      case 4: return fixedSizeInverse<4>(R);
+      case 5: return fixedSizeInverse<5>(R);
+      case 6: return fixedSizeInverse<6>(R);
+      case 7: return fixedSizeInverse<7>(R);
+      default: return R.inverse();
+    }
+  }
+}
+
 namespace TreeFitter {
 
   KalmanCalculator::KalmanCalculator(
@@ -38,9 +64,8 @@ namespace TreeFitter {
     m_res = residuals;
     m_G = G;
 
-    Eigen::Matrix < double, -1, -1, 0, MAX_MATRIX_SIZE, MAX_MATRIX_SIZE > C = fitparams.getCovariance().triangularView<Eigen::Lower>();
-
-    m_CGt = C.selfadjointView<Eigen::Lower>() * G.transpose();
+    // only the lower triangle of the covariance is kept up to date
+    m_CGt.noalias() = fitparams.getCovariance().selfadjointView<Eigen::Lower>() * G.transpose();
     Eigen::Matrix < double, -1, -1, 0, 7, 7 > Rtemp = G * m_CGt;
     if (V && (weight) && ((*V).diagonal().array() != 0).all()) {
 
@@ -55,18 +80,25 @@ namespace TreeFitter {
 
     Eigen::Matrix < double, -1, -1, 0, 7, 7 > RInvtemp;
     RInvtemp = m_R.selfadjointView<Eigen::Lower>();
-    m_Rinverse = RInvtemp.inverse();
+    m_Rinverse = invertResidualCovariance(RInvtemp);
+    m_K.noalias() = m_CGt * m_Rinverse.selfadjointView<Eigen::Lower>();
     if (!m_Rinverse.allFinite()) { return ErrCode(ErrCode::Status::inversionerror); }
 
-    m_K = m_CGt * m_Rinverse.selfadjointView<Eigen::Lower>();
     return ErrCode(ErrCode::Status::success);
   }
 
+  Eigen::Matrix < double, -1, -1, 0, 7, 7 > KalmanCalculator::invertResidualCovariance(const
+      Eigen::Matrix < double, -1, -1, 0, 7, 7 > & R)
+  {
+    return constraintInverse(R);
+  }
+
   void KalmanCalculator::updateState(FitParams& fitparams)
   {
     double eps = Eigen::NumTraits<double>::epsilon();
-    fitparams.getStateVector() = (fitparams.getStateVector().array() - (m_K * m_res).array()).matrix()
-                                 + eps * Eigen::MatrixXd::Identity(fitparams.getStateVector().rows(), fitparams.getStateVector().cols());
+    fitparams.getStateVector().noalias() -= m_K * m_res;
+    // the identity of the shape of the state vector only has its first element set
+    fitparams.getStateVector()(0) += eps;
     m_chisq = m_res.transpose() * m_Rinverse.selfadjointView<Eigen::Lower>() * m_res;
   }
 
@@ -82,28 +114,18 @@ namespace TreeFitter {
     m_chisq = res_prime.transpose() * m_Rinverse.selfadjointView<Eigen::Lower>() * res_prime;
   }
 
-  TREEFITTER_NO_STACK_WARNING
-
   void KalmanCalculator::updateCovariance(FitParams& fitparams)
   {
-    Eigen::Matrix < double, -1, -1, 0, MAX_MATRIX_SIZE, MAX_MATRIX_SIZE > fitCov  =
-      fitparams.getCovariance().triangularView<Eigen::Lower>();
-
-    Eigen::Matrix < double, -1, -1, 0, MAX_MATRIX_SIZE, MAX_MATRIX_SIZE > GRinvGt =
-      m_G.transpose() * m_Rinverse.selfadjointView<Eigen::Lower>() * m_G;
-
-    //fitcov is sym so no transpose needed (not that it would have runtime cost)
-    Eigen::Matrix < double, -1, -1, 0, MAX_MATRIX_SIZE, MAX_MATRIX_SIZE > deltaCov  =
-      fitCov.selfadjointView<Eigen::Lower>() * GRinvGt * fitCov.selfadjointView<Eigen::Lower>();
-
+    // C' = C - C G^t R^-1 G C = C - K (C G^t)^t, evaluated column by column for the lower triangle only.
+    // This avoids temporaries of the size of the covariance and the product of two of them.
+    Eigen::Matrix < double, -1, -1, 0, MAX_MATRIX_SIZE, MAX_MATRIX_SIZE > & fitCov = fitparams.getCovariance();
+    const int dim = fitCov.rows();
     double eps = Eigen::NumTraits<double>::epsilon();
-    Eigen::Matrix < double, -1, -1, 0, MAX_MATRIX_SIZE, MAX_MATRIX_SIZE > delta =
-      (fitCov.array() - deltaCov.array()).matrix() + eps * Eigen::MatrixXd::Identity(fitCov.rows(), fitCov.cols());
-
-    fitparams.getCovariance().triangularView<Eigen::Lower>() = delta.triangularView<Eigen::Lower>();
-
+    for (int col = 0; col < dim; ++col) {
+      const int nRows = dim - col;
+      fitCov.col(col).tail(nRows).noalias() -= m_K.bottomRows(nRows) * m_CGt.row(col).transpose();
+      fitCov(col, col) += eps;
+    }
   }//end function
 
-  TREEFITTER_RESTORE_WARNINGS
-
 }// end namespace
@@ -941,6 +941,15 @@ namespace Belle2 {
     /** Return whether the extra info with the given name is set. */
     bool hasExtraInfo(const std::string& name) const;
 
+    /** Return given value if set, see ParticleExtraInfoMap::getKey() for the key of a name.
+     *
+     * throws std::runtime_error if variable is not set.
+     */
+    double getExtraInfo(int key) const;
+
+    /** Return whether the extra info with the given key is set, see ParticleExtraInfoMap::getKey(). */
+    bool hasExtraInfo(int key) const;
+
     /** Return the id of the associated ParticleExtraInfoMap or -1 if no map is set. */
     int getExtraInfoMap() const
     {
@@ -970,6 +979,24 @@ namespace Belle2 {
      */
     void addExtraInfo(const std::string& name, double value);
 
+    /**
+     * Sets the user defined extraInfo with the given key, see ParticleExtraInfoMap::getKey().
+     * Adds it if necessary, overwrites it if it is already set.
+     */
+    void writeExtraInfo(int key, double value);
+
+    /** Sets the user-defined data with the given key to the given value.
+     *
+     * throws std::runtime_error if variable isn't set.
+     */
+    void setExtraInfo(int key, double value);
+
+    /** Sets the user-defined data with the given key to the given value.
+     *
+     * throws std::runtime_error if variable is already set.
+     */
+    void addExtraInfo(int key, double value);
+
     /** Returns the pointer to the store array which holds the daughter particles
      *
      *  \warning TClonesArray is dangerously easy to misuse, please avoid.
@@ -1164,6 +1191,16 @@ namespace Belle2 {
     // TODO: this can be optimized for speed
     void fillDecayChain(std::vector<int>& decayChain) const;
 
+    /**
+     * Return index of the extra info with the given key in m_extraInfo, or 0 if it is not set.
+     */
+    unsigned int getExtraInfoIndex(int key) const;
+
+    /**
+     * Append the extra info with the given name, which must not be set yet.
+     */
+    void appendExtraInfo(const std::string& name, double value);
+
     /**
      * sets m_flavorType using m_pdgCode
      */
@@ -21,6 +21,10 @@ namespace Belle2 {
    *
    * Modules registering a StoreArray<Particle> should always register a StoreObjPtr<ParticleExtraInfoMap>
    * to allow storing additional information.
+   *
+   * Besides by name, extra info can be accessed by an integer key obtained once per job with getKey()
+   * (e.g. in the initialize method of a module). Lookups by key use a transient table per map and
+   * avoid the string comparisons of the std::map. The keys are not stored, only the maps are written out.
    */
   class ParticleExtraInfoMap : public TObject {
   public:
@@ -32,9 +36,32 @@ namespace Belle2 {
     /** Return reference to map with given ID. */
     const IndexMap& getMap(unsigned int mapID) const { return m_maps[mapID]; }
 
+    /** Value of an invalid extra info key. */
+    const static int c_InvalidKey = -1;
+
+    /** Return the key for the given extra info name, registering the name if necessary.
+     *
+     * Keys are valid for the whole job and independent of the maps of the current event.
+     */
+    static int getKey(const std::string& name);
+
+    /** Return the name of the extra info with the given key. */
+    static const std::string& getNameFromKey(int key);
+
     /** Find index for name in the given map, or return 0 if not found. */
     unsigned int getIndex(unsigned int mapID, const std::string& name) const;
 
+    /** Find index for the key (see getKey()) in the given map, or return 0 if not found. */
+    unsigned int getIndex(unsigned int mapID, int key) const
+    {
+      if (mapID < m_keyIndices.size()) {
+        const std::vector<unsigned int>& indices = m_keyIndices[mapID];
+        if ((unsigned int)key < indices.size())
+          return indices[key];
+      }
+      return getIndexUpdateKeys(mapID, key);
+    }
+
     /** Return map ID to a map that has 'name' as first entry.
      *
      * Creates a new map if necessary.
@@ -51,11 +78,17 @@ namespace Belle2 {
     unsigned int getNMaps() const { return m_maps.size(); }
 
   private:
+    /** Rebuild the key -> index table of the given map and return the index for the key. */
+    unsigned int getIndexUpdateKeys(unsigned int mapID, int key) const;
+
     /** check if all entries in 'oldMap' prior to insertIndex are found in 'map' (with same idx). */
     static bool isCompatible(const IndexMap& oldMap, const IndexMap& map, unsigned int insertIndex);
 
     std::vector<IndexMap> m_maps; /**< List of string -> index maps. */
 
+    /** key -> index tables for the maps in m_maps, 0 for names not in the map. Built on first access by key. */
+    mutable std::vector<std::vector<unsigned int>> m_keyIndices; //!
+
     ClassDef(ParticleExtraInfoMap, 1); /**< Internal class to store string -> index maps for user-defined variables in Particle. */
   };
 }
@@ -26,6 +26,13 @@
 #pragma link C++ class Belle2::ParticleExtraInfoMap::IndexMap+; // checksum=0xf9eb593, version=6
 #pragma link C++ class map<string, unsigned int>+; // checksum=0xf9eb593, version=6
 #pragma link C++ class vector<map<string, unsigned int> >+; // checksum=0x267ce51a, version=6
+
+// the key -> index tables are transient and must not survive reading another event into the same object
+#pragma read sourceClass="Belle2::ParticleExtraInfoMap" version="[1-]" \
+  source="" \
+  targetClass="Belle2::ParticleExtraInfoMap" target="m_keyIndices" \
+  code="{m_keyIndices.clear();}"
+
 #pragma link C++ class Belle2::Btube+; // checksum=0x772238ab, version=1
 #pragma link C++ class Eigen::Matrix<double,3,1,0,3,1>+; // checksum=0x43805c43, version=-1
 #pragma link C++ class Eigen::PlainObjectBase<Eigen::Matrix<double,3,1,0,3,1> >+; // checksum=0x6464cd47, version=-1
@@ -1422,6 +1422,11 @@ void Particle::addExtraInfo(const std::string& name, double value)
   if (hasExtraInfo(name))
     throw std::runtime_error(std::string("addExtraInfo: Value '") + name + "' already set!");
 
+  appendExtraInfo(name, value);
+}
+
+void Particle::appendExtraInfo(const std::string& name, double value)
+{
   StoreObjPtr<ParticleExtraInfoMap> extraInfoMap;
   if (!extraInfoMap)
     extraInfoMap.create();
@@ -1439,6 +1444,63 @@ void Particle::addExtraInfo(const std::string& name, double value)
   }
 }
 
+unsigned int Particle::getExtraInfoIndex(int key) const
+{
+  if (m_extraInfo.empty())
+    return 0;
+
+  const auto mapID = (unsigned int)m_extraInfo[0];
+  StoreObjPtr<ParticleExtraInfoMap> extraInfoMap;
+  if (!extraInfoMap) {
+    B2FATAL("ParticleExtraInfoMap not available, but needed for storing extra info in Particle!");
+  }
+  unsigned int index = extraInfoMap->getIndex(mapID, key);
+  if (index >= m_extraInfo.size()) //actually indices start at 1
+    return 0;
+  return index;
+}
+
+bool Particle::hasExtraInfo(int key) const
+{
+  return getExtraInfoIndex(key) != 0;
+}
+
+double Particle::getExtraInfo(int key) const
+{
+  unsigned int index = getExtraInfoIndex(key);
+  if (index == 0)
+    throw std::runtime_error(std::string("getExtraInfo: Value '") + ParticleExtraInfoMap::getNameFromKey(key) + "' not found in Particle!");
+
+  return m_extraInfo[index];
+}
+
+void Particle::writeExtraInfo(int key, double value)
+{
+  unsigned int index = getExtraInfoIndex(key);
+  if (index != 0) {
+    m_extraInfo[index] = value;
+  } else {
+    appendExtraInfo(ParticleExtraInfoMap::getNameFromKey(key), value);
+  }
+}
+
+void Particle::setExtraInfo(int key, double value)
+{
+  unsigned int index = getExtraInfoIndex(key);
+  if (index == 0)
+    throw std::runtime_error(std::string("setExtraInfo: Value '") + ParticleExtraInfoMap::getNameFromKey(key) + "' not found in Particle!");
+
+  m_extraInfo[index] = value;
+}
+
+void Particle::addExtraInfo(int key, double value)
+{
+  if (hasExtraInfo(key))
+    throw std::runtime_error(std::string("addExtraInfo: Value '") + ParticleExtraInfoMap::getNameFromKey(key) + "' already set!");
+
+  appendExtraInfo(ParticleExtraInfoMap::getNameFromKey(key), value);
+}
+
 bool Particle::forEachDaughter(const std::function<bool(const Particle*)>& function,
                                bool recursive, bool includeSelf) const
 {
@@ -8,9 +8,70 @@
 
 #include <analysis/dataobjects/ParticleExtraInfoMap.h>
 
+#include <framework/logging/Logger.h>
+
+#include <unordered_map>
 
 using namespace Belle2;
 
+namespace {
+  /** Names of all extra info keys, indexed by key. */
+  std::vector<std::string>& keyNames()
+  {
+    static std::vector<std::string> names;
+    return names;
+  }
+
+  /** Keys of all registered extra info names. */
+  std::unordered_map<std::string, int>& keysByName()
+  {
+    static std::unordered_map<std::string, int> keys;
+    return keys;
+  }
+}
+
+int ParticleExtraInfoMap::getKey(const std::string& name)
+{
+  auto& keys = keysByName();
+  auto it = keys.find(name);
+  if (it != keys.end())
+    return it->second;
+
+  std::vector<std::string>& names = keyNames();
+  const int key = names.size();
+  names.push_back(name);
+  keys.emplace(name, key);
+  return key;
+}
+
+const std::string& ParticleExtraInfoMap::getNameFromKey(int key)
+{
+  const std::vector<std::string>& names = keyNames();
+  if (key < 0 or (unsigned int)key >= names.size())
+    B2FATAL("ParticleExtraInfoMap: invalid extra info key " << key);
+  return names[key];
+}
+
+unsigned int ParticleExtraInfoMap::getIndexUpdateKeys(unsigned int mapID, int key) const
+{
+  const std::vector<std::string>& names = keyNames();
+  if (key < 0 or (unsigned int)key >= names.size())
+    B2FATAL("ParticleExtraInfoMap: invalid extra info key " << key);
+
+  //keys registered after the table was built are not in it yet, so always rebuild the complete table
+  if (m_keyIndices.size() < m_maps.size())
+    m_keyIndices.resize(m_maps.size());
+  std::vector<unsigned int>& indices = m_keyIndices[mapID];
+  indices.assign(names.size(), 0);
+  const auto& keys = keysByName();
+  for (const auto& pair : m_maps[mapID]) {
+    auto it = keys.find(pair.first);
+    if (it != keys.end())
+      indices[it->second] = pair.second;
+  }
+  return indices[key];
+}
+
 unsigned int ParticleExtraInfoMap::getIndex(unsigned int mapID, const std::string& name) const
 {
   const IndexMap& map = m_maps[mapID];
@@ -48,6 +109,8 @@ unsigned int ParticleExtraInfoMap::getMapForNewVar(const std::string& name, unsi
   if (lastIndexInOldMap + 1 == insertIndex) {
     //we can make oldMap fit by adding one entry
     m_maps[oldMapID][name] = insertIndex;
+    if (oldMapID < m_keyIndices.size())
+      m_keyIndices[oldMapID].clear();
     return oldMapID;
   }
   auto oldMapIter = oldMap.find(name);
@@ -78,6 +78,7 @@ namespace Belle2 {
     double m_Bfield;              /**< magnetic field from data base */
     std::string m_vertexFitter;   /**< Vertex Fitter name */
     std::string m_fitType;        /**< type of the kinematic fit */
+    std::string m_kfitBackend;    /**< matrix implementation of KFit */
     std::string m_withConstraint; /**< additional constraint on vertex */
     std::string m_decayString;    /**< daughter particles selection */
     bool m_updateDaughters;       /**< flag for daughters update */
@@ -68,6 +68,10 @@ ParticleVertexFitterModule::ParticleVertexFitterModule() : Module(),
            0.001);
   addParam("vertexFitter", m_vertexFitter, "KFit or Rave", string("KFit"));
   addParam("fitType", m_fitType, "type of the kinematic fit (vertex, massvertex, mass)", string("vertex"));
+  addParam("kfitBackend", m_kfitBackend,
+           "matrix implementation of KFit: CLHEP or Eigen. Eigen is used for all fits except vertex fits "
+           "with IP profile constraint and vertex fits of more than 4 tracks, the results are the same.",
+           string("CLHEP"));
   addParam("withConstraint", m_withConstraint,
            "additional constraint on vertex: ipprofile, iptube, mother, iptubecut, pointing, btube",
            string(""));
@@ -94,6 +98,9 @@ void ParticleVertexFitterModule::initialize()
   B2DEBUG(1, "ParticleVertexFitterModule : magnetic field = " << m_Bfield);
 
 
+  if (m_kfitBackend != "CLHEP" && m_kfitBackend != "Eigen")
+    B2FATAL("ParticleVertexFitter: " << m_kfitBackend << " ***invalid KFit backend ");
+
   if (m_decayString != "")
     m_decaydescriptor.init(m_decayString);
 
@@ -447,6 +454,7 @@ bool ParticleVertexFitterModule::redoTwoPhotonDaughterMassFit(Particle* postFit,
   // perform the mass fit for the two-photon particle
   analysis::MassFitKFit km;
   km.setMagneticField(m_Bfield);
+  km.setEigenBackend(m_kfitBackend == "Eigen");
 
   km.addParticle(&g1Temp);
   km.addParticle(&g2Temp);
@@ -496,6 +504,7 @@ bool ParticleVertexFitterModule::doKVertexFit(Particle* mother, bool ipProfileCo
   // Initialise the Fitter
   analysis::VertexFitKFit kv;
   kv.setMagneticField(m_Bfield);
+  kv.setEigenBackend(m_kfitBackend == "Eigen");
 
   if (mother->getV0()) {
     HepPoint3D V0vertex_heppoint(mother->getV0()->getFittedVertexX(),
@@ -542,6 +551,7 @@ bool ParticleVertexFitterModule::doKVertexFit(Particle* mother, bool ipProfileCo
     // finally perform the fit using all daughter particles
     analysis::VertexFitKFit kv2;
     kv2.setMagneticField(m_Bfield);
+    kv2.setEigenBackend(m_kfitBackend == "Eigen");
 
     for (auto& child : fitChildren)
       kv2.addParticle(child);
@@ -593,6 +603,7 @@ bool ParticleVertexFitterModule::doKMassVertexFit(Particle* mother)
     // Initialise the Fitter
     analysis::MassVertexFitKFit kmv;
     kmv.setMagneticField(m_Bfield);
+    kmv.setEigenBackend(m_kfitBackend == "Eigen");
 
     if (mother->getV0()) {
       HepPoint3D V0vertex_heppoint(mother->getV0()->getFittedVertexX(),
@@ -619,6 +630,7 @@ bool ParticleVertexFitterModule::doKMassVertexFit(Particle* mother)
 
     analysis::VertexFitKFit kv;
     kv.setMagneticField(m_Bfield);
+    kv.setEigenBackend(m_kfitBackend == "Eigen");
 
     for (auto child : fitChildren)
       kv.addParticle(child);
@@ -637,6 +649,7 @@ bool ParticleVertexFitterModule::doKMassVertexFit(Particle* mother)
     // finally perform the fit using all daughter particles
     analysis::MassVertexFitKFit kmv2;
     kmv2.setMagneticField(m_Bfield);
+    kmv2.setEigenBackend(m_kfitBackend == "Eigen");
 
     for (auto child : fitChildren)
       kmv2.addParticle(child);
@@ -683,6 +696,7 @@ bool ParticleVertexFitterModule::doKMassPointingVertexFit(Particle* mother)
   // Initialise the Fitter
   analysis::MassPointingVertexFitKFit kmpv;
   kmpv.setMagneticField(m_Bfield);
+  kmpv.setEigenBackend(m_kfitBackend == "Eigen");
 
   for (auto child : fitChildren)
     kmpv.addParticle(child);
@@ -706,6 +720,7 @@ bool ParticleVertexFitterModule::doKMassFit(Particle* mother)
 
   analysis::MassFitKFit km;
   km.setMagneticField(m_Bfield);
+  km.setEigenBackend(m_kfitBackend == "Eigen");
 
   for (unsigned ichild = 0; ichild < mother->getNDaughters(); ichild++) {
     const Particle* child = mother->getDaughter(ichild);
@@ -733,6 +748,7 @@ bool ParticleVertexFitterModule::doKFourCFit(Particle* mother)
 
   analysis::FourCFitKFit kf;
   kf.setMagneticField(m_Bfield);
+  kf.setEigenBackend(m_kfitBackend == "Eigen");
 
   for (unsigned ichild = 0; ichild < mother->getNDaughters(); ichild++) {
     const Particle* child = mother->getDaughter(ichild);
@@ -766,6 +782,7 @@ bool ParticleVertexFitterModule::doKMassFourCFit(Particle* mother)
 
   analysis::MassFourCFitKFit kf;
   kf.setMagneticField(m_Bfield);
+  kf.setEigenBackend(m_kfitBackend == "Eigen");
 
   for (unsigned ichild = 0; ichild < mother->getNDaughters(); ichild++) {
     const Particle* child = mother->getDaughter(ichild);
@@ -800,6 +817,7 @@ bool ParticleVertexFitterModule::doKRecoilMassFit(Particle* mother)
 {
   analysis::RecoilMassKFit kf;
   kf.setMagneticField(m_Bfield);
+  kf.setEigenBackend(m_kfitBackend == "Eigen");
 
   for (unsigned ichild = 0; ichild < mother->getNDaughters(); ichild++) {
     const Particle* child = mother->getDaughter(ichild);
@@ -15,15 +15,23 @@
 #include <analysis/dataobjects/ParticleList.h>
 
 #include <analysis/DecayDescriptor/DecayDescriptor.h>
+#include <analysis/VertexFitting/TreeFitter/ConstraintConfiguration.h>
 
 #include <Eigen/Dense>
 
+#include <memory>
+
 namespace Belle2 {
   class Particle;
 
   /** Module to fit an entire decay tree.
    * The newton method is used to minimize the chi2 derivative.
    * We use a kalman filter within the newton method to smooth the statevector.
+   *
+   * By default the candidates are fitted one after the other. With batchSize > 1 the first iteration
+   * is done for each candidate on its own and the remaining iterations for up to batchSize candidates
+   * with the same decay topology together, see TreeFitter::FitManager::fitBatch().
+   * The time spent in the fits is recorded as named time "fit" in the module statistics.
    */
   class TreeFitterModule : public Module {
 
@@ -172,5 +180,11 @@ namespace Belle2 {
     /** StoreArray of Particles */
     StoreArray<Particle> m_particles;
 
+    /** maximum number of candidates with the same decay topology that are fitted together */
+    int m_batchSize;
+
+    /** configuration of the constraints, the same for all candidates of a run */
+    std::unique_ptr<const TreeFitter::ConstraintConfiguration> m_constraintConfiguration;
+
   };
 }
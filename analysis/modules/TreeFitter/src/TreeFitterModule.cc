@@ -13,12 +13,18 @@
 #include <analysis/VertexFitting/TreeFitter/FitManager.h>
 
 #include <framework/particledb/EvtGenDatabasePDG.h>
+#include <framework/core/ProcessStatistics.h>
+#include <framework/utilities/Utils.h>
 
 #include <analysis/utility/ParticleCopy.h>
 #include <analysis/utility/PCmsLabTransform.h>
 
 #include <analysis/VertexFitting/TreeFitter/FitParameterDimensionException.h>
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
 using namespace Belle2;
 
 REG_MODULE(TreeFitter);
@@ -89,6 +95,9 @@ TreeFitterModule::TreeFitterModule() : Module(), m_nCandidatesBeforeFit(-1), m_n
 
   addParam("ignoreFromVertexFit", m_ignoreFromVertexFit,
            "Type::[string]. Decay string to select particles that will be ignored to determine the vertex position while kept for kinematics determination.", {});
+  addParam("batchSize", m_batchSize,
+           "Type::int. Maximum number of candidates with the same decay topology whose fit iterations are done together. The Kalman filter is then vectorized over the candidates, which is faster for large candidate lists. The results agree with the candidate by candidate fit up to rounding. 1: fit the candidates one after the other.",
+           1);
 }
 
 void TreeFitterModule::initialize()
@@ -98,6 +107,9 @@ void TreeFitterModule::initialize()
   m_nCandidatesBeforeFit = 0;
   m_nCandidatesAfter = 0;
   m_usePDGMassForMassConstraint = m_massConstraintMassValues.empty();
+  if (m_batchSize < 1) {
+    B2ERROR("TreeFitterModule::initialize The batch size has to be at least 1");
+  }
 
   if (!m_massConstraintDecayString.empty()) {
     if (!m_massConstraintList.empty())
@@ -146,6 +158,24 @@ void TreeFitterModule::beginRun()
     m_beamCovariance(i, i) = covE;
     // TODO Currently, we do not get a full covariance matrix from beamparams, and the py value is zero, which means there is no constraint on py. Therefore, we approximate it by a diagonal matrix using the energy value for all components. This is based on the assumption that the components of the beam four-momentum are independent and of comparable size.
   }
+
+  m_constraintConfiguration = std::make_unique<const TreeFitter::ConstraintConfiguration>(
+                                m_massConstraintType,
+                                m_massConstraintList,
+                                m_fixedToMotherVertexListPDG,
+                                m_geoConstraintListPDG,
+                                m_removeConstraintList,
+                                m_automatic_vertex_constraining,
+                                m_ipConstraint,
+                                m_customOrigin,
+                                m_customOriginVertex,
+                                m_customOriginCovariance,
+                                m_originDimension,
+                                m_beamConstraintPDG,
+                                m_beamMomE,
+                                m_beamCovariance,
+                                m_inflationFactorCovZ
+                              );
 }
 
 void TreeFitterModule::event()
@@ -156,6 +186,10 @@ void TreeFitterModule::event()
   }
 
   std::vector<unsigned int> toRemove;
+  double fitTime = 0;
+  // with batchSize > 1: all fits of the event and the unfinished ones grouped by decay topology
+  std::vector<std::unique_ptr<TreeFitter::FitManager>> fits;
+  std::map<std::vector<int>, std::vector<TreeFitter::FitManager*>> batches;
   const unsigned int nParticles = m_plist->getListSize();
   m_nCandidatesBeforeFit += nParticles;
 
@@ -218,20 +252,55 @@ void TreeFitterModule::event()
       }
     }
 
+    const double fitStart = Utils::getClock();
     try {
-      const bool ok = fitTree(particle);
-      if (!ok) { particle->setPValue(-1); }
+      if (m_batchSize > 1) {
+        auto fit = std::make_unique<TreeFitter::FitManager>(particle, *m_constraintConfiguration, m_precision, m_updateDaughters);
+        fit->startFit();
+        if (!fit->isFinished()) batches[fit->getTopology()].push_back(fit.get());
+        fits.push_back(std::move(fit));
+      } else {
+        const bool ok = fitTree(particle);
+        if (!ok) { particle->setPValue(-1); }
+      }
     } catch (TreeFitter::FitParameterDimensionException const& e) {
       B2ERROR(e.what());
     }
+    fitTime += Utils::getClock() - fitStart;
+  }
+
+  const double batchStart = Utils::getClock();
+  for (const auto& topologyAndFits : batches) {
+    const std::vector<TreeFitter::FitManager*>& sameTopology = topologyAndFits.second;
+    for (size_t first = 0; first < sameTopology.size(); first += m_batchSize) {
+      const size_t last = std::min(sameTopology.size(), first + m_batchSize);
+      const std::vector<TreeFitter::FitManager*> batch(sameTopology.begin() + first, sameTopology.begin() + last);
+      try {
+        TreeFitter::FitManager::fitBatch(batch);
+      } catch (TreeFitter::FitParameterDimensionException const& e) {
+        B2ERROR(e.what());
+      }
+    }
+  }
+  for (const auto& fit : fits) {
+    const bool ok = fit->finishFit();
+    if (!ok) { fit->particle()->setPValue(-1); }
+  }
+  fitTime += Utils::getClock() - batchStart;
 
+  for (unsigned iPart = 0; iPart < nParticles; iPart++) {
+    const Particle* particle = m_plist->getParticle(iPart);
     if (particle->getPValue() < m_confidenceLevel) {
       toRemove.push_back(particle->getArrayIndex());
     }
-
   }
   m_plist->removeParticles(toRemove);
   m_nCandidatesAfter += m_plist->getListSize();
+
+  // the time of the fits without the preparation of the candidates, see named_time_sum("fit") of the module statistics
+  StoreObjPtr<ProcessStatistics> processStatistics("", DataStore::c_Persistent);
+  if (processStatistics)
+    processStatistics->getStatistics(this).addNamedTime("fit", fitTime);
 }
 
 
@@ -247,28 +316,10 @@ void TreeFitterModule::terminate()
 
 bool TreeFitterModule::fitTree(Particle* head)
 {
-  const TreeFitter::ConstraintConfiguration constrConfig(
-    m_massConstraintType,
-    m_massConstraintList,
-    m_fixedToMotherVertexListPDG,
-    m_geoConstraintListPDG,
-    m_removeConstraintList,
-    m_automatic_vertex_constraining,
-    m_ipConstraint,
-    m_customOrigin,
-    m_customOriginVertex,
-    m_customOriginCovariance,
-    m_originDimension,
-    m_beamConstraintPDG,
-    m_beamMomE,
-    m_beamCovariance,
-    m_inflationFactorCovZ
-  );
-
   std::unique_ptr<TreeFitter::FitManager> TreeFitter(
     new TreeFitter::FitManager(
       head,
-      constrConfig,
+      *m_constraintConfiguration,
       m_precision,
       m_updateDaughters
     )
@@ -61,6 +61,8 @@ namespace Belle2 {
     std::vector<Variable::Manager::FunctionPtr> m_functions;
     /** Vector of extra info names */
     std::vector<std::string> m_extraInfoNames;
+    /** Vector of extra info keys corresponding to m_extraInfoNames, see ParticleExtraInfoMap::getKey() */
+    std::vector<int> m_extraInfoKeys;
 
     /** DecayString specifying the daughter Particle to which the extra-info field will be added */
     std::string m_decayString;
@@ -8,6 +8,8 @@
 
 #include <analysis/modules/VariablesToExtraInfo/VariablesToExtraInfoModule.h>
 
+#include <analysis/dataobjects/ParticleExtraInfoMap.h>
+
 #include <framework/logging/Logger.h>
 #include <framework/core/ModuleParam.templateDetails.h>
 
@@ -49,6 +51,7 @@ void VariablesToExtraInfoModule::initialize()
     } else {
       m_functions.push_back(var->function);
       m_extraInfoNames.push_back(pair.second);
+      m_extraInfoKeys.push_back(ParticleExtraInfoMap::getKey(pair.second));
     }
   }
 
@@ -89,29 +92,31 @@ void VariablesToExtraInfoModule::addExtraInfo(const Particle* source, Particle*
   const unsigned int nVars = m_functions.size();
   for (unsigned int iVar = 0; iVar < nVars; iVar++) {
     double value = std::numeric_limits<double>::quiet_NaN();
-    if (std::holds_alternative<double>(m_functions[iVar](source))) {
-      value = std::get<double>(m_functions[iVar](source));
-    } else if (std::holds_alternative<int>(m_functions[iVar](source))) {
-      value = std::get<int>(m_functions[iVar](source));
-    } else if (std::holds_alternative<bool>(m_functions[iVar](source))) {
-      value = std::get<bool>(m_functions[iVar](source));
+    const auto result = m_functions[iVar](source);
+    if (std::holds_alternative<double>(result)) {
+      value = std::get<double>(result);
+    } else if (std::holds_alternative<int>(result)) {
+      value = std::get<int>(result);
+    } else if (std::holds_alternative<bool>(result)) {
+      value = std::get<bool>(result);
     }
-    if (destination->hasExtraInfo(m_extraInfoNames[iVar])) {
-      double current = destination->getExtraInfo(m_extraInfoNames[iVar]);
+    const int key = m_extraInfoKeys[iVar];
+    if (destination->hasExtraInfo(key)) {
+      double current = destination->getExtraInfo(key);
       if (m_overwrite == -1) {
         if (value < current)
-          destination->setExtraInfo(m_extraInfoNames[iVar], value);
+          destination->setExtraInfo(key, value);
       } else if (m_overwrite == 1) {
         if (value > current)
-          destination->setExtraInfo(m_extraInfoNames[iVar], value);
+          destination->setExtraInfo(key, value);
       } else if (m_overwrite == 0) {
         B2WARNING("Extra info with given name " << m_extraInfoNames[iVar] << " already set, I won't set it again.");
       } else if (m_overwrite == 2) {
-        destination->setExtraInfo(m_extraInfoNames[iVar], value);
+        destination->setExtraInfo(key, value);
       }
 
     } else {
-      destination->addExtraInfo(m_extraInfoNames[iVar], value);
+      destination->addExtraInfo(key, value);
     }
   }
 }
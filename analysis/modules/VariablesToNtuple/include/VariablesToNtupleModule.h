@@ -9,6 +9,7 @@
 #pragma once
 
 #include <analysis/VariableManager/Manager.h>
+#include <analysis/VariableManager/BatchEvaluator.h>
 #include <analysis/dataobjects/RestOfEvent.h>
 
 #include <framework/core/Module.h>
@@ -56,6 +57,9 @@ namespace Belle2 {
     /** Create and fill FileMetaData object. */
     void fillFileMetaData();
 
+    /** Copy the values of one row of the batch evaluation to the branch addresses. */
+    void fillBranches(size_t row);
+
     /** Name of particle list with reconstructed particles. */
     std::string m_particleList;
     /** List of variables to save. Variables are taken from Variable::Manager, and are identical to those available to e.g. ParticleSelector. */
@@ -98,8 +102,14 @@ namespace Belle2 {
 
     /** Branch addresses of variables of type int (or bool) */
     std::vector<int> m_branchAddressesInt;
-    /** List of pairs of function pointers and respective data type corresponding to given variables. */
-    std::vector<std::pair<Variable::Manager::FunctionPtr, Variable::Manager::VariableDataType>> m_functions;
+    /** Registered data types of the given variables. */
+    std::vector<Variable::Manager::VariableDataType> m_variableTypes;
+    /** Evaluates all variables for the selected candidates of an event. */
+    std::unique_ptr<Variable::BatchEvaluator> m_evaluator;
+    /** Candidates of the current event which are written out. */
+    std::vector<const Particle*> m_selectedParticles;
+    /** Index in the particle list and weight of the candidates which are written out. */
+    std::vector<std::pair<int, float>> m_selectedCandidates;
 
     /** Tuple of variable name and a map of integer values and inverse sampling rate. E.g. (signal, {1: 0, 0:10}) selects all signal candidates and every 10th background candidate. */
     std::tuple<std::string, std::map<int, unsigned int>> m_sampling;
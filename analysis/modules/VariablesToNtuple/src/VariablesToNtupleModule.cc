@@ -202,6 +202,7 @@ void VariablesToNtupleModule::initialize()
     m_tree->get().Branch("__weight__", &m_branchAddressesDouble[0], "__weight__/D");
   }
   size_t enumerate = 1;
+  std::vector<const Variable::Manager::Var*> variables;
   for (const string& varStr : m_variables) {
     string branchName = MakeROOTCompatible::makeROOTCompatible(varStr);
 
@@ -232,10 +233,12 @@ void VariablesToNtupleModule::initialize()
       } else if (var->variabletype == Variable::Manager::VariableDataType::c_bool) {
         m_tree->get().Branch(branchName.c_str(), &m_branchAddressesInt[enumerate], (branchName + "/O").c_str());
       }
-      m_functions.push_back(std::make_pair(var->function, var->variabletype));
+      variables.push_back(var);
+      m_variableTypes.push_back(var->variabletype);
     }
     enumerate++;
   }
+  m_evaluator = std::make_unique<Variable::BatchEvaluator>(variables);
   m_tree->get().SetBasketSize("*", m_basketsize);
 
   m_sampling_name = std::get<0>(m_sampling);
@@ -339,80 +342,67 @@ void VariablesToNtupleModule::event()
     }
   }
 
+  // the sampling counters depend on the order of the candidates, so all weights are determined before the variables
+  m_selectedParticles.clear();
+  m_selectedCandidates.clear();
   if (m_particleList.empty()) {
-    double weight = getInverseSamplingRateWeight(nullptr);
-    if (m_useFloat) {
-      m_branchAddressesFloat[0] = weight;
-    } else {
-      m_branchAddressesDouble[0] = weight;
-    }
+    const float weight = getInverseSamplingRateWeight(nullptr);
     if (weight > 0) {
-      for (unsigned int iVar = 0; iVar < m_variables.size(); iVar++) {
-        auto var_result = std::get<0>(m_functions[iVar])(nullptr);
-        auto var_type = std::get<1>(m_functions[iVar]);
-        if (std::holds_alternative<double>(var_result)) {
-          if (var_type != Variable::Manager::VariableDataType::c_double)
-            B2WARNING("Wrong registered data type for variable '" + m_variables[iVar] +
-                      "'. Expected Variable::Manager::VariableDataType::c_double. Exported data for this variable might be incorrect.");
-          if (m_useFloat) {
-            m_branchAddressesFloat[iVar + 1] = std::get<double>(var_result);
-          } else {
-            m_branchAddressesDouble[iVar + 1] = std::get<double>(var_result);
-          }
-        } else if (std::holds_alternative<int>(var_result)) {
-          if (var_type != Variable::Manager::VariableDataType::c_int)
-            B2WARNING("Wrong registered data type for variable '" + m_variables[iVar] +
-                      "'. Expected Variable::Manager::VariableDataType::c_int. Exported data for this variable might be incorrect.");
-          m_branchAddressesInt[iVar + 1] = std::get<int>(var_result);
-        } else if (std::holds_alternative<bool>(var_result)) {
-          if (var_type != Variable::Manager::VariableDataType::c_bool)
-            B2WARNING("Wrong registered data type for variable '" + m_variables[iVar] +
-                      "'. Expected Variable::Manager::VariableDataType::c_bool. Exported data for this variable might be incorrect.");
-          m_branchAddressesInt[iVar + 1] = std::get<bool>(var_result);
-        }
-      }
-      m_tree->get().Fill();
+      m_selectedParticles.push_back(nullptr);
+      m_selectedCandidates.emplace_back(-1, weight);
     }
-
   } else {
     StoreObjPtr<ParticleList> particlelist(m_particleList);
     m_ncandidates = particlelist->getListSize();
     for (unsigned int iPart = 0; iPart < m_ncandidates; iPart++) {
-      m_candidate = iPart;
       const Particle* particle = particlelist->getParticle(iPart);
-      double weight = getInverseSamplingRateWeight(particle);
+      const float weight = getInverseSamplingRateWeight(particle);
+      if (weight > 0) {
+        m_selectedParticles.push_back(particle);
+        m_selectedCandidates.emplace_back(iPart, weight);
+      }
+    }
+  }
+
+  m_evaluator->evaluate(m_selectedParticles);
+  for (size_t row = 0; row < m_selectedCandidates.size(); ++row) {
+    const auto& [candidate, weight] = m_selectedCandidates[row];
+    if (not m_particleList.empty())
+      m_candidate = candidate;
+    if (m_useFloat) {
+      m_branchAddressesFloat[0] = weight;
+    } else {
+      m_branchAddressesDouble[0] = weight;
+    }
+    fillBranches(row);
+    m_tree->get().Fill();
+  }
+}
+
+void VariablesToNtupleModule::fillBranches(size_t row)
+{
+  for (unsigned int iVar = 0; iVar < m_evaluator->getNumberOfColumns(); iVar++) {
+    const auto& var_result = m_evaluator->getValue(iVar, row);
+    auto var_type = m_variableTypes[iVar];
+    if (std::holds_alternative<double>(var_result)) {
+      if (var_type != Variable::Manager::VariableDataType::c_double)
+        B2WARNING("Wrong registered data type for variable '" + m_variables[iVar] +
+                  "'. Expected Variable::Manager::VariableDataType::c_double. Exported data for this variable might be incorrect.");
       if (m_useFloat) {
-        m_branchAddressesFloat[0] = weight;
+        m_branchAddressesFloat[iVar + 1] = std::get<double>(var_result);
       } else {
-        m_branchAddressesDouble[0] = weight;
-      }
-      if (weight > 0) {
-        for (unsigned int iVar = 0; iVar < m_variables.size(); iVar++) {
-          auto var_result = std::get<0>(m_functions[iVar])(particle);
-          auto var_type = std::get<1>(m_functions[iVar]);
-          if (std::holds_alternative<double>(var_result)) {
-            if (var_type != Variable::Manager::VariableDataType::c_double)
-              B2WARNING("Wrong registered data type for variable '" + m_variables[iVar] +
-                        "'. Expected Variable::Manager::VariableDataType::c_double. Exported data for this variable might be incorrect.");
-            if (m_useFloat) {
-              m_branchAddressesFloat[iVar + 1] = std::get<double>(var_result);
-            } else {
-              m_branchAddressesDouble[iVar + 1] = std::get<double>(var_result);
-            }
-          } else if (std::holds_alternative<int>(var_result)) {
-            if (var_type != Variable::Manager::VariableDataType::c_int)
-              B2WARNING("Wrong registered data type for variable '" + m_variables[iVar] +
-                        "'. Expected Variable::Manager::VariableDataType::c_int. Exported data for this variable might be incorrect.");
-            m_branchAddressesInt[iVar + 1] = std::get<int>(var_result);
-          } else if (std::holds_alternative<bool>(var_result)) {
-            if (var_type != Variable::Manager::VariableDataType::c_bool)
-              B2WARNING("Wrong registered data type for variable '" + m_variables[iVar] +
-                        "'. Expected Variable::Manager::VariableDataType::c_bool. Exported data for this variable might be incorrect.");
-            m_branchAddressesInt[iVar + 1] = std::get<bool>(var_result);
-          }
-        }
-        m_tree->get().Fill();
+        m_branchAddressesDouble[iVar + 1] = std::get<double>(var_result);
       }
+    } else if (std::holds_alternative<int>(var_result)) {
+      if (var_type != Variable::Manager::VariableDataType::c_int)
+        B2WARNING("Wrong registered data type for variable '" + m_variables[iVar] +
+                  "'. Expected Variable::Manager::VariableDataType::c_int. Exported data for this variable might be incorrect.");
+      m_branchAddressesInt[iVar + 1] = std::get<int>(var_result);
+    } else if (std::holds_alternative<bool>(var_result)) {
+      if (var_type != Variable::Manager::VariableDataType::c_bool)
+        B2WARNING("Wrong registered data type for variable '" + m_variables[iVar] +
+                  "'. Expected Variable::Manager::VariableDataType::c_bool. Exported data for this variable might be incorrect.");
+      m_branchAddressesInt[iVar + 1] = std::get<bool>(var_result);
     }
   }
 }
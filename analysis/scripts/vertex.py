@@ -73,6 +73,7 @@ def _fitVertex(
     daughtersUpdate=False,
     smearing=0,
     path=None,
+    kfitBackend='CLHEP',
 ):
     """
     An internal function, performs the specified fit for each Particle in the given ParticleList.
@@ -94,6 +95,7 @@ def _fitVertex(
         daughtersUpdate (bool): make copy of the daughters and update them after the vertex fit
         smearing (float) :      IP tube width is smeared by this value (cm). meaningful only with 'KFit/vertex/iptube' option.
         path (basf2.Path):      modules are added to this path
+        kfitBackend (str):      matrix implementation of KFit (CLHEP or Eigen)
     """
 
     from pdg import from_names
@@ -109,6 +111,7 @@ def _fitVertex(
     pvfit.param('decayString', decay_string)
     pvfit.param('recoilMass', recoilMass)
     pvfit.param('smearing', smearing)
+    pvfit.param('kfitBackend', kfitBackend)
     if massConstraint:
         pvfit.param('massConstraintList', from_names(massConstraint))
     path.add_module(pvfit)
@@ -123,7 +126,8 @@ def kFit(list_name,
          massConstraint=[],
          recoilMass=0,
          smearing=0,
-         path=None):
+         path=None,
+         backend='CLHEP'):
     """
     Perform KFit for each Particle in the given ParticleList.
 
@@ -149,11 +153,14 @@ def kFit(list_name,
         decay_string (str):     select particles used for the KFit
         smearing (float) :      IP tube width is smeared by this value (cm). meaningful only with 'iptube' constraint.
         path (basf2.Path):      modules are added to this path
+        backend (str):          matrix implementation, ``CLHEP`` or ``Eigen``. ``Eigen`` is used for vertex fits
+            of 2 to 4 tracks without ``ipprofile`` constraint and for ``mass``, ``fourC``, ``massfourC`` and
+            ``recoilmass`` fits, the results are the same.
     """
 
     _fitVertex(
         list_name, conf_level, decay_string, 'KFit', fit_type, constraint,
-        massConstraint, recoilMass, daughtersUpdate, smearing, path)
+        massConstraint, recoilMass, daughtersUpdate, smearing, path, backend)
 
 
 def raveFit(
@@ -0,0 +1,144 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#pragma once
+
+#include <Eigen/Core>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <vector>
+
+#include "analysis/VertexFitting/TreeFitter/BatchKalmanCalculator.h"
+#include "analysis/VertexFitting/TreeFitter/FitParams.h"
+#include "analysis/VertexFitting/TreeFitter/KalmanCalculator.h"
+
+namespace {
+
+  /** Test fixture. */
+  class TreeFitterBatchKalmanCalculatorTest : public ::testing::Test {
+  protected:
+    /** random fit parameters with a positive definite covariance, only its lower triangle is set */
+    static TreeFitter::FitParams randomFitParams(int sizeState)
+    {
+      const Eigen::MatrixXd A = Eigen::MatrixXd::Random(sizeState, sizeState);
+      const Eigen::MatrixXd C = A * A.transpose() + Eigen::MatrixXd::Identity(sizeState, sizeState);
+      TreeFitter::FitParams fitParams(sizeState);
+      fitParams.getStateVector() = Eigen::VectorXd::Random(sizeState);
+      fitParams.getCovariance() = C.triangularView<Eigen::Lower>();
+      return fitParams;
+    }
+
+    /** random projection matrix which only depends on a few parameters like the ones of the constraints */
+    static Eigen::MatrixXd randomG(int sizeRes, int sizeState)
+    {
+      Eigen::MatrixXd G = Eigen::MatrixXd::Zero(sizeRes, sizeState);
+      for (int col = 0; col < sizeState; col += 3) {
+        G.col(col) = Eigen::VectorXd::Random(sizeRes);
+      }
+      return G;
+    }
+  };
+
+  /** Filtering a batch gives the same result as filtering each candidate with the KalmanCalculator. */
+  TEST_F(TreeFitterBatchKalmanCalculatorTest, SameAsKalmanCalculator)
+  {
+    std::srand(42);
+    const int nCandidates = 5;
+    for (int sizeState : {8, 20, 50}) {
+      std::vector<TreeFitter::FitParams> reference, single;
+      TreeFitter::BatchKalmanCalculator batch(sizeState, nCandidates);
+      for (int i = 0; i < nCandidates; ++i) {
+        reference.push_back(randomFitParams(sizeState));
+        single.push_back(reference.back());
+        single.back().getStateVector() += 0.1 * Eigen::VectorXd::Random(sizeState);
+        batch.setState(i, single.back());
+      }
+
+      for (int sizeRes : {3, 1, 7, 2}) {
+        const bool withV = sizeRes != 1;
+        batch.beginConstraint(sizeRes);
+        std::vector<double> chiSquare;
+        for (int i = 0; i < nCandidates; ++i) {
+          const Eigen::Matrix < double, -1, 1, 0, 7, 1 > residuals = Eigen::VectorXd::Random(sizeRes);
+          const Eigen::Matrix < double, -1, -1, 0, 7, MAX_MATRIX_SIZE > G = randomG(sizeRes, sizeState);
+          const Eigen::MatrixXd B = Eigen::MatrixXd::Random(sizeRes, sizeRes);
+          const Eigen::Matrix < double, -1, -1, 0, 7, 7 > V = withV ?
+                                                              Eigen::MatrixXd(B * B.transpose() + Eigen::MatrixXd::Identity(sizeRes, sizeRes)) :
+                                                              Eigen::MatrixXd::Zero(sizeRes, sizeRes);
+          batch.setProjection(i, residuals, G, V, reference[i], TreeFitter::ErrCode());
+
+          // see Constraint::filterWithReference()
+          const Eigen::Matrix < double, -1, 1, 0, 7, 1 > correctedResiduals =
+            residuals + G * (single[i].getStateVector() - reference[i].getStateVector());
+          TreeFitter::KalmanCalculator kalman(sizeRes, sizeState);
+          ASSERT_FALSE(kalman.calculateGainMatrix(correctedResiduals, G, single[i], &V, 1).failure());
+          kalman.updateState(single[i]);
+          kalman.updateCovariance(single[i]);
+          chiSquare.push_back(kalman.getChiSquare());
+        }
+        batch.filter();
+        for (int i = 0; i < nCandidates; ++i) {
+          EXPECT_FALSE(batch.getErrCode(i).failure());
+          EXPECT_NEAR(batch.getChiSquare(i), chiSquare[i], 1e-9 * chiSquare[i]) << "constraint size " << sizeRes;
+        }
+      }
+
+      for (int i = 0; i < nCandidates; ++i) {
+        TreeFitter::FitParams result(sizeState);
+        batch.getState(i, result);
+        const Eigen::MatrixXd expected = single[i].getCovariance().triangularView<Eigen::Lower>();
+        const Eigen::MatrixXd updated = result.getCovariance().triangularView<Eigen::Lower>();
+        EXPECT_LT((updated - expected).norm(), 1e-12 * expected.norm()) << "state size " << sizeState;
+        EXPECT_LT((result.getStateVector() - single[i].getStateVector()).norm(), 1e-12 * single[i].getStateVector().norm())
+            << "state size " << sizeState;
+      }
+    }
+  }
+
+  /** A candidate whose residual covariance can't be inverted fails without changing its state or the other candidates. */
+  TEST_F(TreeFitterBatchKalmanCalculatorTest, FailedInversionAndRemove)
+  {
+    std::srand(42);
+    const int sizeState = 10;
+    const int sizeRes = 2;
+    std::vector<TreeFitter::FitParams> fitParams;
+    TreeFitter::BatchKalmanCalculator batch(sizeState, 3);
+    for (int i = 0; i < 3; ++i) {
+      fitParams.push_back(randomFitParams(sizeState));
+      batch.setState(i, fitParams.back());
+    }
+
+    batch.beginConstraint(sizeRes);
+    const Eigen::Matrix < double, -1, 1, 0, 7, 1 > residuals = Eigen::VectorXd::Random(sizeRes);
+    const Eigen::Matrix < double, -1, -1, 0, 7, 7 > V = Eigen::MatrixXd::Zero(sizeRes, sizeRes);
+    const Eigen::Matrix < double, -1, -1, 0, 7, MAX_MATRIX_SIZE > G = randomG(sizeRes, sizeState);
+    const Eigen::Matrix < double, -1, -1, 0, 7, MAX_MATRIX_SIZE > zeroG = Eigen::MatrixXd::Zero(sizeRes, sizeState);
+    batch.setProjection(0, residuals, G, V, fitParams[0], TreeFitter::ErrCode());
+    batch.setProjection(1, residuals, zeroG, V, fitParams[1], TreeFitter::ErrCode());
+    batch.setProjection(2, residuals, G, V, fitParams[2], TreeFitter::ErrCode());
+    batch.filter();
+
+    EXPECT_FALSE(batch.getErrCode(0).failure());
+    EXPECT_TRUE(batch.getErrCode(1).failure());
+    EXPECT_FALSE(batch.getErrCode(2).failure());
+    EXPECT_EQ(batch.getChiSquare(1), 1e10);
+
+    TreeFitter::FitParams result(sizeState);
+    batch.getState(1, result);
+    EXPECT_EQ(result.getStateVector(), fitParams[1].getStateVector());
+
+    // the last candidate takes the place of the removed one
+    batch.getState(2, result);
+    const Eigen::VectorXd lastState = result.getStateVector();
+    batch.remove(1);
+    EXPECT_EQ(batch.size(), 2);
+    batch.getState(1, result);
+    EXPECT_EQ(result.getStateVector(), lastState);
+  }
+
+}  // namespace
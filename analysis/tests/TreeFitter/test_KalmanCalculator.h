@@ -10,6 +10,8 @@
 #include <Eigen/Core>
 #include <gtest/gtest.h>
 
+#include <cstdlib>
+
 #include "analysis/VertexFitting/TreeFitter/FitParams.h"
 #include "analysis/VertexFitting/TreeFitter/KalmanCalculator.h"
 
@@ -74,4 +76,42 @@ namespace {
 
   }
 
+  /** The covariance update with the gain matrix agrees with the previous form C - C G^t R^-1 G C. */
+  TEST_F(TreeFitterKalmanCalculatorTest, CovarianceUpdate)
+  {
+    std::srand(42);
+    for (int sizeState : {8, 20, 50}) {
+      for (int sizeRes = 1; sizeRes <= 7; ++sizeRes) {
+        for (bool withV : {false, true}) {
+          // positive definite covariance, only its lower triangle is used
+          const Eigen::MatrixXd A = Eigen::MatrixXd::Random(sizeState, sizeState);
+          const Eigen::MatrixXd C = A * A.transpose() + Eigen::MatrixXd::Identity(sizeState, sizeState);
+          const Eigen::MatrixXd G = Eigen::MatrixXd::Random(sizeRes, sizeState);
+          const Eigen::MatrixXd B = Eigen::MatrixXd::Random(sizeRes, sizeRes);
+          const Eigen::MatrixXd V = B * B.transpose() + Eigen::MatrixXd::Identity(sizeRes, sizeRes);
+          const double weight = 0.5;
+
+          TreeFitter::FitParams fitParams(sizeState);
+          fitParams.getStateVector().setZero();
+          fitParams.getCovariance() = C.triangularView<Eigen::Lower>();
+
+          TreeFitter::KalmanCalculator kalman(sizeRes, sizeState);
+          const Eigen::Matrix < double, -1, 1, 0, 7, 1 > residuals = Eigen::VectorXd::Random(sizeRes);
+          const Eigen::Matrix < double, -1, -1, 0, 7, MAX_MATRIX_SIZE > constraintG = G;
+          const Eigen::Matrix < double, -1, -1, 0, 7, 7 > constraintV = V;
+          ASSERT_FALSE(kalman.calculateGainMatrix(residuals, constraintG, fitParams, withV ? &constraintV : nullptr,
+                                                  withV ? weight : 0).failure());
+          kalman.updateCovariance(fitParams);
+          const Eigen::MatrixXd updated = fitParams.getCovariance().selfadjointView<Eigen::Lower>();
+
+          const Eigen::MatrixXd R = G * C * G.transpose() + (withV ? Eigen::MatrixXd(weight * V) : Eigen::MatrixXd::Zero(sizeRes,
+                                    sizeRes));
+          const Eigen::MatrixXd expected = C - C * G.transpose() * R.inverse() * G * C;
+          EXPECT_LT((updated - expected).norm(), 1e-12 * C.norm())
+              << "state size " << sizeState << ", constraint size " << sizeRes << (withV ? " with V" : "");
+        }
+      }
+    }
+  }
+
 }  // namespace
@@ -13,17 +13,25 @@
 #include <analysis/dataobjects/ParticleList.h>
 
 #include <analysis/DecayDescriptor/DecayDescriptor.h>
+#include <analysis/VariableManager/Utility.h>
 #include <analysis/utility/EvtPDLUtil.h>
 
 #include <framework/datastore/StoreArray.h>
 #include <framework/datastore/StoreObjPtr.h>
 #include <framework/gearbox/Const.h>
+#include <framework/logging/Logger.h>
 
 #include <utility>
 #include <algorithm>
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <random>
 #include <set>
+#include <unordered_set>
+
+#include <boost/functional/hash.hpp>
 
 #include <Math/Vector4D.h>
 
@@ -220,6 +228,25 @@ namespace {
 
     }
 
+    {
+      ParticleIndexGenerator particleIndexGenerator;
+      particleIndexGenerator.init(std::vector<unsigned int>({2, 4, 3}));
+      EXPECT_TRUE(particleIndexGenerator.loadNext());
+      EXPECT_TRUE(particleIndexGenerator.loadNext());
+      EXPECT_TRUE(particleIndexGenerator.loadNext());
+      EXPECT_EQ(std::vector<unsigned int>({0, 1, 0}), particleIndexGenerator.getCurrentIndices());
+      particleIndexGenerator.skipInnerLists(1);
+      EXPECT_TRUE(particleIndexGenerator.loadNext());
+      EXPECT_EQ(std::vector<unsigned int>({0, 2, 0}), particleIndexGenerator.getCurrentIndices());
+      particleIndexGenerator.skipInnerLists(2);
+      EXPECT_TRUE(particleIndexGenerator.loadNext());
+      EXPECT_EQ(std::vector<unsigned int>({0, 0, 1}), particleIndexGenerator.getCurrentIndices());
+      EXPECT_TRUE(particleIndexGenerator.loadNext());
+      EXPECT_EQ(std::vector<unsigned int>({1, 0, 1}), particleIndexGenerator.getCurrentIndices());
+      particleIndexGenerator.skipInnerLists(3);
+      EXPECT_FALSE(particleIndexGenerator.loadNext());
+    }
+
   }
 
 
@@ -271,20 +298,20 @@ namespace {
       }
     }
 
-    void addParticle(unsigned int mdstSource)
+    void addParticle(unsigned int mdstSource, const ROOT::Math::PxPyPzEVector& momentum = ROOT::Math::PxPyPzEVector())
     {
       StoreObjPtr<ParticleList> list(listName);
       StoreArray<Particle> particles;
-      Particle* part = particles.appendNew(ROOT::Math::PxPyPzEVector(), pdgCode,
+      Particle* part = particles.appendNew(momentum, pdgCode,
                                            isSelfConjugatedParticle ? Particle::c_Unflavored : Particle::c_Flavored, Particle::c_MCParticle, mdstSource);
       list->addParticle(part);
     }
 
-    void addAntiParticle(unsigned int mdstSource)
+    void addAntiParticle(unsigned int mdstSource, const ROOT::Math::PxPyPzEVector& momentum = ROOT::Math::PxPyPzEVector())
     {
       StoreObjPtr<ParticleList> list(antiListName);
       StoreArray<Particle> particles;
-      Particle* part = particles.appendNew(ROOT::Math::PxPyPzEVector(), -pdgCode,
+      Particle* part = particles.appendNew(momentum, -pdgCode,
                                            isSelfConjugatedParticle ? Particle::c_Unflavored : Particle::c_Flavored, Particle::c_MCParticle, mdstSource);
       list->addParticle(part);
     }
@@ -1684,4 +1711,197 @@ namespace {
     EXPECT_EQ(6, aB0_4->getNParticlesOfType(ParticleList::c_SelfConjugatedParticle));
 
   }
+
+  /** The kinematic pre-cuts and the skipped blocks of combinations do not change the generated particles. */
+  TEST_F(ParticleCombinerTest, KinematicPreCuts)
+  {
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<double> component(-1.5, 1.5);
+    auto randomMomentum = [&](double mass) {
+      const double px = component(generator), py = component(generator), pz = component(generator);
+      return ROOT::Math::PxPyPzEVector(px, py, pz, std::sqrt(px * px + py * py + pz * pz + mass * mass));
+    };
+
+    TestParticleList K("K+");
+    TestParticleList pi("pi+");
+    TestParticleList gamma("gamma");
+    for (int i = 0; i < 8; ++i) {
+      K.addParticle(1 + 2 * i, randomMomentum(0.494));
+      K.addAntiParticle(2 + 2 * i, randomMomentum(0.494));
+    }
+    for (int i = 0; i < 20; ++i) {
+      if (i % 2) pi.addParticle(100 + i, randomMomentum(0.140));
+      else pi.addAntiParticle(100 + i, randomMomentum(0.140));
+      gamma.addParticle(200 + i, randomMomentum(0));
+    }
+
+    // D0 candidates used as daughters of D*0
+    TestParticleList D0("D0:pre -> K- pi+");
+    StoreArray<Particle> particles;
+    StoreObjPtr<ParticleList> d0List("D0:pre");
+    ParticleGenerator d0Combiner("D0:pre -> K- pi+", "1.7 < M < 2.0");
+    d0Combiner.init();
+    while (d0Combiner.loadNext()) d0List->addParticle(particles.appendNew(d0Combiner.getCurrentParticle()));
+    EXPECT_GT(d0List->getListSize(), 0u);
+
+    const std::vector<std::pair<std::string, std::string>> decays = {
+      {"D0:pre -> K- pi+", "1.7 < M < 2.0"},
+      {"D0:pre -> K- pi+", "p > 2.5 and InvM < 2.5"},
+      {"D+:pre -> K- pi+ pi+", "M < 0.7"},
+      {"D+:pre -> K- pi+ pi+", "1.5 < M < 2.2 and 3 <= p"},
+      {"D*0:pre -> D0:pre gamma", "[M < 2.1 or p > 1] and p > 1.5"},
+      {"B0:pre -> K+ pi- gamma gamma", "M < 1.6 and p > 3.5"},
+    };
+    for (const auto& [decayString, cutString] : decays) {
+      // reference: all combinations checked with the cut afterwards
+      std::unique_ptr<Variable::Cut> cut = Variable::Cut::compile(cutString);
+      std::vector<std::vector<int>> expected;
+      ParticleGenerator all(decayString);
+      all.init();
+      while (all.loadNext()) {
+        const Particle particle = all.getCurrentParticle();
+        if (cut->check(&particle)) expected.push_back(particle.getDaughterIndices());
+      }
+
+      std::vector<std::vector<int>> generated;
+      ParticleGenerator combiner(decayString, cutString);
+      combiner.init();
+      while (combiner.loadNext()) generated.push_back(combiner.getCurrentParticle().getDaughterIndices());
+      EXPECT_EQ(expected, generated) << decayString << " with cut " << cutString;
+    }
+  }
+
+  /** Decays of 2 to 5 bodies of the lists created by fillCollidingLists(). */
+  const char* const c_collidingDecays[] = {"D0:b2 -> K- pi+:a", "D+:b3 -> K- pi+:a pi+:b", "D0:b4 -> K- pi+:a pi+:b pi-:a",
+                                           "D+:b5 -> K- pi+:a pi+:b pi+:a pi-:b"
+                                          };
+
+  /** Fill K+, pi+:a and pi+:b, where pi+:b contains copies of half of the particles in pi+:a, so the lists collide. */
+  void fillCollidingLists(int nPions)
+  {
+    TestParticleList K("K+");
+    TestParticleList piA("pi+:a");
+    TestParticleList piB("pi+:b");
+    for (int i = 0; i < 4; ++i) {
+      K.addParticle(1 + 2 * i);
+      K.addAntiParticle(2 + 2 * i);
+    }
+    for (int i = 0; i < nPions; ++i) {
+      if (i % 2) piA.addParticle(100 + i);
+      else piA.addAntiParticle(100 + i);
+      if (i % 4 < 2) {
+        if (i % 2) piB.addParticle(100 + i);
+        else piB.addAntiParticle(100 + i);
+      }
+    }
+  }
+
+  /** Colliding lists give every combination of different input particles exactly once, compared to a brute force enumeration. */
+  TEST_F(ParticleCombinerTest, CollidingListsBruteForce)
+  {
+    // particles in none of the input lists, the map of unique IDs does not have to cover them
+    StoreArray<Particle> particles;
+    for (int i = 0; i < 5; ++i)
+      particles.appendNew();
+
+    fillCollidingLists(16);
+
+    for (const char* decayString : c_collidingDecays) {
+      DecayDescriptor decay;
+      decay.init(decayString);
+      const int nDaughters = decay.getNDaughters();
+
+      // all combinations of the particles and of the anti-particles with different mdst sources, identified by the set of sources
+      std::set<std::set<int>> expected;
+      for (bool anti : {false, true}) {
+        std::vector<std::vector<int>> inputs;
+        for (int k = 0; k < nDaughters; ++k) {
+          StoreObjPtr<ParticleList> list(decay.getDaughter(k)->getMother()->getFullName());
+          inputs.push_back(list->getList(ParticleList::c_FlavorSpecificParticle, anti));
+        }
+        std::vector<size_t> position(nDaughters, 0);
+        for (bool done = false; not done;) {
+          std::set<int> sources;
+          for (int k = 0; k < nDaughters; ++k)
+            sources.insert(particles[inputs[k][position[k]]]->getMdstSource());
+          if ((int)sources.size() == nDaughters)
+            expected.insert(sources);
+          int k = 0;
+          while (k < nDaughters and ++position[k] == inputs[k].size())
+            position[k++] = 0;
+          done = k == nDaughters;
+        }
+      }
+
+      std::set<std::set<int>> combined;
+      ParticleGenerator generator(decayString);
+      generator.init();
+      while (generator.loadNext()) {
+        std::set<int> sources;
+        for (int index : generator.getCurrentParticle().getDaughterIndices())
+          sources.insert(particles[index]->getMdstSource());
+        EXPECT_EQ(nDaughters, (int)sources.size()) << decayString;
+        EXPECT_TRUE(combined.insert(sources).second) << decayString << ": combination found twice";
+      }
+      EXPECT_FALSE(expected.empty());
+      EXPECT_EQ(expected, combined) << decayString;
+
+      if (nDaughters > 2) {
+        EXPECT_EQ(-1, generator.getUniqueID(0));
+        EXPECT_EQ(-1, generator.getUniqueID(particles.getEntries()));
+        // copies share their unique ID
+        const std::vector<int>& a = StoreObjPtr<ParticleList>("pi+:a")->getList(ParticleList::c_FlavorSpecificParticle);
+        const std::vector<int>& b = StoreObjPtr<ParticleList>("pi+:b")->getList(ParticleList::c_FlavorSpecificParticle);
+        EXPECT_EQ(generator.getUniqueID(a[0]), generator.getUniqueID(b[0]));
+        EXPECT_NE(generator.getUniqueID(a[0]), generator.getUniqueID(a[1]));
+      }
+    }
+  }
+
+  /** Time the combiner for 2 to 5 body decays of colliding lists and the std::unordered_set based uniqueness check it replaced.
+   *
+   * Only informational, so it is disabled by default. Run it with --gtest_also_run_disabled_tests.
+   */
+  TEST_F(ParticleCombinerTest, DISABLED_Benchmark)
+  {
+    fillCollidingLists(16);
+
+    typedef std::chrono::high_resolution_clock clock;
+    StoreArray<Particle> particles;
+    for (const char* decayString : c_collidingDecays) {
+      const int nEvents = 10;
+      int nCandidates = 0;
+      std::chrono::duration<double, std::milli> time{0};
+      for (int i = 0; i < nEvents; ++i) {
+        const auto start = clock::now();
+        ParticleGenerator generator(decayString);
+        generator.init();
+        nCandidates = 0;
+        while (generator.loadNext()) ++nCandidates;
+        time += clock::now() - start;
+      }
+
+      // reference: the previous implementation kept the sets of daughters in an unordered_set
+      struct SetHash {
+        std::size_t operator()(const std::set<int>& v) const { return boost::hash_value(v); }
+      };
+      std::chrono::duration<double, std::milli> referenceTime{0};
+      for (int i = 0; i < nEvents; ++i) {
+        std::unordered_set<std::set<int>, SetHash> reference;
+        ParticleGenerator generator(decayString);
+        generator.init();
+        while (generator.loadNext()) {
+          const auto start = clock::now();
+          std::set<int> sources;
+          for (int index : generator.getCurrentParticle().getDaughterIndices())
+            sources.insert(particles[index]->getMdstSource());
+          EXPECT_TRUE(reference.insert(sources).second);
+          referenceTime += clock::now() - start;
+        }
+        EXPECT_EQ(nCandidates, (int)reference.size());
+      }
+      B2INFO(decayString << ": " << nCandidates << " candidates, combiner " << time.count() / nEvents
+             << " ms/event, std::unordered_set based uniqueness check alone " << referenceTime.count() / nEvents << " ms/event");
+    }
+  }
 }  // namespace
@@ -0,0 +1,282 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <analysis/VertexFitting/KFit/MassFitKFit.h>
+#include <analysis/VertexFitting/KFit/MassFourCFitKFit.h>
+#include <analysis/VertexFitting/KFit/MassPointingVertexFitKFit.h>
+#include <analysis/VertexFitting/KFit/MassVertexFitKFit.h>
+#include <analysis/VertexFitting/KFit/VertexFitKFit.h>
+
+#include <gtest/gtest.h>
+
+#include <TRandom3.h>
+
+#include <cmath>
+
+using namespace std;
+using namespace Belle2;
+using namespace Belle2::analysis;
+using namespace CLHEP;
+
+namespace {
+
+  /** Compare two numbers with a tolerance relative to their size. */
+  void expectClose(double a, double b)
+  {
+    EXPECT_NEAR(a, b, 1e-9 * max(1., max(fabs(a), fabs(b))));
+  }
+
+  /** Compare two matrices element by element. */
+  void expectClose(const HepMatrix& a, const HepMatrix& b)
+  {
+    ASSERT_EQ(a.num_row(), b.num_row());
+    ASSERT_EQ(a.num_col(), b.num_col());
+    for (int i = 0; i < a.num_row(); i++)
+      for (int j = 0; j < a.num_col(); j++)
+        expectClose(a[i][j], b[i][j]);
+  }
+
+  /** Add nTracks tracks from a common vertex with smeared positions to both fitters and return the vertex. */
+  HepPoint3D addTracks(TRandom3& random, int nTracks, KFitBase& clhep, KFitBase& eigen)
+  {
+    const HepPoint3D vertex(random.Gaus(0, 0.1), random.Gaus(0, 0.1), random.Gaus(0, 1));
+    for (int k = 0; k < nTracks; k++) {
+      const double pt = random.Uniform(0.2, 2.);
+      const double phi = random.Uniform(0, 2 * M_PI);
+      const Hep3Vector p(pt * cos(phi), pt * sin(phi), random.Gaus(0, 1));
+      const double mass = 0.13957;
+      const HepLorentzVector p4(p, sqrt(p.mag2() + mass * mass));
+      const HepPoint3D x(vertex.x() + random.Gaus(0, 0.005), vertex.y() + random.Gaus(0, 0.005),
+                         vertex.z() + random.Gaus(0, 0.01));
+      HepSymMatrix error(KFitConst::kNumber7, 0);
+      for (int i = 0; i < 4; i++) error[i][i] = pow(0.001 * (1 + p.mag()), 2);
+      for (int i = 4; i < 7; i++) error[i][i] = pow(0.005, 2);
+      error[0][1] = 0.3 * error[0][0];
+      error[4][5] = 0.2 * error[4][4];
+      // one neutral track for the largest multiplicity
+      const double charge = k == 3 ? 0 : (k % 2 ? -1 : 1);
+      clhep.addTrack(p4, x, error, charge);
+      eigen.addTrack(p4, x, error, charge);
+    }
+    return vertex;
+  }
+
+  /** Sum of the momenta of the tracks first to last before the fit. */
+  HepLorentzVector sumMomentum(const KFitBase& fitter, int first, int last)
+  {
+    HepLorentzVector sum;
+    for (int k = first; k <= last; k++) sum += fitter.getTrack(k).getMomentum(KFitConst::kBeforeFit);
+    return sum;
+  }
+
+  /** Compare the results of the generic constraint fit common to all fitters. */
+  void expectSameTracks(const KFitBase& clhep, const KFitBase& eigen)
+  {
+    EXPECT_EQ(clhep.getNDF(), eigen.getNDF());
+    expectClose(clhep.getCHIsq(), eigen.getCHIsq());
+    for (int i = 0; i < clhep.getTrackCount(); i++) {
+      for (int j = 0; j < 4; j++)
+        expectClose(clhep.getTrackMomentum(i)[j], eigen.getTrackMomentum(i)[j]);
+      expectClose(clhep.getTrackPosition(i).x(), eigen.getTrackPosition(i).x());
+      expectClose(clhep.getTrackPosition(i).y(), eigen.getTrackPosition(i).y());
+      expectClose(clhep.getTrackPosition(i).z(), eigen.getTrackPosition(i).z());
+      expectClose(clhep.getTrackError(i), eigen.getTrackError(i));
+    }
+  }
+
+  /** The vertex fit gives the same result with the CLHEP and the Eigen matrices. */
+  TEST(KFitTest, VertexFitEigenBackend)
+  {
+    TRandom3 random(42);
+    for (int nTracks = 2; nTracks <= 5; nTracks++) {
+      for (int iFit = 0; iFit < 20; iFit++) {
+        VertexFitKFit clhep, eigen;
+        clhep.setMagneticField(1.5);
+        eigen.setMagneticField(1.5);
+        eigen.setEigenBackend();
+        addTracks(random, nTracks, clhep, eigen);
+
+        const enum KFitError::ECode clhepError = clhep.doFit();
+        const enum KFitError::ECode eigenError = eigen.doFit();
+        ASSERT_EQ(clhepError, eigenError);
+        if (clhepError != KFitError::kNoError) continue;
+
+        EXPECT_EQ(clhep.getNDF(), eigen.getNDF());
+        expectClose(clhep.getCHIsq(), eigen.getCHIsq());
+        expectClose(clhep.getVertex().x(), eigen.getVertex().x());
+        expectClose(clhep.getVertex().y(), eigen.getVertex().y());
+        expectClose(clhep.getVertex().z(), eigen.getVertex().z());
+        expectClose(clhep.getVertexError(), eigen.getVertexError());
+        for (int i = 0; i < nTracks; i++) {
+          expectClose(clhep.getTrackCHIsq(i), eigen.getTrackCHIsq(i));
+          for (int j = 0; j < 4; j++)
+            expectClose(clhep.getTrackMomentum(i)[j], eigen.getTrackMomentum(i)[j]);
+          expectClose(clhep.getTrackError(i), eigen.getTrackError(i));
+          expectClose(clhep.getTrackVertexError(i), eigen.getTrackVertexError(i));
+          for (int j = i + 1; j < nTracks; j++)
+            expectClose(clhep.getCorrelation(i, j), eigen.getCorrelation(i, j));
+        }
+      }
+    }
+  }
+
+  /** The mass-constraint fit gives the same result with the CLHEP and the Eigen matrices. */
+  TEST(KFitTest, MassFitEigenBackend)
+  {
+    TRandom3 random(43);
+    for (int nTracks = 2; nTracks <= 4; nTracks++) {
+      for (int iFit = 0; iFit < 20; iFit++) {
+        MassFitKFit clhep, eigen;
+        clhep.setMagneticField(1.5);
+        eigen.setMagneticField(1.5);
+        eigen.setEigenBackend();
+        const HepPoint3D vertex = addTracks(random, nTracks, clhep, eigen);
+        // alternate between the fit at the decay point with a vertex error and the one at the track positions
+        const bool atDecayPoint = iFit % 2;
+        const double mass = sumMomentum(clhep, 0, nTracks - 1).m() + random.Gaus(0, 0.01);
+        for (MassFitKFit* fitter : {&clhep, &eigen}) {
+          fitter->setInvariantMass(mass);
+          fitter->setFlagAtDecayPoint(atDecayPoint);
+          if (atDecayPoint) {
+            fitter->setVertex(vertex);
+            fitter->setVertexError(HepSymMatrix(3, 1) * 1e-4);
+          }
+        }
+
+        const enum KFitError::ECode clhepError = clhep.doFit();
+        const enum KFitError::ECode eigenError = eigen.doFit();
+        ASSERT_EQ(clhepError, eigenError);
+        if (clhepError != KFitError::kNoError) continue;
+
+        expectSameTracks(clhep, eigen);
+        expectClose(clhep.getInvariantMass(), eigen.getInvariantMass());
+        if (atDecayPoint) {
+          expectClose(clhep.getVertexError(), eigen.getVertexError());
+          for (int i = 0; i < nTracks; i++)
+            expectClose(clhep.getTrackVertexError(i), eigen.getTrackVertexError(i));
+        }
+        for (int i = 0; i < nTracks; i++)
+          for (int j = i + 1; j < nTracks; j++)
+            expectClose(clhep.getCorrelation(i, j), eigen.getCorrelation(i, j));
+      }
+    }
+  }
+
+  /** The four-momentum fit with a daughter mass constraint gives the same result with the CLHEP and the Eigen matrices. */
+  TEST(KFitTest, MassFourCFitEigenBackend)
+  {
+    TRandom3 random(44);
+    for (int nTracks = 3; nTracks <= 4; nTracks++) {
+      for (int iFit = 0; iFit < 20; iFit++) {
+        MassFourCFitKFit clhep, eigen;
+        clhep.setMagneticField(1.5);
+        eigen.setMagneticField(1.5);
+        eigen.setEigenBackend();
+        const HepPoint3D vertex = addTracks(random, nTracks, clhep, eigen);
+        const HepLorentzVector sum = sumMomentum(clhep, 0, nTracks - 1);
+        const ROOT::Math::PxPyPzEVector fourMomentum(sum.px() + random.Gaus(0, 0.005), sum.py() + random.Gaus(0, 0.005),
+                                                     sum.pz() + random.Gaus(0, 0.005), sum.e() + random.Gaus(0, 0.005));
+        const double mass = sumMomentum(clhep, 0, 1).m() + random.Gaus(0, 0.005);
+        for (MassFourCFitKFit* fitter : {&clhep, &eigen}) {
+          vector<unsigned> children = {0, 1};
+          fitter->addMassConstraint(mass, children);
+          fitter->setFourMomentum(fourMomentum);
+          fitter->setVertex(vertex);
+        }
+
+        const enum KFitError::ECode clhepError = clhep.doFit();
+        const enum KFitError::ECode eigenError = eigen.doFit();
+        ASSERT_EQ(clhepError, eigenError);
+        if (clhepError != KFitError::kNoError) continue;
+
+        expectSameTracks(clhep, eigen);
+        for (int i = 0; i < nTracks; i++)
+          for (int j = i + 1; j < nTracks; j++)
+            expectClose(clhep.getCorrelation(i, j), eigen.getCorrelation(i, j));
+      }
+    }
+  }
+
+  /** Compare the results of the mass-constrained vertex fits. */
+  template <class Fitter>
+  void expectSameVertexFit(const Fitter& clhep, const Fitter& eigen)
+  {
+    expectSameTracks(clhep, eigen);
+    expectClose(clhep.getVertex().x(), eigen.getVertex().x());
+    expectClose(clhep.getVertex().y(), eigen.getVertex().y());
+    expectClose(clhep.getVertex().z(), eigen.getVertex().z());
+    expectClose(clhep.getVertexError(), eigen.getVertexError());
+    for (int i = 0; i < clhep.getTrackCount(); i++) {
+      expectClose(clhep.getTrackVertexError(i), eigen.getTrackVertexError(i));
+      for (int j = i + 1; j < clhep.getTrackCount(); j++)
+        expectClose(clhep.getCorrelation(i, j), eigen.getCorrelation(i, j));
+    }
+  }
+
+  /** The mass-constrained vertex fit gives the same result with the CLHEP and the Eigen matrices. */
+  TEST(KFitTest, MassVertexFitEigenBackend)
+  {
+    TRandom3 random(45);
+    for (int nTracks = 2; nTracks <= 4; nTracks++) {
+      for (int iFit = 0; iFit < 20; iFit++) {
+        MassVertexFitKFit clhep, eigen;
+        clhep.setMagneticField(1.5);
+        eigen.setMagneticField(1.5);
+        eigen.setEigenBackend();
+        const HepPoint3D vertex = addTracks(random, nTracks, clhep, eigen);
+        const double mass = sumMomentum(clhep, 0, nTracks - 1).m() + random.Gaus(0, 0.01);
+        for (MassVertexFitKFit* fitter : {&clhep, &eigen}) {
+          fitter->setInvariantMass(mass);
+          fitter->setInitialVertex(vertex);
+        }
+
+        const enum KFitError::ECode clhepError = clhep.doFit();
+        const enum KFitError::ECode eigenError = eigen.doFit();
+        ASSERT_EQ(clhepError, eigenError);
+        if (clhepError != KFitError::kNoError) continue;
+
+        expectSameVertexFit(clhep, eigen);
+      }
+    }
+  }
+
+  /** The mass-constrained vertex fit pointing to the production vertex gives the same result with the CLHEP and the Eigen matrices. */
+  TEST(KFitTest, MassPointingVertexFitEigenBackend)
+  {
+    TRandom3 random(46);
+    for (int nTracks = 2; nTracks <= 4; nTracks++) {
+      for (int iFit = 0; iFit < 20; iFit++) {
+        MassPointingVertexFitKFit clhep, eigen;
+        clhep.setMagneticField(1.5);
+        eigen.setMagneticField(1.5);
+        eigen.setEigenBackend();
+        const HepPoint3D vertex = addTracks(random, nTracks, clhep, eigen);
+        const HepLorentzVector sum = sumMomentum(clhep, 0, nTracks - 1);
+        // production vertex roughly along the flight direction, behind the decay vertex
+        const double flightLength = random.Uniform(0.5, 2.);
+        const HepPoint3D productionVertex(vertex.x() - flightLength * sum.px() / sum.rho() + random.Gaus(0, 0.005),
+                                          vertex.y() - flightLength * sum.py() / sum.rho() + random.Gaus(0, 0.005),
+                                          vertex.z() - flightLength * sum.pz() / sum.rho() + random.Gaus(0, 0.01));
+        const double mass = sum.m() + random.Gaus(0, 0.01);
+        for (MassPointingVertexFitKFit* fitter : {&clhep, &eigen}) {
+          fitter->setInvariantMass(mass);
+          fitter->setInitialVertex(vertex);
+          fitter->setProductionVertex(productionVertex);
+        }
+
+        const enum KFitError::ECode clhepError = clhep.doFit();
+        const enum KFitError::ECode eigenError = eigen.doFit();
+        ASSERT_EQ(clhepError, eigenError);
+        if (clhepError != KFitError::kNoError) continue;
+
+        expectSameVertexFit(clhep, eigen);
+      }
+    }
+  }
+
+}
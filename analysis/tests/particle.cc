@@ -515,6 +515,61 @@ namespace {
     tCopy.print();
   }
 
+  /** Test access to the extra info by integer keys. */
+  TEST_F(ParticleTest, ExtraInfoKeys)
+  {
+    StoreObjPtr<ParticleExtraInfoMap> map;
+
+    const int first = ParticleExtraInfoMap::getKey("keyed_first");
+    const int second = ParticleExtraInfoMap::getKey("keyed_second");
+    EXPECT_EQ(first, ParticleExtraInfoMap::getKey("keyed_first"));
+    EXPECT_NE(first, second);
+    EXPECT_EQ("keyed_second", ParticleExtraInfoMap::getNameFromKey(second));
+
+    Particle p;
+    EXPECT_FALSE(p.hasExtraInfo(first));
+    EXPECT_THROW(p.getExtraInfo(first), std::runtime_error);
+    EXPECT_THROW(p.setExtraInfo(first, 1.0), std::runtime_error);
+
+    //values added by key can be read by name and vice versa
+    p.addExtraInfo(first, 1.0);
+    EXPECT_THROW(p.addExtraInfo(first, 1.0), std::runtime_error);
+    EXPECT_THROW(p.addExtraInfo("keyed_first", 1.0), std::runtime_error);
+    EXPECT_DOUBLE_EQ(1.0, p.getExtraInfo("keyed_first"));
+    EXPECT_FALSE(p.hasExtraInfo(second));
+    p.addExtraInfo("keyed_second", 2.0);
+    EXPECT_TRUE(p.hasExtraInfo(second));
+    EXPECT_DOUBLE_EQ(2.0, p.getExtraInfo(second));
+
+    //a key registered after the map was used is found as well
+    const int third = ParticleExtraInfoMap::getKey("keyed_third");
+    EXPECT_FALSE(p.hasExtraInfo(third));
+    p.writeExtraInfo("keyed_third", 3.0);
+    EXPECT_DOUBLE_EQ(3.0, p.getExtraInfo(third));
+    p.writeExtraInfo(third, 4.0);
+    EXPECT_DOUBLE_EQ(4.0, p.getExtraInfo("keyed_third"));
+    p.setExtraInfo(first, 5.0);
+    EXPECT_DOUBLE_EQ(5.0, p.getExtraInfo("keyed_first"));
+
+    //entries of an extended map which are not set for the particle are not found
+    Particle q;
+    q.addExtraInfo(first, 11.0);
+    EXPECT_EQ(map->getIndex(q.getExtraInfoMap(), second), map->getIndex(q.getExtraInfoMap(), "keyed_second"));
+    EXPECT_FALSE(q.hasExtraInfo(second));
+    EXPECT_FALSE(q.hasExtraInfo(third));
+
+    //switching to another map
+    q.writeExtraInfo(third, 13.0);
+    EXPECT_NE(p.getExtraInfoMap(), q.getExtraInfoMap());
+    EXPECT_FALSE(q.hasExtraInfo(second));
+    EXPECT_DOUBLE_EQ(11.0, q.getExtraInfo(first));
+    EXPECT_DOUBLE_EQ(13.0, q.getExtraInfo(third));
+    EXPECT_DOUBLE_EQ(13.0, q.getExtraInfo("keyed_third"));
+    EXPECT_DOUBLE_EQ(5.0, p.getExtraInfo(first));
+    EXPECT_DOUBLE_EQ(2.0, p.getExtraInfo(second));
+    EXPECT_DOUBLE_EQ(4.0, p.getExtraInfo(third));
+  }
+
 
   /** test ParticleCopy utility */
   TEST_F(ParticleTest, ParticleCopyUtility)
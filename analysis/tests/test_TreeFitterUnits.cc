@@ -7,5 +7,6 @@
  **************************************************************************/
 #include "TreeFitter/test_Fitparams.h"
 #include "TreeFitter/test_KalmanCalculator.h"
+#include "TreeFitter/test_BatchKalmanCalculator.h"
 #include "TreeFitter/test_HelixJacobian.h"
 // run a single test with: test_all --gtest_filter=TreeFitterKalmanCalculatorTest.Functions
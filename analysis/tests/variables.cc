@@ -13,6 +13,7 @@
 #include <analysis/variables/TrackVariables.h>
 
 #include <analysis/VariableManager/Manager.h>
+#include <analysis/VariableManager/BatchEvaluator.h>
 
 #include <analysis/dataobjects/Particle.h>
 #include <analysis/dataobjects/ParticleExtraInfoMap.h>
@@ -845,6 +846,69 @@ namespace {
 
   }
 
+  TEST_F(MetaVariableTest, batchEvaluation)
+  {
+    StoreArray<Particle> particles;
+    const Particle* kaon = particles.appendNew(Particle(PxPyPzEVector(0.1, 0.2, 0.3, 0.8), 321));
+    const Particle* pion = particles.appendNew(Particle(PxPyPzEVector(-0.2, 0.1, 0.5, 0.6), -211));
+    const Particle* dMeson = particles.appendNew(kaon->get4Vector() + pion->get4Vector(), -421, Particle::c_Flavored,
+                                                 std::vector<int> {kaon->getArrayIndex(), pion->getArrayIndex()});
+    // two B candidates sharing the same D meson
+    StoreObjPtr<ParticleList> bList("B+:batch");
+    DataStore::Instance().setInitializeActive(true);
+    bList.registerInDataStore(DataStore::c_DontWriteOut);
+    DataStore::Instance().setInitializeActive(false);
+    bList.create();
+    bList->initialize(521, "B+:batch");
+    for (double px : {0.4, -0.3}) {
+      const Particle* bachelor = particles.appendNew(Particle(PxPyPzEVector(px, 0.3, 0.2, 1.1), 211));
+      const Particle* b = particles.appendNew(dMeson->get4Vector() + bachelor->get4Vector(), 521, Particle::c_Flavored,
+                                              std::vector<int> {dMeson->getArrayIndex(), bachelor->getArrayIndex()});
+      bList->addParticle(b);
+    }
+
+    const std::vector<std::string> names = {"px", "nDaughters", "daughter(0, M)", "daughter(0, daughter(1, E))",
+                                            "daughter(0, daughter(0, charge))", "daughter(1, px)", "daughter(3, px)",
+                                            "daughter(0, daughter(0, daughter(0, px)))"
+                                           };
+    std::vector<const Manager::Var*> variables;
+    for (const auto& name : names) {
+      variables.push_back(Manager::Instance().getVariable(name));
+      ASSERT_NE(variables.back(), nullptr);
+    }
+
+    Variable::BatchEvaluator evaluator(variables);
+    // the candidate, daughter 0, 1 and 3, two daughters of daughter 0 and one of its granddaughters
+    EXPECT_EQ(evaluator.getNumberOfNodes(), 7u);
+
+    evaluator.evaluate(*bList);
+    ASSERT_EQ(evaluator.getNumberOfRows(), 2u);
+    ASSERT_EQ(evaluator.getNumberOfColumns(), names.size());
+    for (size_t row = 0; row < evaluator.getNumberOfRows(); ++row) {
+      for (size_t column = 0; column < names.size(); ++column) {
+        const Manager::VarVariant expected = variables[column]->function(bList->getParticle(row));
+        const Manager::VarVariant& value = evaluator.getValue(column, row);
+        EXPECT_EQ(value.index(), expected.index()) << names[column];
+        const double expectedValue = std::visit([](auto v) { return static_cast<double>(v); }, expected);
+        const double actualValue = std::visit([](auto v) { return static_cast<double>(v); }, value);
+        if (std::isnan(expectedValue))
+          EXPECT_TRUE(std::isnan(actualValue)) << names[column];
+        else
+          EXPECT_DOUBLE_EQ(actualValue, expectedValue) << names[column];
+      }
+    }
+    EXPECT_TRUE(std::isnan(std::get<double>(evaluator.getValue(6, 0))));
+
+    // the flattened evaluation gives the same values
+    const std::vector<double> values = Manager::Instance().evaluateVariables(names, bList.operator->());
+    ASSERT_EQ(values.size(), 2 * names.size());
+    EXPECT_DOUBLE_EQ(values[names.size() + 5], -0.3);
+
+    // evaluating nothing
+    evaluator.evaluate(std::vector<const Particle*>());
+    EXPECT_EQ(evaluator.getNumberOfRows(), 0u);
+  }
+
   TEST_F(MetaVariableTest, useRestFrame)
   {
     Gearbox& gearbox = Gearbox::getInstance();
@@ -68,8 +68,9 @@ void ParticleSubset::fixParticles(const std::map<int, int>& oldToNewMap)
 
 void ParticleSubset::fixParticleLists(const std::map<int, int>& oldToNewMap)
 {
-  const auto& entryMap = DataStore::Instance().getStoreEntryMap(DataStore::c_Event);
-  for (const auto& entry : entryMap) {
+  auto& entryMap = DataStore::Instance().getStoreEntryMap(DataStore::c_Event);
+  for (auto& entry : entryMap) {
+    entry.second.ensureLoaded();
     if (!entry.second.ptr or !entry.second.object->InheritsFrom(ParticleList::Class()))
       continue;
 
@@ -13,6 +13,7 @@
 #include <analysis/VariableManager/Utility.h>
 #include <analysis/dataobjects/Particle.h>
 #include <analysis/dataobjects/ParticleList.h>
+#include <analysis/dataobjects/ParticleExtraInfoMap.h>
 #include <analysis/utility/PCmsLabTransform.h>
 #include <analysis/utility/ReferenceFrame.h>
 #include <analysis/utility/EvtPDLUtil.h>
@@ -233,16 +234,16 @@ namespace Belle2 {
     Manager::FunctionPtr extraInfo(const std::vector<std::string>& arguments)
     {
       if (arguments.size() == 1) {
-        auto extraInfoName = arguments[0];
-        auto func = [extraInfoName](const Particle * particle) -> double {
+        const int extraInfoKey = ParticleExtraInfoMap::getKey(arguments[0]);
+        auto func = [extraInfoKey](const Particle * particle) -> double {
           if (particle == nullptr)
           {
             B2WARNING("Returns NaN because the particle is nullptr! If you want EventExtraInfo variables, please use eventExtraInfo() instead");
             return Const::doubleNaN;
           }
-          if (particle->hasExtraInfo(extraInfoName))
+          if (particle->hasExtraInfo(extraInfoKey))
           {
-            return particle->getExtraInfo(extraInfoName);
+            return particle->getExtraInfo(extraInfoKey);
           } else
           {
             return Const::doubleNaN;
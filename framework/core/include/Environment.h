@@ -158,6 +158,17 @@ namespace Belle2 {
         return m_numberProcesses;
     }
 
+    /**
+     * Sets the number of threads which should be used for multithreaded processing (within one process).
+     * If the value is set to 0, events are processed one at a time. Ignored if parallel processing is enabled.
+     */
+    void setNumberThreads(int number) { m_numberThreads = number; }
+
+    /**
+     * Returns the number of threads which should be used for multithreaded processing.
+     */
+    int getNumberThreads() const { return m_numberThreads; }
+
     /**
      * Sets the path to the file where the pickled path is stored
      *
@@ -193,6 +204,12 @@ namespace Belle2 {
 
     /** Disable collection of statistics during event processing. */
     bool getNoStats() const { return m_noStats; }
+
+    /** Collect hardware performance counters and heap allocations for each module during event processing. */
+    void setPerfStats(bool perfStats) { m_perfStats = perfStats; }
+
+    /** Collect hardware performance counters and heap allocations for each module during event processing. */
+    bool getPerfStats() const { return m_perfStats; }
     /** Read steering file, but do not start any actually start any event processing. Prints information on input/output files and number of events that that would be used during normal execution. */
     void setDryRun(bool dryRun) { m_dryRun = dryRun; }
     /** Read steering file, but do not start any actually start any event processing. Prints information on input/output files and number of events that that would be used during normal execution. */
@@ -252,6 +269,18 @@ namespace Belle2 {
       m_useZMQ = useZMQ;
     }
 
+    /// Flag if the LockFreeRingBuffer should be used instead of the semaphore protected RingBuffer
+    bool getUseLockFreeRingBuffer() const
+    {
+      return m_useLockFreeRingBuffer;
+    }
+
+    /// Set the flag if the LockFreeRingBuffer should be used instead of the semaphore protected RingBuffer
+    void setUseLockFreeRingBuffer(bool useLockFree)
+    {
+      m_useLockFreeRingBuffer = useLockFree;
+    }
+
     /// Socket address to use in ZMQ.
     const std::string& getZMQSocketAddress() const
     {
@@ -288,6 +317,30 @@ namespace Belle2 {
       m_zmqEventBufferSize = zmqEventBufferSize;
     }
 
+    /// Number of events sent in one message between the processes
+    unsigned int getZMQBatchSize() const
+    {
+      return m_zmqBatchSize;
+    }
+
+    /// Number of events sent in one message between the processes
+    void setZMQBatchSize(unsigned int zmqBatchSize)
+    {
+      m_zmqBatchSize = zmqBatchSize;
+    }
+
+    /// ROOT compression setting (algorithm * 100 + level) of the batches of events, 0 for no compression
+    int getZMQBatchCompressionLevel() const
+    {
+      return m_zmqBatchCompressionLevel;
+    }
+
+    /// ROOT compression setting (algorithm * 100 + level) of the batches of events, 0 for no compression
+    void setZMQBatchCompressionLevel(int zmqBatchCompressionLevel)
+    {
+      m_zmqBatchCompressionLevel = zmqBatchCompressionLevel;
+    }
+
     /// How long should a worker maximally need to process all of his events in the queue. Set to 0 to disable the check.
     unsigned int getZMQWorkerTimeout() const
     {
@@ -398,6 +451,7 @@ namespace Belle2 {
     int m_logLevelOverride; /**< Override global log level if != LogConfig::c_Default. */
     bool m_visualizeDataFlow; /**< Whether to generate DOT files with data store inputs/outputs of each module. */
     bool m_noStats; /**< Disable collection of statistics during event processing. Useful for very high-rate applications. */
+    bool m_perfStats; /**< Collect hardware performance counters and heap allocations for each module. */
     bool m_dryRun; /**< Read steering file, but do not start any actually start any event processing. Prints information on input/output files that that would be used during normal execution. */
     std::string m_jobInfoOutput; /**< Output for printJobInformation(), generated by setJobInformation(). */
     std::string m_profileModuleName; /**< Name of the module which should be profiled, empty if no profiling requested */
@@ -413,10 +467,14 @@ namespace Belle2 {
 
     // ZMQ specific settings
     bool m_useZMQ = false; /**< Set to true to use ZMQ instead of RingBuffer */
+    bool m_useLockFreeRingBuffer = false; /**< Set to true to use LockFreeRingBuffer instead of RingBuffer */
+    int m_numberThreads = 0; /**< The number of threads that should be used for multithreaded processing. */
     std::string m_zmqSocketAddress = ""; /**< Socket address to use in ZMQ. If not set, uses a random IPC connection. */
     unsigned int m_zmqMaximalWaitingTime = (3600 * 24) *
                                            1000; /**< Maximal waiting time of any ZMQ module for any communication in ms */
     unsigned int m_zmqEventBufferSize = 1; /**< Number of events to keep in flight for every worker */
+    unsigned int m_zmqBatchSize = 1; /**< Number of events sent in one message between the processes */
+    int m_zmqBatchCompressionLevel = 0; /**< ROOT compression setting of the batches of events, 0 for no compression */
     unsigned int m_zmqWorkerTimeout =
       0; /**< How long should a worker maximally need to process all of his events in the queue. Set to 0 to disable the check. */
     bool m_zmqUseEventBackup = true; /**< If a worker dies, store its events in a backup. */
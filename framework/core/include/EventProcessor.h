@@ -97,7 +97,7 @@ namespace Belle2 {
      * @param maxEvent The maximum number of events that will be processed. If the number is smaller or equal 0, all events are processed.
      * @param isInputProcess true when this is either the only or the input process
      */
-    void processCore(const PathPtr& startPath, const ModulePtrList& modulePathList, long maxEvent = 0, bool isInputProcess = true);
+    virtual void processCore(const PathPtr& startPath, const ModulePtrList& modulePathList, long maxEvent = 0, bool isInputProcess = true);
 
     /** Calls event() functions on all modules for the current event. Used by processCore.
      *
@@ -147,6 +147,9 @@ namespace Belle2 {
      */
     long getMaximumEventNumber(long maxEvent) const;
 
+    /** Signal received by the handler installed by installMainSignalHandlers(), 0 if there was none. */
+    static int getSignalReceived();
+
     const Module* m_master;  /**< The master module that determines the experiment/run/event number **/
     ModulePtrList m_moduleList; /**< List of all modules in order initialized. */
 
@@ -78,6 +78,7 @@ namespace Belle2 {
       c_InternalSerializer          = 16,  /**< This module is an internal serializer/deserializer for parallel processing */
       c_TerminateInAllProcesses     = 32,  /**< When using parallel processing, call this module's terminate() function in all processes(). This will also ensure that there is exactly one process (single-core if no parallel modules found) or at least one input, one main and one output process. */
       c_DontCollectStatistics       = 64,  /**< No statistics is collected for this module. */
+      c_ThreadSafe                  = 128, /**< event() can be called for several events at the same time from different threads (see ThreadedEventProcessor). The module must only use the DataStore, DBObjPtr/DBArray and RandomNumbers::getEventRandomGenerator(), and not modify its own members or other global state in event(). Python modules are always serialized. */
     };
 
     /// Forward the EAfterConditionPath definition from the ModuleCondition.
@@ -9,6 +9,8 @@
 #pragma once
 
 #include <framework/utilities/CalcMeanCov.h>
+#include <framework/utilities/PerformanceCounters.h>
+#include <map>
 #include <string>
 #include <ostream>
 
@@ -19,6 +21,9 @@ namespace Belle2 {
    * processing steps (initialize, beginRun, event, endRun, terminate and
    * total). It will automatically calculate a running mean, stddev and
    * correlation factor between time and memory consumption.
+   *
+   * If enabled, the sums of the hardware performance counters and heap
+   * allocations (see PerformanceCounters) are kept as well.
    */
   class ModuleStatistics {
   public:
@@ -56,11 +61,46 @@ namespace Belle2 {
         m_stats[c_Total].add(time, memory);
     }
 
+    /** Add time the module spent waiting for input data, e.g. for the
+     * next entry to be read from file in a background thread. This time
+     * is also included in the event() time of the module.
+     * @param time time spent waiting
+     */
+    void addStallTime(value_type time) { m_stallTime += time; }
+
+    /** Add time spent in a named part of the module, e.g. in the fits of
+     * a fitter module. This time is also included in the time of the
+     * calling method of the module.
+     * @param name name of the part of the module
+     * @param time time spent in this part
+     */
+    void addNamedTime(const std::string& name, value_type time) { m_namedTimes[name] += time; }
+
+    /** Add the change of the performance counters during one call to the counter of a given type.
+     * @param type Type of counter to add the values to
+     * @param values change of all performance counters during execution
+     */
+    void addPerformanceCounters(EStatisticCounters type, const PerformanceCounters::Values& values)
+    {
+      for (int i = 0; i < PerformanceCounters::c_NCounters; i++) {
+        m_counterSums[type][i] += values[i];
+        if (type != c_Total)
+          m_counterSums[c_Total][i] += values[i];
+      }
+    }
+
     /** Add statistics for each category. */
     void update(const ModuleStatistics& other)
     {
       for (int i = c_Init; i <= c_Total; i++) {
         m_stats[i].add(other.m_stats[i]);
+        for (int j = 0; j < PerformanceCounters::c_NCounters; j++) {
+          m_counterSums[i][j] += other.m_counterSums[i][j];
+        }
+      }
+      m_stallTime += other.m_stallTime;
+      for (const auto& namedTime : other.m_namedTimes) {
+        m_namedTimes[namedTime.first] += namedTime.second;
       }
     }
 
@@ -110,6 +150,49 @@ namespace Belle2 {
     {
       return m_stats[type].getStddev<1>();
     }
+    /** return the total time spent waiting for input data */
+    value_type getStallTimeSum() const { return m_stallTime; }
+    /** return the mean time spent waiting for input data per event() call */
+    value_type getStallTimeMean() const
+    {
+      const value_type calls = getCalls(c_Event);
+      return calls > 0 ? m_stallTime / calls : 0;
+    }
+    /** return the total time spent in a named part of the module, 0 if it was never recorded */
+    value_type getNamedTimeSum(const std::string& name) const
+    {
+      const auto it = m_namedTimes.find(name);
+      return it != m_namedTimes.end() ? it->second : 0;
+    }
+    /** return the mean time spent in a named part of the module per event() call */
+    value_type getNamedTimeMean(const std::string& name) const
+    {
+      const value_type calls = getCalls(c_Event);
+      return calls > 0 ? getNamedTimeSum(name) / calls : 0;
+    }
+    /** return the total times of all named parts of the module */
+    const std::map<std::string, value_type>& getNamedTimes() const { return m_namedTimes; }
+
+    /** return the sum of a performance counter for a given counter type */
+    value_type getPerformanceCounterSum(PerformanceCounters::ECounter counter, EStatisticCounters type = c_Total) const
+    {
+      return m_counterSums[type][counter];
+    }
+    /** return the mean of a performance counter per call for a given counter type */
+    value_type getPerformanceCounterMean(PerformanceCounters::ECounter counter, EStatisticCounters type = c_Total) const
+    {
+      const value_type calls = getCalls(type);
+      return calls > 0 ? m_counterSums[type][counter] / calls : 0;
+    }
+    /** check whether any performance counters were recorded */
+    bool hasPerformanceCounters() const
+    {
+      for (value_type sum : m_counterSums[c_Total]) {
+        if (sum != 0) return true;
+      }
+      return false;
+    }
+
     /** return the pearson correlation coefficient between execution times
      * and memory consumption changes */
     value_type getTimeMemoryCorrelation(EStatisticCounters type = c_Total) const
@@ -131,6 +214,11 @@ namespace Belle2 {
     void clear()
     {
       for (auto& stat : m_stats) stat.clear();
+      for (auto& sums : m_counterSums) {
+        for (auto& sum : sums) sum = 0;
+      }
+      m_stallTime = 0;
+      m_namedTimes.clear();
     }
   private:
     /** display index of the module */
@@ -139,6 +227,12 @@ namespace Belle2 {
     std::string m_name;
     /** array with  mean/covariance for all counters */
     CalcMeanCov<2, value_type> m_stats[c_Total + 1];
+    /** total time spent waiting for input data */
+    value_type m_stallTime{0};
+    /** total time spent in named parts of the module */
+    std::map<std::string, value_type> m_namedTimes;
+    /** sums of all performance counters for all counter types */
+    value_type m_counterSums[c_Total + 1][PerformanceCounters::c_NCounters] {};
   };
 
 } //Belle2 namespace
@@ -71,6 +71,12 @@ namespace Belle2 {
    * The global statistics for the framework can be accessed via
    * statistics.framework
    *
+   * If collection of performance counters is enabled (``basf2 --perf-stats``)
+   * the hardware performance counters and heap allocations of each module
+   * are shown in a second table and are available with
+   *
+   * >>> stats.perf_counter_mean(statistics.CYCLES, statistics.EVENT)
+   *
    * The name shown in the statistics can be modified. This is particular
    * useful if there is more than one instance of a given module in the path
    *
@@ -97,6 +103,16 @@ namespace Belle2 {
     std::string getStatisticsString(ModuleStatistics::EStatisticCounters type = ModuleStatistics::c_Event,
                                     const std::vector<Belle2::ModuleStatistics>* modules = nullptr, bool html = false) const;
 
+    /**
+     * Return a string with the performance counters of the given modules, shown by getStatisticsString() if available.
+     * @param type    type of counters to show
+     * @param modules modules to show, in the order they should be shown
+     * @param moduleNameLength width of the name column
+     * @param html    if true return the output as html table instead of an ascii table
+     */
+    std::string getPerformanceCounterString(ModuleStatistics::EStatisticCounters type, const std::vector<Belle2::ModuleStatistics>& modules,
+                                            int moduleNameLength, bool html = false) const;
+
     /** Get global statistics. */
     const ModuleStatistics& getGlobal() const { return m_global; }
 
@@ -134,6 +150,7 @@ namespace Belle2 {
     void startModule()
     {
       setCounters(m_moduleTime, m_moduleMemory);
+      if (PerformanceCounters::isEnabled()) PerformanceCounters::read(m_moduleCounters);
     }
 
     /** Stop module counter and attribute values to appropriate module */
@@ -142,7 +159,14 @@ namespace Belle2 {
       setCounters(m_moduleTime, m_moduleMemory,
                   m_moduleTime, m_moduleMemory);
       if (module && module->hasProperties(Module::c_DontCollectStatistics)) return;
-      m_stats[getIndex(module)].add(type, m_moduleTime, m_moduleMemory);
+      ModuleStatistics& stats = m_stats[getIndex(module)];
+      stats.add(type, m_moduleTime, m_moduleMemory);
+      if (PerformanceCounters::isEnabled()) {
+        PerformanceCounters::Values counters;
+        PerformanceCounters::read(counters);
+        for (int i = 0; i < PerformanceCounters::c_NCounters; i++) counters[i] -= m_moduleCounters[i];
+        stats.addPerformanceCounters(type, counters);
+      }
     }
 
     /** Init module statistics: Set name from module if still empty and
@@ -170,6 +194,9 @@ namespace Belle2 {
     /** Merge other ProcessStatistics object into this one. */
     virtual void merge(const Mergeable* other) override;
 
+    /** Add the global statistics of another object for the same modules, which merge() leaves alone (e.g. from another thread). */
+    void mergeGlobal(const ProcessStatistics& other) { m_global.update(other.m_global); }
+
     /** Clear collected statistics but keep names of modules */
     virtual void clear() override;
 
@@ -221,6 +248,8 @@ namespace Belle2 {
      * would be a stack of values but we know that we need at most one
      * element so we keep it a plain double. */
     double m_suspendedTime; //! (transient)
+    /** store performance counters for consumption by modules */
+    PerformanceCounters::Values m_moduleCounters{}; //! (transient)
     /** store heap size for suspended measurement. Generally this
      * would be a stack of values but we know that we need at most one
      * element so we keep it a plain double. */
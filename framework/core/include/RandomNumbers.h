@@ -65,9 +65,18 @@ namespace Belle2 {
      */
     static void useEventDependent();
 
-    /** return reference to the event dependent random generator */
+    /** return reference to the event dependent random generator (of the calling thread) */
     static RandomGenerator& getEventRandomGenerator() { return *s_evtRng; }
 
+    /**
+     * Give the calling thread its own event dependent random generator, starting as copy of the given one.
+     * Called by ThreadedEventProcessor for each worker thread, should not be called by other users
+     */
+    static void initializeThread(const RandomGenerator& eventGenerator);
+
+    /** Delete the random generator created by initializeThread(). */
+    static void terminateThread();
+
     /** Increase random barrier.
      * current random generator will be reseeded with a different "barrier
      * index" which makes it's state independent from previous calls */
@@ -98,8 +107,8 @@ namespace Belle2 {
 
 
   private:
-    /** event dependent random generator to be used for event processing */
-    static RandomGenerator* s_evtRng;
+    /** event dependent random generator to be used for event processing, one per thread */
+    static thread_local RandomGenerator* s_evtRng;
     /** event independent random generator to be used for begin/end run processing */
     static RandomGenerator* s_runRng;
     /** The random number generator seed set by the user. initialized to a
@@ -0,0 +1,111 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <framework/core/EventProcessor.h>
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+namespace Belle2 {
+  class RandomGenerator;
+
+  /**
+   * Event processing loop running several events at the same time in threads of one process.
+   *
+   * Alternative to the fork-based pEventProcessor without serializing events: every thread
+   * works in its own DataStore ID (created as copy of the main DataStore after initialize())
+   * and picks up the next event as soon as it is done with the previous one.
+   *
+   * - The modules up to and including the master module (the input stage) are run by one thread
+   *   at a time, so events are read in order.
+   * - Modules with the Module::c_ThreadSafe flag (and without conditions) are run concurrently.
+   * - All other modules are run by one thread at a time, on the DataStore ID they were initialized
+   *   with: the event data of the calling thread is swapped into the main DataStore for the call.
+   *   This includes the input and output modules, which keep pointers to DataStore entries, and
+   *   Python modules (the thread holds the GIL during the call).
+   * - beginRun()/endRun() are called once all events of the previous run are done, no other
+   *   thread processes events during that time.
+   *
+   * Persistent objects of thread-safe modules exist once per thread, the ones deriving from
+   * Mergeable are merged into the main DataStore at the end, other ones are discarded.
+   * Intra-run dependent conditions are updated when an event is read, threads still working on
+   * earlier events will see the new payloads. Sub-DataStore IDs (independent paths) are not supported.
+   *
+   * Modules are only flagged after an audit of their event() function. So far these are
+   * PruneDataStore and EventInfoPrinter, all other modules are serialized, so a speedup needs
+   * the expensive modules of a path to be audited and flagged. Until then typical paths are not
+   * faster than with the normal EventProcessor. Note that setReturnValue() and gRandom are not
+   * thread-safe either, so modules using them (e.g. Prescale) can't be flagged as they are.
+   */
+  class ThreadedEventProcessor : public EventProcessor {
+  public:
+    /** Constructor.
+     *
+     * @param nThreads Number of threads processing events.
+     */
+    explicit ThreadedEventProcessor(int nThreads);
+
+    /** Prefix of the DataStore IDs used by the threads, followed by the thread index. */
+    static const std::string c_ThreadIDPrefix;
+
+  protected:
+    /** Starts the threads and waits until all events are processed, see EventProcessor::processCore(). */
+    void processCore(const PathPtr& startPath, const ModulePtrList& modulePathList, long maxEvent = 0,
+                     bool isInputProcess = true) override;
+
+  private:
+    /** Create the DataStore IDs of the threads as copies of the main DataStore, without event data and collected statistics. */
+    void prepareThreadDataStores();
+
+    /** Merge persistent objects of the given thread into the main DataStore. */
+    void mergeThreadDataStore(const std::string& id);
+
+    /** Event loop of one thread.
+     *
+     * @param threadIndex index of the thread, determines its DataStore ID.
+     * @param startPath The processing starts with the first module of this path.
+     * @param eventGenerator random generator the one of the thread is copied from.
+     */
+    void processThread(int threadIndex, const PathPtr& startPath, const RandomGenerator& eventGenerator);
+
+    /** Calls event() functions on all modules for the current event, like EventProcessor::processEvent().
+     *
+     * @param moduleIter iterator of the path containing all the modules
+     * @param skipMasterModule skip the execution of the master module (first event, done in initialize())
+     * @param inputLock lock on m_inputMutex, released once the master module is done.
+     * @param runLock shared lock on m_runMutex, acquired once the master module is done.
+     * @return true if execution should stop.
+     */
+    bool processThreadEvent(PathIterator moduleIter, bool skipMasterModule, std::unique_lock<std::mutex>& inputLock,
+                            std::shared_lock<std::shared_mutex>& runLock);
+
+    /** Calls event() of one module, holding m_moduleMutex unless the module is thread-safe.
+     *
+     * @return result of Module::evalCondition() after the call.
+     */
+    bool callModule(Module* module);
+
+    int m_nThreads; /**< Number of threads processing events. */
+
+    std::mutex m_inputMutex; /**< Held while reading an event (modules up to and including the master module). */
+    std::mutex m_moduleMutex; /**< Held while calling a module which is not thread-safe (or doing anything else with global state). */
+    std::shared_mutex m_runMutex; /**< Held shared while processing an event, exclusively for beginRun()/endRun(). */
+    std::mutex m_exceptionMutex; /**< Protects m_exception. */
+
+    long m_maxEvent{0}; /**< Maximal number of events, 0 for all. Protected by m_inputMutex. */
+    long m_nEvents{0}; /**< Number of events read so far. Protected by m_inputMutex. */
+    bool m_firstEventPending{false}; /**< First event was read in initialize() and is still in the main DataStore. Protected by m_inputMutex. */
+    std::atomic<bool> m_endOfData{false}; /**< Set once no further events are to be processed. */
+    std::exception_ptr m_exception; /**< First exception thrown in one of the threads, rethrown after all threads stopped. */
+  };
+}
@@ -94,6 +94,7 @@ Environment::Environment() :
   m_logLevelOverride(LogConfig::c_Default),
   m_visualizeDataFlow(false),
   m_noStats(false),
+  m_perfStats(false),
   m_dryRun(false),
   m_mcEvents(0),
   m_run(-1),
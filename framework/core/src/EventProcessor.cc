@@ -297,6 +297,11 @@ void EventProcessor::processInitialize(const ModulePtrList& modulePathList, bool
   m_processStatisticsPtr->stopGlobal(ModuleStatistics::c_Init);
 }
 
+int EventProcessor::getSignalReceived()
+{
+  return gSignalReceived;
+}
+
 void EventProcessor::installSignalHandler(int sig, void (*fn)(int))
 {
   struct sigaction s;
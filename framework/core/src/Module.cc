@@ -369,6 +369,10 @@ void Module::exposePythonAPI()
 .. attribute:: TERMINATEINALLPROCESSES
 
   When using parallel processing, call this module's terminate() function in all processes. This will also ensure that there is exactly one process (single-core if no parallel modules found) or at least one input, one main and one output process.
+
+.. attribute:: THREADSAFE
+
+  The event() function of this module can be called for several events at the same time from different threads when using multithreaded processing (see :func:`set_nthreads()`). Modules without this flag are run by one thread at a time.
 )")
   .value("INPUT", Module::EModulePropFlags::c_Input)
   .value("OUTPUT", Module::EModulePropFlags::c_Output)
@@ -376,6 +380,7 @@ void Module::exposePythonAPI()
   .value("HISTOGRAMMANAGER", Module::EModulePropFlags::c_HistogramManager)
   .value("INTERNALSERIALIZER", Module::EModulePropFlags::c_InternalSerializer)
   .value("TERMINATEINALLPROCESSES", Module::EModulePropFlags::c_TerminateInAllProcesses)
+  .value("THREADSAFE", Module::EModulePropFlags::c_ThreadSafe)
   ;
 
   //Python class definition
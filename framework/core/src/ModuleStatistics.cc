@@ -19,6 +19,11 @@ void ModuleStatistics::csv_header(std::ostream& output) const
     }
     output << "," << resource << " mean" << "," << resource << " stddev";
   }
+  output << ",stall time" << ",named times";
+  for (int counter = 0; counter < PerformanceCounters::c_NCounters; counter++) {
+    const char* name = PerformanceCounters::getName(PerformanceCounters::ECounter(counter));
+    output << "," << name << " event" << "," << name << " total";
+  }
   output << std::endl;
 }
 
@@ -35,6 +40,16 @@ void ModuleStatistics::csv(std::ostream& output) const
     output << "," << m_stats[type].getSum<1>();
   }
   output << "," << m_stats[c_Event].getMean<1>() << ","  << m_stats[c_Event].getStddev<1>();
+  output << "," << m_stallTime << ",";
+  // the named times differ between modules, so they share one column as space separated name=time pairs
+  const char* separator = "";
+  for (const auto& namedTime : m_namedTimes) {
+    output << separator << namedTime.first << "=" << namedTime.second;
+    separator = " ";
+  }
+  for (int counter = 0; counter < PerformanceCounters::c_NCounters; counter++) {
+    output << "," << m_counterSums[c_Event][counter] << "," << m_counterSums[c_Total][counter];
+  }
 
   output << std::endl;
 }
\ No newline at end of file
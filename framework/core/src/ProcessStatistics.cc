@@ -113,6 +113,80 @@ string ProcessStatistics::getStatisticsString(ModuleStatistics::EStatisticCounte
   } else {
     out << "</tfoot></table>";
   }
+
+  if (std::any_of(modules->begin(), modules->end(), [](const ModuleStatistics & stats) { return stats.hasPerformanceCounters(); }))
+    out << getPerformanceCounterString(mode, modulesSortedByIndex, moduleNameLength, html);
+  return out.str();
+}
+
+string ProcessStatistics::getPerformanceCounterString(ModuleStatistics::EStatisticCounters mode,
+                                                      const std::vector<ModuleStatistics>& modules, int moduleNameLength, bool html) const
+{
+  const std::string numTabsModule = (boost::format("%d") % (moduleNameLength + 1)).str();
+  const std::string numWidth = (boost::format("%d") % (moduleNameLength + 1 + 86)).str();
+  boost::format outputheader("%s %|" + numTabsModule + "t|| %10s | %10s | %6s | %10s | %10s | %10s | %10s\n");
+  boost::format output("%s %|" + numTabsModule + "t|| %10.4g | %10.4g | %6.2f | %10.4g | %10.4g | %10.4g | %10.2f\n");
+  if (html) {
+    outputheader = boost::format("<thead><tr><th>%s</th><th>%s</th><th>%s</th><th>%s</th><th>%s</th><th>%s</th><th>%s</th>"
+                                 "<th>%s</th></tr></thead>");
+    output = boost::format("<tr><td>%s</td><td>%.4g</td><td>%.4g</td><td>%.2f</td><td>%.4g</td><td>%.4g</td><td>%.4g</td>"
+                           "<td>%.2f</td></tr>");
+  }
+
+  stringstream out;
+  if (!html) {
+    out << boost::format("%|" + numWidth + "T=|\n");
+    out << outputheader % "Name (mean per call)" % "Cycles" % "Instr." % "IPC" % "LLC miss" % "Br. miss" % "Allocs" % "Alloc(kB)";
+    out << boost::format("%|" + numWidth + "T=|\n");
+  } else {
+    out << "<table border=0>";
+    out << outputheader % "Name (mean per call)" % "Cycles" % "Instr." % "IPC" % "LLC miss" % "Br. miss" % "Allocs" % "Alloc(kB)";
+    out << "<tbody>";
+  }
+
+  ModuleStatistics total;
+  for (const ModuleStatistics& stats : modules) {
+    total.update(stats);
+    const double cycles = stats.getPerformanceCounterMean(PerformanceCounters::c_Cycles, mode);
+    const double instructions = stats.getPerformanceCounterMean(PerformanceCounters::c_Instructions, mode);
+    out << output
+        % stats.getName()
+        % cycles
+        % instructions
+        % (cycles > 0 ? instructions / cycles : 0.)
+        % stats.getPerformanceCounterMean(PerformanceCounters::c_CacheMisses, mode)
+        % stats.getPerformanceCounterMean(PerformanceCounters::c_BranchMisses, mode)
+        % stats.getPerformanceCounterMean(PerformanceCounters::c_Allocations, mode)
+        % (stats.getPerformanceCounterMean(PerformanceCounters::c_AllocatedBytes, mode) / 1024);
+  }
+
+  if (!html) {
+    out << boost::format("%|" + numWidth + "T=|\n");
+  } else {
+    out << "</tbody><tfoot>";
+  }
+  // sum of all modules divided by the number of calls of the module called most often, e.g. per event
+  double calls = 0;
+  for (const ModuleStatistics& stats : modules) calls = std::max(calls, stats.getCalls(mode));
+  const auto perCall = [&](PerformanceCounters::ECounter counter) {
+    return calls > 0 ? total.getPerformanceCounterSum(counter, mode) / calls : 0;
+  };
+  const double cycles = perCall(PerformanceCounters::c_Cycles);
+  const double instructions = perCall(PerformanceCounters::c_Instructions);
+  out << output
+      % "Total"
+      % cycles
+      % instructions
+      % (cycles > 0 ? instructions / cycles : 0.)
+      % perCall(PerformanceCounters::c_CacheMisses)
+      % perCall(PerformanceCounters::c_BranchMisses)
+      % perCall(PerformanceCounters::c_Allocations)
+      % (perCall(PerformanceCounters::c_AllocatedBytes) / 1024);
+  if (!html) {
+    out << boost::format("%|" + numWidth + "T=|\n");
+  } else {
+    out << "</tfoot></table>";
+  }
   return out.str();
 }
 
@@ -202,6 +276,7 @@ void ProcessStatistics::setTransientCounters(const ProcessStatistics* otherObjec
   m_moduleMemory = otherObject->m_moduleMemory;
   m_suspendedTime = otherObject->m_suspendedTime;
   m_suspendedMemory = otherObject->m_suspendedMemory;
+  m_moduleCounters = otherObject->m_moduleCounters;
 }
 
 void ProcessStatistics::clear()
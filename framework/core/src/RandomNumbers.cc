@@ -23,7 +23,7 @@ using namespace Belle2;
  * non-deterministic 64byte hex string if not set by user  */
 std::string RandomNumbers::s_initialSeed;
 /** event dependent random generator to be used for event processing */
-RandomGenerator* RandomNumbers::s_evtRng{nullptr};
+thread_local RandomGenerator* RandomNumbers::s_evtRng{nullptr};
 /** event independent random generator to be used for begin/end run processing */
 RandomGenerator* RandomNumbers::s_runRng{nullptr};
 /** barrier index offset to be used in begin/endRun. Obtained from event dependent generator */
@@ -130,6 +130,21 @@ void RandomNumbers::useEventDependent()
   gRandom = s_evtRng;
 }
 
+void RandomNumbers::initializeThread(const RandomGenerator& eventGenerator)
+{
+  delete s_evtRng;
+  s_evtRng = new RandomGenerator(eventGenerator);
+}
+
+void RandomNumbers::terminateThread()
+{
+  //gRandom is shared by all threads, don't leave it dangling
+  if (gRandom == s_evtRng)
+    gRandom = s_runRng;
+  delete s_evtRng;
+  s_evtRng = nullptr;
+}
+
 //=====================================================================
 //                          Python API
 //=====================================================================
@@ -247,6 +247,9 @@ void SubEventModule::event()
     //get event map and make a deep copy of the StoreEntry objects
     //(we want to revert changes to the StoreEntry objects, but not to the arrays/objects)
     DataStore::StoreEntryMap& eventMap = DataStore::Instance().getStoreEntryMap(DataStore::c_Event);
+    //objects read by the input module on first access have to be read before, restoring would invalidate them otherwise
+    for (auto& entry : eventMap)
+      entry.second.ensureLoaded();
     DataStore::StoreEntryMap eventMapCopy = eventMap;
     DataStore::StoreEntry& objectEntry = DataStore::Instance().getStoreEntryMap(DataStore::c_Event).at(*m_objectName);
 
@@ -0,0 +1,345 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+//first because of python include
+#include <framework/core/Module.h>
+#include <Python.h>
+
+#include <framework/core/ThreadedEventProcessor.h>
+
+#include <framework/core/Environment.h>
+#include <framework/core/MetadataService.h>
+#include <framework/core/RandomGenerator.h>
+#include <framework/core/RandomNumbers.h>
+#include <framework/database/DBStore.h>
+#include <framework/datastore/DataStore.h>
+#include <framework/logging/Logger.h>
+#include <framework/pcore/Mergeable.h>
+
+#include <map>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace Belle2;
+
+const std::string ThreadedEventProcessor::c_ThreadIDPrefix = "thread";
+
+namespace {
+  /** Switches the calling thread to the main DataStore ID, with the event data of its own ID swapped in (RAII).
+   *
+   * Modules which are not thread-safe were initialized on the main DataStore ID and may keep pointers to its entries.
+   */
+  class MainDataStoreGuard {
+  public:
+    /** Swap in the event data and switch to the main DataStore ID. */
+    MainDataStoreGuard(): m_id(DataStore::Instance().currentID())
+    {
+      DataStore::Instance().swapContentsWith("", DataStore::c_Event);
+      DataStore::Instance().switchID("");
+    }
+    /** Switch back to the DataStore ID of the thread, taking the event data along. */
+    ~MainDataStoreGuard()
+    {
+      DataStore::Instance().switchID(m_id);
+      DataStore::Instance().swapContentsWith("", DataStore::c_Event);
+    }
+    /** no copy constructor */
+    MainDataStoreGuard(const MainDataStoreGuard&) = delete;
+    /** no assignment operator */
+    MainDataStoreGuard& operator=(const MainDataStoreGuard&) = delete;
+  private:
+    std::string m_id; /**< DataStore ID of the calling thread. */
+  };
+
+  /** Holds the Python GIL if the interpreter is running (RAII), for modules which might be implemented in Python. */
+  class PythonLockGuard {
+  public:
+    /** Acquire the GIL. */
+    PythonLockGuard(): m_active(Py_IsInitialized())
+    {
+      if (m_active)
+        m_state = PyGILState_Ensure();
+    }
+    /** Release the GIL. */
+    ~PythonLockGuard()
+    {
+      if (m_active)
+        PyGILState_Release(m_state);
+    }
+    /** no copy constructor */
+    PythonLockGuard(const PythonLockGuard&) = delete;
+    /** no assignment operator */
+    PythonLockGuard& operator=(const PythonLockGuard&) = delete;
+  private:
+    bool m_active; /**< Python is initialized and the GIL was acquired. */
+    PyGILState_STATE m_state{}; /**< GIL state before the guard was created. */
+  };
+}
+
+ThreadedEventProcessor::ThreadedEventProcessor(int nThreads): EventProcessor(), m_nThreads(nThreads)
+{
+  if (m_nThreads < 1)
+    B2FATAL("ThreadedEventProcessor needs at least one thread, got " << m_nThreads);
+}
+
+void ThreadedEventProcessor::processCore(const PathPtr& startPath, const ModulePtrList& modulePathList, long maxEvent,
+                                         bool isInputProcess)
+{
+  DataStore::Instance().setInitializeActive(false);
+  m_moduleList = modulePathList;
+  //Remember the previous event meta data, and identify end of data meta data
+  m_previousEventMetaData.setEndOfData(); //invalid start state
+
+  m_maxEvent = maxEvent;
+  m_nEvents = 0;
+  m_firstEventPending = isInputProcess;
+  m_endOfData = false;
+  m_exception = nullptr;
+
+  int nThreadSafe = 0;
+  for (const ModulePtr& module : modulePathList) {
+    if (module->hasProperties(Module::c_ThreadSafe))
+      nThreadSafe++;
+  }
+  B2INFO("Processing events in " << m_nThreads << " threads, " << nThreadSafe << " of " << modulePathList.size()
+         << " modules can be run concurrently (THREADSAFE flag).");
+  if (nThreadSafe == 0)
+    B2WARNING("No module in the path can be run concurrently, multithreaded processing gives no speedup.");
+
+  prepareThreadDataStores();
+  MetadataService::Instance().addBasf2Status("running event loop");
+
+  //threads start with a copy of the generator initialized from the seed
+  const RandomGenerator& eventGenerator = RandomNumbers::getEventRandomGenerator();
+  //let the threads acquire the GIL for modules which are not thread-safe (e.g. Python modules)
+  PyThreadState* pythonState = (Py_IsInitialized() and PyGILState_Check()) ? PyEval_SaveThread() : nullptr;
+  LogSystem::Instance().enableThreadSafety();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < m_nThreads; i++)
+    threads.emplace_back(&ThreadedEventProcessor::processThread, this, i, std::cref(startPath), std::cref(eventGenerator));
+  for (std::thread& thread : threads)
+    thread.join();
+  LogSystem::Instance().disableThreadSafety();
+  if (pythonState)
+    PyEval_RestoreThread(pythonState);
+
+  for (int i = 0; i < m_nThreads; i++)
+    mergeThreadDataStore(c_ThreadIDPrefix + std::to_string(i));
+  DataStore::Instance().switchID("");
+  DataStore::setMultiThreaded(false);
+  RandomNumbers::useEventDependent();
+
+  if (m_exception)
+    std::rethrow_exception(m_exception);
+
+  //End last run
+  m_eventMetaDataPtr.create();
+  processEndRun();
+}
+
+void ThreadedEventProcessor::prepareThreadDataStores()
+{
+  DataStore& store = DataStore::Instance();
+  for (int i = 0; i < m_nThreads; i++)
+    store.createNewDataStoreID(c_ThreadIDPrefix + std::to_string(i));
+
+  //from now on, switchID() only affects the calling thread
+  DataStore::setMultiThreaded(true);
+  for (int i = 0; i < m_nThreads; i++) {
+    store.switchID(c_ThreadIDPrefix + std::to_string(i));
+    //the first event stays in the main DataStore until a thread picks it up
+    store.invalidateData(DataStore::c_Event);
+    //statistics and histograms are merged in the end, don't count what was done before several times
+    for (auto& entry : store.getStoreEntryMap(DataStore::c_Persistent)) {
+      if (auto* mergeable = dynamic_cast<Mergeable*>(entry.second.ptr))
+        mergeable->clear();
+    }
+  }
+  store.switchID("");
+}
+
+void ThreadedEventProcessor::mergeThreadDataStore(const std::string& id)
+{
+  DataStore& store = DataStore::Instance();
+  store.switchID(id);
+  std::map<std::string, const Mergeable*> threadObjects;
+  for (const auto& entry : store.getStoreEntryMap(DataStore::c_Persistent)) {
+    if (const auto* mergeable = dynamic_cast<const Mergeable*>(entry.second.ptr))
+      threadObjects[entry.first] = mergeable;
+  }
+
+  store.switchID("");
+  for (auto& entry : store.getStoreEntryMap(DataStore::c_Persistent)) {
+    auto* mergeable = dynamic_cast<Mergeable*>(entry.second.ptr);
+    const auto it = threadObjects.find(entry.first);
+    if (!mergeable or it == threadObjects.end())
+      continue;
+    mergeable->merge(it->second);
+    //time per event is measured by the threads
+    if (auto* stats = dynamic_cast<ProcessStatistics*>(mergeable))
+      stats->mergeGlobal(*static_cast<const ProcessStatistics*>(it->second));
+  }
+}
+
+void ThreadedEventProcessor::processThread(int threadIndex, const PathPtr& startPath, const RandomGenerator& eventGenerator)
+{
+  DataStore::Instance().switchID(c_ThreadIDPrefix + std::to_string(threadIndex));
+  RandomNumbers::initializeThread(eventGenerator);
+  const bool collectStats = !Environment::Instance().getNoStats();
+
+  try {
+    while (true) {
+      std::unique_lock<std::mutex> inputLock(m_inputMutex);
+      if (m_endOfData or (m_maxEvent > 0 and m_nEvents >= m_maxEvent))
+        break;
+      const bool skipMasterModule = m_firstEventPending;
+      if (m_firstEventPending) {
+        DataStore::Instance().swapContentsWith("", DataStore::c_Event);
+        m_firstEventPending = false;
+      }
+      m_nEvents++;
+
+      if (collectStats)
+        m_processStatisticsPtr->startGlobal();
+
+      std::shared_lock<std::shared_mutex> runLock(m_runMutex, std::defer_lock);
+      if (processThreadEvent(PathIterator(startPath), skipMasterModule, inputLock, runLock))
+        m_endOfData = true;
+
+      //Delete event related data in DataStore (of this thread)
+      DataStore::Instance().invalidateData(DataStore::c_Event);
+
+      if (collectStats)
+        m_processStatisticsPtr->stopGlobal(ModuleStatistics::c_Event);
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(m_exceptionMutex);
+    if (!m_exception)
+      m_exception = std::current_exception();
+    m_endOfData = true;
+  }
+
+  std::lock_guard<std::mutex> lock(m_moduleMutex);
+  RandomNumbers::terminateThread();
+}
+
+bool ThreadedEventProcessor::processThreadEvent(PathIterator moduleIter, bool skipMasterModule,
+                                                std::unique_lock<std::mutex>& inputLock, std::shared_lock<std::shared_mutex>& runLock)
+{
+  const bool collectStats = !Environment::Instance().getNoStats();
+  EventMetaData eventMetaData;
+
+  while (!moduleIter.isDone()) {
+    Module* module = moduleIter.get();
+
+    // run the module ... unless we don't want to
+    bool condition = false;
+    if (!(skipMasterModule && module == m_master)) {
+      condition = callModule(module);
+    } else {
+      condition = module->evalCondition();
+    }
+
+    //Check for end of data
+    if ((m_eventMetaDataPtr && (m_eventMetaDataPtr->isEndOfData())) ||
+        ((module == m_master) && !m_eventMetaDataPtr)) {
+      if ((module != m_master) && !m_steerRootInputModuleOn) {
+        B2WARNING("Event processing stopped by module '" << module->getName() <<
+                  "', which is not in control of event processing (does not provide EventMetaData)");
+      }
+      return true;
+    }
+
+    //Handle EventMetaData changes by master module
+    if (module == m_master) {
+      const bool newRun = (m_eventMetaDataPtr->getExperiment() != m_previousEventMetaData.getExperiment()) ||
+                          (m_eventMetaDataPtr->getRun() != m_previousEventMetaData.getRun());
+      //wait until the events of the previous run are done (before taking m_moduleMutex, which they might need)
+      std::unique_lock<std::shared_mutex> exclusiveRunLock(m_runMutex, std::defer_lock);
+      if (newRun)
+        exclusiveRunLock.lock();
+
+      {
+        //gRandom and the conditions are shared by all threads
+        std::lock_guard<std::mutex> lock(m_moduleMutex);
+
+        //initialize random number state for the event
+        RandomNumbers::initializeEvent();
+
+        if (newRun) {
+          if (collectStats)
+            m_processStatisticsPtr->suspendGlobal();
+
+          MainDataStoreGuard mainDataStore;
+          PythonLockGuard pythonLock;
+          processEndRun();
+          processBeginRun(skipMasterModule);
+
+          if (collectStats)
+            m_processStatisticsPtr->resumeGlobal();
+        }
+
+        m_previousEventMetaData = *m_eventMetaDataPtr;
+        eventMetaData = *m_eventMetaDataPtr;
+
+        //make sure we use the event dependent generator again
+        RandomNumbers::useEventDependent();
+
+        DBStore::Instance().updateEvent();
+      }
+
+      //the event is read, let the next thread in
+      if (exclusiveRunLock.owns_lock())
+        exclusiveRunLock.unlock();
+      runLock.lock();
+      inputLock.unlock();
+    } else {
+      //Check for a second master module, see EventProcessor::processEvent()
+      if (!skipMasterModule && runLock.owns_lock() && m_eventMetaDataPtr &&
+          (*m_eventMetaDataPtr != eventMetaData)) {
+        B2FATAL("Two modules setting EventMetaData were discovered: " << m_master->getName() << " and " << module->getName());
+      }
+    }
+
+    if (getSignalReceived() != 0) {
+      throw StoppedBySignalException(getSignalReceived());
+    }
+
+    //Check for the module conditions, evaluate them and if one is true switch to the new path
+    if (condition) {
+      PathPtr condPath = module->getConditionPath();
+      //continue with parent Path after condition path is executed?
+      if (module->getAfterConditionPath() == Module::EAfterConditionPath::c_Continue) {
+        moduleIter = PathIterator(condPath, moduleIter);
+      } else {
+        moduleIter = PathIterator(condPath);
+      }
+    } else {
+      moduleIter.next();
+    }
+  } //end module loop
+  return false;
+}
+
+bool ThreadedEventProcessor::callModule(Module* module)
+{
+  //the return value is stored in the module, so modules with conditions cannot run concurrently
+  if (module->hasProperties(Module::c_ThreadSafe) and !module->hasCondition()) {
+    callEvent(module);
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(m_moduleMutex);
+  MainDataStoreGuard mainDataStore;
+  PythonLockGuard pythonLock;
+  //module might use gRandom
+  RandomNumbers::useEventDependent();
+  callEvent(module);
+  return module->evalCondition();
+}
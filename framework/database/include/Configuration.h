@@ -286,6 +286,11 @@ namespace Belle2::Conditions {
     /** Get the timeout we try to lock a file in the download cache directory for downloading */
     size_t getDownloadLockTimeout() const { return m_downloadLockTimeout; }
 
+    /** Set the size of the payload cache shared between the processes in parallel processing in MB, 0 disables it */
+    void setPayloadCacheSize(size_t size) { ensureEditable(); m_payloadCacheSize = size; }
+    /** Get the size of the payload cache shared between the processes in parallel processing in MB */
+    size_t getPayloadCacheSize() const { return m_payloadCacheSize; }
+
     /** Set the set of usable globaltag states to be allowed for processing.
      * The state INVALID will always be ignored and not permitted */
     void setUsableTagStates(const std::set<std::string>& states) { ensureEditable(); m_usableTagStates = states; }
@@ -339,6 +344,8 @@ namespace Belle2::Conditions {
     std::string m_downloadCacheDirectory{""};
     /** the timeout when trying to lock files in the download directory */
     size_t m_downloadLockTimeout{120};
+    /** the size of the shared payload cache in MB */
+    size_t m_payloadCacheSize{256};
     /** the tag states accepted for processing */
     std::set<std::string> m_usableTagStates{"TESTING", "VALIDATED", "PUBLISHED", "RUNNING"};
     /** the callback function to determine the final final list of globaltags */
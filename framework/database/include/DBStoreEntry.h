@@ -101,7 +101,8 @@ namespace Belle2 {
     /** get the object for this payload, can be nullptr if the payload is not
      * loaded or not of type c_Object */
     const TObject* getObject() const { return m_object; }
-    /** get the ROOT TFile pointer for this payload. Can be nullptr if the payload is not loaded or neither c_ROOTFile or c_Object */
+    /** get the ROOT TFile pointer for this payload. Can be nullptr if the payload is not loaded or neither c_ROOTFile or c_Object,
+     * or if the object was taken from the shared payload cache */
     const TFile* getTFile() const { return m_tfile; }
     /** get the class of this payload */
     const TClass* getClass() const { return m_objClass; }
@@ -139,8 +140,10 @@ namespace Belle2 {
      */
     void updatePayload(unsigned int revision, const IntervalOfValidity& iov, const std::string& filename, const std::string& checksum,
                        const std::string& globaltag, const EventMetaData& event);
-    /** Actual load the payload from file after all info is set */
+    /** Actual load the payload from file (or the shared payload cache) after all info is set */
     void loadPayload(const EventMetaData& event);
+    /** If the loaded object is an IntraRunDependency, keep it and point m_object to the object valid for the given event */
+    void resolveIntraRunDependency(const EventMetaData& event);
     /** update the payload object according to the new event information.
      * If the payload has no intra run dependency this does nothing, otherwise
      * it will load the appropriate object for the given event and call the
@@ -0,0 +1,99 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class TObject;
+
+namespace Belle2::Conditions {
+  struct PayloadCacheHeader;
+
+  /** Cache of payload objects shared between the processes of one basf2 job.
+   *
+   * When using parallel processing every process has to load the payloads for
+   * each run. To avoid opening and decompressing the same payload file in
+   * every process, the first process to load a payload revision puts the
+   * streamed (uncompressed) object into shared memory, other processes just
+   * read the object back from there.
+   *
+   * The shared memory is an anonymous mapping created before forking and
+   * inherited by all processes. Space is handed out in order and never freed,
+   * once it is full all further payloads are just loaded from file.
+   * Entries are only written once and read-only afterwards, so no locking is
+   * needed besides claiming a slot and space with atomic operations.
+   */
+  class PayloadCache {
+  public:
+    /** Statistics on the usage of the cache, summed over all processes */
+    struct Statistics {
+      /** number of payloads found in the cache */
+      uint64_t hits{0};
+      /** number of payloads not found in the cache */
+      uint64_t misses{0};
+      /** number of payloads in the cache */
+      uint64_t entries{0};
+      /** size of the cache in bytes */
+      uint64_t size{0};
+      /** bytes used by the payloads in the cache */
+      uint64_t residentSize{0};
+    };
+
+    /** Maximum number of payloads in the cache */
+    static constexpr size_t c_MaxEntries = 4096;
+
+    /** Get the instance */
+    static PayloadCache& getInstance();
+
+    /** Create the shared memory with the given size in bytes, removing any
+     * previous cache. Has to be called before forking to be shared between the processes.
+     * A size of 0 disables the cache. */
+    void create(size_t size);
+    /** Remove the cache, only to be called once no other process uses it anymore */
+    void destroy();
+    /** Check if the cache was created */
+    bool isEnabled() const { return m_header != nullptr; }
+
+    /** Get a new instance of a payload object from the cache.
+     *
+     * @param checksum checksum of the payload file
+     * @param name name of the object in the payload file
+     * @return new object which is owned by the caller, or nullptr if the
+     *         payload is not in the cache (yet).
+     */
+    TObject* get(const std::string& checksum, const std::string& name);
+    /** Put a payload object into the cache. Does nothing if the cache is
+     * disabled or full or if the payload is already in the cache.
+     *
+     * @param checksum checksum of the payload file
+     * @param name name of the object in the payload file
+     * @param object payload object as read from the file
+     */
+    void put(const std::string& checksum, const std::string& name, const TObject* object);
+
+    /** Return the statistics of all processes */
+    Statistics getStatistics() const;
+
+  private:
+    /** Hidden constructor, as it is a singleton */
+    PayloadCache() = default;
+    /** Don't copy */
+    PayloadCache(const PayloadCache&) = delete;
+    /** Don't assign */
+    PayloadCache& operator=(const PayloadCache&) = delete;
+    /** Remove the shared memory on destruction */
+    ~PayloadCache() { destroy(); }
+
+    /** Pointer to the start of the shared memory */
+    PayloadCacheHeader* m_header{nullptr};
+    /** Size of the shared memory in bytes */
+    size_t m_size{0};
+  };
+} // Belle2::Conditions namespace
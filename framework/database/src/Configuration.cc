@@ -333,6 +333,9 @@ namespace Belle2::Conditions {
       checkValue("download_lock_timeout",
       [&self](size_t timeout) { self.setDownloadLockTimeout(timeout);},
       [&self]() { return self.getDownloadLockTimeout();});
+      checkValue("payload_cache_size",
+      [&self](size_t size) { self.setPayloadCacheSize(size);},
+      [&self]() { return self.getPayloadCacheSize();});
       checkValue("usable_globaltag_states",
       [&self](const auto & states) { self.setUsableTagStates(states); },
       [&self]() { return self.getUsableTagStates(); });
@@ -563,6 +566,7 @@ function will return a dictionary containing all current settings.
     {'save_payloads': 'localdb/database.txt',
      'download_cache_location': '',
      'download_lock_timeout': 120,
+     'payload_cache_size': 256,
      'usable_globaltag_states': {'PUBLISHED', 'RUNNING', 'TESTING', 'VALIDATED'},
      'connection_timeout': 5,
      'stalled_timeout': 60,
@@ -587,6 +591,11 @@ Parameters:
       concurrently downloading the same payload between different processes.
       If locking fails the payload will be downloaded to a temporary file
       separately for each process.
+  payload_cache_size (int): Size in MB of the shared memory used to share
+      loaded payloads between the processes when using parallel processing.
+      The first process to load a payload puts it there, the other processes
+      don't need to open and decompress the payload file again. Memory is only
+      used once payloads are put into the cache. 0 disables the cache.
   usable_globaltag_states (set(str)): Names of globaltag states accepted for
       processing. This can be changed to make sure that only fully published
       globaltags are used or to enable running on an open tag. It is not possible
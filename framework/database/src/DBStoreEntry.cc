@@ -8,12 +8,14 @@
 
 #include <framework/database/DBStoreEntry.h>
 #include <framework/database/DBAccessorBase.h>
+#include <framework/database/PayloadCache.h>
 #include <framework/dataobjects/EventMetaData.h>
 #include <framework/logging/Logger.h>
 #include <iomanip>
 #include <TFile.h>
 #include <TClonesArray.h>
 #include <TClass.h>
+#include <TDirectory.h>
 
 namespace {
   /** do nothing, needed for variadic template below */
@@ -114,6 +116,18 @@ namespace Belle2 {
       // invalid payload nothing else to do
       return;
     }
+    // Maybe another process already loaded the object, then we don't need to open the file at all
+    auto& cache = Conditions::PayloadCache::getInstance();
+    if (m_payloadType == c_Object and cache.isEnabled() and !m_checksum.empty()) {
+      m_object = cache.get(m_checksum, m_name);
+      if (m_object) {
+        B2DEBUG(34, "Got " << m_name << " from shared payload cache");
+        // check that it is compatible with what it should be
+        checkType(m_object);
+        resolveIntraRunDependency(event);
+        return;
+      }
+    }
     if (m_payloadType != c_RawFile) {
       // Open the payload file but make sure to go back to the previous
       // directory to not disturb other code.
@@ -139,12 +153,12 @@ namespace Belle2 {
         m_object->SetBit(kCanDelete, false);
         // check that it is compatible with what it should be
         checkType(m_object);
-        // resolve run dependency
-        if (m_object->InheritsFrom(IntraRunDependency::Class())) {
-          m_intraRunDependency = static_cast<IntraRunDependency*>(m_object);
-          m_object = m_intraRunDependency->getObject(event);
-          B2DEBUG(34, "Found intra run dependency for " << m_name << ": " << m_intraRunDependency << ", " << m_object);
+        // objects which need the file (like TTrees) cannot be shared
+        if (cache.isEnabled() and !m_checksum.empty() and !m_object->InheritsFrom(TDirectory::Class())
+            and !m_object->InheritsFrom("TTree")) {
+          cache.put(m_checksum, m_name, m_object);
         }
+        resolveIntraRunDependency(event);
         // TODO: depending on the object type we could now close the file. I
         // guess we cannot close the file in case of TTree but we have to find
         // out exactly which object types are safe before doing that?
@@ -152,6 +166,15 @@ namespace Belle2 {
     }
   }
 
+  void DBStoreEntry::resolveIntraRunDependency(const EventMetaData& event)
+  {
+    if (m_object->InheritsFrom(IntraRunDependency::Class())) {
+      m_intraRunDependency = static_cast<IntraRunDependency*>(m_object);
+      m_object = m_intraRunDependency->getObject(event);
+      B2DEBUG(34, "Found intra run dependency for " << m_name << ": " << m_intraRunDependency << ", " << m_object);
+    }
+  }
+
   void DBStoreEntry::overrideObject(TObject* obj, const IntervalOfValidity& iov)
   {
     if (!checkType(obj)) return;
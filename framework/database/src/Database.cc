@@ -20,10 +20,12 @@
 #include <framework/database/Database.h>
 
 #include <framework/dataobjects/EventMetaData.h>
+#include <framework/core/Environment.h>
 #include <framework/logging/Logger.h>
 #include <framework/database/DBStore.h>
 
 #include <framework/database/PayloadProvider.h>
+#include <framework/database/PayloadCache.h>
 #include <framework/database/MetadataProvider.h>
 #include <framework/database/LocalMetadataProvider.h>
 #include <framework/database/CentralMetadataProvider.h>
@@ -47,6 +49,17 @@ namespace Belle2 {
     auto& conf = Conditions::Configuration::getInstance();
     conf.setInitialized(false);
     DBStore::Instance().reset(true);
+    auto& cache = Conditions::PayloadCache::getInstance();
+    if (cache.isEnabled()) {
+      const auto stats = cache.getStatistics();
+      if (stats.entries > 0)
+        B2INFO("Conditions data: shared payload cache summary"
+               << LogVar("hits", stats.hits) << LogVar("misses", stats.misses)
+               << LogVar("payloads", stats.entries)
+               << LogVar("resident size [MB]", stats.residentSize / 1024. / 1024.)
+               << LogVar("size [MB]", stats.size / 1024. / 1024.));
+      cache.destroy();
+    }
     Instance().m_configState = c_PreInit;
     Instance().m_metadataProvider.reset();
     Instance().m_payloadCreation.reset();
@@ -244,6 +257,10 @@ namespace Belle2 {
                             conf.getDownloadCacheDirectory(),
                             conf.getDownloadLockTimeout()
                           );
+      // Share loaded payloads between the processes, needs to be created before forking
+      if (Environment::Instance().getNumberProcesses() > 0) {
+        Conditions::PayloadCache::getInstance().create(conf.getPayloadCacheSize() * 1024 * 1024);
+      }
       // Also we need to be able to create payloads ...
       m_payloadCreation = std::make_unique<Conditions::TestingPayloadStorage>(conf.getNewPayloadLocation());
       // And maaaybe we want to use testing payloads
@@ -0,0 +1,192 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/database/PayloadCache.h>
+#include <framework/logging/Logger.h>
+
+#include <TBufferFile.h>
+#include <TObject.h>
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+namespace Belle2::Conditions {
+  namespace {
+    /** States of one slot in the cache */
+    enum ESlotState : uint32_t {
+      /** Unused, terminates the search for a payload */
+      c_Empty = 0,
+      /** Claimed by a process which is copying the payload */
+      c_Writing = 1,
+      /** Payload can be read */
+      c_Ready = 2,
+      /** Payload didn't fit into the cache, slot is unusable */
+      c_Failed = 3,
+    };
+  }
+
+  /** One payload in the cache */
+  struct PayloadCacheSlot {
+    /** State of the slot, see ESlotState. Everything else may only be read once this is c_Ready */
+    std::atomic<uint32_t> state;
+    /** Size of the key in bytes */
+    uint32_t keySize;
+    /** Hash of the key */
+    uint64_t hash;
+    /** Offset of the key in the data area, followed by the object */
+    uint64_t offset;
+    /** Size of the streamed object in bytes */
+    uint64_t size;
+  };
+
+  /** Placed at the beginning of the shared memory, followed by the data area */
+  struct PayloadCacheHeader {
+    /** Bytes used in the data area */
+    std::atomic<uint64_t> used;
+    /** Number of cache hits */
+    std::atomic<uint64_t> hits;
+    /** Number of cache misses */
+    std::atomic<uint64_t> misses;
+    /** Number of payloads in the cache */
+    std::atomic<uint64_t> entries;
+    /** Slots, searched with linear probing starting at hash % c_MaxEntries */
+    PayloadCacheSlot slots[PayloadCache::c_MaxEntries];
+  };
+
+  namespace {
+    /** Key of a payload in the cache */
+    std::string getKey(const std::string& checksum, const std::string& name) { return checksum + "/" + name; }
+
+    /** FNV-1a hash of the key, has to be the same in all processes */
+    uint64_t getHash(const std::string& key)
+    {
+      uint64_t hash = 14695981039346656037ull;
+      for (unsigned char c : key) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+      }
+      return hash;
+    }
+  }
+
+  PayloadCache& PayloadCache::getInstance()
+  {
+    static PayloadCache instance;
+    return instance;
+  }
+
+  void PayloadCache::create(size_t size)
+  {
+    destroy();
+    if (size == 0) return;
+    m_size = sizeof(PayloadCacheHeader) + size;
+    // memory is only really allocated once used
+    void* memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (memory == MAP_FAILED) {
+      B2WARNING("Conditions data: cannot create shared payload cache, payloads will be loaded separately in each process"
+                << LogVar("size", size) << LogVar("error", std::strerror(errno)));
+      m_size = 0;
+      return;
+    }
+    // anonymous mappings are zero initialized, i.e. all slots are empty
+    m_header = new(memory) PayloadCacheHeader;
+    B2DEBUG(30, "Conditions data: created shared payload cache" << LogVar("size", size));
+  }
+
+  void PayloadCache::destroy()
+  {
+    if (!m_header) return;
+    munmap(m_header, m_size);
+    m_header = nullptr;
+    m_size = 0;
+  }
+
+  TObject* PayloadCache::get(const std::string& checksum, const std::string& name)
+  {
+    if (!m_header) return nullptr;
+    const std::string key = getKey(checksum, name);
+    const uint64_t hash = getHash(key);
+    const char* data = reinterpret_cast<const char*>(m_header + 1);
+    for (size_t i = 0; i < c_MaxEntries; ++i) {
+      const PayloadCacheSlot& slot = m_header->slots[(hash + i) % c_MaxEntries];
+      const uint32_t state = slot.state.load(std::memory_order_acquire);
+      if (state == c_Empty) break;
+      if (state != c_Ready or slot.hash != hash or slot.keySize != key.size()
+          or key.compare(0, key.size(), data + slot.offset, slot.keySize) != 0) continue;
+      // found it, stream a new object out of the shared memory (which is not modified)
+      TBufferFile buffer(TBuffer::kRead, slot.size, const_cast<char*>(data + slot.offset + slot.keySize), false);
+      TObject* object = buffer.ReadObject(TObject::Class());
+      if (object) {
+        m_header->hits.fetch_add(1, std::memory_order_relaxed);
+        return object;
+      }
+      B2WARNING("Conditions data: cannot read payload from shared cache" << LogVar("name", name) << LogVar("checksum", checksum));
+      break;
+    }
+    m_header->misses.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  void PayloadCache::put(const std::string& checksum, const std::string& name, const TObject* object)
+  {
+    if (!m_header or !object) return;
+    const std::string key = getKey(checksum, name);
+    const uint64_t hash = getHash(key);
+    const uint64_t capacity = m_size - sizeof(PayloadCacheHeader);
+    char* data = reinterpret_cast<char*>(m_header + 1);
+    for (size_t i = 0; i < c_MaxEntries; ++i) {
+      PayloadCacheSlot& slot = m_header->slots[(hash + i) % c_MaxEntries];
+      uint32_t state = c_Empty;
+      if (!slot.state.compare_exchange_strong(state, c_Writing, std::memory_order_acquire)) {
+        // someone else was faster with this payload, no need to put it twice
+        if (state == c_Ready and slot.hash == hash and slot.keySize == key.size()
+            and key.compare(0, key.size(), data + slot.offset, slot.keySize) == 0) return;
+        continue;
+      }
+      // we own the slot, stream the object and claim the space
+      TBufferFile buffer(TBuffer::kWrite);
+      buffer.WriteObject(object);
+      const uint64_t size = key.size() + buffer.Length();
+      slot.hash = hash;
+      // only advance the used space if the payload fits, a payload too large must not disable the cache
+      uint64_t offset = m_header->used.load(std::memory_order_relaxed);
+      do {
+        if (offset + size > capacity) {
+          B2DEBUG(30, "Conditions data: shared payload cache is full" << LogVar("name", name) << LogVar("size", buffer.Length()));
+          slot.state.store(c_Failed, std::memory_order_release);
+          return;
+        }
+      } while (!m_header->used.compare_exchange_weak(offset, offset + size, std::memory_order_relaxed));
+      std::memcpy(data + offset, key.data(), key.size());
+      std::memcpy(data + offset + key.size(), buffer.Buffer(), buffer.Length());
+      slot.keySize = key.size();
+      slot.offset = offset;
+      slot.size = buffer.Length();
+      slot.state.store(c_Ready, std::memory_order_release);
+      m_header->entries.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  PayloadCache::Statistics PayloadCache::getStatistics() const
+  {
+    Statistics stats;
+    if (!m_header) return stats;
+    stats.hits = m_header->hits.load();
+    stats.misses = m_header->misses.load();
+    stats.entries = m_header->entries.load();
+    stats.size = m_size - sizeof(PayloadCacheHeader);
+    stats.residentSize = std::min<uint64_t>(m_header->used.load(), stats.size);
+    return stats;
+  }
+} // Belle2::Conditions namespace
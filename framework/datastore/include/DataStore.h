@@ -18,9 +18,13 @@
 
 #include <regex>
 #include <array>
+#include <deque>
+#include <functional>
 #include <vector>
 #include <string>
 #include <map>
+#include <shared_mutex>
+#include <unordered_map>
 
 class TObject;
 class TClass;
@@ -58,6 +62,9 @@ namespace Belle2 {
     /** Number of Durability Types.  */
     const static int c_NDurabilityTypes = 2;
 
+    /** Value of an unresolved entry name handle, see getNameHandle(). */
+    const static int c_InvalidNameHandle = -1;
+
     /** Flags describing behaviours of objects etc.
      *
      * Bitwise operators (|, &, etc.) are provided via ADD_BITMASK_OPERATORS.
@@ -103,6 +110,17 @@ namespace Belle2 {
      */
     static DataStore& Instance();
 
+    /** Switch multithreaded mode on/off. Only to be called while no other threads access the DataStore.
+     *
+     *  In multithreaded mode, every thread works in its own DataStore ID (see switchID(), which then only affects the
+     *  calling thread), accessors no longer cache pointers to the entries and name handles are interned under a lock.
+     *  Used by ThreadedEventProcessor.
+     */
+    static void setMultiThreaded(bool multiThreaded) { s_multiThreaded = multiThreaded; }
+
+    /** Are there several threads with their own DataStore ID? See setMultiThreaded(). */
+    static bool isMultiThreaded() { return s_multiThreaded; }
+
     //--------------------------------- default name stuff -----------------------------------------------------
 
     /** Tries to deduce the TClass from a default object name, which is generally the name of the C++ class.
@@ -289,6 +307,17 @@ namespace Belle2 {
      */
     StoreEntry* getEntry(const StoreAccessorBase& accessor);
 
+    /** Return the integer handle for the given entry name, interning the name if it wasn't seen before.
+     *
+     *  Handles are assigned once per process and remain valid across events, DataStore IDs and reset(), so accessors
+     *  resolve them once (see StoreAccessorBase::getNameHandle()) and afterwards find their StoreEntry with a single
+     *  index into a flat table instead of a string lookup.
+     */
+    int getNameHandle(const std::string& name);
+
+    /** Return the entry name interned under the given handle. */
+    const std::string& getNameFromHandle(int handle) const;
+
     /** Get a pointer to a pointer of an object in the DataStore.
      *
      *  If the map of requested durability already contains an object under the key name with a DIFFERENT type
@@ -500,9 +529,23 @@ namespace Belle2 {
     /** Clears all registered StoreEntry objects of a specified durability, invalidating all objects.
      *
      *  Called by the framework once the given durability is over. Users should usually not use this function without a good reason.
+     *  In multithreaded mode, only the DataStore ID of the calling thread is affected.
      */
     void invalidateData(EDurability durability);
 
+    /** Register a function which is called at the end of each event, right before the objects with event durability are invalidated.
+     *
+     *  The function may take over objects of the event by swapping StoreEntry::object with another object of the same class,
+     *  e.g. to write them in a separate thread. It is called by the thread which processed the event.
+     *
+     *  @param owner Identifies the function for removeEndOfEventCallbacks()
+     *  @param callback Function to call
+     */
+    void addEndOfEventCallback(const void* owner, std::function<void()> callback);
+
+    /** Remove all functions registered with addEndOfEventCallback() by the given owner. */
+    void removeEndOfEventCallbacks(const void* owner);
+
     /** Frees memory occupied by data store items and removes all objects from the map.
      *
      *  Afterwards, m_storeEntryMap[durability] is empty.
@@ -534,6 +577,12 @@ namespace Belle2 {
     void copyContentsTo(const std::string& id, const std::vector<std::string>& entrylist_event = {});
     /** merge contents (actual array / object contents) of current DataStore to the DataStore with given ID. */
     void mergeContentsTo(const std::string& id, const std::vector<std::string>& entrylist_event = {});
+    /** exchange contents of all entries with given durability between the current DataStore and the one with the given ID.
+     *
+     *  Only pointers are swapped, entries existing in only one of the DataStores are left alone.
+     *  Used by ThreadedEventProcessor to run modules on the DataStore they were initialized with.
+     */
+    void swapContentsWith(const std::string& id, EDurability durability);
 
   private:
     /** Hidden constructor, as it is a singleton.*/
@@ -555,6 +604,12 @@ namespace Belle2 {
      */
     bool checkType(const StoreEntry& entry, const StoreAccessorBase& accessor) const;
 
+    /** Return the entry with the given name and durability, or nullptr if no such entry is registered. No type checks. */
+    StoreEntry* findEntry(const std::string& name, EDurability durability)
+    {
+      return m_storeEntryMap.getEntry(durability, getNameHandle(name), name);
+    }
+
     /** Returns a vector with the names of store arrays matching the given name and class. Note that the returned reference is only valid until the next call.
      *
      *  @param arrayName  A given array name, the special string "ALL" for all arrays deriving from the given class, or an empty string for the default array name.
@@ -584,7 +639,7 @@ namespace Belle2 {
       /** Clears all registered StoreEntry objects of a specified durability, invalidating all objects. */
       void invalidateData(EDurability durability);
       /** Get StoreEntry map for given durability (and current DataStore ID). */
-      const StoreEntryMap& operator [](int durability) const { return m_entries[m_currentIdx][durability]; }
+      const StoreEntryMap& operator [](int durability) const { return m_entries[currentIdx()][durability]; }
       /** Get StoreEntry map for given durability (and current DataStore ID). */
       StoreEntryMap& operator [](int durability)
       {
@@ -593,29 +648,69 @@ namespace Belle2 {
         return const_cast<StoreEntryMap&>((*this2)[durability]);
       }
 
+      /** Get the StoreEntry for the given name handle and durability (in the current DataStore ID), or nullptr if there is none.
+       *
+       * Entries found once are remembered in a flat table indexed by the handle, so that subsequent lookups are a single load.
+       */
+      StoreEntry* getEntry(int durability, int handle, const std::string& name)
+      {
+        const std::vector<StoreEntry*>& table = m_handleTables[currentIdx()][durability];
+        if (static_cast<size_t>(handle) < table.size() and table[handle])
+          return table[handle];
+        return lookupEntry(durability, handle, name);
+      }
+
       /** switch to DataStore with given ID. */
       void switchID(const std::string& id);
       /** returns ID of current DataStore. */
-      const std::string& currentID() const { return m_currentID; }
+      const std::string& currentID() const { return s_multiThreaded ? s_threadID : m_currentID; }
       /** copy entries (not contents) of current DataStore to the DataStore with given ID. */
       void copyEntriesTo(const std::string& id, const std::vector<std::string>& entrylist_event = {}, bool mergeEntries = false);
       /** copy contents (actual array / object contents) of current DataStore to the DataStore with given ID. */
       void copyContentsTo(const std::string& id, const std::vector<std::string>& entrylist_event = {});
       /** merge contents (actual array / object contents) of current DataStore to the DataStore with given ID. */
       void mergeContentsTo(const std::string& id, const std::vector<std::string>& entrylist_event = {});
+      /** exchange contents of current DataStore with those of the DataStore with given ID. */
+      void swapContentsWith(const std::string& id, EDurability durability);
       /** creates new datastore with given id, copying the registered objects/arrays from the current one. */
       void createNewDataStoreID(const std::string& id);
       /** creates empty datastore with given id. */
       void createEmptyDataStoreID(const std::string& id);
     private:
+      /** Index of the current DataStore ID in m_entries. */
+      int currentIdx() const { return s_multiThreaded ? s_threadIdx : m_currentIdx; }
+      /** Slow path of getEntry(): search the StoreEntry map and remember the result in the handle table. */
+      StoreEntry* lookupEntry(int durability, int handle, const std::string& name);
+      /** Forget all cached handle -> StoreEntry pointers (needed whenever map entries are removed). */
+      void clearHandleTables(int durability);
+
       std::vector<DataStoreContents> m_entries; /**< wrapped DataStoreContents. */
+      /** Handle -> StoreEntry lookup tables for each entry in m_entries and each durability. Entries point into the maps in m_entries. */
+      std::vector<std::array<std::vector<StoreEntry*>, c_NDurabilityTypes>> m_handleTables;
       std::map<std::string, int> m_idToIndexMap; /**< Maps DataStore ID to index in m_entries. */
       std::string m_currentID = ""; /**< currently active DataStore ID. */
       int m_currentIdx = 0; /**< index of currently active DataStore. */
+      static thread_local std::string s_threadID; /**< DataStore ID of the calling thread, used instead of m_currentID in multithreaded mode. */
+      static thread_local int s_threadIdx; /**< index of s_threadID, used instead of m_currentIdx in multithreaded mode. */
     };
     /** Maps (name, durability) key to StoreEntry objects. */
     SwitchableDataStoreContents m_storeEntryMap;
 
+    /** Interned entry names, maps name to handle. Only grows during the lifetime of the process. */
+    std::unordered_map<std::string, int> m_nameToHandle;
+
+    /** Interned entry names, indexed by handle. A deque, so references stay valid when names are added. */
+    std::deque<std::string> m_handleNames;
+
+    /** Protects m_nameToHandle and m_handleNames in multithreaded mode. */
+    mutable std::shared_mutex m_handleMutex;
+
+    /** See setMultiThreaded(). */
+    static bool s_multiThreaded;
+
+    /** Functions called at the end of each event, with their owner. See addEndOfEventCallback(). */
+    std::vector<std::pair<const void*, std::function<void()>>> m_endOfEventCallbacks;
+
 
     /** True if modules are currently being initialized.
      *
@@ -149,7 +149,7 @@ namespace Belle2 {
     bool create(bool replace = false)
     {
       bool result = DataStore::Instance().createObject(0, replace, *this);
-      m_relations = reinterpret_cast<RelationContainer**>(DataStore::Instance().getObject(*this));
+      attach();
       if (result) {
         (*m_relations)->setFromName(m_accessorFrom.first);
         (*m_relations)->setFromDurability(m_accessorFrom.second);
@@ -408,10 +408,13 @@ namespace Belle2 {
     /** Attach to relation, if necessary. */
     void ensureAttached() const
     {
-      if (m_relations)
+      if (m_relations) {
+        //the input module might only read the relation now
+        m_storeEntry->ensureLoaded();
         return;
+      }
 
-      const_cast<RelationArray*>(this)->m_relations = reinterpret_cast<RelationContainer**>(DataStore::Instance().getObject(*this));
+      const_cast<RelationArray*>(this)->attach();
       if (m_relations && *m_relations && !(*m_relations)->isDefaultConstructed()) {
         AccessorParams fromAccessorRel((*m_relations)->getFromName(), (DataStore::EDurability)(*m_relations)->getFromDurability());
         AccessorParams toAccessorRel((*m_relations)->getToName(), (DataStore::EDurability)(*m_relations)->getToDurability());
@@ -428,6 +431,13 @@ namespace Belle2 {
       }
     }
 
+    /** Set m_storeEntry and m_relations to the entry in the DataStore (or nullptr). */
+    void attach()
+    {
+      m_storeEntry = DataStore::Instance().getEntry(*this);
+      m_relations = m_storeEntry ? reinterpret_cast<RelationContainer**>(&m_storeEntry->ptr) : nullptr;
+    }
+
     /** check that pointer exits, otherwise bail out. */
     void assertValid() const { if (!isValid()) B2FATAL("RelationArray does not point to valid StoreObject"); }
 
@@ -453,6 +463,9 @@ namespace Belle2 {
     /** Pointer that actually holds the relations. */
     RelationContainer** m_relations;
 
+    /** DataStore entry of the relations, set together with m_relations. */
+    DataStore::StoreEntry* m_storeEntry{nullptr};
+
     template<class FROM, class TO> friend class RelationIndex;
     template<class FROM, class TO> friend class RelationIndexContainer;
 
@@ -62,6 +62,11 @@ namespace Belle2 {
       }
       \endcode
    *
+   *  The returned ranges and element pointers are only valid until a relation
+   *  of the same type is added (e.g. with RelationsObject::addRelationTo()), so
+   *  do not add such relations while looping over a range. Debug builds abort
+   *  with a B2FATAL if a range is used after that.
+   *
    *  The documentation of the relation element type used by getFirstElementTo()/
    *  getFirstElementFrom() or during the for loop can be found in
    *  RelationIndexContainer<FROM, TO>::Element.
@@ -74,24 +79,15 @@ namespace Belle2 {
     /** Struct representing a single element in the index. */
     typedef typename RelationIndexContainer<FROM, TO>::Element Element;
 
-    /** Class representing a the index on the relation. */
-    typedef typename RelationIndexContainer<FROM, TO>::ElementIndex ElementIndex;
-
-    /** Typedef for easy access to the from side of the index. */
-    typedef typename ElementIndex::template nth_index<0>::type index_from;
-
-    /** Typedef for easy access to the to side of the index. */
-    typedef typename ElementIndex::template nth_index<1>::type index_to;
-
     /** Element iterator of the from side index.
      *
      * @note Both iterator_from and iterator_to point to objects of type Element,
      *       but reflect the structure of the underlying index.
      * */
-    typedef typename index_from::const_iterator iterator_from;
+    typedef typename RelationIndexContainer<FROM, TO>::const_iterator iterator_from;
 
     /** Element iterator of the to side index. */
-    typedef typename index_to::const_iterator iterator_to;
+    typedef typename RelationIndexContainer<FROM, TO>::const_iterator iterator_to;
 
     /** Iterator range [first,second) of the from side. */
     typedef boost::iterator_range<iterator_from> range_from;
@@ -108,9 +104,7 @@ namespace Belle2 {
      */
     explicit RelationIndex(const std::string& name = (DataStore::defaultRelationName<FROM, TO>()),
                            DataStore::EDurability durability = DataStore::c_Event):
-      m_index(RelationIndexManager::Instance().get<FROM, TO>(RelationArray(name, durability))),
-      m_from(m_index->index().template get<0>()),
-      m_to(m_index->index().template get<1>()) {}
+      m_index(RelationIndexManager::Instance().get<FROM, TO>(RelationArray(name, durability))) {}
 
     /** Constructor with checks.
      *
@@ -126,9 +120,7 @@ namespace Belle2 {
      */
     RelationIndex(const StoreArray<FROM>& from, const StoreArray<TO>& to, const std::string& name = "",
                   DataStore::EDurability durability = DataStore::c_Event):
-      m_index(RelationIndexManager::Instance().get<FROM, TO>(RelationArray(from, to, name, durability))),
-      m_from(m_index->index().template get<0>()),
-      m_to(m_index->index().template get<1>()) {}
+      m_index(RelationIndexManager::Instance().get<FROM, TO>(RelationArray(from, to, name, durability))) {}
 
     /** check if index is based on valid relation. */
     operator bool() const { return *(m_index.get()); }
@@ -136,53 +128,58 @@ namespace Belle2 {
     /** Return a range of all elements pointing from the given object.
      *
      *  Can be used with range-based for, see RelationIndex class
-     *  documentation for an example.
+     *  documentation for an example. The range is invalidated when a
+     *  relation of the same type is added.
      *
      *  @param   from Pointer for which to get the relation.
      *  @returns Iterator range [first,second) of
      *           elements which point from this object.
      */
-    range_from getElementsFrom(const FROM* from) const { return m_from.equal_range(from); }
+    range_from getElementsFrom(const FROM* from) const { return m_index->getElementsFrom(from); }
 
     /** Return a range of all elements pointing from the given object.
      *
      *  Can be used with range-based for, see RelationIndex class
-     *  documentation for an example.
+     *  documentation for an example. The range is invalidated when a
+     *  relation of the same type is added.
      *
      *  @param from Reference for which to get the relation
      *  @returns Iterator range [first,second) of
      *           elements which point from this object
      */
-    range_from getElementsFrom(const FROM& from) const { return m_from.equal_range(&from); }
+    range_from getElementsFrom(const FROM& from) const { return m_index->getElementsFrom(&from); }
 
     /** Return a range of all elements pointing to the given object.
      *
      *  Can be used with range-based for, see RelationIndex class
-     *  documentation for an example.
+     *  documentation for an example. The range is invalidated when a
+     *  relation of the same type is added.
      *
      *  @param to Pointer for which to get the relation
      *  @returns Iterator range [first,second) of
      *           elements which point to this object
      */
-    range_to getElementsTo(const TO* to) const { return m_to.equal_range(to); }
+    range_to getElementsTo(const TO* to) const { return m_index->getElementsTo(to); }
 
     /** Return a range of all elements pointing to the given object.
      *
      *  Can be used with range-based for, see RelationIndex class
-     *  documentation for an example.
+     *  documentation for an example. The range is invalidated when a
+     *  relation of the same type is added.
      *
      *  @param to Reference for which to get the relation
      *  @returns Iterator range [first,second) of
      *           elements which point to this object
      */
-    range_to getElementsTo(const TO& to) const { return m_to.equal_range(&to); }
+    range_to getElementsTo(const TO& to) const { return m_index->getElementsTo(&to); }
 
     /** Return a pointer to the first relation Element of the given object.
      *
      *  Useful if there is at most one relation
      *  @param from Reference for which to get the Relation
      *  @returns Pointer to the RelationIndex<FROM,TO>::Element, can be
-     *           NULL if no relation exists
+     *           NULL if no relation exists. It is invalidated when a
+     *           relation of the same type is added.
      */
     const Element* getFirstElementFrom(const FROM& from) const { return getFirstElementFrom(&from); }
 
@@ -191,21 +188,18 @@ namespace Belle2 {
      *  Useful if there is at most one relation
      *  @param from Pointer for which to get the Relation
      *  @returns Pointer to the RelationIndex<FROM,TO>::Element, can be
-     *           NULL if no relation exists
+     *           NULL if no relation exists. It is invalidated when a
+     *           relation of the same type is added.
      */
-    const Element* getFirstElementFrom(const FROM* from) const
-    {
-      iterator_from it = m_from.find(from);
-      if (it == m_from.end()) return 0;
-      return &(*it);
-    }
+    const Element* getFirstElementFrom(const FROM* from) const { return m_index->getFirstElementFrom(from); }
 
     /** Return a pointer to the first relation Element of the given object.
      *
      *  Useful if there is at most one relation
      *  @param to Reference for which to get the Relation
      *  @returns Pointer to the RelationIndex<FROM,TO>::Element, can be
-     *           NULL if no relation exists
+     *           NULL if no relation exists. It is invalidated when a
+     *           relation of the same type is added.
      */
     const Element* getFirstElementTo(const TO& to) const { return getFirstElementTo(&to); }
 
@@ -214,14 +208,10 @@ namespace Belle2 {
      *  Useful if there is at most one relation
      *  @param to Pointer for which to get the Relation
      *  @returns Pointer to the RelationIndex<FROM,TO>::Element, can be
-     *           NULL if no relation exists
+     *           NULL if no relation exists. It is invalidated when a
+     *           relation of the same type is added.
      */
-    const Element* getFirstElementTo(const TO* to) const
-    {
-      iterator_to it = m_to.find(to);
-      if (it == m_to.end()) return 0;
-      return &(*it);
-    }
+    const Element* getFirstElementTo(const TO* to) const { return m_index->getFirstElementTo(to); }
 
     /** Get the AccessorParams of the underlying relation. */
     AccessorParams getAccessorParams()     const { return m_index->getAccessorParams(); }
@@ -233,16 +223,10 @@ namespace Belle2 {
     const AccessorParams& getToAccessorParams()   const { return m_index->getToAccessorParams(); }
 
     /** Get the size of the index. */
-    size_t size() const { return m_index->index().size(); }
+    size_t size() const { return m_index->size(); }
   protected:
     /** Reference to the IndexContainer. */
     const std::shared_ptr<RelationIndexContainer<FROM, TO>> m_index;
-
-    /** Reference to the from index. */
-    const index_from& m_from;
-
-    /** Reference to the to index. */
-    const index_to& m_to;
   };
 
 } // end namespace Belle2
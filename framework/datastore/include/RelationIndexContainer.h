@@ -11,9 +11,12 @@
 #include <framework/datastore/StoreArray.h>
 #include <framework/datastore/RelationArray.h>
 
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/member.hpp>
+#include <boost/iterator/iterator_adaptor.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
 
 namespace Belle2 {
 
@@ -41,6 +44,26 @@ namespace Belle2 {
    *  or adding Relations. All instances of this class will be managed and
    *  created by the RelationIndexManager.
    *
+   *  The index keeps all elements twice in contiguous memory, once sorted by
+   *  the from-side pointer and once by the to-side pointer, so lookups are a
+   *  binary search returning a contiguous range. Elements are only sorted when
+   *  a side is first queried after the index was (re)built or extended, and
+   *  all buffers keep their capacity when the index is cleared at the end of
+   *  an event, so no memory is allocated once the buffers have grown to the
+   *  typical event size.
+   *
+   *  \warning Unlike with the previous node based container, ranges and Element
+   *  pointers returned by the lookups are only valid until the index is changed:
+   *  a later add() (e.g. by DataStore::addRelation() for the same relation), a
+   *  rebuild, or the first lookup of a side after such a change, which sorts the
+   *  new elements in, can move all elements. Copy what is needed before adding
+   *  relations of the same type while iterating over a range.
+   *
+   *  If RELATIONINDEX_CHECK_ITERATORS is defined (in debug builds), each side of
+   *  the index counts its changes and the iterators of the ranges check on every
+   *  access that their side did not change since the lookup, otherwise they abort
+   *  with a B2FATAL. Element pointers are not checked.
+   *
    *  This class is only used internally, users should use RelationsObject/RelationsInterface to access/add relations.
    */
   template<class FROM, class TO> class RelationIndexContainer: public RelationIndexBase {
@@ -49,6 +72,9 @@ namespace Belle2 {
     /** Element type for the index. */
     struct Element {
 
+      /** Create an empty element. */
+      Element(): indexFrom(0), indexTo(0), from(nullptr), to(nullptr), weight(0) {}
+
       /** Create a new element. */
       Element(RelationElement::index_type indexFrom_,  RelationElement::index_type indexTo_,
               const FROM* from_, const TO* to_,  RelationElement::weight_type weight_):
@@ -70,29 +96,95 @@ namespace Belle2 {
       RelationElement::weight_type weight;
     };
 
-    /** Boost MultiIndex container to keep the bidirectional index.
-     *
-     *  All the heavy lifting is done by this class
-     */
-    typedef boost::multi_index::multi_index_container <
-    Element,
-    boost::multi_index::indexed_by <
-    boost::multi_index::ordered_non_unique <
-    boost::multi_index::member<Element, const FROM*, &Element::from>
-    >,
-    boost::multi_index::ordered_non_unique <
-    boost::multi_index::member<Element, const TO*, &Element::to>
-    >
-    >
-    > ElementIndex;
+    /** Contiguous storage of the index elements. */
+    typedef std::vector<Element> ElementVector;
+
+#ifdef RELATIONINDEX_CHECK_ITERATORS
+    /** Iterator over the elements of one side of the index, checks on access that the side was not changed. */
+    class const_iterator: public boost::iterator_adaptor<const_iterator, typename ElementVector::const_iterator> {
+    public:
+      /** Create an iterator which is not bound to an index. */
+      const_iterator() = default;
+
+      /** Create an iterator for the side of the index with the given change counter. */
+      const_iterator(typename ElementVector::const_iterator it, const unsigned int* generation):
+        const_iterator::iterator_adaptor_(it), m_generation(generation), m_expected(*generation) {}
+
+    private:
+      /** Allow boost to access dereference(). */
+      friend class boost::iterator_core_access;
+
+      /** Return the element, abort if the index was changed since the iterator was created. */
+      const Element& dereference() const
+      {
+        if (m_generation and *m_generation != m_expected)
+          B2FATAL("RelationIndex range used after the index was changed. Copy the elements before adding relations of the same type.");
+        return *this->base_reference();
+      }
+
+      /** Change counter of the side of the index. */
+      const unsigned int* m_generation = nullptr;
+
+      /** Value of the change counter when the iterator was created. */
+      unsigned int m_expected = 0;
+    };
+#else
+    /** Iterator over the elements of one side of the index. */
+    typedef typename ElementVector::const_iterator const_iterator;
+#endif
+
+    /** Iterator range [first,second) of elements. */
+    typedef boost::iterator_range<const_iterator> range;
 
     /** Returns true if relation is valid */
     operator bool() const { return m_valid; }
 
-    /** Get the index. */
-    const ElementIndex&  index() const { return m_index; }
-    /** Get the index. */
-    ElementIndex&  index() { return m_index; }
+    /** Return the range of all elements pointing from the given object.
+     *  The range is invalidated by any change of the index, see class documentation. */
+    range getElementsFrom(const FROM* from) const
+    {
+      sortPending(m_byFrom, m_nSortedFrom, m_generationFrom, CompareFrom());
+      const auto& result = std::equal_range(m_byFrom.cbegin(), m_byFrom.cend(), from, CompareFrom());
+      return makeRange(result.first, result.second, m_generationFrom);
+    }
+
+    /** Return the range of all elements pointing to the given object.
+     *  The range is invalidated by any change of the index, see class documentation. */
+    range getElementsTo(const TO* to) const
+    {
+      sortPending(m_byTo, m_nSortedTo, m_generationTo, CompareTo());
+      const auto& result = std::equal_range(m_byTo.cbegin(), m_byTo.cend(), to, CompareTo());
+      return makeRange(result.first, result.second, m_generationTo);
+    }
+
+    /** Return a pointer to the first element pointing from the given object, or nullptr if there is none.
+     *  The pointer is invalidated by any change of the index, see class documentation. */
+    const Element* getFirstElementFrom(const FROM* from) const
+    {
+      const range& elements = getElementsFrom(from);
+      return elements.empty() ? nullptr : &elements.front();
+    }
+
+    /** Return a pointer to the first element pointing to the given object, or nullptr if there is none.
+     *  The pointer is invalidated by any change of the index, see class documentation. */
+    const Element* getFirstElementTo(const TO* to) const
+    {
+      const range& elements = getElementsTo(to);
+      return elements.empty() ? nullptr : &elements.front();
+    }
+
+    /** Get the number of elements in the index. */
+    size_t size() const { return m_byFrom.size(); }
+
+    /** Add a single element to an existing index, e.g. after a relation was added (avoids rebuilding the index).
+     *  This invalidates all ranges and element pointers previously returned by the lookups. */
+    void add(const Element& element)
+    {
+      m_byFrom.push_back(element);
+      m_byTo.push_back(element);
+      ++m_generationFrom;
+      ++m_generationTo;
+    }
 
     /** Get the AccessorParams of the underlying relation. */
     AccessorParams getAccessorParams() const { return m_storeRel.getAccessorParams(); }
@@ -104,6 +196,26 @@ namespace Belle2 {
     const AccessorParams& getToAccessorParams()   const { return m_storeTo; }
 
   protected:
+    /** Orders elements (and from-side pointers) by their from-side pointer. */
+    struct CompareFrom {
+      /** compare two elements */
+      bool operator()(const Element& a, const Element& b) const { return std::less<const FROM*>()(a.from, b.from); }
+      /** compare element and pointer */
+      bool operator()(const Element& a, const FROM* b) const { return std::less<const FROM*>()(a.from, b); }
+      /** compare pointer and element */
+      bool operator()(const FROM* a, const Element& b) const { return std::less<const FROM*>()(a, b.from); }
+    };
+
+    /** Orders elements (and to-side pointers) by their to-side pointer. */
+    struct CompareTo {
+      /** compare two elements */
+      bool operator()(const Element& a, const Element& b) const { return std::less<const TO*>()(a.to, b.to); }
+      /** compare element and pointer */
+      bool operator()(const Element& a, const TO* b) const { return std::less<const TO*>()(a.to, b); }
+      /** compare pointer and element */
+      bool operator()(const TO* a, const Element& b) const { return std::less<const TO*>()(a, b.to); }
+    };
+
     /** Constructor to create a new IndexContainer.
      *
      *  @param relArray RelationArray to build the relation for
@@ -126,11 +238,103 @@ namespace Belle2 {
      */
     void rebuild(bool force = false);
 
-    /** Clear the index (at the end of an event) */
-    virtual void clear() override { m_index.clear(); }
+    /** Clear the index (at the end of an event), keeping the allocated memory. */
+    virtual void clear() override
+    {
+      m_byFrom.clear();
+      m_byTo.clear();
+      m_nSortedFrom = 0;
+      m_nSortedTo = 0;
+      ++m_generationFrom;
+      ++m_generationTo;
+    }
+
+    /** Create the range of the given side of the index. */
+    static range makeRange(typename ElementVector::const_iterator first, typename ElementVector::const_iterator second,
+                           const unsigned int& generation)
+    {
+#ifdef RELATIONINDEX_CHECK_ITERATORS
+      return range(const_iterator(first, &generation), const_iterator(second, &generation));
+#else
+      (void)generation;
+      return range(first, second);
+#endif
+    }
+
+    /** Sort the elements added after the first nSorted ones into the sorted part.
+     *
+     *  Sorting is stable, so elements with the same key keep the order in which
+     *  they were added, like in the RelationArray. The change counter of the
+     *  side is increased if elements are moved.
+     */
+    template<class Compare> void sortPending(ElementVector& elements, size_t& nSorted, unsigned int& generation,
+                                             Compare compare) const
+    {
+      const size_t nElements = elements.size();
+      if (nSorted == nElements)
+        return;
+      ++generation;
+
+      const auto& begin = elements.begin();
+      stableSort(elements, nSorted, compare);
+      //elements appended in order don't need to be merged
+      if (nSorted > 0 and compare(begin[nSorted], begin[nSorted - 1])) {
+        m_buffer.resize(nElements);
+        std::merge(begin, begin + nSorted, begin + nSorted, elements.end(), m_buffer.begin(), compare);
+        std::copy(m_buffer.begin(), m_buffer.begin() + nElements, begin);
+      }
+      nSorted = nElements;
+    }
+
+    /** Stable sort of elements[first, end), using m_buffer as scratch space (bottom-up merge sort). */
+    template<class Compare> void stableSort(ElementVector& elements, size_t first, Compare compare) const
+    {
+      const auto& begin = elements.begin();
+      const size_t nElements = elements.size();
+      if (std::is_sorted(begin + first, elements.end(), compare))
+        return;
+
+      //insertion sort for short runs
+      const size_t runLength = 16;
+      for (size_t lo = first; lo < nElements; lo += runLength) {
+        const auto& runEnd = begin + std::min(lo + runLength, nElements);
+        for (auto it = begin + lo + 1; it < runEnd; ++it) {
+          std::rotate(std::upper_bound(begin + lo, it, *it, compare), it, it + 1);
+        }
+      }
+
+      //merge runs of increasing length
+      m_buffer.resize(nElements);
+      for (size_t width = runLength; width < nElements - first; width *= 2) {
+        for (size_t lo = first; lo < nElements; lo += 2 * width) {
+          const size_t mid = std::min(lo + width, nElements);
+          const size_t hi = std::min(lo + 2 * width, nElements);
+          std::merge(begin + lo, begin + mid, begin + mid, begin + hi, m_buffer.begin() + lo, compare);
+        }
+        std::copy(m_buffer.begin() + first, m_buffer.begin() + nElements, begin + first);
+      }
+    }
+
+    /** Index elements sorted by from-side pointer (up to m_nSortedFrom, rest in insertion order). */
+    mutable ElementVector m_byFrom;
+
+    /** Index elements sorted by to-side pointer (up to m_nSortedTo, rest in insertion order). */
+    mutable ElementVector m_byTo;
+
+    /** Scratch space for sorting. */
+    mutable ElementVector m_buffer;
+
+    /** Number of elements at the beginning of m_byFrom which are already sorted. */
+    mutable size_t m_nSortedFrom = 0;
+
+    /** Number of elements at the beginning of m_byTo which are already sorted. */
+    mutable size_t m_nSortedTo = 0;
+
+    /** Number of changes of m_byFrom, checked by the iterators if RELATIONINDEX_CHECK_ITERATORS is defined. */
+    mutable unsigned int m_generationFrom = 0;
 
-    /** Instance of the index. */
-    ElementIndex m_index;
+    /** Number of changes of m_byTo, checked by the iterators if RELATIONINDEX_CHECK_ITERATORS is defined. */
+    mutable unsigned int m_generationTo = 0;
 
     /** the underlying relation. */
     RelationArray m_storeRel;
@@ -154,7 +358,7 @@ namespace Belle2 {
     m_valid = m_storeRel.isValid();
     if (!m_valid) {
       B2DEBUG(100, "Relation " << m_storeRel.getName() << " does not exist, cannot build index");
-      m_index.clear();
+      clear();
       m_storeFrom = AccessorParams();
       m_storeTo = AccessorParams();
       return;
@@ -169,7 +373,7 @@ namespace Belle2 {
     //Reset modification flag
     m_storeRel.setModified(false);
 
-    m_index.clear();
+    clear();
 
     //Get related StoreArrays
     m_storeFrom = m_storeRel.getFromAccessorParams();
@@ -201,9 +405,11 @@ namespace Belle2 {
         if (idxTo >= nTo)
           B2FATAL("Relation " <<  m_storeRel.getName() << " is inconsistent: to-index (" << idxTo << ") out of range");
         const TO* to = storeTo[idxTo];
-        m_index.insert(Element(idxFrom, idxTo, from, to, *itWgt));
+        m_byFrom.emplace_back(idxFrom, idxTo, from, to, *itWgt);
       }
     }
+    //both sides are sorted lazily on first access
+    m_byTo = m_byFrom;
   }
 
 } // end namespace Belle2
@@ -25,7 +25,7 @@ namespace Belle2 {
    */
   class RelationIndexManager {
   public:
-    /** Returns the singleton instance. */
+    /** Returns the singleton instance (one per thread). */
     static RelationIndexManager& Instance();
 
     /** Get a RelationIndexContainer.
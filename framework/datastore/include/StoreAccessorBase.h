@@ -31,7 +31,7 @@ namespace Belle2 {
      *  @param isArray    true if the entry in the DataStore is an array
      */
     StoreAccessorBase(const std::string& name, DataStore::EDurability durability, TClass* objClass, bool isArray):
-      m_name(name), m_durability(durability), m_class(objClass), m_isArray(isArray) {}
+      m_name(name), m_durability(durability), m_class(objClass), m_isArray(isArray), m_nameHandle(DataStore::c_InvalidNameHandle) {}
 
     /** Destructor.
      *
@@ -47,6 +47,7 @@ namespace Belle2 {
      */
     bool registerInDataStore(DataStore::EStoreFlags storeFlags = DataStore::c_WriteOut)
     {
+      getNameHandle();
       return DataStore::Instance().registerEntry(m_name, m_durability, getClass(), isArray(), storeFlags);
     }
 
@@ -60,7 +61,8 @@ namespace Belle2 {
     bool registerInDataStore(const std::string& name, DataStore::EStoreFlags storeFlags = DataStore::c_WriteOut)
     {
       if (!name.empty())
-        m_name = name;
+        setName(name);
+      getNameHandle();
       return DataStore::Instance().registerEntry(m_name, m_durability, getClass(), isArray(), storeFlags);
     }
 
@@ -74,7 +76,8 @@ namespace Belle2 {
     bool isRequired(const std::string& name = "")
     {
       if (!name.empty())
-        m_name = name;
+        setName(name);
+      getNameHandle();
       return DataStore::Instance().requireInput(*this);
     }
 
@@ -89,7 +92,8 @@ namespace Belle2 {
     bool isOptional(const std::string& name = "")
     {
       if (!name.empty())
-        m_name = name;
+        setName(name);
+      getNameHandle();
       return DataStore::Instance().optionalInput(*this);
     }
 
@@ -123,6 +127,17 @@ namespace Belle2 {
     /** Return name under which the object is saved in the DataStore. */
     const std::string& getName() const { return m_name; }
 
+    /** Return the interned handle of getName(), see DataStore::getNameHandle(). Resolved on first use.
+     *
+     * In multithreaded mode, several threads resolving it at the same time all store the same value.
+     */
+    int getNameHandle() const
+    {
+      if (m_nameHandle == DataStore::c_InvalidNameHandle)
+        m_nameHandle = DataStore::Instance().getNameHandle(m_name);
+      return m_nameHandle;
+    }
+
     /** Return durability with which the object is saved in the DataStore. */
     DataStore::EDurability getDurability() const { return m_durability; }
 
@@ -158,6 +173,13 @@ namespace Belle2 {
     std::string readableName() const;
 
   protected:
+    /** Change the name under which this object/array is saved, invalidating the cached name handle. */
+    void setName(const std::string& name)
+    {
+      m_name = name;
+      m_nameHandle = DataStore::c_InvalidNameHandle;
+    }
+
     /** Store name under which this object/array is saved. */
     std::string m_name;
 
@@ -170,5 +192,8 @@ namespace Belle2 {
     /** Is this an accessor for an array? */
     bool m_isArray;
 
+    /** Cached handle of m_name in the DataStore name registry, or DataStore::c_InvalidNameHandle if not resolved yet. */
+    mutable int m_nameHandle;
+
   };
 }
@@ -120,7 +120,7 @@ namespace Belle2 {
      *  @param durability Decides durability map used for getting the accessed array.
      */
     explicit StoreArray(const std::string& name = "", DataStore::EDurability durability = DataStore::c_Event):
-      StoreAccessorBase(DataStore::arrayName<T>(name), durability, T::Class(), true), m_storeArray(0) {}
+      StoreAccessorBase(DataStore::arrayName<T>(name), durability, T::Class(), true), m_storeEntry(nullptr) {}
 
 
     /** Register a relation to the given StoreArray.
@@ -203,13 +203,17 @@ namespace Belle2 {
     void clear() override
     {
       if (getEntries() != 0) {
-        (*m_storeArray)->Delete();
+        (*ensureAttached())->Delete();
         _StoreArrayImpl::clearRelations(*this);
       }
     }
 
     /** Get the number of objects in the array. */
-    inline int getEntries() const { return isCreated() ? ((*m_storeArray)->GetEntriesFast()) : 0;}
+    inline int getEntries() const
+    {
+      TClonesArray** array = ensureAttached();
+      return (array && *array) ? (*array)->GetEntriesFast() : 0;
+    }
 
     /** Access to the stored objects.
      *
@@ -223,9 +227,8 @@ namespace Belle2 {
      */
     inline T* operator [](int i) const
     {
-      ensureCreated();
       //At() checks for out-of-range and returns NULL in that case
-      TObject* obj = (*m_storeArray)->At(i);
+      TObject* obj = ensureCreated()->At(i);
       if (obj == nullptr)
         throw std::out_of_range("Out-of-range access in StoreArray::operator[], for " + readableName() + ", index " + std::to_string(i));
       return static_cast<T*>(obj); //type was checked by DataStore, so the cast is safe.
@@ -283,8 +286,7 @@ namespace Belle2 {
      **/
     inline bool isValid() const
     {
-      ensureAttached();
-      return m_storeArray;
+      return ensureAttached();
     }
 
     /** Check whether the array was registered.
@@ -306,19 +308,18 @@ namespace Belle2 {
      */
     TClonesArray* getPtr() const
     {
-      ensureCreated();
-      return (m_storeArray ? *m_storeArray : nullptr);
+      return ensureCreated();
     }
 
     /** Return iterator to first entry. */
-    iterator begin() { ensureAttached(); return iterator(m_storeArray); }
+    iterator begin() { return iterator(ensureAttached()); }
     /** Return iterator to last entry +1. */
-    iterator end() { ensureAttached(); return iterator(m_storeArray, true); }
+    iterator end() { return iterator(ensureAttached(), true); }
 
     /** Return const_iterator to first entry. */
-    const_iterator begin() const { ensureAttached(); return const_iterator(m_storeArray); }
+    const_iterator begin() const { return const_iterator(ensureAttached()); }
     /** Return const_iterator to last entry +1. */
-    const_iterator end() const { ensureAttached(); return const_iterator(m_storeArray, true); }
+    const_iterator end() const { return const_iterator(ensureAttached(), true); }
 
   private:
     /** Creating StoreArrays is unnecessary, only used internally. */
@@ -330,38 +331,53 @@ namespace Belle2 {
      */
     inline T* nextFreeAdress()
     {
-      ensureCreated();
-      return static_cast<T*>((*m_storeArray)->AddrAt(getEntries()));
+      TClonesArray* array = ensureCreated();
+      return static_cast<T*>(array->AddrAt(array->GetEntriesFast()));
     }
 
-    /** Ensure that this object is attached. */
-    inline void ensureAttached() const
+    /** Ensure that this object is attached, returns pointer to the TClonesArray pointer in the DataStore (or nullptr).
+     *
+     * In multithreaded mode (see DataStore::setMultiThreaded()) the entry is looked up every time,
+     * as every thread has its own DataStore contents.
+     */
+    inline TClonesArray** ensureAttached() const
     {
-      if (!m_storeArray) {
-        const_cast<StoreArray*>(this)->m_storeArray = reinterpret_cast<TClonesArray**>(DataStore::Instance().getObject(*this));
+      DataStore::StoreEntry* entry = m_storeEntry;
+      if (DataStore::isMultiThreaded()) {
+        entry = DataStore::Instance().getEntry(*this);
+      } else if (!entry) {
+        entry = const_cast<StoreArray*>(this)->m_storeEntry = DataStore::Instance().getEntry(*this);
       }
+      if (!entry)
+        return nullptr;
+      //the input module might only read the array now
+      entry->ensureLoaded();
+      return reinterpret_cast<TClonesArray**>(&entry->ptr);
     }
-    /** Ensure that the array has been created.
+    /** Ensure that the array has been created, returns it.
      *
      * Called automatically by write operations.
      */
-    inline void ensureCreated() const
+    inline TClonesArray* ensureCreated() const
     {
-      if (!isCreated()) {
+      TClonesArray** array = ensureAttached();
+      if (!array || !*array) {
         if (!const_cast<StoreArray*>(this)->create())
           throw std::runtime_error("Write access to " + readableName() + " failed, did you remember to call registerInDataStore()?");
+        array = ensureAttached();
       }
+      return *array;
     }
 
     /** Check whether the array object was created.  **/
     inline bool isCreated() const
     {
-      ensureAttached();
-      return m_storeArray && *m_storeArray;
+      TClonesArray** array = ensureAttached();
+      return array && *array;
     }
 
-    /** Pointer that actually holds the TClonesArray. */
-    TClonesArray** m_storeArray;
+    /** DataStore entry that actually holds the TClonesArray. */
+    DataStore::StoreEntry* m_storeEntry;
 
   };
 } // end namespace Belle2
@@ -14,9 +14,25 @@ class TClass;
 class TClonesArray;
 
 namespace Belle2 {
+  struct StoreEntry;
+
+  /** Interface for input modules which only read the object of a StoreEntry once it is accessed.
+   *
+   * The input module sets StoreEntry::loader for the entries it didn't read yet, the first
+   * access through the DataStore or one of the accessors calls load() which has to read the
+   * object, set StoreEntry::ptr as usual and reset StoreEntry::loader to nullptr.
+   */
+  class StoreEntryLoader {
+  public:
+    /** Virtual destructor for base class */
+    virtual ~StoreEntryLoader() = default;
+    /** Read the object of the given entry for the current event. */
+    virtual void load(StoreEntry& entry) = 0;
+  };
+
   /** Wraps a stored array/object, stored under unique (name, durability) key. See DataStore::m_storeEntryMap. */
   struct StoreEntry {
-    StoreEntry() : isArray(false), dontWriteOut(false), objClass(nullptr), object(nullptr), ptr(nullptr), name() {};
+    StoreEntry() : isArray(false), dontWriteOut(false), objClass(nullptr), object(nullptr), ptr(nullptr), name(), loader(nullptr) {};
 
     /** useful constructor, creates 'object', but leaves 'ptr' NULL. */
     StoreEntry(bool isArray, TClass* cl, std::string  name, bool dontWriteOut);
@@ -31,6 +47,8 @@ namespace Belle2 {
     void recreate();
     /** Return ptr cast to TClonesArray. If this is not an array, return null. */
     TClonesArray* getPtrAsArray() const;
+    /** Make sure the object of the current event was read if an input module only reads it on first access. */
+    void ensureLoaded() { if (loader) loader->load(*this); }
 
     bool isArray;     /**< Flag that indicates whether the object is a TClonesArray **/
     bool dontWriteOut; /**< Flag that indicates whether the object should be written to the output by default **/
@@ -47,5 +65,12 @@ namespace Belle2 {
     TObject* ptr;
 
     std::string name; /**< Name of the entry. Equal to the key in the map. **/
+
+    /** If not null, the object of the current event was not read yet and 'ptr' is null until ensureLoaded() is called.
+     *
+     * Code accessing 'object' or 'ptr' directly (instead of using the DataStore or one of the accessors)
+     * has to call ensureLoaded() first.
+     */
+    StoreEntryLoader* loader;
   };
 }
@@ -97,13 +97,13 @@ namespace Belle2 {
      *  @param durability Decides durability map used for getting the accessed object.
      */
     explicit StoreObjPtr(const std::string& name = "", DataStore::EDurability durability = DataStore::c_Event):
-      StoreAccessorBase(DataStore::objectName<T>(name), durability, T::Class(), false), m_storeObjPtr(0) {}
+      StoreAccessorBase(DataStore::objectName<T>(name), durability, T::Class(), false), m_storeEntry(nullptr) {}
 
     /** Check whether the object was created.
      *
      *  @return          True if the object exists.
      **/
-    inline bool isValid() const {ensureAttached(); return m_storeObjPtr && *m_storeObjPtr;}
+    inline bool isValid() const { TObject** ptr = ensureAttached(); return ptr && *ptr;}
 
     /** Construct an object of type T in this StoreObjPtr, using the provided constructor arguments.
      *
@@ -132,9 +132,9 @@ namespace Belle2 {
     //------------------------ Imitate pointer functionality -----------------------------------------------
     inline T& operator *()  const {return *operator->();}  /**< Imitate pointer functionality. */
 #ifdef __clang_analyzer__
-    inline T* operator ->() const {ensureValid(); assert(m_storeObjPtr); return static_cast<T*>(*m_storeObjPtr);}   /**< Imitate pointer functionality. */
+    inline T* operator ->() const {TObject** ptr = ensureValid(); assert(ptr); return static_cast<T*>(*ptr);}   /**< Imitate pointer functionality. */
 #else
-    inline T* operator ->() const {ensureValid(); return static_cast<T*>(*m_storeObjPtr);}   /**< Imitate pointer functionality. */
+    inline T* operator ->() const {return static_cast<T*>(*ensureValid());}   /**< Imitate pointer functionality. */
 #endif
     inline operator bool()  const {return isValid();}   /**< Imitate pointer functionality. */
 
@@ -146,22 +146,35 @@ namespace Belle2 {
     }
 
   private:
-    /** Ensure that this object is attached. */
-    inline void ensureAttached() const
+    /** Ensure that this object is attached, returns pointer to the object pointer in the DataStore (or nullptr).
+     *
+     * In multithreaded mode (see DataStore::setMultiThreaded()) the entry is looked up every time,
+     * as every thread has its own DataStore contents.
+     */
+    inline TObject** ensureAttached() const
     {
-      if (!m_storeObjPtr) {
-        const_cast<StoreObjPtr*>(this)->m_storeObjPtr = DataStore::Instance().getObject(*this);
+      DataStore::StoreEntry* entry = m_storeEntry;
+      if (DataStore::isMultiThreaded()) {
+        entry = DataStore::Instance().getEntry(*this);
+      } else if (!entry) {
+        entry = const_cast<StoreObjPtr*>(this)->m_storeEntry = DataStore::Instance().getEntry(*this);
       }
+      if (!entry)
+        return nullptr;
+      //the input module might only read the object now
+      entry->ensureLoaded();
+      return &entry->ptr;
     }
-    /** if accesses to this object would crash, throw an std::runtime_error */
-    inline void ensureValid() const
+    /** if accesses to this object would crash, throw an std::runtime_error. Otherwise returns ensureAttached(). */
+    inline TObject** ensureValid() const
     {
-      ensureAttached();
-      if (!m_storeObjPtr || !(*m_storeObjPtr))
+      TObject** ptr = ensureAttached();
+      if (!ptr || !(*ptr))
         throw std::runtime_error("Trying to access StoreObjPtr " + readableName() +
                                  ", which was not created. Please check isValid() before accesses if the object is not guaranteed to be created in every event.");
+      return ptr;
     }
-    /** Store of actual pointer. Don't make this a T** as this might cause problems with multiple inheritance objects */
-    TObject** m_storeObjPtr;
+    /** DataStore entry holding the actual pointer. We don't keep a T** as this might cause problems with multiple inheritance objects */
+    DataStore::StoreEntry* m_storeEntry;
   };
 } // end namespace Belle2
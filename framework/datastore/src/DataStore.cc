@@ -49,6 +49,9 @@ namespace {
 }
 
 bool DataStore::s_DoCleanup = false;
+bool DataStore::s_multiThreaded = false;
+thread_local std::string DataStore::SwitchableDataStoreContents::s_threadID = "";
+thread_local int DataStore::SwitchableDataStoreContents::s_threadIdx = 0;
 
 DataStore& DataStore::Instance()
 {
@@ -202,9 +205,9 @@ bool DataStore::registerEntry(const std::string& name, EDurability durability,
   m_dependencyMap->getCurrentModuleInfo().addEntry(name, DependencyMap::c_Output, (objClass == RelationContainer::Class()));
 
   // Check whether the map entry already exists
-  const auto& it = m_storeEntryMap[durability].find(name);
-  if (it != m_storeEntryMap[durability].end()) {
-    StoreEntry& entry = it->second;
+  StoreEntry* existingEntry = findEntry(name, durability);
+  if (existingEntry) {
+    StoreEntry& entry = *existingEntry;
 
     // Complain about existing entry
     if (storeFlags & c_ErrorIfAlreadyRegistered) {
@@ -284,23 +287,53 @@ bool DataStore::hasRelation(const StoreAccessorBase& fromArray, const StoreAcces
   const std::string& realname = relationName(fromArray.getName(), toArray.getName(), namedRelation);
 
   // check whether the map entry exists
-  const auto& it = m_storeEntryMap[durability].find(realname);
-  if (it != m_storeEntryMap[durability].end()) return true;
-
-  return false;
+  return findEntry(realname, durability) != nullptr;
 }
 
 DataStore::StoreEntry* DataStore::getEntry(const StoreAccessorBase& accessor)
 {
-  const auto& it = m_storeEntryMap[accessor.getDurability()].find(accessor.getName());
+  StoreEntry* entry = m_storeEntryMap.getEntry(accessor.getDurability(), accessor.getNameHandle(), accessor.getName());
 
-  if (it != m_storeEntryMap[accessor.getDurability()].end() and checkType((it->second), accessor)) {
-    return &(it->second);
+  if (entry and checkType(*entry, accessor)) {
+    entry->ensureLoaded();
+    return entry;
   } else {
     return nullptr;
   }
 }
 
+int DataStore::getNameHandle(const std::string& name)
+{
+  std::shared_lock<std::shared_mutex> readLock(m_handleMutex, std::defer_lock);
+  if (s_multiThreaded)
+    readLock.lock();
+  const auto& it = m_nameToHandle.find(name);
+  if (it != m_nameToHandle.end())
+    return it->second;
+
+  std::unique_lock<std::shared_mutex> writeLock(m_handleMutex, std::defer_lock);
+  if (s_multiThreaded) {
+    readLock.unlock();
+    writeLock.lock();
+    //someone else might have been faster
+    const auto& found = m_nameToHandle.find(name);
+    if (found != m_nameToHandle.end())
+      return found->second;
+  }
+  const int handle = m_handleNames.size();
+  m_handleNames.push_back(name);
+  m_nameToHandle.emplace(name, handle);
+  return handle;
+}
+
+const std::string& DataStore::getNameFromHandle(int handle) const
+{
+  std::shared_lock<std::shared_mutex> readLock(m_handleMutex, std::defer_lock);
+  if (s_multiThreaded)
+    readLock.lock();
+  return m_handleNames.at(handle);
+}
+
 
 TObject** DataStore::getObject(const StoreAccessorBase& accessor)
 {
@@ -405,6 +438,9 @@ bool DataStore::findStoreEntry(const TObject* object, DataStore::StoreEntry*& en
       index = relObj->m_cacheArrayIndex;
     }
   }
+  // in multithreaded mode, the cached entry might belong to the DataStore ID of another thread
+  if (s_multiThreaded && entry && m_storeEntryMap.getEntry(c_Event, getNameHandle(entry->name), entry->name) != entry)
+    entry = nullptr;
   // check whether the cached information is (still) valid
   if (entry && entry->ptr && (index >= 0)) {
     const TClonesArray* array = static_cast<TClonesArray*>(entry->ptr);
@@ -508,14 +544,14 @@ void DataStore::addRelation(const TObject* fromObject, StoreEntry*& fromEntry, i
 
   // get the relations from -> to
   const string& relationsName = relationName(fromEntry->name, toEntry->name, namedRelation);
-  const StoreEntryIter& it = m_storeEntryMap[c_Event].find(relationsName);
-  if (it == m_storeEntryMap[c_Event].end()) {
+  StoreEntry* entry = findEntry(relationsName, c_Event);
+  if (!entry) {
     B2FATAL("No relation '" << relationsName <<
             "' found. Please register it (using StoreArray::registerRelationTo()) before trying to add relations.");
   }
-  StoreEntry* entry = &(it->second);
 
   // auto create relations if needed (both if null pointer, or uninitialised object read from TTree)
+  entry->ensureLoaded();
   if (!entry->ptr)
     entry->recreate();
   auto* relContainer = static_cast<RelationContainer*>(entry->ptr);
@@ -534,7 +570,7 @@ void DataStore::addRelation(const TObject* fromObject, StoreEntry*& fromEntry, i
                                                            RelationIndexManager::Instance().getIndexIfExists<TObject, TObject>(relationsName, c_Event);
   if (relIndex) {
     // add it to index (so we avoid expensive rebuilding later)
-    relIndex->index().emplace(fromIndex, toIndex, fromObject, toObject, weight);
+    relIndex->add(RelationIndexContainer<TObject, TObject>::Element(fromIndex, toIndex, fromObject, toObject, weight));
   } else {
     //mark for rebuilding later on
     relContainer->setModified(true);
@@ -714,10 +750,25 @@ std::vector<std::string> DataStore::getSortedListOfDataStore(EDurability durabil
 void DataStore::invalidateData(EDurability durability)
 {
   B2DEBUG(100, "Invalidating objects for durability " << durability);
+  if (durability == c_Event) {
+    for (const auto& ownerAndCallback : m_endOfEventCallbacks)
+      ownerAndCallback.second();
+  }
   m_storeEntryMap.invalidateData(durability);
   RelationIndexManager::Instance().clear();
 }
 
+void DataStore::addEndOfEventCallback(const void* owner, std::function<void()> callback)
+{
+  m_endOfEventCallbacks.emplace_back(owner, std::move(callback));
+}
+
+void DataStore::removeEndOfEventCallbacks(const void* owner)
+{
+  m_endOfEventCallbacks.erase(std::remove_if(m_endOfEventCallbacks.begin(), m_endOfEventCallbacks.end(),
+  [owner](const auto & ownerAndCallback) { return ownerAndCallback.first == owner; }), m_endOfEventCallbacks.end());
+}
+
 bool DataStore::requireInput(const StoreAccessorBase& accessor)
 {
   if (m_initializeActive) {
@@ -816,9 +867,14 @@ void DataStore::mergeContentsTo(const std::string& id, const std::vector<std::st
   m_storeEntryMap.mergeContentsTo(id, entrylist_event);
 }
 
+void DataStore::swapContentsWith(const std::string& id, EDurability durability)
+{
+  m_storeEntryMap.swapContentsWith(id, durability);
+}
+
 
 DataStore::SwitchableDataStoreContents::SwitchableDataStoreContents():
-  m_entries(1)
+  m_entries(1), m_handleTables(1)
 {
   m_idToIndexMap[""] = 0;
 }
@@ -844,6 +900,9 @@ void DataStore::SwitchableDataStoreContents::createEmptyDataStoreID(const std::s
   m_idToIndexMap[id] = targetidx;
 
   m_entries.push_back(DataStoreContents());
+  //m_entries may have been reallocated, start with fresh handle tables
+  m_handleTables.clear();
+  m_handleTables.resize(m_entries.size());
 }
 
 void DataStore::SwitchableDataStoreContents::copyEntriesTo(const std::string& id, const std::vector<std::string>& entrylist_event,
@@ -876,7 +935,10 @@ void DataStore::SwitchableDataStoreContents::copyEntriesTo(const std::string& id
     m_idToIndexMap[id] = targetidx;
 
     //copy entries
-    m_entries.push_back(m_entries[m_currentIdx]);
+    m_entries.push_back(m_entries[currentIdx()]);
+    //m_entries may have been reallocated, start with fresh handle tables
+    m_handleTables.clear();
+    m_handleTables.resize(m_entries.size());
   } else if (!entrylist.empty()) {
     targetidx = m_idToIndexMap.at(id);
     // if we are merging DataStores, we need to register a new object that stores at which indices the arrays have been merged
@@ -888,7 +950,7 @@ void DataStore::SwitchableDataStoreContents::copyEntriesTo(const std::string& id
     }
     for (std::string& entryname : entrylist) {
       //copy only given entries (in c_Event)
-      if (m_entries[m_currentIdx][c_Event].count(entryname) == 0) {
+      if (m_entries[currentIdx()][c_Event].count(entryname) == 0) {
         continue;
       }
       if (m_entries[targetidx][c_Event].count(entryname) != 0) {
@@ -912,7 +974,7 @@ void DataStore::SwitchableDataStoreContents::copyEntriesTo(const std::string& id
                     "'! This will likely break something.");
         }
       } else {
-        m_entries[targetidx][c_Event][entryname] = m_entries[m_currentIdx][c_Event][entryname];
+        m_entries[targetidx][c_Event][entryname] = m_entries[currentIdx()][c_Event][entryname];
       }
     }
   } else {
@@ -946,11 +1008,11 @@ void DataStore::SwitchableDataStoreContents::copyContentsTo(const std::string& i
 {
   int targetidx = m_idToIndexMap.at(id);
   auto& targetMaps = m_entries[targetidx];
-  const auto& sourceMaps = m_entries[m_currentIdx];
+  auto& sourceMaps = m_entries[currentIdx()];
 
   for (int iDurability = 0; iDurability < c_NDurabilityTypes; iDurability++) {
-    for (const auto& entrypair : sourceMaps[iDurability]) {
-      const StoreEntry& fromEntry = entrypair.second;
+    for (auto& entrypair : sourceMaps[iDurability]) {
+      StoreEntry& fromEntry = entrypair.second;
       //does this exist in target?
       if (targetMaps[iDurability].count(fromEntry.name) == 0) {
         continue;
@@ -966,6 +1028,7 @@ void DataStore::SwitchableDataStoreContents::copyContentsTo(const std::string& i
       }
 
       StoreEntry& target = targetMaps[iDurability][fromEntry.name];
+      fromEntry.ensureLoaded();
 
       //copy contents into target object
       if (not fromEntry.ptr) {
@@ -983,6 +1046,35 @@ void DataStore::SwitchableDataStoreContents::copyContentsTo(const std::string& i
 
 }
 
+void DataStore::SwitchableDataStoreContents::swapContentsWith(const std::string& id, EDurability durability)
+{
+  StoreEntryMap& otherMap = m_entries[m_idToIndexMap.at(id)][durability];
+  StoreEntryMap& map = m_entries[currentIdx()][durability];
+  if (&otherMap == &map)
+    return;
+
+  //both maps are sorted by name, so we can walk through them in parallel
+  auto otherIt = otherMap.begin();
+  for (auto& entrypair : map) {
+    while (otherIt != otherMap.end() and otherIt->first < entrypair.first)
+      ++otherIt;
+    if (otherIt == otherMap.end())
+      break;
+    if (otherIt->first != entrypair.first)
+      continue;
+
+    StoreEntry& entry = entrypair.second;
+    StoreEntry& otherEntry = otherIt->second;
+    if (entry.isArray != otherEntry.isArray or entry.objClass != otherEntry.objClass)
+      B2FATAL("Cannot swap contents of DataStore entry " << entry.name << ", it was registered differently in DataStore ID '" << id << "'");
+    //objects not read yet can only be read into the entry of the input module
+    entry.ensureLoaded();
+    otherEntry.ensureLoaded();
+    std::swap(entry.object, otherEntry.object);
+    std::swap(entry.ptr, otherEntry.ptr);
+  }
+}
+
 void DataStore::SwitchableDataStoreContents::mergeContentsTo(const std::string& id, const std::vector<std::string>& entrylist_event)
 {
   if (entrylist_event.empty()) {
@@ -999,7 +1091,7 @@ void DataStore::SwitchableDataStoreContents::mergeContentsTo(const std::string&
 
   int targetidx = m_idToIndexMap.at(id);
   auto& targetMaps = m_entries[targetidx];
-  const auto& sourceMaps = m_entries[m_currentIdx];
+  auto& sourceMaps = m_entries[currentIdx()];
 
   // we need to know the length of the original StoreArrays in order to fix the Relations
   if (targetMaps[c_Event].count("MergedArrayIndices") == 0) {
@@ -1011,8 +1103,8 @@ void DataStore::SwitchableDataStoreContents::mergeContentsTo(const std::string&
 
   // we have to go through the list in this order to make sure StoreArrays are merged before their Relations
   for (std::string nextEntry : entrylist) {
-    for (const auto& entrypair : sourceMaps[c_Event]) {
-      const StoreEntry& fromEntry = entrypair.second;
+    for (auto& entrypair : sourceMaps[c_Event]) {
+      StoreEntry& fromEntry = entrypair.second;
       if (fromEntry.name != nextEntry) {
         continue;
       }
@@ -1023,6 +1115,8 @@ void DataStore::SwitchableDataStoreContents::mergeContentsTo(const std::string&
       }
 
       StoreEntry& target = targetMaps[c_Event][fromEntry.name];
+      fromEntry.ensureLoaded();
+      target.ensureLoaded();
 
       //copy contents into target object
       if (!fromEntry.ptr) {
@@ -1142,12 +1236,18 @@ void DataStore::SwitchableDataStoreContents::mergeContentsTo(const std::string&
 
 void DataStore::SwitchableDataStoreContents::switchID(const std::string& id)
 {
-  //switch
-  m_currentID = id;
-  m_currentIdx = m_idToIndexMap.at(id);
+  const int idx = m_idToIndexMap.at(id);
+  if ((unsigned int)idx >= m_entries.size())
+    B2FATAL("out of bounds in SwitchableDataStoreContents::switchID(): " << idx << " >= size " << m_entries.size());
 
-  if ((unsigned int)m_currentIdx >= m_entries.size())
-    B2FATAL("out of bounds in SwitchableDataStoreContents::switchID(): " << m_currentIdx << " >= size " << m_entries.size());
+  //switch
+  if (s_multiThreaded) {
+    s_threadID = id;
+    s_threadIdx = idx;
+  } else {
+    m_currentID = id;
+    m_currentIdx = idx;
+  }
 }
 
 void DataStore::SwitchableDataStoreContents::clear()
@@ -1157,10 +1257,14 @@ void DataStore::SwitchableDataStoreContents::clear()
 
   m_entries.clear();
   m_entries.resize(1);
+  m_handleTables.clear();
+  m_handleTables.resize(1);
   m_idToIndexMap.clear();
   m_idToIndexMap[""] = 0;
   m_currentID = "";
   m_currentIdx = 0;
+  s_threadID = "";
+  s_threadIdx = 0;
 }
 
 void DataStore::SwitchableDataStoreContents::reset(EDurability durability)
@@ -1171,10 +1275,38 @@ void DataStore::SwitchableDataStoreContents::reset(EDurability durability)
     }
     map[durability].clear();
   }
+  clearHandleTables(durability);
+}
+
+DataStore::StoreEntry* DataStore::SwitchableDataStoreContents::lookupEntry(int durability, int handle, const std::string& name)
+{
+  StoreEntryMap& map = m_entries[currentIdx()][durability];
+  const auto& it = map.find(name);
+  if (it == map.end())
+    return nullptr;
+
+  //map nodes are stable, so we can keep pointers to them until the map is cleared
+  std::vector<StoreEntry*>& table = m_handleTables[currentIdx()][durability];
+  if (static_cast<size_t>(handle) >= table.size())
+    table.resize(handle + 1, nullptr);
+  table[handle] = &(it->second);
+  return table[handle];
+}
+
+void DataStore::SwitchableDataStoreContents::clearHandleTables(int durability)
+{
+  for (auto& tables : m_handleTables)
+    tables[durability].clear();
 }
 
 void DataStore::SwitchableDataStoreContents::invalidateData(EDurability durability)
 {
+  if (s_multiThreaded) {
+    //other threads are still busy with their own contents
+    for (auto& mapEntry : m_entries[currentIdx()][durability])
+      mapEntry.second.invalidate();
+    return;
+  }
   for (auto& map : m_entries)
     for (auto& mapEntry : map[durability])
       mapEntry.second.invalidate();
@@ -12,7 +12,8 @@ using namespace Belle2;
 
 RelationIndexManager& RelationIndexManager::Instance()
 {
-  static RelationIndexManager instance;
+  //indices point into the DataStore contents of the current thread, see DataStore::setMultiThreaded()
+  static thread_local RelationIndexManager instance;
   return instance;
 }
 void RelationIndexManager::clear(DataStore::EDurability durability)
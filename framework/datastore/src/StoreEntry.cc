@@ -22,7 +22,8 @@ StoreEntry::StoreEntry(bool isArray_, TClass* cl, std::string  name_, bool dontW
   objClass(cl),
   object(nullptr),
   ptr(nullptr),
-  name(std::move(name_))
+  name(std::move(name_)),
+  loader(nullptr)
 {
   recoverFromNullObject();
 }
@@ -76,6 +77,8 @@ void StoreEntry::recreate()
 
 void StoreEntry::invalidate()
 {
+  //nothing to read anymore
+  loader = nullptr;
   recreate();
   ptr = nullptr;
 }
@@ -46,6 +46,14 @@ namespace Belle2 {
      *     need the field strength in a fixed unit please divide the returned value
      *     by Unit::T or similar. */
     ROOT::Math::XYZVector getField(const ROOT::Math::XYZVector& pos) const;
+    /** Calculate the magnetic field at several positions at once.
+     * This gives the same result as calling getField() for each position but
+     * allows the components to use vectorized implementations.
+     * @param n number of positions
+     * @param pos array of n positions where the field should be evaluated in framework units.
+     * @param field output array for the n field values in framework units.
+     */
+    void getField(size_t n, const ROOT::Math::XYZVector* pos, ROOT::Math::XYZVector* field) const;
     /** Convenience function to get the field directly in Tesla
      * @param pos position where the field should be evaluated in framework units.
      * @return magnetic field at pos in framework units.
@@ -37,6 +37,17 @@ namespace Belle2 {
     virtual bool inside(const ROOT::Math::XYZVector& pos) const = 0;
     /** return the field at point pos */
     virtual ROOT::Math::XYZVector getField(const ROOT::Math::XYZVector& pos) const = 0;
+    /** return the field at n points, assuming they are all inside. The
+     * default implementation calls getField() for each point, components can
+     * override it with a vectorized implementation.
+     * @param n number of points
+     * @param pos array of n positions
+     * @param field output array for the n field values
+     */
+    virtual void getFieldBatch(size_t n, const ROOT::Math::XYZVector* pos, ROOT::Math::XYZVector* field) const
+    {
+      for (size_t i = 0; i < n; ++i) field[i] = getField(pos[i]);
+    }
     /** destructor */
     virtual ~MagneticFieldComponent() {}
 
@@ -0,0 +1,56 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/dbobjects/MagneticField.h>
+
+#include <vector>
+
+using namespace Belle2;
+
+void MagneticField::getField(size_t n, const ROOT::Math::XYZVector* pos, ROOT::Math::XYZVector* field) const
+{
+  for (size_t i = 0; i < n; ++i) field[i].SetXYZ(0, 0, 0);
+  // scratch space for the points inside each component, kept to avoid allocations
+  thread_local std::vector<size_t> selected;
+  thread_local std::vector<ROOT::Math::XYZVector> selectedPos, selectedField;
+  // points which already got the field of an exclusive component
+  thread_local std::vector<char> done;
+  done.assign(n, false);
+  for (auto c : m_components) {
+    selected.clear();
+    for (size_t i = 0; i < n; ++i) {
+      if (!done[i] and c->inside(pos[i])) selected.push_back(i);
+    }
+    if (selected.empty()) continue;
+    if (selected.size() == n) {
+      // all points inside, usually the case for the main field component
+      if (c->isExclusive()) {
+        c->getFieldBatch(n, pos, field);
+        return;
+      }
+      selectedField.resize(n);
+      c->getFieldBatch(n, pos, selectedField.data());
+      for (size_t i = 0; i < n; ++i) field[i] += selectedField[i];
+      continue;
+    }
+    selectedPos.resize(selected.size());
+    selectedField.resize(selected.size());
+    for (size_t j = 0; j < selected.size(); ++j) selectedPos[j] = pos[selected[j]];
+    c->getFieldBatch(selected.size(), selectedPos.data(), selectedField.data());
+    for (size_t j = 0; j < selected.size(); ++j) {
+      const size_t i = selected[j];
+      // same as getField(): an exclusive component replaces the field of all previous ones
+      if (c->isExclusive()) {
+        field[i] = selectedField[j];
+        done[i] = true;
+      } else {
+        field[i] += selectedField[j];
+      }
+    }
+  }
+}
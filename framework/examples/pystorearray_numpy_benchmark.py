@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+
+##########################################################################
+# basf2 (Belle II Analysis Software Framework)                           #
+# Author: The Belle II Collaboration                                     #
+#                                                                        #
+# See git log for contributors and copyright holders.                    #
+# This file is licensed under LGPL-3.0, see LICENSE.md.                  #
+##########################################################################
+
+######################################################
+# Compares the time needed to access the contents of a
+# StoreArray from Python by looping over the objects
+# with PyROOT and by getting the data members as numpy
+# arrays with PyStoreArray.columns()
+######################################################
+
+import time
+
+import basf2
+import numpy as np
+from ROOT import Belle2
+
+
+class PyROOTLoopModule(basf2.Module):
+    """Compute the transverse momenta of all MCParticles by looping over the objects"""
+
+    def initialize(self):
+        """Reset the timer"""
+        #: time spent in the event function
+        self.time = 0
+        #: sum of all transverse momenta, to compare the results
+        self.sum = 0
+
+    def event(self):
+        """Loop over the MCParticles"""
+        start = time.perf_counter()
+        mcParticles = Belle2.PyStoreArray("MCParticles")
+        pt = np.array([mcParticle.getMomentum().Rho() for mcParticle in mcParticles])
+        self.sum += pt[pt > 0.5].sum()
+        self.time += time.perf_counter() - start
+
+    def terminate(self):
+        """Print the result"""
+        basf2.B2INFO(f"PyROOT loop:   {self.time:8.3f} s, sum of pt > 0.5 GeV: {self.sum:.3f}")
+
+
+class NumpyColumnsModule(PyROOTLoopModule):
+    """Compute the transverse momenta of all MCParticles from numpy arrays of the data members"""
+
+    def event(self):
+        """Get the columns of the momentum components"""
+        start = time.perf_counter()
+        mcParticles = Belle2.PyStoreArray("MCParticles")
+        columns = mcParticles.columns("m_momentum_x", "m_momentum_y")
+        pt = np.hypot(columns["m_momentum_x"], columns["m_momentum_y"])
+        self.sum += pt[pt > 0.5].sum()
+        self.time += time.perf_counter() - start
+
+    def terminate(self):
+        """Print the result"""
+        basf2.B2INFO(f"numpy columns: {self.time:8.3f} s, sum of pt > 0.5 GeV: {self.sum:.3f}")
+
+
+main = basf2.Path()
+main.add_module("EventInfoSetter", evtNumList=[1000])
+main.add_module("ParticleGun", nTracks=200, momentumGeneration="uniform", momentumParams=[0.05, 3])
+main.add_module(PyROOTLoopModule())
+main.add_module(NumpyColumnsModule())
+basf2.process(main)
+print(basf2.statistics)
@@ -12,6 +12,7 @@
 
 #include <framework/gearbox/Interface.h>
 #include <framework/gearbox/InputHandler.h>
+#include <framework/gearbox/GearboxCache.h>
 
 #include <map>
 #include <vector>
@@ -85,6 +86,18 @@ namespace Belle2 {
       m_overrides.clear();
     }
 
+    /**
+     * Set the directory for the persistent query cache, empty to disable it.
+     *
+     * If enabled, the results of all queries are written to a binary file in
+     * this directory when the document is closed, together with a hash of the
+     * content of all XML resources. If the same document is opened again with
+     * the same backends and overrides and none of the resources changed, the
+     * queries are answered from this file and the XML is only parsed if a path
+     * is requested which is not in the file.
+     */
+    void setCacheDirectory(const std::string& directory) { m_cacheDirectory = directory; }
+
     /**
      * Open connection to backend and parse tree
      * @param name Name of the tree to parse
@@ -95,11 +108,20 @@ namespace Belle2 {
     /** Free internal structures of previously parsed tree and clear cache */
     void close();
 
+    /** Write the persistent query cache if there are new results since it was loaded or written */
+    void writeCache();
+
     /**
      * Return the state of the Gearbox.
      * @return True if the Gearbox has an initialized backend and opened a document for reading.
      */
-    bool isOpen() const { return m_xmlDocument != 0; }
+    bool isOpen() const { return m_xmlDocument != 0 or m_queryCache.isLoaded(); }
+
+    /** True if the queries are currently answered from the persistent query cache */
+    bool isUsingCache() const { return m_queryCache.isLoaded(); }
+
+    /** Time in ms it took to open the last document, including the parsing or validating the query cache */
+    double getOpenTime() const { return m_openTime; }
 
     /**
      * Return the number of nodes a given path will expand to
@@ -196,15 +218,21 @@ namespace Belle2 {
     /** Function to be called when libxml requests a new input uri to be opened */
     gearbox::InputContext* openXmlUri(const std::string& uri) const;
 
+    /** Parse the document and apply the overrides */
+    void parseDocument() const;
+    /** Identify everything which influences the query results apart from the content of the XML resources */
+    uint64_t getCacheKey(const std::string& name) const;
+    /** Check whether the XML resources in the query cache are unchanged */
+    bool checkCacheInputs() const;
     /** Change the value of a given path expression */
-    void overridePathValue(const PathOverride& poverride);
+    void overridePathValue(const PathOverride& poverride) const;
     /** Return the (cached) value of a given path */
     PathValue getPathValue(const std::string& path) const;
 
-    /** Pointer to the libxml Document structure */
-    xmlDocPtr m_xmlDocument;
+    /** Pointer to the libxml Document structure, parsed only when needed if the query cache is used */
+    mutable xmlDocPtr m_xmlDocument;
     /** Pointer to the libxml XPath context */
-    xmlXPathContextPtr m_xpathContext;
+    mutable xmlXPathContextPtr m_xpathContext;
     /** Cache for already queried paths */
     mutable MRUCache<std::string, PathValue>* m_parameterCache;
     /** Map of queried objects (path -> TObject*). Objects will be removed once they are no longer valid. */
@@ -212,12 +240,33 @@ namespace Belle2 {
 
     /** List of input handlers which will be used to find resources. */
     std::vector<gearbox::InputHandler*> m_handlers;
+    /** Backends given to setBackends(), used to identify the document in the query cache */
+    std::vector<std::string> m_backendNames;
     /** Map of registered InputHandlers */
     std::map<std::string, gearbox::InputHandler::Factory*> m_registeredHandlers;
 
     /** the existing overrides */
     std::vector<PathOverride> m_overrides;
 
+    /** Name of the opened document */
+    std::string m_documentName;
+    /** Directory of the persistent query cache, empty if disabled */
+    std::string m_cacheDirectory;
+    /** File name of the persistent query cache of the opened document */
+    std::string m_cacheFile;
+    /** Key of the opened document in the persistent query cache */
+    uint64_t m_cacheKey{0};
+    /** Persistent query cache mapped into memory */
+    gearbox::GearboxCache m_queryCache;
+    /** True while the document is parsed, the XML resources read are then recorded in m_cacheInputs */
+    mutable bool m_recordInputs{false};
+    /** XML resources read while parsing the document */
+    mutable std::vector<gearbox::GearboxCache::Input> m_cacheInputs;
+    /** Query results obtained from the XML document which are not yet in the persistent query cache */
+    mutable std::map<std::string, gearbox::GearboxCache::Value> m_newCacheValues;
+    /** Time in ms it took to open the last document */
+    double m_openTime{0};
+
     /**
      * friend to internal c-like function to interface libxml2 callback
      *
@@ -0,0 +1,105 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Belle2 {
+  namespace gearbox {
+
+    /**
+     * Binary file containing the results of Gearbox queries.
+     *
+     * The file contains the list of XML resources the document was built
+     * from together with a hash of their content, and a hash table mapping
+     * each queried path to the number of nodes, value and unit. It is mapped
+     * into memory and queries are answered directly from the mapped file, so
+     * nothing has to be parsed when the cache is used.
+     *
+     * The file is identified by a key which should contain everything
+     * influencing the query results apart from the content of the XML
+     * resources (name of the document, backends, overrides). Files with
+     * a different key or version are ignored.
+     */
+    class GearboxCache {
+    public:
+      /** Version of the file format, files with a different version are ignored */
+      enum { c_Version = 1 };
+
+      /** One XML resource the document was built from */
+      struct Input {
+        /** uri of the resource as requested by libxml */
+        std::string uri;
+        /** hash of the content */
+        uint64_t hash;
+      };
+
+      /** Result of one query */
+      struct Value {
+        /** number of nodes corresponding to the path */
+        int numNodes{0};
+        /** value of the first node if present */
+        std::string value;
+        /** unit attribute of the first node if present */
+        std::string unit;
+      };
+
+      /** Hash some data, can be called repeatedly with the previous result as seed */
+      static uint64_t hash(const char* data, size_t size, uint64_t seed = c_HashSeed);
+      /** Initial value for hash() */
+      static const uint64_t c_HashSeed = 0xcbf29ce484222325ULL;
+
+      /** Nothing is mapped */
+      GearboxCache() = default;
+      /** Unmap the file */
+      ~GearboxCache() { unload(); }
+      /** No copying */
+      GearboxCache(const GearboxCache&) = delete;
+      /** No assignment */
+      GearboxCache& operator=(const GearboxCache&) = delete;
+
+      /** Map the given file. Returns false if it does not exist, is corrupt or has a different version or key. */
+      bool load(const std::string& filename, uint64_t key);
+      /** Unmap the file */
+      void unload();
+      /** Check whether a file is mapped */
+      bool isLoaded() const { return m_data != nullptr; }
+      /** The XML resources stored in the mapped file */
+      const std::vector<Input>& getInputs() const { return m_inputs; }
+      /** Look up the result of a query in the mapped file, returns false if it is not contained */
+      bool find(const std::string& path, Value& value) const;
+      /** Call the function for all queries in the mapped file */
+      void forEach(const std::function<void(const std::string&, const Value&)>& function) const;
+
+      /** Write a cache file, replacing an existing one atomically. Returns false on errors. */
+      static bool write(const std::string& filename, uint64_t key, const std::vector<Input>& inputs,
+                        const std::map<std::string, Value>& values);
+
+    private:
+      /** Read the entry at the given offset, returns false if it is out of bounds */
+      bool readEntry(uint64_t offset, std::string& path, Value& value) const;
+
+      /** Start of the mapped file */
+      const char* m_data{nullptr};
+      /** Size of the mapped file */
+      size_t m_size{0};
+      /** Number of slots in the hash table */
+      uint64_t m_nSlots{0};
+      /** Position of the hash table in the file */
+      uint64_t m_slotsOffset{0};
+      /** The XML resources stored in the file */
+      std::vector<Input> m_inputs;
+    };
+  }
+}
@@ -7,14 +7,19 @@
  **************************************************************************/
 #include <framework/gearbox/Gearbox.h>
 #include <framework/gearbox/GearDir.h>
+#include <framework/gearbox/Unit.h>
 #include <framework/core/MRUCache.h>
 #include <framework/logging/Logger.h>
 #include <framework/utilities/Stream.h>
+#include <framework/utilities/Utils.h>
 
 #include <libxml/parser.h>
 #include <libxml/xinclude.h>
 #include <libxml/xmlIO.h>
 #include <cstring>
+#include <filesystem>
+#include <memory>
+#include <sstream>
 #include <boost/algorithm/string.hpp>
 
 #include <TObject.h>
@@ -50,6 +55,32 @@ namespace Belle2 {
       return gearContext->readXmlData(buffer, buffsize);
     }
 
+    /** InputContext which hashes all data read by libxml2 to record the resource for the query cache */
+    class HashingContext: public InputContext {
+    public:
+      /** Take ownership of the context of the resource */
+      HashingContext(InputContext* context, const std::string& uri, std::vector<GearboxCache::Input>& inputs):
+        m_context(context), m_uri(uri), m_inputs(inputs) {}
+      /** Record the resource and its hash once it is completely read */
+      ~HashingContext() { m_inputs.push_back({m_uri, m_hash}); }
+      /** Read from the resource and update the hash */
+      virtual int readXmlData(char* buffer, int buffsize) override
+      {
+        int size = m_context->readXmlData(buffer, buffsize);
+        if (size > 0) m_hash = GearboxCache::hash(buffer, size, m_hash);
+        return size;
+      }
+    private:
+      /** context of the resource */
+      std::unique_ptr<InputContext> m_context;
+      /** uri of the resource */
+      std::string m_uri;
+      /** list to add the resource to */
+      std::vector<GearboxCache::Input>& m_inputs;
+      /** hash of the data read so far */
+      uint64_t m_hash{GearboxCache::c_HashSeed};
+    };
+
     /** Callback function to close GearInputContext when requested by libxml2 */
     static int closeXmlContext(void* context)
     {
@@ -86,6 +117,7 @@ namespace Belle2 {
     for (gearbox::InputHandler* handler : m_handlers) {
       //try to create context for uri, return if success
       gearbox::InputContext* context = handler->open(uri);
+      if (context and m_recordInputs) return new gearbox::HashingContext(context, uri, m_cacheInputs);
       if (context) return context;
     }
     B2ERROR("Could not find data for uri '" << uri << "'");
@@ -95,6 +127,7 @@ namespace Belle2 {
   void Gearbox::setBackends(const vector<string>& backends)
   {
     clearBackends();
+    m_backendNames = backends;
     for (const string& backend : backends) {
       B2DEBUG(300, "Adding InputHandler for '" << backend << "'");
       //Find correct InputHandler, assuming file backend by default if there is no colon in the
@@ -124,29 +157,61 @@ namespace Belle2 {
   {
     for (gearbox::InputHandler* handler : m_handlers) delete handler;
     m_handlers.clear();
+    m_backendNames.clear();
   }
 
   void Gearbox::open(const std::string& name, size_t cacheSize)
   {
+    const double start = Utils::getClock();
     //Check if we have an open connection and close first if so
-    if (m_xmlDocument) close();
+    if (isOpen()) close();
     //Check if we have at least one backend
     if (m_handlers.empty())
       B2FATAL("No backends defined, please use Gearbox::setBackends() first to specify how to access XML files.");
 
+    m_documentName = name;
+    m_cacheFile.clear();
+    if (!m_cacheDirectory.empty()) {
+      m_cacheKey = getCacheKey(name);
+      std::stringstream cacheFile;
+      cacheFile << m_cacheDirectory << "/gearbox-" << std::hex << m_cacheKey << ".cache";
+      m_cacheFile = cacheFile.str();
+      if (m_queryCache.load(m_cacheFile, m_cacheKey) and !checkCacheInputs()) {
+        B2DEBUG(20, "Gearbox query cache " << m_cacheFile << " is outdated");
+        m_queryCache.unload();
+      }
+    }
+    //Without the query cache we need the document right away
+    if (!m_queryCache.isLoaded()) parseDocument();
+
+    //Set cachesize
+    m_parameterCache->setMaxSize(cacheSize);
+
+    m_openTime = (Utils::getClock() - start) / Unit::ms;
+    B2DEBUG(20, "Gearbox opened " << name << (m_queryCache.isLoaded() ? " using the query cache " + m_cacheFile : "")
+            << LogVar("time [ms]", m_openTime));
+  }
+
+  void Gearbox::parseDocument() const
+  {
     // register input callbacks for opening the files
     xmlRegisterInputCallbacks(gearbox::matchXmlUri, gearbox::openXmlUri,
                               gearbox::readXmlData, gearbox::closeXmlContext);
 
+    //Record all resources read if we want to write the query cache
+    m_recordInputs = !m_cacheFile.empty();
+    m_cacheInputs.clear();
+
     //Open document
-    m_xmlDocument = xmlParseFile(name.c_str());
+    m_xmlDocument = xmlParseFile(m_documentName.c_str());
     //libxml >= 2.7.0 introduced some limits on node size etc. which breaks reading VXDTF files
     xmlXIncludeProcessFlags(m_xmlDocument, XML_PARSE_HUGE);
 
     // reset input callbacks
     xmlPopInputCallbacks();
+    m_recordInputs = false;
 
-    if (!m_xmlDocument) B2FATAL("Could not connect gearbox to " << name);
+    if (!m_xmlDocument) B2FATAL("Could not connect gearbox to " << m_documentName);
     m_xpathContext = xmlXPathNewContext(m_xmlDocument);
     if (!m_xpathContext) B2FATAL("Could not create XPath context");
 
@@ -157,13 +222,71 @@ namespace Belle2 {
 
     //Speeds up XPath computation on static documents.
     xmlXPathOrderDocElems(m_xmlDocument);
+  }
 
-    //Set cachesize
-    m_parameterCache->setMaxSize(cacheSize);
+  uint64_t Gearbox::getCacheKey(const std::string& name) const
+  {
+    //Everything changing the query results apart from the content of the resources
+    std::stringstream key;
+    key << gearbox::GearboxCache::c_Version << '\0' << name << '\0';
+    for (const std::string& backend : m_backendNames) key << backend << '\0';
+    for (const PathOverride& poverride : m_overrides) {
+      key << poverride.path << '\0' << poverride.value << '\0' << poverride.unit << '\0' << poverride.multiple << '\0';
+    }
+    const std::string data = key.str();
+    return gearbox::GearboxCache::hash(data.data(), data.size());
+  }
+
+  bool Gearbox::checkCacheInputs() const
+  {
+    std::vector<char> buffer(1 << 16);
+    for (const gearbox::GearboxCache::Input& input : m_queryCache.getInputs()) {
+      //Find the resource the same way libxml2 would
+      std::unique_ptr<gearbox::InputContext> context;
+      for (gearbox::InputHandler* handler : m_handlers) {
+        context.reset(handler->open(input.uri));
+        if (context) break;
+      }
+      if (!context) return false;
+      uint64_t hash = gearbox::GearboxCache::c_HashSeed;
+      int size{0};
+      while ((size = context->readXmlData(buffer.data(), buffer.size())) > 0) {
+        hash = gearbox::GearboxCache::hash(buffer.data(), size, hash);
+      }
+      if (hash != input.hash) return false;
+    }
+    return !m_queryCache.getInputs().empty();
+  }
+
+  void Gearbox::writeCache()
+  {
+    if (m_cacheFile.empty() or m_newCacheValues.empty()) return;
+    //Results already in the cache are still valid, its resources were checked when opening
+    std::map<std::string, gearbox::GearboxCache::Value> values;
+    m_queryCache.forEach([&values](const std::string & path, const gearbox::GearboxCache::Value & value) {
+      values[path] = value;
+    });
+    for (const auto& entry : m_newCacheValues) values[entry.first] = entry.second;
+    const auto& inputs = m_cacheInputs.empty() ? m_queryCache.getInputs() : m_cacheInputs;
+
+    std::error_code error;
+    std::filesystem::create_directories(m_cacheDirectory, error);
+    if (gearbox::GearboxCache::write(m_cacheFile, m_cacheKey, inputs, values)) {
+      B2DEBUG(20, "Wrote Gearbox query cache " << m_cacheFile << LogVar("queries", values.size()));
+    } else {
+      B2WARNING("Could not write Gearbox query cache " << m_cacheFile);
+    }
+    m_newCacheValues.clear();
   }
 
   void Gearbox::close()
   {
+    writeCache();
+    m_queryCache.unload();
+    m_cacheInputs.clear();
+    m_newCacheValues.clear();
+    m_cacheFile.clear();
+
     if (m_xpathContext) xmlXPathFreeContext(m_xpathContext);
     if (m_xmlDocument) xmlFreeDoc(m_xmlDocument);
     m_xpathContext = nullptr;
@@ -177,7 +300,7 @@ namespace Belle2 {
     m_parameterCache->clear();
   }
 
-  void Gearbox::overridePathValue(const PathOverride& poverride)
+  void Gearbox::overridePathValue(const PathOverride& poverride) const
   {
     if (m_xpathContext == nullptr) B2FATAL("Gearbox is not connected");
     //Make sure it ends with a slash
@@ -243,11 +366,22 @@ namespace Belle2 {
   Gearbox::PathValue Gearbox::getPathValue(const std::string& path) const
   {
     PathValue value;
-    if (m_xpathContext == nullptr) B2FATAL("Gearbox is not connected");
+    if (!isOpen()) B2FATAL("Gearbox is not connected");
     //Get from cache if possible
     if (m_parameterCache->retrieve(path, value)) {
       return value;
     }
+    //Then try the persistent query cache
+    gearbox::GearboxCache::Value cached;
+    if (m_queryCache.find(path, cached)) {
+      value.numNodes = cached.numNodes;
+      value.value = cached.value;
+      value.unit = cached.unit;
+      m_parameterCache->insert(path, value);
+      return value;
+    }
+    //Not known yet, parse the document if not done already
+    if (!m_xpathContext) parseDocument();
     //Nothing in cache, query xml
     string query = ensureNode(path);
     B2DEBUG(1000, "Gearbox XPath query: " << query);
@@ -282,6 +416,7 @@ namespace Belle2 {
     }
     //Add to cache, empty or not: results won't change
     m_parameterCache->insert(path, value);
+    if (!m_cacheFile.empty()) m_newCacheValues[path] = {value.numNodes, value.value, value.unit};
     B2DEBUG(1000, "Gearbox XPath result: " << value.numNodes << ", " << value.value << ", " << value.unit);
 
     xmlXPathFreeObject(result);
@@ -0,0 +1,248 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/gearbox/GearboxCache.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+namespace Belle2::gearbox {
+
+  namespace {
+    /** Magic string at the beginning of the file */
+    const char c_magic[8] = {'B', '2', 'G', 'B', 'X', 'C', 'A', 'C'};
+
+    /** Header at the beginning of the file */
+    struct Header {
+      /** magic string identifying the file type */
+      char magic[8];
+      /** version of the file format */
+      uint32_t version;
+      /** number of XML resources */
+      uint32_t nInputs;
+      /** key of the document */
+      uint64_t key;
+      /** number of slots in the hash table, a power of two */
+      uint64_t nSlots;
+      /** position of the hash table */
+      uint64_t slotsOffset;
+      /** size of the file */
+      uint64_t fileSize;
+    };
+
+    /** One slot in the hash table */
+    struct Slot {
+      /** hash of the path */
+      uint64_t pathHash;
+      /** position of the entry, 0 for empty slots */
+      uint64_t entryOffset;
+    };
+
+    /** Header of an entry, followed by path, value and unit */
+    struct EntryHeader {
+      /** number of nodes */
+      int32_t numNodes;
+      /** length of the path */
+      uint32_t pathLength;
+      /** length of the value */
+      uint32_t valueLength;
+      /** length of the unit */
+      uint32_t unitLength;
+    };
+
+    /** Append some bytes to a buffer */
+    void append(vector<char>& buffer, const void* data, size_t size)
+    {
+      const char* bytes = static_cast<const char*>(data);
+      buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+  }
+
+  uint64_t GearboxCache::hash(const char* data, size_t size, uint64_t seed)
+  {
+    // 64 bit FNV-1a
+    uint64_t result = seed;
+    for (size_t i = 0; i < size; ++i) {
+      result ^= static_cast<unsigned char>(data[i]);
+      result *= 0x100000001b3ULL;
+    }
+    return result;
+  }
+
+  bool GearboxCache::load(const string& filename, uint64_t key)
+  {
+    unload();
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat status;
+    if (fstat(fd, &status) != 0 or status.st_size < (off_t)sizeof(Header)) {
+      close(fd);
+      return false;
+    }
+    void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    m_data = static_cast<const char*>(data);
+    m_size = status.st_size;
+
+    Header header;
+    memcpy(&header, m_data, sizeof(header));
+    if (memcmp(header.magic, c_magic, sizeof(c_magic)) != 0 or header.version != c_Version or header.key != key or
+        header.fileSize != m_size or header.nSlots == 0 or (header.nSlots & (header.nSlots - 1)) != 0 or
+        header.slotsOffset > m_size or header.nSlots > (m_size - header.slotsOffset) / sizeof(Slot)) {
+      unload();
+      return false;
+    }
+    uint64_t offset = sizeof(header);
+    for (uint32_t i = 0; i < header.nInputs; ++i) {
+      Input input;
+      uint32_t length{0};
+      if (offset + sizeof(input.hash) + sizeof(length) > header.slotsOffset) {
+        unload();
+        return false;
+      }
+      memcpy(&input.hash, m_data + offset, sizeof(input.hash));
+      memcpy(&length, m_data + offset + sizeof(input.hash), sizeof(length));
+      offset += sizeof(input.hash) + sizeof(length);
+      if (offset + length > header.slotsOffset) {
+        unload();
+        return false;
+      }
+      input.uri.assign(m_data + offset, length);
+      offset += length;
+      m_inputs.push_back(std::move(input));
+    }
+    m_nSlots = header.nSlots;
+    m_slotsOffset = header.slotsOffset;
+    return true;
+  }
+
+  void GearboxCache::unload()
+  {
+    if (m_data) munmap(const_cast<char*>(m_data), m_size);
+    m_data = nullptr;
+    m_size = 0;
+    m_nSlots = 0;
+    m_inputs.clear();
+  }
+
+  bool GearboxCache::readEntry(uint64_t offset, string& path, Value& value) const
+  {
+    EntryHeader header;
+    if (offset < m_slotsOffset or offset + sizeof(header) > m_size) return false;
+    memcpy(&header, m_data + offset, sizeof(header));
+    offset += sizeof(header);
+    const uint64_t length = (uint64_t)header.pathLength + header.valueLength + header.unitLength;
+    if (offset + length > m_size) return false;
+    path.assign(m_data + offset, header.pathLength);
+    offset += header.pathLength;
+    value.numNodes = header.numNodes;
+    value.value.assign(m_data + offset, header.valueLength);
+    offset += header.valueLength;
+    value.unit.assign(m_data + offset, header.unitLength);
+    return true;
+  }
+
+  bool GearboxCache::find(const string& path, Value& value) const
+  {
+    if (!m_data) return false;
+    const uint64_t pathHash = hash(path.data(), path.size());
+    for (uint64_t i = 0; i < m_nSlots; ++i) {
+      Slot slot;
+      memcpy(&slot, m_data + m_slotsOffset + ((pathHash + i) & (m_nSlots - 1)) * sizeof(Slot), sizeof(slot));
+      if (slot.entryOffset == 0) return false;
+      if (slot.pathHash != pathHash) continue;
+      // only compare the path, the value is only assigned if it matches
+      EntryHeader header;
+      if (slot.entryOffset + sizeof(header) > m_size) return false;
+      memcpy(&header, m_data + slot.entryOffset, sizeof(header));
+      if (header.pathLength != path.size() or slot.entryOffset + sizeof(header) + path.size() > m_size or
+          path.compare(0, string::npos, m_data + slot.entryOffset + sizeof(header), path.size()) != 0) continue;
+      string storedPath;
+      return readEntry(slot.entryOffset, storedPath, value);
+    }
+    return false;
+  }
+
+  void GearboxCache::forEach(const function<void(const string&, const Value&)>& function) const
+  {
+    for (uint64_t i = 0; i < m_nSlots; ++i) {
+      Slot slot;
+      memcpy(&slot, m_data + m_slotsOffset + i * sizeof(Slot), sizeof(slot));
+      string path;
+      Value value;
+      if (slot.entryOffset != 0 and readEntry(slot.entryOffset, path, value)) function(path, value);
+    }
+  }
+
+  bool GearboxCache::write(const string& filename, uint64_t key, const vector<Input>& inputs,
+                           const map<string, Value>& values)
+  {
+    vector<char> buffer(sizeof(Header));
+    for (const Input& input : inputs) {
+      const uint32_t length = input.uri.size();
+      append(buffer, &input.hash, sizeof(input.hash));
+      append(buffer, &length, sizeof(length));
+      append(buffer, input.uri.data(), length);
+    }
+    buffer.resize((buffer.size() + 7) / 8 * 8, 0);
+
+    // hash table with at most 50% occupancy, followed by the entries
+    uint64_t nSlots = 1;
+    while (nSlots < 2 * values.size()) nSlots *= 2;
+    const uint64_t slotsOffset = buffer.size();
+    vector<Slot> slots(nSlots, Slot{0, 0});
+    buffer.resize(slotsOffset + nSlots * sizeof(Slot));
+    for (const auto& [path, value] : values) {
+      const uint64_t pathHash = hash(path.data(), path.size());
+      uint64_t index = pathHash & (nSlots - 1);
+      while (slots[index].entryOffset != 0) index = (index + 1) & (nSlots - 1);
+      slots[index] = Slot{pathHash, buffer.size()};
+      const EntryHeader header{value.numNodes, (uint32_t)path.size(), (uint32_t)value.value.size(), (uint32_t)value.unit.size()};
+      append(buffer, &header, sizeof(header));
+      append(buffer, path.data(), path.size());
+      append(buffer, value.value.data(), value.value.size());
+      append(buffer, value.unit.data(), value.unit.size());
+    }
+    memcpy(buffer.data() + slotsOffset, slots.data(), nSlots * sizeof(Slot));
+
+    Header header;
+    memcpy(header.magic, c_magic, sizeof(c_magic));
+    header.version = c_Version;
+    header.nInputs = inputs.size();
+    header.key = key;
+    header.nSlots = nSlots;
+    header.slotsOffset = slotsOffset;
+    header.fileSize = buffer.size();
+    memcpy(buffer.data(), &header, sizeof(header));
+
+    // write to a temporary file first so other processes never see an incomplete file
+    const string tmpName = filename + ".tmp" + to_string(getpid());
+    {
+      ofstream out(tmpName, ios::binary | ios::trunc);
+      out.write(buffer.data(), buffer.size());
+      if (!out) {
+        remove(tmpName.c_str());
+        return false;
+      }
+    }
+    if (rename(tmpName.c_str(), filename.c_str()) != 0) {
+      remove(tmpName.c_str());
+      return false;
+    }
+    return true;
+  }
+}
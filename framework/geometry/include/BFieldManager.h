@@ -14,6 +14,8 @@
 #include <framework/database/DBObjPtr.h>
 #include <framework/dbobjects/MagneticField.h>
 
+#include <vector>
+
 namespace Belle2 {
   /** Bfield manager to obtain the magnetic field at any point.
    * This class is implemented as singleton, there can only be one magnetic
@@ -57,6 +59,27 @@ namespace Belle2 {
     {
       return getField(pos) / Unit::T;
     }
+    /** return the magnetic field at several positions at once.
+     * This is faster than calling getField() for each position if many
+     * positions are known in advance as the field map can be evaluated
+     * vectorized.
+     * @param[in] n number of positions
+     * @param[in] pos array of n positions where to evaluate the magnetic field
+     * @param[out] field array of n magnetic field values in framework units
+     */
+    static void getField(size_t n, const ROOT::Math::XYZVector* pos, ROOT::Math::XYZVector* field)
+    {
+      BFieldManager::getInstance().calculate(n, pos, field);
+    }
+    /** return the magnetic field at several positions at once.
+     * @param[in] pos positions where to evaluate the magnetic field
+     * @param[out] field magnetic field values in framework units, resized to the number of positions
+     */
+    static void getField(const std::vector<ROOT::Math::XYZVector>& pos, std::vector<ROOT::Math::XYZVector>& field)
+    {
+      field.resize(pos.size());
+      getField(pos.size(), pos.data(), field.data());
+    }
     /** Return the instance of the magnetic field manager */
     static BFieldManager& getInstance();
   private:
@@ -73,6 +96,12 @@ namespace Belle2 {
      * @returns magnetic field value at position pos
      */
     ROOT::Math::XYZVector calculate(const ROOT::Math::XYZVector& pos) const;
+    /** Calculate the field values at several positions
+     * @param n number of positions
+     * @param pos array of n positions where to evaluate the magnetic field
+     * @param field output array for the n magnetic field values
+     */
+    void calculate(size_t n, const ROOT::Math::XYZVector* pos, ROOT::Math::XYZVector* field) const;
     /** Pointer to the actual magnetic field in the database */
     DBObjPtr<MagneticField> m_magfield;
   };
@@ -83,6 +112,12 @@ namespace Belle2 {
     return m_magfield->getField(pos);
   };
 
+  inline void BFieldManager::calculate(size_t n, const ROOT::Math::XYZVector* pos, ROOT::Math::XYZVector* field) const
+  {
+    if (!m_magfield) B2FATAL("Could not load magnetic field configuration from database");
+    m_magfield->getField(n, pos, field);
+  };
+
   inline void BFieldManager::getField(const double* pos, double* field)
   {
     ROOT::Math::XYZVector fieldvec = getField(ROOT::Math::XYZVector(pos[0], pos[1], pos[2]));
@@ -0,0 +1,132 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Belle2 {
+  /** Global index of events in a set of files, mapping (experiment, run, event) to (LFN, entry).
+   *
+   * The index is stored in a single binary file which is memory mapped when
+   * opened, so only the pages needed for the lookups are actually read. The
+   * file consists of
+   *
+   * - a fixed size header (see Header),
+   * - the records sorted by (experiment, run, event), see Record,
+   * - the LFNs of all files, each as 32bit length followed by the characters.
+   *
+   * Lookups are a binary search over the records. The same event can be
+   * contained in more than one file (e.g. a skim and its parent), so all
+   * locations of an event can be returned.
+   *
+   * Index files are created with write(), usually with the b2file-index tool.
+   */
+  class EventIndex {
+  public:
+    /** One event in the index */
+    struct Record {
+      /** experiment number */
+      int32_t experiment;
+      /** run number */
+      int32_t run;
+      /** event number */
+      uint32_t event;
+      /** index of the file in the LFN list of the index */
+      uint32_t file;
+      /** entry of the event in the event tree of the file */
+      uint32_t entry;
+
+      /** Order by experiment, run and event */
+      bool operator<(const Record& other) const
+      {
+        if (experiment != other.experiment) return experiment < other.experiment;
+        if (run != other.run) return run < other.run;
+        return event < other.event;
+      }
+    };
+
+    /** Location of an event returned by the lookup functions */
+    struct Location {
+      /** LFN of the file containing the event */
+      std::string lfn;
+      /** entry of the event in the event tree of the file */
+      long entry{ -1};
+    };
+
+    /** Create an empty index, use open() to read a file. */
+    EventIndex() = default;
+    /** Unmap the file */
+    ~EventIndex();
+    /** no copy constructor */
+    EventIndex(const EventIndex&) = delete;
+    /** no assignment operator */
+    EventIndex& operator=(const EventIndex&) = delete;
+
+    /** Map the given index file, throws std::runtime_error if the file cannot be read or is not a valid index. */
+    void open(const std::string& filename);
+
+    /** Unmap the file, the index is empty afterwards. */
+    void close();
+
+    /** Check whether an index file is opened */
+    bool isOpen() const { return m_records != nullptr; }
+
+    /** Number of events in the index */
+    size_t getNumberOfEvents() const { return m_nRecords; }
+
+    /** LFNs of all files in the index */
+    const std::vector<std::string>& getLfns() const { return m_lfns; }
+
+    /** Return all locations of the given event, empty if it is not in the index. */
+    std::vector<Location> findAll(int experiment, int run, unsigned int event) const;
+
+    /** Return the location of the given event, restricted to the given file if lfn is not empty.
+     * Returns a location with entry -1 if the event cannot be found.
+     */
+    Location find(int experiment, int run, unsigned int event, const std::string& lfn = "") const;
+
+    /** Write an index file for the given files and events, the records don't need to be sorted.
+     * Throws std::runtime_error if the file cannot be written.
+     */
+    static void write(const std::string& filename, const std::vector<std::string>& lfns, std::vector<Record> records);
+
+  private:
+    /** Header at the beginning of the index file */
+    struct Header {
+      /** Identifies index files, see c_magic */
+      char magic[8];
+      /** Version of the format */
+      uint32_t version;
+      /** Number of files */
+      uint32_t nFiles;
+      /** Number of records */
+      uint64_t nRecords;
+    };
+
+    /** Expected content of Header::magic */
+    static constexpr char c_magic[8] = {'B', '2', 'E', 'V', 'I', 'D', 'X', '\0'};
+    /** Current version of the format */
+    static constexpr uint32_t c_version = 1;
+
+    /** Return the range of records of the given event */
+    std::pair<const Record*, const Record*> getRange(int experiment, int run, unsigned int event) const;
+
+    /** Start of the mapped file */
+    void* m_mapping{nullptr};
+    /** Size of the mapped file */
+    size_t m_size{0};
+    /** First record in the mapped file */
+    const Record* m_records{nullptr};
+    /** Number of records */
+    size_t m_nRecords{0};
+    /** LFNs of the files, indexed by Record::file */
+    std::vector<std::string> m_lfns;
+  };
+}
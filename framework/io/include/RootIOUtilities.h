@@ -83,6 +83,27 @@ namespace Belle2 {
      */
     std::string getCommitID();
 
+    /** Enables ROOT implicit multi-threading for the lifetime of this object.
+     *
+     * Implicit multi-threading is a global setting of ROOT, so it is only disabled again once all
+     * objects which enabled it are destroyed. The number of threads is the one requested first.
+     * If it was already enabled by someone else, e.g. in the steering file, it is left alone.
+     */
+    class ImplicitMTScope {
+    public:
+      /** Enable implicit multi-threading with the given number of threads */
+      explicit ImplicitMTScope(unsigned int nThreads);
+      /** Disable implicit multi-threading if this is the last object which enabled it */
+      ~ImplicitMTScope();
+      /** No copies */
+      ImplicitMTScope(const ImplicitMTScope&) = delete;
+      /** No assignment */
+      ImplicitMTScope& operator=(const ImplicitMTScope&) = delete;
+    private:
+      /** True if this object counts as a user of implicit multi-threading */
+      bool m_active{false};
+    };
+
     /** Names of trees. */
     extern const std::string c_treeNames[];
 
@@ -0,0 +1,153 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#include <framework/io/EventIndex.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace Belle2;
+
+// the records are used directly from the mapped file
+static_assert(sizeof(EventIndex::Record) == 20, "unexpected padding in EventIndex::Record");
+
+constexpr char EventIndex::c_magic[8];
+
+EventIndex::~EventIndex()
+{
+  close();
+}
+
+void EventIndex::open(const std::string& filename)
+{
+  close();
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0) throw std::runtime_error("Cannot open event index " + filename + ": " + std::strerror(errno));
+  struct stat status;
+  if (fstat(fd, &status) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Cannot open event index " + filename + ": " + std::strerror(errno));
+  }
+  m_size = status.st_size;
+  if (m_size < sizeof(Header)) {
+    ::close(fd);
+    throw std::runtime_error("Event index " + filename + " is too short");
+  }
+  m_mapping = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (m_mapping == MAP_FAILED) {
+    m_mapping = nullptr;
+    throw std::runtime_error("Cannot map event index " + filename + ": " + std::strerror(errno));
+  }
+
+  const auto* data = static_cast<const char*>(m_mapping);
+  const auto* header = reinterpret_cast<const Header*>(data);
+  // compare the number of records by division, the product can overflow for a corrupt header
+  if (std::memcmp(header->magic, c_magic, sizeof(c_magic)) != 0 or header->version != c_version
+      or header->nRecords > (m_size - sizeof(Header)) / sizeof(Record)) {
+    close();
+    throw std::runtime_error("File " + filename + " is not a valid event index");
+  }
+
+  // the list of files is small, so just copy it
+  const char* pos = data + sizeof(Header) + header->nRecords * sizeof(Record);
+  const char* end = data + m_size;
+  m_lfns.reserve(header->nFiles);
+  for (uint32_t i = 0; i < header->nFiles; ++i) {
+    uint32_t length = 0;
+    if (pos + sizeof(length) > end) break;
+    std::memcpy(&length, pos, sizeof(length));
+    pos += sizeof(length);
+    if (pos + length > end) break;
+    m_lfns.emplace_back(pos, length);
+    pos += length;
+  }
+  if (m_lfns.size() != header->nFiles) {
+    close();
+    throw std::runtime_error("Event index " + filename + " is truncated");
+  }
+  // the lookups use the file of a record as index into the LFNs, so check all of them once
+  const auto* records = reinterpret_cast<const Record*>(data + sizeof(Header));
+  madvise(m_mapping, m_size, MADV_SEQUENTIAL);
+  const bool validFiles = std::all_of(records, records + header->nRecords, [nFiles = header->nFiles](const Record & record) {
+    return record.file < nFiles;
+  });
+  if (!validFiles) {
+    close();
+    throw std::runtime_error("Event index " + filename + " refers to files which are not in the index");
+  }
+  // lookups only touch the pages of the records they need
+  madvise(m_mapping, m_size, MADV_RANDOM);
+  m_records = records;
+  m_nRecords = header->nRecords;
+}
+
+void EventIndex::close()
+{
+  if (m_mapping) munmap(m_mapping, m_size);
+  m_mapping = nullptr;
+  m_size = 0;
+  m_records = nullptr;
+  m_nRecords = 0;
+  m_lfns.clear();
+}
+
+std::pair<const EventIndex::Record*, const EventIndex::Record*> EventIndex::getRange(int experiment, int run,
+    unsigned int event) const
+{
+  const Record key{experiment, run, event, 0, 0};
+  return std::equal_range(m_records, m_records + m_nRecords, key);
+}
+
+std::vector<EventIndex::Location> EventIndex::findAll(int experiment, int run, unsigned int event) const
+{
+  std::vector<Location> locations;
+  const auto [begin, end] = getRange(experiment, run, event);
+  for (const Record* record = begin; record != end; ++record) {
+    locations.push_back({m_lfns[record->file], record->entry});
+  }
+  return locations;
+}
+
+EventIndex::Location EventIndex::find(int experiment, int run, unsigned int event, const std::string& lfn) const
+{
+  const auto [begin, end] = getRange(experiment, run, event);
+  for (const Record* record = begin; record != end; ++record) {
+    if (lfn.empty() or m_lfns[record->file] == lfn) return {m_lfns[record->file], record->entry};
+  }
+  return {};
+}
+
+void EventIndex::write(const std::string& filename, const std::vector<std::string>& lfns, std::vector<Record> records)
+{
+  std::stable_sort(records.begin(), records.end());
+  std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+  if (!out) throw std::runtime_error("Cannot create event index " + filename);
+
+  Header header{};
+  std::memcpy(header.magic, c_magic, sizeof(c_magic));
+  header.version = c_version;
+  header.nFiles = lfns.size();
+  header.nRecords = records.size();
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+  for (const std::string& lfn : lfns) {
+    const uint32_t length = lfn.size();
+    out.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.write(lfn.data(), length);
+  }
+  out.close();
+  if (!out) throw std::runtime_error("Cannot write event index " + filename);
+}
@@ -12,6 +12,7 @@
 #include <framework/logging/Logger.h>
 
 #include <RVersion.h>
+#include <TROOT.h>
 #include <TTree.h>
 #include <TList.h>
 #include <TClass.h>
@@ -20,10 +21,18 @@
 
 #include <wordexp.h>
 
+#include <mutex>
 #include <queue>
 
 using namespace Belle2;
 
+namespace {
+  /** Protects s_implicitMTUsers */
+  std::mutex s_implicitMTMutex;
+  /** Number of RootIOUtilities::ImplicitMTScope objects which need implicit multi-threading */
+  int s_implicitMTUsers = 0;
+}
+
 const std::string RootIOUtilities::c_treeNames[] = { "tree", "persistent" };
 const std::string RootIOUtilities::c_SteerBranchNames[] = { "branchNames", "branchNamesPersistent" };
 const std::string RootIOUtilities::c_SteerExcludeBranchNames[] = { "excludeBranchNames", "excludeBranchNamesPersistent" };
@@ -218,3 +227,24 @@ std::string RootIOUtilities::getCommitID()
 {
   return GIT_COMMITID;
 }
+
+RootIOUtilities::ImplicitMTScope::ImplicitMTScope(unsigned int nThreads)
+{
+  std::lock_guard<std::mutex> lock(s_implicitMTMutex);
+  if (s_implicitMTUsers == 0) {
+    if (ROOT::IsImplicitMTEnabled()) return;
+    ROOT::EnableThreadSafety();
+    ROOT::EnableImplicitMT(nThreads);
+  }
+  ++s_implicitMTUsers;
+  m_active = true;
+}
+
+RootIOUtilities::ImplicitMTScope::~ImplicitMTScope()
+{
+  if (!m_active) return;
+  std::lock_guard<std::mutex> lock(s_implicitMTMutex);
+  if (--s_implicitMTUsers == 0) {
+    ROOT::DisableImplicitMT();
+  }
+}
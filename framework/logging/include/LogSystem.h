@@ -11,9 +11,11 @@
 #include <framework/logging/LogConfig.h>
 #include <framework/logging/LogMessage.h>
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
+#include <mutex>
 #include <unordered_map>
 
 
@@ -179,12 +181,25 @@ namespace Belle2 {
     /**
      * Sets the log configuration to the given module log configuration and sets the module name
      * This method should _only_ be called by the EventProcessor.
+     * The setting only applies to the calling thread.
      *
      * @param moduleLogConfig Pointer to the logging configuration object of the module.
      *                        Set to NULL to use the global log configuration.
      * @param moduleName Name of the module.
      */
-    void updateModule(const LogConfig* moduleLogConfig = nullptr, const std::string& moduleName = "") { m_moduleLogConfig = moduleLogConfig; m_moduleName = moduleName; }
+    void updateModule(const LogConfig* moduleLogConfig = nullptr, const std::string& moduleName = "") { s_moduleLogConfig = moduleLogConfig; s_moduleName = moduleName; }
+
+    /**
+     * Announce that messages can be sent from several threads at the same time, until the matching
+     * disableThreadSafety() call. Has to be called before the additional threads are started.
+     *
+     * sendMessage() is only serialized while there is at least one such announcement,
+     * so single-threaded jobs don't pay for the lock.
+     */
+    void enableThreadSafety() { ++m_threadSafetyUsers; }
+
+    /** Undo one enableThreadSafety() call, after the additional threads have been joined. */
+    void disableThreadSafety() { --m_threadSafetyUsers; }
 
     /**
      * Enable debug output.
@@ -201,10 +216,14 @@ namespace Belle2 {
     std::vector<LogConnectionBase*> m_logConnections;
     /** The global log system configuration. */
     LogConfig m_logConfig;
-    /** log config of current module */
-    const LogConfig* m_moduleLogConfig;
-    /** The current module name. */
-    std::string m_moduleName;
+    /** log config of current module (in the current thread) */
+    static thread_local const LogConfig* s_moduleLogConfig;
+    /** The current module name (in the current thread). */
+    static thread_local std::string s_moduleName;
+    /** Serializes sendMessage() calls from several threads, see enableThreadSafety(). */
+    std::recursive_mutex m_sendMutex;
+    /** Number of enableThreadSafety() calls without matching disableThreadSafety() call. */
+    std::atomic<int> m_threadSafetyUsers{0};
     /** Stores the log configuration objects for packages. */
     std::map<std::string, LogConfig> m_packageLogConfigs;
     /** Whether to re-print errors-warnings encountered during execution at the end. */
@@ -254,8 +273,8 @@ namespace Belle2 {
   inline const LogConfig& LogSystem::getCurrentLogConfig(const char* package) const
   {
     //module specific config?
-    if (m_moduleLogConfig && (m_moduleLogConfig->getLogLevel() != LogConfig::c_Default)) {
-      return *m_moduleLogConfig;
+    if (s_moduleLogConfig && (s_moduleLogConfig->getLogLevel() != LogConfig::c_Default)) {
+      return *s_moduleLogConfig;
     }
     //package specific config?
     if (package && !m_packageLogConfigs.empty()) {
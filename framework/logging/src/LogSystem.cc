@@ -23,6 +23,8 @@ using namespace std;
 
 
 bool LogSystem::s_debugEnabled = false;
+thread_local const LogConfig* LogSystem::s_moduleLogConfig = nullptr;
+thread_local std::string LogSystem::s_moduleName;
 
 
 LogSystem& LogSystem::Instance()
@@ -65,17 +67,20 @@ void LogSystem::showText(LogConfig::ELogLevel level, const std::string& txt, int
 
 bool LogSystem::sendMessage(LogMessage&& message)
 {
+  //messages can come from several threads, e.g. in ThreadedEventProcessor
+  std::unique_lock<std::recursive_mutex> lock(m_sendMutex, std::defer_lock);
+  if (m_threadSafetyUsers > 0) lock.lock();
   LogConfig::ELogLevel logLevel = message.getLogLevel();
   auto packageLogConfig = m_packageLogConfigs.find(message.getPackage());
   if ((packageLogConfig != m_packageLogConfigs.end()) && packageLogConfig->second.getLogInfo(logLevel)) {
     message.setLogInfo(packageLogConfig->second.getLogInfo(logLevel));
-  } else if (m_moduleLogConfig && m_moduleLogConfig->getLogInfo(logLevel)) {
-    message.setLogInfo(m_moduleLogConfig->getLogInfo(logLevel));
+  } else if (s_moduleLogConfig && s_moduleLogConfig->getLogInfo(logLevel)) {
+    message.setLogInfo(s_moduleLogConfig->getLogInfo(logLevel));
   } else {
     message.setLogInfo(m_logConfig.getLogInfo(logLevel));
   }
 
-  message.setModule(m_moduleName);
+  message.setModule(s_moduleName);
 
   // We want to count it whether we've seen it or not
   incMessageCounter(logLevel);
@@ -167,7 +172,6 @@ int LogSystem::getMessageCounter(LogConfig::ELogLevel logLevel) const
 
 LogSystem::LogSystem() :
   m_logConfig(LogConfig::c_Info),
-  m_moduleLogConfig(nullptr),
   m_printErrorSummary(false),
   m_messageCounter{0}
 {
@@ -178,7 +182,7 @@ void LogSystem::resetLogging()
 {
   m_logConfig.setLogLevel(LogConfig::c_Info);
   m_logConfig.setDebugLevel(LogConfig::c_DefaultDebugLevel);
-  m_moduleLogConfig = nullptr;
+  s_moduleLogConfig = nullptr;
   m_packageLogConfigs.clear();
   constexpr unsigned int logInfo = LogConfig::c_Level + LogConfig::c_Message;
   constexpr unsigned int warnLogInfo = LogConfig::c_Level + LogConfig::c_Message + LogConfig::c_Module;
@@ -227,7 +231,7 @@ void LogSystem::printErrorSummary()
   const LogConfig oldConfig = m_logConfig;
   // and make sure module configuration is bypassed, otherwise changing the settings in m_logConfig would be ignored
   const LogConfig* oldModuleConfig {nullptr};
-  std::swap(m_moduleLogConfig, oldModuleConfig);
+  std::swap(s_moduleLogConfig, oldModuleConfig);
   // similar for package configuration
   map<string, LogConfig> oldPackageConfig;
   std::swap(m_packageLogConfigs, oldPackageConfig);
@@ -282,7 +286,7 @@ void LogSystem::printErrorSummary()
 
   // restore old configuration
   m_logConfig = oldConfig;
-  std::swap(m_moduleLogConfig, oldModuleConfig);
+  std::swap(s_moduleLogConfig, oldModuleConfig);
   std::swap(m_packageLogConfigs, oldPackageConfig);
 }
 
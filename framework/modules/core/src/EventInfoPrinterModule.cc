@@ -28,6 +28,8 @@ EventInfoPrinterModule::EventInfoPrinterModule() : Module()
 {
   //Set module properties
   setDescription("Prints the current event meta data information (exp, run, event numbers). LogLevel need to be set to INFO, at least for this module.");
+  // event() only reads the EventMetaData and the parameters
+  setPropertyFlags(c_ThreadSafe);
 
   addParam("printTime", m_printTime, "Print time in addition to exp/run/evt numbers.", false);
 }
@@ -73,10 +75,11 @@ std::string EventInfoPrinterModule::formatDateTime(unsigned long long int nsec)
   using namespace chrono;
   high_resolution_clock::time_point time(duration_cast<high_resolution_clock::duration>(nanoseconds(nsec)));
   time_t ttime = high_resolution_clock::to_time_t(time);
-  tm* tm = gmtime(&ttime);
+  tm brokenDownTime;
+  gmtime_r(&ttime, &brokenDownTime);
 
   char timeStr[32];
-  strftime(timeStr, 32, "%F %T", tm);
+  strftime(timeStr, 32, "%F %T", &brokenDownTime);
   unsigned int sec_decimals = (nsec / 1000) % 1000000;
 
   return str(boost::format("%s.%06d") % timeStr % sec_decimals);
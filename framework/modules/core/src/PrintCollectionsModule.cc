@@ -91,7 +91,10 @@ void PrintCollectionsModule::printCollections(DataStore::EDurability durability)
   //-----------------------------
   //Print the object information
   //-----------------------------
-  const DataStore::StoreEntryMap& map = DataStore::Instance().getStoreEntryMap(durability);
+  DataStore::StoreEntryMap& map = DataStore::Instance().getStoreEntryMap(durability);
+  //show what is in the event, not only what was accessed so far
+  for (auto& entry : map)
+    entry.second.ensureLoaded();
   for (auto iter = map.begin(); iter != map.end(); ++iter) {
     if (iter->second.isArray)
       continue;
@@ -57,9 +57,13 @@ namespace Belle2 {
     /** Load the (possibly rundependent) parameters from the chosen backends */
     void beginRun() override;
 
+    /** Write the query cache if enabled */
+    void terminate() override;
+
   private:
     std::vector<std::string> m_backends;   /**< The backend specifier. */
     std::string m_fileName;  /**< The toplevel filename for the parameters */
+    std::string m_cacheDirectory; /**< Directory for the query cache, empty to disable it */
 
     /** common prefix for all value overrides */
     std::string m_overridePrefix;
@@ -10,6 +10,7 @@
 #include <framework/gearbox/Gearbox.h>
 #include <framework/datastore/StoreObjPtr.h>
 #include <framework/dataobjects/EventMetaData.h>
+#include <framework/utilities/EnvironmentVariables.h>
 // needed for complex module parameter
 #include <framework/core/ModuleParam.templateDetails.h>
 
@@ -55,6 +56,13 @@ GearboxModule::GearboxModule() : Module()
            "prepended to all overrides. Beware that '//' has a special meaning "
            "meaning in xpath so be careful with leading and trailing slashes "
            "in the overrides and the prefix respectively", std::string("/Detector"));
+  addParam("cacheDirectory", m_cacheDirectory, "Directory for a binary cache of all "
+           "parameter queries. If not empty, the query results are stored in this "
+           "directory together with a hash of all xml files and subsequent jobs "
+           "with the same backends, file name and overrides answer the queries "
+           "from this cache without parsing the xml files as long as none of them "
+           "changed. Defaults to the environment variable BELLE2_GEARBOX_CACHE_DIR",
+           EnvironmentVariables::get("BELLE2_GEARBOX_CACHE_DIR", ""));
 }
 
 void GearboxModule::initialize()
@@ -80,6 +88,7 @@ void GearboxModule::initialize()
   }
 
   gearbox.setBackends(m_backends);
+  gearbox.setCacheDirectory(m_cacheDirectory);
   gearbox.open(m_fileName);
 }
 
@@ -93,3 +102,9 @@ void GearboxModule::beginRun()
   gearbox.close();
   gearbox.open(m_fileName);
 }
+
+void GearboxModule::terminate()
+{
+  // store all queries of this job for the next one
+  Gearbox::getInstance().writeCache();
+}
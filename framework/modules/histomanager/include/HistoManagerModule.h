@@ -31,6 +31,7 @@ namespace Belle2 {
   private:
     std::string m_workdir; /**< Name of working directory. */
     std::string m_histoFileName; /**< Name of histogram output file. */
+    int         m_sharedMemorySize; /**< Size in MB of the shared memory for histogram bins in parallel processing, 0 to merge files. */
     bool        m_initmain; /**< True if initialize() was called. */
     bool        m_tupleManagerInitialized; /**< True if RbTupleManager was initialized. */
   };
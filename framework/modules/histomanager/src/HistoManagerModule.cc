@@ -34,6 +34,12 @@ HistoManagerModule::HistoManagerModule() : Module(), m_initmain(false), m_tupleM
   // Parameters
   addParam("histoFileName", m_histoFileName, "Name of histogram output file.", string("histofile.root"));
   addParam("workDirName", m_workdir, "Name of working directory.", string("."));
+  addParam("sharedMemorySize", m_sharedMemorySize,
+           "Size in MB of the shared memory for the histogram bins in parallel processing. If larger than 0, all processes fill "
+           "the same histograms in shared memory, the totals are written at the end without merging files. Profiles and other "
+           "objects, histograms with extendable axes, bin labels or a fill buffer, or histograms that do not fit, are still "
+           "written to one file per process and merged. Shared histograms must not be rebinned. The memory is only allocated "
+           "when used.", 0);
 
 }
 
@@ -41,7 +47,8 @@ HistoManagerModule::~HistoManagerModule() = default;
 
 void HistoManagerModule::initialize()
 {
-  RbTupleManager::Instance().init(Environment::Instance().getNumberProcesses(), m_histoFileName.c_str(), m_workdir.c_str());
+  RbTupleManager::Instance().init(Environment::Instance().getNumberProcesses(), m_histoFileName.c_str(), m_workdir.c_str(),
+                                  m_sharedMemorySize);
 
   m_initmain = true;
   //  cout << "HistoManager::initialization done" << endl;
@@ -13,16 +13,21 @@
 #include <framework/core/Environment.h>
 #include <framework/dataobjects/FileMetaData.h>
 #include <framework/dataobjects/EventMetaData.h>
+#include <framework/io/EventIndex.h>
 
+#include <memory>
 #include <string>
 #include <vector>
 #include <set>
+#include <tuple>
 
 #include <TChain.h>
 #include <TFile.h>
 
 
 namespace Belle2 {
+  class RootInputPrefetcher;
+
   /** Module to read TTree data from file into the data store.
    *
    *  For more information consult the `basf2 Software Portal XWiki page <https://xwiki.desy.de/xwiki/rest/p/899ba>`_.
@@ -33,6 +38,19 @@ namespace Belle2 {
    *  The module supports reading from multiple files using TChain, entries will
    *  be read in the order the files are specified.
    *
+   *  With prefetchEntries > 0 the next entries are read in a background thread
+   *  (see RootInputPrefetcher), the time the event loop still has to wait for
+   *  them is added to the stall time in the module statistics.
+   *
+   *  With lazyLoading the event durability branches (except EventMetaData) are
+   *  only read once the object is accessed in the DataStore (see StoreEntryLoader).
+   *  At the end of the job the branches which were never accessed are listed.
+   *
+   *  An event index created with b2file-index (see EventIndex) can be given
+   *  with eventIndexFile. It is used to find events by experiment, run and
+   *  event number in the input and parent files. With indexedEvents the
+   *  input files and entries are taken from the index directly.
+   *
    *  @sa DataStore::EDurability
   */
   class RootInputModule : public Module {
@@ -68,12 +86,54 @@ namespace Belle2 {
       return inputFiles;
     }
 
+    /** for collecting statistics over multiple files. */
+    struct ReadStats {
+      long calls{0}; /**< number of read calls. */
+      long bytesRead{0}; /**< total number of bytes read. */
+      long bytesReadExtra{0}; /**< what TFile thinks was the overhead. */
+      /** add other stats object. */
+      void add(const ReadStats& b)
+      {
+        calls += b.calls;
+        bytesRead += b.bytesRead;
+        bytesReadExtra += b.bytesReadExtra;
+      }
+      /** add current statistics from TFile object. */
+      void addFromFile(const TFile* f)
+      {
+        calls += f->GetReadCalls();
+        bytesRead += f->GetBytesRead();
+        bytesReadExtra += f->GetBytesReadExtra();
+      }
+      /** string suitable for printing. */
+      std::string getString() const
+      {
+        std::string s;
+        s += "read: " + std::to_string(bytesRead) + " Bytes";
+        s += ", overhead: " + std::to_string(bytesReadExtra) + " Bytes";
+        s += ", Read() calls: " + std::to_string(calls);
+        return s;
+      }
+    };
+
   protected:
 
 
   private:
     typedef std::vector<DataStore::StoreEntry*> StoreEntries;   /**< Vector of entries in the data store. */
 
+    /** Reads one branch of the event tree once the DataStore entry is accessed, used with lazyLoading. */
+    struct LazyBranch : public StoreEntryLoader {
+      /** Module which reads the branch */
+      RootInputModule* module{nullptr};
+      /** Branch in the current file of the chain, nullptr if it doesn't exist there */
+      TBranch* branch{nullptr};
+      /** Number of events in which the branch was read */
+      long events{0};
+      /** Read the branch for the current entry */
+      void load(StoreEntry& entry) override { module->readLazyBranch(*this, entry); }
+    };
+
     /** Actually performs the reading from the tree */
     void readTree();
 
@@ -102,6 +162,33 @@ namespace Belle2 {
     /** For index files, this creates TEventList/TEntryListArray to enable better cache use. */
     void addEventListForIndexFile(const std::string& parentLfn);
 
+    /** Take the next entry from the prefetcher and swap its objects into the DataStore.
+     * @return number of bytes read, <= 0 on failure
+     */
+    int readPrefetchedEntry();
+
+    /** Mark all event durability entries as not read yet and only read EventMetaData.
+     * @return number of bytes read, <= 0 on failure
+     */
+    int readLazyEntry(long localEntry);
+
+    /** Read the branch of the given entry for the current event, called on first access with lazyLoading.
+     * @return number of bytes read
+     */
+    int readLazyBranch(LazyBranch& lazyBranch, DataStore::StoreEntry& entry);
+
+    /** Set the input files and entry sequences to the files and entries of m_indexedEvents in the event index. */
+    void selectIndexedEvents();
+
+    /** Return the chain entry of the given event using the event index, -1 if not found. */
+    long findIndexedEntry(int experiment, int run, unsigned int event) const;
+
+    /** Return the entry of the given event in a parent file, using the event index if possible. -1 if not found. */
+    long getParentEntry(TTree* tree, const std::string& lfn, int experiment, int run, unsigned int event) const;
+
+    /** Add time spent waiting for input data to the statistics of this module. */
+    void addStallTime(double time);
+
     /** Correct isMC flag for raw data recorded before experiment 8 run 2364. */
     void realDataWorkaround(FileMetaData& metaData);
 
@@ -148,6 +235,12 @@ namespace Belle2 {
     /** experiment, run, event number of first event to load */
     std::vector<int> m_skipToEvent;
 
+    /** Name of the event index file, empty to not use an index */
+    std::string m_eventIndexFile;
+
+    /** (experiment, run, event) of the events to read using the event index */
+    std::vector<std::tuple<int, int, unsigned int>> m_indexedEvents;
+
     //then those for purely internal use:
 
     /** Next entry to be read in event tree.  */
@@ -166,6 +259,12 @@ namespace Belle2 {
     /**  TTree for persistent input. */
     TChain* m_persistent;
 
+    /** Event index read from m_eventIndexFile */
+    EventIndex m_eventIndex;
+
+    /** LFNs of the files in m_tree, indexed by tree number */
+    std::vector<std::string> m_chainLfns;
+
     /** Already connected branches. */
     std::set<std::string> m_connectedBranches[DataStore::c_NDurabilityTypes];
 
@@ -180,42 +279,33 @@ namespace Belle2 {
     /** Map of file LFNs to trees */
     std::map<std::string, TTree*> m_parentTrees;
 
-    /** for collecting statistics over multiple files. */
-    struct ReadStats {
-      long calls{0}; /**< number of read calls. */
-      long bytesRead{0}; /**< total number of bytes read. */
-      long bytesReadExtra{0}; /**< what TFile thinks was the overhead. */
-      /** add other stats object. */
-      void add(const ReadStats& b)
-      {
-        calls += b.calls;
-        bytesRead += b.bytesRead;
-        bytesReadExtra += b.bytesReadExtra;
-      }
-      /** add current statistics from TFile object. */
-      void addFromFile(const TFile* f)
-      {
-        calls += f->GetReadCalls();
-        bytesRead += f->GetBytesRead();
-        bytesReadExtra += f->GetBytesReadExtra();
-      }
-      /** string suitable for printing. */
-      std::string getString() const
-      {
-        std::string s;
-        s += "read: " + std::to_string(bytesRead) + " Bytes";
-        s += ", overhead: " + std::to_string(bytesReadExtra) + " Bytes";
-        s += ", Read() calls: " + std::to_string(calls);
-        return s;
-      }
-    };
-
     /** some statistics for all files read so far. */
     ReadStats m_readStats;
 
     /** Input ROOT File Cache size in MB, <0 means default */
     int m_cacheSize{0};
 
+    /** Number of entries to read ahead in a background thread, 0 to disable */
+    unsigned int m_prefetchEntries{0};
+
+    /** Number of threads for ROOT implicit multi-threading when prefetching, 0 to disable */
+    int m_prefetchThreads{0};
+
+    /** Reads entries ahead if m_prefetchEntries > 0 */
+    std::unique_ptr<RootInputPrefetcher> m_prefetcher;
+
+    /** Only read event durability branches when they are accessed */
+    bool m_lazyLoading{false};
+
+    /** One for each element of m_storeEntries if m_lazyLoading is set */
+    std::vector<LazyBranch> m_lazyBranches;
+
+    /** Entry in the current file of the chain the lazily read branches belong to */
+    long m_lazyEntry{ -1};
+
+    /** File number in the chain m_lazyBranches point to */
+    int m_lazyTreeNumber{ -1};
+
     /** Discard events that have an error flag != 0 */
     bool m_discardErrorEvents{true};
     /** Don't issue a warning when discarding events if the error flag consists exclusively of flags in this mask */
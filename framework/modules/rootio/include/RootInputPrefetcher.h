@@ -0,0 +1,150 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <framework/modules/rootio/RootInputModule.h>
+#include <framework/datastore/StoreEntry.h>
+#include <framework/io/RootIOUtilities.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TChain;
+class TEventList;
+class TObject;
+
+namespace Belle2 {
+  /** Reads the next entries of the event tree in a background thread for RootInputModule.
+   *
+   * The prefetcher opens the input files a second time in its own TChain,
+   * so the TChain of the module can still be used for everything else
+   * (file names, index lookups, ...) in the main thread. The objects of
+   * an entry are read into separate objects which are swapped into the
+   * DataStore by the module, objects of previous events are handed back
+   * and reused.
+   *
+   * Up to a given number of entries are read ahead and kept in a queue.
+   * Entries are read in order, if the module wants to read a different
+   * entry the prefetcher has to be restarted.
+   *
+   * Optionally, ROOT implicit multi-threading is enabled to decompress
+   * and deserialize the branches of one entry in parallel. It is only
+   * enabled as long as the prefetcher exists and only used for its own
+   * chain, if it was already enabled before it is left untouched.
+   */
+  class RootInputPrefetcher {
+  public:
+    /** One entry read by the prefetcher */
+    struct Entry {
+      /** entry number as counted by the module, i.e. before applying the event list */
+      long entry{0};
+      /** entry number in the chain, after applying the event list */
+      long chainEntry{0};
+      /** entry number in the current file, or the (negative) return value of TChain::LoadTree() on failure */
+      long localEntry{0};
+      /** return value of TTree::GetEntry() */
+      int bytesRead{0};
+      /** one object per store entry, in the order given to the constructor. Can be nullptr if missing in the file */
+      std::vector<TObject*> objects;
+    };
+
+    /** Constructor.
+     *
+     * @param chain chain of the module, files and event list are copied from it
+     * @param storeEntries store entries to be read, the branches with these names will be read
+     * @param maxEntries maximal number of entries to read ahead
+     * @param nThreads number of threads for implicit multi-threading in ROOT while the prefetcher exists, 0 to not use it
+     * @param cacheSize TTreeCache size in bytes, <0 to use the ROOT default
+     */
+    RootInputPrefetcher(const TChain& chain, const std::vector<StoreEntry*>& storeEntries, unsigned int maxEntries,
+                        int nThreads, long cacheSize);
+
+    /** Destructor, stops the thread and deletes all objects it owns. */
+    ~RootInputPrefetcher();
+
+    /** no copy constructor */
+    RootInputPrefetcher(const RootInputPrefetcher&) = delete;
+    /** no assignment operator */
+    RootInputPrefetcher& operator=(const RootInputPrefetcher&) = delete;
+
+    /** Start reading ahead at the given entry, restarting the thread if needed. */
+    void start(long entry);
+
+    /** Stop the thread and discard all entries read so far. */
+    void stop();
+
+    /** Check whether the thread is running and the next entry it will return is the given one. */
+    bool isReading(long entry) const { return m_thread.joinable() and m_nextEntry == entry; }
+
+    /** Wait for the next entry and return it.
+     *
+     * The caller takes ownership of the objects of the returned entry,
+     * they should be given back with recycle() once they are no longer needed.
+     * Has to be called from the thread which called start().
+     *
+     * @param[out] entry the next entry
+     * @return time spent waiting for the entry
+     */
+    double next(Entry& entry);
+
+    /** Give back objects which are no longer needed so they can be reused. The vector is emptied. */
+    void recycle(std::vector<TObject*>& objects);
+
+    /** Return the read statistics of the files read by the prefetcher so far. */
+    RootInputModule::ReadStats getReadStats() const;
+
+  private:
+    /** Main loop of the reading thread. */
+    void readEntries();
+
+    /** Reset the objects of one entry before reading the next entry into them. */
+    void resetObjects(std::vector<TObject*>& objects);
+
+    /** Keeps implicit multi-threading enabled while the prefetcher exists, has to outlive the chain. */
+    std::unique_ptr<RootIOUtilities::ImplicitMTScope> m_implicitMT;
+    /** Our copy of the module's chain, only used by the reading thread. */
+    std::unique_ptr<TChain> m_chain;
+    /** Copy of the event list of the module's chain, if any. */
+    std::unique_ptr<TEventList> m_eventList;
+    /** Objects the branches are read into, addresses of the elements are connected to the branches. */
+    std::vector<StoreEntry> m_readEntries;
+    /** maximal number of entries in m_queue */
+    const unsigned int m_maxEntries;
+    /** number of threads for implicit multi-threading */
+    const int m_nThreads;
+
+    /** the reading thread */
+    std::thread m_thread;
+    /** protects all members below */
+    mutable std::mutex m_mutex;
+    /** notified when an entry was added to m_queue or reading stopped */
+    std::condition_variable m_entryReady;
+    /** notified when an entry was removed from m_queue or the thread should stop */
+    std::condition_variable m_spaceAvailable;
+    /** entries read but not yet taken */
+    std::deque<Entry> m_queue;
+    /** object sets given back by the module, to be reused */
+    std::vector<std::vector<TObject*>> m_freeObjects;
+    /** next entry the thread will read */
+    long m_readEntry{0};
+    /** next entry next() will return */
+    long m_nextEntry{0};
+    /** set to stop the thread */
+    bool m_stop{false};
+    /** set once the thread reached the end of the input or a read error, no further entries will be added */
+    bool m_done{false};
+    /** read statistics of files which are no longer read */
+    RootInputModule::ReadStats m_readStats;
+  };
+}
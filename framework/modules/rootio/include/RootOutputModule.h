@@ -14,12 +14,18 @@
 #include <framework/datastore/StoreObjPtr.h>
 #include <framework/dataobjects/FileMetaData.h>
 #include <framework/dataobjects/EventMetaData.h>
+#include <framework/io/RootIOUtilities.h>
 
 #include <TFile.h>
 #include <TTree.h>
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace Belle2 {
@@ -27,6 +33,11 @@ namespace Belle2 {
    *
    * You can use the RootInputModule to read the data back in.
    *
+   * With writerQueueDepth > 0 the event tree is filled in a separate thread:
+   * at the end of each event the objects are handed over to the writer, in exchange
+   * for objects of an already written event, and queued. Processing only waits if
+   * the queue is full. This time is added to the stall time in the module statistics.
+   *
    *  @sa DataStore::EDurability
    */
   class RootOutputModule : public Module {
@@ -78,6 +89,25 @@ namespace Belle2 {
 
   private:
 
+    /** Information about one event needed for the file metadata */
+    struct EventSummary {
+      unsigned long experiment{0}; /**< experiment number */
+      unsigned long run{0}; /**< run number */
+      unsigned long event{0}; /**< event number */
+      bool fullEvent{false}; /**< true if the event has no error flag */
+      std::vector<std::string> parentLfns; /**< LFNs of the parent files */
+    };
+
+    /** One event waiting to be written by the writer thread */
+    struct QueuedEvent {
+      /** objects of m_entries[c_Event] taken over from the DataStore, in the same order */
+      std::vector<std::unique_ptr<TObject>> objects;
+      /** whether each object was created in this event */
+      std::vector<bool> valid;
+      /** information for the file metadata */
+      EventSummary summary;
+    };
+
     /** Finalize the output file */
     void closeFile();
 
@@ -88,9 +118,46 @@ namespace Belle2 {
      *
      * Write the objects from the DataStore to the output TTree.
      *
+     * Branch addresses are only set again if the object of an entry changed.
+     *
      * @param durability Specifies map and tree to be used.
+     * @param writerObjects If true, write the objects in m_writerObjects instead of the ones in the DataStore
+     */
+    void fillTree(DataStore::EDurability durability, bool writerObjects = false);
+
+    /** Collect the information about the current event needed for the file metadata. */
+    EventSummary getEventSummary() const;
+
+    /** Update experiment/run/event range, number of full events and parents for the file metadata with one written event. */
+    void addEventSummary(const EventSummary& summary);
+
+    /** Check if the output file has reached outputSplitSize. */
+    bool needsSplit() const { return m_outputSplitSize and (uint64_t)m_file->GetEND() > *m_outputSplitSize; }
+
+    /** Take over the objects of the current event from the DataStore and queue them for the writer thread, waiting if the queue is full.
+     *
+     * Called at the end of the event, so modules after this one can still use the objects.
      */
-    void fillTree(DataStore::EDurability durability);
+    void queueEvent();
+
+    /** Enable ROOT implicit multi-threading for the event tree until terminate(). */
+    void enableImplicitMT();
+
+    /** Wait until at most the given number of events are in the queue, splitting the file if requested by the writer.
+     * @param maxQueued number of events which may still be in the queue
+     * @param reopen open the next file after splitting even if there are no more events in the queue
+     * @return time spent waiting
+     */
+    double waitForWriter(size_t maxQueued, bool reopen);
+
+    /** Main loop of the writer thread. */
+    void writeEvents();
+
+    /** Write all events still in the queue and stop the writer thread. */
+    void stopWriter();
+
+    /** Add time spent waiting for the writer to the statistics of this module. */
+    void addStallTime(double time);
 
     /** Create and fill FileMetaData object. */
     void fillFileMetaData();
@@ -155,6 +222,12 @@ namespace Belle2 {
      * if the event tree in output file has reached the given size in MB */
     std::optional<uint64_t> m_outputSplitSize{std::nullopt};
 
+    /** Maximal number of events waiting for the writer thread, 0 to write the events directly */
+    unsigned int m_writerQueueDepth{0};
+
+    /** Number of threads for ROOT implicit multi-threading, used to compress baskets in parallel. 0 to disable */
+    int m_writerThreads{0};
+
     //then those for purely internal use:
 
     /** Keep track of the file index: if we split files than we add '.f{fileIndex:05d}' in front of the ROOT extension */
@@ -172,6 +245,9 @@ namespace Belle2 {
     /** Vector of DataStore entries that are written to the output. */
     std::vector<DataStore::StoreEntry*> m_entries[DataStore::c_NDurabilityTypes];
 
+    /** Objects the branches of each tree currently point to, in the same order as m_entries. */
+    std::vector<const TObject*> m_branchObjects[DataStore::c_NDurabilityTypes];
+
     /** Vector of parent file LFNs. */
     std::vector<std::string> m_parentLfns;
 
@@ -217,5 +293,38 @@ namespace Belle2 {
     StoreObjPtr<FileMetaData> m_fileMetaData{"", DataStore::c_Persistent};
     /** File meta data stored in the output file */
     FileMetaData* m_outputFileMetaData;
+
+    /** Thread filling the event tree if m_writerQueueDepth > 0 */
+    std::thread m_writer;
+    /** Protects the queue and the flags used to communicate with the writer thread */
+    std::mutex m_writerMutex;
+    /** Notified when the writer thread has something to do */
+    std::condition_variable m_writerWakeup;
+    /** Notified when the writer thread finished an event */
+    std::condition_variable m_writerDone;
+    /** Events waiting to be written. The writer removes an event only after writing it */
+    std::deque<QueuedEvent> m_writerQueue;
+    /** Written events, their buffers are reused for the next events */
+    std::vector<QueuedEvent> m_freeEvents;
+    /** Objects of the event the writer thread is writing, in the same order as m_entries[c_Event]. The branches of the event tree point to these. */
+    std::vector<TObject*> m_writerObjects;
+    /** Set in event() if the objects of the current event have to be queued at its end */
+    bool m_eventPending{false};
+    /** Whether each object was created when event() was called, for the pending event */
+    std::vector<bool> m_pendingValid;
+    /** Information for the file metadata of the pending event */
+    EventSummary m_pendingSummary;
+    /** Keeps ROOT implicit multi-threading enabled while it is needed for writerThreads */
+    std::unique_ptr<RootIOUtilities::ImplicitMTScope> m_implicitMT;
+    /** Set to stop the writer thread */
+    bool m_writerStop{false};
+    /** Set by the writer once outputSplitSize is reached, it waits until the file is replaced */
+    bool m_splitRequested{false};
+    /** Number of events queued for the writer thread */
+    unsigned long m_queuedEvents{0};
+    /** Number of events which had to wait for space in the queue */
+    unsigned long m_queueFullEvents{0};
+    /** Total time spent waiting for the writer thread */
+    double m_writerWaitTime{0};
   };
 } // end namespace Belle2
@@ -35,6 +35,9 @@ namespace Belle2 {
     virtual void terminate() override;
 
   private:
+    //! Skip m_skipNEvents events after the StreamerInfo of the first file
+    void skipEvents();
+
     //! File name
     std::string m_inputFileName{""};
     //! List of all file names to read
@@ -46,6 +49,12 @@ namespace Belle2 {
     //! Is the input real data?
     bool m_realData{false};
 
+    //! Number of events to skip at the beginning of the first file
+    int m_skipNEvents{0};
+
+    //! Number of threads reading and decompressing blocks ahead for the block format
+    int m_decompressionThreads{0};
+
     //! Blocked file handler
     SeqFile* m_file{nullptr};
 
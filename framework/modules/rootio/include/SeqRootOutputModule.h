@@ -54,6 +54,15 @@ namespace Belle2 {
     //! Compression level
     int m_compressionLevel;
 
+    //! ROOT compression setting for the block format, 0 for the classic format
+    int m_blockCompression{0};
+
+    //! Uncompressed size of one block in kB
+    int m_blockSize{4096};
+
+    //! Number of threads compressing blocks
+    int m_compressionThreads{0};
+
     //! Blocked file handler
     SeqFile* m_file;
 
@@ -8,11 +8,13 @@
 
 
 #include <framework/modules/rootio/RootInputModule.h>
+#include <framework/modules/rootio/RootInputPrefetcher.h>
 
 #include <framework/io/RootIOUtilities.h>
 #include <framework/io/RootFileInfo.h>
 #include <framework/core/FileCatalog.h>
 #include <framework/core/InputController.h>
+#include <framework/core/ProcessStatistics.h>
 #include <framework/pcore/Mergeable.h>
 #include <framework/datastore/StoreObjPtr.h>
 #include <framework/datastore/DataStore.h>
@@ -20,6 +22,7 @@
 #include <framework/dataobjects/EventMetaData.h>
 #include <framework/utilities/NumberSequence.h>
 #include <framework/utilities/ScopeGuard.h>
+#include <framework/utilities/Utils.h>
 #include <framework/database/Configuration.h>
 
 #include <TClonesArray.h>
@@ -28,6 +31,7 @@
 #include <TChainElement.h>
 #include <TError.h>
 
+#include <algorithm>
 #include <iomanip>
 
 using namespace std;
@@ -61,6 +65,13 @@ RootInputModule::RootInputModule() : Module(), m_nextEntry(0), m_lastPersistentE
   addParam("skipToEvent", m_skipToEvent, "Skip events until the event with "
            "the specified (experiment, run, event number) occurs. This parameter "
            "is useful for debugging to start with a specific event.", m_skipToEvent);
+  addParam("eventIndexFile", m_eventIndexFile,
+           "Event index created with b2file-index. If given, it is used to find the entries for skipToEvent and "
+           "in the parent files without building a TTreeIndex for each file.", m_eventIndexFile);
+  addParam("indexedEvents", m_indexedEvents,
+           "List of (experiment, run, event) to read. Requires eventIndexFile, the input files and entries are taken "
+           "from the index (LFNs are converted using the file catalog), so inputFileNames and entrySequences must not be "
+           "given. Events are read in the order of the files and entries.", m_indexedEvents);
 
   addParam(c_SteerBranchNames[0], m_branchNames[0],
            "Names of event durability branches to be read. Empty means all branches. (EventMetaData is always read)", emptyvector);
@@ -82,6 +93,19 @@ RootInputModule::RootInputModule() : Module(), m_nextEntry(0), m_lastPersistentE
            false);
   addParam("cacheSize", m_cacheSize,
            "file cache size in Mbytes. If negative, use root default", 0);
+  addParam("prefetchEntries", m_prefetchEntries,
+           "Number of entries to read ahead in a background thread while the current event is processed. 0 disables "
+           "prefetching. The input files are opened a second time for this. The time the event loop still has to wait "
+           "for the data is shown as stall time in the module statistics.", m_prefetchEntries);
+  addParam("prefetchThreads", m_prefetchThreads,
+           "Number of threads ROOT uses to decompress and deserialize the branches of one entry in parallel "
+           "(implicit multi-threading) if prefetchEntries > 0. It is only used for the prefetched branches and switched off "
+           "again at the end of processing, unless it was already enabled before. 0 disables implicit multi-threading.", m_prefetchThreads);
+  addParam("lazyLoading", m_lazyLoading,
+           "Only read the event durability objects once they are accessed in the DataStore (EventMetaData is always read). "
+           "At the end of the job the branches which were never accessed are listed, they can be excluded with "
+           "excludeBranchNames. Output modules and parallel processing still need all objects, so this only helps if "
+           "the objects are not written out. Cannot be combined with prefetchEntries.", m_lazyLoading);
 
   addParam("discardErrorEvents", m_discardErrorEvents,
            "Discard events with an error flag != 0", m_discardErrorEvents);
@@ -108,10 +132,31 @@ void RootInputModule::initialize()
   if (entrySequencesOverride.size() > 0)
     m_entrySequences = entrySequencesOverride;
 
+  if (m_prefetchThreads < 0) {
+    B2ERROR("prefetchThreads must be >= 0!");
+  }
+  if (m_lazyLoading and m_prefetchEntries > 0) {
+    B2ERROR("lazyLoading cannot be combined with prefetchEntries, disabling prefetching");
+    m_prefetchEntries = 0;
+  }
+
   m_nextEntry = m_skipNEvents;
   m_lastPersistentEntry = -1;
   m_lastParentFileLFN = "";
 
+  if (!m_eventIndexFile.empty()) {
+    try {
+      m_eventIndex.open(m_eventIndexFile);
+    } catch (std::exception& e) {
+      B2FATAL("Cannot read event index" << LogVar("filename", m_eventIndexFile) << LogVar("error", e.what()));
+    }
+    B2DEBUG(30, "Opened event index" << LogVar("filename", m_eventIndexFile)
+            << LogVar("events", m_eventIndex.getNumberOfEvents()) << LogVar("files", m_eventIndex.getLfns().size()));
+  }
+  if (!m_indexedEvents.empty()) {
+    selectIndexedEvents();
+  }
+
   const vector<string>& inputFiles = getFileNames();
   if (inputFiles.empty()) {
     B2FATAL("You have to set either the 'inputFileName' or the 'inputFileNames' parameter, or start basf2 with the '-i MyFile.root' option.");
@@ -217,6 +262,7 @@ void RootInputModule::initialize()
         if (m_tree->AddFile(fileName.c_str(), meta.getNEvents()) == 0 || m_persistent->AddFile(fileName.c_str(), 1) == 0) {
           throw std::runtime_error("Could not add file to TChain");
         }
+        m_chainLfns.push_back(meta.getLfn());
         B2INFO("Added file " + fileName);
       } catch (std::exception& e) {
         B2FATAL("Could not open input file " << std::quoted(fileName) << ": " << e.what());
@@ -292,6 +338,18 @@ void RootInputModule::initialize()
     InputController::setCanControlInput(true);
     InputController::setChain(m_tree, m_isSecondaryInput);
   }
+  if (m_tree and m_lazyLoading) {
+    m_lazyBranches.resize(m_storeEntries.size());
+    for (LazyBranch& lazyBranch : m_lazyBranches) {
+      lazyBranch.module = this;
+    }
+  }
+  // the thread is only started with the first event, i.e. after forking for parallel processing
+  if (m_tree and m_prefetchEntries > 0) {
+    const long cacheSize = (m_cacheSize >= 0) ? m_cacheSize * 1024l * 1024l : -1;
+    m_prefetcher = std::make_unique<RootInputPrefetcher>(*m_tree, m_storeEntries, m_prefetchEntries, m_prefetchThreads,
+                                                         cacheSize);
+  }
 
   if (m_parentLevel > 0) {
     createParentStoreEntries();
@@ -357,9 +415,15 @@ void RootInputModule::event()
       m_nextEntry = nextEntry;
     } else if (InputController::getNextExperiment() >= 0 && InputController::getNextRun() >= 0
                && InputController::getNextEvent() >= 0) {
-      const long entry = RootIOUtilities::getEntryNumberWithEvtRunExp(m_tree->GetTree(), InputController::getNextEvent(),
-                         InputController::getNextRun(), InputController::getNextExperiment());
-      if (entry >= 0) {
+      // with an index we can jump to any file, otherwise we can only search the current one
+      const long indexedEntry = m_eventIndex.isOpen() ? findIndexedEntry(InputController::getNextExperiment(),
+                                InputController::getNextRun(), InputController::getNextEvent()) : -1;
+      const long entry = (indexedEntry >= 0) ? -1 : RootIOUtilities::getEntryNumberWithEvtRunExp(m_tree->GetTree(),
+                         InputController::getNextEvent(), InputController::getNextRun(), InputController::getNextExperiment());
+      if (indexedEntry >= 0) {
+        B2INFO("RootInput: will read entry " << indexedEntry << " (found in event index) next.");
+        m_nextEntry = indexedEntry;
+      } else if (entry >= 0) {
         const long chainentry = m_tree->GetChainEntryNumber(entry);
         B2INFO("RootInput: will read entry " << chainentry << " (entry " << entry << " in current file) next.");
         m_nextEntry = chainentry;
@@ -394,10 +458,33 @@ void RootInputModule::event()
 
 void RootInputModule::terminate()
 {
-  if (m_collectStatistics and m_tree) {
+  if (m_prefetcher) {
+    m_prefetcher->stop();
+    //the entries were read by the prefetcher
+    if (m_collectStatistics)
+      m_readStats.add(m_prefetcher->getReadStats());
+    m_prefetcher.reset();
+  } else if (m_collectStatistics and m_tree) {
     //add stats for last file
     m_readStats.addFromFile(m_tree->GetFile());
   }
+  if (!m_lazyBranches.empty()) {
+    std::string unusedBranches;
+    for (size_t i = 0; i < m_lazyBranches.size(); ++i) {
+      if (m_lazyBranches[i].events > 0) continue;
+      if (!unusedBranches.empty()) unusedBranches += ", ";
+      unusedBranches += m_storeEntries[i]->name;
+    }
+    if (!unusedBranches.empty()) {
+      B2INFO("RootInput: some branches were never accessed, they could be excluded with excludeBranchNames"
+             << LogVar("branches", unusedBranches));
+    }
+    //nothing can be read anymore
+    for (auto entry : m_storeEntries) {
+      entry->loader = nullptr;
+    }
+    m_lazyBranches.clear();
+  }
   delete m_tree;
   delete m_persistent;
   ReadStats parentReadStats;
@@ -419,6 +506,8 @@ void RootInputModule::terminate()
   }
   m_storeEntries.clear();
   m_persistentStoreEntries.clear();
+  m_chainLfns.clear();
+  m_eventIndex.close();
   m_parentStoreEntries.clear();
   m_parentTrees.clear();
 }
@@ -431,7 +520,7 @@ void RootInputModule::readTree()
 
   //keep snapshot of TFile stats (to use if it changes)
   ReadStats currentEventStats;
-  if (m_collectStatistics) {
+  if (m_collectStatistics and !m_prefetcher) {
     currentEventStats.addFromFile(m_tree->GetFile());
   }
 
@@ -452,8 +541,10 @@ void RootInputModule::readTree()
   B2DEBUG(39, "Reading file entry " << m_nextEntry);
 
   //Make sure transient members of objects are reinitialised
-  for (auto entry : m_storeEntries) {
-    entry->resetForGetEntry();
+  if (!m_prefetcher and !m_lazyLoading) {
+    for (auto entry : m_storeEntries) {
+      entry->resetForGetEntry();
+    }
   }
   for (const auto& storeEntries : m_parentStoreEntries) {
     for (auto entry : storeEntries) {
@@ -461,7 +552,16 @@ void RootInputModule::readTree()
     }
   }
 
-  int bytesRead = m_tree->GetTree()->GetEntry(localEntryNumber);
+  int bytesRead = 0;
+  if (m_prefetcher) {
+    bytesRead = readPrefetchedEntry();
+  } else if (m_lazyLoading) {
+    bytesRead = readLazyEntry(localEntryNumber);
+  } else {
+    const double start = Utils::getClock();
+    bytesRead = m_tree->GetTree()->GetEntry(localEntryNumber);
+    addStallTime(Utils::getClock() - start);
+  }
   if (bytesRead <= 0) {
     B2FATAL("Could not read 'tree' entry " << m_nextEntry << " in file " << m_tree->GetCurrentFile()->GetName());
   }
@@ -477,7 +577,7 @@ void RootInputModule::readTree()
   const long treeNum = m_tree->GetTreeNumber();
   const bool fileChanged = (m_lastPersistentEntry != treeNum);
   if (fileChanged) {
-    if (m_collectStatistics) {
+    if (m_collectStatistics and !m_prefetcher) {
       m_readStats.add(currentEventStats);
     }
     // file changed, read the FileMetaData object from the persistent tree and update the parent file metadata
@@ -489,6 +589,8 @@ void RootInputModule::readTree()
   realDataWorkaround(*fileMetaData);
 
   for (auto entry : m_storeEntries) {
+    //not read yet, see readLazyBranch()
+    if (entry->loader) continue;
     if (!entry->object) {
       entryNotFound("Event durability tree (global entry: " + std::to_string(m_nextEntry) + ")", entry->name, fileChanged);
       entry->recoverFromNullObject();
@@ -506,7 +608,7 @@ void RootInputModule::readTree()
   // Nooow, if the object didn't exist in the event when we wrote it to File we still have it in the file but it's marked as invalid Object.
   // So go through everything and check for the bit and invalidate as necessary
   for (auto entry : m_storeEntries) {
-    if (entry->object->TestBit(kInvalidObject)) entry->invalidate();
+    if (!entry->loader and entry->object->TestBit(kInvalidObject)) entry->invalidate();
   }
   for (const auto& storeEntries : m_parentStoreEntries) {
     for (auto entry : storeEntries) {
@@ -515,6 +617,80 @@ void RootInputModule::readTree()
   }
 }
 
+int RootInputModule::readPrefetchedEntry()
+{
+  //start reading ahead with the first event or after we jumped to another entry
+  if (!m_prefetcher->isReading(m_nextEntry)) {
+    m_prefetcher->start(m_nextEntry);
+  }
+  RootInputPrefetcher::Entry entry;
+  addStallTime(m_prefetcher->next(entry));
+  if (entry.localEntry < 0) return 0;
+
+  //the objects of the previous event are reused for the next entries
+  for (size_t i = 0; i < m_storeEntries.size(); ++i) {
+    std::swap(m_storeEntries[i]->object, entry.objects[i]);
+  }
+  m_prefetcher->recycle(entry.objects);
+  return entry.bytesRead;
+}
+
+int RootInputModule::readLazyEntry(long localEntry)
+{
+  m_lazyEntry = localEntry;
+  const int treeNumber = m_tree->GetTreeNumber();
+  if (treeNumber != m_lazyTreeNumber) {
+    //branch addresses are set by the chain when loading the tree
+    for (size_t i = 0; i < m_storeEntries.size(); ++i) {
+      m_lazyBranches[i].branch = m_tree->GetTree()->GetBranch(m_storeEntries[i]->name.c_str());
+    }
+    m_lazyTreeNumber = treeNumber;
+  }
+
+  int bytesRead = 0;
+  for (size_t i = 0; i < m_storeEntries.size(); ++i) {
+    DataStore::StoreEntry* entry = m_storeEntries[i];
+    entry->ptr = nullptr;
+    entry->loader = &m_lazyBranches[i];
+    //we need this one ourselves
+    if (entry->name == "EventMetaData") {
+      const double start = Utils::getClock();
+      bytesRead = readLazyBranch(m_lazyBranches[i], *entry);
+      addStallTime(Utils::getClock() - start);
+    }
+  }
+  return bytesRead;
+}
+
+int RootInputModule::readLazyBranch(LazyBranch& lazyBranch, DataStore::StoreEntry& entry)
+{
+  entry.loader = nullptr;
+  entry.resetForGetEntry();
+  const int bytesRead = lazyBranch.branch ? lazyBranch.branch->GetEntry(m_lazyEntry) : 0;
+  if (bytesRead < 0) {
+    B2FATAL("Could not read branch " << entry.name << " of entry " << m_lazyEntry << " in file " << m_tree->GetCurrentFile()->GetName());
+  }
+  ++lazyBranch.events;
+
+  //same as readTree() does for all entries
+  if (!entry.object) {
+    entryNotFound("Event durability tree (entry " + std::to_string(m_lazyEntry) + " in current file)", entry.name, false);
+    entry.recoverFromNullObject();
+    entry.ptr = nullptr;
+  } else {
+    entry.ptr = entry.object;
+  }
+  if (entry.object->TestBit(kInvalidObject)) entry.invalidate();
+  return bytesRead;
+}
+
+void RootInputModule::addStallTime(double time)
+{
+  StoreObjPtr<ProcessStatistics> processStatistics("", DataStore::c_Persistent);
+  if (processStatistics)
+    processStatistics->getStatistics(this).addStallTime(time);
+}
+
 bool RootInputModule::connectBranches(TTree* tree, DataStore::EDurability durability, StoreEntries* storeEntries)
 {
   B2DEBUG(30, "File changed, loading persistent data.");
@@ -629,7 +805,7 @@ bool RootInputModule::createParentStoreEntries()
     // get parent LFN of parent
     EventMetaData* metaData = nullptr;
     tree->SetBranchAddress("EventMetaData", &metaData);
-    long entry = RootIOUtilities::getEntryNumberWithEvtRunExp(tree, event, run, experiment);
+    long entry = getParentEntry(tree, parentLfn, experiment, run, event);
     tree->GetBranch("EventMetaData")->GetEntry(entry);
     parentLfn = metaData->getParentLfn();
   }
@@ -674,7 +850,7 @@ bool RootInputModule::readParentTrees()
     }
 
     // get entry number in parent tree
-    long entryNumber = RootIOUtilities::getEntryNumberWithEvtRunExp(tree, event, run, experiment);
+    long entryNumber = getParentEntry(tree, parentLfn, experiment, run, event);
     if (entryNumber < 0) {
       B2ERROR("No event " << experiment << "/" << run << "/" << event << " in parent file " << parentPfn);
       return false;
@@ -697,6 +873,59 @@ bool RootInputModule::readParentTrees()
   return true;
 }
 
+long RootInputModule::getParentEntry(TTree* tree, const std::string& lfn, int experiment, int run, unsigned int event) const
+{
+  if (m_eventIndex.isOpen()) {
+    const long entry = m_eventIndex.find(experiment, run, event, lfn).entry;
+    if (entry >= 0) return entry;
+  }
+  return RootIOUtilities::getEntryNumberWithEvtRunExp(tree, event, run, experiment);
+}
+
+void RootInputModule::selectIndexedEvents()
+{
+  if (!m_eventIndex.isOpen()) {
+    B2FATAL("indexedEvents can only be used together with eventIndexFile");
+  }
+  if (!m_inputFileName.empty() or !m_inputFileNames.empty() or !m_entrySequences.empty()) {
+    B2FATAL("The input files and entries are taken from the event index with indexedEvents, "
+            "inputFileName(s) and entrySequences cannot be used at the same time");
+  }
+  // one entry sequence for each file, in the order the files are first needed
+  std::map<std::string, size_t> fileNumbers;
+  for (const auto& [experiment, run, event] : m_indexedEvents) {
+    const EventIndex::Location location = m_eventIndex.find(experiment, run, event);
+    if (location.entry < 0) {
+      B2ERROR("Event not found in event index" << LogVar("experiment", experiment) << LogVar("run", run) << LogVar("event", event));
+      continue;
+    }
+    const auto [it, inserted] = fileNumbers.emplace(location.lfn, m_inputFileNames.size());
+    if (inserted) {
+      m_inputFileNames.push_back(FileCatalog::Instance().getPhysicalFileName(location.lfn));
+      m_entrySequences.emplace_back();
+    }
+    std::string& sequence = m_entrySequences[it->second];
+    if (!sequence.empty()) sequence += ",";
+    sequence += std::to_string(location.entry);
+  }
+  if (m_inputFileNames.empty()) {
+    B2FATAL("None of the indexedEvents were found in the event index");
+  }
+  // the files from the index are the input files, don't replace them with the ones given with -i
+  m_ignoreCommandLineOverride = true;
+}
+
+long RootInputModule::findIndexedEntry(int experiment, int run, unsigned int event) const
+{
+  for (const EventIndex::Location& location : m_eventIndex.findAll(experiment, run, event)) {
+    const auto it = std::find(m_chainLfns.begin(), m_chainLfns.end(), location.lfn);
+    if (it != m_chainLfns.end()) {
+      return m_tree->GetTreeOffset()[it - m_chainLfns.begin()] + location.entry;
+    }
+  }
+  return -1;
+}
+
 void RootInputModule::addEventListForIndexFile(const std::string& parentLfn)
 {
   //is this really an index file? (=only EventMetaData stored)
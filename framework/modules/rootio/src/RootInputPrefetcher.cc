@@ -0,0 +1,202 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/modules/rootio/RootInputPrefetcher.h>
+
+#include <framework/utilities/Utils.h>
+
+#include <TChain.h>
+#include <TChainElement.h>
+#include <TEventList.h>
+#include <TFile.h>
+#include <TObjArray.h>
+#include <TROOT.h>
+
+using namespace Belle2;
+
+RootInputPrefetcher::RootInputPrefetcher(const TChain& chain, const std::vector<StoreEntry*>& storeEntries,
+                                         unsigned int maxEntries, int nThreads, long cacheSize):
+  m_implicitMT(nThreads > 0 ? std::make_unique<RootIOUtilities::ImplicitMTScope>(nThreads) : nullptr),
+  m_chain(std::make_unique<TChain>(chain.GetName())), m_maxEntries(maxEntries), m_nThreads(nThreads)
+{
+  // the trees of the module's chain keep the setting they were created with, only our own trees use it
+  m_chain->SetImplicitMT(m_nThreads > 0);
+  // open the same files with the same number of entries, files are only opened once we read from them
+  TIter next(chain.GetListOfFiles());
+  while (auto* element = static_cast<TChainElement*>(next())) {
+    m_chain->AddFile(element->GetTitle(), element->GetEntries());
+  }
+  if (const TEventList* eventList = chain.GetEventList()) {
+    m_eventList.reset(static_cast<TEventList*>(eventList->Clone()));
+    m_chain->SetEventList(m_eventList.get());
+  }
+  if (cacheSize >= 0) m_chain->SetCacheSize(cacheSize);
+
+  // only read the branches the module reads, into our own set of objects
+  m_chain->SetBranchStatus("*", false);
+  m_readEntries.reserve(storeEntries.size());
+  for (const StoreEntry* entry : storeEntries) {
+    m_readEntries.emplace_back(*entry);
+    m_readEntries.back().object = nullptr;
+    m_readEntries.back().ptr = nullptr;
+  }
+  // addresses have to stay valid, so only connect them once the vector is complete
+  for (StoreEntry& entry : m_readEntries) {
+    m_chain->SetBranchStatus(entry.name.c_str(), true);
+    m_chain->SetBranchAddress(entry.name.c_str(), &entry.object);
+  }
+}
+
+RootInputPrefetcher::~RootInputPrefetcher()
+{
+  stop();
+  for (auto& objects : m_freeObjects) {
+    for (TObject* object : objects) delete object;
+  }
+  for (StoreEntry& entry : m_readEntries) {
+    delete entry.object;
+  }
+  // the chain keeps a pointer to the event list
+  m_chain.reset();
+  // switches implicit multi-threading off again if we enabled it
+  m_implicitMT.reset();
+}
+
+void RootInputPrefetcher::start(long entry)
+{
+  stop();
+  // the thread reads from other files than the main thread
+  ROOT::EnableThreadSafety();
+  LogSystem::Instance().enableThreadSafety();
+  m_readEntry = entry;
+  m_nextEntry = entry;
+  m_stop = false;
+  m_done = false;
+  m_thread = std::thread(&RootInputPrefetcher::readEntries, this);
+}
+
+void RootInputPrefetcher::stop()
+{
+  if (!m_thread.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_spaceAvailable.notify_one();
+  m_thread.join();
+  LogSystem::Instance().disableThreadSafety();
+  // keep the objects of the discarded entries for later
+  for (Entry& entry : m_queue) {
+    m_freeObjects.emplace_back(std::move(entry.objects));
+  }
+  m_queue.clear();
+}
+
+double RootInputPrefetcher::next(Entry& entry)
+{
+  const double start = Utils::getClock();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_entryReady.wait(lock, [this]() { return !m_queue.empty() or m_done; });
+  const double waitTime = Utils::getClock() - start;
+  if (m_queue.empty()) {
+    // the thread stopped without adding the entry, this shouldn't happen as it always adds the failed entry
+    entry = Entry();
+    entry.entry = m_nextEntry;
+    entry.localEntry = -2;
+    return waitTime;
+  }
+  entry = std::move(m_queue.front());
+  m_queue.pop_front();
+  m_nextEntry = entry.entry + 1;
+  lock.unlock();
+  m_spaceAvailable.notify_one();
+  return waitTime;
+}
+
+void RootInputPrefetcher::recycle(std::vector<TObject*>& objects)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_freeObjects.emplace_back(std::move(objects));
+  objects.clear();
+}
+
+RootInputModule::ReadStats RootInputPrefetcher::getReadStats() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  RootInputModule::ReadStats stats = m_readStats;
+  // the current file only if the thread is not using it at the moment
+  if (!m_thread.joinable() and m_chain->GetCurrentFile()) stats.addFromFile(m_chain->GetCurrentFile());
+  return stats;
+}
+
+void RootInputPrefetcher::resetObjects(std::vector<TObject*>& objects)
+{
+  objects.resize(m_readEntries.size(), nullptr);
+  for (size_t i = 0; i < m_readEntries.size(); ++i) {
+    if (!objects[i]) continue;
+    // same as the module does with the DataStore entries before reading
+    m_readEntries[i].object = objects[i];
+    m_readEntries[i].resetForGetEntry();
+    objects[i] = m_readEntries[i].object;
+  }
+}
+
+void RootInputPrefetcher::readEntries()
+{
+  const long nEntries = m_chain->GetEntries();
+  while (true) {
+    Entry entry;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_spaceAvailable.wait(lock, [this]() { return m_stop or m_queue.size() < m_maxEntries; });
+      if (m_stop) return;
+      if (!m_freeObjects.empty()) {
+        entry.objects = std::move(m_freeObjects.back());
+        m_freeObjects.pop_back();
+      }
+    }
+
+    entry.entry = m_readEntry++;
+    entry.chainEntry = m_eventList ? m_chain->GetEntryNumber(entry.entry) : entry.entry;
+    if (entry.chainEntry < 0 or entry.chainEntry >= nEntries) {
+      entry.localEntry = -2;
+    } else {
+      // the chain closes the current file when loading the next one, so collect the statistics now
+      const int treeNumber = m_chain->GetTreeNumber();
+      TFile* currentFile = m_chain->GetCurrentFile();
+      if (currentFile and (entry.chainEntry < m_chain->GetTreeOffset()[treeNumber]
+                           or entry.chainEntry >= m_chain->GetTreeOffset()[treeNumber + 1])) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_readStats.addFromFile(currentFile);
+      }
+      entry.localEntry = m_chain->LoadTree(entry.chainEntry);
+    }
+
+    if (entry.localEntry >= 0) {
+      resetObjects(entry.objects);
+      for (size_t i = 0; i < m_readEntries.size(); ++i) {
+        m_readEntries[i].object = entry.objects[i];
+      }
+      entry.bytesRead = m_chain->GetTree()->GetEntry(entry.localEntry);
+      for (size_t i = 0; i < m_readEntries.size(); ++i) {
+        entry.objects[i] = m_readEntries[i].object;
+        m_readEntries[i].object = nullptr;
+      }
+    }
+
+    const bool failed = entry.localEntry < 0 or entry.bytesRead <= 0;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_queue.emplace_back(std::move(entry));
+      // the module handles end of data and errors, nothing more to read for us
+      if (failed) m_done = true;
+    }
+    m_entryReady.notify_one();
+    if (failed) return;
+  }
+}
@@ -13,16 +13,20 @@
 #include <framework/io/RootIOUtilities.h>
 #include <framework/core/FileCatalog.h>
 #include <framework/core/MetadataService.h>
+#include <framework/core/ProcessStatistics.h>
 #include <framework/core/RandomNumbers.h>
 #include <framework/database/Database.h>
 // needed for complex module parameter
 #include <framework/core/ModuleParam.templateDetails.h>
 #include <framework/utilities/EnvironmentVariables.h>
+#include <framework/utilities/Utils.h>
+#include <framework/gearbox/Unit.h>
 
 #include <boost/format.hpp>
 #include <boost/algorithm/string.hpp>
 
 #include <TClonesArray.h>
+#include <TROOT.h>
 
 #include <regex>
 #include <filesystem>
@@ -123,6 +127,26 @@ Warning:
 
 .. versionadded:: release-03-00-00
 )DOC", m_outputSplitSize);
+  addParam("writerQueueDepth", m_writerQueueDepth, R"DOC(
+If larger than zero, fill the event tree in a separate thread. At the end of
+each event its objects are handed over to the writer thread, in exchange for
+the objects of an already written event, and up to this many events are kept
+in a queue. Processing only has to wait if the queue is full. This time is
+shown as stall time in the module statistics. Zero writes each event directly.
+
+This only helps if filling the tree is a significant part of the processing
+time, e.g. with strong compression. Compare the event processing time with
+and without it, a summary of the waiting time is printed at the end.
+
+Note:
+  The objects are written as they are at the end of the event, so changes by
+  modules after RootOutput end up in the file. With the threaded event
+  processor the events are written directly.)DOC", m_writerQueueDepth);
+  addParam("writerThreads", m_writerThreads,
+           "Number of threads ROOT uses to compress the baskets of the event tree in parallel when they are flushed "
+           "(implicit multi-threading). ROOT implicit multi-threading is a global setting: it is enabled "
+           "until the end of processing unless it was enabled before, and other trees created meanwhile "
+           "use it as well. 0 leaves it disabled.", m_writerThreads);
 
   m_outputFileMetaData = new FileMetaData;
 }
@@ -130,6 +154,8 @@ Warning:
 
 RootOutputModule::~RootOutputModule()
 {
+  stopWriter();
+  DataStore::Instance().removeEndOfEventCallbacks(this);
   delete m_outputFileMetaData;
 }
 
@@ -150,6 +176,14 @@ void RootOutputModule::initialize()
     // convert to bytes
     *m_outputSplitSize *= 1024 * 1024;
   }
+  if (m_writerThreads < 0) B2ERROR("writerThreads must be >= 0");
+  if (m_writerQueueDepth > 0) {
+    DataStore::Instance().addEndOfEventCallback(this, [this]() { queueEvent(); });
+  }
+  // with parallel processing the other processes are forked from this one after initialize(), so the threads are only started with the first event
+  if (m_writerThreads > 0 and Environment::Instance().getNumberProcesses() == 0) {
+    enableImplicitMT();
+  }
 
   getFileNames();
 
@@ -217,6 +251,8 @@ void RootOutputModule::openFile()
     m_tree[durability] = new TTree(c_treeNames[durability].c_str(), c_treeNames[durability].c_str());
     m_tree[durability]->SetAutoFlush(m_autoflush);
     m_tree[durability]->SetAutoSave(m_autosave);
+    // only the event tree is large enough to profit from compressing baskets in parallel
+    m_tree[durability]->SetImplicitMT(durability == DataStore::c_Event and m_implicitMT);
     for (auto & iter : map) {
       const std::string& branchName = iter.first;
       //skip transient entries (allow overriding via branchNames)
@@ -273,6 +309,7 @@ void RootOutputModule::openFile()
       }
       m_tree[durability]->Branch(branchName.c_str(), &iter.second.object, m_basketsize, splitLevel);
       m_entries[durability].push_back(&iter.second);
+      m_branchObjects[durability].push_back(iter.second.object);
       B2DEBUG(39, "The branch " << branchName << " was created.");
 
       //Tell DataStore that we are using this entry
@@ -300,6 +337,11 @@ void RootOutputModule::openFile()
 
 void RootOutputModule::event()
 {
+  // with parallel processing this is the first point after forking, see initialize()
+  if (m_writerThreads > 0 and !m_implicitMT) {
+    enableImplicitMT();
+  }
+
   // if we closed after last event ... make a new one
   if (!m_file)
     openFile();
@@ -310,29 +352,68 @@ void RootOutputModule::event()
     }
   }
 
+  EventSummary summary = getEventSummary();
+  // the threaded event processor swaps the objects between DataStore IDs, so they can't be taken over at the end of the event
+  if (m_writerQueueDepth > 0 and !DataStore::isMultiThreaded()) {
+    if (m_eventPending) {
+      B2FATAL("The end of the previous event was not signalled, writerQueueDepth > 0 is not supported with this event processor");
+    }
+    const auto& entries = m_entries[DataStore::c_Event];
+    m_pendingValid.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+      // objects the input module didn't read yet are still written
+      entries[i]->ensureLoaded();
+      m_pendingValid[i] = entries[i]->ptr != nullptr;
+    }
+    m_pendingSummary = std::move(summary);
+    m_eventPending = true;
+    return;
+  }
+
   //fill Event data
   fillTree(DataStore::c_Event);
+  addEventSummary(summary);
+
+  // check if we need to split the file
+  if (needsSplit()) {
+    // close file and open new one
+    B2INFO(getName() << ": Output size limit reached, closing file ...");
+    closeFile();
+  }
+}
 
+RootOutputModule::EventSummary RootOutputModule::getEventSummary() const
+{
+  EventSummary summary;
   if (m_fileMetaData) {
     if (m_keepParents) {
       for (int iparent = 0; iparent < m_fileMetaData->getNParents(); iparent++) {
-        string lfn = m_fileMetaData->getParent(iparent);
-        if (!lfn.empty() && (m_parentLfns.empty() || (m_parentLfns.back() != lfn))) {
-          m_parentLfns.push_back(lfn);
-        }
+        summary.parentLfns.push_back(m_fileMetaData->getParent(iparent));
       }
     } else {
-      string lfn = m_fileMetaData->getLfn();
-      if (!lfn.empty() && (m_parentLfns.empty() || (m_parentLfns.back() != lfn))) {
-        m_parentLfns.push_back(lfn);
-      }
+      summary.parentLfns.push_back(m_fileMetaData->getLfn());
+    }
+  }
+  summary.experiment = m_eventMetaData->getExperiment();
+  summary.run = m_eventMetaData->getRun();
+  summary.event = m_eventMetaData->getEvent();
+  // check if the event is a full event or not (no error flag)
+  summary.fullEvent = m_eventMetaData->getErrorFlag() == 0;
+  return summary;
+}
+
+void RootOutputModule::addEventSummary(const EventSummary& summary)
+{
+  for (const std::string& lfn : summary.parentLfns) {
+    if (!lfn.empty() && (m_parentLfns.empty() || (m_parentLfns.back() != lfn))) {
+      m_parentLfns.push_back(lfn);
     }
   }
 
   // keep track of file level metadata
-  unsigned long experiment =  m_eventMetaData->getExperiment();
-  unsigned long run =  m_eventMetaData->getRun();
-  unsigned long event = m_eventMetaData->getEvent();
+  unsigned long experiment = summary.experiment;
+  unsigned long run = summary.run;
+  unsigned long event = summary.event;
   if (m_experimentLow > m_experimentHigh) { //starting condition
     m_experimentLow = m_experimentHigh = experiment;
     m_runLow = m_runHigh = run;
@@ -352,16 +433,158 @@ void RootOutputModule::event()
     }
   }
 
-  // check if the event is a full event or not: if yes, increase the counter
-  if (m_eventMetaData->getErrorFlag() == 0) // no error flag -> this is a full event
+  if (summary.fullEvent)
     m_nFullEvents++;
+}
 
-  // check if we need to split the file
-  if (m_outputSplitSize and (uint64_t)m_file->GetEND() > *m_outputSplitSize) {
-    // close file and open new one
-    B2INFO(getName() << ": Output size limit reached, closing file ...");
-    closeFile();
+void RootOutputModule::enableImplicitMT()
+{
+  m_implicitMT = std::make_unique<RootIOUtilities::ImplicitMTScope>(m_writerThreads);
+  if (m_tree[DataStore::c_Event]) {
+    m_tree[DataStore::c_Event]->SetImplicitMT(true);
+  }
+}
+
+void RootOutputModule::queueEvent()
+{
+  if (!m_eventPending) return;
+  m_eventPending = false;
+
+  QueuedEvent queued;
+  {
+    std::lock_guard<std::mutex> lock(m_writerMutex);
+    if (!m_freeEvents.empty()) {
+      queued = std::move(m_freeEvents.back());
+      m_freeEvents.pop_back();
+    }
+  }
+  // the branches are the same for all output files
+  const auto& entries = m_entries[DataStore::c_Event];
+  const size_t nEntries = entries.size();
+  queued.objects.resize(nEntries);
+  for (size_t i = 0; i < nEntries; ++i) {
+    StoreEntry& entry = *entries[i];
+    std::unique_ptr<TObject>& object = queued.objects[i];
+    if (!object) {
+      StoreEntry spare(entry.isArray, entry.objClass, entry.name, entry.dontWriteOut);
+      object.reset(spare.object);
+      if (entry.isArray) {
+        const bool bypass = static_cast<TClonesArray*>(entry.object)->CanBypassStreamer();
+        static_cast<TClonesArray*>(object.get())->BypassStreamer(bypass);
+      }
+    }
+    // swap the objects like DataStore::swapContentsWith(), the DataStore resets the ones of the written event right after this
+    TObject* eventObject = entry.object;
+    entry.object = object.release();
+    if (entry.ptr) entry.ptr = entry.object;
+    object.reset(eventObject);
+  }
+  queued.valid = m_pendingValid;
+  queued.summary = std::move(m_pendingSummary);
+
+  const double waitTime = waitForWriter(m_writerQueueDepth - 1, true);
+  addStallTime(waitTime);
+  {
+    std::lock_guard<std::mutex> lock(m_writerMutex);
+    m_writerQueue.emplace_back(std::move(queued));
+    if (!m_writer.joinable()) {
+      m_writerObjects.assign(nEntries, nullptr);
+      // the thread fills the tree while we continue with other ROOT objects
+      ROOT::EnableThreadSafety();
+      LogSystem::Instance().enableThreadSafety();
+      m_writerStop = false;
+      m_writer = std::thread(&RootOutputModule::writeEvents, this);
+    }
+  }
+  m_writerWakeup.notify_one();
+}
+
+double RootOutputModule::waitForWriter(size_t maxQueued, bool reopen)
+{
+  if (!m_writer.joinable()) return 0;
+  const double start = Utils::getClock();
+  bool waited = false;
+  std::unique_lock<std::mutex> lock(m_writerMutex);
+  while (m_writerQueue.size() > maxQueued or m_splitRequested) {
+    if (m_splitRequested) {
+      // the writer is waiting for us: the events still in the queue belong into the next file
+      lock.unlock();
+      B2INFO(getName() << ": Output size limit reached, closing file ...");
+      closeFile();
+      lock.lock();
+      if (reopen or !m_writerQueue.empty()) {
+        openFile();
+      }
+      m_splitRequested = false;
+      m_writerWakeup.notify_one();
+      continue;
+    }
+    waited = true;
+    m_writerDone.wait(lock);
   }
+  const double waitTime = Utils::getClock() - start;
+  if (waited) {
+    ++m_queueFullEvents;
+    m_writerWaitTime += waitTime;
+  }
+  return waitTime;
+}
+
+void RootOutputModule::writeEvents()
+{
+  std::unique_lock<std::mutex> lock(m_writerMutex);
+  while (true) {
+    m_writerWakeup.wait(lock, [this]() { return m_writerStop or (!m_writerQueue.empty() and !m_splitRequested); });
+    if (m_writerQueue.empty() or m_splitRequested) {
+      // only stopped once everything is written
+      return;
+    }
+    // references to elements of a deque stay valid when adding elements
+    QueuedEvent& queued = m_writerQueue.front();
+    lock.unlock();
+
+    for (size_t i = 0; i < queued.objects.size(); ++i) {
+      m_writerObjects[i] = queued.objects[i].get();
+      // objects which were not created in this event are still written, but marked as invalid
+      m_writerObjects[i]->SetBit(kInvalidObject, !queued.valid[i]);
+    }
+    fillTree(DataStore::c_Event, true);
+    // the objects are given back to the DataStore for one of the next events
+    for (TObject* object : m_writerObjects) {
+      object->ResetBit(kInvalidObject);
+    }
+    addEventSummary(queued.summary);
+    const bool split = needsSplit();
+
+    lock.lock();
+    m_freeEvents.emplace_back(std::move(queued));
+    m_writerQueue.pop_front();
+    ++m_queuedEvents;
+    // stop writing until the module replaced the file
+    if (split) m_splitRequested = true;
+    m_writerDone.notify_one();
+  }
+}
+
+void RootOutputModule::stopWriter()
+{
+  if (!m_writer.joinable()) return;
+  waitForWriter(0, false);
+  {
+    std::lock_guard<std::mutex> lock(m_writerMutex);
+    m_writerStop = true;
+  }
+  m_writerWakeup.notify_one();
+  m_writer.join();
+  LogSystem::Instance().disableThreadSafety();
+  m_freeEvents.clear();
+}
+
+void RootOutputModule::addStallTime(double time)
+{
+  StoreObjPtr<ProcessStatistics> processStatistics("", DataStore::c_Persistent);
+  if (processStatistics)
+    processStatistics->getStatistics(this).addStallTime(time);
 }
 
 void RootOutputModule::fillFileMetaData()
@@ -432,7 +655,15 @@ void RootOutputModule::fillFileMetaData()
 
 void RootOutputModule::terminate()
 {
+  if (m_writer.joinable()) {
+    stopWriter();
+    B2INFO(getName() << ": Statistics for the writer thread" << LogVar("events", m_queuedEvents)
+           << LogVar("events waiting for the writer", m_queueFullEvents)
+           << LogVar("waiting time [s]", m_writerWaitTime / Unit::s));
+  }
   closeFile();
+  DataStore::Instance().removeEndOfEventCallbacks(this);
+  m_implicitMT.reset();
 }
 
 void RootOutputModule::closeFile()
@@ -471,6 +702,9 @@ void RootOutputModule::closeFile()
   for (auto & entry : m_entries) {
     entry.clear();
   }
+  for (auto& objects : m_branchObjects) {
+    objects.clear();
+  }
   m_parentLfns.clear();
   m_experimentLow = 1;
   m_experimentHigh = 0;
@@ -483,27 +717,42 @@ void RootOutputModule::closeFile()
 }
 
 
-void RootOutputModule::fillTree(DataStore::EDurability durability)
+void RootOutputModule::fillTree(DataStore::EDurability durability, bool writerObjects)
 {
   if (!m_tree[durability]) return;
 
   TTree& tree = *m_tree[durability];
-  for(auto* entry: m_entries[durability]) {
-    // Check for entries whose object was not created and mark them as invalid. 
-    // We still have to write them in the file due to the structure we have. This could be done better 
-    if (!entry->ptr) {
-      entry->object->SetBit(kInvalidObject);
+  const auto& entries = m_entries[durability];
+  for (size_t i = 0; i < entries.size(); ++i) {
+    StoreEntry* entry = entries[i];
+    // the objects of the writer are already marked, see writeEvents()
+    TObject*& object = writerObjects ? m_writerObjects[i] : entry->object;
+    if (!writerObjects) {
+      // objects the input module didn't read yet are still written
+      entry->ensureLoaded();
+      // Check for entries whose object was not created and mark them as invalid.
+      // We still have to write them in the file due to the structure we have. This could be done better
+      if (!entry->ptr) {
+        object->SetBit(kInvalidObject);
+      }
     }
     //FIXME: Do we need this? in theory no but it crashes in parallel processing otherwise ¯\_(ツ)_/¯
+    // Setting the address is expensive for split branches, so only do it if the object changed
     if (entry->name == "FileMetaData") {
-      tree.SetBranchAddress(entry->name.c_str(), &m_outputFileMetaData);
-    } else {
-      tree.SetBranchAddress(entry->name.c_str(), &entry->object);
+      if (m_branchObjects[durability][i] != m_outputFileMetaData) {
+        tree.SetBranchAddress(entry->name.c_str(), &m_outputFileMetaData);
+        m_branchObjects[durability][i] = m_outputFileMetaData;
+      }
+    } else if (m_branchObjects[durability][i] != object) {
+      tree.SetBranchAddress(entry->name.c_str(), &object);
+      m_branchObjects[durability][i] = object;
     }
   }
   tree.Fill();
-  for (auto* entry: m_entries[durability]) {
-    entry->object->ResetBit(kInvalidObject);
+  if (!writerObjects) {
+    for (auto* entry: entries) {
+      entry->object->ResetBit(kInvalidObject);
+    }
   }
 
   const bool writeError = m_file->TestBit(TFile::kWriteError);
@@ -16,6 +16,7 @@
 
 #include <cmath>
 #include <cstdio>
+#include <memory>
 
 using namespace std;
 using namespace Belle2;
@@ -47,6 +48,10 @@ SeqRootInputModule::SeqRootInputModule() : Module()
            "subsequent files are named .sroot-N. For example 'myfile-f%08d.sroot'",
            false);
   addParam("declareRealData", m_realData, "Declare the input to be real, not generated data", false);
+  addParam("skipNEvents", m_skipNEvents, "Skip this number of events at the beginning of the first input file. "
+           "Files written in the block format (see SeqRootOutput) jump directly to the event, other files are read up to it.", 0);
+  addParam("decompressionThreads", m_decompressionThreads, "Number of threads reading and decompressing the next blocks "
+           "ahead for files in the block format, 0 to read them in the main thread when needed.", 0);
 }
 
 SeqRootInputModule::~SeqRootInputModule() = default;
@@ -80,7 +85,10 @@ void SeqRootInputModule::initialize()
 
   EvtMessage* evtmsg = nullptr;
   // Open input file
-  m_file = new SeqFile(m_inputFileName.c_str(), "r", nullptr, 0, m_fileNameIsPattern);
+  if (m_decompressionThreads < 0) {
+    B2FATAL("SeqRootInput: decompressionThreads cannot be negative" << LogVar("decompressionThreads", m_decompressionThreads));
+  }
+  m_file = new SeqFile(m_inputFileName.c_str(), "r", nullptr, 0, m_fileNameIsPattern, {0, 0, m_decompressionThreads});
   if (m_file->status() <= 0)
     B2FATAL("SeqRootInput : Error in opening input file : " << m_inputFileName);
 
@@ -99,6 +107,7 @@ void SeqRootInputModule::initialize()
         B2INFO("Reading StreamerInfo");
         if (info_cnt != 0) B2FATAL("SeqRootInput : Reading StreamerInfos twice");
         info_cnt++;
+        if (m_skipNEvents > 0) skipEvents();
       } else {
         // first event was read
         delete[] evtbuf;
@@ -125,6 +134,24 @@ void SeqRootInputModule::initialize()
   Conditions::Configuration::getInstance().setInputGlobaltags({});
 }
 
+void SeqRootInputModule::skipEvents()
+{
+  // the StreamerInfo is record 0, so the first event to read is record m_skipNEvents + 1
+  if (m_file->seek(m_skipNEvents + 1)) {
+    B2INFO("SeqRootInput : Skipped " << m_skipNEvents << " events using the block index");
+    return;
+  }
+  std::unique_ptr<char[]> evtbuf(new char[EvtMessage::c_MaxEventSize]);
+  int skipped = 0;
+  while (skipped < m_skipNEvents) {
+    int size = m_file->read(evtbuf.get(), EvtMessage::c_MaxEventSize);
+    if (size <= 0) {
+      B2FATAL("SeqRootInput : Cannot skip " << m_skipNEvents << " events, the file contains only " << skipped);
+    }
+    if (EvtMessage(evtbuf.get()).type() != MSG_STREAMERINFO) skipped++;
+  }
+  B2INFO("SeqRootInput : Skipped " << m_skipNEvents << " events");
+}
 
 void SeqRootInputModule::beginRun()
 {
@@ -167,7 +194,7 @@ void SeqRootInputModule::event()
     printf("fileptr = %d ( of %d )\n", m_fileptr, m_nfile);
     fflush(stdout);
     m_inputFileName = m_filelist[m_fileptr];
-    m_file = new SeqFile(m_inputFileName, "r");
+    m_file = new SeqFile(m_inputFileName, "r", nullptr, 0, false, {0, 0, m_decompressionThreads});
     if (m_file->status() <= 0)
       B2FATAL("SeqRootInput : Error in opening input file : " << m_inputFileName);
     B2INFO("SeqRootInput : Open " << m_inputFileName);
@@ -48,6 +48,13 @@ SeqRootOutputModule::SeqRootOutputModule() : Module(), m_nevt(0), m_streamer(nul
   addParam("saveObjs", m_saveObjs, "List of objects/arrays to be saved", emptyvector);
   addParam("fileNameIsPattern", m_fileNameIsPattern, "If true interpret the output filename as a boost::format pattern "
            "instead of the standard where subsequent files are named .sroot-N. For example 'myfile-f%08d.sroot'", false);
+  addParam("blockCompression", m_blockCompression, "If larger than zero write the file in the block format: events are "
+           "collected in blocks which are compressed independently with this ROOT compression setting (algorithm * 100 + level, "
+           "e.g. 404 for LZ4 or 505 for ZSTD), followed by a block index at the end of the file. SeqRootInput detects the format "
+           "automatically and can skip events without reading them. Cannot be combined with a .gz suffix.", 0);
+  addParam("blockSize", m_blockSize, "Uncompressed size of one block in kB for the block format", 4096);
+  addParam("compressionThreads", m_compressionThreads, "Number of threads compressing blocks in parallel for the block format, "
+           "0 to compress them in the main thread", 0);
 }
 
 
@@ -75,7 +82,15 @@ void SeqRootOutputModule::initialize()
   //Write StreamerInfo at the beginning of a file
   getStreamerInfos();
 
-  m_file = new SeqFile(m_outputFileName.c_str(), "w", m_streamerinfo, m_streamerinfo_size, m_fileNameIsPattern);
+  if (m_blockSize <= 0 or m_blockSize > (1 << 20)) {
+    B2FATAL("SeqRootOutput: blockSize has to be between 1 kB and 1 GB" << LogVar("blockSize", m_blockSize));
+  }
+  if (m_compressionThreads < 0) {
+    B2FATAL("SeqRootOutput: compressionThreads cannot be negative" << LogVar("compressionThreads", m_compressionThreads));
+  }
+  const SeqFileBlockSettings blockSettings{m_blockCompression, (unsigned int)m_blockSize * 1024, m_compressionThreads};
+
+  m_file = new SeqFile(m_outputFileName.c_str(), "w", m_streamerinfo, m_streamerinfo_size, m_fileNameIsPattern, blockSettings);
 
   B2INFO("SeqRootOutput: initialized.");
 }
@@ -9,11 +9,13 @@
 #pragma once
 
 #include <framework/pcore/EvtMessage.h>
+#include <framework/datastore/StoreAccessorBase.h>
 
 #include <Rtypes.h> //for BIT()
 
 #include <pthread.h>
 
+#include <map>
 #include <vector>
 #include <string>
 
@@ -34,6 +36,16 @@ namespace Belle2 {
     /** Ask Itoh-san. */
     static const unsigned int c_maxQueueDepth = 64;
 
+    /** Bytes and time spent (de)serializing the objects of one DataStore entry. */
+    struct EntryStatistics {
+      unsigned int nStreamed{0}; /**< number of times the entry was streamed. */
+      unsigned int nRestored{0}; /**< number of times the entry was restored. */
+      double streamedBytes{0}; /**< total size of streamed objects (before compression), in bytes. */
+      double restoredBytes{0}; /**< total size of restored objects (after decompression), in bytes. */
+      double streamTime{0}; /**< total time spent streaming the objects, in ms. */
+      double restoreTime{0}; /**< total time spent deserializing the objects and putting them into the DataStore, in ms. */
+    };
+
     /** Constructor
      *  @param complevel  Compression level of streaming, 0 to disable
      *  @param handleMergeable perform special handling for Mergeable objects?
@@ -67,6 +79,26 @@ namespace Belle2 {
     /** Set names of objects to be streamed/destreamed. */
     void setStreamingObjects(const std::vector<std::string>& list);
 
+    /** Let streamDataStore() return messages using a buffer owned by this DataStoreStreamer.
+     *
+     * This saves allocating and copying the full message for every event, but the returned
+     * message is then only valid until the next call to streamDataStore() (it still needs to be deleted).
+     */
+    void setReuseMessageBuffer(bool reuse = true) { m_reuseMessageBuffer = reuse; }
+
+    /** Debug level at which the entry statistics are collected and printed. */
+    static const int c_statisticsDebugLevel = 32;
+
+    /** Statistics on streamed/restored DataStore entries, by name.
+     *  Only filled while debug output of level c_statisticsDebugLevel is enabled. */
+    const std::map<std::string, EntryStatistics>& getEntryStatistics() const { return m_entryStatistics; }
+
+    /** Print getEntryStatistics() as debug output (with given level). */
+    void printEntryStatistics(int debugLevel) const;
+
+    /** True if the entry statistics are collected, checked once per streamed or restored event. */
+    bool statisticsEnabled() const;
+
     // Pipelined destreaming of EvtMessage using thread
 
     /** Queue EvtMessage for destreaming
@@ -132,6 +164,19 @@ namespace Belle2 {
     /** Compression level in streaming */
     int m_compressionLevel;
 
+    bool m_reuseMessageBuffer{false}; /**< see setReuseMessageBuffer(). */
+
+    /** DataStore layout of the objects in the last restored message, by position in the message.
+     *
+     * Messages from the same sender usually contain the same objects in the same order, so we
+     * can keep accessors (with the entry names already resolved in the DataStore) and
+     * statistics for them.
+     */
+    std::vector<std::pair<StoreAccessorBase, EntryStatistics*>> m_restoreLayout;
+
+    /** see getEntryStatistics(). */
+    std::map<std::string, EntryStatistics> m_entryStatistics;
+
     bool m_handleMergeable; /**< Whether to handle Mergeable objects. */
 
     /** first event flag.
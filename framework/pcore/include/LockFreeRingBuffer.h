@@ -0,0 +1,182 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <framework/pcore/RingBufferBase.h>
+#include <framework/pcore/RingBuffer.h>
+
+#include <sys/ipc.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace Belle2 {
+
+  /** Descriptor of one entry in a LockFreeRingBuffer, placed in shared memory after LockFreeRingBufInfo.
+   *
+   * The sequence number encodes the state of the slot for a given ticket t
+   * (slot index = t % nslots):
+   *  - seq == t: free, can be reserved by the writer holding ticket t
+   *  - seq == t + 1: data published, can be picked up by a reader
+   *  - seq == t + 2: data was picked up, memory is waiting to be reclaimed
+   * Reclaiming the entry sets seq = t + nslots, i.e. frees it for the next round.
+   */
+  struct LockFreeRingBufSlot {
+    std::atomic<uint32_t> seq; /**< Sequence number, see above. */
+    uint32_t start; /**< Offset of the data in the data area (integers). */
+    uint32_t end; /**< Offset after the data (integers), the reclaimed memory extends up to here. */
+    int size; /**< Size of the data (integers). */
+  };
+
+  /** Internal metadata structure for LockFreeRingBuffer. Placed on top of the shared memory.
+   *
+   * Reservation and reclamation each pack a ticket (upper 32 bits) and an offset in the data
+   * area (lower 32 bits) into one 64 bit word, so that tickets and memory are always
+   * handed out and given back in the same order with a single compare-and-swap.
+   */
+  struct LockFreeRingBufInfo {
+    /** Magic value identifying a LockFreeRingBufInfo. Negative, so it can be told apart from RingBufInfo::size. */
+    const static int c_Magic = -0x4c465242;
+
+    std::atomic<int> magic; /**< c_Magic once initialized. */
+    uint32_t size; /**< Size of the data area (integers). */
+    uint32_t nslots; /**< Number of slots, a power of two. */
+    int semid; /**< Always -1, there is no semaphore. Kept for the tools looking at SHM ID files. */
+
+    alignas(64) std::atomic<uint64_t> reserve; /**< Next ticket to be written and write offset. */
+    alignas(64) std::atomic<uint64_t> reclaim; /**< Next ticket to be reclaimed and offset up to which memory is used. */
+    alignas(64) std::atomic<uint32_t> readTicket; /**< Next ticket to be read. */
+    alignas(64) std::atomic<uint32_t> nPublished; /**< Incremented for every published entry, futex word readers wait on. */
+    std::atomic<int> nWaitingRx; /**< Number of readers waiting on nPublished. */
+    alignas(64) std::atomic<uint32_t> nReclaimed; /**< Incremented for every reclaimed entry, futex word writers wait on. */
+    std::atomic<int> nWaitingTx; /**< Number of writers waiting on nReclaimed. */
+
+    alignas(64) std::atomic<int> numAttachedTx; /**< number of attached sending processes, see RingBufInfo::numAttachedTx. */
+    std::atomic<int> nbusy; /**< Number of attached _reading_ processes currently processing events. */
+    std::atomic<int> nattached; /**< Number of LockFreeRingBuffer instances currently attached to this buffer. */
+    std::atomic<int> killed; /**< Set by kill(), entries still in the buffer are to be ignored. */
+    std::atomic<uint32_t> ninsq; /**< Count insq() calls for this buffer. */
+    std::atomic<uint32_t> nremq; /**< Count picked up entries for this buffer. */
+  };
+
+  /** Ring buffer in IPC shared memory that is not protected by a semaphore.
+   *
+   * Any number of processes may write and read concurrently (the pEventProcessor uses it with one
+   * writer and many readers for the input and with many writers and one reader for the output).
+   * Space and entries are claimed via atomic compare-and-swap in the shared memory, and waiting
+   * processes sleep on a futex instead of polling, so they are woken up as soon as something happens.
+   *
+   * Entries have to fit into half of the data area.
+   */
+  class LockFreeRingBuffer : public RingBufferBase {
+  public:
+    /** Number of entry slots, limits the number of entries held at any time. */
+    const static int c_NSlots = 4096;
+
+    /** Constructor to create a new shared memory in private space.
+     *
+     * @param nwords Ring buffer size in integers
+     */
+    explicit LockFreeRingBuffer(int nwords = RingBuffer::c_DefaultSize);
+    /** Constructor to create/attach named shared memory in global space */
+    explicit LockFreeRingBuffer(const std::string& name, unsigned int nwords = 0);
+    /** Destructor */
+    ~LockFreeRingBuffer() override;
+
+    /** Append a buffer, returns size or -1 if there's currently not enough space. */
+    int insq(const int* buf, int size, bool checkTx = false) override;
+    /** Pick up a buffer. */
+    int remq(int* buf) override;
+    /** Pick up at most maxEntries buffers with a single compare-and-swap. */
+    int remqBatch(std::vector<int>& buf, std::vector<int>& sizes, int maxEntries) override;
+    /** Pick up a buffer, returns a pointer directly into the shared memory. */
+    const int* acquireq(int& size) override;
+    /** Give back the buffer obtained by the last acquireq(), its memory can then be reused by the writers. */
+    void releaseq() override;
+    /** Returns number of entries/buffers (including those currently being written). */
+    int numq() const override;
+
+    /** Sleep on the futex until an entry is published (or for at most c_WaitTimeout). */
+    void waitForEntries() override;
+    /** Sleep on the futex until an entry is reclaimed (or for at most c_WaitTimeout). */
+    void waitForSpace() override;
+
+    /** Increase the number of attached Tx counter. */
+    void txAttached() override;
+    /** Decrease the number of attached Tx counter, wakes up readers once it drops to zero. */
+    void txDetached() override;
+    /** Cause termination of reading processes and wake everyone up. Async-signal-safe. */
+    void kill() override;
+
+    /** If True, the ring buffer is empty (or killed) and has no attached Tx modules. Processes should then stop. */
+    bool isDead() const override;
+    /** True if and only if buffer is empty and nbusy == 0. */
+    bool allRxWaiting() const override;
+
+    /** Clear the buffer. Only safe while no other process is using it. */
+    int clear() override;
+
+    /** Return ID of the shared memory */
+    int shmid() const override;
+
+    /** Return number of insq() calls for current buffer. */
+    int ninsq() const { return m_bufinfo->ninsq; }
+    /** Return number of entries picked up from current buffer. */
+    int nremq() const { return m_bufinfo->nremq; }
+
+  private:
+    /** Maximal time spent in one futex wait (ns), so that waiting processes can check isDead() now and then. */
+    const static long c_WaitTimeout = 10000000;
+
+    /** open (and initialize) shared memory */
+    void openSHM(int nwords);
+    /** Function to detach and remove shared memory*/
+    void cleanup();
+    /** initialize control parameters and empty slots. */
+    void initInfo(uint32_t size);
+
+    /** Reclaim memory of entries that have been picked up, in order. Returns true if anything was reclaimed. */
+    bool reclaim();
+    /** Try to claim up to maxEntries consecutive published entries, returns number claimed and first ticket. */
+    int claim(int maxEntries, uint32_t& firstTicket);
+    /** Mark entry as picked up and reclaim as much as possible. */
+    void release(uint32_t ticket);
+    /** Update nbusy depending on whether this process got data. */
+    void setBusy(bool busy);
+
+    /** Slot for the given ticket. */
+    LockFreeRingBufSlot& slot(uint32_t ticket) const { return m_slots[ticket & (m_bufinfo->nslots - 1)]; }
+
+    bool m_new{true}; /**< True if we created the ring buffer ourselves (and need to clean it). */
+    bool m_file{false}; /**< True if m_pathname needs to be removed. */
+    std::string m_pathname{""}; /**< Path for identifying shared memory if named ring buffer is created. */
+    int  m_pathfd{ -1}; /**< Associated file descriptor. */
+    key_t m_shmkey{IPC_PRIVATE}; /**< SHM key, see shmget(2). */
+    /** file path containing id of shm for private shared mem, used for easier cleanup if we fail to do things properly */
+    std::string m_semshmFileName{""};
+
+    /** Value of LockFreeRingBufInfo::nReclaimed at the beginning of the last insq(), waitForSpace() waits for it to change. */
+    uint32_t m_reclaimedSeen{0};
+
+    uint32_t m_acquiredTicket{0}; /**< Ticket of the next buffer to be handed out by acquireq(). */
+    int m_nAcquired{0}; /**< Number of claimed buffers not yet handed out by acquireq(). */
+    bool m_acquirePending{false}; /**< True if the buffer before m_acquiredTicket still needs to be released. */
+
+    /** Is this process currently processing events from this buffer? See RingBuffer::m_procIsBusy. */
+    bool m_procIsBusy{false};
+
+    int  m_shmid{ -1}; /**< ID of shared memory segment. (See shmget(2)) */
+    char* m_shmadr{nullptr}; /**< Address of attached shared memory segment. (See shmat(2)) */
+    LockFreeRingBufInfo* m_bufinfo{nullptr}; /**< Control parameters, placed on top of the shared memory. */
+    LockFreeRingBufSlot* m_slots{nullptr}; /**< Slot descriptors, following m_bufinfo. */
+    int* m_buftop{nullptr}; /**< Data area, following the slots. */
+  };
+
+}
@@ -13,6 +13,7 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 
 class TObject;
 
@@ -31,7 +32,8 @@ namespace Belle2 {
     /** Constructor, with the initial capacity of the buffer to allocate
      * (in bytes). size() will remain zero until buffer is filled.
      */
-    explicit CharBuffer(size_t initial_capacity = 0): m_data{initial_capacity > 0 ? new char[initial_capacity] : nullptr}
+    explicit CharBuffer(size_t initial_capacity = 0): m_data{initial_capacity > 0 ? new char[initial_capacity] : nullptr},
+      m_capacity{initial_capacity}
     {}
     /** copy data to end of buffer, expanding buffer if needed.
      * This can invalidate previous pointers obtained by data() if the buffer
@@ -119,14 +121,31 @@ namespace Belle2 {
 
     /** Stream object list into an EvtMessage. Caller is responsible for deletion. */
     virtual EvtMessage* encode_msg(ERecordType rectype);
+    /** Stream object list into an EvtMessage using the internal buffer of this MsgHandler.
+     *
+     * Unlike encode_msg() this doesn't allocate and fill a new buffer for every message.
+     * The caller is still responsible for deleting the returned EvtMessage, but its buffer
+     * is only valid until the next call to add() or clear().
+     */
+    EvtMessage* encode_msg_reuse(ERecordType rectype);
     /** Decode an EvtMessage into a vector list of objects with names */
     virtual void decode_msg(EvtMessage* msg, std::vector<TObject*>& objlist, std::vector<std::string>& namelist);
 
+    /** Sizes (bytes, uncompressed) of the objects added since the last clear(), or read in the last decode_msg(). */
+    const std::vector<UInt_t>& getObjectSizes() const { return m_objectSizes; }
+    /** Time (ns) spent deserializing each object in the last decode_msg(). */
+    const std::vector<double>& getObjectDecodeTimes() const { return m_objectDecodeTimes; }
+
   private:
-    CharBuffer m_buf; /**< EvtMessage character buffer for encode_msg(). */
+    /** Compress body of m_buf into m_compBuf (both after header space), returns the buffer to send and sets flags accordingly. */
+    CharBuffer* compress(unsigned int& flags);
+
+    CharBuffer m_buf; /**< EvtMessage character buffer for encode_msg(), starts with space for the EvtHeader. */
     CharBuffer m_compBuf; /**< EvtMessage character buffer for compressing/decompressing. */
     std::unique_ptr<TMessage> m_msg; /**< Used for serialising objects into m_buf. */
     InMessage m_inMsg; /**< Used for deserializing in decode_msg() */
+    std::vector<UInt_t> m_objectSizes; /**< see getObjectSizes(). */
+    std::vector<double> m_objectDecodeTimes; /**< see getObjectDecodeTimes(). */
     int m_complevel; /**< compression algorithm * 100 + compression level.
                       level can be 0 for no compression to 9 for highest
                       compression, algorithm can be one of default (0), zlib
@@ -8,13 +8,18 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
 #include <vector>
 #include <string>
 
+class TDirectory;
 class TFile;
+class TH1;
 
 namespace Belle2 {
   class Module;
+  class SharedHistograms;
 
   /** Class to manage histograms defined in registered modules */
   /*
@@ -35,8 +40,13 @@ namespace Belle2 {
     /** Access to singleton */
     static RbTupleManager& Instance();
 
-    /** Global initialization */
-    void init(int nprocess, const char* filename, const char* workdir = ".");
+    /** Global initialization
+     * @param nprocess number of parallel processes
+     * @param filename name of the histogram output file
+     * @param workdir directory of the temporary histogram files
+     * @param sharedMemorySize size in MB of the shared memory for the histogram bins, 0 to write and merge one file per process
+     */
+    void init(int nprocess, const char* filename, const char* workdir = ".", int sharedMemorySize = 0);
 
     /** Functions called by analysis modules in mother process */
     //  void define ( void (*func)( void ) );
@@ -58,6 +68,15 @@ namespace Belle2 {
     /** Functions to add up all histogram files */
     int hadd(bool deleteflag = true);
 
+    /** Add the totals over all processes of a histogram in shared memory to the target histogram.
+     *
+     * Can be called at any time by any process, e.g. to monitor the histograms during the run.
+     * @param target histogram with the same binning, e.g. a reset clone of hist
+     * @param hist histogram defined by a HistoModule in this process
+     * @return false if the histogram is not in shared memory
+     */
+    bool addSharedTotal(TH1& target, const TH1* hist) const;
+
     /** Return the list of modules that have defined histograms */
     const std::vector<Module*>& getHistDefiningModules() const
     {
@@ -65,6 +84,18 @@ namespace Belle2 {
     }
 
   private:
+    /** Collect all histograms in a directory and its subdirectories. */
+    static void collectHistograms(TDirectory* dir, std::vector<TH1*>& histograms);
+
+    /** Directory and name of a histogram, the same in all processes. */
+    static std::string getSharedKey(const TH1* hist);
+
+    /** Point the bins of the histograms of this process into the shared memory. */
+    void attachSharedHistograms(int procid);
+
+    /** Write the totals of the shared histograms to the output file. */
+    int writeSharedHistograms();
+
     static RbTupleManager* s_instance; /**< singleton instance. */
 
     std::vector<Module*> m_histdefs; /**< registered HistoModules. */
@@ -72,6 +103,8 @@ namespace Belle2 {
     std::string m_filename; /**< Name of histogram output file. */
     std::string m_workdir;  /**< Name of working directory */
     TFile* m_root{nullptr}; /**< Histogram output file. */
+    std::unique_ptr<SharedHistograms> m_shared; /**< Histogram bins in shared memory, nullptr if not used. */
+    std::map<const TH1*, std::string> m_sharedKeys; /**< Keys of the histograms of this process in shared memory. */
   };
 
 } // Belle2 namespace
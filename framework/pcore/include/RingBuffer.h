@@ -8,6 +8,8 @@
 
 #pragma once
 
+#include <framework/pcore/RingBufferBase.h>
+
 #include <sys/ipc.h>
 #include <string>
 
@@ -32,7 +34,7 @@ namespace Belle2 {
   };
 
   /** Class to manage a Ring Buffer placed in an IPC shared memory */
-  class RingBuffer {
+  class RingBuffer : public RingBufferBase {
   public:
     /** Standard size of buffer, in integers (~60MB). Needs to be large enough to contain any event, but adds to total memory use of basf2. */
     const static int c_DefaultSize = 15000000;
@@ -45,38 +47,45 @@ namespace Belle2 {
     /** Constructor to create/attach named shared memory in global space */
     explicit RingBuffer(const std::string& name, unsigned int nwords = 0);     // Create / Attach Ring buffer
     /** Destructor */
-    ~RingBuffer();
+    ~RingBuffer() override;
     /** open shared memory */
     void openSHM(int nwords);
     /** Function to detach and remove shared memory*/
     void cleanup();
 
     /** Append a buffer to the RingBuffer */
-    int insq(const int* buf, int size, bool checkTx = false);
+    int insq(const int* buf, int size, bool checkTx = false) override;
     /** Pick up a buffer from the RingBuffer */
-    int remq(int* buf);
+    int remq(int* buf) override;
+    /** Pick up at most maxEntries buffers from the RingBuffer while holding the semaphore only once. */
+    int remqBatch(std::vector<int>& buf, std::vector<int>& sizes, int maxEntries) override;
     /** Prefetch a buffer from the RingBuffer w/o removing it*/
     int spyq(int* buf) const;
     /** Returns number of entries/buffers in the RingBuffer */
-    int numq() const;
+    int numq() const override;
+
+    /** Polls, i.e. sleeps for 20 us. */
+    void waitForEntries() override;
+    /** Polls, i.e. sleeps for 20 us. */
+    void waitForSpace() override;
 
     /** Increase the number of attached Tx counter. */
-    void txAttached();
+    void txAttached() override;
     /** Decrease the number of attached Tx counter. */
-    void txDetached();
+    void txDetached() override;
     /** Cause termination of reading processes (if they use isDead()). Assumed to be atomic. */
-    void kill();
+    void kill() override;
 
     /** If True, the ring buffer is empty and has no attached Tx modules (i.e. no new data is going to be added). Processes should then stop. */
-    bool isDead() const;
+    bool isDead() const override;
     /** True if and only if buffer is empty and nbusy == 0.
      *
      * Called in Tx to see if all events of the current run
      * have been processed */
-    bool allRxWaiting() const;
+    bool allRxWaiting() const override;
 
     /** Clear the RingBuffer */
-    int clear();
+    int clear() override;
     /** Forcefully clear the RingBuffer with resetting semaphore*/
     void forceClear();
 
@@ -84,7 +93,7 @@ namespace Belle2 {
     int tryClear();
 
     /** Return ID of the shared memory */
-    int shmid() const;
+    int shmid() const override;
 
     // Debugging functions
     /** Print some info on the RingBufInfo structure. */
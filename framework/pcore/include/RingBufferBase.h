@@ -0,0 +1,87 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Belle2 {
+
+  /** Common interface of the shared memory buffers connecting the processes in pEventProcessor.
+   *
+   * Implemented by the semaphore protected RingBuffer and by LockFreeRingBuffer,
+   * TxModule and RxModule only talk to this interface.
+   */
+  class RingBufferBase {
+  public:
+    /** Virtual destructor */
+    virtual ~RingBufferBase() = default;
+
+    /** Append a buffer of 'size' integers. Returns size or -1 if there's not enough space at the moment. */
+    virtual int insq(const int* buf, int size, bool checkTx = false) = 0;
+    /** Pick up a buffer, returns its size in integers or 0 if there's nothing to read. buf may be nullptr to discard the buffer. */
+    virtual int remq(int* buf) = 0;
+    /** Pick up at most maxEntries buffers at once.
+     *
+     * The buffers are appended to buf, their sizes (in integers) to sizes.
+     * @return number of buffers picked up, 0 if there's nothing to read.
+     */
+    virtual int remqBatch(std::vector<int>& buf, std::vector<int>& sizes, int maxEntries) = 0;
+    /** Pick up a buffer without copying it out, if possible.
+     *
+     * The returned data stays valid (and its space in the ring buffer stays occupied) until releaseq()
+     * is called, which has to happen before the next call to acquireq().
+     * Up to getReadBatchSize() buffers are picked up at once and handed out one by one.
+     *
+     * @param size set to the size of the buffer in integers
+     * @return pointer to the buffer, nullptr if there's nothing to read.
+     */
+    virtual const int* acquireq(int& size);
+    /** Give back the buffer obtained by the last acquireq(). */
+    virtual void releaseq() {}
+    /** Set maximal number of buffers picked up at once by acquireq(). */
+    void setReadBatchSize(int batchSize) { m_readBatchSize = batchSize; }
+    /** Maximal number of buffers picked up at once by acquireq(). */
+    int getReadBatchSize() const { return m_readBatchSize; }
+    /** Returns number of entries/buffers in the ring buffer */
+    virtual int numq() const = 0;
+
+    /** Block for a short while until there might be entries to read. remq() should be called again afterwards. */
+    virtual void waitForEntries() = 0;
+    /** Block for a short while until there might be space for insq(). */
+    virtual void waitForSpace() = 0;
+
+    /** Increase the number of attached Tx counter. */
+    virtual void txAttached() = 0;
+    /** Decrease the number of attached Tx counter. */
+    virtual void txDetached() = 0;
+    /** Cause termination of reading processes (if they use isDead()). Must be safe to call from a signal handler. */
+    virtual void kill() = 0;
+
+    /** If True, the ring buffer is empty and has no attached Tx modules (i.e. no new data is going to be added). Processes should then stop. */
+    virtual bool isDead() const = 0;
+    /** True if and only if buffer is empty and no reading process is busy with an event taken from it. */
+    virtual bool allRxWaiting() const = 0;
+
+    /** Clear the ring buffer */
+    virtual int clear() = 0;
+
+    /** Return ID of the shared memory */
+    virtual int shmid() const = 0;
+
+  protected:
+    int m_readBatchSize{1}; /**< Maximal number of buffers picked up at once by acquireq(). */
+
+  private:
+    std::vector<int> m_acquireBuffer; /**< Buffers copied out by the default acquireq(). */
+    std::vector<int> m_acquireSizes; /**< Sizes of the buffers in m_acquireBuffer. */
+    size_t m_acquireEntry{0}; /**< Index of next buffer in m_acquireSizes to be handed out. */
+    size_t m_acquireOffset{0}; /**< Offset of next buffer in m_acquireBuffer to be handed out. */
+  };
+}
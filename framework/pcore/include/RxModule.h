@@ -9,7 +9,7 @@
 #pragma once
 
 #include <framework/core/Module.h>
-#include <framework/pcore/RingBuffer.h>
+#include <framework/pcore/RingBufferBase.h>
 #include <framework/datastore/StoreObjPtr.h>
 #include <framework/core/RandomGenerator.h>
 
@@ -17,15 +17,15 @@
 namespace Belle2 {
   class DataStoreStreamer;
 
-  /** Module to decode data store contents from RingBuffer. */
+  /** Module to decode data store contents from a RingBuffer (or LockFreeRingBuffer). */
   class RxModule : public Module {
   public:
 
     /** Constructor.
      *
-     * @param rbuf Use the given RingBuffer for data
+     * @param rbuf Use the given ring buffer for data
      */
-    explicit RxModule(RingBuffer* rbuf);
+    explicit RxModule(RingBufferBase* rbuf);
     virtual ~RxModule();
 
     //! Module functions to be called from main process
@@ -46,8 +46,8 @@ namespace Belle2 {
     void readEvent();
 
   private:
-    /** attached RingBuffer. */
-    RingBuffer* m_rbuf;
+    /** attached ring buffer. */
+    RingBufferBase* m_rbuf;
 
     /** Used for serialization. */
     DataStoreStreamer* m_streamer;
@@ -8,13 +8,22 @@
 
 #pragma once
 
+#include <framework/pcore/SeqFileBlocks.h>
+
+#include <cstdint>
 #include <iosfwd>
 #include <memory>
 #include <string>
 
 namespace Belle2 {
 
-  /** A class to manage I/O for a chain of blocked files */
+  /** A class to manage I/O for a chain of blocked files
+   *
+   * Files are either written as a plain sequence of records, optionally
+   * gzip-compressed if the name ends in .gz, or in the block format
+   * (see SeqBlockWriter) if a block compression is given. When reading,
+   * the block format is detected automatically.
+   */
   class SeqFile {
   public:
     /** Constructor.
@@ -26,10 +35,11 @@ namespace Belle2 {
      * @param filenameIsPattern if true interpret the filename as a
      *     boost::format pattern which takes the sequence number as argument
      *     instead of producing .sroot-N files
+     * @param blockSettings compression and number of threads for the block format
      */
     SeqFile(const std::string& filename, const std::string& rwflag,
             char* streamerinfo = nullptr, int streamerinfo_size = 0,
-            bool filenameIsPattern = false);
+            bool filenameIsPattern = false, const SeqFileBlockSettings& blockSettings = SeqFileBlockSettings());
     /** Destructor */
     ~SeqFile();
     /** No copying */
@@ -43,10 +53,15 @@ namespace Belle2 {
     int write(const char* buf);
     /** Read a record from a file. The record length is returned. */
     int read(char* buf, int max);
+    /** Continue reading at the given record of the current file, counting the StreamerInfo as record 0.
+     * Only possible for files in the block format, returns false otherwise or if the file has fewer records. */
+    bool seek(uint64_t record);
 
   private:
     /** actually open the file */
     void openFile(std::string filename, bool readonly);
+    /** Read a record from a plain or gzip-compressed file, returns 0 at the end of the file. */
+    int readStream(char* buf, int max);
 
   private:
     /** maximal size of one file (in Bytes). */
@@ -59,6 +74,9 @@ namespace Belle2 {
     int m_nfile{0}; /**< file counter, starting at 0 (files are split after c_MaxFileSize bytes). */
     bool m_compressed{false}; /**< is file gzipped compressed? */
     std::unique_ptr<std::ios> m_stream; /**< pointer to the filtering input or output stream */
+    SeqFileBlockSettings m_blockSettings; /**< settings for the block format */
+    std::unique_ptr<SeqBlockWriter> m_blockWriter; /**< writer if the file is written in the block format */
+    std::unique_ptr<SeqBlockReader> m_blockReader; /**< reader if the file is read in the block format */
 
     /** StreamerInfo */
     char* m_streamerinfo;
@@ -0,0 +1,184 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Belle2 {
+
+  /** Settings for writing SeqFiles in the block format, see SeqBlockWriter. */
+  struct SeqFileBlockSettings {
+    /** ROOT compression setting of the blocks (algorithm * 100 + level, e.g. 404 for LZ4 or 505 for ZSTD), 0 to write the classic format */
+    int compression{0};
+    /** Uncompressed size of one block in bytes, blocks only contain complete records so they can be larger */
+    unsigned int blockSize{4 << 20};
+    /** Number of threads to compress or decompress blocks, 0 to do it in the calling thread */
+    int nThreads{0};
+  };
+
+  /** Description of one block of a SeqFile in the block format, as stored in the block header and the index */
+  struct SeqFileBlockInfo {
+    /** Position of the block header in the file */
+    uint64_t offset;
+    /** Number of the first record in the block, counted from the beginning of the file */
+    uint64_t firstRecord;
+    /** Number of records in the block */
+    uint32_t nRecords;
+    /** Size of the block data in the file */
+    uint32_t storedSize;
+    /** Size of the block data after uncompressing */
+    uint32_t rawSize;
+    /** 1 if the block data is compressed */
+    uint32_t compressed;
+  };
+
+  /** Writes records into a file in the block format of SeqFile.
+   *
+   * The file starts with a header containing a magic string which can never be
+   * the size of the first record in a classic .sroot file. Records are collected
+   * in blocks which are compressed independently with the ROOT compression
+   * algorithms, optionally by several threads in parallel. The blocks are
+   * written in order, each preceded by a block header. When the file is closed,
+   * an index of all blocks and a footer with the position of the index are
+   * appended, so readers can jump to any record without uncompressing the
+   * blocks before it.
+   */
+  class SeqBlockWriter {
+  public:
+    /** Take over the open file descriptor and write the file header. */
+    SeqBlockWriter(int fd, const SeqFileBlockSettings& settings);
+    /** Write everything still pending, the index and the footer and close the file. */
+    ~SeqBlockWriter();
+    /** No copying */
+    SeqBlockWriter(const SeqBlockWriter&) = delete;
+    /** No assignment */
+    SeqBlockWriter& operator=(const SeqBlockWriter&) = delete;
+
+    /** Add a record, the first word of which is its size in bytes. Returns false on a write error. */
+    bool write(const char* buf, int size);
+    /** Upper limit of the file size if it was closed now */
+    uint64_t getFileSize() const;
+
+  private:
+    /** One block which is filled, compressed or waiting to be written */
+    struct Block {
+      /** Position and sizes of the block, offset is set when it is written */
+      SeqFileBlockInfo info;
+      /** Uncompressed records */
+      std::vector<char> raw;
+      /** Compressed records, empty if compression did not reduce the size */
+      std::vector<char> compressed;
+    };
+
+    /** Hand the current block to the compression and start a new one */
+    void flushBlock();
+    /** Wait for the oldest pending block and write it to the file */
+    bool writeOldestBlock();
+    /** Write the given number of bytes at the end of the file */
+    bool writeBytes(const void* data, size_t size);
+
+    /** File descriptor, owned by the writer */
+    int m_fd;
+    /** Settings of the block format */
+    SeqFileBlockSettings m_settings;
+    /** Block which is currently filled */
+    std::unique_ptr<Block> m_current;
+    /** Blocks being compressed, in the order they have to be written */
+    std::deque<std::future<std::unique_ptr<Block>>> m_pending;
+    /** Raw size of the pending blocks */
+    uint64_t m_pendingSize{0};
+    /** Index of all blocks written so far */
+    std::vector<SeqFileBlockInfo> m_index;
+    /** Number of records added so far */
+    uint64_t m_nRecords{0};
+    /** Number of bytes written to the file */
+    uint64_t m_fileSize{0};
+    /** Set after the first write error, nothing is written afterwards */
+    bool m_failed{false};
+  };
+
+  /** Reads records from a file in the block format of SeqFile.
+   *
+   * The block index is taken from the end of the file. If the file was not
+   * closed properly, the index is rebuilt from the block headers, so all complete
+   * blocks can still be read. The blocks following the current one are read and
+   * uncompressed ahead by a number of threads.
+   */
+  class SeqBlockReader {
+  public:
+    /** Take over the open file descriptor and read the block index. Use isValid() to check for errors. */
+    SeqBlockReader(int fd, int nThreads);
+    /** Wait for blocks still being read and close the file. */
+    ~SeqBlockReader();
+    /** No copying */
+    SeqBlockReader(const SeqBlockReader&) = delete;
+    /** No assignment */
+    SeqBlockReader& operator=(const SeqBlockReader&) = delete;
+
+    /** Check whether the file descriptor points to a file in the block format without moving the file position. */
+    static bool hasBlockFormat(int fd);
+
+    /** True if the file header and the index could be read */
+    bool isValid() const { return m_valid; }
+    /** Number of records in the file */
+    uint64_t getNumberOfRecords() const { return m_nRecords; }
+    /** Read the next record. Returns the record size, 0 at the end of the file and -1 on errors. */
+    int read(char* buf, int max);
+    /** Continue reading at the given record number. Returns false if the file has fewer records. */
+    bool seek(uint64_t record);
+
+  private:
+    /** One block read from the file and uncompressed */
+    struct Block {
+      /** Position and sizes of the block */
+      SeqFileBlockInfo info;
+      /** Uncompressed records, empty on errors */
+      std::vector<char> raw;
+    };
+
+    /** Read the index from the end of the file, returns false if there is none */
+    bool readIndex(uint64_t fileSize);
+    /** Build the index from the block headers, for files which were not closed properly */
+    void scanBlocks(uint64_t fileSize);
+    /** Start reading blocks ahead until enough are pending */
+    void readAhead();
+    /** Take the oldest block read ahead as the current block, returns false if it could not be read */
+    bool loadBlock();
+    /** Size of the next record in the current block, -1 if the block is corrupt */
+    int nextRecordSize() const;
+    /** Cancel all blocks which are read ahead */
+    void clearPending();
+
+    /** File descriptor, owned by the reader */
+    int m_fd;
+    /** Number of threads for reading ahead */
+    int m_nThreads;
+    /** True if the file could be opened */
+    bool m_valid{false};
+    /** Index of all blocks */
+    std::vector<SeqFileBlockInfo> m_index;
+    /** Number of records in the file */
+    uint64_t m_nRecords{0};
+    /** Blocks read ahead, starting with the one after the current block */
+    std::deque<std::future<std::unique_ptr<Block>>> m_pending;
+    /** Index of the next block to be read ahead */
+    size_t m_nextBlock{0};
+    /** Block the records are currently taken from */
+    std::unique_ptr<Block> m_current;
+    /** Position of the next record in the current block */
+    size_t m_position{0};
+    /** Number of records left in the current block */
+    uint32_t m_recordsLeft{0};
+  };
+}
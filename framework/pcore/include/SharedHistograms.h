@@ -0,0 +1,182 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TArray;
+class TH1;
+
+namespace Belle2 {
+
+  /** Descriptor of one histogram in SharedHistograms, placed in the shared memory after SharedHistogramsInfo. */
+  struct SharedHistogramSlot {
+    /** Maximal length of the histogram key including the terminating zero. */
+    const static size_t c_MaxKeyLength = 256;
+
+    /** Slot state: 0 free, 1 being registered, 2 shared, 3 not shared (e.g. no memory left). */
+    std::atomic<int> state;
+    char type; /**< Type of the bin contents: 'D', 'F', 'I', 'S' or 'C'. */
+    bool hasSumw2; /**< True if the sums of squared weights are stored as well. */
+    int nCells; /**< Number of cells (bins including under- and overflow). */
+    uint64_t offset; /**< Offset of the data of this histogram in the data area. */
+    uint64_t prototypeOffset; /**< Offset of the streamed empty histogram in the data area. */
+    uint32_t prototypeSize; /**< Size of the streamed empty histogram in bytes. */
+    char key[c_MaxKeyLength]; /**< Directory and name of the histogram, e.g. "/CDC/hADC". */
+  };
+
+  /** State of one stripe, placed in the shared memory after SharedHistogramsInfo. */
+  struct SharedHistogramStripe {
+    /** 0 free, 1 filled by a running process, 2 the process detached its histograms. */
+    std::atomic<int> state;
+    int pid; /**< Process filling the stripe. */
+  };
+
+  /** Metadata of SharedHistograms, placed at the beginning of the shared memory. */
+  struct SharedHistogramsInfo {
+    uint64_t dataSize; /**< Size of the data area in bytes. */
+    unsigned int nSlots; /**< Number of histogram slots. */
+    unsigned int nStripes; /**< Number of stripes, i.e. processes which can fill the histograms. */
+    std::atomic<unsigned int> nextStripe; /**< Next stripe to be handed out. */
+    std::atomic<uint64_t> used; /**< Used bytes in the data area. */
+  };
+
+  /** Histogram bins in shared memory, filled by all processes of a parallel basf2 job.
+   *
+   * The memory is mapped anonymously before the processes are forked, so all of them see the same
+   * bins. Every process gets its own stripe of the bin arrays: the arrays of its histograms are
+   * pointed into the stripe, so the usual (non atomic) TH1::Fill() can be used without races. The
+   * totals are the sums over the stripes and can be read at any time by any process, without
+   * writing and merging files.
+   *
+   * Histograms are identified by their directory and name, so all processes have to define the
+   * same histograms. The first process attaching a histogram also stores an empty copy of it, so
+   * the totals can be created by any process without defining the histograms again.
+   * The statistics (entries, sum of weights, ...) are not bins; they are copied to the shared
+   * memory by publishStatistics().
+   *
+   * @warning The bin arrays of attached histograms point into the shared memory. Anything that
+   * reallocates them, e.g. Rebin(), SetBins() or Sumw2(false), would free shared memory and must not
+   * be called before detachAll(). Histograms that can change their binning by themselves (extendable
+   * axes, bin labels or a fill buffer) are therefore not attached.
+   *
+   * If a process ends without detachAll(), e.g. because it crashed, its stripe is dropped from the
+   * totals. This matches the histogram file of a crashed process, which is never written, and the
+   * events resent to the replacement of the process are not counted twice.
+   */
+  class SharedHistograms {
+  public:
+    /** Number of values for the statistics of each histogram and stripe: the entries and the values of TH1::GetStats(). */
+    const static int c_NStats = 16;
+
+    /** Map the shared memory.
+     * @param sizeBytes size of the data area in bytes, only the used part occupies memory
+     * @param nStripes maximal number of processes filling histograms
+     * @param nSlots maximal number of histograms
+     */
+    SharedHistograms(size_t sizeBytes, unsigned int nStripes, unsigned int nSlots = 16384);
+
+    /** Detach all histograms and unmap the shared memory. */
+    ~SharedHistograms();
+
+    /** No copies. */
+    SharedHistograms(const SharedHistograms&) = delete;
+    /** No assignment. */
+    SharedHistograms& operator=(const SharedHistograms&) = delete;
+
+    /** True if the shared memory could be mapped. */
+    bool isValid() const { return m_info != nullptr; }
+
+    /** Get a stripe for the calling process, -1 if all stripes are taken. */
+    int acquireStripe();
+
+    /** Point the bins of the histogram into the given stripe of the shared memory.
+     *
+     * The current content of the histogram is added to the stripe. Histograms with other bin types
+     * than TArrayD/F/I/S/C (e.g. profiles), histograms which can change their binning, or if there
+     * is no memory left, are not attached.
+     * @param hist histogram to attach
+     * @param key unique identifier of the histogram, the same in all processes
+     * @param stripe stripe returned by acquireStripe()
+     * @return true if the histogram was attached
+     */
+    bool attach(TH1* hist, const std::string& key, int stripe);
+
+    /** Copy the statistics of all attached histograms of this process into their stripes. */
+    void publishStatistics();
+
+    /** Give the attached histograms their own copy of the bins again and mark the stripes of this process as complete. */
+    void detachAll();
+
+    /** Add the totals over all stripes of a shared histogram to the target histogram, which must have the same binning.
+     * @return false if there is no such shared histogram
+     */
+    bool addTotal(TH1& target, const std::string& key) const;
+
+    /** Keys of all shared histograms of all processes. */
+    std::vector<std::string> getKeys() const;
+
+    /** Create an empty histogram like the one attached first with the given key, without directory.
+     * @return nullptr if there is no such shared histogram
+     */
+    std::unique_ptr<TH1> createPrototype(const std::string& key) const;
+
+    /** Number of histograms attached in this process. */
+    size_t getNumberOfAttached() const { return m_attached.size(); }
+
+  private:
+    /** Histogram attached in this process. */
+    struct Attached {
+      TH1* hist; /**< the histogram */
+      TArray* array; /**< array of the bin contents */
+      void* ownContent; /**< original memory of the bin contents */
+      void* ownSumw2; /**< original memory of the sums of squared weights */
+      const SharedHistogramSlot* slot; /**< descriptor in the shared memory */
+      int stripe; /**< stripe filled by this process */
+    };
+
+    /** Find the slot of the key, nullptr if not found. */
+    const SharedHistogramSlot* findSlot(const std::string& key) const;
+
+    /** Find or register the slot of the key, nullptr if not possible.
+     * @param prototype empty copy of the histogram, stored if the slot is registered
+     */
+    SharedHistogramSlot* registerSlot(const std::string& key, char type, bool hasSumw2, int nCells, const TH1& prototype);
+
+    /** True if the stripe is filled by a running process or was completed. */
+    bool isStripeCounted(unsigned int stripe) const;
+
+    /** Start of the statistics of a stripe. */
+    double* getStatistics(const SharedHistogramSlot& slot, int stripe) const;
+
+    /** Start of the bin contents of a stripe. */
+    char* getContent(const SharedHistogramSlot& slot, int stripe) const;
+
+    /** Start of the sums of squared weights of a stripe. */
+    double* getSumw2(const SharedHistogramSlot& slot, int stripe) const;
+
+    /** Bytes used by one histogram for all stripes. */
+    size_t getSize(char type, bool hasSumw2, int nCells) const;
+
+    void* m_memory{nullptr}; /**< Start of the mapped memory. */
+    size_t m_mappedSize{0}; /**< Size of the mapped memory. */
+    SharedHistogramsInfo* m_info{nullptr}; /**< Metadata at the beginning of the memory. */
+    SharedHistogramStripe* m_stripes{nullptr}; /**< State of the stripes. */
+    SharedHistogramSlot* m_slots{nullptr}; /**< Histogram descriptors. */
+    char* m_data{nullptr}; /**< Data area. */
+    std::vector<Attached> m_attached; /**< Histograms attached in this process. */
+    std::vector<int> m_ownStripes; /**< Stripes acquired by this process. */
+  };
+
+} // Belle2 namespace
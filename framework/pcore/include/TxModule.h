@@ -9,7 +9,7 @@
 #pragma once
 
 #include <framework/core/Module.h>
-#include <framework/pcore/RingBuffer.h>
+#include <framework/pcore/RingBufferBase.h>
 #include <framework/datastore/StoreObjPtr.h>
 #include <framework/core/RandomGenerator.h>
 
@@ -17,7 +17,7 @@
 namespace Belle2 {
   class DataStoreStreamer;
 
-  /** Module for encoding data store contents into a RingBuffer. */
+  /** Module for encoding data store contents into a RingBuffer (or LockFreeRingBuffer). */
   class TxModule : public Module {
 
     // Public functions
@@ -25,9 +25,9 @@ namespace Belle2 {
 
     /** Constructor.
      *
-     * @param rbuf Use the given RingBuffer for data
+     * @param rbuf Use the given ring buffer for data
      */
-    explicit TxModule(RingBuffer* rbuf);
+    explicit TxModule(RingBufferBase* rbuf);
     virtual ~TxModule();
 
     //! Module functions to be called from main process
@@ -55,8 +55,8 @@ namespace Belle2 {
     //!Compression parameter
     int m_compressionLevel;
 
-    //! RingBuffer (not owned by us)
-    RingBuffer* m_rbuf;
+    //! ring buffer (not owned by us)
+    RingBufferBase* m_rbuf;
 
     //! DataStoreStreamer
     DataStoreStreamer* m_streamer;
@@ -16,7 +16,7 @@
 namespace Belle2 {
 
   class ProcHandler;
-  class RingBuffer;
+  class RingBufferBase;
 
   /**
     This class provides the core event processing loop for parallel processing.
@@ -58,14 +58,20 @@ namespace Belle2 {
     void cleanup();
 
   private:
+    /** Number of events the output process picks up from the output ring buffer at once. */
+    const static int c_OutputBatchSize = 16;
+
     /** Analyze given path. Fills m_*path objects. */
     void analyzePath(const PathPtr& path);
 
     /** Adds internal modules to paths, prepare RingBuffers. */
     void preparePaths();
 
-    /** Create RingBuffer with name from given environment variable, add Tx and Rx modules to a and b. */
-    RingBuffer* connectViaRingBuffer(const char* name, const PathPtr& a, PathPtr& b);
+    /** Create RingBuffer (or LockFreeRingBuffer, see Environment::getUseLockFreeRingBuffer()) with name from given environment variable, add Tx and Rx modules to a and b.
+     *
+     * @param rxBatchSize Number of events the Rx module picks up at once, only >1 if b is run by a single process.
+     */
+    RingBufferBase* connectViaRingBuffer(const char* name, const PathPtr& a, PathPtr& b, int rxBatchSize = 1);
 
     /** Dump module names in the ModulePtrList */
     void dump_modules(const std::string&, const ModulePtrList&);
@@ -96,9 +102,9 @@ namespace Belle2 {
     PathPtr m_outputPath;
 
     /** input RingBuffer */
-    RingBuffer* m_rbin = nullptr;
+    RingBufferBase* m_rbin = nullptr;
     /** output RingBuffer */
-    RingBuffer* m_rbout = nullptr;;
+    RingBufferBase* m_rbout = nullptr;
 
     /** Pointer to HistoManagerModule, or nullptr if not found. */
     ModulePtr m_histoman;
@@ -24,11 +24,20 @@
 #include <cstdio>                      // for NULL, printf
 
 #include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <queue>
+#include <sstream>
 
 using namespace Belle2;
 
 namespace {
+  /** Milliseconds since given time point. */
+  double msSince(const std::chrono::steady_clock::time_point& start)
+  {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+
 // Thread related
   static DataStoreStreamer* s_streamer = nullptr;
 
@@ -136,6 +145,9 @@ EvtMessage* DataStoreStreamer::streamDataStore(bool addPersistentDurability, boo
   // Clear Message Handler
   m_msghandler->clear();
 
+  // per entry statistics are only collected if they will be printed
+  const bool collectStatistics = statisticsEnabled();
+
   // Stream objects (for all included durabilities)
   int narrays = 0;
   int nobjs = 0;
@@ -153,6 +165,9 @@ EvtMessage* DataStoreStreamer::streamDataStore(bool addPersistentDurability, boo
         if (pos == m_streamobjnames.end())  continue;
       }
 
+      //objects the input module didn't read yet are needed as well
+      entry.ensureLoaded();
+
       //verify that bits are unused
       if (entry.object->TestBit(c_IsTransient)) {
         B2FATAL("DataStoreStreamer::c_IsTransient bit is set for " << name << "!");
@@ -171,7 +186,16 @@ EvtMessage* DataStoreStreamer::streamDataStore(bool addPersistentDurability, boo
       entry.object->SetBit(c_IsTransient, entry.dontWriteOut);
       entry.object->SetBit(c_IsNull, (entry.ptr == nullptr));
       entry.object->SetBit(c_PersistentDurability, (durability == DataStore::c_Persistent));
-      m_msghandler->add(entry.object, name);
+      if (collectStatistics) {
+        const auto start = std::chrono::steady_clock::now();
+        m_msghandler->add(entry.object, name);
+        EntryStatistics& stats = m_entryStatistics[name];
+        stats.nStreamed++;
+        stats.streamedBytes += m_msghandler->getObjectSizes().back();
+        stats.streamTime += msSince(start);
+      } else {
+        m_msghandler->add(entry.object, name);
+      }
       B2DEBUG(100, "adding item " << name);
 
       if (entry.isArray)
@@ -196,7 +220,7 @@ EvtMessage* DataStoreStreamer::streamDataStore(bool addPersistentDurability, boo
   }
 
   // Encode EvtMessage
-  EvtMessage* msg = m_msghandler->encode_msg(MSG_EVENT);
+  EvtMessage* msg = m_reuseMessageBuffer ? m_msghandler->encode_msg_reuse(MSG_EVENT) : m_msghandler->encode_msg(MSG_EVENT);
   (msg->header())->nObjects = nobjs;
   (msg->header())->nArrays = narrays;
 
@@ -230,7 +254,11 @@ int DataStoreStreamer::restoreDataStore(EvtMessage* msg)
       B2WARNING("restoreDataStore(): inconsistent #objects/#arrays in header");
 
     // Restore objects in DataStore
+    const std::vector<UInt_t>& objectSizes = m_msghandler->getObjectSizes();
+    const std::vector<double>& decodeTimes = m_msghandler->getObjectDecodeTimes();
+    const bool collectStatistics = statisticsEnabled();
     for (int i = 0; i < nobjs + narrays; i++) {
+      const auto start = collectStatistics ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
       TObject* obj = objlist.at(i);
       bool array = (dynamic_cast<TClonesArray*>(obj) != nullptr);
       if (obj != nullptr) {
@@ -250,7 +278,18 @@ int DataStoreStreamer::restoreDataStore(EvtMessage* msg)
           auto flags = obj->TestBit(c_IsTransient) ? DataStore::c_DontWriteOut : DataStore::c_WriteOut;
           DataStore::Instance().registerEntry(namelist.at(i), durability, cl, array, flags);
         }
-        DataStore::StoreEntry* entry = DataStore::Instance().getEntry(StoreAccessorBase(namelist.at(i), durability, cl, array));
+        //usually the same layout as in the previous message, otherwise update it
+        if (m_restoreLayout.size() <= (unsigned)i)
+          m_restoreLayout.resize(i + 1, {StoreAccessorBase("", DataStore::c_Event, nullptr, false), nullptr});
+        const StoreAccessorBase& cached = m_restoreLayout[i].first;
+        if (cached.getName() != namelist[i] or cached.getDurability() != durability or cached.getClass() != cl
+            or cached.isArray() != array) {
+          m_restoreLayout[i] = {StoreAccessorBase(namelist[i], durability, cl, array), &m_entryStatistics[namelist[i]]};
+        }
+        const StoreAccessorBase& accessor = m_restoreLayout[i].first;
+        EntryStatistics& stats = *m_restoreLayout[i].second;
+
+        DataStore::StoreEntry* entry = DataStore::Instance().getEntry(accessor);
         B2ASSERT("Can not find a data store entry with the name " << namelist.at(i) << ". Did you maybe forget to register it?", entry);
         //only restore object if it is valid for current event
         bool ptrIsNULL = obj->TestBit(c_IsNull);
@@ -263,8 +302,7 @@ int DataStoreStreamer::restoreDataStore(EvtMessage* msg)
             delete obj;
           } else {
             //note: replace=true
-            DataStore::Instance().createObject(obj, true,
-                                               StoreAccessorBase(namelist.at(i), durability, cl, array));
+            DataStore::Instance().createObject(obj, true, accessor);
 
             //reset bits of object in DataStore (are checked to be false when streaming the object)
             obj->SetBit(c_IsTransient, false);
@@ -279,6 +317,11 @@ int DataStoreStreamer::restoreDataStore(EvtMessage* msg)
           //not stored, clean up
           delete obj;
         }
+        if (collectStatistics) {
+          stats.nRestored++;
+          stats.restoredBytes += objectSizes.at(i);
+          stats.restoreTime += decodeTimes.at(i) * 1e-6 + msSince(start);
+        }
       } else {
         //DataStore always has non-NULL content (whether they're available is a different matter)
         B2ERROR("restoreDS: " << (array ? "Array" : "Object") << ": " << namelist.at(i) << " is NULL!");
@@ -291,6 +334,28 @@ int DataStoreStreamer::restoreDataStore(EvtMessage* msg)
   return 0;
 }
 
+bool DataStoreStreamer::statisticsEnabled() const
+{
+  return LogSystem::Instance().isLevelEnabled(LogConfig::c_Debug, c_statisticsDebugLevel, PACKAGENAME());
+}
+
+void DataStoreStreamer::printEntryStatistics(int debugLevel) const
+{
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(3);
+  out << "DataStoreStreamer statistics (name: #streamed, kB/event, ms/event | #restored, kB/event, ms/event)";
+  for (const auto& [name, stats] : m_entryStatistics) {
+    out << "\n  " << name << ": ";
+    out << stats.nStreamed << ", "
+        << (stats.nStreamed ? stats.streamedBytes / stats.nStreamed / 1024 : 0) << ", "
+        << (stats.nStreamed ? stats.streamTime / stats.nStreamed : 0) << " | ";
+    out << stats.nRestored << ", "
+        << (stats.nRestored ? stats.restoredBytes / stats.nRestored / 1024 : 0) << ", "
+        << (stats.nRestored ? stats.restoreTime / stats.nRestored : 0);
+  }
+  B2DEBUG(debugLevel, out.str());
+}
+
 // Parallel EvtMessage Destreamer implemented using thread
 
 int DataStoreStreamer::queueEvtMessage(char* evtbuf)
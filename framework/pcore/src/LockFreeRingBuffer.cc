@@ -0,0 +1,466 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/pcore/LockFreeRingBuffer.h>
+#include <framework/logging/Logger.h>
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+
+using namespace std;
+using namespace Belle2;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free and std::atomic<uint64_t>::is_always_lock_free,
+              "LockFreeRingBuffer needs address-free atomics in shared memory");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be plain 32 bit integers");
+static_assert((LockFreeRingBuffer::c_NSlots & (LockFreeRingBuffer::c_NSlots - 1)) == 0, "c_NSlots must be a power of two");
+
+namespace {
+  /** Sleep until *addr != expected, we're woken up, or the timeout (ns) expires. Not private, the futex is in shared memory. */
+  void futexWait(std::atomic<uint32_t>* addr, uint32_t expected, long timeout)
+  {
+    struct timespec ts = {0, timeout};
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAIT, expected, &ts, nullptr, 0);
+  }
+
+  /** Wake up to n processes waiting on addr. */
+  void futexWake(std::atomic<uint32_t>* addr, int n)
+  {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(addr), FUTEX_WAKE, n, nullptr, nullptr, 0);
+  }
+
+  /** Pack ticket and offset into one word. */
+  uint64_t pack(uint32_t ticket, uint32_t offset) { return (static_cast<uint64_t>(ticket) << 32) | offset; }
+  /** Ticket from packed word. */
+  uint32_t ticketOf(uint64_t packed) { return packed >> 32; }
+  /** Offset from packed word. */
+  uint32_t offsetOf(uint64_t packed) { return packed & 0xffffffff; }
+}
+
+LockFreeRingBuffer::LockFreeRingBuffer(int nwords)
+{
+  openSHM(nwords);
+  B2DEBUG(32, "LockFreeRingBuffer initialization done");
+}
+
+LockFreeRingBuffer::LockFreeRingBuffer(const std::string& name, unsigned int nwords)
+{
+  if (name != "private") { // Global
+    m_file = true;
+    m_pathname = std::string(std::filesystem::temp_directory_path() / getenv("USER")) + "_RB_" + name;
+    m_pathfd = open(m_pathname.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (m_pathfd > 0) {   // a new shared memory file created
+      B2DEBUG(32, "[LockFreeRingBuffer] Creating a ring buffer with key " << name);
+      m_new = true;
+    } else if (m_pathfd == -1 && errno == EEXIST) { // shm already there
+      B2DEBUG(32, "[LockFreeRingBuffer] Attaching the ring buffer with key " << name);
+      m_new = false;
+      m_file = false;
+    } else {
+      B2FATAL("LockFreeRingBuffer: error opening shm file: " << m_pathname);
+    }
+    m_shmkey = ftok(m_pathname.c_str(), 1);
+  }
+
+  openSHM(nwords);
+
+  if (m_pathfd > 0) {
+    char rbufinfo[256];
+    snprintf(rbufinfo, sizeof(rbufinfo), "%d\n%d\n", m_shmid, -1);
+    int is = write(m_pathfd, rbufinfo, strlen(rbufinfo));
+    if (is < 0) perror("write");
+    close(m_pathfd);
+  }
+  B2DEBUG(32, "LockFreeRingBuffer initialization done with shm=" << m_shmid);
+}
+
+LockFreeRingBuffer::~LockFreeRingBuffer()
+{
+  cleanup();
+}
+
+void LockFreeRingBuffer::openSHM(int nwords)
+{
+  const size_t headerBytes = sizeof(LockFreeRingBufInfo) + c_NSlots * sizeof(LockFreeRingBufSlot);
+  size_t sizeBytes = m_new ? std::max<size_t>(static_cast<size_t>(nwords) * sizeof(int), 2 * headerBytes) : 0;
+  const auto mode = IPC_CREAT | 0644;
+  m_shmid = shmget(m_shmkey, sizeBytes, mode);
+  if (m_shmid < 0) {
+    size_t maxSizeBytes = sizeBytes;
+    ifstream shmax("/proc/sys/kernel/shmmax");
+    if (shmax.good())
+      shmax >> maxSizeBytes;
+    shmax.close();
+
+    B2WARNING("LockFreeRingBuffer: shmget(" << sizeBytes << ") failed, limiting to system maximum: " << maxSizeBytes);
+    sizeBytes = maxSizeBytes;
+    m_shmid = shmget(m_shmkey, sizeBytes, mode);
+    if (m_shmid < 0) {
+      B2FATAL("LockFreeRingBuffer: shmget(" << sizeBytes <<
+              ") failed. Most likely the system doesn't allow us to reserve the needed shared memory. Try 'echo 500000000 > /proc/sys/kernel/shmmax' as root to set a higher limit (500MB).");
+    }
+  }
+  m_shmadr = static_cast<char*>(shmat(m_shmid, nullptr, 0));
+  if (m_shmadr == reinterpret_cast<char*>(-1)) {
+    B2FATAL("LockFreeRingBuffer: Attaching to shared memory segment via shmat() failed");
+  }
+
+  m_bufinfo = reinterpret_cast<LockFreeRingBufInfo*>(m_shmadr);
+  m_slots = reinterpret_cast<LockFreeRingBufSlot*>(m_shmadr + sizeof(LockFreeRingBufInfo));
+  m_buftop = reinterpret_cast<int*>(m_shmadr + headerBytes);
+  if (m_new) {
+    initInfo((sizeBytes - headerBytes) / sizeof(int));
+    // Leave id of shm in file name, there's no semaphore
+    m_semshmFileName = std::string(std::filesystem::temp_directory_path() / "SHM") + to_string(m_shmid) + "-SEM-1-UNNAMED";
+    int fd = open(m_semshmFileName.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd < 0) {
+      B2WARNING("LockFreeRingBuffer ID file could not be created.");
+    } else {
+      close(fd);
+    }
+  } else {
+    //the creating process publishes the magic value last, wait until initialization is complete
+    while (m_bufinfo->magic.load(std::memory_order_acquire) != LockFreeRingBufInfo::c_Magic)
+      usleep(20);
+    m_bufinfo->nattached++;
+    B2DEBUG(32, "[LockFreeRingBuffer] check entries = " << numq());
+    B2DEBUG(32, "[LockFreeRingBuffer] check size = " << m_bufinfo->size);
+  }
+}
+
+void LockFreeRingBuffer::initInfo(uint32_t size)
+{
+  auto* info = new (m_bufinfo) LockFreeRingBufInfo;
+  info->size = size;
+  info->nslots = c_NSlots;
+  info->semid = -1;
+  info->reserve = 0;
+  info->reclaim = 0;
+  info->readTicket = 0;
+  info->nPublished = 0;
+  info->nWaitingRx = 0;
+  info->nReclaimed = 0;
+  info->nWaitingTx = 0;
+  info->numAttachedTx = -1;
+  info->nbusy = 0;
+  info->nattached = 1;
+  info->killed = 0;
+  info->ninsq = 0;
+  info->nremq = 0;
+  for (uint32_t i = 0; i < info->nslots; i++) {
+    auto* s = new (&m_slots[i]) LockFreeRingBufSlot;
+    s->seq = i;
+    s->start = s->end = 0;
+    s->size = 0;
+  }
+  info->magic.store(LockFreeRingBufInfo::c_Magic, std::memory_order_release);
+}
+
+void LockFreeRingBuffer::cleanup()
+{
+  setBusy(false);
+  m_bufinfo->nattached--;
+
+  shmdt(m_shmadr);
+  B2DEBUG(32, "LockFreeRingBuffer: Cleaning up IPC");
+  if (m_new) {
+    shmctl(m_shmid, IPC_RMID, (struct shmid_ds*) nullptr);
+    if (m_file) {
+      unlink(m_pathname.c_str());
+    }
+    unlink(m_semshmFileName.c_str());
+  }
+}
+
+int LockFreeRingBuffer::insq(const int* buf, int size, bool checkTx)
+{
+  if (size <= 0) {
+    B2FATAL("LockFreeRingBuffer::insq() failed: invalid buffer size = " << size);
+  }
+  if (m_bufinfo->numAttachedTx == 0 and checkTx) {
+    //safe abort was requested
+    B2WARNING("Number of attached Tx is 0, so I will not go on with the processing.");
+    exit(0);
+  }
+  const uint32_t bufsize = m_bufinfo->size;
+  const uint32_t nwords = size;
+  if (nwords > bufsize / 2) {
+    throw std::runtime_error("[LockFreeRingBuffer::insq ()] Inserted item (size: " + std::to_string(size) +
+                             ") is larger than half of the LockFreeRingBuffer (size: " + std::to_string(bufsize) + ")!");
+  }
+  //waitForSpace() sleeps only if nothing got reclaimed since here
+  m_reclaimedSeen = m_bufinfo->nReclaimed.load();
+
+  uint64_t reserved = m_bufinfo->reserve.load(std::memory_order_acquire);
+  uint32_t ticket;
+  uint32_t start;
+  while (true) {
+    ticket = ticketOf(reserved);
+    const uint32_t wptr = offsetOf(reserved);
+    const uint64_t reclaimed = m_bufinfo->reclaim.load(std::memory_order_acquire);
+    const uint32_t freeWords = (ticketOf(reclaimed) == ticket) ? bufsize : (offsetOf(reclaimed) + bufsize - wptr) % bufsize;
+
+    //entries are contiguous, skip the rest of the buffer if it's too small
+    start = wptr;
+    uint32_t needed = nwords;
+    if (wptr + nwords > bufsize) {
+      start = 0;
+      needed += bufsize - wptr;
+    }
+
+    if (needed > freeWords or slot(ticket).seq.load(std::memory_order_acquire) != ticket) {
+      if (reclaim())
+        continue;
+      //our view might be outdated, only give up if nobody else got in between
+      const uint64_t current = m_bufinfo->reserve.load(std::memory_order_acquire);
+      if (current == reserved)
+        return -1;
+      reserved = current;
+      continue;
+    }
+    if (m_bufinfo->reserve.compare_exchange_weak(reserved, pack(ticket + 1, (start + nwords) % bufsize),
+                                                 std::memory_order_acq_rel, std::memory_order_acquire))
+      break;
+  }
+
+  LockFreeRingBufSlot& s = slot(ticket);
+  s.start = start;
+  s.end = (start + nwords) % bufsize;
+  s.size = size;
+  memcpy(m_buftop + start, buf, nwords * sizeof(int));
+  s.seq.store(ticket + 1, std::memory_order_release);
+
+  m_bufinfo->ninsq++;
+  m_bufinfo->nPublished++;
+  if (m_bufinfo->nWaitingRx > 0)
+    futexWake(&m_bufinfo->nPublished, 1);
+  return size;
+}
+
+int LockFreeRingBuffer::claim(int maxEntries, uint32_t& firstTicket)
+{
+  maxEntries = std::min<int>(maxEntries, m_bufinfo->nslots / 2);
+  uint32_t ticket = m_bufinfo->readTicket.load(std::memory_order_acquire);
+  while (not m_bufinfo->killed) {
+    int n = 0;
+    while (n < maxEntries and slot(ticket + n).seq.load(std::memory_order_acquire) == ticket + n + 1)
+      n++;
+    if (n == 0) {
+      //nothing published, unless someone else claimed it in the meantime
+      const uint32_t current = m_bufinfo->readTicket.load(std::memory_order_acquire);
+      if (current == ticket)
+        return 0;
+      ticket = current;
+      continue;
+    }
+    if (m_bufinfo->readTicket.compare_exchange_weak(ticket, ticket + n, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      firstTicket = ticket;
+      return n;
+    }
+  }
+  return 0;
+}
+
+void LockFreeRingBuffer::release(uint32_t ticket)
+{
+  slot(ticket).seq.store(ticket + 2, std::memory_order_release);
+  m_bufinfo->nremq++;
+  reclaim();
+}
+
+bool LockFreeRingBuffer::reclaim()
+{
+  bool reclaimed = false;
+  uint64_t current = m_bufinfo->reclaim.load(std::memory_order_acquire);
+  while (true) {
+    const uint32_t ticket = ticketOf(current);
+    LockFreeRingBufSlot& s = slot(ticket);
+    if (s.seq.load(std::memory_order_acquire) != ticket + 2)
+      break;
+    const uint64_t next = pack(ticket + 1, s.end);
+    if (m_bufinfo->reclaim.compare_exchange_weak(current, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+      s.seq.store(ticket + m_bufinfo->nslots, std::memory_order_release);
+      reclaimed = true;
+      current = next;
+    }
+  }
+  if (reclaimed) {
+    m_bufinfo->nReclaimed++;
+    if (m_bufinfo->nWaitingTx > 0)
+      futexWake(&m_bufinfo->nReclaimed, INT_MAX);
+  }
+  return reclaimed;
+}
+
+void LockFreeRingBuffer::setBusy(bool busy)
+{
+  if (busy == m_procIsBusy)
+    return;
+  if (busy)
+    m_bufinfo->nbusy++;
+  else
+    m_bufinfo->nbusy--;
+  m_procIsBusy = busy;
+}
+
+int LockFreeRingBuffer::remq(int* buf)
+{
+  uint32_t ticket;
+  if (claim(1, ticket) == 0) {
+    setBusy(false);
+    return 0;
+  }
+  const LockFreeRingBufSlot& s = slot(ticket);
+  const int nw = s.size;
+  if (buf)
+    memcpy(buf, m_buftop + s.start, nw * sizeof(int));
+  release(ticket);
+  setBusy(true);
+  return nw;
+}
+
+int LockFreeRingBuffer::remqBatch(std::vector<int>& buf, std::vector<int>& sizes, int maxEntries)
+{
+  uint32_t first;
+  const int nentries = claim(maxEntries, first);
+  for (int i = 0; i < nentries; i++) {
+    const LockFreeRingBufSlot& s = slot(first + i);
+    buf.insert(buf.end(), m_buftop + s.start, m_buftop + s.start + s.size);
+    sizes.push_back(s.size);
+    release(first + i);
+  }
+  setBusy(nentries > 0);
+  return nentries;
+}
+
+const int* LockFreeRingBuffer::acquireq(int& size)
+{
+  releaseq();
+  if (m_nAcquired == 0) {
+    m_nAcquired = claim(m_readBatchSize, m_acquiredTicket);
+    if (m_nAcquired == 0) {
+      setBusy(false);
+      return nullptr;
+    }
+  }
+  setBusy(true);
+  const LockFreeRingBufSlot& s = slot(m_acquiredTicket);
+  size = s.size;
+  m_acquiredTicket++;
+  m_nAcquired--;
+  m_acquirePending = true;
+  return m_buftop + s.start;
+}
+
+void LockFreeRingBuffer::releaseq()
+{
+  if (not m_acquirePending)
+    return;
+  m_acquirePending = false;
+  release(m_acquiredTicket - 1);
+}
+
+int LockFreeRingBuffer::numq() const
+{
+  if (m_bufinfo->killed)
+    return 0;
+  return static_cast<int>(ticketOf(m_bufinfo->reserve.load()) - m_bufinfo->readTicket.load());
+}
+
+void LockFreeRingBuffer::waitForEntries()
+{
+  m_bufinfo->nWaitingRx++;
+  const uint32_t published = m_bufinfo->nPublished.load();
+  const uint32_t ticket = m_bufinfo->readTicket.load();
+  if (not m_bufinfo->killed and m_bufinfo->numAttachedTx != 0 and slot(ticket).seq.load() != ticket + 1)
+    futexWait(&m_bufinfo->nPublished, published, c_WaitTimeout);
+  m_bufinfo->nWaitingRx--;
+}
+
+void LockFreeRingBuffer::waitForSpace()
+{
+  m_bufinfo->nWaitingTx++;
+  if (not m_bufinfo->killed)
+    futexWait(&m_bufinfo->nReclaimed, m_reclaimedSeen, c_WaitTimeout);
+  m_bufinfo->nWaitingTx--;
+}
+
+void LockFreeRingBuffer::txAttached()
+{
+  int pending = -1;
+  //first attach
+  m_bufinfo->numAttachedTx.compare_exchange_strong(pending, 0);
+  m_bufinfo->numAttachedTx++;
+}
+
+void LockFreeRingBuffer::txDetached()
+{
+  int attached = m_bufinfo->numAttachedTx.load();
+  while (attached > 0 and not m_bufinfo->numAttachedTx.compare_exchange_weak(attached, attached - 1)) { }
+  if (attached <= 1) {
+    m_bufinfo->numAttachedTx = 0;
+    //let the readers check isDead()
+    futexWake(&m_bufinfo->nPublished, INT_MAX);
+  }
+}
+
+void LockFreeRingBuffer::kill()
+{
+  m_bufinfo->numAttachedTx = 0;
+  m_bufinfo->killed = 1;
+  futexWake(&m_bufinfo->nPublished, INT_MAX);
+  futexWake(&m_bufinfo->nReclaimed, INT_MAX);
+}
+
+bool LockFreeRingBuffer::isDead() const
+{
+  //NOTE: numAttachedTx == -1 also means we should read data (i.e. initialization pending)
+  return (m_bufinfo->numAttachedTx == 0) and (numq() <= 0);
+}
+
+bool LockFreeRingBuffer::allRxWaiting() const
+{
+  return (m_bufinfo->nbusy == 0) and (numq() == 0);
+}
+
+int LockFreeRingBuffer::clear()
+{
+  m_bufinfo->reserve = 0;
+  m_bufinfo->reclaim = 0;
+  m_bufinfo->readTicket = 0;
+  m_bufinfo->killed = 0;
+  m_bufinfo->ninsq = 0;
+  m_bufinfo->nremq = 0;
+  for (uint32_t i = 0; i < m_bufinfo->nslots; i++)
+    m_slots[i].seq = i;
+  m_bufinfo->nReclaimed++;
+  futexWake(&m_bufinfo->nReclaimed, INT_MAX);
+  return 0;
+}
+
+int LockFreeRingBuffer::shmid() const
+{
+  return m_shmid;
+}
@@ -13,6 +13,10 @@
 #include <TMessage.h>
 #include <RZip.h>
 
+#include <sys/time.h>
+
+#include <chrono>
+
 using namespace std;
 using namespace Belle2;
 
@@ -33,14 +37,17 @@ MsgHandler::MsgHandler(int complevel):
   //If disabled, streamers will crash when reading data.
   TMessage::EnableSchemaEvolutionForAll();
   m_msg->SetWriteMode();
+  clear();
 }
 
 MsgHandler::~MsgHandler()  = default;
 
 void MsgHandler::clear()
 {
-  m_buf.clear();
+  //leave space for the header, so encode_msg_reuse() can build the message in place
+  m_buf.resize(sizeof(EvtHeader));
   m_compBuf.clear();
+  m_objectSizes.clear();
 }
 
 void MsgHandler::add(const TObject* obj, const string& name)
@@ -62,6 +69,35 @@ void MsgHandler::add(const TObject* obj, const string& name)
   m_buf.add(&len, sizeof(len));
   m_buf.add(buf, len);
   m_msg->Reset();
+  m_objectSizes.push_back(len);
+}
+
+CharBuffer* MsgHandler::compress(unsigned int& flags)
+{
+  // defaults to uncompressed
+  flags = 0;
+  if (m_complevel <= 0)
+    return &m_buf;
+
+  const int headerSize = sizeof(EvtHeader);
+  // make sure buffer for the compression is big enough.
+  m_compBuf.resize(m_buf.size());
+  // And call the root compression function
+  const int algorithm = m_complevel / 100;
+  const int level = m_complevel % 100;
+  int irep{0}, nin{(int)m_buf.size() - headerSize}, nout{nin};
+  R__zipMultipleAlgorithm(level, &nin, m_buf.data() + headerSize, &nout, m_compBuf.data() + headerSize, &irep,
+                          (ROOT::RCompressionSetting::EAlgorithm::EValues) algorithm);
+  // it returns the number of bytes of the output in irep. If that is zero or
+  // to big compression failed and we transmit uncompressed.
+  if (irep > 0 && irep <= nin) {
+    //set correct size of compressed message
+    m_compBuf.resize(headerSize + irep);
+    // also add a flag indicating it's compressed
+    flags = EvtMessage::c_MsgCompressed;
+    return &m_compBuf;
+  }
+  return &m_buf;
 }
 
 EvtMessage* MsgHandler::encode_msg(ERecordType rectype)
@@ -71,43 +107,46 @@ EvtMessage* MsgHandler::encode_msg(ERecordType rectype)
     return eod;
   }
 
-  // which buffer to send? defaults to uncompressed
-  auto buf = &m_buf;
   unsigned int flags = 0;
-  // but if we have compression enabled then please compress.
-  if (m_complevel > 0) {
-    // make sure buffer for the compression is big enough.
-    m_compBuf.resize(m_buf.size());
-    // And call the root compression function
-    const int algorithm = m_complevel / 100;
-    const int level = m_complevel % 100;
-    int irep{0}, nin{(int)m_buf.size()}, nout{nin};
-    R__zipMultipleAlgorithm(level, &nin, m_buf.data(), &nout, m_compBuf.data(), &irep,
-                            (ROOT::RCompressionSetting::EAlgorithm::EValues) algorithm);
-    // it returns the number of bytes of the output in irep. If that is zero or
-    // to big compression failed and we transmit uncompressed.
-    if (irep > 0 && irep <= nin) {
-      //set correct size of compressed message
-      m_compBuf.resize(irep);
-      // and set pointer to correct buffer for creating message
-      buf = &m_compBuf;
-      // also add a flag indicating it's compressed
-      flags = EvtMessage::c_MsgCompressed;
-    }
-  }
-
-  auto* evtmsg = new EvtMessage(buf->data(), buf->size(), rectype);
+  CharBuffer* buf = compress(flags);
+  auto* evtmsg = new EvtMessage(buf->data() + sizeof(EvtHeader), buf->size() - sizeof(EvtHeader), rectype);
   evtmsg->setMsgFlags(flags);
   clear();
 
   return evtmsg;
 }
 
+EvtMessage* MsgHandler::encode_msg_reuse(ERecordType rectype)
+{
+  if (rectype == MSG_TERMINATE)
+    return encode_msg(rectype);
+
+  unsigned int flags = 0;
+  CharBuffer* buf = compress(flags);
+
+  // zero the bytes up to the next int boundary, as EvtMessage does for its own buffers
+  const size_t size = buf->size();
+  const size_t paddedSize = sizeof(int) * ((size + sizeof(int) - 1) / sizeof(int));
+  buf->resize(paddedSize);
+  memset(buf->data() + size, 0, paddedSize - size);
+  buf->resize(size);
+
+  new (buf->data()) EvtHeader(size, rectype);
+  auto* evtmsg = new EvtMessage(buf->data());
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  evtmsg->setTime(tv);
+  evtmsg->setMsgFlags(flags);
+  return evtmsg;
+}
+
 void MsgHandler::decode_msg(EvtMessage* msg, vector<TObject*>& objlist,
                             vector<string>& namelist)
 {
   const char* msgptr = msg->msg();
   const char* end = msgptr + msg->msg_size();
+  m_objectSizes.clear();
+  m_objectDecodeTimes.clear();
 
   if (msg->hasMsgFlags(EvtMessage::c_MsgCompressed)) {
     // apparently message is compressed, let's decompress
@@ -163,9 +202,12 @@ void MsgHandler::decode_msg(EvtMessage* msg, vector<TObject*>& objlist,
     if (objlen == 0 || std::distance(msgptr, end) < objlen)
       B2FATAL("Buffer overrun while decoding object, check length fields!");
 
+    const auto start = std::chrono::steady_clock::now();
     m_inMsg.SetBuffer(msgptr, objlen);
     objlist.push_back(m_inMsg.readTObject());
     msgptr += objlen;
+    m_objectSizes.push_back(objlen);
+    m_objectDecodeTimes.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
     //no need to call InMessage::Reset() here (done in SetBuffer())
   }
 }
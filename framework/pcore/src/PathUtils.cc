@@ -129,6 +129,8 @@ ModulePtrList PathUtils::preparePaths(PathPtr& inputPath, PathPtr& mainPath, Pat
   unsigned int eventBufferSize = environment.getZMQEventBufferSize();
   unsigned int workerTimeout = environment.getZMQWorkerTimeout();
   bool useEventBackup = environment.getZMQUseEventBackup();
+  unsigned int batchSize = environment.getZMQBatchSize();
+  int batchCompressionLevel = environment.getZMQBatchCompressionLevel();
 
   if (inputPath) {
     // Add TXInput after input path
@@ -139,6 +141,8 @@ ModulePtrList PathUtils::preparePaths(PathPtr& inputPath, PathPtr& mainPath, Pat
     zmqTxInputModule->getParam<unsigned int>("workerProcessTimeout").setValue(workerTimeout);
     zmqTxInputModule->getParam<bool>("useEventBackup").setValue(useEventBackup);
     zmqTxInputModule->getParam<unsigned int>("maximalWaitingTime").setValue(maximalWaitingTime);
+    zmqTxInputModule->getParam<unsigned int>("batchSize").setValue(batchSize);
+    zmqTxInputModule->getParam<int>("batchCompressionLevel").setValue(batchCompressionLevel);
     appendModule(inputPath, zmqTxInputModule);
 
     // Add RXWorker before main path
@@ -158,6 +162,8 @@ ModulePtrList PathUtils::preparePaths(PathPtr& inputPath, PathPtr& mainPath, Pat
     zmqTxWorkerModule->getParam<std::string>("socketName").setValue(outputSocketAddress);
     zmqTxWorkerModule->getParam<std::string>("xpubProxySocketName").setValue(pubSocketAddress);
     zmqTxWorkerModule->getParam<std::string>("xsubProxySocketName").setValue(pubSocketAddress);
+    zmqTxWorkerModule->getParam<unsigned int>("batchSize").setValue(batchSize);
+    zmqTxWorkerModule->getParam<int>("batchCompressionLevel").setValue(batchCompressionLevel);
     appendModule(mainPath, zmqTxWorkerModule);
 
     // Add RXOutput before output path
@@ -9,11 +9,13 @@
 #include <framework/core/HistoModule.h>
 #include <framework/pcore/RbTuple.h>
 #include <framework/pcore/ProcHandler.h>
+#include <framework/pcore/SharedHistograms.h>
 
 #include <framework/logging/Logger.h>
 
 #include <TFileMerger.h>
 #include <TFile.h>
+#include <TH1.h>
 
 #include <unistd.h>
 #include <dirent.h>
@@ -44,12 +46,19 @@ RbTupleManager& RbTupleManager::Instance()
 }
 
 // Global initialization
-void RbTupleManager::init(int nprocess, const char* filename, const char* workdir)
+void RbTupleManager::init(int nprocess, const char* filename, const char* workdir, int sharedMemorySize)
 {
   m_filename = filename;
   m_nproc = nprocess;
   m_workdir = workdir;
 
+  if (m_nproc > 0 && sharedMemorySize > 0 && !m_shared) {
+    // mapped before forking, so all processes share it. Workers can be restarted, so allow for more
+    // processes than workers.
+    m_shared = std::make_unique<SharedHistograms>(size_t(sharedMemorySize) << 20, 2 * m_nproc + 2);
+    if (!m_shared->isValid()) m_shared.reset();
+  }
+
   if (ProcHandler::EvtProcID() == -1 && m_nproc > 0) {
 
     // should be called only from main
@@ -110,11 +119,69 @@ int RbTupleManager::begin(int procid)
 
   //  printf ( "RbTupleManager::Histograms defined in proc %d\n", procid );
 
+  if (m_nproc > 0 && m_shared) attachSharedHistograms(procid);
+
   return 0;
 }
 
+void RbTupleManager::collectHistograms(TDirectory* dir, std::vector<TH1*>& histograms)
+{
+  for (TObject* obj : *dir->GetList()) {
+    if (auto* hist = dynamic_cast<TH1*>(obj)) {
+      histograms.push_back(hist);
+    } else if (auto* subdir = dynamic_cast<TDirectory*>(obj)) {
+      collectHistograms(subdir, histograms);
+    }
+  }
+}
+
+std::string RbTupleManager::getSharedKey(const TH1* hist)
+{
+  // the path without the file name, e.g. "/CDC"
+  std::string path = hist->GetDirectory()->GetPath();
+  path = path.substr(path.find(':') + 1);
+  if (path.empty() || path.back() != '/') path += '/';
+  return path + hist->GetName();
+}
+
+void RbTupleManager::attachSharedHistograms(int procid)
+{
+  const int stripe = m_shared->acquireStripe();
+  if (stripe < 0) {
+    B2WARNING("RbTupleManager: too many processes, histograms of this process are not shared."
+              << LogVar("process", procid));
+    return;
+  }
+  std::vector<TH1*> histograms;
+  collectHistograms(m_root, histograms);
+  for (TH1* hist : histograms) {
+    std::string key = getSharedKey(hist);
+    if (m_shared->attach(hist, key, stripe)) {
+      // the totals are written by the main process, keep it out of the file of this process
+      hist->SetDirectory(nullptr);
+      m_sharedKeys[hist] = key;
+    }
+  }
+  B2DEBUG(20, "RbTupleManager: histograms in shared memory."
+          << LogVar("process", procid)
+          << LogVar("shared", m_shared->getNumberOfAttached())
+          << LogVar("not shared", histograms.size() - m_shared->getNumberOfAttached()));
+}
+
+bool RbTupleManager::addSharedTotal(TH1& target, const TH1* hist) const
+{
+  auto it = m_sharedKeys.find(hist);
+  if (!m_shared || it == m_sharedKeys.end()) return false;
+  return m_shared->addTotal(target, it->second);
+}
+
 int RbTupleManager::terminate()
 {
+  if (m_shared) {
+    m_shared->publishStatistics();
+    m_shared->detachAll();
+    m_sharedKeys.clear();
+  }
   if (m_root != nullptr) {
     m_root->Write();
     m_root->Close();
@@ -126,6 +193,7 @@ int RbTupleManager::terminate()
 
 int RbTupleManager::dump()
 {
+  if (m_shared) m_shared->publishStatistics();
   if (m_root != nullptr) {
     m_root->Write();
   }
@@ -196,5 +264,37 @@ int RbTupleManager::hadd(bool deleteflag)
 
   B2INFO("RbTupleManager: histogram files are added.");
 
+  if (m_shared) return writeSharedHistograms();
+
+  return 0;
+}
+
+int RbTupleManager::writeSharedHistograms()
+{
+  TFile output(m_filename.c_str(), "update");
+  if (output.IsZombie()) {
+    B2ERROR("RbTupleManager: error on opening the output file."
+            << LogVar("file name", m_filename));
+    return -1;
+  }
+
+  // the binning is taken from the empty copies stored when the histograms were attached
+  TDirectory* oldDir = gDirectory;
+  int nShared = 0;
+  for (const std::string& key : m_shared->getKeys()) {
+    std::unique_ptr<TH1> hist = m_shared->createPrototype(key);
+    if (!hist or !m_shared->addTotal(*hist, key)) continue;
+    ++nShared;
+    const std::string path = key.substr(0, key.rfind('/'));
+    TDirectory* dir = path.empty() ? &output : output.mkdir(path.c_str() + 1, "", true);
+    // processes which could not share the histogram wrote it to their file
+    if (auto* merged = dir->Get<TH1>(hist->GetName())) hist->Add(merged);
+    dir->WriteTObject(hist.get(), hist->GetName(), "Overwrite");
+  }
+  output.Close();
+  oldDir->cd();
+
+  B2INFO("RbTupleManager: shared histograms are written."
+         << LogVar("number of histograms", nShared));
   return 0;
 }
@@ -345,6 +345,41 @@ int RingBuffer::remq(int* buf)
   return nw;
 }
 
+int RingBuffer::remqBatch(std::vector<int>& buf, std::vector<int>& sizes, int maxEntries)
+{
+  SemaphoreLocker locker(m_semid);
+  if (m_bufinfo->nbuf < 0) {
+    throw std::runtime_error("[RingBuffer::remqBatch ()] number of entries is negative: " + std::to_string(m_bufinfo->nbuf));
+  }
+  int nentries = 0;
+  while (nentries < maxEntries and m_bufinfo->nbuf > 0) {
+    const int* r_ptr = m_buftop + m_bufinfo->rptr;
+    int nw = *r_ptr;
+    if (nw <= 0) {
+      printf("RingBuffer::remqBatch : buffer size = %d, skipped\n", nw);
+      break;
+    }
+    buf.insert(buf.end(), r_ptr + 2, r_ptr + 2 + nw);
+    sizes.push_back(nw);
+    m_bufinfo->rptr = *(r_ptr + 1);
+    if (m_bufinfo->rptr == 0)
+      m_bufinfo->errtype = 4;
+    m_bufinfo->nbuf--;
+    m_bufinfo->nremq++;
+    m_remq_counter++;
+    nentries++;
+  }
+
+  if (nentries == 0 and m_procIsBusy) {
+    m_bufinfo->nbusy--;
+    m_procIsBusy = false;
+  } else if (nentries > 0 and not m_procIsBusy) {
+    m_bufinfo->nbusy++;
+    m_procIsBusy = true;
+  }
+  return nentries;
+}
+
 int RingBuffer::spyq(int* buf) const
 {
   SemaphoreLocker locker(m_semid);
@@ -370,6 +405,16 @@ int RingBuffer::numq() const
   return m_bufinfo->nbuf;
 }
 
+void RingBuffer::waitForEntries()
+{
+  usleep(20);
+}
+
+void RingBuffer::waitForSpace()
+{
+  usleep(20);
+}
+
 void RingBuffer::txAttached()
 {
   SemaphoreLocker locker(m_semid);
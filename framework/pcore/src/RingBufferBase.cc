@@ -0,0 +1,27 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/pcore/RingBufferBase.h>
+
+using namespace Belle2;
+
+const int* RingBufferBase::acquireq(int& size)
+{
+  if (m_acquireEntry >= m_acquireSizes.size()) {
+    m_acquireBuffer.clear();
+    m_acquireSizes.clear();
+    m_acquireEntry = 0;
+    m_acquireOffset = 0;
+    if (remqBatch(m_acquireBuffer, m_acquireSizes, m_readBatchSize) == 0)
+      return nullptr;
+  }
+  size = m_acquireSizes[m_acquireEntry++];
+  const int* buf = m_acquireBuffer.data() + m_acquireOffset;
+  m_acquireOffset += size;
+  return buf;
+}
@@ -16,7 +16,7 @@
 using namespace std;
 using namespace Belle2;
 
-RxModule::RxModule(RingBuffer* rbuf) : Module(), m_streamer(nullptr), m_nrecv(-1)
+RxModule::RxModule(RingBufferBase* rbuf) : Module(), m_streamer(nullptr), m_nrecv(-1)
 {
   //Set module properties
   setDescription("Decode data from RingBuffer into DataStore");
@@ -43,25 +43,23 @@ void RxModule::initStreamer()
 
 void RxModule::readEvent()
 {
-  auto* evtbuf = new char[EvtMessage::c_MaxEventSize];
-  while (!m_rbuf->isDead()) {
-    int size = m_rbuf->remq((int*)evtbuf);
-    if (size != 0) {
-      B2DEBUG(35, "Rx: got an event from RingBuffer, size=" << size);
-
-      // Restore objects in DataStore
-      EvtMessage evtmsg(evtbuf);
-      m_streamer->restoreDataStore(&evtmsg);
-      // Restore the event dependent random number object from Datastore
-      if (m_randomgenerator.isValid()) {
-        RandomNumbers::getEventRandomGenerator() = *m_randomgenerator;
-      }
-      break;
-    }
-    usleep(20);
+  int size = 0;
+  const int* buf = nullptr;
+  while (!(buf = m_rbuf->acquireq(size))) {
+    if (m_rbuf->isDead())
+      return;
+    m_rbuf->waitForEntries();
+  }
+  B2DEBUG(35, "Rx: got an event from RingBuffer, size=" << size);
+
+  // Restore objects in DataStore, directly from the memory of the ring buffer
+  EvtMessage evtmsg(const_cast<char*>(reinterpret_cast<const char*>(buf)));
+  m_streamer->restoreDataStore(&evtmsg);
+  m_rbuf->releaseq();
+  // Restore the event dependent random number object from Datastore
+  if (m_randomgenerator.isValid()) {
+    RandomNumbers::getEventRandomGenerator() = *m_randomgenerator;
   }
-
-  delete[] evtbuf;
 }
 
 void RxModule::initialize()
@@ -95,5 +93,6 @@ void RxModule::endRun() { }
 void RxModule::terminate()
 {
   B2DEBUG(32, "Rx: terminate called");
+  m_streamer->printEntryStatistics(DataStoreStreamer::c_statisticsDebugLevel);
   delete m_streamer;
 }
@@ -23,8 +23,8 @@ using namespace std;
 namespace io = boost::iostreams;
 
 SeqFile::SeqFile(const std::string& filename, const std::string& rwflag, char* streamerinfo, int streamerinfo_size,
-                 bool filenameIsPattern):
-  m_filename(filename)
+                 bool filenameIsPattern, const SeqFileBlockSettings& blockSettings):
+  m_filename(filename), m_blockSettings(blockSettings)
 {
   if (m_filename.empty()) {
     B2ERROR("SeqFile: Empty filename given");
@@ -40,6 +40,10 @@ SeqFile::SeqFile(const std::string& filename, const std::string& rwflag, char* s
   // strip .gz suffix to add it at the end automatically and correctly for subsequent files
   if (m_compressed) {
     m_filename = m_filename.substr(0, m_filename.size() - 3);
+    if (!readonly && m_blockSettings.compression > 0) {
+      B2WARNING("SeqFile: gzip-compressed files cannot be written in the block format, ignoring the block compression");
+      m_blockSettings.compression = 0;
+    }
   }
   // check if we want different naming scheme using boost::format
   if (filenameIsPattern) {
@@ -84,13 +88,20 @@ void SeqFile::openFile(std::string filename, bool readonly)
   // add compression suffix if file is supposed to be compressed
   if (m_compressed) filename += ".gz";
   if (!readonly) {
+    // finish the previous file before starting the next one
+    m_blockWriter.reset();
     //open file in create mode and set stream correctly
     m_fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0664);
-    auto filter = new io::filtering_ostream();
-    if (m_compressed) filter->push(io::gzip_compressor());
-    filter->push(io::file_descriptor_sink(m_fd, io::close_handle));
-    filter->exceptions(ios_base::badbit | ios_base::failbit);
-    m_stream.reset(filter);
+    if (m_blockSettings.compression > 0) {
+      m_stream.reset();
+      if (m_fd >= 0) m_blockWriter = std::make_unique<SeqBlockWriter>(m_fd, m_blockSettings);
+    } else {
+      auto filter = new io::filtering_ostream();
+      if (m_compressed) filter->push(io::gzip_compressor());
+      filter->push(io::file_descriptor_sink(m_fd, io::close_handle));
+      filter->exceptions(ios_base::badbit | ios_base::failbit);
+      m_stream.reset(filter);
+    }
 
     //
     // Write StreamerInfo  (2017.5.8)
@@ -98,6 +109,12 @@ void SeqFile::openFile(std::string filename, bool readonly)
     if (m_streamerinfo == nullptr || m_streamerinfo_size <= 0) {
       // If you want to use SeqFile for non-sroot file type, please skip this B2FATAL
       B2FATAL("Invalid size of StreamerInfo : " << m_streamerinfo_size << "bytes");
+    } else if (m_blockWriter) {
+      if (m_blockWriter->write(m_streamerinfo, m_streamerinfo_size)) {
+        B2INFO("Wrote StreamerInfo at the begenning of the file. : " << m_streamerinfo_size << "bytes");
+      } else {
+        B2ERROR("SeqFile::openFile() error: " << strerror(errno));
+      }
     } else {
       auto* out = dynamic_cast<std::ostream*>(m_stream.get());
       if (!out) {
@@ -114,12 +131,23 @@ void SeqFile::openFile(std::string filename, bool readonly)
 
   } else {
     //open file in read mode and set stream correctly
+    m_blockReader.reset();
     m_fd = open(filename.c_str(), O_RDONLY);
-    auto filter = new io::filtering_istream();
-    if (m_compressed) filter->push(io::gzip_decompressor());
-    filter->push(io::file_descriptor_source(m_fd, io::close_handle));
-    filter->exceptions(ios_base::badbit | ios_base::failbit);
-    m_stream.reset(filter);
+    if (m_fd >= 0 && !m_compressed && SeqBlockReader::hasBlockFormat(m_fd)) {
+      m_stream.reset();
+      m_blockReader = std::make_unique<SeqBlockReader>(m_fd, m_blockSettings.nThreads);
+      if (!m_blockReader->isValid()) {
+        // the reader closes the file
+        m_blockReader.reset();
+        m_fd = -1;
+      }
+    } else {
+      auto filter = new io::filtering_istream();
+      if (m_compressed) filter->push(io::gzip_decompressor());
+      filter->push(io::file_descriptor_source(m_fd, io::close_handle));
+      filter->exceptions(ios_base::badbit | ios_base::failbit);
+      m_stream.reset(filter);
+    }
   }
   // reset number of written bytes (does not include streamerinfo )
   m_nb = 0;
@@ -127,7 +155,7 @@ void SeqFile::openFile(std::string filename, bool readonly)
 
 SeqFile::~SeqFile()
 {
-  if (m_streamerinfo != nullptr) delete m_streamerinfo;
+  if (m_streamerinfo != nullptr) delete[] m_streamerinfo;
   B2INFO("Closing SeqFile " << m_nfile);
   //closed automatically by m_stream.
 }
@@ -141,12 +169,13 @@ int SeqFile::write(const char* buf)
 {
   // cast stream object
   auto* out = dynamic_cast<std::ostream*>(m_stream.get());
-  if (!out) {
+  if (!out && !m_blockWriter) {
     B2FATAL("SeqFile::write() called on a file opened in read mode");
   }
   int insize = *((int*)buf); // nbytes in the buffer at the beginning
-  if (insize + m_nb >= c_MaxFileSize && m_filename != "/dev/null") {
-    B2INFO("SeqFile: previous file closed (size=" << m_nb << " bytes)");
+  const uint64_t filesize = m_blockWriter ? m_blockWriter->getFileSize() : m_nb;
+  if (insize + filesize >= c_MaxFileSize && m_filename != "/dev/null") {
+    B2INFO("SeqFile: previous file closed (size=" << filesize << " bytes)");
     m_nfile++;
     auto file = m_filename + '-' + std::to_string(m_nfile);
     if (!m_filenamePattern.empty()) {
@@ -161,6 +190,13 @@ int SeqFile::write(const char* buf)
     // update stream pointer since we reopened the file
     out = dynamic_cast<std::ostream*>(m_stream.get());
   }
+  if (m_blockWriter) {
+    if (!m_blockWriter->write(buf, insize)) {
+      B2ERROR("SeqFile::write() error: " << strerror(errno));
+      return 0;
+    }
+    return insize;
+  }
   try {
     out->write(buf, insize);
     m_nb += insize;
@@ -172,6 +208,27 @@ int SeqFile::write(const char* buf)
 }
 
 int SeqFile::read(char* buf, int size)
+{
+  int recsize = m_blockReader ? m_blockReader->read(buf, size) : readStream(buf, size);
+  if (recsize != 0) return recsize;
+  // EOF of current file, search for next file
+  m_nfile++;
+  auto nextfile = m_filename + '-' + std::to_string(m_nfile);
+  if (!m_filenamePattern.empty()) {
+    nextfile = (boost::format(m_filenamePattern) % m_nfile).str();
+  }
+  openFile(nextfile, true);
+  if (m_fd < 0) return 0;   // End of all files
+  B2INFO("SeqFile::read() opened '" << nextfile << "'");
+  return m_blockReader ? m_blockReader->read(buf, size) : readStream(buf, size);
+}
+
+bool SeqFile::seek(uint64_t record)
+{
+  return m_blockReader && m_blockReader->seek(record);
+}
+
+int SeqFile::readStream(char* buf, int size)
 {
   // cast stream object
   auto* in = dynamic_cast<std::istream*>(m_stream.get());
@@ -185,20 +242,7 @@ int SeqFile::read(char* buf, int size)
     B2ERROR("SeqFile::read() cannot read file: " << e.what());
     return -1;
   }
-  //ok, now we can open the next file reliably
-  if (in->eof()) {
-    // EOF of current file, search for next file
-    m_nfile++;
-    auto nextfile = m_filename + '-' + std::to_string(m_nfile);
-    if (!m_filenamePattern.empty()) {
-      nextfile = (boost::format(m_filenamePattern) % m_nfile).str();
-    }
-    openFile(nextfile, true);
-    if (m_fd < 0) return 0;   // End of all files
-    // update the stream pointer
-    in = dynamic_cast<std::istream*>(m_stream.get());
-    B2INFO("SeqFile::read() opened '" << nextfile << "'");
-  }
+  if (in->eof()) return 0;
   try {
     // Obtain new header
     in->read(buf, sizeof(int));
@@ -0,0 +1,409 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/pcore/SeqFileBlocks.h>
+#include <framework/logging/Logger.h>
+
+#include <RZip.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+using namespace Belle2;
+
+namespace {
+  /// Magic string at the beginning of the file. Read as the size of a first record it is larger than EvtMessage::c_MaxEventSize
+  const char c_fileMagic[8] = {'B', '2', 'S', 'R', 'B', 'L', 'K', '1'};
+  /// Magic string at the end of the footer
+  const char c_footerMagic[8] = {'B', '2', 'S', 'R', 'I', 'D', 'X', '1'};
+  /// Magic number at the beginning of each block header
+  const uint32_t c_blockMagic = 0x4b4c4253;
+  /// Version of the block format
+  const uint32_t c_version = 1;
+  /// ROOT compresses at most this many bytes at once
+  const int c_maxCompressionBlock = 0xffffff;
+
+  /// Header at the beginning of the file
+  struct FileHeader {
+    /// Magic string identifying the format
+    char magic[8];
+    /// Version of the format
+    uint32_t version;
+    /// ROOT compression setting used for the blocks
+    uint32_t compression;
+  };
+
+  /// Header in front of each block
+  struct BlockHeader {
+    /// Magic number to detect corrupt files
+    uint32_t magic;
+    /// Number of records in the block
+    uint32_t nRecords;
+    /// Size of the block data in the file
+    uint32_t storedSize;
+    /// Size of the block data after uncompressing
+    uint32_t rawSize;
+    /// 1 if the block data is compressed
+    uint32_t compressed;
+    /// Unused, keeps the header size a multiple of 8 bytes
+    uint32_t reserved;
+    /// Number of the first record in the block
+    uint64_t firstRecord;
+  };
+
+  /// Footer at the end of the file, following the block index
+  struct Footer {
+    /// Position of the block index in the file
+    uint64_t indexOffset;
+    /// Number of blocks in the index
+    uint64_t nBlocks;
+    /// Number of records in the file
+    uint64_t nRecords;
+    /// Magic string identifying the footer
+    char magic[8];
+  };
+
+  /// Read exactly size bytes at the given position, returns false on errors or if the file is too short
+  bool readAt(int fd, void* data, size_t size, uint64_t offset)
+  {
+    auto* out = static_cast<char*>(data);
+    while (size > 0) {
+      ssize_t n = pread(fd, out, size, offset);
+      if (n < 0 and errno == EINTR) continue;
+      if (n <= 0) return false;
+      out += n;
+      size -= n;
+      offset += n;
+    }
+    return true;
+  }
+
+  /// Compress the records of a block, leaves the compressed data empty if it does not get smaller
+  void compressBlock(SeqFileBlockInfo& info, const std::vector<char>& raw, std::vector<char>& compressed, int compression)
+  {
+    const int algorithm = compression / 100;
+    const int level = compression % 100;
+    compressed.resize(raw.size());
+    size_t in = 0;
+    size_t out = 0;
+    while (in < raw.size()) {
+      int nin = std::min<size_t>(raw.size() - in, c_maxCompressionBlock);
+      int nout = std::min<size_t>(compressed.size() - out, c_maxCompressionBlock);
+      int irep = 0;
+      R__zipMultipleAlgorithm(level, &nin, const_cast<char*>(raw.data() + in), &nout, compressed.data() + out, &irep,
+                              (ROOT::RCompressionSetting::EAlgorithm::EValues) algorithm);
+      if (irep <= 0) break;
+      in += nin;
+      out += irep;
+    }
+    info.rawSize = raw.size();
+    if (in == raw.size() and out < raw.size()) {
+      compressed.resize(out);
+      info.storedSize = out;
+      info.compressed = 1;
+    } else {
+      compressed.clear();
+      info.storedSize = raw.size();
+      info.compressed = 0;
+    }
+  }
+
+  /// Uncompress stored block data, returns false if it does not have the expected size
+  bool uncompressBlock(const std::vector<char>& stored, std::vector<char>& raw)
+  {
+    auto* in = (unsigned char*) stored.data();
+    auto* end = in + stored.size();
+    size_t out = 0;
+    while (in < end and out < raw.size()) {
+      int nin{0}, nout{0}, irep{0};
+      if (R__unzip_header(&nin, in, &nout) != 0 or nin > end - in or out + nout > raw.size()) return false;
+      R__unzip(&nin, in, &nout, (unsigned char*)(raw.data() + out), &irep);
+      if (irep <= 0) return false;
+      in += nin;
+      out += irep;
+    }
+    return in == end and out == raw.size();
+  }
+}
+
+SeqBlockWriter::SeqBlockWriter(int fd, const SeqFileBlockSettings& settings): m_fd(fd), m_settings(settings)
+{
+  FileHeader header;
+  memcpy(header.magic, c_fileMagic, sizeof(header.magic));
+  header.version = c_version;
+  header.compression = m_settings.compression;
+  writeBytes(&header, sizeof(header));
+}
+
+SeqBlockWriter::~SeqBlockWriter()
+{
+  flushBlock();
+  while (!m_pending.empty()) writeOldestBlock();
+
+  Footer footer;
+  footer.indexOffset = m_fileSize;
+  footer.nBlocks = m_index.size();
+  footer.nRecords = m_nRecords;
+  memcpy(footer.magic, c_footerMagic, sizeof(footer.magic));
+  writeBytes(m_index.data(), m_index.size() * sizeof(SeqFileBlockInfo));
+  writeBytes(&footer, sizeof(footer));
+  if (m_failed) {
+    B2ERROR("SeqBlockWriter: file incomplete, could only write " << m_fileSize << " bytes: " << strerror(errno));
+  }
+  close(m_fd);
+}
+
+bool SeqBlockWriter::write(const char* buf, int size)
+{
+  if (!m_current) {
+    m_current = std::make_unique<Block>();
+    m_current->info.firstRecord = m_nRecords;
+    m_current->info.nRecords = 0;
+    m_current->raw.reserve(m_settings.blockSize);
+  }
+  m_current->raw.insert(m_current->raw.end(), buf, buf + size);
+  m_current->info.nRecords++;
+  m_nRecords++;
+  if (m_current->raw.size() >= m_settings.blockSize) flushBlock();
+  return !m_failed;
+}
+
+uint64_t SeqBlockWriter::getFileSize() const
+{
+  uint64_t size = m_fileSize + m_pendingSize + (m_pending.size() + 1) * sizeof(BlockHeader);
+  if (m_current) size += m_current->raw.size();
+  return size + (m_index.size() + m_pending.size() + 1) * sizeof(SeqFileBlockInfo) + sizeof(Footer);
+}
+
+void SeqBlockWriter::flushBlock()
+{
+  if (!m_current) return;
+  m_pendingSize += m_current->raw.size();
+  auto compress = [compression = m_settings.compression](std::unique_ptr<Block> block) {
+    compressBlock(block->info, block->raw, block->compressed, compression);
+    return block;
+  };
+  if (m_settings.nThreads > 0) {
+    // keep at most one block per thread in flight
+    while (m_pending.size() >= (size_t)m_settings.nThreads) writeOldestBlock();
+    m_pending.push_back(std::async(std::launch::async, compress, std::move(m_current)));
+  } else {
+    m_pending.push_back(std::async(std::launch::deferred, compress, std::move(m_current)));
+    writeOldestBlock();
+  }
+}
+
+bool SeqBlockWriter::writeOldestBlock()
+{
+  std::unique_ptr<Block> block = m_pending.front().get();
+  m_pending.pop_front();
+  m_pendingSize -= block->raw.size();
+
+  SeqFileBlockInfo& info = block->info;
+  info.offset = m_fileSize;
+  const BlockHeader header{c_blockMagic, info.nRecords, info.storedSize, info.rawSize, info.compressed, 0, info.firstRecord};
+  const std::vector<char>& data = info.compressed ? block->compressed : block->raw;
+  if (!writeBytes(&header, sizeof(header)) or !writeBytes(data.data(), data.size())) return false;
+  m_index.push_back(info);
+  return true;
+}
+
+bool SeqBlockWriter::writeBytes(const void* data, size_t size)
+{
+  auto* in = static_cast<const char*>(data);
+  while (size > 0 and !m_failed) {
+    ssize_t n = ::write(m_fd, in, size);
+    if (n < 0 and errno == EINTR) continue;
+    if (n <= 0) {
+      m_failed = true;
+      break;
+    }
+    in += n;
+    size -= n;
+    m_fileSize += n;
+  }
+  return !m_failed;
+}
+
+SeqBlockReader::SeqBlockReader(int fd, int nThreads): m_fd(fd), m_nThreads(nThreads)
+{
+  struct stat status;
+  FileHeader header;
+  if (fstat(m_fd, &status) != 0 or !readAt(m_fd, &header, sizeof(header), 0) or
+      memcmp(header.magic, c_fileMagic, sizeof(header.magic)) != 0) {
+    B2ERROR("SeqBlockReader: cannot read file header");
+    return;
+  }
+  if (header.version != c_version) {
+    B2ERROR("SeqBlockReader: unsupported version of the block format" << LogVar("version", header.version));
+    return;
+  }
+  if (!readIndex(status.st_size)) {
+    B2WARNING("SeqBlockReader: no block index found, the file was probably not closed properly. "
+              "Reading all complete blocks.");
+    scanBlocks(status.st_size);
+  }
+  m_nRecords = 0;
+  for (const SeqFileBlockInfo& info : m_index) m_nRecords += info.nRecords;
+  m_valid = true;
+}
+
+SeqBlockReader::~SeqBlockReader()
+{
+  clearPending();
+  close(m_fd);
+}
+
+bool SeqBlockReader::hasBlockFormat(int fd)
+{
+  char magic[sizeof(c_fileMagic)];
+  return readAt(fd, magic, sizeof(magic), 0) and memcmp(magic, c_fileMagic, sizeof(magic)) == 0;
+}
+
+bool SeqBlockReader::readIndex(uint64_t fileSize)
+{
+  Footer footer;
+  if (fileSize < sizeof(FileHeader) + sizeof(Footer) or
+      !readAt(m_fd, &footer, sizeof(footer), fileSize - sizeof(footer)) or
+      memcmp(footer.magic, c_footerMagic, sizeof(footer.magic)) != 0 or
+      footer.indexOffset + footer.nBlocks * sizeof(SeqFileBlockInfo) + sizeof(footer) != fileSize) {
+    return false;
+  }
+  m_index.resize(footer.nBlocks);
+  if (!readAt(m_fd, m_index.data(), m_index.size() * sizeof(SeqFileBlockInfo), footer.indexOffset)) {
+    m_index.clear();
+    return false;
+  }
+  return true;
+}
+
+void SeqBlockReader::scanBlocks(uint64_t fileSize)
+{
+  m_index.clear();
+  uint64_t offset = sizeof(FileHeader);
+  BlockHeader header;
+  while (readAt(m_fd, &header, sizeof(header), offset) and header.magic == c_blockMagic and
+         offset + sizeof(header) + header.storedSize <= fileSize) {
+    m_index.push_back({offset, header.firstRecord, header.nRecords, header.storedSize, header.rawSize, header.compressed});
+    offset += sizeof(header) + header.storedSize;
+  }
+}
+
+void SeqBlockReader::readAhead()
+{
+  auto readBlock = [fd = m_fd](SeqFileBlockInfo info) {
+    auto block = std::make_unique<Block>();
+    block->info = info;
+    std::vector<char> stored(info.storedSize);
+    BlockHeader header;
+    if (!readAt(fd, &header, sizeof(header), info.offset) or header.magic != c_blockMagic or
+        header.storedSize != info.storedSize or !readAt(fd, stored.data(), stored.size(), info.offset + sizeof(header))) {
+      return block;
+    }
+    if (info.compressed) {
+      block->raw.resize(info.rawSize);
+      if (!uncompressBlock(stored, block->raw)) block->raw.clear();
+    } else {
+      block->raw = std::move(stored);
+    }
+    return block;
+  };
+  const size_t depth = std::max(m_nThreads, 1);
+  const auto policy = m_nThreads > 0 ? std::launch::async : std::launch::deferred;
+  while (m_pending.size() < depth and m_nextBlock < m_index.size()) {
+    m_pending.push_back(std::async(policy, readBlock, m_index[m_nextBlock++]));
+  }
+}
+
+void SeqBlockReader::clearPending()
+{
+  for (auto& block : m_pending) {
+    if (block.valid()) block.wait();
+  }
+  m_pending.clear();
+}
+
+bool SeqBlockReader::loadBlock()
+{
+  m_current = m_pending.front().get();
+  m_pending.pop_front();
+  // immediately start reading the following block
+  readAhead();
+  if (m_current->raw.size() != m_current->info.rawSize or m_current->raw.empty()) {
+    B2ERROR("SeqBlockReader: cannot read block" << LogVar("offset", m_current->info.offset));
+    return false;
+  }
+  m_position = 0;
+  m_recordsLeft = m_current->info.nRecords;
+  return true;
+}
+
+int SeqBlockReader::nextRecordSize() const
+{
+  const std::vector<char>& raw = m_current->raw;
+  int recsize = 0;
+  if (m_position + sizeof(int) <= raw.size()) memcpy(&recsize, raw.data() + m_position, sizeof(int));
+  if (recsize < (int)sizeof(int) or m_position + recsize > raw.size()) {
+    B2ERROR("SeqBlockReader: corrupt record in block" << LogVar("offset", m_current->info.offset));
+    return -1;
+  }
+  return recsize;
+}
+
+int SeqBlockReader::read(char* buf, int max)
+{
+  if (!m_valid) return -1;
+  while (m_recordsLeft == 0) {
+    readAhead();
+    if (m_pending.empty()) return 0;
+    if (!loadBlock()) return -1;
+  }
+  const int recsize = nextRecordSize();
+  if (recsize < 0) return -1;
+  if (recsize > max) {
+    B2ERROR("SeqBlockReader: buffer too small, need at least " << recsize << " bytes");
+    return -1;
+  }
+  memcpy(buf, m_current->raw.data() + m_position, recsize);
+  m_position += recsize;
+  m_recordsLeft--;
+  return recsize;
+}
+
+bool SeqBlockReader::seek(uint64_t record)
+{
+  if (!m_valid or record > m_nRecords) return false;
+  clearPending();
+  m_current.reset();
+  m_recordsLeft = 0;
+  if (record == m_nRecords) {
+    m_nextBlock = m_index.size();
+    return true;
+  }
+  // the block containing the record is the last one starting at or before it
+  auto block = std::upper_bound(m_index.begin(), m_index.end(), record,
+  [](uint64_t value, const SeqFileBlockInfo & info) { return value < info.firstRecord; });
+  m_nextBlock = block - m_index.begin() - 1;
+  uint64_t skip = record - m_index[m_nextBlock].firstRecord;
+  readAhead();
+  if (skip == 0) return true;
+
+  // skip the records before the requested one without copying them
+  if (!loadBlock()) return false;
+  for (; skip > 0; --skip) {
+    const int recsize = nextRecordSize();
+    if (recsize < 0) return false;
+    m_position += recsize;
+    m_recordsLeft--;
+  }
+  return true;
+}
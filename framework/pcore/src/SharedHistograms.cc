@@ -0,0 +1,452 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/pcore/SharedHistograms.h>
+
+#include <framework/logging/Logger.h>
+
+#include <TH1.h>
+#include <TAxis.h>
+#include <TBufferFile.h>
+#include <TArrayC.h>
+#include <TArrayD.h>
+#include <TArrayF.h>
+#include <TArrayI.h>
+#include <TArrayS.h>
+
+#include <sys/mman.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <new>
+
+using namespace Belle2;
+
+namespace {
+  /** Alignment of the data of each histogram in the shared memory. */
+  const size_t c_alignment = 64;
+
+  /** Round up to a multiple of the alignment. */
+  size_t align(size_t size)
+  {
+    return (size + c_alignment - 1) / c_alignment * c_alignment;
+  }
+
+  /** Size of one bin content of the given type. */
+  size_t getElementSize(char type)
+  {
+    switch (type) {
+      case 'D': return sizeof(Double_t);
+      case 'F': return sizeof(Float_t);
+      case 'I': return sizeof(Int_t);
+      case 'S': return sizeof(Short_t);
+      default: return sizeof(Char_t);
+    }
+  }
+
+  /** Find the array holding the bin contents of the histogram and return its type, 0 if it is not supported. */
+  char getArray(TH1* hist, TArray*& array)
+  {
+    // profiles keep more per-bin information than the bin contents
+    if (hist->InheritsFrom("TProfile") or hist->InheritsFrom("TProfile2D") or hist->InheritsFrom("TProfile3D")) return 0;
+    if (auto* a = dynamic_cast<TArrayD*>(hist)) { array = a; return 'D'; }
+    if (auto* a = dynamic_cast<TArrayF*>(hist)) { array = a; return 'F'; }
+    if (auto* a = dynamic_cast<TArrayI*>(hist)) { array = a; return 'I'; }
+    if (auto* a = dynamic_cast<TArrayS*>(hist)) { array = a; return 'S'; }
+    if (auto* a = dynamic_cast<TArrayC*>(hist)) { array = a; return 'C'; }
+    return 0;
+  }
+
+  /** Get the memory of the bin contents of an array. */
+  void* getData(TArray* array, char type)
+  {
+    switch (type) {
+      case 'D': return static_cast<TArrayD*>(array)->fArray;
+      case 'F': return static_cast<TArrayF*>(array)->fArray;
+      case 'I': return static_cast<TArrayI*>(array)->fArray;
+      case 'S': return static_cast<TArrayS*>(array)->fArray;
+      default: return static_cast<TArrayC*>(array)->fArray;
+    }
+  }
+
+  /** Free memory of bin contents allocated by an array. */
+  void deleteData(char type, void* data)
+  {
+    switch (type) {
+      case 'D': delete [] static_cast<Double_t*>(data); break;
+      case 'F': delete [] static_cast<Float_t*>(data); break;
+      case 'I': delete [] static_cast<Int_t*>(data); break;
+      case 'S': delete [] static_cast<Short_t*>(data); break;
+      default: delete [] static_cast<Char_t*>(data); break;
+    }
+  }
+
+  /** True if the histogram can reallocate its bins by itself while it is filled. */
+  bool canChangeBinning(const TH1* hist)
+  {
+    // filling a buffered histogram determines the binning when the buffer is full
+    if (hist->GetBuffer()) return true;
+    for (const TAxis* axis : {hist->GetXaxis(), hist->GetYaxis(), hist->GetZaxis()}) {
+      // bins are added for new labels or values outside of an extendable axis
+      if (axis->CanExtend() or axis->GetLabels()) return true;
+    }
+    return false;
+  }
+
+  /** Set the memory of the bin contents of an array. */
+  void setData(TArray* array, char type, void* data)
+  {
+    switch (type) {
+      case 'D': static_cast<TArrayD*>(array)->fArray = static_cast<Double_t*>(data); break;
+      case 'F': static_cast<TArrayF*>(array)->fArray = static_cast<Float_t*>(data); break;
+      case 'I': static_cast<TArrayI*>(array)->fArray = static_cast<Int_t*>(data); break;
+      case 'S': static_cast<TArrayS*>(array)->fArray = static_cast<Short_t*>(data); break;
+      default: static_cast<TArrayC*>(array)->fArray = static_cast<Char_t*>(data); break;
+    }
+  }
+
+  /** Add n values of type T. */
+  template<class T>
+  void addValues(void* to, const void* from, int n)
+  {
+    T* t = static_cast<T*>(to);
+    const T* f = static_cast<const T*>(from);
+    for (int i = 0; i < n; ++i) t[i] += f[i];
+  }
+
+  /** Add n values of the given type. */
+  void addValues(char type, void* to, const void* from, int n)
+  {
+    switch (type) {
+      case 'D': addValues<Double_t>(to, from, n); break;
+      case 'F': addValues<Float_t>(to, from, n); break;
+      case 'I': addValues<Int_t>(to, from, n); break;
+      case 'S': addValues<Short_t>(to, from, n); break;
+      default: addValues<Char_t>(to, from, n); break;
+    }
+  }
+
+  /** Add n values of type T to doubles. */
+  template<class T>
+  void addToDouble(double* to, const void* from, int n)
+  {
+    const T* f = static_cast<const T*>(from);
+    for (int i = 0; i < n; ++i) to[i] += f[i];
+  }
+
+  /** Add n values of the given type to doubles. */
+  void addToDouble(char type, double* to, const void* from, int n)
+  {
+    switch (type) {
+      case 'D': addToDouble<Double_t>(to, from, n); break;
+      case 'F': addToDouble<Float_t>(to, from, n); break;
+      case 'I': addToDouble<Int_t>(to, from, n); break;
+      case 'S': addToDouble<Short_t>(to, from, n); break;
+      default: addToDouble<Char_t>(to, from, n); break;
+    }
+  }
+}
+
+SharedHistograms::SharedHistograms(size_t sizeBytes, unsigned int nStripes, unsigned int nSlots)
+{
+  const size_t infoSize = align(sizeof(SharedHistogramsInfo));
+  const size_t stripesSize = align(nStripes * sizeof(SharedHistogramStripe));
+  const size_t slotsSize = align(nSlots * sizeof(SharedHistogramSlot));
+  m_mappedSize = infoSize + stripesSize + slotsSize + align(sizeBytes);
+  // anonymous shared memory is inherited by the forked processes, pages are only allocated when used
+  void* memory = mmap(nullptr, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (memory == MAP_FAILED) {
+    B2ERROR("SharedHistograms: cannot map shared memory, histograms are not shared."
+            << LogVar("size", m_mappedSize) << LogVar("error", strerror(errno)));
+    return;
+  }
+  m_memory = memory;
+  m_info = new (m_memory) SharedHistogramsInfo;
+  m_info->dataSize = align(sizeBytes);
+  m_info->nSlots = nSlots;
+  m_info->nStripes = nStripes;
+  m_info->nextStripe = 0;
+  m_info->used = 0;
+  m_stripes = reinterpret_cast<SharedHistogramStripe*>(static_cast<char*>(m_memory) + infoSize);
+  for (unsigned int i = 0; i < nStripes; ++i) {
+    new (&m_stripes[i]) SharedHistogramStripe;
+    m_stripes[i].state = 0;
+    m_stripes[i].pid = 0;
+  }
+  m_slots = reinterpret_cast<SharedHistogramSlot*>(static_cast<char*>(m_memory) + infoSize + stripesSize);
+  for (unsigned int i = 0; i < nSlots; ++i) {
+    new (&m_slots[i]) SharedHistogramSlot;
+    m_slots[i].state = 0;
+  }
+  m_data = static_cast<char*>(m_memory) + infoSize + stripesSize + slotsSize;
+}
+
+SharedHistograms::~SharedHistograms()
+{
+  detachAll();
+  if (m_memory) munmap(m_memory, m_mappedSize);
+}
+
+int SharedHistograms::acquireStripe()
+{
+  if (!m_info) return -1;
+  const unsigned int stripe = m_info->nextStripe++;
+  if (stripe >= m_info->nStripes) return -1;
+  m_stripes[stripe].pid = getpid();
+  m_stripes[stripe].state = 1;
+  m_ownStripes.push_back(stripe);
+  return stripe;
+}
+
+bool SharedHistograms::isStripeCounted(unsigned int stripe) const
+{
+  const int state = m_stripes[stripe].state.load();
+  if (state == 2) return true;
+  if (state != 1) return false;
+  // a process which ended without detaching crashed, its events are processed again by another process
+  return kill(m_stripes[stripe].pid, 0) == 0 or errno != ESRCH;
+}
+
+size_t SharedHistograms::getSize(char type, bool hasSumw2, int nCells) const
+{
+  const size_t nStripes = m_info->nStripes;
+  size_t size = align(nStripes * c_NStats * sizeof(double));
+  size += align(nStripes * nCells * getElementSize(type));
+  if (hasSumw2) size += align(nStripes * nCells * sizeof(double));
+  return size;
+}
+
+double* SharedHistograms::getStatistics(const SharedHistogramSlot& slot, int stripe) const
+{
+  return reinterpret_cast<double*>(m_data + slot.offset) + stripe * c_NStats;
+}
+
+char* SharedHistograms::getContent(const SharedHistogramSlot& slot, int stripe) const
+{
+  const size_t start = slot.offset + align(m_info->nStripes * c_NStats * sizeof(double));
+  return m_data + start + stripe * slot.nCells * getElementSize(slot.type);
+}
+
+double* SharedHistograms::getSumw2(const SharedHistogramSlot& slot, int stripe) const
+{
+  const size_t start = slot.offset + align(m_info->nStripes * c_NStats * sizeof(double)) +
+                       align(m_info->nStripes * slot.nCells * getElementSize(slot.type));
+  return reinterpret_cast<double*>(m_data + start) + stripe * slot.nCells;
+}
+
+const SharedHistogramSlot* SharedHistograms::findSlot(const std::string& key) const
+{
+  if (!m_info) return nullptr;
+  const size_t start = std::hash<std::string>()(key) % m_info->nSlots;
+  for (unsigned int i = 0; i < m_info->nSlots; ++i) {
+    const SharedHistogramSlot& slot = m_slots[(start + i) % m_info->nSlots];
+    int state = slot.state.load();
+    while (state == 1) {
+      sched_yield();
+      state = slot.state.load();
+    }
+    if (state == 0) return nullptr;
+    if (key == slot.key) return &slot;
+  }
+  return nullptr;
+}
+
+SharedHistogramSlot* SharedHistograms::registerSlot(const std::string& key, char type, bool hasSumw2, int nCells,
+                                                    const TH1& prototype)
+{
+  if (key.size() >= SharedHistogramSlot::c_MaxKeyLength) {
+    B2WARNING("SharedHistograms: histogram name too long, it is not shared." << LogVar("histogram", key));
+    return nullptr;
+  }
+  // open addressing: all processes probe the slots in the same order, the first one registers the histogram
+  const size_t start = std::hash<std::string>()(key) % m_info->nSlots;
+  for (unsigned int i = 0; i < m_info->nSlots; ++i) {
+    SharedHistogramSlot& slot = m_slots[(start + i) % m_info->nSlots];
+    int state = 0;
+    if (slot.state.compare_exchange_strong(state, 1)) {
+      strcpy(slot.key, key.c_str());
+      slot.type = type;
+      slot.hasSumw2 = hasSumw2;
+      slot.nCells = nCells;
+      // keep an empty copy so the totals can be created without the module defining the histogram
+      std::unique_ptr<TH1> empty(static_cast<TH1*>(prototype.Clone()));
+      empty->SetDirectory(nullptr);
+      empty->Reset();
+      TBufferFile streamed(TBuffer::kWrite);
+      streamed.WriteObject(empty.get());
+      const size_t binsSize = getSize(type, hasSumw2, nCells);
+      const size_t size = binsSize + align(streamed.Length());
+      uint64_t used = m_info->used.load();
+      do {
+        if (used + size > m_info->dataSize) {
+          B2WARNING("SharedHistograms: shared memory is full, histogram is not shared." << LogVar("histogram", key));
+          slot.state = 3;
+          return nullptr;
+        }
+      } while (!m_info->used.compare_exchange_weak(used, used + size));
+      slot.offset = used;
+      slot.prototypeOffset = used + binsSize;
+      slot.prototypeSize = streamed.Length();
+      memcpy(m_data + slot.prototypeOffset, streamed.Buffer(), slot.prototypeSize);
+      slot.state = 2;
+      return &slot;
+    }
+    while (state == 1) {
+      sched_yield();
+      state = slot.state.load();
+    }
+    if (key != slot.key) continue;
+    if (state != 2) return nullptr;
+    if (slot.type != type or slot.hasSumw2 != hasSumw2 or slot.nCells != nCells) {
+      B2ERROR("SharedHistograms: histogram is defined differently in different processes, it is not shared."
+              << LogVar("histogram", key));
+      return nullptr;
+    }
+    return &slot;
+  }
+  B2WARNING("SharedHistograms: too many histograms, histogram is not shared." << LogVar("histogram", key));
+  return nullptr;
+}
+
+bool SharedHistograms::attach(TH1* hist, const std::string& key, int stripe)
+{
+  if (!m_info or stripe < 0 or stripe >= int(m_info->nStripes)) return false;
+  TArray* array = nullptr;
+  const char type = getArray(hist, array);
+  if (!type) return false;
+  if (canChangeBinning(hist)) {
+    B2DEBUG(20, "SharedHistograms: histogram can change its binning, it is not shared." << LogVar("histogram", key));
+    return false;
+  }
+  const int nCells = array->fN;
+  const bool hasSumw2 = hist->GetSumw2N() == nCells;
+  SharedHistogramSlot* slot = registerSlot(key, type, hasSumw2, nCells, *hist);
+  if (!slot) return false;
+
+  Attached attached{hist, array, getData(array, type), nullptr, slot, stripe};
+  char* content = getContent(*slot, stripe);
+  addValues(type, content, attached.ownContent, nCells);
+  setData(array, type, content);
+  if (hasSumw2) {
+    TArrayD* sumw2 = hist->GetSumw2();
+    attached.ownSumw2 = sumw2->fArray;
+    double* shared = getSumw2(*slot, stripe);
+    addValues('D', shared, sumw2->fArray, nCells);
+    sumw2->fArray = shared;
+  }
+  m_attached.push_back(attached);
+  return true;
+}
+
+void SharedHistograms::publishStatistics()
+{
+  for (const Attached& attached : m_attached) {
+    double* statistics = getStatistics(*attached.slot, attached.stripe);
+    double values[c_NStats] = {0};
+    values[0] = attached.hist->GetEntries();
+    attached.hist->GetStats(values + 1);
+    std::copy(values, values + c_NStats, statistics);
+  }
+}
+
+void SharedHistograms::detachAll()
+{
+  for (const Attached& attached : m_attached) {
+    const SharedHistogramSlot& slot = *attached.slot;
+    char* content = getContent(slot, attached.stripe);
+    // Resizing the array while it was attached freed the shared memory with delete[], which is undefined behaviour.
+    // There is nothing to restore in that case, the array already has new memory.
+    if (getData(attached.array, slot.type) == content) {
+      memcpy(attached.ownContent, content, slot.nCells * getElementSize(slot.type));
+      setData(attached.array, slot.type, attached.ownContent);
+    } else {
+      B2ERROR("SharedHistograms: histogram was resized while its bins were in shared memory, this is not allowed."
+              << LogVar("histogram", slot.key));
+      deleteData(slot.type, attached.ownContent);
+    }
+    TArrayD* sumw2 = attached.hist->GetSumw2();
+    if (attached.ownSumw2 and sumw2->fArray == getSumw2(slot, attached.stripe)) {
+      memcpy(attached.ownSumw2, sumw2->fArray, slot.nCells * sizeof(double));
+      sumw2->fArray = static_cast<double*>(attached.ownSumw2);
+    } else if (attached.ownSumw2) {
+      B2ERROR("SharedHistograms: sums of squared weights were resized while they were in shared memory, this is not allowed."
+              << LogVar("histogram", slot.key));
+      deleteData('D', attached.ownSumw2);
+    } else if (sumw2->fN > 0) {
+      B2WARNING("SharedHistograms: Sumw2() was called after the histogram was put in shared memory, "
+                "the total has no sums of squared weights." << LogVar("histogram", slot.key));
+    }
+  }
+  m_attached.clear();
+  // the fills of this process are complete
+  for (int stripe : m_ownStripes) m_stripes[stripe].state = 2;
+  m_ownStripes.clear();
+}
+
+bool SharedHistograms::addTotal(TH1& target, const std::string& key) const
+{
+  const SharedHistogramSlot* slot = findSlot(key);
+  if (!slot or slot->state != 2) return false;
+  TArray* array = nullptr;
+  if (getArray(&target, array) != slot->type or array->fN != slot->nCells) {
+    B2ERROR("SharedHistograms: target histogram does not match the shared histogram." << LogVar("histogram", key));
+    return false;
+  }
+
+  double statistics[c_NStats] = {0};
+  target.GetStats(statistics + 1);
+  statistics[0] = target.GetEntries();
+  double publishedEntries = 0;
+  const unsigned int nStripes = std::min(m_info->nextStripe.load(), m_info->nStripes);
+  if (slot->hasSumw2 and target.GetSumw2N() == 0) target.Sumw2();
+  for (unsigned int stripe = 0; stripe < nStripes; ++stripe) {
+    if (!isStripeCounted(stripe)) continue;
+    addValues(slot->type, getData(array, slot->type), getContent(*slot, stripe), slot->nCells);
+    if (slot->hasSumw2) {
+      addValues('D', target.GetSumw2()->fArray, getSumw2(*slot, stripe), slot->nCells);
+    } else if (target.GetSumw2N() > 0) {
+      // unweighted filling: the sum of squared weights is the content
+      addToDouble(slot->type, target.GetSumw2()->fArray, getContent(*slot, stripe), slot->nCells);
+    }
+    const double* published = getStatistics(*slot, stripe);
+    publishedEntries += published[0];
+    for (int i = 0; i < c_NStats; ++i) statistics[i] += published[i];
+  }
+  if (publishedEntries > 0) {
+    target.PutStats(statistics + 1);
+    target.SetEntries(statistics[0]);
+  } else {
+    // the statistics were not published yet, calculate them from the bins
+    target.ResetStats();
+  }
+  return true;
+}
+
+std::vector<std::string> SharedHistograms::getKeys() const
+{
+  std::vector<std::string> keys;
+  if (!m_info) return keys;
+  for (unsigned int i = 0; i < m_info->nSlots; ++i) {
+    if (m_slots[i].state == 2) keys.emplace_back(m_slots[i].key);
+  }
+  return keys;
+}
+
+std::unique_ptr<TH1> SharedHistograms::createPrototype(const std::string& key) const
+{
+  const SharedHistogramSlot* slot = findSlot(key);
+  if (!slot or slot->state != 2) return nullptr;
+  TBufferFile streamed(TBuffer::kRead, slot->prototypeSize, m_data + slot->prototypeOffset, false);
+  std::unique_ptr<TH1> hist(static_cast<TH1*>(streamed.ReadObjectAny(TH1::Class())));
+  if (hist) hist->SetDirectory(nullptr);
+  return hist;
+}
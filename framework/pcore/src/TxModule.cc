@@ -17,7 +17,7 @@
 using namespace std;
 using namespace Belle2;
 
-TxModule::TxModule(RingBuffer* rbuf) : Module(), m_streamer(nullptr), m_blockingInsert(true)
+TxModule::TxModule(RingBufferBase* rbuf) : Module(), m_streamer(nullptr), m_blockingInsert(true)
 {
   //Set module properties
   setDescription("Encode DataStore into RingBuffer");
@@ -43,6 +43,8 @@ void TxModule::initialize()
 
   m_rbuf->txAttached();
   m_streamer = new DataStoreStreamer(m_compressionLevel, m_handleMergeable);
+  //messages are copied into the ring buffer right away, no need to allocate a new one for every event
+  m_streamer->setReuseMessageBuffer();
 
   if ((Environment::Instance().getStreamingObjects()).size() > 0) {
     m_streamer->setStreamingObjects(Environment::Instance().getStreamingObjects());
@@ -90,8 +92,7 @@ void TxModule::event()
       B2WARNING("Ring buffer seems full, removing some previous data.");
       m_rbuf->remq(nullptr);
     }
-    //    usleep(200);
-    usleep(20);
+    m_rbuf->waitForSpace();
   }
   m_nsent++;
 
@@ -112,6 +113,7 @@ void TxModule::terminate()
   B2DEBUG(32, "Tx: terminate called");
 
   m_rbuf->txDetached();
+  m_streamer->printEntryStatistics(DataStoreStreamer::c_statisticsDebugLevel);
   delete m_streamer;
   m_rbuf = nullptr;
 }
@@ -9,6 +9,7 @@
 #include <framework/pcore/pEventProcessor.h>
 #include <framework/pcore/ProcHandler.h>
 #include <framework/pcore/RingBuffer.h>
+#include <framework/pcore/LockFreeRingBuffer.h>
 #include <framework/pcore/RxModule.h>
 #include <framework/pcore/TxModule.h>
 #include <framework/pcore/DataStoreStreamer.h>
@@ -370,23 +371,32 @@ void pEventProcessor::analyzePath(const PathPtr& path)
     m_outputPath = outpath;
 }
 
-RingBuffer* pEventProcessor::connectViaRingBuffer(const char* name, const PathPtr& a, PathPtr& b)
+RingBufferBase* pEventProcessor::connectViaRingBuffer(const char* name, const PathPtr& a, PathPtr& b, int rxBatchSize)
 {
   //create ringbuffers and add rx/tx where needed
   const char* inrbname = getenv(name);
-  RingBuffer* rbuf;
+  const bool lockFree = Environment::Instance().getUseLockFreeRingBuffer();
+  RingBufferBase* rbuf;
   if (inrbname == nullptr) {
-    rbuf = new RingBuffer();
+    if (lockFree)
+      rbuf = new LockFreeRingBuffer();
+    else
+      rbuf = new RingBuffer();
   } else {
     string rbname(inrbname + to_string(0)); //currently at most one input, one output buffer
-    rbuf = new RingBuffer(rbname.c_str(), RingBuffer::c_DefaultSize);
+    if (lockFree)
+      rbuf = new LockFreeRingBuffer(rbname, RingBuffer::c_DefaultSize);
+    else
+      rbuf = new RingBuffer(rbname.c_str(), RingBuffer::c_DefaultSize);
   }
 
   // Insert Tx at the end of current path
   ModulePtr txptr(new TxModule(rbuf));
   a->addModule(txptr);
   // Insert Rx at beginning of next path
-  ModulePtr rxptr(new RxModule(rbuf));
+  auto* rx = new RxModule(rbuf);
+  rbuf->setReadBatchSize(rxBatchSize);
+  ModulePtr rxptr(rx);
   PathPtr newB(new Path());
   newB->addModule(rxptr);
   newB->addPath(b);
@@ -406,7 +416,7 @@ void pEventProcessor::preparePaths()
   if (m_inputPath)
     m_rbin = connectViaRingBuffer("BASF2_RBIN", m_inputPath, m_mainPath);
   if (m_outputPath)
-    m_rbout = connectViaRingBuffer("BASF2_RBOUT", m_mainPath, m_outputPath);
+    m_rbout = connectViaRingBuffer("BASF2_RBOUT", m_mainPath, m_outputPath, c_OutputBatchSize);
 }
 
 
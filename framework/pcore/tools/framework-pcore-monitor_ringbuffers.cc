@@ -7,6 +7,7 @@
  **************************************************************************/
 
 #include <framework/pcore/RingBuffer.h>
+#include <framework/pcore/LockFreeRingBuffer.h>
 #include <framework/logging/Logger.h>
 
 #include <filesystem>
@@ -22,12 +23,40 @@
 #include <sys/shm.h>
 
 
+void lockFreeRbinfo(int shmid, const Belle2::LockFreeRingBufInfo* info)
+{
+  const uint64_t reserve = info->reserve.load();
+  const uint64_t reclaim = info->reclaim.load();
+  const uint32_t readTicket = info->readTicket.load();
+  const uint32_t reserveTicket = reserve >> 32;
+  const uint32_t reclaimTicket = reclaim >> 32;
+  //used memory includes entries picked up but not yet reclaimed
+  long filled_words = long(reserve & 0xffffffff) - long(reclaim & 0xffffffff);
+  if (filled_words < 0 or (filled_words == 0 and reserveTicket != reclaimTicket))
+    filled_words += info->size;
+  const long filled_bytes = filled_words * sizeof(int);
+  const uint32_t usedSlots = reserveTicket - reclaimTicket;
+  std::cout << "LFRB " << shmid
+            << " #Tx: " << info->numAttachedTx << "\t"
+            << " #busy: " << info->nbusy << "\t"
+            << " #waiting Rx/Tx: " << info->nWaitingRx << "/" << info->nWaitingTx << "\t"
+            << (info->killed ? 0 : reserveTicket - readTicket) << " entries\t"
+            << filled_bytes / 1024.0 / 1024.0 << " MiB filled\t(" << 100.0 * filled_words / double(info->size) << " %)\t"
+            << usedSlots << "/" << info->nslots << " slots used"
+            << "\n";
+}
+
 void rbinfo(int shmid)
 {
   const int* shmadr = (int*) shmat(shmid, nullptr, SHM_RDONLY);
   if (shmadr == (int*) - 1) {
     B2FATAL("RingBuffer: Attaching to shared memory segment via shmat() failed");
   }
+  if (*shmadr == Belle2::LockFreeRingBufInfo::c_Magic) {
+    lockFreeRbinfo(shmid, reinterpret_cast<const Belle2::LockFreeRingBufInfo*>(shmadr));
+    shmdt(shmadr);
+    return;
+  }
   const auto* m_bufinfo = reinterpret_cast<const Belle2::RingBufInfo*>(shmadr);
 
   long filled_bytes = m_bufinfo->wptr - m_bufinfo->rptr;
@@ -82,7 +111,7 @@ int main(int argc, char**)
   if (argc > 1) {
     printf("Usage : monitor_ringbuffers\n");
 
-    printf("\n Shows fill-state information on all active RingBuffers on this system.\n\n");
+    printf("\n Shows fill-state information on all active RingBuffers (RB) and LockFreeRingBuffers (LFRB) on this system.\n\n");
     return -1;
   }
 
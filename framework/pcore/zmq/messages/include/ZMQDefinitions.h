@@ -22,6 +22,7 @@ namespace Belle2 {
     c_rawDataMessage = 'u',        // a normal message with event data but in raw format
     c_compressedDataMessage = 'v', // a normal message with event data but in compressed format
     c_eventMessage = 'w',          // a normal message with event data
+    c_eventBatchMessage = 'b',     // several events packed into one message (see EventBatch)
 
     // Only needed by framework
     c_goodbyeMessage = 'g',      // un-registration
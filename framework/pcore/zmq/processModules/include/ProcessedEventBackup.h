@@ -12,38 +12,49 @@
 #include <framework/pcore/zmq/messages/ZMQMessageFactory.h>
 #include <memory>
 #include <chrono>
+#include <vector>
 
 namespace Belle2 {
-  /// Storage item for the event backup storing the event message, the time stamp and the event meta data
+  /**
+   * Storage item for the event backup storing the event messages of one batch sent to a worker,
+   * the time stamp and the event meta data. Confirmed events are removed one by one.
+   */
   class ProcessedEventBackup {
     /// Short for the class of the time stamp (it is a system clock time stamp)
     using TimeStamp = std::chrono::time_point<std::chrono::system_clock>;
   public:
-    /// Constructor setting the information. Takes ownership of the evtMsg.
-    ProcessedEventBackup(std::unique_ptr<EvtMessage> evtMsg, const EventMetaData& evtMetaData,
+    /// Constructor setting the information. Takes ownership of the evtMsgs, which belong to the entries of evtMetaData.
+    ProcessedEventBackup(std::vector<std::unique_ptr<EvtMessage>> evtMsgs, const std::vector<EventMetaData>& evtMetaData,
                          unsigned int workerId);
 
-    /// Compare operator needed in the backup list
-    bool operator==(const EventMetaData& rhs);
+    /// Remove the event with the given meta data (on confirmation). Returns false if it is not in this backup.
+    bool removeEvent(const EventMetaData& evtMetaData);
 
-    /// Publish this event backup directly to the given client.
+    /// True if all events were confirmed
+    bool empty() const;
+
+    /// Publish the remaining events of this backup directly to the given client.
     template <class AZMQClient>
     void sendToSocket(const AZMQClient& socket);
 
-    /// Getter for the stored event meta data
-    const EventMetaData& getEventMetaData() const;
+    /// Getter for the stored event meta data of the remaining events
+    const std::vector<EventMetaData>& getEventMetaData() const;
+    /// Getter for the number of events sent to the worker, including the already confirmed ones
+    unsigned int getBatchSize() const;
     /// Getter for the stored time stamp
     const TimeStamp& getTimestamp() const;
     /// Getter for the stored worker id
     const unsigned int& getWorkerId() const;
 
   private:
-    /// Stored event message
-    std::unique_ptr<EvtMessage> m_eventMessage;
+    /// Stored event messages
+    std::vector<std::unique_ptr<EvtMessage>> m_eventMessages;
     /// Getter for the stored event meta data
-    EventMetaData m_eventMetaData;
+    std::vector<EventMetaData> m_eventMetaData;
     /// Getter for the stored worker id
     unsigned int m_workerId;
+    /// Number of events sent to the worker
+    unsigned int m_batchSize;
     /// Getter for the stored time stamp
     TimeStamp m_timestamp = std::chrono::system_clock::now();
   };
@@ -51,8 +62,10 @@ namespace Belle2 {
   template <class AZMQClient>
   void ProcessedEventBackup::sendToSocket(const AZMQClient& socket)
   {
-    auto message = ZMQMessageFactory::createMessage(EMessageTypes::c_eventMessage, m_eventMessage);
-    socket.publish(std::move(message));
-    B2DEBUG(100, "sent backup evt: " << m_eventMetaData.getEvent());
+    for (size_t i = 0; i < m_eventMessages.size(); ++i) {
+      auto message = ZMQMessageFactory::createMessage(EMessageTypes::c_eventMessage, m_eventMessages[i]);
+      socket.publish(std::move(message));
+      B2DEBUG(100, "sent backup evt: " << m_eventMetaData[i].getEvent());
+    }
   }
 }
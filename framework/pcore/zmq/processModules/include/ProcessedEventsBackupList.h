@@ -25,17 +25,25 @@ namespace Belle2 {
     /// Add a new event backup with the given information. Takes ownership of the evt message.
     void storeEvent(std::unique_ptr<EvtMessage> evtMsg, const StoreObjPtr<EventMetaData>& evtMetaData, const unsigned int workerId);
 
-    /// Remove all backups with the given event meta data (on confirmation)
+    /// Add a backup of a batch of events sent to one worker. Takes ownership of the evt messages.
+    void storeBatch(std::vector<std::unique_ptr<EvtMessage>> evtMsgs, const std::vector<EventMetaData>& evtMetaData,
+                    const unsigned int workerId);
+
+    /// Remove the event with the given event meta data (on confirmation), and its batch if it was the last one
     void removeEvent(const EventMetaData& evtMetaData);
 
-    /// Check the items for timeout. Returns -1 if no timeout happened and the worker id, if it did.
+    /**
+     * Check the items for timeout. Returns -1 if no timeout happened and the worker id, if it did.
+     * The timeout is per event: a worker processes the events of a batch one after the other, so a batch
+     * times out after the given timeout multiplied with the number of events sent in it.
+     */
     int checkForTimeout(const Duration& timeout) const;
 
     /// Send all backups of a given worker directly to the multicast and delete them.
     template <class AZMQClient>
     void sendWorkerBackupEvents(unsigned int worker, const AZMQClient& socket);
 
-    /// Check the size
+    /// Check the size (number of batches)
     unsigned int size() const;
 
   private:
@@ -48,10 +56,10 @@ namespace Belle2 {
   {
     for (auto it = m_evtBackupVector.begin(); it != m_evtBackupVector.end();) {
       if (it->getWorkerId() == worker) {
-        B2DEBUG(100, "Delete event: " << it->getEventMetaData().getEvent());
+        B2DEBUG(100, "Delete batch of " << it->getEventMetaData().size() << " events");
         it->sendToSocket(socket);
         // TODO: better: delete backup on confirmation message
-        m_evtBackupVector.erase(it);
+        it = m_evtBackupVector.erase(it);
         B2DEBUG(100, "new backup list size: " << m_evtBackupVector.size());
       } else {
         it++;
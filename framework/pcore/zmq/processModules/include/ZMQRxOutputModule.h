@@ -13,6 +13,7 @@
 #include <framework/core/RandomGenerator.h>
 #include <framework/pcore/zmq/sockets/ZMQClient.h>
 #include <framework/pcore/zmq/utils/StreamHelper.h>
+#include <framework/pcore/zmq/utils/EventBatch.h>
 
 namespace Belle2 {
   /**
@@ -53,6 +54,10 @@ namespace Belle2 {
     ZMQClient m_zmqClient;
     /// The data store streamer
     StreamHelper m_streamer;
+    /// The last received batch of events
+    EventBatch m_batch;
+    /// Index of the next event of the batch to pass on
+    size_t m_nextBatchEvent = 0;
 
     /// The event meta data in the data store needed for confirming events
     StoreObjPtr<EventMetaData> m_eventMetaData;
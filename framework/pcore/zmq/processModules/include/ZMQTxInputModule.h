@@ -13,9 +13,13 @@
 #include <framework/core/RandomGenerator.h>
 #include <framework/pcore/zmq/sockets/ZMQClient.h>
 #include <framework/pcore/zmq/utils/StreamHelper.h>
+#include <framework/pcore/zmq/utils/EventBatch.h>
 
 #include <framework/pcore/zmq/processModules/ProcessedEventsBackupList.h>
+#include <condition_variable>
 #include <deque>
+#include <mutex>
+#include <thread>
 
 namespace Belle2 {
   /**
@@ -65,6 +69,27 @@ namespace Belle2 {
     int m_param_compressionLevel = 0;
     /// Parameter: Can we handle mergeables?
     bool m_param_handleMergeable = true;
+    /// Parameter: number of events sent to a worker in one message
+    unsigned int m_param_batchSize = 1;
+    /// Parameter: maximal time in ms an event waits for its batch to become full
+    unsigned int m_param_maximalBatchLatency = 100;
+    /// Parameter: ROOT compression setting of the batches
+    int m_param_batchCompressionLevel = 0;
+
+    /// Events collected for the next batch
+    EventBatch m_batch;
+    /// Event messages of the next batch, kept for the event backup
+    std::vector<std::unique_ptr<EvtMessage>> m_batchMessages;
+    /// Set if a terminate message was received
+    bool m_terminate = false;
+    /// Protects the batch, the client and the worker bookkeeping, which are shared with the flush thread
+    std::mutex m_batchMutex;
+    /// Wakes up the flush thread when the first event of a batch arrives or on terminate
+    std::condition_variable m_flushCondition;
+    /// Set to true to end the flush thread
+    bool m_stopFlushThread = false;
+    /// Sends batches which are not full after maximalBatchLatency while the input waits for new events
+    std::thread m_flushThread;
 
     /// Our ZMQ client
     ZMQClient m_zmqClient;
@@ -78,5 +103,17 @@ namespace Belle2 {
 
     /// Check if a worker has fallen into a timeout and send a kill message if needed.
     void checkWorkerProcTimeout();
+    /// Answer hello, confirmation, delete and terminate messages on the multicast during event processing
+    bool handleMulticastMessage(const std::unique_ptr<zmq::socket_t>& socket);
+    /// Register ready workers
+    bool handleSocketMessage(const std::unique_ptr<zmq::socket_t>& socket);
+    /**
+     * Send the collected batch to the next ready worker.
+     * @param waitForWorker wait for a ready worker if there is none, otherwise keep the batch
+     * @return true if the batch was sent (or there was nothing to send)
+     */
+    bool sendBatch(bool waitForWorker = true);
+    /// Body of the flush thread
+    void flushOldBatches();
   };
 }
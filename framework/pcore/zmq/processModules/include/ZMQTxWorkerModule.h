@@ -14,6 +14,11 @@
 
 #include <framework/pcore/zmq/sockets/ZMQClient.h>
 #include <framework/pcore/zmq/utils/StreamHelper.h>
+#include <framework/pcore/zmq/utils/EventBatch.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 
 namespace Belle2 {
@@ -46,6 +51,12 @@ namespace Belle2 {
     int m_param_compressionLevel = 0;
     /// Parameter: Can we handle mergeables?
     bool m_param_handleMergeable = true;
+    /// Parameter: number of events sent to the output in one message
+    unsigned int m_param_batchSize = 1;
+    /// Parameter: maximal time in ms an event waits for its batch to become full
+    unsigned int m_param_maximalBatchLatency = 100;
+    /// Parameter: ROOT compression setting of the batches
+    int m_param_batchCompressionLevel = 0;
 
     /// The event meta data in the data store needed for confirming events
     StoreObjPtr<EventMetaData> m_eventMetaData;
@@ -54,5 +65,21 @@ namespace Belle2 {
     ZMQClient m_zmqClient;
     /// The data store streamer
     StreamHelper m_streamer;
+    /// Events collected for the next batch
+    EventBatch m_batch;
+
+    /// Protects the batch and the client, which are shared with the flush thread
+    std::mutex m_batchMutex;
+    /// Wakes up the flush thread when the first event of a batch arrives or on terminate
+    std::condition_variable m_flushCondition;
+    /// Set to true to end the flush thread
+    bool m_stopFlushThread = false;
+    /// Sends batches which are not full after maximalBatchLatency while the worker waits for new events
+    std::thread m_flushThread;
+
+    /// Send the collected batch to the output
+    void sendBatch();
+    /// Body of the flush thread
+    void flushOldBatches();
   };
 }
@@ -9,18 +9,42 @@
 
 using namespace Belle2;
 
-ProcessedEventBackup::ProcessedEventBackup(std::unique_ptr<EvtMessage> evtMsg,
-                                           const EventMetaData& evtMetaData,
+ProcessedEventBackup::ProcessedEventBackup(std::vector<std::unique_ptr<EvtMessage>> evtMsgs,
+                                           const std::vector<EventMetaData>& evtMetaData,
                                            unsigned int workerId)
-  : m_eventMessage(std::move(evtMsg)), m_eventMetaData(evtMetaData), m_workerId(workerId)
+  : m_eventMessages(std::move(evtMsgs)), m_eventMetaData(evtMetaData), m_workerId(workerId),
+    m_batchSize(evtMetaData.size())
 {
+  B2ASSERT("Each event of the backup needs its meta data", m_eventMessages.size() == m_eventMetaData.size());
 }
 
-const EventMetaData& ProcessedEventBackup::getEventMetaData() const
+bool ProcessedEventBackup::removeEvent(const EventMetaData& evtMetaData)
+{
+  for (size_t i = 0; i < m_eventMetaData.size(); ++i) {
+    if (m_eventMetaData[i] == evtMetaData) {
+      m_eventMetaData.erase(m_eventMetaData.begin() + i);
+      m_eventMessages.erase(m_eventMessages.begin() + i);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ProcessedEventBackup::empty() const
+{
+  return m_eventMetaData.empty();
+}
+
+const std::vector<EventMetaData>& ProcessedEventBackup::getEventMetaData() const
 {
   return m_eventMetaData;
 }
 
+unsigned int ProcessedEventBackup::getBatchSize() const
+{
+  return m_batchSize;
+}
+
 const ProcessedEventBackup::TimeStamp& ProcessedEventBackup::getTimestamp() const
 {
   return m_timestamp;
@@ -30,8 +54,3 @@ const unsigned int& ProcessedEventBackup::getWorkerId() const
 {
   return m_workerId;
 }
-
-bool ProcessedEventBackup::operator==(const EventMetaData& rhs)
-{
-  return m_eventMetaData == rhs;
-}
\ No newline at end of file
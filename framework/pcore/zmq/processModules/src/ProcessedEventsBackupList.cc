@@ -13,31 +13,38 @@ void ProcessedEventsBackupList::storeEvent(std::unique_ptr<EvtMessage> evtMsg, c
                                            const unsigned int workerId)
 {
   EventMetaData eventMetaData(evtMetaData->getEvent(), evtMetaData->getRun(), evtMetaData->getExperiment());
-  m_evtBackupVector.emplace_back(std::move(evtMsg), eventMetaData, workerId);
+  std::vector<std::unique_ptr<EvtMessage>> evtMsgs;
+  evtMsgs.push_back(std::move(evtMsg));
+  m_evtBackupVector.emplace_back(std::move(evtMsgs), std::vector<EventMetaData> {eventMetaData}, workerId);
 }
 
-void ProcessedEventsBackupList::removeEvent(const EventMetaData& evtMetaData)
+void ProcessedEventsBackupList::storeBatch(std::vector<std::unique_ptr<EvtMessage>> evtMsgs,
+                                           const std::vector<EventMetaData>& evtMetaData, const unsigned int workerId)
 {
-  const auto oldSize = m_evtBackupVector.size();
-
-  m_evtBackupVector.erase(std::remove(m_evtBackupVector.begin(), m_evtBackupVector.end(), evtMetaData),
-                          m_evtBackupVector.end());
+  m_evtBackupVector.emplace_back(std::move(evtMsgs), evtMetaData, workerId);
+}
 
-  if (oldSize == m_evtBackupVector.size()) {
-    B2WARNING("Event: " << evtMetaData.getEvent() << ", no matching event backup found in backup list");
+void ProcessedEventsBackupList::removeEvent(const EventMetaData& evtMetaData)
+{
+  for (auto it = m_evtBackupVector.begin(); it != m_evtBackupVector.end(); ++it) {
+    if (it->removeEvent(evtMetaData)) {
+      if (it->empty()) m_evtBackupVector.erase(it);
+      return;
+    }
   }
+  B2WARNING("Event: " << evtMetaData.getEvent() << ", no matching event backup found in backup list");
 }
 
 int ProcessedEventsBackupList::checkForTimeout(const Duration& timeout) const
 {
-  if (m_evtBackupVector.empty()) {
-    return -1;
-  }
-  if (std::chrono::system_clock::now() - m_evtBackupVector[0].getTimestamp() > timeout) {
-    return m_evtBackupVector[0].getWorkerId();
-  } else {
-    return -1;
+  const auto now = std::chrono::system_clock::now();
+  // batches of different size have different deadlines, so the oldest one is not necessarily the first to time out
+  for (const auto& backup : m_evtBackupVector) {
+    if (now - backup.getTimestamp() > timeout * backup.getBatchSize()) {
+      return backup.getWorkerId();
+    }
   }
+  return -1;
 }
 
 unsigned int ProcessedEventsBackupList::size() const
@@ -8,6 +8,7 @@
 #include <framework/pcore/zmq/processModules/ZMQRxOutputModule.h>
 #include <framework/pcore/zmq/messages/ZMQDefinitions.h>
 #include <framework/pcore/zmq/messages/ZMQMessageFactory.h>
+#include <framework/pcore/zmq/utils/EventMetaDataSerialization.h>
 #include <framework/core/Environment.h>
 
 using namespace std;
@@ -53,6 +54,12 @@ void ZMQRxOutputModule::event()
       m_endRun = Environment::Instance().getNumberProcesses();
     }
 
+    // pass on the remaining events of the last batch first, they were already confirmed
+    if (m_nextBatchEvent < m_batch.size()) {
+      m_streamer.read(m_batch.getEventBuffer(m_nextBatchEvent++));
+      return;
+    }
+
     const auto multicastAnswer = [this](const auto & socket) {
       auto message = ZMQMessageFactory::fromSocket<ZMQNoIdMessage>(socket);
       if (message->isMessage(EMessageTypes::c_eventMessage)) {
@@ -104,6 +111,19 @@ void ZMQRxOutputModule::event()
           }
         }
 
+        return false;
+      } else if (message->isMessage(EMessageTypes::c_eventBatchMessage)) {
+        // batches only contain normal events, end run records and special first events are sent alone
+        m_batch.unpack(message->getDataMessage());
+        B2DEBUG(100, "received batch of " << m_batch.size() << " events");
+        auto confirmMessage = ZMQMessageFactory::createMessage(EMessageTypes::c_confirmMessage,
+                                                               EventMetaDataSerialization::serializeList(m_batch.getEventMetaData()));
+        m_zmqClient.publish(std::move(confirmMessage));
+        m_nextBatchEvent = 0;
+        if (m_batch.empty()) {
+          return true;
+        }
+        m_streamer.read(m_batch.getEventBuffer(m_nextBatchEvent++));
         return false;
       }
 
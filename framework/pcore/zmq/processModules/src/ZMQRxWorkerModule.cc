@@ -90,6 +90,12 @@ void ZMQRxWorkerModule::event()
       //      B2INFO ( "ZMQRxWorker :: Connection established after sending reply" );
     }
 
+    // process the remaining events of the last batch before asking for more
+    if (m_nextBatchEvent < m_batch.size()) {
+      m_streamer.read(m_batch.getEventBuffer(m_nextBatchEvent++));
+      return;
+    }
+
     const auto multicastAnswer = [](const auto & socket) {
       const auto message = ZMQMessageFactory::fromSocket<ZMQNoIdMessage>(socket);
       if (message->isMessage(EMessageTypes::c_terminateMessage)) {
@@ -114,6 +120,17 @@ void ZMQRxWorkerModule::event()
         auto readyMessage = ZMQMessageFactory::createMessage(EMessageTypes::c_readyMessage);
         m_zmqClient.send(std::move(readyMessage));
         return false;
+      } else if (message->isMessage(EMessageTypes::c_eventBatchMessage)) {
+        B2DEBUG(30, "received event batch... write the first event to data store");
+        m_batch.unpack(message->getDataMessage());
+        m_nextBatchEvent = 0;
+        if (not m_batch.empty()) {
+          m_streamer.read(m_batch.getEventBuffer(m_nextBatchEvent++));
+        }
+        // one ready message per batch, the input sends the next batch while we process this one
+        auto readyMessage = ZMQMessageFactory::createMessage(EMessageTypes::c_readyMessage);
+        m_zmqClient.send(std::move(readyMessage));
+        return false;
       } else if (message->isMessage(EMessageTypes::c_lastEventMessage)) {
         B2DEBUG(30, "received end message from input");
         return false;
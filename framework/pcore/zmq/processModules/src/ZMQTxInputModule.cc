@@ -29,6 +29,13 @@ ZMQTxInputModule::ZMQTxInputModule() : Module()
   addParam("maximalWaitingTime", m_param_maximalWaitingTime, "Maximal time to wait for any message");
   addParam("workerProcessTimeout", m_param_workerProcessTimeout, "Maximal time a worker is allowed to spent per event");
   addParam("useEventBackup", m_param_useEventBackup, "Turn on the event backup");
+  addParam("batchSize", m_param_batchSize, "Number of events sent to a worker in one message", m_param_batchSize);
+  addParam("maximalBatchLatency", m_param_maximalBatchLatency,
+           "Send a batch which is not full if its first event is older than this (in ms), also while waiting for new events",
+           m_param_maximalBatchLatency);
+  addParam("batchCompressionLevel", m_param_batchCompressionLevel,
+           "ROOT compression setting of the batches (algorithm * 100 + level, e.g. 404 for LZ4 or 505 for ZSTD), 0 for none",
+           m_param_batchCompressionLevel);
 
   setPropertyFlags(EModulePropFlags::c_ParallelProcessingCertified);
 
@@ -46,6 +53,7 @@ void ZMQTxInputModule::initialize()
 void ZMQTxInputModule::event()
 {
   try {
+    std::unique_lock<std::mutex> lock(m_batchMutex);
     if (m_firstEvent) {
       B2INFO("ZMQTxInputModule :: First Event here");
 
@@ -62,6 +70,11 @@ void ZMQTxInputModule::event()
       m_zmqClient.subscribe(EMessageTypes::c_deleteWorkerMessage);
       m_zmqClient.subscribe(EMessageTypes::c_terminateMessage);
 
+      // the next event() call only happens when the input path delivers the next event, so the latency is checked in a thread
+      if (m_param_batchSize > 1) {
+        LogSystem::Instance().enableThreadSafety();
+        m_flushThread = std::thread(&ZMQTxInputModule::flushOldBatches, this);
+      }
       m_firstEvent = false;
     }
 
@@ -77,49 +90,12 @@ void ZMQTxInputModule::event()
       timeout = 0;
     }
 
-    bool terminate = false;
-
-    const auto multicastAnswer = [this, &terminate](const auto & socket) {
-      const auto multicastMessage = ZMQMessageFactory::fromSocket<ZMQNoIdMessage>(socket);
-      const std::string& data = multicastMessage->getData();
-
-      if (multicastMessage->isMessage(EMessageTypes::c_helloMessage)) {
-        m_workers.push_back(std::stoi(data));
-        B2DEBUG(30, "received c_helloMessage from " << data << "... replying");
-        //        B2INFO ( "ZMQTxInput : received c_helloMessage from " << data << "... replying");
-        auto replyHelloMessage = ZMQMessageFactory::createMessage(data, EMessageTypes::c_helloMessage);
-        m_zmqClient.send(std::move(replyHelloMessage));
-        return true;
-      } else if (multicastMessage->isMessage(EMessageTypes::c_confirmMessage) and m_param_useEventBackup) {
-        const auto& eventMetaData = EventMetaDataSerialization::deserialize(data);
-        m_procEvtBackupList.removeEvent(eventMetaData);
-        B2DEBUG(30, "removed event backup.. list size: " << m_procEvtBackupList.size());
-        return true;
-      } else if (multicastMessage->isMessage(EMessageTypes::c_deleteWorkerMessage) and m_param_useEventBackup) {
-        const int workerID = std::atoi(data.c_str());
-        B2DEBUG(30, "received worker delete message, workerID: " << workerID);
-        m_procEvtBackupList.sendWorkerBackupEvents(workerID, m_zmqClient);
-        m_nextWorker.erase(std::remove(m_nextWorker.begin(), m_nextWorker.end(), workerID), m_nextWorker.end());
-        return true;
-      } else if (multicastMessage->isMessage(EMessageTypes::c_terminateMessage)) {
-        B2DEBUG(30, "Having received a stop message. I can not do much here, but just hope for the best.");
-        terminate = true;
-        return false;
-      }
-
-      return true;
+    const auto multicastAnswer = [this](const auto & socket) {
+      return handleMulticastMessage(socket);
     };
 
     const auto socketAnswer = [this](const auto & socket) {
-      const auto message = ZMQMessageFactory::fromSocket<ZMQIdMessage>(socket);
-      if (message->isMessage(EMessageTypes::c_readyMessage)) {
-        B2DEBUG(30, "got worker ready message");
-        m_nextWorker.push_back(std::stoi(message->getIdentity()));
-        return false;
-      }
-
-      B2ERROR("Invalid message from worker");
-      return true;
+      return handleSocketMessage(socket);
     };
 
 
@@ -138,8 +114,7 @@ void ZMQTxInputModule::event()
       while (m_nextWorker.size() < numproc * numbuf) {
         m_zmqClient.poll(timeout, multicastAnswer, socketAnswer);
         //      B2INFO ( "ZMQTxInput : numproc = " << numproc << " <-> count = " << m_nextWorker.size() );
-        // false positive due to lambda capture ...
-        if (terminate) {
+        if (m_terminate) {
           m_zmqClient.terminate();
           return;
         }
@@ -169,9 +144,31 @@ void ZMQTxInputModule::event()
 
     // Normal event processing
 
+    if (m_param_batchSize > 1) {
+      auto eventMessage = m_streamer.stream();
+      if (eventMessage->size() > 0) {
+        if (m_batch.empty()) {
+          m_flushCondition.notify_one();
+        }
+        m_batch.add(*eventMessage, *m_eventMetaData);
+        if (m_param_useEventBackup) {
+          m_batchMessages.push_back(std::move(eventMessage));
+        }
+      }
+      if (m_batch.size() >= m_param_batchSize) {
+        sendBatch();
+      } else {
+        // do not wait, but answer confirmations and register ready workers
+        m_zmqClient.poll(0, multicastAnswer, socketAnswer);
+      }
+      if (m_terminate) {
+        m_zmqClient.terminate();
+      }
+      return;
+    }
+
     m_zmqClient.poll(timeout, multicastAnswer, socketAnswer);
-    // false positive due to lambda capture ...
-    if (terminate) {
+    if (m_terminate) {
       m_zmqClient.terminate();
       return;
     }
@@ -207,14 +204,140 @@ void ZMQTxInputModule::event()
   }
 }
 
+bool ZMQTxInputModule::handleMulticastMessage(const std::unique_ptr<zmq::socket_t>& socket)
+{
+  const auto multicastMessage = ZMQMessageFactory::fromSocket<ZMQNoIdMessage>(socket);
+  const std::string& data = multicastMessage->getData();
+
+  if (multicastMessage->isMessage(EMessageTypes::c_helloMessage)) {
+    m_workers.push_back(std::stoi(data));
+    B2DEBUG(30, "received c_helloMessage from " << data << "... replying");
+    //        B2INFO ( "ZMQTxInput : received c_helloMessage from " << data << "... replying");
+    auto replyHelloMessage = ZMQMessageFactory::createMessage(data, EMessageTypes::c_helloMessage);
+    m_zmqClient.send(std::move(replyHelloMessage));
+    return true;
+  } else if (multicastMessage->isMessage(EMessageTypes::c_confirmMessage) and m_param_useEventBackup) {
+    // the output confirms all events of a batch at once
+    for (const auto& eventMetaData : EventMetaDataSerialization::deserializeList(data)) {
+      m_procEvtBackupList.removeEvent(eventMetaData);
+    }
+    B2DEBUG(30, "removed event backup.. list size: " << m_procEvtBackupList.size());
+    return true;
+  } else if (multicastMessage->isMessage(EMessageTypes::c_deleteWorkerMessage) and m_param_useEventBackup) {
+    const int workerID = std::atoi(data.c_str());
+    B2DEBUG(30, "received worker delete message, workerID: " << workerID);
+    m_procEvtBackupList.sendWorkerBackupEvents(workerID, m_zmqClient);
+    m_nextWorker.erase(std::remove(m_nextWorker.begin(), m_nextWorker.end(), workerID), m_nextWorker.end());
+    return true;
+  } else if (multicastMessage->isMessage(EMessageTypes::c_terminateMessage)) {
+    B2DEBUG(30, "Having received a stop message. I can not do much here, but just hope for the best.");
+    m_terminate = true;
+    return false;
+  }
+
+  return true;
+}
+
+bool ZMQTxInputModule::handleSocketMessage(const std::unique_ptr<zmq::socket_t>& socket)
+{
+  const auto message = ZMQMessageFactory::fromSocket<ZMQIdMessage>(socket);
+  if (message->isMessage(EMessageTypes::c_readyMessage)) {
+    B2DEBUG(30, "got worker ready message");
+    m_nextWorker.push_back(std::stoi(message->getIdentity()));
+    return false;
+  }
+
+  B2ERROR("Invalid message from worker");
+  return true;
+}
+
+bool ZMQTxInputModule::sendBatch(bool waitForWorker)
+{
+  if (m_batch.empty() or not m_zmqClient.isOnline()) {
+    return true;
+  }
+
+  const auto multicastAnswer = [this](const auto & socket) {
+    return handleMulticastMessage(socket);
+  };
+  const auto socketAnswer = [this](const auto & socket) {
+    return handleSocketMessage(socket);
+  };
+  if (not waitForWorker) {
+    // only register workers which are ready already
+    m_zmqClient.poll(0, multicastAnswer, socketAnswer);
+    if (m_terminate or m_nextWorker.empty()) {
+      return false;
+    }
+  }
+  while (m_nextWorker.empty()) {
+    const int pollReply = m_zmqClient.poll(Environment::Instance().getZMQMaximalWaitingTime(), multicastAnswer, socketAnswer);
+    if (m_terminate) {
+      return false;
+    }
+    B2ASSERT("Did not receive any ready messaged for quite some time!", pollReply);
+  }
+
+  const unsigned int nextWorker = m_nextWorker.front();
+  m_nextWorker.pop_front();
+
+  // the batch is cleared when packing
+  const std::vector<EventMetaData> eventMetaData = m_batch.getEventMetaData();
+  auto message = ZMQMessageFactory::createMessage(std::to_string(nextWorker), EMessageTypes::c_eventBatchMessage,
+                                                  m_batch.pack(m_param_batchCompressionLevel));
+  m_zmqClient.send(std::move(message));
+  B2DEBUG(30, "Having send batch of " << eventMetaData.size() << " events to worker " << nextWorker);
+
+  if (m_param_useEventBackup) {
+    m_procEvtBackupList.storeBatch(std::move(m_batchMessages), eventMetaData, nextWorker);
+    m_batchMessages.clear();
+    checkWorkerProcTimeout();
+  }
+  return true;
+}
+
+void ZMQTxInputModule::flushOldBatches()
+{
+  const std::chrono::milliseconds latency(m_param_maximalBatchLatency);
+  std::unique_lock<std::mutex> lock(m_batchMutex);
+  while (not m_stopFlushThread and not m_terminate and m_zmqClient.isOnline()) {
+    if (m_batch.empty()) {
+      m_flushCondition.wait(lock);
+    } else if (m_batch.getAge() < latency) {
+      m_flushCondition.wait_for(lock, latency - m_batch.getAge());
+    } else {
+      try {
+        // never wait for a worker here: B2ASSERT can't be used outside of the main thread, and the
+        // main thread still waits (and fails) in event() if the workers stop sending ready messages
+        if (not sendBatch(false)) {
+          m_flushCondition.wait_for(lock, latency);
+        }
+      } catch (zmq::error_t& ex) {
+        if (ex.num() != EINTR) {
+          B2ERROR("There was an error sending a batch from the Tx input: " << ex.what());
+        }
+        // the remaining events are sent at the end of the run
+        return;
+      } catch (exception& ex) {
+        B2ERROR("There was an error sending a batch from the Tx input: " << ex.what());
+        return;
+      }
+    }
+  }
+}
+
 // End Run
 void ZMQTxInputModule::endRun()
 {
+  std::unique_lock<std::mutex> lock(m_batchMutex);
 
   B2DEBUG(30, "ZMQTxInput:: EndRun detected. isEndOfRun = " << m_eventMetaData->isEndOfRun() << " RunNo = " <<
           m_eventMetaData->getRun());
   if (m_eventMetaData->isEndOfRun() != 1) return;
 
+  // the events of the run have to reach the workers before the end run record
+  sendBatch();
+
   // Stream End Run record
   auto eventMessage = m_streamer.stream();
 
@@ -252,11 +375,23 @@ void ZMQTxInputModule::checkWorkerProcTimeout()
 
 void ZMQTxInputModule::terminate()
 {
+  if (m_flushThread.joinable()) {
+    {
+      std::unique_lock<std::mutex> lock(m_batchMutex);
+      m_stopFlushThread = true;
+    }
+    m_flushCondition.notify_one();
+    m_flushThread.join();
+    LogSystem::Instance().disableThreadSafety();
+  }
 
   if (not m_zmqClient.isOnline()) {
     return;
   }
 
+  sendBatch();
+  m_batch.printStatistics("ZMQTxInput", m_param_batchSize);
+
   for (unsigned int workerID : m_workers) {
     std::string workerIDString = std::to_string(workerID);
     auto message = ZMQMessageFactory::createMessage(workerIDString, EMessageTypes::c_lastEventMessage);
@@ -268,8 +403,9 @@ void ZMQTxInputModule::terminate()
     const std::string& data = multicastMessage->getData();
 
     if (multicastMessage->isMessage(EMessageTypes::c_confirmMessage) and m_param_useEventBackup) {
-      const auto& eventMetaData = EventMetaDataSerialization::deserialize(data);
-      m_procEvtBackupList.removeEvent(eventMetaData);
+      for (const auto& eventMetaData : EventMetaDataSerialization::deserializeList(data)) {
+        m_procEvtBackupList.removeEvent(eventMetaData);
+      }
       B2DEBUG(30, "removed event backup.. list size: " << m_procEvtBackupList.size());
       return true;
     } else if (multicastMessage->isMessage(EMessageTypes::c_deleteWorkerMessage) and m_param_useEventBackup) {
@@ -18,6 +18,13 @@ ZMQTxWorkerModule::ZMQTxWorkerModule() : Module()
   addParam("socketName", m_param_socketName, "Name of the socket to connect this module to.");
   addParam("xpubProxySocketName", m_param_xpubProxySocketName, "Address of the XPUB socket of the proxy");
   addParam("xsubProxySocketName", m_param_xsubProxySocketName, "Address of the XSUB socket of the proxy");
+  addParam("batchSize", m_param_batchSize, "Number of events sent to the output in one message", m_param_batchSize);
+  addParam("maximalBatchLatency", m_param_maximalBatchLatency,
+           "Send a batch which is not full if its first event is older than this (in ms), also while waiting for new events",
+           m_param_maximalBatchLatency);
+  addParam("batchCompressionLevel", m_param_batchCompressionLevel,
+           "ROOT compression setting of the batches (algorithm * 100 + level, e.g. 404 for LZ4 or 505 for ZSTD), 0 for none",
+           m_param_batchCompressionLevel);
   setPropertyFlags(EModulePropFlags::c_ParallelProcessingCertified);
 
   B2ASSERT("Module is only allowed in a multiprocessing environment. If you only want to use a single process,"
@@ -28,14 +35,34 @@ ZMQTxWorkerModule::ZMQTxWorkerModule() : Module()
 void ZMQTxWorkerModule::event()
 {
   try {
+    std::unique_lock<std::mutex> lock(m_batchMutex);
     if (m_firstEvent) {
       m_streamer.initialize(m_param_compressionLevel, m_param_handleMergeable);
       m_zmqClient.initialize<ZMQ_PUSH>(m_param_xpubProxySocketName, m_param_xsubProxySocketName, m_param_socketName, false);
 
+      // the next event() call only happens when the next event arrives, so the latency is checked in a thread
+      if (m_param_batchSize > 1) {
+        LogSystem::Instance().enableThreadSafety();
+        m_flushThread = std::thread(&ZMQTxWorkerModule::flushOldBatches, this);
+      }
       m_firstEvent = false;
     }
 
     const auto& evtMessage = m_streamer.stream();
+    // the special first event is counted by the output, send it right away
+    if (m_param_batchSize > 1 and
+        not Environment::Instance().isZMQDAQFirstEvent(m_eventMetaData->getExperiment(), m_eventMetaData->getRun())) {
+      if (m_batch.empty()) {
+        m_flushCondition.notify_one();
+      }
+      m_batch.add(*evtMessage, *m_eventMetaData);
+      if (m_batch.size() >= m_param_batchSize) {
+        sendBatch();
+      }
+      return;
+    }
+
+    sendBatch();
     auto message = ZMQMessageFactory::createMessage(EMessageTypes::c_eventMessage, evtMessage);
     m_zmqClient.send(std::move(message));
     //    B2INFO ( "ZMQTxWorker : an event sent" );
@@ -46,10 +73,47 @@ void ZMQTxWorkerModule::event()
   }
 }
 
+void ZMQTxWorkerModule::sendBatch()
+{
+  if (m_batch.empty()) return;
+  auto message = ZMQMessageFactory::createMessage(EMessageTypes::c_eventBatchMessage, m_batch.pack(m_param_batchCompressionLevel));
+  m_zmqClient.send(std::move(message));
+}
+
+void ZMQTxWorkerModule::flushOldBatches()
+{
+  const std::chrono::milliseconds latency(m_param_maximalBatchLatency);
+  std::unique_lock<std::mutex> lock(m_batchMutex);
+  while (not m_stopFlushThread) {
+    if (m_batch.empty()) {
+      m_flushCondition.wait(lock);
+    } else if (m_batch.getAge() < latency) {
+      m_flushCondition.wait_for(lock, latency - m_batch.getAge());
+    } else {
+      try {
+        sendBatch();
+      } catch (zmq::error_t& ex) {
+        if (ex.num() != EINTR) {
+          B2ERROR("There was an error sending a batch from the Tx worker: " << ex.what());
+        }
+        // the remaining events are sent at the end of the run
+        return;
+      } catch (std::exception& ex) {
+        B2ERROR("There was an error sending a batch from the Tx worker: " << ex.what());
+        return;
+      }
+    }
+  }
+}
+
 void ZMQTxWorkerModule::endRun()
 {
+  std::unique_lock<std::mutex> lock(m_batchMutex);
   if (m_eventMetaData->isEndOfRun() != 1) return;
 
+  // the events of the run have to reach the output before the end run record
+  sendBatch();
+
   const auto& evtMessage = m_streamer.stream();
   auto message = ZMQMessageFactory::createMessage(EMessageTypes::c_eventMessage, evtMessage);
   m_zmqClient.send(std::move(message));
@@ -57,5 +121,18 @@ void ZMQTxWorkerModule::endRun()
 
 void ZMQTxWorkerModule::terminate()
 {
+  if (m_flushThread.joinable()) {
+    {
+      std::unique_lock<std::mutex> lock(m_batchMutex);
+      m_stopFlushThread = true;
+    }
+    m_flushCondition.notify_one();
+    m_flushThread.join();
+    LogSystem::Instance().disableThreadSafety();
+  }
+  if (m_zmqClient.isOnline()) {
+    sendBatch();
+  }
+  m_batch.printStatistics("ZMQTxWorker", m_param_batchSize);
   m_zmqClient.terminate();
 }
@@ -0,0 +1,86 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#pragma once
+
+#include <framework/dataobjects/EventMetaData.h>
+#include <framework/pcore/EvtMessage.h>
+
+#include <zmq.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Belle2 {
+
+  /**
+   * Several streamed events packed into the payload of one ZMQ message, optionally compressed.
+   *
+   * The sending side adds events until the batch is full or too old, then packs and sends it.
+   * The receiving side unpacks the payload and reads the events one by one with getEventBuffer().
+   * The event meta data of all events is part of the payload, so the output can confirm a whole
+   * batch with one message. The sending side also keeps statistics about the sent batches.
+   */
+  class EventBatch {
+  public:
+    /// Add a streamed event to the batch
+    void add(EvtMessage& message, const EventMetaData& eventMetaData);
+
+    /// Number of events in the batch
+    size_t size() const { return m_eventMetaData.size(); }
+
+    /// True if there are no events in the batch
+    bool empty() const { return m_eventMetaData.empty(); }
+
+    /// Time since the first event was added
+    std::chrono::milliseconds getAge() const;
+
+    /// Event meta data of the events in the batch
+    const std::vector<EventMetaData>& getEventMetaData() const { return m_eventMetaData; }
+
+    /**
+     * Pack all events into one message payload and clear the batch.
+     * @param compressionLevel ROOT compression setting (algorithm * 100 + level, e.g. 404 for LZ4 or 505 for ZSTD), 0 for none
+     */
+    zmq::message_t pack(int compressionLevel);
+
+    /// Replace the content of the batch by the events of a payload created with pack()
+    void unpack(const zmq::message_t& payload);
+
+    /// Buffer of the given event after unpack(), to be used with EvtMessage(char*)
+    char* getEventBuffer(size_t index) { return m_data.data() + m_offsets[index]; }
+
+    /// Print the statistics of the sent batches
+    void printStatistics(const std::string& name, unsigned int batchSize) const;
+
+  private:
+    /// Concatenated event buffers, each padded to 8 bytes
+    std::vector<char> m_data;
+    /// Start of each event in m_data
+    std::vector<size_t> m_offsets;
+    /// Event meta data of each event
+    std::vector<EventMetaData> m_eventMetaData;
+    /// Time when the first event was added
+    std::chrono::steady_clock::time_point m_firstEventTime;
+    /// Buffer for the compression
+    std::vector<char> m_compressionBuffer;
+
+    /// Number of sent batches
+    unsigned int m_nBatches = 0;
+    /// Number of sent events
+    unsigned int m_nEvents = 0;
+    /// Sum over the batches of the age when sent in ms
+    double m_sumLatency = 0;
+    /// Maximal age of a batch when sent in ms
+    double m_maxLatency = 0;
+    /// Sum of the uncompressed payload sizes
+    double m_rawBytes = 0;
+    /// Sum of the sent payload sizes
+    double m_sentBytes = 0;
+  };
+}
@@ -9,6 +9,7 @@
 
 #include <framework/dataobjects/EventMetaData.h>
 #include <string>
+#include <vector>
 
 namespace Belle2 {
 
@@ -36,5 +37,30 @@ namespace Belle2 {
              std::to_string(eventMetaData.getRun()) + ":" +
              std::to_string(eventMetaData.getExperiment());
     }
+
+    /// Deserialize a list of event meta data separated by ';'
+    static std::vector<EventMetaData> deserializeList(const std::string& stream)
+    {
+      std::vector<EventMetaData> list;
+      size_t start = 0;
+      while (start < stream.size()) {
+        size_t end = stream.find(';', start);
+        if (end == std::string::npos) end = stream.size();
+        list.push_back(deserialize(stream.substr(start, end - start)));
+        start = end + 1;
+      }
+      return list;
+    }
+
+    /// Serialize a list of event meta data, separated by ';'
+    static std::string serializeList(const std::vector<EventMetaData>& list)
+    {
+      std::string stream;
+      for (const EventMetaData& eventMetaData : list) {
+        if (not stream.empty()) stream += ";";
+        stream += serialize(eventMetaData);
+      }
+      return stream;
+    }
   };
 }
\ No newline at end of file
@@ -24,6 +24,8 @@ namespace Belle2 {
     std::unique_ptr<EvtMessage> stream(bool addPersistentDurability = true, bool streamTransientObjects = true);
     /// Read in a ZMQ message and rebuilt the data store from it.
     void read(std::unique_ptr<ZMQNoIdMessage> message);
+    /// Rebuild the data store from the buffer of an event message, e.g. from an EventBatch.
+    void read(char* eventBuffer);
 
   private:
     /// The data store streamer to use
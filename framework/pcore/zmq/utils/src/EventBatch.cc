@@ -0,0 +1,185 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/pcore/zmq/utils/EventBatch.h>
+#include <framework/logging/Logger.h>
+
+#include <RZip.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+using namespace Belle2;
+
+namespace {
+  /// Header at the beginning of the payload
+  struct BatchHeader {
+    /// Number of events
+    uint32_t nEvents;
+    /// 1 if the rest of the payload is compressed
+    uint32_t compressed;
+    /// Size of the rest of the payload before compression
+    uint64_t rawSize;
+  };
+
+  /// Event meta data as stored in the payload
+  struct BatchEntry {
+    /// Event number
+    uint32_t event;
+    /// Run number
+    int32_t run;
+    /// Experiment number
+    int32_t experiment;
+  };
+
+  /// ROOT compresses at most this many bytes at once
+  const int c_maxCompressionBlock = 0xffffff;
+
+  /// Round up to a multiple of 8 bytes
+  size_t padded(size_t size)
+  {
+    return (size + 7) / 8 * 8;
+  }
+}
+
+void EventBatch::add(EvtMessage& message, const EventMetaData& eventMetaData)
+{
+  if (empty()) {
+    m_firstEventTime = std::chrono::steady_clock::now();
+    m_data.clear();
+    m_offsets.clear();
+  }
+  const size_t offset = m_data.size();
+  m_offsets.push_back(offset);
+  m_data.resize(offset + padded(message.size()));
+  memcpy(m_data.data() + offset, message.buffer(), message.size());
+  m_eventMetaData.push_back(eventMetaData);
+}
+
+std::chrono::milliseconds EventBatch::getAge() const
+{
+  if (empty()) return std::chrono::milliseconds(0);
+  return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_firstEventTime);
+}
+
+zmq::message_t EventBatch::pack(int compressionLevel)
+{
+  const size_t metaDataSize = padded(size() * sizeof(BatchEntry));
+  std::vector<char> raw(metaDataSize + m_data.size(), 0);
+  for (size_t i = 0; i < size(); ++i) {
+    const EventMetaData& eventMetaData = m_eventMetaData[i];
+    const BatchEntry entry{eventMetaData.getEvent(), eventMetaData.getRun(), eventMetaData.getExperiment()};
+    memcpy(raw.data() + i * sizeof(BatchEntry), &entry, sizeof(BatchEntry));
+  }
+  std::copy(m_data.begin(), m_data.end(), raw.begin() + metaDataSize);
+
+  BatchHeader header{uint32_t(size()), 0, raw.size()};
+  const char* body = raw.data();
+  size_t bodySize = raw.size();
+
+  if (compressionLevel > 0) {
+    // compress block by block, give up if it does not get smaller
+    const int algorithm = compressionLevel / 100;
+    const int level = compressionLevel % 100;
+    m_compressionBuffer.resize(raw.size());
+    size_t in = 0;
+    size_t out = 0;
+    while (in < raw.size()) {
+      int nin = std::min<size_t>(raw.size() - in, c_maxCompressionBlock);
+      int nout = std::min<size_t>(m_compressionBuffer.size() - out, c_maxCompressionBlock);
+      int irep = 0;
+      R__zipMultipleAlgorithm(level, &nin, raw.data() + in, &nout, m_compressionBuffer.data() + out, &irep,
+                              (ROOT::RCompressionSetting::EAlgorithm::EValues) algorithm);
+      if (irep <= 0) break;
+      in += nin;
+      out += irep;
+    }
+    if (in == raw.size()) {
+      header.compressed = 1;
+      body = m_compressionBuffer.data();
+      bodySize = out;
+    }
+  }
+
+  zmq::message_t payload(sizeof(BatchHeader) + bodySize);
+  memcpy(payload.data(), &header, sizeof(BatchHeader));
+  memcpy(static_cast<char*>(payload.data()) + sizeof(BatchHeader), body, bodySize);
+
+  const double latency = getAge().count();
+  m_nBatches++;
+  m_nEvents += size();
+  m_sumLatency += latency;
+  m_maxLatency = std::max(m_maxLatency, latency);
+  m_rawBytes += raw.size();
+  m_sentBytes += bodySize;
+
+  m_data.clear();
+  m_offsets.clear();
+  m_eventMetaData.clear();
+  return payload;
+}
+
+void EventBatch::unpack(const zmq::message_t& payload)
+{
+  B2ASSERT("Event batch is too short", payload.size() >= sizeof(BatchHeader));
+  BatchHeader header;
+  memcpy(&header, payload.data(), sizeof(BatchHeader));
+  const char* body = static_cast<const char*>(payload.data()) + sizeof(BatchHeader);
+  const size_t bodySize = payload.size() - sizeof(BatchHeader);
+
+  if (header.compressed) {
+    m_compressionBuffer.resize(header.rawSize);
+    auto* in = (unsigned char*) body;
+    auto* end = in + bodySize;
+    size_t out = 0;
+    while (in < end and out < header.rawSize) {
+      int nin{0}, nout{0}, irep{0};
+      if (R__unzip_header(&nin, in, &nout) != 0 or nin > end - in or out + nout > header.rawSize) {
+        B2FATAL("Cannot uncompress event batch");
+      }
+      R__unzip(&nin, in, &nout, (unsigned char*)(m_compressionBuffer.data() + out), &irep);
+      if (irep <= 0) B2FATAL("Cannot uncompress event batch");
+      in += nin;
+      out += irep;
+    }
+    if (out != header.rawSize) B2FATAL("Event batch has the wrong size after uncompressing");
+    body = m_compressionBuffer.data();
+  } else if (bodySize != header.rawSize) {
+    B2FATAL("Event batch has the wrong size");
+  }
+
+  const size_t metaDataSize = padded(header.nEvents * sizeof(BatchEntry));
+  if (metaDataSize > header.rawSize) B2FATAL("Event batch is too short");
+  m_eventMetaData.clear();
+  for (size_t i = 0; i < header.nEvents; ++i) {
+    BatchEntry entry;
+    memcpy(&entry, body + i * sizeof(BatchEntry), sizeof(BatchEntry));
+    m_eventMetaData.emplace_back(entry.event, entry.run, entry.experiment);
+  }
+  m_data.assign(body + metaDataSize, body + header.rawSize);
+  m_offsets.clear();
+  size_t offset = 0;
+  for (size_t i = 0; i < header.nEvents; ++i) {
+    B2ASSERT("Event batch is too short", offset < m_data.size());
+    m_offsets.push_back(offset);
+    offset += padded(EvtMessage(m_data.data() + offset).size());
+  }
+}
+
+void EventBatch::printStatistics(const std::string& name, unsigned int batchSize) const
+{
+  if (m_nBatches == 0) return;
+  B2INFO(name << ": event batch statistics"
+         << LogVar("events", m_nEvents)
+         << LogVar("batches", m_nBatches)
+         << LogVar("mean fill", double(m_nEvents) / m_nBatches / batchSize)
+         << LogVar("mean latency [ms]", m_sumLatency / m_nBatches)
+         << LogVar("maximal latency [ms]", m_maxLatency)
+         << LogVar("compression ratio", m_rawBytes > 0 ? m_sentBytes / m_rawBytes : 1.));
+}
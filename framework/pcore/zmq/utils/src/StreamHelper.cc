@@ -40,7 +40,12 @@ std::unique_ptr<EvtMessage> StreamHelper::stream(bool addPersistentDurability, b
 
 void StreamHelper::read(std::unique_ptr<ZMQNoIdMessage> message)
 {
-  EvtMessage eventMessage(message->getMessagePartAsCharArray<ZMQNoIdMessage::c_data>());
+  read(message->getMessagePartAsCharArray<ZMQNoIdMessage::c_data>());
+}
+
+void StreamHelper::read(char* eventBuffer)
+{
+  EvtMessage eventMessage(eventBuffer);
   m_streamer->restoreDataStore(&eventMessage);
 
   if (m_randomGenerator.isValid()) {
@@ -100,6 +100,26 @@ namespace Belle2 {
     */
     static int getNumberProcesses();
 
+    /**
+     * Function to set number of threads for multithreaded processing.
+    */
+    static void setNumberThreads(int numThreads);
+
+    /**
+     * Function to get number of threads for multithreaded processing.
+    */
+    static int getNumberThreads();
+
+    /**
+     * Function to enable collection of performance counters for each module.
+    */
+    static void setPerfStats(bool perfStats);
+
+    /**
+     * Function to check whether performance counters are collected for each module.
+    */
+    static bool getPerfStats();
+
     /**
      * Function to set the path to the file where the pickled path is stored
      *
@@ -10,6 +10,7 @@
 
 #include <framework/datastore/DataStore.h>
 #include <framework/datastore/StoreAccessorBase.h>
+#include <framework/pybasf2/PyStoreArrayColumn.h>
 
 #include <TCollection.h> //for TIter
 
@@ -227,6 +228,16 @@ namespace Belle2 {
      */
     TObject* appendNew();
 
+    /** Copy the given data member of all objects into a contiguous column.
+     *
+     * In Python, use the column() and columns() methods instead which return
+     * numpy arrays using the buffer of the column.
+     *
+     * @param member Name of the data member, see PyStoreArrayColumn for the supported types
+     * @returns the column, invalid with the reason in getError() if the data member is not supported
+     */
+    PyStoreArrayColumn getColumn(const std::string& member) const;
+
     /** Raw access to the underlying TClonesArray.
      *
      *  \warning TClonesArray is dangerously easy to misuse. Whatever you do will probably
@@ -0,0 +1,87 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class TClass;
+class TClonesArray;
+
+namespace Belle2 {
+  /** Values of one data member of all objects in a StoreArray, stored contiguously.
+   *
+   * The values are copied out of the objects in C++ in one pass, so Python
+   * modules can work on whole columns without iterating over the objects.
+   * The buffer is exposed to numpy without a further copy by the
+   * pythonization of PyStoreArray:
+   *
+   * \code{.py}
+     from ROOT import Belle2
+     clusters = Belle2.PyStoreArray("ECLClusters")
+     logEnergy = clusters.column("m_logEnergy")  # numpy array with one entry per cluster
+     tracks = Belle2.PyStoreArray("TrackFitResults")
+     columns = tracks.columns("m_tau", "m_pValue")  # dict of numpy arrays, m_tau has the shape (n, 5)
+    \endcode
+   *
+   * Only data members of fundamental types and fixed size arrays of them are
+   * supported. Double32_t and Float16_t members are returned as they are kept
+   * in memory, i.e. as double and float.
+   */
+  class PyStoreArrayColumn {
+  public:
+    /** Create an invalid column */
+    PyStoreArrayColumn() = default;
+
+    /** Copy the given data member of all objects in the array.
+     *
+     * @param objClass Class of the objects in the array
+     * @param array    Array containing the objects, can be nullptr for an empty column
+     * @param member   Name of the data member, can be a member of a base class
+     */
+    PyStoreArrayColumn(TClass* objClass, const TClonesArray* array, const std::string& member);
+
+    /** Check whether the data member could be found and has a supported type */
+    bool isValid() const { return !m_typeString.empty(); }
+
+    /** Reason why the column is not valid */
+    const std::string& getError() const { return m_error; }
+
+    /** Name of the data member */
+    const std::string& getName() const { return m_name; }
+
+    /** Type of the values in the format of the numpy array interface, e.g. "<f4" */
+    const std::string& getTypeString() const { return m_typeString; }
+
+    /** Shape of the column: number of objects followed by the array dimensions of the member */
+    const std::vector<size_t>& getShape() const { return m_shape; }
+
+    /** Number of objects */
+    size_t getEntries() const { return m_shape.empty() ? 0 : m_shape[0]; }
+
+    /** Size of the buffer in bytes */
+    size_t getSize() const { return m_buffer.size(); }
+
+    /** Address of the first value, for the numpy array interface */
+    size_t getAddress() const { return reinterpret_cast<size_t>(m_buffer.data()); }
+
+  private:
+    /** Name of the data member */
+    std::string m_name;
+    /** Type of the values in the format of the numpy array interface, empty if invalid */
+    std::string m_typeString;
+    /** Reason why the column is not valid */
+    std::string m_error;
+    /** Number of objects followed by the array dimensions */
+    std::vector<size_t> m_shape;
+    /** Values of all objects */
+    std::vector<char> m_buffer;
+  };
+}
@@ -6,6 +6,7 @@
 #pragma link C++ nestedclasses;
 
 #pragma link C++ class Belle2::PyStoreArray-;
+#pragma link C++ class Belle2::PyStoreArrayColumn-;
 #pragma link C++ class Belle2::PyStoreObj-;
 #pragma link C++ class Belle2::PyDBArray-;
 #pragma link C++ class Belle2::PyDBObj-;
@@ -18,8 +18,10 @@
 #include <framework/database/Database.h>
 #include <framework/pcore/pEventProcessor.h>
 #include <framework/pcore/ZMQEventProcessor.h>
+#include <framework/core/ThreadedEventProcessor.h>
 #include <framework/pcore/zmq/utils/ZMQAddressUtils.h>
 #include <framework/utilities/FileSystem.h>
+#include <framework/utilities/PerformanceCounters.h>
 #include <framework/database/Configuration.h>
 
 #include <framework/logging/Logger.h>
@@ -126,13 +128,19 @@ void Framework::process(PathPtr startPath, long maxEvent)
     DataStore::Instance().setInitializeActive(true);
 
     auto& environment = Environment::Instance();
+    PerformanceCounters::setEnabled(environment.getPerfStats() and !environment.getNoStats());
 
     already_executed = true;
-    if (environment.getNumberProcesses() == 0) {
+    if (environment.getNumberProcesses() == 0 and environment.getNumberThreads() > 0) {
+      ThreadedEventProcessor processor(environment.getNumberThreads());
+      processor.process(startPath, maxEvent);
+    } else if (environment.getNumberProcesses() == 0) {
       EventProcessor processor;
       processor.setProfileModuleName(environment.getProfileModuleName());
       processor.process(startPath, maxEvent);
     } else {
+      if (environment.getNumberThreads() > 0)
+        B2WARNING("Both parallel processing and multithreading were requested, the number of threads is ignored.");
       if (environment.getUseZMQ()) {
         // If the user has not given any socket address, use a random one.
         if (environment.getZMQSocketAddress().empty()) {
@@ -177,6 +185,30 @@ int Framework::getNumberProcesses()
 }
 
 
+void Framework::setNumberThreads(int numThreads)
+{
+  Environment::Instance().setNumberThreads(numThreads);
+}
+
+
+int Framework::getNumberThreads()
+{
+  return Environment::Instance().getNumberThreads();
+}
+
+
+void Framework::setPerfStats(bool perfStats)
+{
+  Environment::Instance().setPerfStats(perfStats);
+}
+
+
+bool Framework::getPerfStats()
+{
+  return Environment::Instance().getPerfStats();
+}
+
+
 void Framework::setPicklePath(const std::string& path)
 {
   Environment::Instance().setPicklePath(path);
@@ -388,6 +420,41 @@ Parameters:
 )DOCSTRING");
   def("get_nprocesses", &Framework::getNumberProcesses, R"DOCSTRING(
 Gets number of worker processes for parallel processing. 0 disables parallel processing
+)DOCSTRING");
+  def("set_nthreads", &Framework::setNumberThreads, R"DOCSTRING(
+Sets number of threads for multithreaded processing: several events are
+processed at the same time within one process, sharing geometry, conditions
+data and magnetic field. Modules are only run for several events at once if
+they have the `ModulePropFlags.THREADSAFE` flag, all others are run by one
+thread at a time.
+
+.. warning:: So far only PruneDataStore and EventInfoPrinter have the flag,
+   so typical paths will not run faster than without threads yet.
+
+Can be overridden using the ``--threads`` argument to basf2. Ignored if
+parallel processing is enabled with `set_nprocesses`.
+
+Parameters:
+  nthreads (int): number of threads. 0 to disable multithreaded processing.
+)DOCSTRING");
+  def("get_nthreads", &Framework::getNumberThreads, R"DOCSTRING(
+Gets number of threads for multithreaded processing. 0 disables multithreaded processing
+)DOCSTRING");
+  def("set_perf_stats", &Framework::setPerfStats, R"DOCSTRING(
+Enable collection of hardware performance counters (cycles, instructions,
+last level cache misses, branch misses) and heap allocations for each module
+call. They are shown as an additional table when printing `basf2.statistics`
+and are available with `ModuleStatistics.perf_counter_sum`.
+
+Can be enabled using the ``--perf-stats`` argument to basf2. The hardware
+counters are only available if the kernel allows it (see
+``/proc/sys/kernel/perf_event_paranoid``), otherwise they are zero.
+
+Parameters:
+  enabled (bool): whether to collect the performance counters
+)DOCSTRING");
+  def("get_perf_stats", &Framework::getPerfStats, R"DOCSTRING(
+Whether hardware performance counters and heap allocations are collected for each module
 )DOCSTRING");
   def("set_streamobjs", &Framework::setStreamingObjects, R"DOCSTRING(
 Set the names of all DataStore objects which should be sent between the
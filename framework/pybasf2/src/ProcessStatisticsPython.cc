@@ -206,6 +206,44 @@ Time spent or memory used in any module function. This is the sum of all of the
   .export_values()
   ;
 
+  //Define enum for the performance counters in scope of class
+  enum_<PerformanceCounters::ECounter>("PerformanceCounters", R"DOCSTRING(
+Available performance counters, only collected if enabled with `basf2.set_perf_stats` or ``basf2 --perf-stats``
+
+.. attribute:: CYCLES
+
+CPU cycles
+
+.. attribute:: INSTRUCTIONS
+
+Retired instructions
+
+.. attribute:: CACHE_MISSES
+
+Last level cache misses
+
+.. attribute:: BRANCH_MISSES
+
+Mispredicted branches
+
+.. attribute:: ALLOCATIONS
+
+Number of heap allocations
+
+.. attribute:: ALLOCATED_BYTES
+
+Number of bytes allocated on the heap
+
+)DOCSTRING")
+  .value("CYCLES", PerformanceCounters::c_Cycles)
+  .value("INSTRUCTIONS", PerformanceCounters::c_Instructions)
+  .value("CACHE_MISSES", PerformanceCounters::c_CacheMisses)
+  .value("BRANCH_MISSES", PerformanceCounters::c_BranchMisses)
+  .value("ALLOCATIONS", PerformanceCounters::c_Allocations)
+  .value("ALLOCATED_BYTES", PerformanceCounters::c_AllocatedBytes)
+  .export_values()
+  ;
+
   {
     // the overloaded __str__ and __call__ give very confusing signatures so hand-craft doc string.
   docstring_options custom_options(true, false, false); //userdef, py sigs, c++ sigs
@@ -265,6 +303,22 @@ Parameters:
        "time_memory_corr(counter=StatisticCounters.TOTAL)\nReturn the correlaction factor between time and memory consumption")
   .def("calls", &ModuleStatistics::getCalls, bp::arg("counter") = ModuleStatistics::c_Total,
        "calls(counter=StatisticCounters.TOTAL)\nReturn the total number of calls")
+  .def("stall_time_sum", &ModuleStatistics::getStallTimeSum,
+       "stall_time_sum()\nReturn the total time spent waiting for input data (included in the event time), "
+       "e.g. by ``RootInput`` with ``prefetchEntries`` set")
+  .def("stall_time_mean", &ModuleStatistics::getStallTimeMean,
+       "stall_time_mean()\nReturn the mean time per event spent waiting for input data")
+  .def("named_time_sum", &ModuleStatistics::getNamedTimeSum, bp::arg("name"),
+       "named_time_sum(name)\nReturn the total time spent in the named part of the module (included in the time of "
+       "the calling method), e.g. ``fit`` for ``TreeFitter``")
+  .def("named_time_mean", &ModuleStatistics::getNamedTimeMean, bp::arg("name"),
+       "named_time_mean(name)\nReturn the mean time per event spent in the named part of the module")
+  .def("perf_counter_sum", &ModuleStatistics::getPerformanceCounterSum,
+       (bp::arg("perf_counter"), bp::arg("counter") = ModuleStatistics::c_Total),
+       "perf_counter_sum(perf_counter, counter=StatisticCounters.TOTAL)\nReturn the sum of the given `PerformanceCounters` value")
+  .def("perf_counter_mean", &ModuleStatistics::getPerformanceCounterMean,
+       (bp::arg("perf_counter"), bp::arg("counter") = ModuleStatistics::c_Total),
+       "perf_counter_mean(perf_counter, counter=StatisticCounters.TOTAL)\nReturn the mean of the given `PerformanceCounters` value per call")
   ;
 
   //Expose ProcessStatisticsPython instance as "statistics" object in pybasf2 module
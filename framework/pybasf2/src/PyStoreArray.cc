@@ -149,7 +149,10 @@ bool PyStoreArray::hasValidClass() const
 
 bool PyStoreArray::isValid() const
 {
-  return m_storeEntry and m_storeEntry->ptr;
+  if (not m_storeEntry) return false;
+  // the input module might only read the array now
+  m_storeEntry->ensureLoaded();
+  return m_storeEntry->ptr != nullptr;
 }
 
 TObject* PyStoreArray::operator [](int i) const
@@ -186,6 +189,14 @@ TObject* PyStoreArray::appendNew()
   }
 }
 
+PyStoreArrayColumn PyStoreArray::getColumn(const std::string& member) const
+{
+  ensureAttached();
+  // an array which was not created in this event gives an empty column
+  const TClonesArray* array = isValid() ? m_storeEntry->getPtrAsArray() : nullptr;
+  return PyStoreArrayColumn(array ? array->GetClass() : m_storeAccessor.getClass(), array, member);
+}
+
 TClonesArray* PyStoreArray::getPtr()
 {
   ensureCreated();
@@ -0,0 +1,107 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#include <framework/pybasf2/PyStoreArrayColumn.h>
+
+#include <TClass.h>
+#include <TClonesArray.h>
+#include <TDataMember.h>
+#include <TDataType.h>
+#include <TRealData.h>
+
+#include <cstdint>
+#include <cstring>
+
+using namespace Belle2;
+using namespace std;
+
+namespace {
+  /** Return the kind of the type in the numpy array interface ('f', 'i', 'u' or 'b'), 0 for unsupported types */
+  char getTypeKind(int type)
+  {
+    switch (type) {
+      case kFloat_t:
+      case kFloat16_t:
+      case kDouble_t:
+      case kDouble32_t:
+        return 'f';
+      case kChar_t:
+      case kShort_t:
+      case kInt_t:
+      case kLong_t:
+      case kLong64_t:
+        return 'i';
+      case kUChar_t:
+      case kUShort_t:
+      case kUInt_t:
+      case kULong_t:
+      case kULong64_t:
+        return 'u';
+      case kBool_t:
+        return 'b';
+      default:
+        return 0;
+    }
+  }
+
+  /** Byte order character of the numpy array interface for multi-byte values */
+  char getByteOrder()
+  {
+    const uint16_t one = 1;
+    char first;
+    memcpy(&first, &one, 1);
+    return first ? '<' : '>';
+  }
+}
+
+PyStoreArrayColumn::PyStoreArrayColumn(TClass* objClass, const TClonesArray* array, const std::string& member):
+  m_name(member)
+{
+  if (!objClass) {
+    m_error = "the class of the objects is unknown";
+    return;
+  }
+  const TRealData* realData = objClass->GetRealData(member.c_str());
+  const TDataMember* dataMember = realData ? realData->GetDataMember() : nullptr;
+  if (!dataMember) {
+    m_error = string("class ") + objClass->GetName() + " has no data member " + member;
+    return;
+  }
+  const TDataType* dataType = dataMember->GetDataType();
+  const char kind = dataType ? getTypeKind(dataType->GetType()) : 0;
+  if (dataMember->IsaPointer() or !(dataMember->IsBasic() or dataMember->IsEnum()) or !kind) {
+    m_error = string("data member ") + member + " of type " + dataMember->GetTypeName() +
+              " is not a fundamental type or fixed size array of one";
+    return;
+  }
+  // objects are returned as TObject pointers which might not point to the beginning of the object
+  const int tobjectOffset = objClass->GetBaseClassOffset(TObject::Class());
+  if (tobjectOffset < 0) {
+    m_error = string("class ") + objClass->GetName() + " does not inherit from TObject";
+    return;
+  }
+
+  const size_t valueSize = dataType->Size();
+  size_t rowSize = valueSize;
+  const size_t nEntries = array ? array->GetEntriesFast() : 0;
+  m_shape.push_back(nEntries);
+  for (int i = 0; i < dataMember->GetArrayDim(); ++i) {
+    m_shape.push_back(dataMember->GetMaxIndex(i));
+    rowSize *= m_shape.back();
+  }
+
+  // copy the values of all objects in one go
+  const long offset = realData->GetThisOffset() - tobjectOffset;
+  m_buffer.resize(nEntries * rowSize);
+  char* destination = m_buffer.data();
+  for (size_t i = 0; i < nEntries; ++i, destination += rowSize) {
+    const char* object = reinterpret_cast<const char*>(array->UncheckedAt(i));
+    memcpy(destination, object + offset, rowSize);
+  }
+
+  m_typeString = string(1, valueSize == 1 ? '|' : getByteOrder()) + kind + to_string(valueSize);
+}
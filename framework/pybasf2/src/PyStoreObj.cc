@@ -91,7 +91,10 @@ bool PyStoreObj::isOptional(const std::string& name)
 
 bool PyStoreObj::isValid() const
 {
-  return m_storeEntry and m_storeEntry->ptr;
+  if (not m_storeEntry) return false;
+  // the input module might only read the object now
+  m_storeEntry->ensureLoaded();
+  return m_storeEntry->ptr != nullptr;
 }
 
 bool PyStoreObj::hasValidClass() const
@@ -14,7 +14,8 @@ accidental changes to the conditions data.
 
 This module does not contain any public functions or variables, it just
 modifies the ROOT interfaces for PyDBObj and PyDBArray to only return read only
-objects.
+objects and adds numpy access to the data members of the objects in a
+PyStoreArray.
 """
 
 # we need to patch PyDBObj so lets import the ROOT cppyy backend.
@@ -99,6 +100,46 @@ def _PyDBArray__iter__(self):
         yield self[i]
 
 
+class _ColumnView:
+    """Expose the buffer of a Belle2::PyStoreArrayColumn to numpy without copying
+    it. The numpy array keeps a reference to this object, and thereby to the
+    column owning the buffer, as long as it exists."""
+
+    def __init__(self, column):
+        """Remember the column and describe its buffer"""
+        #: the column owning the buffer
+        self._column = column
+        #: numpy array interface pointing to the read only buffer of the column
+        self.__array_interface__ = {
+            "version": 3,
+            "typestr": str(column.getTypeString()),
+            "shape": tuple(int(n) for n in column.getShape()),
+            "data": (int(column.getAddress()), True),
+        }
+
+
+def _PyStoreArray_column(self, member):
+    """Return the values of the data member ``member`` of all objects in the
+    array as numpy array, with the array dimensions of the member as additional
+    axes. The values are copied out of the objects in C++ in one pass and the
+    array uses the buffer of this copy directly.
+
+    Raises a ValueError if the member does not exist or has no fundamental type.
+    """
+    import numpy
+    column = self.getColumn(member)
+    if not column.isValid():
+        raise ValueError(f"Cannot get column {member} of {self.getName()}: {column.getError()}")
+    if column.getSize() == 0:
+        return numpy.empty(tuple(int(n) for n in column.getShape()), dtype=str(column.getTypeString()))
+    return numpy.asarray(_ColumnView(column))
+
+
+def _PyStoreArray_columns(self, *members):
+    """Return a dictionary with the numpy arrays of the given data members, see `column`"""
+    return {member: _PyStoreArray_column(self, member) for member in members}
+
+
 @pythonization(namespace="Belle2")
 def _pythonize(klass, name):
     """Adjust the python interface of some Py* classes"""
@@ -120,6 +161,10 @@ def _pythonize(klass, name):
         klass.__getitem__ = lambda self, i: _make_tobject_const(self._get(i))
         # and supply an iterator
         klass.__iter__ = _PyDBArray__iter__
+    elif name == "PyStoreArray":
+        # allow columnar access to the data members as numpy arrays
+        klass.column = _PyStoreArray_column
+        klass.columns = _PyStoreArray_columns
     elif name == "PyStoreObj":
         # make sure that we can iterate over the items in the class
         # pointed to if it allows iteration
@@ -12,6 +12,7 @@
 #include <framework/database/DBArray.h>
 #include <framework/database/EventDependency.h>
 #include <framework/database/PayloadFile.h>
+#include <framework/database/PayloadCache.h>
 #include <framework/database/DBPointer.h>
 #include <framework/datastore/StoreObjPtr.h>
 #include <framework/dataobjects/EventMetaData.h>
@@ -25,8 +26,12 @@
 
 #include <gtest/gtest.h>
 
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include <filesystem>
 #include <list>
+#include <memory>
 #include <cstdio>
 
 using namespace std;
@@ -942,4 +947,57 @@ namespace {
     ptr = 3;
     EXPECT_FALSE(ptr.isValid());
   }
+
+  /** Payloads put into the shared cache can be read back, also by forked processes */
+  TEST(PayloadCacheTest, SharedBetweenProcesses)
+  {
+    auto& cache = Conditions::PayloadCache::getInstance();
+    EXPECT_FALSE(cache.isEnabled());
+    EXPECT_EQ(cache.get("abc", "TNamed"), nullptr);
+    cache.create(1024 * 1024);
+    ASSERT_TRUE(cache.isEnabled());
+
+    EXPECT_EQ(cache.get("abc", "TNamed"), nullptr);
+    TNamed named("TNamed", "some title");
+    cache.put("abc", "TNamed", &named);
+    cache.put("abc", "TNamed", &named);
+    auto stats = cache.getStatistics();
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_GT(stats.residentSize, 0u);
+
+    std::unique_ptr<TObject> copy(cache.get("abc", "TNamed"));
+    ASSERT_NE(copy, nullptr);
+    EXPECT_STREQ(copy->GetTitle(), "some title");
+    EXPECT_EQ(cache.get("abd", "TNamed"), nullptr);
+
+    //too large for the cache
+    TNamed large("TNamed", std::string(2 * 1024 * 1024, 'x').c_str());
+    cache.put("large", "TNamed", &large);
+    EXPECT_EQ(cache.get("large", "TNamed"), nullptr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      //child: find the payload of the parent, add another one
+      //do not use an ASSERT_TRUE or something here, or we'll run tests twice
+      std::unique_ptr<TObject> childCopy(cache.get("abc", "TNamed"));
+      TNamed other("TNamed", "other title");
+      cache.put("def", "TNamed", &other);
+      exit((childCopy and std::string(childCopy->GetTitle()) == "some title") ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+    std::unique_ptr<TObject> other(cache.get("def", "TNamed"));
+    ASSERT_NE(other, nullptr);
+    EXPECT_STREQ(other->GetTitle(), "other title");
+
+    stats = cache.getStatistics();
+    EXPECT_EQ(stats.entries, 2u);
+    EXPECT_EQ(stats.hits, 3u);
+    EXPECT_EQ(stats.misses, 3u);
+    cache.destroy();
+    EXPECT_FALSE(cache.isEnabled());
+  }
 }  // namespace
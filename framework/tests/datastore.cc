@@ -14,7 +14,10 @@
 
 #include <gtest/gtest.h>
 
+#include <TClonesArray.h>
+
 #include <algorithm>
+#include <thread>
 
 using namespace std;
 using namespace Belle2;
@@ -758,6 +761,169 @@ namespace {
     EXPECT_EQ(0, DataStore::Instance().getListOfObjects(TObject::Class(), DataStore::c_Persistent).size());
   }
 
+  TEST_F(DataStoreTest, NameHandles)
+  {
+    StoreArray<EventMetaData> evtData;
+    StoreArray<EventMetaData> evtData2;
+    StoreArray<EventMetaData> evtDataDifferentName("EventMetaDatas_2");
+    StoreArray<EventMetaData> evtDataDifferentDurability("", DataStore::c_Persistent);
+
+    //same name gives same handle, independent of durability
+    EXPECT_EQ(evtData.getNameHandle(), evtData2.getNameHandle());
+    EXPECT_EQ(evtData.getNameHandle(), evtDataDifferentDurability.getNameHandle());
+    EXPECT_NE(evtData.getNameHandle(), evtDataDifferentName.getNameHandle());
+    EXPECT_EQ(evtData.getName(), DataStore::Instance().getNameFromHandle(evtData.getNameHandle()));
+
+    //handle lookups find the same entries as before
+    EXPECT_EQ(evtData.getEntries(), 10);
+    EXPECT_EQ(evtDataDifferentName.getEntries(), 10);
+    EXPECT_EQ(evtDataDifferentDurability.getEntries(), 10);
+    EXPECT_EQ(DataStore::Instance().getEntry(evtData), DataStore::Instance().getEntry(evtData2));
+    EXPECT_NE(DataStore::Instance().getEntry(evtData), DataStore::Instance().getEntry(evtDataDifferentDurability));
+
+    //changing the name invalidates the cached handle
+    StoreArray<EventMetaData> renamed;
+    const int oldHandle = renamed.getNameHandle();
+    EXPECT_TRUE(renamed.isOptional("EventMetaDatas_2"));
+    EXPECT_NE(oldHandle, renamed.getNameHandle());
+    EXPECT_EQ(renamed.getNameHandle(), evtDataDifferentName.getNameHandle());
+
+    //handles stay valid after switching DataStore IDs and resetting the DataStore
+    const DataStore::StoreEntry* defaultEntry = DataStore::Instance().getEntry(evtData);
+    DataStore::Instance().createNewDataStoreID("foo");
+    DataStore::Instance().switchID("foo");
+    EXPECT_EQ(StoreArray<EventMetaData>().getEntries(), 10);
+    EXPECT_NE(defaultEntry, DataStore::Instance().getEntry(evtData));
+    DataStore::Instance().switchID("");
+    EXPECT_EQ(defaultEntry, DataStore::Instance().getEntry(evtData));
+
+    const int handle = evtData.getNameHandle();
+    DataStore::Instance().reset();
+    EXPECT_EQ(nullptr, DataStore::Instance().getEntry(evtData));
+    EXPECT_FALSE(StoreArray<EventMetaData>().isValid());
+    EXPECT_EQ(handle, StoreArray<EventMetaData>().getNameHandle());
+  }
+
+  TEST_F(DataStoreTest, MultiThreaded)
+  {
+    DataStore::Instance().createNewDataStoreID("thread0");
+    DataStore::Instance().createNewDataStoreID("thread1");
+    DataStore::setMultiThreaded(true);
+    //the same accessors see the contents of the DataStore ID of the calling thread
+    StoreObjPtr<EventMetaData> evtPtr;
+    StoreArray<EventMetaData> evtData;
+    EXPECT_EQ(evtPtr->getEvent(), 42u);
+
+    std::vector<std::thread> threads;
+    std::vector<int> failures(2, 0);
+    for (int i = 0; i < 2; i++) {
+      threads.emplace_back([&, i]() {
+        DataStore::Instance().switchID("thread" + std::to_string(i));
+        for (int j = 0; j < 1000; j++) {
+          evtPtr->setEvent(100 * i + j);
+          evtData.appendNew()->setEvent(i);
+          if (evtPtr->getEvent() != unsigned(100 * i + j) or evtData.getEntries() != 11 + j or evtData[10 + j]->getEvent() != unsigned(i))
+            failures[i]++;
+        }
+      });
+    }
+    for (std::thread& thread : threads)
+      thread.join();
+    EXPECT_EQ(0, failures[0]);
+    EXPECT_EQ(0, failures[1]);
+    EXPECT_TRUE("" == DataStore::Instance().currentID());
+    verifyContents();
+
+    //swapping exchanges the event data, but nothing else
+    DataStore::Instance().swapContentsWith("thread1", DataStore::c_Event);
+    EXPECT_EQ(evtPtr->getEvent(), 1099u);
+    EXPECT_EQ(evtData.getEntries(), 1010);
+    EXPECT_EQ(StoreArray<EventMetaData>("", DataStore::c_Persistent).getEntries(), 10);
+    DataStore::Instance().swapContentsWith("thread1", DataStore::c_Event);
+    verifyContents();
+
+    DataStore::setMultiThreaded(false);
+    DataStore::Instance().switchID("thread0");
+    EXPECT_EQ(evtPtr->getEvent(), 999u);
+    DataStore::Instance().switchID("");
+  }
+
+  /** Loader which creates an array with the given number of entries, like an input module reading it on first access */
+  class TestLoader : public StoreEntryLoader {
+  public:
+    /** Fill the array. */
+    void load(StoreEntry& entry) override
+    {
+      entry.loader = nullptr;
+      entry.recreate();
+      for (int i = 0; i < nEntries; ++i)
+        static_cast<EventMetaData*>(entry.getPtrAsArray()->ConstructedAt(i))->setEvent(100 + i);
+      ++calls;
+    }
+    int nEntries{5}; /**< number of entries to create */
+    int calls{0}; /**< number of load() calls */
+  };
+
+  TEST_F(DataStoreTest, LazyLoading)
+  {
+    StoreArray<EventMetaData> evtData;
+    StoreArray<EventMetaData> evtDataEmpty("Empty");
+    //attach both accessors before the entries are marked as not read
+    EXPECT_EQ(evtData.getEntries(), 10);
+    EXPECT_FALSE(evtDataEmpty.isValid());
+
+    TestLoader loader;
+    DataStore::StoreEntry* entry = DataStore::Instance().getEntry(evtData);
+    entry->ptr = nullptr;
+    entry->loader = &loader;
+    DataStore::StoreEntry* emptyEntry = DataStore::Instance().getEntry(evtDataEmpty);
+    emptyEntry->loader = &loader;
+    EXPECT_EQ(loader.calls, 0);
+
+    //already attached accessors read it on first access, but only once
+    EXPECT_EQ(evtData.getEntries(), 5);
+    EXPECT_EQ(evtData[4]->getEvent(), 104u);
+    EXPECT_EQ(loader.calls, 1);
+    EXPECT_TRUE(evtDataEmpty.isValid());
+    EXPECT_EQ(loader.calls, 2);
+
+    //invalidating the event means nothing has to be read anymore
+    entry->loader = &loader;
+    DataStore::Instance().invalidateData(DataStore::c_Event);
+    EXPECT_FALSE(evtData.isValid());
+    EXPECT_EQ(loader.calls, 2);
+  }
+
+  TEST_F(DataStoreTest, EndOfEventCallback)
+  {
+    StoreArray<EventMetaData> evtData;
+    DataStore::StoreEntry* entry = DataStore::Instance().getEntry(evtData);
+    TObject* taken = nullptr;
+    int calls = 0;
+    //take over the array of the event like RootOutput does
+    DataStore::Instance().addEndOfEventCallback(this, [&]() {
+      ++calls;
+      EXPECT_EQ(evtData.getEntries(), 10);
+      taken = entry->object;
+      entry->object = new TClonesArray(EventMetaData::Class());
+      entry->ptr = entry->object;
+    });
+
+    DataStore::Instance().invalidateData(DataStore::c_Persistent);
+    EXPECT_EQ(calls, 0);
+    DataStore::Instance().invalidateData(DataStore::c_Event);
+    EXPECT_EQ(calls, 1);
+    EXPECT_FALSE(evtData.isValid());
+    ASSERT_NE(taken, nullptr);
+    EXPECT_NE(taken, entry->object);
+    EXPECT_EQ(static_cast<TClonesArray*>(taken)->GetEntriesFast(), 10);
+    delete taken;
+
+    DataStore::Instance().removeEndOfEventCallbacks(this);
+    DataStore::Instance().invalidateData(DataStore::c_Event);
+    EXPECT_EQ(calls, 1);
+  }
+
   TEST_F(DataStoreTest, Assign)
   {
     StoreArray<EventMetaData> evtData;
@@ -0,0 +1,95 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#include <framework/io/EventIndex.h>
+#include <framework/utilities/TestHelpers.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+using namespace std;
+using namespace Belle2;
+
+namespace {
+  TEST(EventIndexTest, WriteAndFind)
+  {
+    TestHelpers::TempDirCreator tempDir;
+    // unsorted, with one event contained in two files
+    vector<EventIndex::Record> records = {
+      {1, 2, 5, 0, 3}, {1, 2, 3, 0, 1}, {0, 7, 10, 1, 0}, {1, 2, 4, 0, 2}, {1, 2, 3, 1, 1}, {2, 0, 1, 1, 2},
+    };
+    EventIndex::write("test.idx", {"file0.root", "file1.root"}, records);
+
+    EventIndex index;
+    EXPECT_FALSE(index.isOpen());
+    index.open("test.idx");
+    EXPECT_TRUE(index.isOpen());
+    EXPECT_EQ(index.getNumberOfEvents(), 6u);
+    EXPECT_EQ(index.getLfns(), vector<string>({"file0.root", "file1.root"}));
+
+    EventIndex::Location location = index.find(1, 2, 4);
+    EXPECT_EQ(location.lfn, "file0.root");
+    EXPECT_EQ(location.entry, 2);
+    location = index.find(0, 7, 10);
+    EXPECT_EQ(location.lfn, "file1.root");
+    EXPECT_EQ(location.entry, 0);
+    EXPECT_EQ(index.find(2, 0, 1).entry, 2);
+
+    // the same event in both files
+    EXPECT_EQ(index.findAll(1, 2, 3).size(), 2u);
+    EXPECT_EQ(index.find(1, 2, 3).lfn, "file0.root");
+    EXPECT_EQ(index.find(1, 2, 3, "file1.root").lfn, "file1.root");
+
+    // missing events
+    EXPECT_EQ(index.find(1, 2, 6).entry, -1);
+    EXPECT_EQ(index.find(1, 2, 5, "file1.root").entry, -1);
+    EXPECT_TRUE(index.findAll(3, 0, 0).empty());
+
+    index.close();
+    EXPECT_FALSE(index.isOpen());
+    EXPECT_EQ(index.find(1, 2, 4).entry, -1);
+  }
+
+  TEST(EventIndexTest, InvalidFiles)
+  {
+    TestHelpers::TempDirCreator tempDir;
+    EventIndex index;
+    EXPECT_THROW(index.open("missing.idx"), std::runtime_error);
+    {
+      ofstream out("invalid.idx");
+      out << "this is not an event index, just some text which is long enough";
+    }
+    EXPECT_THROW(index.open("invalid.idx"), std::runtime_error);
+    EXPECT_FALSE(index.isOpen());
+
+    // a record referring to a file which is not in the index
+    EventIndex::write("badfile.idx", {"file0.root"}, {{1, 2, 3, 0, 1}, {1, 2, 4, 1, 0}});
+    EXPECT_THROW(index.open("badfile.idx"), std::runtime_error);
+    EXPECT_FALSE(index.isOpen());
+
+    // a number of records which overflows the size check
+    EventIndex::write("overflow.idx", {"file0.root"}, {{1, 2, 3, 0, 1}});
+    {
+      fstream file("overflow.idx", ios::in | ios::out | ios::binary);
+      // the number of records follows magic, version and number of files in the header
+      file.seekp(16);
+      const uint64_t nRecords = numeric_limits<uint64_t>::max() / 20 + 1;
+      file.write(reinterpret_cast<const char*>(&nRecords), sizeof(nRecords));
+    }
+    EXPECT_THROW(index.open("overflow.idx"), std::runtime_error);
+    EXPECT_FALSE(index.isOpen());
+
+    // an empty index is fine
+    EventIndex::write("empty.idx", {}, {});
+    index.open("empty.idx");
+    EXPECT_EQ(index.getNumberOfEvents(), 0u);
+    EXPECT_EQ(index.find(0, 0, 0).entry, -1);
+  }
+}  // namespace
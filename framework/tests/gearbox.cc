@@ -7,8 +7,10 @@
  **************************************************************************/
 #include <framework/gearbox/Gearbox.h>
 #include <framework/gearbox/GearDir.h>
+#include <framework/utilities/TestHelpers.h>
 
 #include <gtest/gtest.h>
+#include <fstream>
 #include <string>
 #include <queue>
 
@@ -36,4 +38,56 @@ namespace {
     }
     gb.close();
   }
+
+  /** Test that queries are answered from the query cache as long as the xml files are unchanged */
+  TEST(GearBox, QueryCache)
+  {
+    TestHelpers::TempDirCreator tempDir;
+    auto writeFile = [](const string & name, const string & content) {
+      ofstream file(name);
+      file << content;
+    };
+    writeFile("main.xml", "<Detector xmlns:xi=\"http://www.w3.org/2001/XInclude\"><Name>Test</Name>"
+              "<xi:include href=\"sub.xml\"/></Detector>");
+    writeFile("sub.xml", "<Sub><Value unit=\"cm\">5</Value><Value>6</Value></Sub>");
+
+    Gearbox& gb = Gearbox::getInstance();
+    gb.setBackends({"file:" + tempDir.getTempDir() + "/"});
+    gb.setCacheDirectory(tempDir.getTempDir() + "/cache");
+    gb.open("main.xml");
+    EXPECT_FALSE(gb.isUsingCache());
+    EXPECT_EQ("Test", gb.getString("/Detector/Name"));
+    EXPECT_EQ(2, gb.getNumberNodes("/Detector/Sub/Value"));
+    EXPECT_EQ("cm", gb.getStringWithUnit("/Detector/Sub/Value").second);
+    gb.close();
+
+    // same document again: answered from the cache, the document is only parsed for new paths
+    gb.open("main.xml");
+    EXPECT_TRUE(gb.isUsingCache());
+    EXPECT_EQ("Test", gb.getString("/Detector/Name"));
+    EXPECT_EQ(2, gb.getNumberNodes("/Detector/Sub/Value"));
+    EXPECT_EQ("5", gb.getString("/Detector/Sub/Value"));
+    EXPECT_EQ(0, gb.getNumberNodes("/Detector/Missing"));
+    EXPECT_EQ(6, GearDir("/Detector/Sub/Value[2]").getInt());
+    gb.close();
+    gb.open("main.xml");
+    EXPECT_TRUE(gb.isUsingCache());
+    EXPECT_EQ(6, GearDir("/Detector/Sub/Value[2]").getInt());
+    gb.close();
+
+    // changing an included file or an override invalidates the cache
+    writeFile("sub.xml", "<Sub><Value>7</Value></Sub>");
+    gb.open("main.xml");
+    EXPECT_FALSE(gb.isUsingCache());
+    EXPECT_EQ(1, gb.getNumberNodes("/Detector/Sub/Value"));
+    gb.close();
+    gb.addOverride({"/Detector/Name", "Other", "", false});
+    gb.open("main.xml");
+    EXPECT_FALSE(gb.isUsingCache());
+    EXPECT_EQ("Other", gb.getString("/Detector/Name"));
+    gb.close();
+
+    gb.clearOverrides();
+    gb.setCacheDirectory("");
+  }
 }  // namespace
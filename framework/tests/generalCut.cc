@@ -27,9 +27,13 @@ namespace {
     /// Function of the variable which always returns the value of the object.
     double function(const MockObjectType* object) const
     {
+      ++calls;
       return object->value;
     }
 
+    /// Number of times the function was called.
+    mutable int calls = 0;
+
     /// Name of the variable.
     const std::string name = "mocking_variable";
   };
@@ -268,6 +272,107 @@ namespace {
     a = MockGeneralCut::compile("[1 < 2 < 3] or [[ 2 < 4] and [  mocking_variable < 4.4231 and [1 < 3 and 4 < mocking_variable]]]");
     EXPECT_EQ(a->decompile(),
               "[1 < 2 < 3] or [[2 < 4] and [mocking_variable < 4.4231 and [1 < 3 and 4 < mocking_variable]]]");
+
+    // constant folding must not change the decompiled cut
+    a = MockGeneralCut::compile("1 < 2 and mocking_variable > 2 * 2");
+    EXPECT_EQ(a->decompile(), "1 < 2 and mocking_variable > 2 * 2");
+  }
+
+  /// Test for the general cut: constant subexpressions and repeated variables are evaluated only once.
+  TEST(GeneralCutTest, evaluateOnce)
+  {
+    MockObjectType testObject;
+    const MockVariableType& variable = MockVariableManager::Instance().m_mocking_variable;
+
+    std::unique_ptr<MockGeneralCut> a = MockGeneralCut::compile("1 < 2 and 2 * 2 < mocking_variable < 5 and mocking_variable != 3");
+    variable.calls = 0;
+    EXPECT_TRUE(a->check(&testObject));
+    EXPECT_EQ(variable.calls, 1);
+
+    a = MockGeneralCut::compile("2 < 1 or mocking_variable > 2 ** 3");
+    variable.calls = 0;
+    EXPECT_FALSE(a->check(&testObject));
+    EXPECT_EQ(variable.calls, 1);
+
+    a = MockGeneralCut::compile("1 < 2 or mocking_variable > 4");
+    variable.calls = 0;
+    EXPECT_TRUE(a->check(&testObject));
+    EXPECT_EQ(variable.calls, 0);
+
+    // errors in constant expressions are still raised when checking
+    a = MockGeneralCut::compile("mocking_variable > 1 and -true");
+    EXPECT_THROW(a->check(&testObject), std::runtime_error);
+  }
+
+  /// Test for the general cut: share the variable values between several cuts on the same object.
+  TEST(GeneralCutTest, variableCache)
+  {
+    MockObjectType testObject;
+    MockObjectType otherObject;
+    otherObject.value = 1.0;
+    const MockVariableType& variable = MockVariableManager::Instance().m_mocking_variable;
+
+    std::unique_ptr<MockGeneralCut> a = MockGeneralCut::compile("mocking_variable > 4");
+    std::unique_ptr<MockGeneralCut> b = MockGeneralCut::compile("mocking_variable < 4");
+    MockGeneralCut::VariableCache cache;
+
+    variable.calls = 0;
+    EXPECT_TRUE(a->check(&testObject, cache));
+    EXPECT_FALSE(b->check(&testObject, cache));
+    EXPECT_EQ(variable.calls, 1);
+
+    // a different object invalidates the cache
+    EXPECT_FALSE(a->check(&otherObject, cache));
+    EXPECT_TRUE(b->check(&otherObject, cache));
+    EXPECT_EQ(variable.calls, 2);
+
+    // the same object with a changed value needs an explicit clear
+    otherObject.value = 5.0;
+    cache.clear();
+    EXPECT_TRUE(a->check(&otherObject, cache));
+    EXPECT_EQ(variable.calls, 3);
+  }
+
+  /// Test for the general cut: reordering the clauses by their measured cost does not change the result.
+  TEST(GeneralCutTest, adaptiveOrdering)
+  {
+    const std::string cut = "[mocking_variable > 3 or mocking_variable < 1] and mocking_variable != 2 and "
+                            "[mocking_variable ** 2 > 9 or not mocking_variable > -1]";
+    std::unique_ptr<MockGeneralCut> a = MockGeneralCut::compile(cut);
+    std::unique_ptr<MockGeneralCut> b = MockGeneralCut::compile(cut, true);
+    EXPECT_EQ(a->decompile(), b->decompile());
+
+    MockObjectType testObject;
+    for (int i = 0; i < 5000; ++i) {
+      testObject.value = (i % 50) / 5.0 - 5.0;
+      EXPECT_EQ(a->check(&testObject), b->check(&testObject)) << "value " << testObject.value;
+    }
+  }
+
+  /// Test for the general cut: ranges of a variable required by the top level comparisons.
+  TEST(GeneralCutTest, requiredRange)
+  {
+    const MockVariableType* variable = &MockVariableManager::Instance().m_mocking_variable;
+    const double inf = std::numeric_limits<double>::infinity();
+
+    std::unique_ptr<MockGeneralCut> a = MockGeneralCut::compile("1.5 < mocking_variable < 2 * 2");
+    EXPECT_EQ(a->getRequiredRange(variable), std::make_pair(1.5, 4.0));
+
+    a = MockGeneralCut::compile("mocking_variable > 1 and 3 >= mocking_variable and [mocking_variable < 2 or mocking_variable > 5]");
+    EXPECT_EQ(a->getRequiredRange(variable), std::make_pair(1.0, 3.0));
+
+    a = MockGeneralCut::compile("mocking_variable > 1 and mocking_variable > 2 and mocking_variable ** 2 < 9");
+    EXPECT_EQ(a->getRequiredRange(variable), std::make_pair(2.0, inf));
+
+    // comparisons which are not necessary for the cut to pass do not constrain the range
+    a = MockGeneralCut::compile("mocking_variable > 1 or mocking_variable < -1");
+    EXPECT_EQ(a->getRequiredRange(variable), std::make_pair(-inf, inf));
+    a = MockGeneralCut::compile("not mocking_variable > 1");
+    EXPECT_EQ(a->getRequiredRange(variable), std::make_pair(-inf, inf));
+    a = MockGeneralCut::compile("mocking_variable == 1 and mocking_variable != 2");
+    EXPECT_EQ(a->getRequiredRange(variable), std::make_pair(-inf, inf));
+    a = MockGeneralCut::compile("1 < 2");
+    EXPECT_EQ(a->getRequiredRange(variable), std::make_pair(-inf, inf));
   }
 
 
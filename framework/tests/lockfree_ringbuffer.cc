@@ -0,0 +1,176 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/pcore/LockFreeRingBuffer.h>
+
+#include <gtest/gtest.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <numeric>
+#include <vector>
+
+using namespace std;
+using namespace Belle2;
+
+namespace {
+  /** Entries come out in the order they went in, also when wrapping around the end of the buffer. */
+  TEST(LockFreeRingBufferTest, InsertRemove)
+  {
+    LockFreeRingBuffer rb(100000);
+    rb.txAttached();
+    EXPECT_FALSE(rb.isDead());
+    EXPECT_TRUE(rb.allRxWaiting());
+
+    std::vector<int> buf(2000);
+    std::vector<int> out(2000);
+    for (int i = 0; i < 1000; i++) {
+      const int size = 1 + (i * 37) % 2000;
+      buf[0] = i;
+      ASSERT_EQ(size, rb.insq(buf.data(), size));
+      if (i % 3 == 0) {
+        //keep a few entries in the buffer
+        ASSERT_EQ(size, rb.insq(buf.data(), size));
+        ASSERT_EQ(size, rb.remq(out.data()));
+        EXPECT_EQ(i, out[0]);
+      }
+      EXPECT_EQ(size, rb.remq(out.data()));
+      EXPECT_EQ(i, out[0]);
+      EXPECT_FALSE(rb.allRxWaiting());
+    }
+    EXPECT_EQ(0, rb.remq(out.data()));
+    EXPECT_EQ(0, rb.numq());
+    EXPECT_TRUE(rb.allRxWaiting());
+
+    rb.txDetached();
+    EXPECT_TRUE(rb.isDead());
+  }
+
+  /** insq() fails if the buffer is full, and succeeds again once entries were picked up. */
+  TEST(LockFreeRingBufferTest, FullAndBatch)
+  {
+    LockFreeRingBuffer rb(100000);
+    rb.txAttached();
+    std::vector<int> buf(1000, 42);
+    int n = 0;
+    while (rb.insq(buf.data(), buf.size()) > 0)
+      n++;
+    EXPECT_GT(n, 10);
+    EXPECT_EQ(n, rb.numq());
+    EXPECT_THROW(rb.insq(buf.data(), 100000), std::runtime_error);
+
+    std::vector<int> batch;
+    std::vector<int> sizes;
+    EXPECT_EQ(5, rb.remqBatch(batch, sizes, 5));
+    ASSERT_EQ(5u, sizes.size());
+    EXPECT_EQ(5000u, batch.size());
+    EXPECT_EQ(42, batch.back());
+    EXPECT_EQ(n - 5, rb.numq());
+    EXPECT_EQ(1000, rb.insq(buf.data(), buf.size()));
+
+    rb.kill();
+    EXPECT_TRUE(rb.isDead());
+    EXPECT_EQ(0, rb.remq(batch.data()));
+  }
+
+  /** acquireq() hands out buffers directly from the shared memory, their space is only reused after releaseq(). */
+  TEST(LockFreeRingBufferTest, AcquireRelease)
+  {
+    LockFreeRingBuffer rb(10000);
+    rb.txAttached();
+    rb.setReadBatchSize(4);
+    std::vector<int> buf(1000);
+    int n = 0;
+    std::iota(buf.begin(), buf.end(), n);
+    while (rb.insq(buf.data(), buf.size()) > 0)
+      std::iota(buf.begin(), buf.end(), ++n);
+    ASSERT_GT(n, 4);
+
+    int size = 0;
+    const int* data = rb.acquireq(size);
+    ASSERT_NE(nullptr, data);
+    EXPECT_EQ(1000, size);
+    EXPECT_EQ(0, data[0]);
+    EXPECT_EQ(999, data[999]);
+    //the whole batch is claimed, but nothing was released yet
+    EXPECT_EQ(n - 4, rb.numq());
+    EXPECT_FALSE(rb.allRxWaiting());
+    EXPECT_EQ(-1, rb.insq(buf.data(), buf.size()));
+
+    for (int i = 1; i < n; i++) {
+      data = rb.acquireq(size);
+      ASSERT_NE(nullptr, data);
+      EXPECT_EQ(i, data[0]);
+    }
+    rb.releaseq();
+    EXPECT_EQ(nullptr, rb.acquireq(size));
+    EXPECT_EQ(n, rb.nremq());
+    EXPECT_TRUE(rb.allRxWaiting());
+    EXPECT_EQ(1000, rb.insq(buf.data(), buf.size()));
+  }
+
+  /** One writer, several reading processes: every entry is picked up exactly once. */
+  TEST(LockFreeRingBufferTest, MultipleReaders)
+  {
+    const int nEntries = 20000;
+    const int nReaders = 3;
+    LockFreeRingBuffer in(50000);
+    LockFreeRingBuffer out(50000);
+    in.txAttached();
+
+    std::vector<pid_t> readers;
+    for (int i = 0; i < nReaders; i++) {
+      if (pid_t pid = fork()) {
+        readers.push_back(pid);
+      } else {
+        //child process: sum up everything we get, send the sum back
+        //do not use an ASSERT_TRUE or something here, or we'll run tests twice
+        out.txAttached();
+        std::vector<int> buf(100);
+        long sum = 0;
+        while (!in.isDead()) {
+          int size = in.remq(buf.data());
+          if (size == 0) {
+            in.waitForEntries();
+            continue;
+          }
+          if (size != 1 + buf[0] % 100)
+            exit(1);
+          sum += buf[0];
+        }
+        int sumBuf[2] = {int(sum >> 31), int(sum & 0x7fffffff)};
+        while (out.insq(sumBuf, 2) < 0)
+          out.waitForSpace();
+        out.txDetached();
+        exit(0);
+      }
+    }
+
+    std::vector<int> buf(100);
+    for (int i = 0; i < nEntries; i++) {
+      buf[0] = i;
+      while (in.insq(buf.data(), 1 + i % 100) < 0)
+        in.waitForSpace();
+    }
+    in.txDetached();
+
+    long sum = 0;
+    for (pid_t pid : readers) {
+      int status = 0;
+      waitpid(pid, &status, 0);
+      EXPECT_TRUE(WIFEXITED(status));
+      EXPECT_EQ(0, WEXITSTATUS(status));
+    }
+    int sumBuf[2];
+    while (out.remq(sumBuf) > 0)
+      sum += (long(sumBuf[0]) << 31) + sumBuf[1];
+    EXPECT_EQ(long(nEntries) * (nEntries - 1) / 2, sum);
+    EXPECT_EQ(nEntries, in.nremq());
+  }
+}  // namespace
@@ -13,6 +13,8 @@
 
 #include <gtest/gtest.h>
 
+#include <cstring>
+
 using namespace std;
 using namespace Belle2;
 
@@ -77,4 +79,46 @@ namespace {
       }
     }
   }
+
+  /** encode_msg_reuse() produces the same messages as encode_msg(), also when called repeatedly */
+  TEST(MsgHandlerTest, reuseBuffer)
+  {
+    TClonesArray longarray("Belle2::EventMetaData");
+    longarray.ExpandCreate(100);
+    TNamed c("abc", "def");
+    for (int complevel : {0, 1}) {
+      MsgHandler handler(complevel);
+      MsgHandler reuseHandler(complevel);
+      for (int i = 0; i < 3; i++) {
+        handler.add(&longarray, "mcparticles");
+        handler.add(&c, "named");
+        EvtMessage* msg = handler.encode_msg(MSG_EVENT);
+
+        reuseHandler.clear();
+        reuseHandler.add(&longarray, "mcparticles");
+        reuseHandler.add(&c, "named");
+        ASSERT_EQ(2, reuseHandler.getObjectSizes().size());
+        EvtMessage* reuseMsg = reuseHandler.encode_msg_reuse(MSG_EVENT);
+
+        ASSERT_EQ(msg->size(), reuseMsg->size());
+        EXPECT_EQ(msg->paddedSize(), reuseMsg->paddedSize());
+        EXPECT_EQ(msg->type(), reuseMsg->type());
+        EXPECT_EQ(msg->getMsgFlags(), reuseMsg->getMsgFlags());
+        EXPECT_EQ(0, memcmp(msg->msg(), reuseMsg->msg(), msg->msg_size()));
+
+        MsgHandler handler2;
+        vector<TObject*> objs;
+        vector<string> names;
+        handler2.decode_msg(reuseMsg, objs, names);
+        ASSERT_EQ(2, objs.size());
+        EXPECT_EQ("mcparticles", names[0]);
+        EXPECT_EQ("named", names[1]);
+        EXPECT_EQ(reuseHandler.getObjectSizes(), handler2.getObjectSizes());
+        EXPECT_EQ(2, handler2.getObjectDecodeTimes().size());
+        for (auto o : objs) delete o;
+        delete reuseMsg;
+        delete msg;
+      }
+    }
+  }
 }  // namespace
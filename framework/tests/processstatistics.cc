@@ -7,6 +7,7 @@
  **************************************************************************/
 #include <framework/core/ProcessStatistics.h>
 #include <framework/core/Module.h>
+#include <framework/utilities/PerformanceCounters.h>
 
 #include <gtest/gtest.h>
 
@@ -90,4 +91,67 @@ namespace {
     EXPECT_EQ(1, a.getStatistics(&dummyMod).getCalls());
     EXPECT_FLOAT_EQ(sum, a.getGlobal().getTimeSum());
   }
+
+  TEST(ProcessStatisticsTest, PerformanceCounters)
+  {
+    ProcessStatistics a;
+    a.startModule();
+    a.stopModule(nullptr, ModuleStatistics::c_Event);
+    EXPECT_FALSE(a.getStatistics(nullptr).hasPerformanceCounters());
+
+    PerformanceCounters::setEnabled(true);
+    DummyModule dummyMod;
+    std::vector<int>* data{nullptr};
+    for (int i = 0; i < 2; ++i) {
+      a.startModule();
+      data = new std::vector<int>(1000);
+      a.stopModule(&dummyMod, ModuleStatistics::c_Event);
+      delete data;
+    }
+    PerformanceCounters::setEnabled(false);
+
+    const ModuleStatistics& stats = a.getStatistics(&dummyMod);
+    EXPECT_TRUE(stats.hasPerformanceCounters());
+    EXPECT_GE(stats.getPerformanceCounterSum(PerformanceCounters::c_Allocations, ModuleStatistics::c_Event), 2);
+    EXPECT_GE(stats.getPerformanceCounterMean(PerformanceCounters::c_AllocatedBytes), 1000 * sizeof(int));
+    EXPECT_EQ(stats.getPerformanceCounterSum(PerformanceCounters::c_Allocations, ModuleStatistics::c_Init), 0);
+    const double allocations = stats.getPerformanceCounterSum(PerformanceCounters::c_Allocations);
+    EXPECT_NE(a.getStatisticsString().find("Allocs"), std::string::npos);
+
+    // counters are merged like all other values
+    ProcessStatistics b;
+    b.getStatistics(nullptr);
+    b.getStatistics(&dummyMod);
+    b.merge(&a);
+    EXPECT_DOUBLE_EQ(allocations, b.getStatistics(&dummyMod).getPerformanceCounterSum(PerformanceCounters::c_Allocations));
+
+    a.clear();
+    EXPECT_FALSE(a.getStatistics(&dummyMod).hasPerformanceCounters());
+  }
+
+  TEST(ProcessStatisticsTest, NamedTimes)
+  {
+    DummyModule dummyMod;
+    ProcessStatistics a;
+    a.startModule();
+    a.stopModule(&dummyMod, ModuleStatistics::c_Event);
+    a.startModule();
+    a.stopModule(&dummyMod, ModuleStatistics::c_Event);
+    a.getStatistics(&dummyMod).addNamedTime("fit", 3);
+    a.getStatistics(&dummyMod).addNamedTime("fit", 1);
+    const ModuleStatistics& stats = a.getStatistics(&dummyMod);
+    EXPECT_DOUBLE_EQ(4, stats.getNamedTimeSum("fit"));
+    EXPECT_DOUBLE_EQ(2, stats.getNamedTimeMean("fit"));
+    EXPECT_EQ(0, stats.getNamedTimeSum("other"));
+
+    // named times are merged by name
+    ProcessStatistics b;
+    b.getStatistics(&dummyMod).addNamedTime("other", 5);
+    b.merge(&a);
+    EXPECT_DOUBLE_EQ(4, b.getStatistics(&dummyMod).getNamedTimeSum("fit"));
+    EXPECT_DOUBLE_EQ(5, b.getStatistics(&dummyMod).getNamedTimeSum("other"));
+
+    a.clear();
+    EXPECT_TRUE(a.getStatistics(&dummyMod).getNamedTimes().empty());
+  }
 }  // namespace
@@ -11,6 +11,7 @@
 import basf2
 from ROOT import Belle2
 import unittest
+import numpy as np
 
 # @cond internal_test
 
@@ -136,6 +137,43 @@ class PythonDataStoreTests(unittest.TestCase):
         otherObject2 = obj2.getRelated("OtherRelationsObjects")
         self.assertEqual(otherObject, otherObject2)
 
+    # numpy access to the data members
+    def test_PyStoreArray_columns(self):
+        array = Belle2.PyStoreArray(Belle2.EventMetaData.Class(), "EventMetaDatas")
+        self.assertTrue(array.registerInDataStore())
+
+        # array not created yet, columns are empty but have the correct type
+        self.assertEqual((0,), array.column("m_event").shape)
+        self.assertEqual(np.dtype("uint32"), array.column("m_event").dtype)
+
+        for i in range(5):
+            obj = array.appendNew()
+            obj.setEvent(i + 1)
+            obj.setExperiment(-i)
+            obj.setTime(2**40 + i)
+            obj.setGeneratedWeight(0.5 * i)
+
+        columns = array.columns("m_event", "m_experiment", "m_time", "m_generatedWeight")
+        self.assertEqual(np.dtype("int32"), columns["m_experiment"].dtype)
+        self.assertEqual(np.dtype("uint64"), columns["m_time"].dtype)
+        self.assertEqual(np.dtype("float64"), columns["m_generatedWeight"].dtype)
+        for i, obj in enumerate(array):
+            self.assertEqual(obj.getEvent(), columns["m_event"][i])
+            self.assertEqual(obj.getExperiment(), columns["m_experiment"][i])
+            self.assertEqual(obj.getTime(), columns["m_time"][i])
+            self.assertEqual(obj.getGeneratedWeight(), columns["m_generatedWeight"][i])
+
+        # the arrays are copies, changing the objects does not change them
+        array[0].setEvent(100)
+        self.assertEqual(1, columns["m_event"][0])
+        self.assertEqual(100, array.column("m_event")[0])
+
+        # only fundamental types are supported
+        with self.assertRaises(ValueError):
+            array.column("m_parentLfn")
+        with self.assertRaisesRegex(ValueError, "m_doesNotExist"):
+            array.column("m_doesNotExist")
+
 
 if __name__ == "__main__":
     basf2.B2INFO("Following error messages are expected, please ignore.")
@@ -0,0 +1,238 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#include <framework/datastore/RelationIndex.h>
+#include <framework/dataobjects/EventMetaData.h>
+#include <framework/dataobjects/ProfileInfo.h>
+#include <framework/logging/Logger.h>
+#include <framework/utilities/TestHelpers.h>
+
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/member.hpp>
+
+#include <TRandom.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+using namespace std;
+using namespace Belle2;
+
+namespace {
+  /** Element of the index */
+  typedef RelationIndexContainer<EventMetaData, ProfileInfo>::Element Element;
+
+  /** The boost::multi_index based index RelationIndexContainer used before, as reference for results and timing. */
+  typedef boost::multi_index::multi_index_container <
+  Element,
+  boost::multi_index::indexed_by <
+  boost::multi_index::ordered_non_unique <
+  boost::multi_index::member<Element, const EventMetaData*, &Element::from>
+  >,
+  boost::multi_index::ordered_non_unique <
+  boost::multi_index::member<Element, const ProfileInfo*, &Element::to>
+  >
+  >
+  > ReferenceIndex;
+
+  /** Compare the index to a multi_index based reference implementation on a large random relation. */
+  class RelationIndexTest : public ::testing::Test {
+  protected:
+    /** fill StoreArrays and a random relation between them */
+    void SetUp() override
+    {
+      DataStore::Instance().setInitializeActive(true);
+      evtData.registerInDataStore();
+      profileData.registerInDataStore();
+      evtData.registerRelationTo(profileData);
+      DataStore::Instance().setInitializeActive(false);
+
+      for (int i = 0; i < c_nFrom; ++i)
+        evtData.appendNew();
+      for (int i = 0; i < c_nTo; ++i)
+        profileData.appendNew();
+
+      //roughly like MCParticles -> CDCHits: every to-object has a single from-object, some have two
+      RelationArray relation(evtData, profileData);
+      for (int i = 0; i < c_nTo; ++i) {
+        relation.add(gRandom->Integer(c_nFrom), i, i);
+        if (i % 10 == 0)
+          relation.add(gRandom->Integer(c_nFrom), i, -i);
+      }
+    }
+
+    /** clear datastore */
+    void TearDown() override
+    {
+      DataStore::Instance().reset();
+    }
+
+    /** Build the reference index the same way RelationIndexContainer::rebuild() does. */
+    void buildReference(ReferenceIndex& index) const
+    {
+      index.clear();
+      RelationArray relation(evtData, profileData);
+      for (int i = 0; i < relation.getEntries(); ++i) {
+        const RelationElement& r = relation[i];
+        for (size_t j = 0; j < r.getSize(); ++j) {
+          index.insert(Element(r.getFromIndex(), r.getToIndex(j), evtData[r.getFromIndex()], profileData[r.getToIndex(j)],
+                               r.getWeight(j)));
+        }
+      }
+    }
+
+    /** Number of objects on the from side. */
+    const static int c_nFrom = 500;
+    /** Number of objects on the to side. */
+    const static int c_nTo = 20000;
+
+    StoreArray<EventMetaData> evtData; /**< from side */
+    StoreArray<ProfileInfo> profileData; /**< to side */
+  };
+
+  /** Both implementations must give the same elements in the same order. */
+  TEST_F(RelationIndexTest, SameAsReference)
+  {
+    ReferenceIndex reference;
+    buildReference(reference);
+    RelationIndex<EventMetaData, ProfileInfo> relIndex;
+    ASSERT_EQ(reference.size(), relIndex.size());
+
+    for (const EventMetaData& from : evtData) {
+      const auto& expected = reference.get<0>().equal_range(&from);
+      const auto& result = relIndex.getElementsFrom(from);
+      ASSERT_EQ(static_cast<size_t>(std::distance(expected.first, expected.second)), result.size());
+      auto it = result.begin();
+      for (auto ref = expected.first; ref != expected.second; ++ref, ++it) {
+        EXPECT_EQ(ref->to, it->to);
+        EXPECT_EQ(ref->indexTo, it->indexTo);
+        EXPECT_EQ(ref->weight, it->weight);
+      }
+    }
+    for (const ProfileInfo& to : profileData) {
+      const auto& expected = reference.get<1>().equal_range(&to);
+      const auto& result = relIndex.getElementsTo(to);
+      ASSERT_EQ(static_cast<size_t>(std::distance(expected.first, expected.second)), result.size());
+      auto it = result.begin();
+      for (auto ref = expected.first; ref != expected.second; ++ref, ++it) {
+        EXPECT_EQ(ref->from, it->from);
+        EXPECT_EQ(ref->indexFrom, it->indexFrom);
+        EXPECT_EQ(ref->weight, it->weight);
+      }
+    }
+
+    //adding relations through the DataStore extends the existing index
+    DataStore::addRelationFromTo(evtData[0], profileData[0], 42.0);
+    DataStore::addRelationFromTo(evtData[0], profileData[1], 43.0);
+    RelationIndex<EventMetaData, ProfileInfo> extendedIndex;
+    EXPECT_EQ(reference.size() + 2, extendedIndex.size());
+    const auto& fromFirst = extendedIndex.getElementsFrom(evtData[0]);
+    ASSERT_GE(fromFirst.size(), 2u);
+    EXPECT_FLOAT_EQ(42.0, (fromFirst.end() - 2)->weight);
+    EXPECT_FLOAT_EQ(43.0, (fromFirst.end() - 1)->weight);
+    EXPECT_FLOAT_EQ(42.0, extendedIndex.getElementsTo(profileData[0]).back().weight);
+  }
+
+  /** After the relation changed the index is rebuilt in the kept buffers and still matches the reference. */
+  TEST_F(RelationIndexTest, RebuildAfterModification)
+  {
+    ReferenceIndex reference;
+    for (int iEvent = 0; iEvent < 3; ++iEvent) {
+      //new event: the relation is changed and the index is rebuilt on next access
+      RelationArray relation(evtData, profileData);
+      relation.add(gRandom->Integer(c_nFrom), gRandom->Integer(c_nTo), iEvent);
+      relation.setModified(true);
+      buildReference(reference);
+
+      RelationIndex<EventMetaData, ProfileInfo> relIndex;
+      ASSERT_EQ(reference.size(), relIndex.size());
+      for (const ProfileInfo& to : profileData) {
+        const auto& expected = reference.get<1>().equal_range(&to);
+        const auto& result = relIndex.getElementsTo(to);
+        ASSERT_EQ(static_cast<size_t>(std::distance(expected.first, expected.second)), result.size());
+        auto it = result.begin();
+        for (auto ref = expected.first; ref != expected.second; ++ref, ++it) {
+          EXPECT_EQ(ref->from, it->from);
+          EXPECT_EQ(ref->weight, it->weight);
+        }
+      }
+      for (const EventMetaData& from : evtData) {
+        const auto& expected = reference.get<0>().equal_range(&from);
+        const auto& result = relIndex.getElementsFrom(from);
+        ASSERT_EQ(static_cast<size_t>(std::distance(expected.first, expected.second)), result.size());
+        auto it = result.begin();
+        for (auto ref = expected.first; ref != expected.second; ++ref, ++it) {
+          EXPECT_EQ(ref->to, it->to);
+          EXPECT_EQ(ref->weight, it->weight);
+        }
+      }
+    }
+  }
+
+  /** Compare build and lookup time of both implementations.
+   *
+   * Only informational, so it is disabled by default. Run it with --gtest_also_run_disabled_tests.
+   */
+  TEST_F(RelationIndexTest, DISABLED_Benchmark)
+  {
+    const int nEvents = 20;
+    typedef std::chrono::high_resolution_clock clock;
+
+    ReferenceIndex reference;
+    double referenceSum = 0;
+    const auto referenceStart = clock::now();
+    for (int i = 0; i < nEvents; ++i) {
+      buildReference(reference);
+      for (const ProfileInfo& to : profileData)
+        for (const Element& e : boost::make_iterator_range(reference.get<1>().equal_range(&to)))
+          referenceSum += e.weight;
+      for (const EventMetaData& from : evtData)
+        for (const Element& e : boost::make_iterator_range(reference.get<0>().equal_range(&from)))
+          referenceSum += e.weight;
+    }
+    const std::chrono::duration<double, std::milli> referenceTime = clock::now() - referenceStart;
+
+    double sum = 0;
+    const auto start = clock::now();
+    for (int i = 0; i < nEvents; ++i) {
+      //new event: index is cleared and rebuilt on next access
+      RelationArray(evtData, profileData).setModified(true);
+      RelationIndex<EventMetaData, ProfileInfo> relIndex;
+      for (const ProfileInfo& to : profileData)
+        for (const Element& e : relIndex.getElementsTo(to))
+          sum += e.weight;
+      for (const EventMetaData& from : evtData)
+        for (const Element& e : relIndex.getElementsFrom(from))
+          sum += e.weight;
+    }
+    const std::chrono::duration<double, std::milli> time = clock::now() - start;
+
+    EXPECT_DOUBLE_EQ(referenceSum, sum);
+    B2INFO("RelationIndex build + lookup of " << c_nTo << " relations: multi_index "
+           << referenceTime.count() / nEvents << " ms/event, sorted vectors " << time.count() / nEvents << " ms/event");
+  }
+
+#ifdef RELATIONINDEX_CHECK_ITERATORS
+  /** Using a range after the index was changed is detected. */
+  TEST_F(RelationIndexTest, InvalidatedRange)
+  {
+    RelationIndex<EventMetaData, ProfileInfo> relIndex;
+    const auto& toFirst = relIndex.getElementsTo(profileData[0]);
+    ASSERT_FALSE(toFirst.empty());
+    //sorting the other side doesn't move the elements of this one
+    relIndex.getElementsFrom(evtData[0]);
+    EXPECT_NO_B2FATAL(toFirst.front());
+
+    //the relation changed, so the next access rebuilds the index
+    DataStore::addRelationFromTo(evtData[0], profileData[0], 42.0);
+    RelationIndex<EventMetaData, ProfileInfo> rebuiltIndex;
+    EXPECT_B2FATAL(toFirst.front());
+  }
+#endif
+}  // namespace
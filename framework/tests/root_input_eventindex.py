@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+
+##########################################################################
+# basf2 (Belle II Analysis Software Framework)                           #
+# Author: The Belle II Collaboration                                     #
+#                                                                        #
+# See git log for contributors and copyright holders.                    #
+# This file is licensed under LGPL-3.0, see LICENSE.md.                  #
+##########################################################################
+
+"""Check that RootInput finds events in all input files with an index created by b2file-index"""
+
+import os
+import subprocess
+import basf2
+from b2test_utils import clean_working_directory, configure_logging_for_tests, skip_test_if_light
+from ROOT import Belle2
+
+skip_test_if_light()  # light builds don't know about PXD hits
+configure_logging_for_tests()
+basf2.conditions.disable_globaltag_replay()
+
+# @cond internal_test
+
+
+class EventContent(basf2.Module):
+    """Collect event numbers, file and content of each event"""
+
+    def __init__(self):
+        """Create an empty list of events"""
+        super().__init__()
+        #: (experiment, run, event, number of events in current file, number of simhits) for all events
+        self.events = []
+
+    def event(self):
+        """Remember the current event"""
+        meta = Belle2.PyStoreObj('EventMetaData').obj()
+        nevents = Belle2.PyStoreObj('FileMetaData', 1).obj().getNEvents()
+        simhits = Belle2.PyStoreArray('PXDSimHits')
+        self.events.append((meta.getExperiment(), meta.getRun(), meta.getEvent(), nevents, len(simhits)))
+
+
+def read_events(**parameters):
+    """Read events with the given RootInput parameters and return the content of all events"""
+    main = basf2.Path()
+    main.add_module('RootInput', **parameters)
+    content = main.add_module(EventContent())
+    basf2.process(main)
+    return content.events
+
+
+inputfiles = [os.path.abspath(basf2.find_file(f'framework/tests/chaintest_{i}.root')) for i in [1, 2]]
+
+with clean_working_directory():
+    # the index refers to the files by LFN, so register them in a local file catalog to be found with indexedEvents
+    os.environ["BELLE2_FILECATALOG"] = os.path.abspath("Belle2FileCatalog.xml")
+    for filename in inputfiles:
+        subprocess.check_call(["b2file-catalog-add", filename])
+    subprocess.check_call(["b2file-index", "-o", "chaintest.index"] + inputfiles)
+
+    reference = read_events(inputFileNames=inputfiles)
+    # event numbers appear in both files, only events which are unique can be found by experiment, run and event
+    ids = [event[:3] for event in reference]
+    unique = [entry for entry, event in enumerate(ids) if ids.count(event) == 1]
+    files = {reference[entry][3] for entry in unique}
+    assert len(files) == 2, "test files changed, need unique events in both of them"
+
+    # events of both files, not in the order of the files
+    selected = unique[::2][::-1]
+    indexed = read_events(eventIndexFile="chaintest.index", indexedEvents=[ids[entry] for entry in selected])
+    expected = [reference[entry] for entry in sorted(selected)]
+    assert indexed == expected, f"indexedEvents read the wrong events: {indexed} != {expected}"
+
+    # the last unique event is in the second file which the TTreeIndex of the first file doesn't know about
+    for entry in [unique[1], unique[-1]]:
+        skipped = read_events(inputFileNames=inputfiles, eventIndexFile="chaintest.index", skipToEvent=list(ids[entry]))
+        assert skipped == reference[entry:], f"skipToEvent={ids[entry]} did not continue with entry {entry}"
+
+# @endcond
@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+
+##########################################################################
+# basf2 (Belle II Analysis Software Framework)                           #
+# Author: The Belle II Collaboration                                     #
+#                                                                        #
+# See git log for contributors and copyright holders.                    #
+# This file is licensed under LGPL-3.0, see LICENSE.md.                  #
+##########################################################################
+
+"""Check that RootInput returns the same events with and without lazy loading of the branches"""
+
+import basf2
+from b2test_utils import configure_logging_for_tests, skip_test_if_light
+from ROOT import Belle2
+
+skip_test_if_light()  # light builds don't know about PXD hits
+configure_logging_for_tests()
+basf2.conditions.disable_globaltag_replay()
+
+
+class EventContent(basf2.Module):
+    """Collect event number and content of each event, only looking at the arrays every few events"""
+
+    def __init__(self, every):
+        """Create an empty list of events"""
+        super().__init__()
+        #: only look at the content of every n-th event
+        self.every = every
+        #: (event number, number of simhits, relations) for all events
+        self.events = []
+
+    def event(self):
+        """Remember the current event"""
+        event = Belle2.PyStoreObj('EventMetaData').obj().getEvent()
+        if event % self.every != 0:
+            self.events.append((event, None, None))
+            return
+        simhits = Belle2.PyStoreArray('PXDSimHits')
+        relations = sum(len(hit.getRelationsFrom("PXDTrueHits")) for hit in simhits)
+        self.events.append((event, len(simhits), relations))
+
+
+def read_events(every, **parameters):
+    """Read the test files with the given RootInput parameters and return the content of the events"""
+    inputfiles = [
+        basf2.find_file('framework/tests/chaintest_1.root'),
+        basf2.find_file('framework/tests/chaintest_2.root')
+    ]
+    main = basf2.Path()
+    main.add_module('RootInput', inputFileNames=inputfiles, **parameters)
+    content = main.add_module(EventContent(every))
+    basf2.process(main)
+    return content.events
+
+
+for every in [1, 3]:
+    reference = read_events(every)
+    assert len(reference) > 0
+    lazy = read_events(every, lazyLoading=True)
+    assert reference == lazy, f"different events with lazyLoading: {reference} != {lazy}"
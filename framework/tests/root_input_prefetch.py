@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+
+##########################################################################
+# basf2 (Belle II Analysis Software Framework)                           #
+# Author: The Belle II Collaboration                                     #
+#                                                                        #
+# See git log for contributors and copyright holders.                    #
+# This file is licensed under LGPL-3.0, see LICENSE.md.                  #
+##########################################################################
+
+"""Check that RootInput returns the same events with and without prefetching"""
+
+import basf2
+from b2test_utils import configure_logging_for_tests, skip_test_if_light
+from ROOT import Belle2
+
+skip_test_if_light()  # light builds don't know about PXD hits
+configure_logging_for_tests()
+basf2.conditions.disable_globaltag_replay()
+
+
+class EventContent(basf2.Module):
+    """Collect event number, file and content of each event"""
+
+    def __init__(self):
+        """Create an empty list of events"""
+        super().__init__()
+        #: (event number, number of events in current file, number of simhits, relations) for all events
+        self.events = []
+
+    def event(self):
+        """Remember the current event"""
+        event = Belle2.PyStoreObj('EventMetaData').obj().getEvent()
+        nevents = Belle2.PyStoreObj('FileMetaData', 1).obj().getNEvents()
+        simhits = Belle2.PyStoreArray('PXDSimHits')
+        relations = sum(len(hit.getRelationsFrom("PXDTrueHits")) for hit in simhits)
+        self.events.append((event, nevents, len(simhits), relations))
+
+
+def read_events(**parameters):
+    """Read the test files with the given RootInput parameters and return the content of all events"""
+    inputfiles = [
+        basf2.find_file('framework/tests/chaintest_1.root'),
+        basf2.find_file('framework/tests/chaintest_2.root')
+    ]
+    main = basf2.Path()
+    main.add_module('RootInput', inputFileNames=inputfiles, **parameters)
+    content = main.add_module(EventContent())
+    basf2.process(main)
+    return content.events
+
+
+for sequences in [[], ['0,3:4,10:100', '1:2,4,12:13']]:
+    reference = read_events(entrySequences=sequences)
+    assert len(reference) > 0
+    # without prefetching the stall time is the time spent reading the entries
+    input_statistics = [stats for stats in basf2.statistics.modules if stats.name == 'RootInput'][0]
+    assert input_statistics.stall_time_sum() > 0, "no stall time recorded without prefetching"
+
+    for prefetch in [1, 4, 100]:
+        prefetched = read_events(entrySequences=sequences, prefetchEntries=prefetch)
+        assert reference == prefetched, f"different events with prefetchEntries={prefetch}: {reference} != {prefetched}"
+
+    # parallel decompression of the branches with ROOT implicit multi-threading
+    prefetched = read_events(entrySequences=sequences, prefetchEntries=4, prefetchThreads=2)
+    assert reference == prefetched, f"different events with prefetchThreads=2: {reference} != {prefetched}"
@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+
+##########################################################################
+# basf2 (Belle II Analysis Software Framework)                           #
+# Author: The Belle II Collaboration                                     #
+#                                                                        #
+# See git log for contributors and copyright holders.                    #
+# This file is licensed under LGPL-3.0, see LICENSE.md.                  #
+##########################################################################
+
+"""Check that RootOutput writes the same files with and without the writer thread"""
+
+import basf2
+import ROOT
+from ROOT import Belle2
+from b2test_utils import clean_working_directory, safe_process
+import subprocess
+import json
+
+# @cond internal_test
+
+
+class CreateDummyData(basf2.Module):
+    """Create some random data to have event size not be too small"""
+
+    def __init__(self, size):
+        super().__init__()
+        self.size = size // 8
+        self.chunk_data = Belle2.PyStoreObj(Belle2.TestChunkData.Class())
+
+    def initialize(self):
+        self.chunk_data.registerInDataStore()
+
+    def event(self):
+        # leave some events without data to check that invalid objects stay invalid
+        if Belle2.PyStoreObj('EventMetaData').obj().getEvent() % 7 != 0:
+            self.chunk_data.assign(Belle2.TestChunkData(self.size))
+
+
+class CheckDummyData(basf2.Module):
+    """Check that modules after RootOutput still see the objects of the event"""
+
+    def __init__(self):
+        super().__init__()
+        #: the dummy data
+        self.chunk_data = Belle2.PyStoreObj(Belle2.TestChunkData.Class())
+
+    def event(self):
+        created = Belle2.PyStoreObj('EventMetaData').obj().getEvent() % 7 != 0
+        assert self.chunk_data.isValid() == created, "RootOutput changed the objects of the event"
+
+
+def get_metadata(filename):
+    """Return the file metadata as dictionary"""
+    meta = subprocess.check_output(["b2file-metadata-show", "--json", filename])
+    return json.loads(meta)
+
+
+def get_content(filename):
+    """Return event numbers and data of all events in the file"""
+    f = ROOT.TFile.Open(filename)
+    tree = f.Get("tree")
+    # the data member is private, so just compare the sum of the data in each event
+    n = tree.Draw("Sum$(TestChunkData.m_chunkData)", "", "goff")
+    sums = [tree.GetV1()[i] for i in range(n)]
+    content = []
+    for event, data_sum in zip(tree, sums):
+        valid = not event.TestChunkData.TestBit(ROOT.kInvalidObject)
+        content.append((event.EventMetaData.getEvent(), valid, data_sum))
+    f.Close()
+    return content
+
+
+def write_files(name, **parameters):
+    """Write 550 events with RootOutput split into files of 3 MB and return metadata and content of the files"""
+    basf2.set_random_seed("something important")
+    path = basf2.Path()
+    path.add_module("EventInfoSetter", evtNumList=550)
+    path.add_module(CreateDummyData(1024 * 10))  # 10 kb dummy data
+    path.add_module("RootOutput", outputFileName=f"{name}.root", updateFileCatalog=False,
+                    compressionAlgorithm=0, compressionLevel=0, outputSplitSize=3, **parameters)
+    path.add_module(CheckDummyData())
+    assert safe_process(path) == 0, "RootOutput failed"
+    files = [f"{name}.f0000{i}.root" for i in range(2)]
+    result = []
+    for filename in files:
+        meta = get_metadata(filename)
+        result.append(({key: meta[key] for key in ["nEvents", "nFullEvents", "eventLow", "eventHigh"]}, get_content(filename)))
+    return result
+
+
+if __name__ == "__main__":
+    basf2.logging.log_level = basf2.LogLevel.ERROR
+    basf2.logging.enable_summary(False)
+    with clean_working_directory():
+        reference = write_files("sync")
+        for depth, threads in [(1, 0), (16, 0), (16, 2)]:
+            result = write_files(f"async{depth}_{threads}", writerQueueDepth=depth, writerThreads=threads)
+            for (meta, content), (ref_meta, ref_content) in zip(result, reference):
+                assert meta == ref_meta, f"metadata differs with writerQueueDepth={depth}: {meta} != {ref_meta}"
+                assert content == ref_content, f"content differs with writerQueueDepth={depth}, writerThreads={threads}"
+
+# @endcond
@@ -0,0 +1,131 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/pcore/SeqFile.h>
+#include <framework/utilities/TestHelpers.h>
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Belle2;
+
+namespace {
+  /** Create a record whose first word is its size, followed by the given number of copies of a character. */
+  vector<char> makeRecord(int length, char content)
+  {
+    const int size = sizeof(int) + length;
+    vector<char> record(size, content);
+    memcpy(record.data(), &size, sizeof(int));
+    return record;
+  }
+
+  /** Writes a file with a StreamerInfo record and a number of event records of different sizes. */
+  class SeqFileBlocksTest : public ::testing::Test {
+  protected:
+    /** Write the file with the given block settings, no block compression gives the classic format */
+    void writeFile(const SeqFileBlockSettings& settings)
+    {
+      vector<char> streamerInfo = makeRecord(100, 's');
+      SeqFile file(m_fileName, "w", streamerInfo.data(), streamerInfo.size(), false, settings);
+      ASSERT_GT(file.status(), 0);
+      for (int i = 0; i < c_nEvents; ++i) {
+        vector<char> record = makeRecord(1 + (i * 97) % 3000, 'a' + i % 26);
+        EXPECT_EQ((int)record.size(), file.write(record.data()));
+      }
+    }
+
+    /** Check that the records from first to last are read back correctly, followed by the end of the file if last is the last record */
+    void checkRecords(SeqFile& file, int first, int last = c_nEvents)
+    {
+      vector<char> buffer(10000);
+      for (int i = first; i < last; ++i) {
+        vector<char> expected = makeRecord(1 + (i * 97) % 3000, 'a' + i % 26);
+        ASSERT_EQ((int)expected.size(), file.read(buffer.data(), buffer.size())) << "record " << i;
+        EXPECT_EQ(0, memcmp(expected.data(), buffer.data(), expected.size())) << "record " << i;
+      }
+      if (last == c_nEvents) {
+        EXPECT_EQ(0, file.read(buffer.data(), buffer.size()));
+      }
+    }
+
+    /** Number of event records in the file */
+    static const int c_nEvents = 500;
+    /** ensure the test runs inside a temporary directory */
+    TestHelpers::TempDirCreator m_tempDir;
+    /** Name of the test file */
+    std::string m_fileName{"test.sroot"};
+  };
+
+  /** Files in the block format are read back with and without threads, compressed or not */
+  TEST_F(SeqFileBlocksTest, RoundTrip)
+  {
+    for (int compression : {404, 505}) {
+      for (int nThreads : {0, 3}) {
+        writeFile({compression, 10000, nThreads});
+        SeqFile file(m_fileName, "r", nullptr, 0, false, {0, 0, nThreads});
+        ASSERT_GT(file.status(), 0);
+        vector<char> buffer(10000);
+        EXPECT_EQ(104, file.read(buffer.data(), buffer.size()));
+        checkRecords(file, 0);
+      }
+    }
+    // identical records compress well
+    EXPECT_LT(std::filesystem::file_size(m_fileName), c_nEvents * 1500u);
+  }
+
+  /** Jump to records in the middle of blocks, at block boundaries and at the end */
+  TEST_F(SeqFileBlocksTest, Seek)
+  {
+    writeFile({404, 10000, 2});
+    SeqFile file(m_fileName, "r", nullptr, 0, false, {0, 0, 2});
+    for (int record : {250, 1, 17, 0}) {
+      ASSERT_TRUE(file.seek(record + 1));
+      checkRecords(file, record, record + 30);
+    }
+    EXPECT_FALSE(file.seek(c_nEvents + 2));
+    ASSERT_TRUE(file.seek(c_nEvents + 1));
+    vector<char> buffer(10000);
+    EXPECT_EQ(0, file.read(buffer.data(), buffer.size()));
+
+    SeqFile other(m_fileName, "r");
+    ASSERT_TRUE(other.seek(c_nEvents));
+    checkRecords(other, c_nEvents - 1);
+  }
+
+  /** Files without the index at the end can still be read up to the last complete block */
+  TEST_F(SeqFileBlocksTest, Truncated)
+  {
+    writeFile({505, 10000, 0});
+    const auto size = std::filesystem::file_size(m_fileName);
+    std::filesystem::resize_file(m_fileName, size - 20);
+    SeqFile file(m_fileName, "r");
+    ASSERT_GT(file.status(), 0);
+    vector<char> buffer(10000);
+    EXPECT_EQ(104, file.read(buffer.data(), buffer.size()));
+    checkRecords(file, 0);
+  }
+
+  /** Classic files without blocks are still read, but cannot be used for seeking */
+  TEST_F(SeqFileBlocksTest, Classic)
+  {
+    writeFile({0, 0, 0});
+    size_t size = 104;
+    for (int i = 0; i < c_nEvents; ++i) size += makeRecord(1 + (i * 97) % 3000, 'a').size();
+    EXPECT_EQ(size, std::filesystem::file_size(m_fileName));
+    SeqFile file(m_fileName, "r", nullptr, 0, false, {0, 0, 2});
+    EXPECT_FALSE(file.seek(1));
+    vector<char> buffer(10000);
+    EXPECT_EQ(104, file.read(buffer.data(), buffer.size()));
+    checkRecords(file, 0);
+  }
+}
@@ -0,0 +1,230 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/pcore/SharedHistograms.h>
+
+#include <gtest/gtest.h>
+
+#include <TH1F.h>
+#include <TH2D.h>
+#include <TProfile.h>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace Belle2;
+
+namespace {
+  /** Histograms filled in different stripes add up to the same totals as one histogram filled with everything. */
+  TEST(SharedHistogramsTest, Stripes)
+  {
+    SharedHistograms shared(1 << 20, 4);
+    ASSERT_TRUE(shared.isValid());
+    const int stripe1 = shared.acquireStripe();
+    const int stripe2 = shared.acquireStripe();
+    EXPECT_NE(stripe1, stripe2);
+
+    TH1F reference("reference", "", 10, 0, 10);
+    TH1F h1("h1", "", 10, 0, 10);
+    TH1F h2("h2", "", 10, 0, 10);
+    h1.SetDirectory(nullptr);
+    h2.SetDirectory(nullptr);
+    reference.SetDirectory(nullptr);
+    h1.Fill(1.5);
+    reference.Fill(1.5);
+    ASSERT_TRUE(shared.attach(&h1, "/h", stripe1));
+    ASSERT_TRUE(shared.attach(&h2, "/h", stripe2));
+    EXPECT_EQ(2u, shared.getNumberOfAttached());
+    for (int i = 0; i < 100; ++i) {
+      (i % 2 ? h1 : h2).Fill(i % 12 - 0.5);
+      reference.Fill(i % 12 - 0.5);
+    }
+
+    // each process only sees its own fills
+    EXPECT_EQ(1 + 50, h1.GetEntries());
+    shared.publishStatistics();
+    TH1F total("total", "", 10, 0, 10);
+    total.SetDirectory(nullptr);
+    ASSERT_TRUE(shared.addTotal(total, "/h"));
+    for (int bin = 0; bin <= 11; ++bin) {
+      EXPECT_EQ(reference.GetBinContent(bin), total.GetBinContent(bin)) << "bin " << bin;
+    }
+    EXPECT_EQ(reference.GetEntries(), total.GetEntries());
+    EXPECT_DOUBLE_EQ(reference.GetMean(), total.GetMean());
+
+    // detached histograms keep their own content
+    const double content = h1.GetBinContent(2);
+    shared.detachAll();
+    EXPECT_EQ(0u, shared.getNumberOfAttached());
+    h2.Fill(1.5);
+    EXPECT_EQ(content, h1.GetBinContent(2));
+
+    TH1F unknown("unknown", "", 10, 0, 10);
+    unknown.SetDirectory(nullptr);
+    EXPECT_FALSE(shared.addTotal(unknown, "/unknown"));
+  }
+
+  /** Weighted 2D histograms, profiles and mismatching definitions. */
+  TEST(SharedHistogramsTest, WeightsAndUnsupported)
+  {
+    SharedHistograms shared(1 << 20, 2);
+    const int stripe = shared.acquireStripe();
+    TH2D h("h", "", 5, 0, 5, 5, 0, 5);
+    h.SetDirectory(nullptr);
+    h.Sumw2();
+    ASSERT_TRUE(shared.attach(&h, "/dir/h", stripe));
+    h.Fill(1, 2, 0.5);
+    h.Fill(1, 2, 2);
+    TH2D total("total", "", 5, 0, 5, 5, 0, 5);
+    total.SetDirectory(nullptr);
+    ASSERT_TRUE(shared.addTotal(total, "/dir/h"));
+    EXPECT_DOUBLE_EQ(2.5, total.GetBinContent(2, 3));
+    EXPECT_DOUBLE_EQ(sqrt(4.25), total.GetBinError(2, 3));
+
+    // the same key with another binning
+    TH2D other("other", "", 4, 0, 5, 5, 0, 5);
+    other.SetDirectory(nullptr);
+    EXPECT_FALSE(shared.attach(&other, "/dir/h", shared.acquireStripe()));
+
+    TProfile profile("profile", "", 5, 0, 5);
+    profile.SetDirectory(nullptr);
+    EXPECT_FALSE(shared.attach(&profile, "/profile", stripe));
+
+    // no stripes left
+    EXPECT_EQ(-1, shared.acquireStripe());
+    shared.detachAll();
+  }
+
+  /** Histograms that do not fit into the memory are not shared. */
+  TEST(SharedHistogramsTest, Full)
+  {
+    SharedHistograms shared(10000, 1);
+    const int stripe = shared.acquireStripe();
+    TH1F small("small", "", 10, 0, 10);
+    TH1F large("large", "", 10000, 0, 10);
+    small.SetDirectory(nullptr);
+    large.SetDirectory(nullptr);
+    EXPECT_TRUE(shared.attach(&small, "/small", stripe));
+    EXPECT_FALSE(shared.attach(&large, "/large", stripe));
+    large.Fill(1);
+    EXPECT_EQ(1, large.GetEntries());
+    shared.detachAll();
+  }
+
+  /** Fills of a forked process are seen by the parent without any merging. */
+  TEST(SharedHistogramsTest, Fork)
+  {
+    auto shared = std::make_unique<SharedHistograms>(1 << 20, 4);
+    TH1F h("h", "", 10, 0, 10);
+    h.SetDirectory(nullptr);
+
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+      const int stripe = shared->acquireStripe();
+      if (!shared->attach(&h, "/h", stripe)) _exit(1);
+      for (int i = 0; i < 1000; ++i) h.Fill(i % 10);
+      shared->publishStatistics();
+      shared->detachAll();
+      _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(0, WEXITSTATUS(status));
+
+    TH1F total("total", "", 10, 0, 10);
+    total.SetDirectory(nullptr);
+    ASSERT_TRUE(shared->addTotal(total, "/h"));
+    EXPECT_EQ(1000, total.GetEntries());
+    for (int bin = 1; bin <= 10; ++bin) {
+      EXPECT_EQ(100, total.GetBinContent(bin));
+    }
+    EXPECT_EQ(0, h.GetEntries());
+  }
+
+  /** The fills of a process which ended without detaching its histograms are dropped from the totals. */
+  TEST(SharedHistogramsTest, CrashedProcess)
+  {
+    SharedHistograms shared(1 << 20, 4);
+    TH1F h("h", "", 10, 0, 10);
+    h.SetDirectory(nullptr);
+
+    for (bool crash : {true, false}) {
+      pid_t pid = fork();
+      ASSERT_NE(-1, pid);
+      if (pid == 0) {
+        const int stripe = shared.acquireStripe();
+        if (!shared.attach(&h, "/h", stripe)) _exit(1);
+        h.Fill(crash ? 1 : 2);
+        shared.publishStatistics();
+        if (!crash) shared.detachAll();
+        _exit(0);
+      }
+      int status = 0;
+      waitpid(pid, &status, 0);
+      ASSERT_TRUE(WIFEXITED(status));
+      ASSERT_EQ(0, WEXITSTATUS(status));
+    }
+
+    TH1F total("total", "", 10, 0, 10);
+    total.SetDirectory(nullptr);
+    ASSERT_TRUE(shared.addTotal(total, "/h"));
+    EXPECT_EQ(0, total.GetBinContent(2));
+    EXPECT_EQ(1, total.GetBinContent(3));
+    EXPECT_EQ(1, total.GetEntries());
+  }
+
+  /** Histograms which can change their binning are not attached, totals can be created from the stored empty copy. */
+  TEST(SharedHistogramsTest, BinningAndPrototype)
+  {
+    SharedHistograms shared(1 << 20, 1);
+    const int stripe = shared.acquireStripe();
+
+    TH1F extendable("extendable", "", 10, 0, 10);
+    extendable.SetDirectory(nullptr);
+    extendable.SetCanExtend(TH1::kAllAxes);
+    EXPECT_FALSE(shared.attach(&extendable, "/extendable", stripe));
+    TH1F labelled("labelled", "", 3, 0, 3);
+    labelled.SetDirectory(nullptr);
+    labelled.GetXaxis()->SetBinLabel(1, "a");
+    EXPECT_FALSE(shared.attach(&labelled, "/labelled", stripe));
+    TH1F buffered("buffered", "", 10, 0, 10);
+    buffered.SetDirectory(nullptr);
+    buffered.SetBuffer(100);
+    EXPECT_FALSE(shared.attach(&buffered, "/buffered", stripe));
+
+    TH2D h("h", "title", 4, 0, 4, 3, 0, 3);
+    h.SetDirectory(nullptr);
+    h.Fill(1, 1);
+    ASSERT_TRUE(shared.attach(&h, "/dir/h", stripe));
+    h.Fill(2, 1);
+    EXPECT_EQ(std::vector<std::string> {"/dir/h"}, shared.getKeys());
+
+    std::unique_ptr<TH1> total = shared.createPrototype("/dir/h");
+    ASSERT_NE(nullptr, total);
+    EXPECT_NE(nullptr, dynamic_cast<TH2D*>(total.get()));
+    EXPECT_STREQ("h", total->GetName());
+    EXPECT_STREQ("title", total->GetTitle());
+    EXPECT_EQ(nullptr, total->GetDirectory());
+    EXPECT_EQ(4, total->GetNbinsX());
+    EXPECT_EQ(3, total->GetNbinsY());
+    EXPECT_EQ(0, total->GetEntries());
+    ASSERT_TRUE(shared.addTotal(*total, "/dir/h"));
+    EXPECT_EQ(1, total->GetBinContent(2, 2));
+    EXPECT_EQ(1, total->GetBinContent(3, 2));
+    EXPECT_EQ(nullptr, shared.createPrototype("/unknown"));
+    shared.detachAll();
+  }
+}
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+
+##########################################################################
+# basf2 (Belle II Analysis Software Framework)                           #
+# Author: The Belle II Collaboration                                     #
+#                                                                        #
+# See git log for contributors and copyright holders.                    #
+# This file is licensed under LGPL-3.0, see LICENSE.md.                  #
+##########################################################################
+
+"""Check that multithreaded processing writes the same events as single-threaded processing"""
+
+import basf2
+import ROOT
+from ROOT import Belle2
+from b2test_utils import clean_working_directory, safe_process
+
+# @cond internal_test
+
+
+class CreateDummyData(basf2.Module):
+    """Create data depending on the event number, and a second object to be removed by PruneDataStore"""
+
+    def __init__(self):
+        super().__init__()
+        self.chunk_data = Belle2.PyStoreObj(Belle2.TestChunkData.Class())
+        self.pruned_data = Belle2.PyStoreObj(Belle2.TestChunkData.Class(), "PrunedChunkData")
+
+    def initialize(self):
+        self.chunk_data.registerInDataStore()
+        self.pruned_data.registerInDataStore()
+
+    def event(self):
+        event = Belle2.PyStoreObj('EventMetaData').obj().getEvent()
+        # leave some events without data to check that invalid objects stay invalid
+        if event % 7 != 0:
+            self.chunk_data.assign(Belle2.TestChunkData(event))
+        self.pruned_data.assign(Belle2.TestChunkData(1))
+
+
+def get_content(filename):
+    """Return run, event number and data of all events in the file, sorted by run and event"""
+    f = ROOT.TFile.Open(filename)
+    tree = f.Get("tree")
+    # the data member is private, so just compare the sum of the data in each event
+    n = tree.Draw("Sum$(TestChunkData.m_chunkData)", "", "goff")
+    sums = [tree.GetV1()[i] for i in range(n)]
+    content = []
+    for event, data_sum in zip(tree, sums):
+        valid = not event.TestChunkData.TestBit(ROOT.kInvalidObject)
+        pruned = event.PrunedChunkData.TestBit(ROOT.kInvalidObject)
+        content.append((event.EventMetaData.getRun(), event.EventMetaData.getEvent(), valid, pruned, data_sum))
+    f.Close()
+    # threads can finish events in a different order
+    return sorted(content)
+
+
+def process(name, nthreads):
+    """Process two runs with the given number of threads and return the content of the output file"""
+    basf2.set_random_seed("something important")
+    basf2.set_nthreads(nthreads)
+    path = basf2.Path()
+    path.add_module("EventInfoSetter", evtNumList=[100, 50], runList=[1, 2], expList=[0, 0])
+    path.add_module(CreateDummyData())
+    # both are flagged THREADSAFE and run concurrently
+    path.add_module("PruneDataStore", matchEntries=["PrunedChunkData"], keepMatchedEntries=False)
+    path.add_module("EventInfoPrinter")
+    path.add_module("RootOutput", outputFileName=f"{name}.root", updateFileCatalog=False)
+    assert safe_process(path) == 0, f"processing with {nthreads} threads failed"
+    return get_content(f"{name}.root")
+
+
+if __name__ == "__main__":
+    basf2.logging.log_level = basf2.LogLevel.ERROR
+    basf2.logging.enable_summary(False)
+    with clean_working_directory():
+        reference = process("single", 0)
+        assert len(reference) == 150, "unexpected number of events"
+        assert all(pruned for (_, _, _, pruned, _) in reference), "PruneDataStore did not remove the object"
+        for nthreads in [1, 4]:
+            result = process(f"threads{nthreads}", nthreads)
+            assert result == reference, f"content differs with {nthreads} threads"
+
+# @endcond
@@ -0,0 +1,150 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <framework/pcore/zmq/utils/EventBatch.h>
+#include <framework/pcore/zmq/utils/EventMetaDataSerialization.h>
+#include <framework/pcore/zmq/processModules/ProcessedEventsBackupList.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace Belle2;
+
+namespace {
+  /** Stand-in for the ZMQClient which remembers the content of the published event messages. */
+  class PublishedEvents {
+  public:
+    /** Store the content of the event message. */
+    template <class AZMQMessage>
+    void publish(AZMQMessage message) const
+    {
+      EvtMessage evtMessage(static_cast<char*>(message->getDataMessage().data()));
+      m_contents.emplace_back(evtMessage.msg(), evtMessage.msg_size());
+    }
+    /** Contents of all published event messages. */
+    mutable vector<string> m_contents;
+  };
+
+  /** Create the backup of a batch with one event message per event, the content of each message is its event number. */
+  void storeBatch(ProcessedEventsBackupList& list, const vector<int>& events, unsigned int workerId)
+  {
+    vector<unique_ptr<EvtMessage>> messages;
+    vector<EventMetaData> eventMetaData;
+    for (int event : events) {
+      const string content = to_string(event);
+      messages.emplace_back(new EvtMessage(content.data(), content.size(), MSG_EVENT));
+      eventMetaData.emplace_back(event, 1, 1);
+    }
+    list.storeBatch(std::move(messages), eventMetaData, workerId);
+  }
+
+  /** Fill a batch with events of different sizes, pack and unpack it with the given compression. */
+  void checkRoundTrip(int compressionLevel)
+  {
+    EventBatch sender;
+    vector<string> contents;
+    for (int i = 0; i < 20; ++i) {
+      contents.push_back(string(1 + i * 37, 'a' + i % 26));
+      EvtMessage message(contents.back().data(), contents.back().size(), MSG_EVENT);
+      sender.add(message, EventMetaData(i, 2, 3));
+    }
+    EXPECT_EQ(20u, sender.size());
+    zmq::message_t payload = sender.pack(compressionLevel);
+    EXPECT_TRUE(sender.empty());
+
+    EventBatch receiver;
+    receiver.unpack(payload);
+    ASSERT_EQ(20u, receiver.size());
+    for (size_t i = 0; i < receiver.size(); ++i) {
+      EXPECT_EQ(EventMetaData(i, 2, 3), receiver.getEventMetaData()[i]);
+      EvtMessage message(receiver.getEventBuffer(i));
+      EXPECT_EQ(MSG_EVENT, message.type());
+      EXPECT_EQ(contents[i], string(message.msg(), message.msg_size()));
+    }
+  }
+
+  /** Events and their meta data survive packing and unpacking. */
+  TEST(ZMQEventBatchTest, PackUnpack)
+  {
+    checkRoundTrip(0);
+  }
+
+  /** The same with LZ4 and ZSTD compression of the payload. */
+  TEST(ZMQEventBatchTest, Compression)
+  {
+    checkRoundTrip(404);
+    checkRoundTrip(505);
+  }
+
+  /** The output confirms all events of a batch with one message. */
+  TEST(ZMQEventBatchTest, SerializeList)
+  {
+    const vector<EventMetaData> list{EventMetaData(1, 2, 3), EventMetaData(4, 5, 6)};
+    const string serialized = EventMetaDataSerialization::serializeList(list);
+    EXPECT_EQ("1:2:3;4:5:6", serialized);
+    EXPECT_EQ(list, EventMetaDataSerialization::deserializeList(serialized));
+    EXPECT_EQ(vector<EventMetaData> {EventMetaData(7, 8, 9)}, EventMetaDataSerialization::deserializeList("7:8:9"));
+    EXPECT_TRUE(EventMetaDataSerialization::deserializeList("").empty());
+  }
+
+  /** Confirmed events are removed from their batch, the batch only when all of its events are confirmed. */
+  TEST(ZMQEventBatchTest, PartialConfirmation)
+  {
+    ProcessedEventsBackupList list;
+    storeBatch(list, {1, 2, 3}, 10);
+    storeBatch(list, {4, 5}, 20);
+    storeBatch(list, {6, 7}, 10);
+    EXPECT_EQ(3u, list.size());
+
+    // confirmations of different batches arrive in any order
+    list.removeEvent(EventMetaData(2, 1, 1));
+    list.removeEvent(EventMetaData(7, 1, 1));
+    list.removeEvent(EventMetaData(4, 1, 1));
+    EXPECT_EQ(3u, list.size());
+    list.removeEvent(EventMetaData(5, 1, 1));
+    EXPECT_EQ(2u, list.size());
+
+    // only the unconfirmed events of the failed worker are sent again
+    PublishedEvents published;
+    list.sendWorkerBackupEvents(20, published);
+    EXPECT_TRUE(published.m_contents.empty());
+    list.sendWorkerBackupEvents(10, published);
+    EXPECT_EQ((vector<string> {"1", "3", "6"}), published.m_contents);
+    EXPECT_EQ(0u, list.size());
+  }
+
+  /** The worker timeout is per event, so a batch may take as many times longer as it has events. */
+  TEST(ZMQEventBatchTest, TimeoutPerEvent)
+  {
+    const chrono::milliseconds timeout(100);
+    ProcessedEventsBackupList list;
+    EXPECT_EQ(-1, list.checkForTimeout(timeout));
+    storeBatch(list, {1, 2, 3, 4}, 10);
+    storeBatch(list, {5}, 20);
+    EXPECT_EQ(-1, list.checkForTimeout(timeout));
+
+    // the later, smaller batch times out first
+    this_thread::sleep_for(timeout * 3 / 2);
+    EXPECT_EQ(20, list.checkForTimeout(timeout));
+    list.removeEvent(EventMetaData(5, 1, 1));
+    EXPECT_EQ(-1, list.checkForTimeout(timeout));
+
+    // confirming events does not extend the deadline of the rest of the batch
+    list.removeEvent(EventMetaData(1, 1, 1));
+    list.removeEvent(EventMetaData(2, 1, 1));
+    list.removeEvent(EventMetaData(3, 1, 1));
+    this_thread::sleep_for(timeout * 3);
+    EXPECT_EQ(10, list.checkForTimeout(timeout));
+  }
+}
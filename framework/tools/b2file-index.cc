@@ -0,0 +1,123 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+// Basf2 headers
+#include <framework/dataobjects/EventMetaData.h>
+#include <framework/dataobjects/FileMetaData.h>
+#include <framework/io/EventIndex.h>
+#include <framework/io/RootFileInfo.h>
+#include <framework/io/RootIOUtilities.h>
+#include <framework/logging/Logger.h>
+
+// ROOT headers
+#include <TError.h>
+#include <TTree.h>
+
+// C++ headers
+#include <csignal>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// Boost headers
+#include <boost/program_options.hpp>
+
+using namespace Belle2;
+namespace prog = boost::program_options;
+
+int main(int argc, char* argv[])
+{
+  //remove SIGPIPE handler set by ROOT which sometimes caused infinite loops
+  //See https://savannah.cern.ch/bugs/?97991
+  //default action is to abort
+  if (std::signal(SIGPIPE, SIG_DFL) == SIG_ERR)
+    B2FATAL("Cannot remove SIGPIPE signal handler");
+
+  // Define command line options
+  prog::options_description options("Options");
+  options.add_options()
+  ("help,h", "print all available options")
+  ("output,o", prog::value<std::string>(), "name of the index file to create")
+  ("file", prog::value<std::vector<std::string>>(), "input file names")
+  ;
+
+  prog::positional_options_description posOptDesc;
+  posOptDesc.add("file", -1);
+
+  prog::variables_map varMap;
+  try {
+    prog::store(prog::command_line_parser(argc, argv).
+                options(options).positional(posOptDesc).run(), varMap);
+    prog::notify(varMap);
+  } catch (std::exception& e) {
+    std::cout << "Problem parsing command line: " << e.what() << std::endl;
+    std::cout << "Usage: " << argv[0] << " -o INDEX [OPTIONS] FILE...\n";
+    std::cout << options << std::endl;
+    return 1;
+  }
+
+  //Check for help option
+  if (varMap.count("help") or argc == 1) {
+    std::cout << "Usage: " << argv[0] << " -o INDEX [OPTIONS] FILE...\n";
+    std::cout << "Create an index of all events in the given files which can be used by RootInput to\n"
+              "read events by experiment, run and event number without searching through the files.\n\n";
+    std::cout << options << std::endl;
+    return 0;
+  }
+  if (!varMap.count("output")) {
+    B2ERROR("No output file name given");
+    return 1;
+  }
+  if (!varMap.count("file")) {
+    B2ERROR("No input files given");
+    return 1;
+  }
+
+  gErrorIgnoreLevel = kError;
+  const std::vector<std::string> fileNames = RootIOUtilities::expandWordExpansions(varMap["file"].as<std::vector<std::string>>());
+  std::vector<std::string> lfns;
+  std::vector<EventIndex::Record> records;
+  for (const std::string& fileName : fileNames) {
+    try {
+      RootIOUtilities::RootFileInfo fileInfo{fileName};
+      const std::string lfn = fileInfo.getFileMetaData().getLfn();
+      TTree& tree = fileInfo.getEventTree();
+      if (tree.GetEntries() > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error("too many entries");
+      // only read the event numbers
+      tree.SetBranchStatus("*", false);
+      tree.SetBranchStatus("EventMetaData*", true);
+      EventMetaData* eventMetaData = nullptr;
+      tree.SetBranchAddress("EventMetaData", &eventMetaData);
+      const uint32_t file = lfns.size();
+      const long nEntries = tree.GetEntries();
+      for (long entry = 0; entry < nEntries; ++entry) {
+        if (tree.GetEntry(entry) <= 0 or !eventMetaData)
+          throw std::runtime_error("cannot read entry " + std::to_string(entry));
+        records.push_back({eventMetaData->getExperiment(), eventMetaData->getRun(), eventMetaData->getEvent(), file,
+                           static_cast<uint32_t>(entry)});
+      }
+      tree.ResetBranchAddresses();
+      delete eventMetaData;
+      lfns.push_back(lfn);
+      B2INFO("Added file to index" << LogVar("filename", fileName) << LogVar("LFN", lfn) << LogVar("events", nEntries));
+    } catch (const std::exception& e) {
+      B2ERROR("Cannot index file" << LogVar("filename", fileName) << LogVar("error", e.what()));
+      return 1;
+    }
+  }
+
+  try {
+    EventIndex::write(varMap["output"].as<std::string>(), lfns, std::move(records));
+  } catch (const std::exception& e) {
+    B2ERROR(e.what());
+    return 1;
+  }
+  return 0;
+}
@@ -127,7 +127,10 @@ int main(int argc, char* argv[])
      "The first event has the number 0.")
     ("output,o", prog::value<string>(),
      "Override name of output file for (Seq)RootOutput. In case multiple modules are present in the path, only the first will be affected.")
-    ("processes,p", prog::value<int>(), "Override number of worker processes (>=1 enables, 0 disables parallel processing)");
+    ("processes,p", prog::value<int>(), "Override number of worker processes (>=1 enables, 0 disables parallel processing)")
+    ("threads", prog::value<int>(),
+     "Number of threads processing events at the same time within one process (>=1 enables, 0 disables multithreaded processing). Ignored if parallel processing is used. "
+     "Only modules flagged as thread-safe run concurrently, so far this gives no speedup for typical paths.");
 
     prog::options_description advanced("Advanced Options");
     advanced.add_options()
@@ -136,6 +139,8 @@ int main(int argc, char* argv[])
     ("visualize-dataflow", "Generate data flow diagram (dataflow.dot) for the executed steering file.")
     ("no-stats",
      "Disable collection of statistics during event processing. Useful for very high-rate applications, but produces empty table with 'print(statistics)'.")
+    ("perf-stats",
+     "Also collect hardware performance counters (cycles, instructions, cache misses, branch misses) and heap allocations for each module call. They are shown in an additional table by 'print(statistics)'.")
     ("dry-run",
      "Read steering file, but do not start any event processing when process(path) is called. Prints information on input/output files that would be used during normal execution.")
     ("dump-path", prog::value<string>(),
@@ -144,6 +149,12 @@ int main(int argc, char* argv[])
      "Do not read any provided steering file, instead execute the pickled (serialized) path from the given file.")
     ("zmq",
      "Use ZMQ for multiprocessing instead of a RingBuffer. This has many implications and should only be used by experts.")
+    ("zmq-batch-size", prog::value<unsigned int>(),
+     "With --zmq, send this many events in one message between the processes. Reduces the overhead for small events.")
+    ("zmq-compression", prog::value<int>(),
+     "With --zmq and --zmq-batch-size, compress the batches of events with this ROOT compression setting (algorithm * 100 + level, e.g. 404 for LZ4 or 505 for ZSTD).")
+    ("lockfree-ringbuffer",
+     "Connect the processes via lock-free shared memory ring buffers, which wake up waiting processes immediately instead of polling. Scales better with many worker processes.")
     ("job-information", prog::value<string>(),
      "Create json file with metadata of output files and basf2 execution status.")
     ("realm", prog::value<string>(),
@@ -229,11 +240,36 @@ int main(int argc, char* argv[])
       Environment::Instance().setNumberProcessesOverride(nprocesses);
     }
 
+    if (varMap.count("threads")) {
+      int nthreads = varMap["threads"].as<int>();
+      if (nthreads < 0) {
+        B2FATAL("Invalid number of threads!");
+      }
+      Environment::Instance().setNumberThreads(nthreads);
+    }
+
     // --zmq
     if (varMap.count("zmq")) {
       Environment::Instance().setUseZMQ(true);
     }
 
+    if (varMap.count("zmq-batch-size")) {
+      unsigned int batchSize = varMap["zmq-batch-size"].as<unsigned int>();
+      if (batchSize == 0) {
+        B2FATAL("Invalid ZMQ batch size!");
+      }
+      Environment::Instance().setZMQBatchSize(batchSize);
+    }
+
+    if (varMap.count("zmq-compression")) {
+      Environment::Instance().setZMQBatchCompressionLevel(varMap["zmq-compression"].as<int>());
+    }
+
+    // --lockfree-ringbuffer
+    if (varMap.count("lockfree-ringbuffer")) {
+      Environment::Instance().setUseLockFreeRingBuffer(true);
+    }
+
 
 #ifdef HAS_CALLGRIND
     if (varMap.count("profile")) {
@@ -403,6 +439,10 @@ int main(int argc, char* argv[])
       Environment::Instance().setNoStats(true);
     }
 
+    if (varMap.count("perf-stats")) {
+      Environment::Instance().setPerfStats(true);
+    }
+
     if (varMap.count("dry-run")) {
       Environment::Instance().setDryRun(true);
     }
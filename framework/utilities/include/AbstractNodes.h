@@ -12,6 +12,9 @@
 
 namespace Belle2 {
 
+  template<class AVariableManager>
+  class CutProgram;
+
   /**
    * A parsed cut-string naturally has a tree shape which incorporates
    * the information of operator precedence and evaluation order
@@ -46,6 +49,11 @@ namespace Belle2 {
      * pure virtual decompile function, has to be overridden in derived class
     **/
     virtual std::string decompile() const = 0;
+    /**
+     * pure virtual function to add the node to a compiled cut, has to be overridden in derived class.
+     * Returns the index of the clause representing this node in the program.
+    **/
+    virtual int emit(CutProgram<AVariableManager>& program) const = 0;
     /**
      * Virtual destructor
     **/
@@ -82,6 +90,11 @@ namespace Belle2 {
      * pure virtual decompile function, has to be overridden in derived class
     **/
     virtual std::string decompile() const = 0;
+    /**
+     * pure virtual function to add the instructions evaluating this expression to a compiled cut,
+     * has to be overridden in derived class
+    **/
+    virtual void emit(CutProgram<AVariableManager>& program) const = 0;
     /**
      * Virtual destructor
     **/
@@ -12,6 +12,7 @@
 #include <functional>
 
 #include <framework/utilities/AbstractNodes.h>
+#include <framework/utilities/CutProgram.h>
 #include <framework/utilities/NodeFactory.h>
 #include <framework/logging/Logger.h>
 
@@ -22,170 +23,6 @@ namespace py = boost::python;
 typedef const py::tuple& Nodetuple;
 
 namespace Belle2 {
-  /**
-   * Forward declaration of function defined in framework/utilities/GeneralCut.cc
-  **/
-  bool almostEqualDouble(const double& a, const double& b);
-
-  /**
-    * This is a class template which takes a template class operation as template argument.
-    * This allows passing the functional class templates e.g std::greater<T>,  which are templates themselves.
-    *
-    * In the Nodes we often have to compare two node evaluation results with each other.
-    * They are of type `variant<double, int, bool>`. Variants cannot be compared to each other directly, you have to extract the values and compare them.
-    * This gives nine different combinations for two variants.
-    * C++ introduced the std::visit concept for this purpose of variant evaluation.
-    * std::visit takes a Visitor class and the variants as parameters.
-    * One way to write a Visitor is the following way, where a operator() overload is supplied for every data type combination the variants can have.
-    * The visitor has to be exhaustive (every data type combination must be covered), and every operator() overload has to have the same return type.
-    *
-    * We have to do this comparisons for all comparison operators e.g ==, !=, > ...
-    * We can do this by passing the corresponding functional class template e.g std::equal_to<T>, std::not_equal_to<T>, std::greater<T>
-    * The datatype T is substituted in the operator() overload depending on the data type combination.
-    *
-    * When comparing double/int and a bool the double/int overload of the functionals are used to disable implicit conversion to bool:
-    * std::equal_to<bool>{}(1.2, true) ==> true; 1.2 is implicitly converted to true, because of std::equal<bool>
-    * std::equal_to<double>{}(1.2, true) ==> false; true is implicitly converted to 1.0, because of std::equal<double>
-    */
-  template <template <typename type> class operation>
-  struct Visitor {
-    /**
-     * double double overload with double comparison.
-     **/
-    bool operator()(const double& val0, const double& val1)
-    {
-      return operation<double> {}(val0, val1);
-    }
-    /**
-     * double int overload with double comparison.
-     **/
-    bool operator()(const double& val0, const int& val1)
-    {
-      return operation<double> {}(val0, val1);
-    }
-    /**
-     * double bool  overload with double comparison.
-     **/
-    bool operator()(const double& val0, const bool& val1)
-    {
-      return operation<double> {}(val0, val1);
-    }
-    /**
-     * int int overload with int comparison.
-     **/
-    bool operator()(const int& val0, const int& val1)
-    {
-      return operation<int> {}(val0, val1);
-    }
-    /**
-     * int bool overload with int comparison.
-     **/
-    bool operator()(const int& val0, const bool& val1)
-    {
-      return operation<int> {}(val0, val1);
-    }
-    /**
-     * int double overload with double comparison.
-     **/
-    bool operator()(const int& val0, const double& val1)
-    {
-      return operation<double> {}(val0, val1);
-    }
-    /**
-     * bool bool overload with bool comparison.
-     **/
-    bool operator()(const bool& val0, const bool& val1)
-    {
-      return operation<bool> {}(val0, val1);
-    }
-    /**
-     * bool double overload with double comparison.
-     **/
-    bool operator()(const bool& val0, const double& val1)
-    {
-      return operation<double> {}(val0, val1);
-    }
-    /**
-     * bool int overload with int comparison.
-     **/
-    bool operator()(const bool& val0, const int& val1)
-    {
-      return operation<int> {}(val0, val1);
-    }
-  };
-
-  /**
-   * Separate Visitor struct for equal_to comparison of variant<double, int bool>.
-   * Uses almostEqualDouble if one argument is double.
-  **/
-  struct EqualVisitor {
-    /**
-     * double double overload with double comparison.
-     **/
-    bool operator()(const double& val0, const double& val1)
-    {
-      return almostEqualDouble(val0, val1);
-    }
-    /**
-     * double int overload with double comparison.
-     **/
-    bool operator()(const double& val0, const int& val1)
-    {
-      return almostEqualDouble(val0, val1);
-    }
-    /**
-     * double bool  overload with double comparison.
-     **/
-    bool operator()(const double& val0, const bool& val1)
-    {
-      return almostEqualDouble(val0, val1);
-    }
-    /**
-     * int int overload with int comparison.
-     **/
-    bool operator()(const int& val0, const int& val1)
-    {
-      return std::equal_to<int> {}(val0, val1);
-    }
-    /**
-     * int bool overload with int comparison.
-     **/
-    bool operator()(const int& val0, const bool& val1)
-    {
-      return std::equal_to<int> {}(val0, val1);
-    }
-    /**
-     * int double overload with double comparison.
-     **/
-    bool operator()(const int& val0, const double& val1)
-    {
-      return almostEqualDouble(val0, val1);
-    }
-    /**
-     * bool bool overload with bool comparison.
-     **/
-    bool operator()(const bool& val0, const bool& val1)
-    {
-      return std::equal_to<bool> {}(val0, val1);
-    }
-    /**
-     * bool double overload with double comparison.
-     **/
-    bool operator()(const bool& val0, const double& val1)
-    {
-      return almostEqualDouble(val0, val1);
-    }
-    /**
-     * bool int overload with int comparison.
-     **/
-    bool operator()(const bool& val0, const int& val1)
-    {
-      return std::equal_to<int> {}(val0, val1);
-    }
-
-  };
-
-
   /**
   * Nodeclass with a single AbstractBooleanNode as child.
   * check() returns the negated result of the child node if m_negation is true.
@@ -236,6 +73,16 @@ namespace Belle2 {
 
       return stringstream.str();
     }
+
+    /**
+     * Add the child to the program, negated if m_negation is true.
+     */
+    int emit(CutProgram<AVariableManager>& program) const override
+    {
+      const int clause = m_bnode->emit(program);
+      if (m_negation) return program.negateClause(clause);
+      return clause;
+    }
     /**
      * Destructor
     **/
@@ -317,6 +164,16 @@ namespace Belle2 {
 
       return stringstream.str();
     }
+
+    /**
+     * Add both children to the program and combine them with m_boperator.
+     */
+    int emit(CutProgram<AVariableManager>& program) const override
+    {
+      const int left = m_left_bnode->emit(program);
+      const int right = m_right_bnode->emit(program);
+      return program.combineClauses(m_boperator, left, right);
+    }
     /**
      * Destructor
     **/
@@ -356,30 +213,7 @@ namespace Belle2 {
     */
     bool check(const Object* p) const override
     {
-      typename AVariableManager::VarVariant ret = m_enode->evaluate(p);
-      if (std::holds_alternative<bool>(ret)) {
-        return std::get<bool>(ret);
-      } else if (std::holds_alternative<int>(ret)) {
-        return static_cast<bool>(std::get<int>(ret));
-      } else if (std::holds_alternative<double>(ret)) {
-        if (static_cast<bool>(std::get<double>(ret))) {
-          // nan is considered false.
-          if (std::isnan(std::get<double>(ret))) {
-            return false;
-          }
-          if (std::get<double>(ret) != 1.0)
-            B2WARNING("Static casting of double value to bool in cutstring evaluation." <<  LogVar("Cut substring",
-                      m_enode->decompile()) << LogVar(" Casted value", std::get<double>(ret)) << LogVar("Casted to", "true"));
-        } else {
-          if (std::get<double>(ret) != 0.0)
-            B2WARNING("Static casting of double value to bool in cutstring evaluation." <<  LogVar("Cut substring",
-                      m_enode->decompile()) << LogVar(" Casted value", std::get<double>(ret)) << LogVar("Casted to", "false"));
-        }
-
-        return static_cast<bool>(std::get<double>(ret));
-      } else {
-        throw std::runtime_error("UnaryRelationalNode should evaluate to bool.");
-      }
+      return CutProgram<AVariableManager>::convertToBool(m_enode->evaluate(p), *m_enode);
     }
 
     /**
@@ -398,6 +232,16 @@ namespace Belle2 {
     {
       return m_enode->decompile();
     }
+
+    /**
+     * Add the expression to the program followed by the conversion to bool.
+     */
+    int emit(CutProgram<AVariableManager>& program) const override
+    {
+      program.beginLeaf();
+      m_enode->emit(program);
+      return program.addTruthTest(*m_enode);
+    }
     /**
      * Destructor
     **/
@@ -437,30 +281,7 @@ namespace Belle2 {
       // Get std::variant values of children node
       typename AVariableManager::VarVariant left_eval = m_left_enode->evaluate(p);
       typename AVariableManager::VarVariant right_eval = m_right_enode->evaluate(p);
-      switch (m_coperator) {
-        case ComparisonOperator::EQUALEQUAL:
-          return std::visit(EqualVisitor{}, left_eval, right_eval);
-          break;
-        case ComparisonOperator::GREATEREQUAL:
-          return std::visit(Visitor<std::greater_equal> {}, left_eval, right_eval);
-          break;
-        case ComparisonOperator::LESSEQUAL:
-          return std::visit(Visitor<std::less_equal> {}, left_eval, right_eval);
-          break;
-        case ComparisonOperator::GREATER:
-          return std::visit(Visitor<std::greater> {}, left_eval, right_eval);
-          break;
-        case ComparisonOperator::LESS:
-          return std::visit(Visitor<std::less> {}, left_eval, right_eval);
-          break;
-
-        case ComparisonOperator::NOTEQUAL:
-          return !std::visit(EqualVisitor{}, left_eval, right_eval);
-          break;
-        default:
-          throw std::runtime_error("BinaryRelationalNode has an invalid ComparisonOperator.");
-      }
-      return false;
+      return CutProgram<AVariableManager>::compareValues(m_coperator, left_eval, right_eval);
     }
 
     /**
@@ -486,6 +307,17 @@ namespace Belle2 {
 
       return stringstream.str();
     }
+
+    /**
+     * Add both expressions to the program followed by the comparison.
+     */
+    int emit(CutProgram<AVariableManager>& program) const override
+    {
+      program.beginLeaf();
+      m_left_enode->emit(program);
+      m_right_enode->emit(program);
+      return program.addComparison(m_coperator);
+    }
     /**
      * Destructor
     **/
@@ -534,51 +366,8 @@ namespace Belle2 {
       typename AVariableManager::VarVariant center_eval = m_center_enode->evaluate(p);
       typename AVariableManager::VarVariant right_eval = m_right_enode->evaluate(p);
 
-      switch (m_lc_coperator) {
-        case ComparisonOperator::EQUALEQUAL:
-          if (not std::visit(EqualVisitor {}, left_eval, center_eval)) return false;
-          break;
-        case ComparisonOperator::GREATEREQUAL:
-          if (not std::visit(Visitor<std::greater_equal> {}, left_eval, center_eval)) return false;
-          break;
-        case ComparisonOperator::LESSEQUAL:
-          if (not std::visit(Visitor<std::less_equal> {}, left_eval, center_eval)) return false;
-          break;
-        case ComparisonOperator::GREATER:
-          if (not std::visit(Visitor<std::greater> {}, left_eval, center_eval)) return false;
-          break;
-        case ComparisonOperator::LESS:
-          if (not std::visit(Visitor<std::less> {}, left_eval, center_eval)) return false;
-          break;
-        case ComparisonOperator::NOTEQUAL:
-          if (std::visit(EqualVisitor {}, left_eval, center_eval)) return false;
-          break;
-        default:
-          throw std::runtime_error("TernaryRelational has an invalid m_lc_operator");
-      }
-      switch (m_cr_coperator) {
-        case ComparisonOperator::EQUALEQUAL:
-          if (not std::visit(EqualVisitor {}, center_eval, right_eval)) return false;
-          break;
-        case ComparisonOperator::GREATEREQUAL:
-          if (not std::visit(Visitor<std::greater_equal> {}, center_eval, right_eval)) return false;
-          break;
-        case ComparisonOperator::LESSEQUAL:
-          if (not std::visit(Visitor<std::less_equal> {}, center_eval, right_eval)) return false;
-          break;
-        case ComparisonOperator::GREATER:
-          if (not std::visit(Visitor<std::greater> {}, center_eval, right_eval)) return false;
-          break;
-        case ComparisonOperator::LESS:
-          if (not std::visit(Visitor<std::less> {}, center_eval, right_eval)) return false;
-          break;
-        case ComparisonOperator::NOTEQUAL:
-          if (std::visit(EqualVisitor {}, center_eval, right_eval)) return false;
-          break;
-        default:
-          throw std::runtime_error("TernaryRelational has an invalid m_cr_operator");
-      }
-      return true;
+      if (not CutProgram<AVariableManager>::compareValues(m_lc_coperator, left_eval, center_eval)) return false;
+      return CutProgram<AVariableManager>::compareValues(m_cr_coperator, center_eval, right_eval);
     }
     /**
      * Print node
@@ -606,6 +395,18 @@ namespace Belle2 {
       stringstream << m_right_enode->decompile();
       return stringstream.str();
     }
+
+    /**
+     * Add the three expressions to the program followed by the range comparison.
+     */
+    int emit(CutProgram<AVariableManager>& program) const override
+    {
+      program.beginLeaf();
+      m_left_enode->emit(program);
+      m_center_enode->emit(program);
+      m_right_enode->emit(program);
+      return program.addRangeComparison(m_lc_coperator, m_cr_coperator);
+    }
     /**
      * Destructor
     **/
@@ -660,11 +461,7 @@ namespace Belle2 {
     typename AVariableManager::VarVariant evaluate(const Object* p) const override
     {
       typename AVariableManager::VarVariant ret = m_enode->evaluate(p);
-      if (m_unary_minus) {
-        if (std::holds_alternative<int>(ret)) return -1 * std::get<int>(ret);
-        if (std::holds_alternative<double>(ret)) return -1.0 * std::get<double>(ret);
-        throw std::runtime_error("Attempted unary sign with boolean type value.");
-      }
+      if (m_unary_minus) return CutProgram<AVariableManager>::applyUnaryMinus(ret);
       return ret;
     }
     /**
@@ -691,6 +488,15 @@ namespace Belle2 {
       if (m_parenthesized) stringstream << " )";
       return stringstream.str();
     }
+
+    /**
+     * Add the child expression to the program followed by the unary minus if m_unary_minus is true.
+     */
+    void emit(CutProgram<AVariableManager>& program) const override
+    {
+      m_enode->emit(program);
+      if (m_unary_minus) program.addUnaryMinus();
+    }
     /**
      * Destructor
     **/
@@ -732,102 +538,10 @@ namespace Belle2 {
     **/
     typename AVariableManager::VarVariant evaluate(const Object* p) const override
     {
-      typename AVariableManager::VarVariant l_val, r_val, ret;
+      typename AVariableManager::VarVariant l_val, r_val;
       l_val = m_left_enode->evaluate(p);
       r_val = m_right_enode->evaluate(p);
-      switch (m_aoperation) {
-        case ArithmeticOperation::PLUS:
-          if (std::holds_alternative<int>(l_val) && std::holds_alternative<int>(r_val)) {
-            ret = std::get<int>(l_val) + std::get<int>(r_val);
-            return ret;
-          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<double>(r_val)) {
-            ret = std::get<double>(l_val) + std::get<double>(r_val);
-            return ret;
-          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<int>(r_val)) {
-            ret = std::get<double>(l_val) + std::get<int>(r_val);
-            return ret;
-          } else if (std::holds_alternative<int>(l_val) && std::holds_alternative<double>(r_val)) {
-            ret = std::get<int>(l_val) + std::get<double>(r_val);
-            return ret;
-          } else {
-            throw std::runtime_error("Invalid datatypes in plus operation.");
-          }
-          break;
-        case ArithmeticOperation::MINUS:
-          if (std::holds_alternative<int>(l_val) && std::holds_alternative<int>(r_val)) {
-            ret = std::get<int>(l_val) - std::get<int>(r_val);
-            return ret;
-          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<double>(r_val)) {
-            ret = std::get<double>(l_val) - std::get<double>(r_val);
-            return ret;
-          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<int>(r_val)) {
-            ret = std::get<double>(l_val) - std::get<int>(r_val);
-            return ret;
-          } else if (std::holds_alternative<int>(l_val) && std::holds_alternative<double>(r_val)) {
-            ret = std::get<int>(l_val) - std::get<double>(r_val);
-            return ret;
-          } else {
-            throw std::runtime_error("Invalid datatypes in minus operation.");
-          }
-          break;
-        case ArithmeticOperation::PRODUCT:
-          if (std::holds_alternative<int>(l_val) && std::holds_alternative<int>(r_val)) {
-            ret = std::get<int>(l_val) * std::get<int>(r_val);
-            return ret;
-          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<double>(r_val)) {
-            ret = std::get<double>(l_val) * std::get<double>(r_val);
-            return ret;
-          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<int>(r_val)) {
-            ret = std::get<double>(l_val) * std::get<int>(r_val);
-            return ret;
-          } else if (std::holds_alternative<int>(l_val) && std::holds_alternative<double>(r_val)) {
-            ret = std::get<int>(l_val) * std::get<double>(r_val);
-            return ret;
-          } else {
-            throw std::runtime_error("Invalid datatypes in product operation.");
-          }
-          break;
-        case ArithmeticOperation::DIVISION:
-          if (std::holds_alternative<int>(l_val) && std::holds_alternative<int>(r_val)) {
-            // Always do double division
-            double d = std::get<int>(r_val);
-            ret = std::get<int>(l_val) / d;
-            return ret;
-          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<double>(r_val)) {
-            ret = std::get<double>(l_val) / std::get<double>(r_val);
-            return ret;
-          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<int>(r_val)) {
-            ret = std::get<double>(l_val) / std::get<int>(r_val);
-            return ret;
-          } else if (std::holds_alternative<int>(l_val) && std::holds_alternative<double>(r_val)) {
-            ret = std::get<int>(l_val) / std::get<double>(r_val);
-            return ret;
-          } else {
-            throw std::runtime_error("Invalid datatypes in division operation.");
-          }
-          break;
-        case ArithmeticOperation::POWER:
-          if (std::holds_alternative<int>(l_val) && std::holds_alternative<int>(r_val)) {
-            ret = std::pow(std::get<int>(l_val), std::get<int>(r_val));
-            return ret;
-          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<double>(r_val)) {
-            ret = std::pow(std::get<double>(l_val), std::get<double>(r_val));
-            return ret;
-          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<int>(r_val)) {
-            ret = std::pow(std::get<double>(l_val), std::get<int>(r_val));
-            return ret;
-          } else if (std::holds_alternative<int>(l_val) && std::holds_alternative<double>(r_val)) {
-            ret = std::pow(std::get<int>(l_val), std::get<double>(r_val));
-            return ret;
-          } else {
-            throw std::runtime_error("Invalid datatypes in power operation.");
-          }
-          break;
-        default:
-          throw std::runtime_error("Operation not valid");
-      }
-      ret = false;
-      return ret;
+      return CutProgram<AVariableManager>::applyArithmetic(m_aoperation, l_val, r_val);
     }
     /**
      * Print node
@@ -852,6 +566,16 @@ namespace Belle2 {
 
       return stringstream.str();
     }
+
+    /**
+     * Add both expressions to the program followed by the arithmetic operation.
+     */
+    void emit(CutProgram<AVariableManager>& program) const override
+    {
+      m_left_enode->emit(program);
+      m_right_enode->emit(program);
+      program.addArithmetic(m_aoperation);
+    }
     /**
      * Destructor
     **/
@@ -923,6 +647,14 @@ namespace Belle2 {
       stringstream << m_value;
       return stringstream.str();
     }
+
+    /**
+     * Add m_value to the program as a constant.
+    **/
+    void emit(CutProgram<AVariableManager>& program) const override
+    {
+      program.addConstant(typename AVariableManager::VarVariant{m_value});
+    }
     /**
      * Destructor
     **/
@@ -973,6 +705,15 @@ namespace Belle2 {
       return m_name;
     }
 
+    /**
+     * Add m_var to the program.
+    **/
+    void emit(CutProgram<AVariableManager>& program) const override
+    {
+      if (m_var == nullptr) throw std::runtime_error("Cut string has an invalid format: Neither number nor variable name");
+      program.addVariable(m_var);
+    }
+
     /**
      * Get variable from AVariableManger
     **/
@@ -1043,6 +784,14 @@ namespace Belle2 {
       return fullname;
     }
 
+    /**
+     * Add m_var to the program.
+    **/
+    void emit(CutProgram<AVariableManager>& program) const override
+    {
+      program.addVariable(m_var);
+    }
+
     /**
      * Get MetaVariable from AVariableManager
     **/
@@ -0,0 +1,1079 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+#include <framework/utilities/AbstractNodes.h>
+#include <framework/utilities/CutHelpers.h>
+#include <framework/logging/Logger.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace Belle2 {
+
+  /**
+    * This is a class template which takes a template class operation as template argument.
+    * This allows passing the functional class templates e.g std::greater<T>,  which are templates themselves.
+    *
+    * In the Nodes we often have to compare two node evaluation results with each other.
+    * They are of type `variant<double, int, bool>`. Variants cannot be compared to each other directly, you have to extract the values and compare them.
+    * This gives nine different combinations for two variants.
+    * C++ introduced the std::visit concept for this purpose of variant evaluation.
+    * std::visit takes a Visitor class and the variants as parameters.
+    * One way to write a Visitor is the following way, where a operator() overload is supplied for every data type combination the variants can have.
+    * The visitor has to be exhaustive (every data type combination must be covered), and every operator() overload has to have the same return type.
+    *
+    * We have to do this comparisons for all comparison operators e.g ==, !=, > ...
+    * We can do this by passing the corresponding functional class template e.g std::equal_to<T>, std::not_equal_to<T>, std::greater<T>
+    * The datatype T is substituted in the operator() overload depending on the data type combination.
+    *
+    * When comparing double/int and a bool the double/int overload of the functionals are used to disable implicit conversion to bool:
+    * std::equal_to<bool>{}(1.2, true) ==> true; 1.2 is implicitly converted to true, because of std::equal<bool>
+    * std::equal_to<double>{}(1.2, true) ==> false; true is implicitly converted to 1.0, because of std::equal<double>
+    */
+  template <template <typename type> class operation>
+  struct Visitor {
+    /**
+     * double double overload with double comparison.
+     **/
+    bool operator()(const double& val0, const double& val1)
+    {
+      return operation<double> {}(val0, val1);
+    }
+    /**
+     * double int overload with double comparison.
+     **/
+    bool operator()(const double& val0, const int& val1)
+    {
+      return operation<double> {}(val0, val1);
+    }
+    /**
+     * double bool  overload with double comparison.
+     **/
+    bool operator()(const double& val0, const bool& val1)
+    {
+      return operation<double> {}(val0, val1);
+    }
+    /**
+     * int int overload with int comparison.
+     **/
+    bool operator()(const int& val0, const int& val1)
+    {
+      return operation<int> {}(val0, val1);
+    }
+    /**
+     * int bool overload with int comparison.
+     **/
+    bool operator()(const int& val0, const bool& val1)
+    {
+      return operation<int> {}(val0, val1);
+    }
+    /**
+     * int double overload with double comparison.
+     **/
+    bool operator()(const int& val0, const double& val1)
+    {
+      return operation<double> {}(val0, val1);
+    }
+    /**
+     * bool bool overload with bool comparison.
+     **/
+    bool operator()(const bool& val0, const bool& val1)
+    {
+      return operation<bool> {}(val0, val1);
+    }
+    /**
+     * bool double overload with double comparison.
+     **/
+    bool operator()(const bool& val0, const double& val1)
+    {
+      return operation<double> {}(val0, val1);
+    }
+    /**
+     * bool int overload with int comparison.
+     **/
+    bool operator()(const bool& val0, const int& val1)
+    {
+      return operation<int> {}(val0, val1);
+    }
+  };
+
+  /**
+   * Separate Visitor struct for equal_to comparison of variant<double, int bool>.
+   * Uses almostEqualDouble if one argument is double.
+  **/
+  struct EqualVisitor {
+    /**
+     * double double overload with double comparison.
+     **/
+    bool operator()(const double& val0, const double& val1)
+    {
+      return almostEqualDouble(val0, val1);
+    }
+    /**
+     * double int overload with double comparison.
+     **/
+    bool operator()(const double& val0, const int& val1)
+    {
+      return almostEqualDouble(val0, val1);
+    }
+    /**
+     * double bool  overload with double comparison.
+     **/
+    bool operator()(const double& val0, const bool& val1)
+    {
+      return almostEqualDouble(val0, val1);
+    }
+    /**
+     * int int overload with int comparison.
+     **/
+    bool operator()(const int& val0, const int& val1)
+    {
+      return std::equal_to<int> {}(val0, val1);
+    }
+    /**
+     * int bool overload with int comparison.
+     **/
+    bool operator()(const int& val0, const bool& val1)
+    {
+      return std::equal_to<int> {}(val0, val1);
+    }
+    /**
+     * int double overload with double comparison.
+     **/
+    bool operator()(const int& val0, const double& val1)
+    {
+      return almostEqualDouble(val0, val1);
+    }
+    /**
+     * bool bool overload with bool comparison.
+     **/
+    bool operator()(const bool& val0, const bool& val1)
+    {
+      return std::equal_to<bool> {}(val0, val1);
+    }
+    /**
+     * bool double overload with double comparison.
+     **/
+    bool operator()(const bool& val0, const double& val1)
+    {
+      return almostEqualDouble(val0, val1);
+    }
+    /**
+     * bool int overload with int comparison.
+     **/
+    bool operator()(const bool& val0, const int& val1)
+    {
+      return std::equal_to<int> {}(val0, val1);
+    }
+
+  };
+
+  /**
+   * Values of the variables used by several cuts which are checked on the same object.
+   *
+   * Pass the same instance to GeneralCut::check() for all cuts checked on one object
+   * and every variable is evaluated only once. The values are dropped as soon as the
+   * cache is used with a different object. As objects can be recreated at the same
+   * address (e.g. in the next event), clear() has to be called whenever the values
+   * could have changed.
+   *
+   * Variables are assumed to have no side effects and to return the same value
+   * when called twice on the same object.
+   */
+  template<class AVariableManager>
+  class CutVariableCache {
+    /**
+     * Template argument dependent Particle type definition
+    **/
+    typedef typename AVariableManager::Object Object;
+    /**
+     * Template argument dependent Variable type definition
+    **/
+    typedef typename AVariableManager::Var Var;
+    /**
+     * Template argument dependent variable value definition
+    **/
+    typedef typename AVariableManager::VarVariant VarVariant;
+  public:
+    /**
+     * Forget all values.
+     */
+    void clear()
+    {
+      m_object = nullptr;
+      m_variables.clear();
+      m_values.clear();
+    }
+
+    /**
+     * Return the value of the variable for the given object, evaluate it only if it is not cached yet.
+     * @param var variable to evaluate
+     * @param p object for which the variable should be evaluated
+     */
+    VarVariant get(const Var* var, const Object* p)
+    {
+      if (p != m_object) {
+        clear();
+        m_object = p;
+      }
+      // there are only a few variables per object, a linear search is the fastest
+      for (size_t i = 0; i < m_variables.size(); ++i) {
+        if (m_variables[i] == var) return m_values[i];
+      }
+      VarVariant value = var->function(p);
+      m_values.push_back(value);
+      m_variables.push_back(var);
+      return value;
+    }
+
+    /**
+     * Number of cached values.
+     */
+    size_t size() const { return m_values.size(); }
+
+  private:
+    const Object* m_object{nullptr}; /**< object the cached values belong to */
+    std::vector<const Var*> m_variables; /**< variables with cached values */
+    std::vector<VarVariant> m_values; /**< cached values in the same order as m_variables */
+  };
+
+  /**
+   * Flat representation of a cut which is evaluated without recursion or virtual function calls.
+   *
+   * The cut nodes add themselves to the program via their emit() member function.
+   * Boolean nodes are stored as clauses: constants, leaves (the expression code
+   * followed by a test instruction) and junctions (and/or with any number of children).
+   * Expressions are stored as instructions for a stack machine.
+   * When the program is built
+   * - subexpressions without variables are folded into constants,
+   * - nested and/or nodes are merged into one junction and constant children are removed,
+   * - every variable is evaluated at most once per check, even if it appears several times in the cut.
+   *
+   * If adaptive ordering is enabled, the time needed to evaluate each child of a junction
+   * and the fraction of objects passing it is measured for the first checks. Afterwards
+   * the children are reordered such that the ones which are cheap and likely decide the
+   * result of the junction are evaluated first. This changes which variables are evaluated,
+   * so it should only be used if the variables have no side effects and if no child of
+   * a junction relies on another one being evaluated first, e.g. to guard against invalid input.
+   *
+   * The result of check() is identical to the one of the node tree, the node tree is still
+   * needed for print() and decompile().
+   */
+  template<class AVariableManager>
+  class CutProgram {
+    /**
+     * Template argument dependent Particle type definition
+    **/
+    typedef typename AVariableManager::Object Object;
+    /**
+     * Template argument dependent Variable type definition
+    **/
+    typedef typename AVariableManager::Var Var;
+    /**
+     * Template argument dependent variable value definition
+    **/
+    typedef typename AVariableManager::VarVariant VarVariant;
+    /**
+     * Clock used to measure the evaluation time of the clauses
+    **/
+    typedef std::chrono::steady_clock Clock;
+
+  public:
+    /** Number of checks used to measure cost and selectivity of the clauses if adaptive ordering is enabled */
+    static constexpr unsigned int c_calibrationChecks = 1000;
+
+    /**
+     * Compare two node evaluation results.
+     * @param coperator comparison operator to apply
+     * @param left left hand side of the comparison
+     * @param right right hand side of the comparison
+     */
+    static bool compareValues(ComparisonOperator coperator, const VarVariant& left, const VarVariant& right)
+    {
+      // most variables are doubles, avoid the dispatch of std::visit for them
+      const double* l = std::get_if<double>(&left);
+      const double* r = std::get_if<double>(&right);
+      if (l and r) {
+        switch (coperator) {
+          case ComparisonOperator::GREATEREQUAL: return *l >= *r;
+          case ComparisonOperator::LESSEQUAL: return *l <= *r;
+          case ComparisonOperator::GREATER: return *l > *r;
+          case ComparisonOperator::LESS: return *l < *r;
+          default: break;
+        }
+      }
+      return compareVariants(coperator, left, right);
+    }
+
+    /**
+     * Compare two node evaluation results of any type.
+     * @param coperator comparison operator to apply
+     * @param left left hand side of the comparison
+     * @param right right hand side of the comparison
+     */
+    static bool compareVariants(ComparisonOperator coperator, const VarVariant& left, const VarVariant& right)
+    {
+      switch (coperator) {
+        case ComparisonOperator::EQUALEQUAL:
+          return std::visit(EqualVisitor{}, left, right);
+        case ComparisonOperator::GREATEREQUAL:
+          return std::visit(Visitor<std::greater_equal> {}, left, right);
+        case ComparisonOperator::LESSEQUAL:
+          return std::visit(Visitor<std::less_equal> {}, left, right);
+        case ComparisonOperator::GREATER:
+          return std::visit(Visitor<std::greater> {}, left, right);
+        case ComparisonOperator::LESS:
+          return std::visit(Visitor<std::less> {}, left, right);
+        case ComparisonOperator::NOTEQUAL:
+          return !std::visit(EqualVisitor{}, left, right);
+        default:
+          throw std::runtime_error("Invalid ComparisonOperator in cut evaluation.");
+      }
+    }
+
+    /**
+     * Apply an arithmetic operation to two node evaluation results.
+     * Integer values are only kept if both values are integers and the operation is not a division.
+     * @param aoperation arithmetic operation to apply
+     * @param l_val left operand
+     * @param r_val right operand
+     */
+    static VarVariant applyArithmetic(ArithmeticOperation aoperation, const VarVariant& l_val, const VarVariant& r_val)
+    {
+      VarVariant ret;
+      switch (aoperation) {
+        case ArithmeticOperation::PLUS:
+          if (std::holds_alternative<int>(l_val) && std::holds_alternative<int>(r_val)) {
+            ret = std::get<int>(l_val) + std::get<int>(r_val);
+            return ret;
+          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<double>(r_val)) {
+            ret = std::get<double>(l_val) + std::get<double>(r_val);
+            return ret;
+          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<int>(r_val)) {
+            ret = std::get<double>(l_val) + std::get<int>(r_val);
+            return ret;
+          } else if (std::holds_alternative<int>(l_val) && std::holds_alternative<double>(r_val)) {
+            ret = std::get<int>(l_val) + std::get<double>(r_val);
+            return ret;
+          } else {
+            throw std::runtime_error("Invalid datatypes in plus operation.");
+          }
+          break;
+        case ArithmeticOperation::MINUS:
+          if (std::holds_alternative<int>(l_val) && std::holds_alternative<int>(r_val)) {
+            ret = std::get<int>(l_val) - std::get<int>(r_val);
+            return ret;
+          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<double>(r_val)) {
+            ret = std::get<double>(l_val) - std::get<double>(r_val);
+            return ret;
+          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<int>(r_val)) {
+            ret = std::get<double>(l_val) - std::get<int>(r_val);
+            return ret;
+          } else if (std::holds_alternative<int>(l_val) && std::holds_alternative<double>(r_val)) {
+            ret = std::get<int>(l_val) - std::get<double>(r_val);
+            return ret;
+          } else {
+            throw std::runtime_error("Invalid datatypes in minus operation.");
+          }
+          break;
+        case ArithmeticOperation::PRODUCT:
+          if (std::holds_alternative<int>(l_val) && std::holds_alternative<int>(r_val)) {
+            ret = std::get<int>(l_val) * std::get<int>(r_val);
+            return ret;
+          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<double>(r_val)) {
+            ret = std::get<double>(l_val) * std::get<double>(r_val);
+            return ret;
+          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<int>(r_val)) {
+            ret = std::get<double>(l_val) * std::get<int>(r_val);
+            return ret;
+          } else if (std::holds_alternative<int>(l_val) && std::holds_alternative<double>(r_val)) {
+            ret = std::get<int>(l_val) * std::get<double>(r_val);
+            return ret;
+          } else {
+            throw std::runtime_error("Invalid datatypes in product operation.");
+          }
+          break;
+        case ArithmeticOperation::DIVISION:
+          if (std::holds_alternative<int>(l_val) && std::holds_alternative<int>(r_val)) {
+            // Always do double division
+            double d = std::get<int>(r_val);
+            ret = std::get<int>(l_val) / d;
+            return ret;
+          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<double>(r_val)) {
+            ret = std::get<double>(l_val) / std::get<double>(r_val);
+            return ret;
+          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<int>(r_val)) {
+            ret = std::get<double>(l_val) / std::get<int>(r_val);
+            return ret;
+          } else if (std::holds_alternative<int>(l_val) && std::holds_alternative<double>(r_val)) {
+            ret = std::get<int>(l_val) / std::get<double>(r_val);
+            return ret;
+          } else {
+            throw std::runtime_error("Invalid datatypes in division operation.");
+          }
+          break;
+        case ArithmeticOperation::POWER:
+          if (std::holds_alternative<int>(l_val) && std::holds_alternative<int>(r_val)) {
+            ret = std::pow(std::get<int>(l_val), std::get<int>(r_val));
+            return ret;
+          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<double>(r_val)) {
+            ret = std::pow(std::get<double>(l_val), std::get<double>(r_val));
+            return ret;
+          } else if (std::holds_alternative<double>(l_val) && std::holds_alternative<int>(r_val)) {
+            ret = std::pow(std::get<double>(l_val), std::get<int>(r_val));
+            return ret;
+          } else if (std::holds_alternative<int>(l_val) && std::holds_alternative<double>(r_val)) {
+            ret = std::pow(std::get<int>(l_val), std::get<double>(r_val));
+            return ret;
+          } else {
+            throw std::runtime_error("Invalid datatypes in power operation.");
+          }
+          break;
+        default:
+          throw std::runtime_error("Operation not valid");
+      }
+      ret = false;
+      return ret;
+    }
+
+    /**
+     * Negate a node evaluation result, booleans cannot be negated.
+     * @param value value to negate
+     */
+    static VarVariant applyUnaryMinus(const VarVariant& value)
+    {
+      if (std::holds_alternative<int>(value)) return -1 * std::get<int>(value);
+      if (std::holds_alternative<double>(value)) return -1.0 * std::get<double>(value);
+      throw std::runtime_error("Attempted unary sign with boolean type value.");
+    }
+
+    /**
+     * Convert the result of a single expression in a cut to a boolean.
+     * A warning is printed if a double other than 0 or 1 is converted, nan is considered false.
+     * @param ret value to convert
+     * @param enode expression from which the value was calculated, used for the warning
+     */
+    static bool convertToBool(const VarVariant& ret, const AbstractExpressionNode<AVariableManager>& enode)
+    {
+      if (std::holds_alternative<bool>(ret)) {
+        return std::get<bool>(ret);
+      } else if (std::holds_alternative<int>(ret)) {
+        return static_cast<bool>(std::get<int>(ret));
+      } else if (std::holds_alternative<double>(ret)) {
+        if (static_cast<bool>(std::get<double>(ret))) {
+          // nan is considered false.
+          if (std::isnan(std::get<double>(ret))) {
+            return false;
+          }
+          if (std::get<double>(ret) != 1.0)
+            B2WARNING("Static casting of double value to bool in cutstring evaluation." <<  LogVar("Cut substring",
+                      enode.decompile()) << LogVar(" Casted value", std::get<double>(ret)) << LogVar("Casted to", "true"));
+        } else {
+          if (std::get<double>(ret) != 0.0)
+            B2WARNING("Static casting of double value to bool in cutstring evaluation." <<  LogVar("Cut substring",
+                      enode.decompile()) << LogVar(" Casted value", std::get<double>(ret)) << LogVar("Casted to", "false"));
+        }
+
+        return static_cast<bool>(std::get<double>(ret));
+      } else {
+        throw std::runtime_error("UnaryRelationalNode should evaluate to bool.");
+      }
+    }
+
+    /**
+     * Build the program from the root node of a cut.
+     * @param root root node of the cut, has to outlive the program
+     * @param adaptiveOrdering measure the cost and selectivity of the clauses and reorder them, see class description
+     */
+    CutProgram(const AbstractBooleanNode<AVariableManager>& root, bool adaptiveOrdering) : m_calibrating{adaptiveOrdering}
+    {
+      m_root = root.emit(*this);
+      m_clauseCalls.assign(m_clauses.size(), 0);
+      m_clausePasses.assign(m_clauses.size(), 0);
+      m_clauseTime.assign(m_clauses.size(), 0.);
+      if (m_calibrating) {
+        // the time to read the clock is not negligible compared to cheap clauses
+        for (int i = 0; i < 100; ++i) {
+          const auto start = Clock::now();
+          m_clockOverhead = std::min(m_clockOverhead, std::chrono::duration<double>(Clock::now() - start).count());
+        }
+      }
+      generateCode();
+    }
+
+    /** Check if the object passes the cut.
+     * @param p object to check
+     * @param cache optional cache of variable values shared with other cuts
+     */
+    bool check(const Object* p, CutVariableCache<AVariableManager>* cache) const
+    {
+      // values of the variables from the previous check are invalid now
+      if (++m_generation == 0) {
+        std::fill(m_valueGeneration.begin(), m_valueGeneration.end(), 0);
+        m_generation = 1;
+      }
+
+      bool flag = false;
+      VarVariant* stack = m_stack.data();
+      size_t top = 0; // number of values on the stack
+      const Instruction* code = m_code.data();
+      const size_t size = m_code.size();
+      size_t pc = 0;
+      while (pc < size) {
+        const Instruction& instruction = code[pc++];
+        switch (instruction.op) {
+          case OpCode::c_PushConstant:
+            stack[top++] = m_constants[instruction.arg];
+            break;
+          case OpCode::c_PushVariable:
+            stack[top++] = getValue(instruction.arg, p, cache);
+            break;
+          case OpCode::c_UnaryMinus:
+            stack[top - 1] = applyUnaryMinus(stack[top - 1]);
+            break;
+          case OpCode::c_Arithmetic:
+            stack[top - 2] = applyArithmetic(static_cast<ArithmeticOperation>(instruction.operation), stack[top - 2], stack[top - 1]);
+            --top;
+            break;
+          case OpCode::c_Truth:
+            flag = convertToBool(stack[--top], *m_truthNodes[instruction.arg]);
+            break;
+          case OpCode::c_Compare:
+            flag = compareValues(static_cast<ComparisonOperator>(instruction.operation), stack[top - 2], stack[top - 1]);
+            top -= 2;
+            break;
+          case OpCode::c_CompareRange:
+            flag = compareValues(static_cast<ComparisonOperator>(instruction.operation), stack[top - 3], stack[top - 2]) and
+                   compareValues(static_cast<ComparisonOperator>(instruction.operation2), stack[top - 2], stack[top - 1]);
+            top -= 3;
+            break;
+          case OpCode::c_CompareOperands: {
+            const VarVariant& left = getOperand(instruction.arg, p, cache);
+            const VarVariant& right = getOperand(instruction.arg2, p, cache);
+            flag = compareValues(static_cast<ComparisonOperator>(instruction.operation), left, right);
+            break;
+          }
+          case OpCode::c_CompareRangeOperands: {
+            const VarVariant& left = getOperand(instruction.arg, p, cache);
+            const VarVariant& center = getOperand(instruction.arg2, p, cache);
+            const VarVariant& right = getOperand(instruction.arg3, p, cache);
+            flag = compareValues(static_cast<ComparisonOperator>(instruction.operation), left, center) and
+                   compareValues(static_cast<ComparisonOperator>(instruction.operation2), center, right);
+            break;
+          }
+          case OpCode::c_SetFlag:
+            flag = instruction.arg;
+            break;
+          case OpCode::c_Not:
+            flag = not flag;
+            break;
+          case OpCode::c_JumpIfFalse:
+            if (not flag) pc = instruction.arg;
+            break;
+          case OpCode::c_JumpIfTrue:
+            if (flag) pc = instruction.arg;
+            break;
+          case OpCode::c_BeginProbe:
+            m_probeStart.push_back(Clock::now());
+            break;
+          case OpCode::c_EndProbe:
+            m_clauseTime[instruction.arg] += std::max(std::chrono::duration<double>(Clock::now() - m_probeStart.back()).count() -
+                                                      m_clockOverhead, 0.);
+            m_probeStart.pop_back();
+            ++m_clauseCalls[instruction.arg];
+            m_clausePasses[instruction.arg] += flag;
+            break;
+        }
+      }
+
+      if (m_calibrating) countCalibrationCheck();
+      return flag;
+    }
+
+    /** Number of instructions in the program, mainly for testing */
+    size_t getNumberOfInstructions() const { return m_code.size(); }
+
+    /** Number of distinct variables used by the program */
+    size_t getNumberOfVariables() const { return m_variables.size(); }
+
+    /** Whether the cost and selectivity of the clauses is still being measured */
+    bool isCalibrating() const { return m_calibrating; }
+
+    /**
+     * Range of values of a variable which is necessary to pass the cut.
+     *
+     * Only comparisons of the variable with numeric constants are considered which are either
+     * the whole cut or one of the operands of a top level and. Everything else, e.g. comparisons
+     * inside an or or with other variables, does not constrain the range. The bounds are
+     * inclusive even for strict comparisons, so an object with a value outside of the range
+     * fails the cut, but one with a value inside of the range does not necessarily pass it.
+     * @param var variable for which the range is requested
+     * @return lower and upper bound, -inf and inf if the variable is not constrained
+     */
+    std::pair<double, double> getRequiredRange(const Var* var) const
+    {
+      std::pair<double, double> range{-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity()};
+      const auto it = std::find(m_variables.begin(), m_variables.end(), var);
+      if (it == m_variables.end()) return range;
+      const int slot = it - m_variables.begin();
+
+      const Clause& root = m_clauses[m_root];
+      if (root.negated) return range;
+      if (root.type == ClauseType::c_Leaf) {
+        restrictRange(root, slot, range);
+      } else if (root.type == ClauseType::c_And) {
+        for (int child : root.children) {
+          const Clause& clause = m_clauses[child];
+          if (clause.type == ClauseType::c_Leaf and not clause.negated) restrictRange(clause, slot, range);
+        }
+      }
+      return range;
+    }
+
+    /** @name Functions used by the nodes to add themselves to the program */
+    /**@{*/
+
+    /** Start a new leaf clause, the following expression instructions are added to it. */
+    void beginLeaf()
+    {
+      m_clauses.emplace_back();
+      m_clauses.back().type = ClauseType::c_Leaf;
+      m_current = &m_clauses.back().code;
+    }
+
+    /** Push a constant on the stack */
+    void addConstant(const VarVariant& value)
+    {
+      m_current->push_back({OpCode::c_PushConstant, 0, 0, static_cast<int>(m_constants.size()), 0, 0});
+      m_constants.push_back(value);
+    }
+
+    /** Push the value of a variable on the stack. Variables used several times share one slot. */
+    void addVariable(const Var* var)
+    {
+      auto it = std::find(m_variables.begin(), m_variables.end(), var);
+      const int slot = it - m_variables.begin();
+      if (it == m_variables.end()) {
+        m_variables.push_back(var);
+        m_values.emplace_back();
+        m_valueGeneration.push_back(0);
+        m_variableUses.push_back(0);
+      }
+      ++m_variableUses[slot];
+      m_current->push_back({OpCode::c_PushVariable, 0, 0, slot, 0, 0});
+    }
+
+    /** Negate the value on top of the stack, folded if it is a constant */
+    void addUnaryMinus()
+    {
+      if (isConstant(1)) {
+        try {
+          m_constants[m_current->back().arg] = applyUnaryMinus(m_constants[m_current->back().arg]);
+          return;
+        } catch (std::runtime_error&) {
+          // keep the instruction so that the error is reported when the cut is checked
+        }
+      }
+      m_current->push_back({OpCode::c_UnaryMinus, 0, 0, 0, 0, 0});
+    }
+
+    /** Replace the two values on top of the stack by the result of an arithmetic operation, folded if both are constants */
+    void addArithmetic(ArithmeticOperation aoperation)
+    {
+      if (isConstant(2)) {
+        try {
+          const size_t n = m_current->size();
+          VarVariant value = applyArithmetic(aoperation, m_constants[(*m_current)[n - 2].arg], m_constants[(*m_current)[n - 1].arg]);
+          m_constants[(*m_current)[n - 2].arg] = value;
+          m_current->pop_back();
+          return;
+        } catch (std::runtime_error&) {
+          // keep the instruction so that the error is reported when the cut is checked
+        }
+      }
+      m_current->push_back({OpCode::c_Arithmetic, static_cast<unsigned char>(aoperation), 0, 0, 0, 0});
+    }
+
+    /** Finish the current leaf with a conversion of the value on the stack to bool
+     * @param enode expression node which was added to the leaf, used for warnings
+     * @return index of the clause
+     */
+    int addTruthTest(const AbstractExpressionNode<AVariableManager>& enode)
+    {
+      Clause& clause = m_clauses.back();
+      if (isConstant(1)) {
+        // only fold values which are converted without a warning
+        const VarVariant& value = m_constants[clause.code.back().arg];
+        if (not std::holds_alternative<double>(value)) return foldLeaf(convertToBool(value, enode));
+      }
+      clause.code.push_back({OpCode::c_Truth, 0, 0, static_cast<int>(m_truthNodes.size()), 0, 0});
+      m_truthNodes.push_back(&enode);
+      return m_clauses.size() - 1;
+    }
+
+    /** Finish the current leaf with a comparison of the two values on the stack
+     * @param coperator comparison operator
+     * @return index of the clause
+     */
+    int addComparison(ComparisonOperator coperator)
+    {
+      Clause& clause = m_clauses.back();
+      if (isConstant(2)) {
+        const size_t n = clause.code.size();
+        return foldLeaf(compareValues(coperator, m_constants[clause.code[n - 2].arg], m_constants[clause.code[n - 1].arg]));
+      }
+      if (isOperand(2)) {
+        // compare the values directly without the stack
+        const size_t n = clause.code.size();
+        const Instruction compare{OpCode::c_CompareOperands, static_cast<unsigned char>(coperator), 0,
+                                  getOperandIndex(clause.code[n - 2]), getOperandIndex(clause.code[n - 1]), 0};
+        clause.code.resize(n - 2);
+        clause.code.push_back(compare);
+      } else {
+        clause.code.push_back({OpCode::c_Compare, static_cast<unsigned char>(coperator), 0, 0, 0, 0});
+      }
+      return m_clauses.size() - 1;
+    }
+
+    /** Finish the current leaf with a range comparison of the three values on the stack
+     * @param lc_coperator comparison operator between the left and the center value
+     * @param cr_coperator comparison operator between the center and the right value
+     * @return index of the clause
+     */
+    int addRangeComparison(ComparisonOperator lc_coperator, ComparisonOperator cr_coperator)
+    {
+      Clause& clause = m_clauses.back();
+      if (isConstant(3)) {
+        const size_t n = clause.code.size();
+        const VarVariant& left = m_constants[clause.code[n - 3].arg];
+        const VarVariant& center = m_constants[clause.code[n - 2].arg];
+        const VarVariant& right = m_constants[clause.code[n - 1].arg];
+        return foldLeaf(compareValues(lc_coperator, left, center) and compareValues(cr_coperator, center, right));
+      }
+      if (isOperand(3)) {
+        const size_t n = clause.code.size();
+        const Instruction compare{OpCode::c_CompareRangeOperands, static_cast<unsigned char>(lc_coperator), static_cast<unsigned char>(cr_coperator),
+                                  getOperandIndex(clause.code[n - 3]), getOperandIndex(clause.code[n - 2]), getOperandIndex(clause.code[n - 1])};
+        clause.code.resize(n - 3);
+        clause.code.push_back(compare);
+      } else {
+        clause.code.push_back({OpCode::c_CompareRange, static_cast<unsigned char>(lc_coperator), static_cast<unsigned char>(cr_coperator), 0, 0, 0});
+      }
+      return m_clauses.size() - 1;
+    }
+
+    /** Negate a clause
+     * @param index index of the clause
+     * @return index of the negated clause
+     */
+    int negateClause(int index)
+    {
+      Clause& clause = m_clauses[index];
+      if (clause.type == ClauseType::c_Constant) clause.value = not clause.value;
+      else clause.negated = not clause.negated;
+      return index;
+    }
+
+    /** Combine two clauses with a boolean operator
+     * @param boperator boolean operator
+     * @param left index of the left clause
+     * @param right index of the right clause
+     * @return index of the combined clause
+     */
+    int combineClauses(BooleanOperator boperator, int left, int right)
+    {
+      const ClauseType type = boperator == BooleanOperator::AND ? ClauseType::c_And : ClauseType::c_Or;
+      // A constant equal to this value decides the result of the junction. Other constants
+      // can be dropped. The left operand is kept even if the right one decides as
+      // it could throw an exception.
+      const bool deciding = type == ClauseType::c_Or;
+      std::vector<int> children;
+      for (int index : {left, right}) {
+        const Clause& clause = m_clauses[index];
+        if (clause.type == ClauseType::c_Constant) {
+          if (clause.value != deciding) continue;
+          if (children.empty()) return makeConstant(deciding);
+          children.push_back(index);
+          break;
+        } else if (clause.type == type and not clause.negated) {
+          children.insert(children.end(), clause.children.begin(), clause.children.end());
+        } else {
+          children.push_back(index);
+        }
+      }
+      if (children.empty()) return makeConstant(not deciding);
+      if (children.size() == 1) return children.front();
+      m_clauses.emplace_back();
+      m_clauses.back().type = type;
+      m_clauses.back().children = std::move(children);
+      return m_clauses.size() - 1;
+    }
+    /**@}*/
+
+  private:
+    /** Operation codes of the instructions */
+    enum class OpCode : unsigned char {
+      c_PushConstant, /**< push m_constants[arg] */
+      c_PushVariable, /**< push the value of m_variables[arg] */
+      c_UnaryMinus, /**< negate the top of the stack */
+      c_Arithmetic, /**< replace the two values on top of the stack by the result of the arithmetic operation */
+      c_Truth, /**< pop a value and set the flag to its conversion to bool, arg is the index in m_truthNodes */
+      c_Compare, /**< pop two values and set the flag to the result of the comparison */
+      c_CompareRange, /**< pop three values and set the flag to the result of the two comparisons */
+      c_CompareOperands, /**< set the flag to the result of the comparison of the operands arg and arg2 */
+      c_CompareRangeOperands, /**< set the flag to the result of the comparisons of the operands arg, arg2 and arg3 */
+      c_SetFlag, /**< set the flag to arg */
+      c_Not, /**< invert the flag */
+      c_JumpIfFalse, /**< continue at instruction arg if the flag is false */
+      c_JumpIfTrue, /**< continue at instruction arg if the flag is true */
+      c_BeginProbe, /**< start measuring the time of a clause */
+      c_EndProbe, /**< stop measuring the time of clause arg and count the result */
+    };
+
+    /** Single instruction of the program */
+    struct Instruction {
+      OpCode op; /**< operation */
+      unsigned char operation; /**< arithmetic or (first) comparison operator */
+      unsigned char operation2; /**< second comparison operator */
+      int arg; /**< first argument */
+      int arg2; /**< second argument */
+      int arg3; /**< third argument */
+    };
+
+    /** Type of a clause */
+    enum class ClauseType : unsigned char {
+      c_Constant, /**< constant value */
+      c_Leaf, /**< expression code followed by a test */
+      c_And, /**< all children have to be true */
+      c_Or, /**< at least one child has to be true */
+    };
+
+    /** Boolean subexpression of the cut */
+    struct Clause {
+      ClauseType type{ClauseType::c_Constant}; /**< type of the clause */
+      bool negated{false}; /**< whether the result is negated, not used for constants */
+      bool value{false}; /**< value of a constant clause */
+      std::vector<Instruction> code; /**< instructions of a leaf clause */
+      std::vector<int> children; /**< children of a junction clause in evaluation order */
+    };
+
+    /** Check whether the last n instructions of the current code push constants, i.e. whether the last n operands are constant */
+    bool isConstant(size_t n) const
+    {
+      if (m_current->size() < n) return false;
+      return std::all_of(m_current->end() - n, m_current->end(), [](const Instruction & instruction) {
+        return instruction.op == OpCode::c_PushConstant;
+      });
+    }
+
+    /** Check whether the last n instructions of the current code each push a constant or a variable */
+    bool isOperand(size_t n) const
+    {
+      if (m_current->size() != n) return false;
+      return std::all_of(m_current->begin(), m_current->end(), [](const Instruction & instruction) {
+        return instruction.op == OpCode::c_PushConstant or instruction.op == OpCode::c_PushVariable;
+      });
+    }
+
+    /** Operand index of a push instruction: variables are counted from 0, constants from -1 downwards */
+    static int getOperandIndex(const Instruction& instruction)
+    {
+      return instruction.op == OpCode::c_PushVariable ? instruction.arg : -1 - instruction.arg;
+    }
+
+    /** Return a variable or constant by its operand index */
+    const VarVariant& getOperand(int index, const Object* p, CutVariableCache<AVariableManager>* cache) const
+    {
+      if (index < 0) return m_constants[-1 - index];
+      return getValue(index, p, cache);
+    }
+
+    /** Narrow the range of the variable in the given slot by the comparisons of a leaf, see getRequiredRange() */
+    void restrictRange(const Clause& clause, int slot, std::pair<double, double>& range) const
+    {
+      if (clause.code.size() != 1) return;
+      const Instruction& instruction = clause.code.front();
+      if (instruction.op == OpCode::c_CompareOperands) {
+        restrictRange(instruction.arg, static_cast<ComparisonOperator>(instruction.operation), instruction.arg2, slot, range);
+      } else if (instruction.op == OpCode::c_CompareRangeOperands) {
+        restrictRange(instruction.arg, static_cast<ComparisonOperator>(instruction.operation), instruction.arg2, slot, range);
+        restrictRange(instruction.arg2, static_cast<ComparisonOperator>(instruction.operation2), instruction.arg3, slot, range);
+      }
+    }
+
+    /** Narrow the range of the variable in the given slot by one comparison of two operands, see getOperandIndex() */
+    void restrictRange(int left, ComparisonOperator coperator, int right, int slot, std::pair<double, double>& range) const
+    {
+      // bring the comparison to the form "variable coperator constant"
+      if (right == slot and left < 0) {
+        std::swap(left, right);
+        switch (coperator) {
+          case ComparisonOperator::GREATEREQUAL: coperator = ComparisonOperator::LESSEQUAL; break;
+          case ComparisonOperator::LESSEQUAL: coperator = ComparisonOperator::GREATEREQUAL; break;
+          case ComparisonOperator::GREATER: coperator = ComparisonOperator::LESS; break;
+          case ComparisonOperator::LESS: coperator = ComparisonOperator::GREATER; break;
+          default: break;
+        }
+      }
+      if (left != slot or right >= 0) return;
+
+      const VarVariant& constant = m_constants[-1 - right];
+      double value;
+      if (const double* d = std::get_if<double>(&constant)) value = *d;
+      else if (const int* i = std::get_if<int>(&constant)) value = *i;
+      else return;
+      if (std::isnan(value)) return;
+
+      // equality uses a tolerance, so it is not used to constrain the range
+      switch (coperator) {
+        case ComparisonOperator::GREATEREQUAL:
+        case ComparisonOperator::GREATER:
+          range.first = std::max(range.first, value);
+          break;
+        case ComparisonOperator::LESSEQUAL:
+        case ComparisonOperator::LESS:
+          range.second = std::min(range.second, value);
+          break;
+        default:
+          break;
+      }
+    }
+
+    /** Replace the current leaf by a constant */
+    int foldLeaf(bool value)
+    {
+      m_clauses.back() = Clause();
+      m_clauses.back().value = value;
+      return m_clauses.size() - 1;
+    }
+
+    /** Add a constant clause */
+    int makeConstant(bool value)
+    {
+      m_clauses.emplace_back();
+      m_clauses.back().value = value;
+      return m_clauses.size() - 1;
+    }
+
+    /** Return the value of a variable, evaluated at most once per check */
+    const VarVariant& getValue(int slot, const Object* p, CutVariableCache<AVariableManager>* cache) const
+    {
+      if (m_variableUses[slot] == 1 or m_valueGeneration[slot] != m_generation) {
+        m_values[slot] = cache ? cache->get(m_variables[slot], p) : VarVariant(m_variables[slot]->function(p));
+        m_valueGeneration[slot] = m_generation;
+      }
+      return m_values[slot];
+    }
+
+    /** Count a check during the calibration and reorder the clauses after the last one */
+    void countCalibrationCheck() const
+    {
+      m_probeStart.clear();
+      if (++m_checks < c_calibrationChecks) return;
+      m_calibrating = false;
+      reorderClauses(m_root);
+      generateCode();
+    }
+
+    /** Sort the children of all junctions by cost and selectivity measured during the calibration */
+    void reorderClauses(int index) const
+    {
+      Clause& clause = m_clauses[index];
+      if (clause.type != ClauseType::c_And and clause.type != ClauseType::c_Or) return;
+      for (int child : clause.children) reorderClauses(child);
+
+      // Expected cost of a child per decision of the junction: the time needed to evaluate
+      // the child divided by the probability that it decides the result (false for and, true for or).
+      // Children which were never evaluated are kept at the end in the original order.
+      auto rank = [this, &clause](int child) {
+        if (m_clauseCalls[child] == 0) return std::numeric_limits<double>::infinity();
+        const double cost = m_clauseTime[child] / m_clauseCalls[child];
+        const double passFraction = static_cast<double>(m_clausePasses[child]) / m_clauseCalls[child];
+        const double decideFraction = clause.type == ClauseType::c_And ? 1 - passFraction : passFraction;
+        return cost / std::max(decideFraction, 1e-3);
+      };
+      std::stable_sort(clause.children.begin(), clause.children.end(), [&rank](int a, int b) { return rank(a) < rank(b); });
+    }
+
+    /** Translate the clauses to the instructions of the program, with probes if still calibrating */
+    void generateCode() const
+    {
+      m_code.clear();
+      addClauseCode(m_root, false);
+      // a leaf needs at most one stack entry per instruction
+      size_t maxCodeSize = 0;
+      for (const Clause& clause : m_clauses) maxCodeSize = std::max(maxCodeSize, clause.code.size());
+      m_stack.resize(maxCodeSize);
+    }
+
+    /** Add the instructions of one clause to the program
+     * @param index index of the clause
+     * @param probe whether the clause should be measured
+     */
+    void addClauseCode(int index, bool probe) const
+    {
+      const Clause& clause = m_clauses[index];
+      if (probe) m_code.push_back({OpCode::c_BeginProbe, 0, 0, index, 0, 0});
+      switch (clause.type) {
+        case ClauseType::c_Constant:
+          m_code.push_back({OpCode::c_SetFlag, 0, 0, clause.value, 0, 0});
+          break;
+        case ClauseType::c_Leaf:
+          m_code.insert(m_code.end(), clause.code.begin(), clause.code.end());
+          break;
+        case ClauseType::c_And:
+        case ClauseType::c_Or: {
+          const OpCode jump = clause.type == ClauseType::c_And ? OpCode::c_JumpIfFalse : OpCode::c_JumpIfTrue;
+          std::vector<size_t> jumps;
+          for (size_t i = 0; i < clause.children.size(); ++i) {
+            addClauseCode(clause.children[i], m_calibrating);
+            if (i + 1 < clause.children.size()) {
+              jumps.push_back(m_code.size());
+              m_code.push_back({jump, 0, 0, 0, 0, 0});
+            }
+          }
+          for (size_t jumpIndex : jumps) m_code[jumpIndex].arg = m_code.size();
+          break;
+        }
+      }
+      // the jumps of a junction end here, so the negation applies to its result
+      if (clause.negated and clause.type != ClauseType::c_Constant) m_code.push_back({OpCode::c_Not, 0, 0, 0, 0, 0});
+      if (probe) m_code.push_back({OpCode::c_EndProbe, 0, 0, index, 0, 0});
+    }
+
+    mutable std::vector<Clause> m_clauses; /**< boolean subexpressions, children are reordered after the calibration */
+    int m_root{0}; /**< index of the root clause */
+    std::vector<Instruction>* m_current{nullptr}; /**< code of the leaf currently being built */
+    std::vector<VarVariant> m_constants; /**< constants used by the program */
+    std::vector<const Var*> m_variables; /**< variables used by the program */
+    std::vector<const AbstractExpressionNode<AVariableManager>*> m_truthNodes; /**< expressions converted to bool, for warnings */
+    mutable std::vector<Instruction> m_code; /**< instructions of the program */
+
+    mutable std::vector<VarVariant> m_stack; /**< value stack, large enough for every leaf */
+    mutable std::vector<VarVariant> m_values; /**< values of the variables in the current check */
+    mutable std::vector<unsigned int> m_valueGeneration; /**< check in which each value was calculated */
+    std::vector<unsigned int> m_variableUses; /**< number of times each variable appears in the cut */
+    mutable unsigned int m_generation{0}; /**< number of the current check */
+
+    mutable bool m_calibrating; /**< whether the clauses are still measured */
+    mutable unsigned int m_checks{0}; /**< number of checks during the calibration */
+    mutable std::vector<Clock::time_point> m_probeStart; /**< start times of the clauses being measured */
+    mutable std::vector<unsigned long> m_clauseCalls; /**< number of evaluations of each clause */
+    mutable std::vector<unsigned long> m_clausePasses; /**< number of evaluations of each clause which were true */
+    mutable std::vector<double> m_clauseTime; /**< total evaluation time of each clause in seconds */
+    double m_clockOverhead{std::numeric_limits<double>::max()}; /**< time needed to read the clock in seconds */
+  };
+}
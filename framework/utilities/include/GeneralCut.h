@@ -10,6 +10,7 @@
 
 #include <boost/python.hpp>
 #include <framework/utilities/CutNodes.h>
+#include <framework/utilities/CutProgram.h>
 #include <framework/utilities/NodeFactory.h>
 
 #include <string>
@@ -59,6 +60,11 @@ namespace Belle2 {
    *    the value corresponding to this name. Whenever this value is needed, the function called "function" is called with a pointer to a Object, that is
    *    given in the check function of this cut.
    *
+   *  For checking, the tree of nodes is translated into a CutProgram: a flat list of instructions in which
+   *  constant subexpressions are already evaluated and each variable is evaluated at most once per check.
+   *  Optionally the order of the operands of and/or is adapted to their measured cost and selectivity, see CutProgram.
+   *  The values of variables can be shared between several cuts checked on the same object with a VariableCache.
+   *
    *  The best example for a VariableManager, that has all these parameters, is probably the analysis VariableManager with VariableManager::var equals
    *  to the analysis variable and the VariableManager::Object equal to a Particle.
    *  For a more slim example of a valid variable manager, see the generalCut.cc test, where a mock variable manager is created.
@@ -71,20 +77,25 @@ namespace Belle2 {
     typedef typename AVariableManager::Var Var;
 
   public:
+    /// Cache of variable values which can be shared between cuts checked on the same object.
+    typedef CutVariableCache<AVariableManager> VariableCache;
+
     /**
      * Creates an instance of a cut and returns a unique_ptr to it, if you need a copy-able object instead
      * you can cast it to a shared_ptr using std::shared_ptr<Variable::Cut>(Cut::compile(cutString))
      * @param cut the string defining the cut
+     * @param adaptiveOrdering reorder the operands of and/or by their measured cost and selectivity.
+     *        Only use this if the variables have no side effects and no operand guards the evaluation of another one.
      * @return std::unique_ptr<Cut>
      */
-    static std::unique_ptr<GeneralCut> compile(const std::string& cut)
+    static std::unique_ptr<GeneralCut> compile(const std::string& cut, bool adaptiveOrdering = false)
     {
       // Here we parse
       Py_Initialize();
       try {
         py::object b2parser_namespace = py::import("b2parser");
         py::tuple tuple = py::extract<py::tuple>(b2parser_namespace.attr("parse")(cut));
-        return std::unique_ptr<GeneralCut>(new GeneralCut(tuple));
+        return std::unique_ptr<GeneralCut>(new GeneralCut(tuple, adaptiveOrdering));
       } catch (py::error_already_set&) {
         PyErr_Print();
         B2FATAL("Parsing error on cutstring:\n" + cut);
@@ -97,8 +108,28 @@ namespace Belle2 {
      */
     bool check(const Object* p) const
     {
-      if (m_root != nullptr) return m_root->check(p);
-      throw std::runtime_error("GeneralCut m_root is not initialized.");
+      return check(p, nullptr);
+    }
+
+    /**
+     * Check if the current cuts are passed by the given object, using and filling a cache of variable values.
+     * @param p pointer to the object, that should be checked.
+     * @param cache values of variables already evaluated for p by other cuts, see CutVariableCache.
+     */
+    bool check(const Object* p, VariableCache& cache) const
+    {
+      return check(p, &cache);
+    }
+
+    /**
+     * Range of values of a variable which is necessary to pass the cut, see CutProgram::getRequiredRange().
+     * This allows to reject objects before all information needed to check the cut is available.
+     * @param var variable for which the range is requested
+     * @return lower and upper bound, -inf and inf if the variable is not constrained
+     */
+    std::pair<double, double> getRequiredRange(const Var* var) const
+    {
+      return m_program->getRequiredRange(var);
     }
 
     /**
@@ -124,8 +155,30 @@ namespace Belle2 {
     /**
      * Constructor of the cut. Call init with given Nodetuple
      * @param tuple (const boost::python::tuple&) constructed by the python parser from cut.
+     * @param adaptiveOrdering reorder the operands of and/or by their measured cost and selectivity.
+     */
+    GeneralCut(Nodetuple tuple, bool adaptiveOrdering) : m_root{NodeFactory::compile_boolean_node<AVariableManager>(tuple)},
+      m_program{std::make_unique<CutProgram<AVariableManager>>(*m_root, adaptiveOrdering)} {}
+
+    /**
+     * Check the cut with the compiled program, optionally with a cache of variable values.
      */
-    explicit GeneralCut(Nodetuple tuple) : m_root{NodeFactory::compile_boolean_node<AVariableManager>(tuple)} {}
+    bool check(const Object* p, VariableCache* cache) const
+    {
+      if (m_root == nullptr) throw std::runtime_error("GeneralCut m_root is not initialized.");
+      // The program keeps its state during a check, if the cut is checked again
+      // while one of its variables is evaluated the tree is used instead.
+      if (m_running) return m_root->check(p);
+      m_running = true;
+      try {
+        const bool result = m_program->check(p, cache);
+        m_running = false;
+        return result;
+      } catch (...) {
+        m_running = false;
+        throw;
+      }
+    }
 
     /**
      * Delete Copy constructor
@@ -138,5 +191,7 @@ namespace Belle2 {
     GeneralCut& operator=(const GeneralCut&) = delete;
 
     std::unique_ptr<const AbstractBooleanNode<AVariableManager>> m_root; /**< cut root node */
+    std::unique_ptr<const CutProgram<AVariableManager>> m_program; /**< compiled representation of the tree used for checking */
+    mutable bool m_running{false}; /**< whether m_program is currently checking an object */
   };
 }
@@ -0,0 +1,66 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#pragma once
+
+#include <array>
+
+namespace Belle2 {
+  /** Hardware performance counters and heap allocation counters of the calling thread.
+   *
+   * The hardware counters are read with the Linux perf_event interface and
+   * only count user space events of the calling thread. If they cannot be
+   * opened (e.g. because of /proc/sys/kernel/perf_event_paranoid or in a
+   * virtual machine) they stay zero and only the allocations are counted.
+   * If the kernel has to multiplex the counters they are scaled to the time
+   * they were enabled, so they are estimates in that case.
+   *
+   * Allocations are counted in the global operator new, so only allocations
+   * of C++ code (which is resolved to the framework's operator new) are
+   * included, not plain malloc() calls. The replacement operator new is always
+   * linked in. If another allocator which replaces operator new is preloaded,
+   * e.g. tcmalloc or jemalloc, no allocations are counted; setEnabled() warns
+   * about this.
+   *
+   * Counting is disabled by default and enabled with setEnabled(), e.g. by
+   * ``basf2 --perf-stats``.
+   */
+  class PerformanceCounters {
+  public:
+    /** Available counters */
+    enum ECounter {
+      /** CPU cycles */
+      c_Cycles,
+      /** retired instructions */
+      c_Instructions,
+      /** last level cache misses */
+      c_CacheMisses,
+      /** mispredicted branches */
+      c_BranchMisses,
+      /** number of heap allocations */
+      c_Allocations,
+      /** number of bytes allocated on the heap */
+      c_AllocatedBytes,
+      /** number of counters */
+      c_NCounters
+    };
+
+    /** Values of all counters */
+    typedef std::array<double, c_NCounters> Values;
+
+    /** Enable or disable counting */
+    static void setEnabled(bool enabled);
+    /** Check whether counting is enabled */
+    static bool isEnabled();
+    /** Check whether the hardware counters are available for the calling thread. */
+    static bool hasHardwareCounters();
+    /** Read the current values of all counters of the calling thread, all zero if not enabled. */
+    static void read(Values& values);
+    /** Return a short name of the counter for display */
+    static const char* getName(ECounter counter);
+  };
+}
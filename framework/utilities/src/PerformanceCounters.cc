@@ -0,0 +1,247 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#include <framework/utilities/PerformanceCounters.h>
+
+#include <framework/logging/Logger.h>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+using namespace Belle2;
+
+namespace {
+  /** Whether counting is enabled */
+  std::atomic<bool> s_enabled{false};
+  /** Whether we already warned about unavailable hardware counters */
+  std::atomic<bool> s_warned{false};
+  /** Number of allocations of this thread */
+  thread_local uint64_t t_allocations{0};
+  /** Number of bytes allocated by this thread */
+  thread_local uint64_t t_allocatedBytes{0};
+
+  /** Count one allocation if enabled */
+  inline void countAllocation(std::size_t size)
+  {
+    if (s_enabled.load(std::memory_order_relaxed)) {
+      ++t_allocations;
+      t_allocatedBytes += size;
+    }
+  }
+
+  /** Group of perf_event counters for the calling thread */
+  class HardwareCounterGroup {
+  public:
+    /** Number of hardware counters */
+    static constexpr int c_NHardware = PerformanceCounters::c_BranchMisses + 1;
+
+    /** Close the counters */
+    ~HardwareCounterGroup() { close(); }
+
+    /** Read the counters, open them first if necessary. Returns false if they are not available */
+    bool read(PerformanceCounters::Values& values)
+    {
+      // file descriptors inherited from the parent process count the parent,
+      // so open new counters after a fork
+      const pid_t pid = getpid();
+      if (pid != m_pid) {
+        close();
+        m_pid = pid;
+        open();
+      }
+      if (m_nCounters == 0) return false;
+      // number of counters, time enabled, time running, values
+      uint64_t buffer[3 + c_NHardware];
+      if (::read(m_fds[0], buffer, sizeof(buffer)) <= 0) return false;
+      // if there are more counters than hardware registers the kernel multiplexes them,
+      // extrapolate to the full time the group was enabled
+      const uint64_t enabled = buffer[1];
+      const uint64_t running = buffer[2];
+      const double scale = (running > 0 and running < enabled) ? double(enabled) / running : 1.;
+      for (uint64_t i = 0; i < buffer[0] and i < m_nCounters; ++i) {
+        values[m_counters[i]] = buffer[3 + i] * scale;
+      }
+      return true;
+    }
+
+  private:
+    /** Open all counters as one group so that they are scheduled together */
+    void open()
+    {
+      static const uint64_t configs[c_NHardware] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+      };
+      for (int i = 0; i < c_NHardware; ++i) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[i];
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        const int leader = m_nCounters > 0 ? m_fds[0] : -1;
+        const int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+        if (fd < 0) {
+          // not all counters are supported everywhere, just skip the missing ones
+          if (!s_warned.exchange(true)) {
+            B2WARNING("Cannot open hardware performance counter, it will be reported as zero"
+                      << LogVar("counter", PerformanceCounters::getName(PerformanceCounters::ECounter(i)))
+                      << LogVar("error", std::strerror(errno)));
+          }
+          continue;
+        }
+        m_fds[m_nCounters] = fd;
+        m_counters[m_nCounters] = i;
+        ++m_nCounters;
+      }
+    }
+
+    /** Close all counters */
+    void close()
+    {
+      for (unsigned int i = 0; i < m_nCounters; ++i) ::close(m_fds[i]);
+      m_nCounters = 0;
+    }
+
+    /** Process the counters were opened in */
+    pid_t m_pid{0};
+    /** Number of opened counters */
+    unsigned int m_nCounters{0};
+    /** File descriptors of the counters, the first one is the group leader */
+    int m_fds[c_NHardware] {};
+    /** Counter index for each opened counter */
+    int m_counters[c_NHardware] {};
+  };
+
+  /** Counters of the calling thread */
+  thread_local HardwareCounterGroup t_hardwareCounters;
+}
+
+void PerformanceCounters::setEnabled(bool enabled)
+{
+  s_enabled = enabled;
+  if (enabled) {
+    // check that our operator new is used and not the one of a preloaded allocator
+    const uint64_t allocations = t_allocations;
+    void* volatile probe = ::operator new(1);
+    ::operator delete(probe);
+    if (t_allocations == allocations) {
+      B2WARNING("Heap allocations cannot be counted because operator new is replaced by another library "
+                "(e.g. tcmalloc or jemalloc), they will be reported as zero");
+    }
+  }
+}
+
+bool PerformanceCounters::isEnabled()
+{
+  return s_enabled;
+}
+
+bool PerformanceCounters::hasHardwareCounters()
+{
+  Values values{};
+  return t_hardwareCounters.read(values);
+}
+
+void PerformanceCounters::read(Values& values)
+{
+  values.fill(0);
+  if (!s_enabled) return;
+  t_hardwareCounters.read(values);
+  values[c_Allocations] = t_allocations;
+  values[c_AllocatedBytes] = t_allocatedBytes;
+}
+
+const char* PerformanceCounters::getName(ECounter counter)
+{
+  switch (counter) {
+    case c_Cycles: return "cycles";
+    case c_Instructions: return "instructions";
+    case c_CacheMisses: return "cache misses";
+    case c_BranchMisses: return "branch misses";
+    case c_Allocations: return "allocations";
+    case c_AllocatedBytes: return "allocated bytes";
+    default: return "unknown";
+  }
+}
+
+// Replacements of the global allocation functions to count allocations. They
+// behave exactly like the default ones which also use malloc()/free(). They are
+// always compiled in, but only count if enabled. An allocator which is preloaded
+// with LD_PRELOAD (e.g. tcmalloc or jemalloc) brings its own operator new which
+// takes precedence, in that case nothing is counted.
+
+void* operator new(std::size_t size)
+{
+  countAllocation(size);
+  if (size == 0) size = 1;
+  while (true) {
+    if (void* ptr = std::malloc(size)) return ptr;
+    std::new_handler handler = std::get_new_handler();
+    if (!handler) throw std::bad_alloc();
+    handler();
+  }
+}
+
+void* operator new[](std::size_t size)
+{
+  return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  try {
+    return ::operator new(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+  return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+  std::free(ptr);
+}
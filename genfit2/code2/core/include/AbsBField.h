@@ -54,6 +54,19 @@ public:
    * Override this in your concrete implementation.
    */
   virtual void get(const double& posX, const double& posY, const double& posZ, double& Bx, double& By, double& Bz) const { const TVector3& B(this->get(TVector3(posX, posY, posZ))); Bx = B.X(); By = B.Y(); Bz = B.Z(); }
+
+  /**
+   * @brief Get the magneticField [kGauss] at n positions at once.
+   *
+   * positions and fields are arrays of 3*n values (x, y, z of each point).
+   * Override this if your implementation can evaluate several points faster
+   * than one at a time, the default calls get() for each point.
+   */
+  virtual void getBatch(unsigned int n, const double* positions, double* fields) const {
+    for (unsigned int i = 0; i < n; ++i) {
+      this->get(positions[3*i], positions[3*i+1], positions[3*i+2], fields[3*i], fields[3*i+1], fields[3*i+2]);
+    }
+  }
  
 };
 
@@ -0,0 +1,81 @@
+/* Copyright 2008-2010, Technische Universitaet Muenchen,
+   Authors: Christian Hoeppner & Sebastian Neubert & Johannes Rauch
+
+   This file is part of GENFIT.
+
+   GENFIT is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published
+   by the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   GENFIT is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with GENFIT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+/** @addtogroup genfit
+ * @{
+ */
+
+#ifndef genfit_FieldCache_h
+#define genfit_FieldCache_h
+
+#include <vector>
+
+
+namespace genfit {
+
+/**
+ * @brief Cache of the magnetic field values at the last few positions.
+ *
+ * This does the same as the cache of the FieldManager, but it is not a global
+ * object: every user (e.g. each RKTrackRep) has its own instance so that
+ * extrapolations of different tracks, possibly in different threads, don't
+ * share any mutable state. Caching is enabled and the number of buckets is set
+ * with FieldManager::useCache().
+ */
+class FieldCache {
+
+ public:
+
+  FieldCache() : lastRead_(0), lastWritten_(0) {}
+
+  //! Get the field at the given position, from the cache if a lookup at (almost) the same position was done before.
+  void getFieldVal(double posX, double posY, double posZ, double& Bx, double& By, double& Bz);
+
+  //! Get the field at n positions (arrays of 3*n values), all positions not in the cache are evaluated in one call.
+  void getFieldVals(unsigned int n, const double* positions, double* fields);
+
+  //! Forget all cached values.
+  void clear();
+
+ private:
+
+  struct Entry {
+    double pos[3];
+    double field[3];
+  };
+
+  //! Return the index of the entry for the given position or -1 if there is none
+  int find(const double* pos);
+  //! Store a new entry, replacing the oldest one
+  void store(const double* pos, const double* field);
+  //! Make sure the number of buckets is the one configured in the FieldManager
+  void checkSize(unsigned int nBuckets);
+
+  std::vector<Entry> entries_;
+  unsigned int lastRead_;
+  unsigned int lastWritten_;
+  //! scratch space for getFieldVals()
+  std::vector<double> missingPositions_, missingFields_;
+  std::vector<unsigned int> missingIndices_;
+
+};
+
+} /* End of namespace genfit */
+/** @} */
+
+#endif // genfit_FieldCache_h
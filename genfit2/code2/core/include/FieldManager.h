@@ -74,6 +74,12 @@ class FieldManager {
   }
 #endif
 
+  //! Get the field values at n positions (arrays of 3*n values). This does NOT use the cache!
+  inline void getFieldVals(unsigned int n, const double* positions, double* fields) {
+    checkInitialized();
+    field_->getBatch(n, positions, fields);
+  }
+
   //! set the magnetic field here. Magnetic field classes must be derived from AbsBField.
   void init(AbsBField* b) {
     field_=b;
@@ -109,11 +115,30 @@ class FieldManager {
 #ifdef CACHE
   //! Cache last lookup positions, and use stored field values if a lookup at (almost) the same position is done.
   void useCache(bool opt = true, unsigned int nBuckets = 8);
+  //! Whether field values should be cached, also used for the FieldCache of each RKTrackRep.
+  bool isCacheUsed() const { return useCache_; }
+  //! Number of positions kept in the cache.
+  unsigned int getCacheBuckets() const { return n_buckets_; }
 #else
   void useCache(bool opt = true, unsigned int nBuckets = 8) {
     std::cerr << "genfit::FieldManager::useCache() - FieldManager is compiled w/o CACHE, no caching will be done!" << std::endl;
   }
+  bool isCacheUsed() const { return false; }
+  unsigned int getCacheBuckets() const { return 0; }
 #endif
+  //! Positions closer than this in all coordinates [cm] use the same cached field value.
+  static constexpr double cacheEpsilon_ = 0.001;
+
+  //! Evaluate the field at the midpoint and the end point of a Runge-Kutta step in one call.
+  /** The end point of a step depends on the field at the midpoint, so it is
+   * predicted using the field at the start point instead. This allows to
+   * evaluate both points with one call to AbsBField::getBatch(), which can
+   * be faster for field maps, but changes the result of the extrapolation
+   * slightly. The precision of each step is still checked with the correct
+   * field values.
+   */
+  void useBatchedStepping(bool opt = true) { useBatchedStepping_ = opt; }
+  bool isBatchedStepping() const { return useBatchedStepping_; }
 
   //! Get singleton instance.
   static FieldManager* getInstance(){
@@ -134,6 +159,7 @@ class FieldManager {
 #endif
   static FieldManager* instance_;
   static AbsBField* field_;
+  static bool useBatchedStepping_;
 
 #ifdef CACHE
   static bool useCache_;
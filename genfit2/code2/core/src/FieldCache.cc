@@ -0,0 +1,123 @@
+/* Copyright 2008-2010, Technische Universitaet Muenchen,
+   Authors: Christian Hoeppner & Sebastian Neubert & Johannes Rauch
+
+   This file is part of GENFIT.
+
+   GENFIT is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published
+   by the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   GENFIT is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with GENFIT.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "FieldCache.h"
+#include "FieldManager.h"
+
+#include <math.h>
+
+namespace genfit {
+
+void FieldCache::getFieldVal(double posX, double posY, double posZ, double& Bx, double& By, double& Bz) {
+  FieldManager* fieldManager = FieldManager::getInstance();
+  if (!fieldManager->isCacheUsed()) {
+    fieldManager->getField()->get(posX, posY, posZ, Bx, By, Bz);
+    return;
+  }
+  checkSize(fieldManager->getCacheBuckets());
+
+  const double pos[3] = {posX, posY, posZ};
+  int i = find(pos);
+  if (i < 0) {
+    double field[3];
+    fieldManager->getField()->get(posX, posY, posZ, field[0], field[1], field[2]);
+    store(pos, field);
+    i = lastWritten_;
+  }
+  Bx = entries_[i].field[0];
+  By = entries_[i].field[1];
+  Bz = entries_[i].field[2];
+}
+
+
+void FieldCache::getFieldVals(unsigned int n, const double* positions, double* fields) {
+  FieldManager* fieldManager = FieldManager::getInstance();
+  if (!fieldManager->isCacheUsed()) {
+    fieldManager->getFieldVals(n, positions, fields);
+    return;
+  }
+  checkSize(fieldManager->getCacheBuckets());
+
+  missingIndices_.clear();
+  missingPositions_.clear();
+  for (unsigned int i = 0; i < n; ++i) {
+    int j = find(positions + 3*i);
+    if (j < 0) {
+      missingIndices_.push_back(i);
+      missingPositions_.insert(missingPositions_.end(), positions + 3*i, positions + 3*i + 3);
+      continue;
+    }
+    for (int k = 0; k < 3; ++k) fields[3*i + k] = entries_[j].field[k];
+  }
+  if (missingIndices_.empty())
+    return;
+
+  missingFields_.resize(missingPositions_.size());
+  fieldManager->getFieldVals(missingIndices_.size(), missingPositions_.data(), missingFields_.data());
+  for (unsigned int j = 0; j < missingIndices_.size(); ++j) {
+    const unsigned int i = missingIndices_[j];
+    for (int k = 0; k < 3; ++k) fields[3*i + k] = missingFields_[3*j + k];
+    store(positions + 3*i, &missingFields_[3*j]);
+  }
+}
+
+
+void FieldCache::clear() {
+  // Should be safe to initialize with values in Andromeda
+  for (Entry& entry : entries_) {
+    entry.pos[0] = entry.pos[1] = entry.pos[2] = 2.4e24 / sqrt(3);
+    entry.field[0] = entry.field[1] = entry.field[2] = 1e30;
+  }
+  lastRead_ = lastWritten_ = 0;
+}
+
+
+int FieldCache::find(const double* pos) {
+  const double epsilon = FieldManager::cacheEpsilon_;
+  unsigned int i = lastRead_;
+  do {
+    if (fabs(entries_[i].pos[0] - pos[0]) < epsilon &&
+        fabs(entries_[i].pos[1] - pos[1]) < epsilon &&
+        fabs(entries_[i].pos[2] - pos[2]) < epsilon) {
+      return i;
+    }
+    i = (i + 1) % entries_.size();
+  } while (i != lastRead_);
+  return -1;
+}
+
+
+void FieldCache::store(const double* pos, const double* field) {
+  lastRead_ = lastWritten_ = (lastWritten_ + 1) % entries_.size();
+  Entry& entry = entries_[lastWritten_];
+  for (int k = 0; k < 3; ++k) {
+    entry.pos[k] = pos[k];
+    entry.field[k] = field[k];
+  }
+}
+
+
+void FieldCache::checkSize(unsigned int nBuckets) {
+  if (nBuckets == 0) nBuckets = 1;
+  if (entries_.size() == nBuckets)
+    return;
+  entries_.resize(nBuckets);
+  clear();
+}
+
+} /* End of namespace genfit */
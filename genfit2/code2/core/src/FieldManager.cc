@@ -25,6 +25,8 @@ namespace genfit {
 
 FieldManager* FieldManager::instance_ = nullptr;
 AbsBField* FieldManager::field_ = nullptr;
+bool FieldManager::useBatchedStepping_ = false;
+constexpr double FieldManager::cacheEpsilon_;
 
 #ifdef CACHE
 bool FieldManager::useCache_ = false;
@@ -45,7 +47,7 @@ void FieldManager::getFieldVal(const double& posX, const double& posY, const dou
     static int last_written_i = 0;
     int i = last_read_i;
 
-    static const double epsilon = 0.001;
+    static const double epsilon = cacheEpsilon_;
 
     #ifdef DEBUG
     static int used = 0;
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <cmath>
+
 #include <TVector3.h>
 
 #include <Exception.h>
@@ -215,6 +217,81 @@ namespace genfit {
         EXPECT_FLOAT_EQ(0., mySA[2]);
     }
 
+    /// Black-Box-Test
+    TEST_F (RKTrackRepTests, RKPropagateBatchedField) {
+        // in a constant field the predicted end point doesn't matter, so both modes give the same result
+        const genfit::M1x7 startState7 = {1, 2, 3, 0.48, 0.6, 0.64, 2};
+        genfit::RKTrackRep myRKTrackRep;
+        genfit::FieldManager::getInstance()->useCache();
+
+        genfit::M1x7 refState7 = startState7;
+        genfit::M1x3 refSA;
+        const double refQuality = myRKTrackRep.RKPropagate(refState7, nullptr, refSA, 5., true);
+
+        genfit::FieldManager::getInstance()->useBatchedStepping();
+        genfit::M1x7 myState7 = startState7;
+        genfit::M1x3 mySA;
+        EXPECT_DOUBLE_EQ(refQuality, myRKTrackRep.RKPropagate(myState7, nullptr, mySA, 5., true));
+        for (unsigned int i = 0; i < 7; ++i) {
+            EXPECT_DOUBLE_EQ(refState7[i], myState7[i]);
+        }
+        for (unsigned int i = 0; i < 3; ++i) {
+            EXPECT_DOUBLE_EQ(refSA[i], mySA[i]);
+        }
+        genfit::FieldManager::getInstance()->useBatchedStepping(false);
+        genfit::FieldManager::getInstance()->useCache(false);
+    }
+
+    /// Field varying along all coordinates, to check the prediction of the last Runge-Kutta point with batched stepping
+    class VaryingField : public genfit::AbsBField {
+    public:
+        TVector3 get(const TVector3& position) const override {
+            double Bx, By, Bz;
+            get(position.X(), position.Y(), position.Z(), Bx, By, Bz);
+            return TVector3(Bx, By, Bz);
+        }
+        void get(const double& posX, const double& posY, const double& posZ, double& Bx, double& By, double& Bz) const override {
+            Bx = 2. * std::sin(posZ / 20.) + 0.01 * posY;
+            By = 2. * std::cos(posX / 20.);
+            Bz = 20. * (1 + 0.3 * std::cos(posZ / 30.)) + 0.02 * posX;
+        }
+    };
+
+    /// Black-Box-Test
+    TEST_F (RKTrackRepTests, RKPropagateBatchedVaryingField) {
+        // in a varying field the predicted last point changes the result, but only far below the precision of the steps
+        VaryingField field;
+        genfit::FieldManager::getInstance()->init(&field);
+        const genfit::M1x7 startState7 = {1, 2, 3, 0.48, 0.6, 0.64, 2};
+        genfit::RKTrackRep myRKTrackRep;
+
+        // 100 steps of 2 cm
+        genfit::M1x7 refState7 = startState7;
+        genfit::M1x3 refSA;
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_GT(myRKTrackRep.RKPropagate(refState7, nullptr, refSA, 2., true), 1.);
+        }
+
+        genfit::FieldManager::getInstance()->useBatchedStepping();
+        genfit::M1x7 myState7 = startState7;
+        genfit::M1x3 mySA;
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_GT(myRKTrackRep.RKPropagate(myState7, nullptr, mySA, 2., true), 1.);
+        }
+        genfit::FieldManager::getInstance()->useBatchedStepping(false);
+        genfit::FieldManager::getInstance()->init(m_constField);
+
+        // the track is bent by the field
+        EXPECT_GT(std::fabs(refState7[3] - startState7[3]), 0.1);
+        for (unsigned int i = 0; i < 3; ++i) {
+            EXPECT_NEAR(refState7[i], myState7[i], 1e-4);
+        }
+        for (unsigned int i = 3; i < 6; ++i) {
+            EXPECT_NEAR(refState7[i], myState7[i], 1e-6);
+        }
+        EXPECT_DOUBLE_EQ(refState7[6], myState7[6]);
+    }
+
     /// White-Box-Test
     TEST_F (RKTrackRepTests, getState7) {
         RKTrackRep myRKTrackRep;
@@ -25,6 +25,7 @@
 #define genfit_RKTrackRep_h
 
 #include "AbsTrackRep.h"
+#include "FieldCache.h"
 #include "StateOnPlane.h"
 #include "RKTools.h"
 #include "StepLimits.h"
@@ -309,6 +310,8 @@ class RKTrackRep : public AbsTrackRep {
   mutable M7x7 noiseProjection_; //!
   mutable M7x7 J_MMT_; //!
 
+  mutable FieldCache fieldCache_; //! field values at the last positions, used if FieldManager::useCache() is set
+
  public:
 
   ClassDefOverride(RKTrackRep, 1)
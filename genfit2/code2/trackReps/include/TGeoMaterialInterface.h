@@ -26,6 +26,8 @@
 
 #include "AbsMaterialInterface.h"
 
+class TGeoMaterial;
+
 
 namespace genfit {
 
@@ -36,7 +38,7 @@ class TGeoMaterialInterface : public AbsMaterialInterface {
 
  public:
 
-  TGeoMaterialInterface() {};
+  TGeoMaterialInterface() : lastMaterial_(nullptr) {};
   ~TGeoMaterialInterface(){;};
 
   /** @brief Initialize the navigator at given position and with given
@@ -45,6 +47,9 @@ class TGeoMaterialInterface : public AbsMaterialInterface {
   bool initTrack(double posX, double posY, double posZ,
                  double dirX, double dirY, double dirZ) override;
 
+  /** @brief Get the parameters of the current material. They are only
+   * calculated again if the material differs from the last call.
+   */
   Material getMaterialParameters() override;
 
   /** @brief Make a step (following the curvature) until step length
@@ -61,6 +66,11 @@ class TGeoMaterialInterface : public AbsMaterialInterface {
   // ClassDefOverride(TGeoMaterialInterface, 1);
 
  private:
+
+  //! material of the last call to getMaterialParameters()
+  const TGeoMaterial* lastMaterial_;
+  //! parameters of lastMaterial_
+  Material lastMaterialParameters_;
 };
 
 } /* End of namespace genfit */
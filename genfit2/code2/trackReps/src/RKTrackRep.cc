@@ -1312,18 +1312,35 @@ double RKTrackRep::RKPropagate(M1x7& state7,
   S4 = 0.25*S;
   PS2 = state7[6]*EC * S;
 
+  // The field values are taken from the cache of this track rep instead of
+  // the global one of the FieldManager, so extrapolations of different track
+  // reps don't share any mutable state.
+  const bool batchedField = varField && FieldManager::getInstance()->isBatchedStepping();
+
   // First point
   r[0] = R[0];           r[1] = R[1];           r[2]=R[2];
-  FieldManager::getInstance()->getFieldVal(r[0], r[1], r[2], H0[0], H0[1], H0[2]);       // magnetic field in 10^-1 T = kGauss
+  fieldCache_.getFieldVal(r[0], r[1], r[2], H0[0], H0[1], H0[2]);       // magnetic field in 10^-1 T = kGauss
   H0[0] *= PS2; H0[1] *= PS2; H0[2] *= PS2;     // H0 is PS2*(Hx, Hy, Hz) @ R0
   A0 = A[1]*H0[2]-A[2]*H0[1]; B0 = A[2]*H0[0]-A[0]*H0[2]; C0 = A[0]*H0[1]-A[1]*H0[0]; // (ax, ay, az) x H0
   A2 = A[0]+A0              ; B2 = A[1]+B0              ; C2 = A[2]+C0              ; // (A0, B0, C0) + (ax, ay, az)
   A1 = A2+A[0]              ; B1 = B2+A[1]              ; C1 = C2+A[2]              ; // (A0, B0, C0) + 2*(ax, ay, az)
 
   // Second point
-  if (varField) {
+  if (batchedField) {
+    // Evaluate the field at the second and the last point in one call. The
+    // last point depends on H1, so it is predicted with H0 instead.
+    A3 = B2*H0[2]-C2*H0[1]+A[0]; B3 = C2*H0[0]-A2*H0[2]+A[1]; C3 = A2*H0[1]-B2*H0[0]+A[2]; // (A2, B2, C2) x H0 + (ax, ay, az)
+    A4 = B3*H0[2]-C3*H0[1]+A[0]; B4 = C3*H0[0]-A3*H0[2]+A[1]; C4 = A3*H0[1]-B3*H0[0]+A[2]; // (A3, B3, C3) x H0 + (ax, ay, az)
+    double points[6] = {R[0] + A1*S4, R[1] + B1*S4, R[2] + C1*S4,
+                        R[0] + S*A4,  R[1] + S*B4,  R[2] + S*C4};
+    double fields[6];
+    fieldCache_.getFieldVals(2, points, fields);
+    H1[0] = fields[0]*PS2; H1[1] = fields[1]*PS2; H1[2] = fields[2]*PS2;
+    H2[0] = fields[3]*PS2; H2[1] = fields[4]*PS2; H2[2] = fields[5]*PS2;
+  }
+  else if (varField) {
     r[0] += A1*S4;         r[1] += B1*S4;         r[2] += C1*S4;
-    FieldManager::getInstance()->getFieldVal(r[0], r[1], r[2], H1[0], H1[1], H1[2]);
+    fieldCache_.getFieldVal(r[0], r[1], r[2], H1[0], H1[1], H1[2]);
     H1[0] *= PS2; H1[1] *= PS2; H1[2] *= PS2; // H1 is PS2*(Hx, Hy, Hz) @ (x, y, z) + 0.25*S * [(A0, B0, C0) + 2*(ax, ay, az)]
   }
   else { H1 = H0; };
@@ -1332,9 +1349,12 @@ double RKTrackRep::RKPropagate(M1x7& state7,
   A5 = A4-A[0]+A4            ; B5 = B4-A[1]+B4            ; C5 = C4-A[2]+C4            ; //    2*(A4, B4, C4) - (ax, ay, az)
 
   // Last point
-  if (varField) {
+  if (batchedField) {
+    // already evaluated together with the second point
+  }
+  else if (varField) {
     r[0]=R[0]+S*A4;         r[1]=R[1]+S*B4;         r[2]=R[2]+S*C4;  //setup.Field(r,H2);
-    FieldManager::getInstance()->getFieldVal(r[0], r[1], r[2], H2[0], H2[1], H2[2]);
+    fieldCache_.getFieldVal(r[0], r[1], r[2], H2[0], H2[1], H2[2]);
     H2[0] *= PS2; H2[1] *= PS2; H2[2] *= PS2; // H2 is PS2*(Hx, Hy, Hz) @ (x, y, z) + 0.25*S * (A4, B4, C4)
   }
   else { H2 = H0; };
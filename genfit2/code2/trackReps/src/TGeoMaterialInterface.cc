@@ -61,7 +61,12 @@ TGeoMaterialInterface::initTrack(double posX, double posY, double posZ,
 Material TGeoMaterialInterface::getMaterialParameters() {
 
   TGeoMaterial* mat = gGeoManager->GetCurrentVolume()->GetMedium()->GetMaterial();
-  return Material(mat->GetDensity(), mat->GetZ(), mat->GetA(), mat->GetRadLen(), MeanExcEnergy_get(mat));
+  // the mean excitation energy of mixtures is expensive, so remember the last material
+  if (mat != lastMaterial_) {
+    lastMaterialParameters_ = Material(mat->GetDensity(), mat->GetZ(), mat->GetA(), mat->GetRadLen(), MeanExcEnergy_get(mat));
+    lastMaterial_ = mat;
+  }
+  return lastMaterialParameters_;
 
 }
 
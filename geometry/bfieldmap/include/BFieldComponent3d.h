@@ -28,6 +28,13 @@ namespace Belle2 {
    * group defines 0 to be in the center of the detector, while the detector
    * group defines the IP to be the center. The filename points to the zip file
    * containing the magnetic field map.
+   *
+   * The field values are stored in single precision as separate arrays for
+   * Br, Bphi and Bz, which halves the memory footprint compared to double
+   * precision vectors. calculateBatch() evaluates many points at once with
+   * loops the compiler can vectorize. As a reference for benchmarks the map
+   * can additionally be loaded in double precision with
+   * loadDoublePrecisionMap() and evaluated with calculateDoublePrecision().
    */
   class BFieldComponent3d : public BFieldComponentAbs {
 
@@ -54,6 +61,33 @@ namespace Belle2 {
      */
     virtual ROOT::Math::XYZVector calculate(const ROOT::Math::XYZVector& point) const override;
 
+    /**
+     * Calculates the magnetic field vectors at several space points.
+     *
+     * @param n      The number of space points.
+     * @param points The space points in [cm] at which the magnetic field vector should be calculated.
+     * @param fields Output array of size n for the magnetic field vectors at the given points in [T].
+     */
+    virtual void calculateBatch(size_t n, const ROOT::Math::XYZVector* points, ROOT::Math::XYZVector* fields) const override;
+
+    /**
+     * Reads the magnetic field map file again and keeps the field values in
+     * double precision, the way they were stored before the map was changed to
+     * single precision. This is only needed for calculateDoublePrecision().
+     */
+    void loadDoublePrecisionMap();
+
+    /**
+     * Calculates the magnetic field vector at the specified space point from
+     * the double precision map. This is meant as reference to check the
+     * accuracy and speed of calculate() and calculateBatch().
+     *
+     * @param point The space point in [cm] at which the magnetic field vector should be calculated.
+     * @return The magnetic field vector at the given space point in [T].
+     *         Returns a zero vector if loadDoublePrecisionMap() has not been called.
+     */
+    ROOT::Math::XYZVector calculateDoublePrecision(const ROOT::Math::XYZVector& point) const;
+
     /**
      * Terminates the magnetic field component.
      * This method closes the magnetic field map file.
@@ -141,15 +175,35 @@ namespace Belle2 {
 
   private:
 
+    /**
+     * Read the magnetic field map file and pass the field values of all grid
+     * points, ordered by z, r and phi, to the given function.
+     * @param fullPath The full path of the magnetic field map file.
+     * @param store    Function called with Br, Bphi and Bz of each grid point.
+     */
+    template<class STORE> void readMap(const std::string& fullPath, STORE store) const;
+
+    /**
+     * Calculate the magnetic field vector at the given space point from the
+     * single or double precision map.
+     */
+    template<bool DOUBLE_PRECISION> ROOT::Math::XYZVector calculatePoint(const ROOT::Math::XYZVector& point) const;
+
     /**
      * Interpolate the value of B-field between (ir, iphi, iz) and (ir+1, iphi+1, iz+1) using weights (wr, wphi, wz)
      */
-    ROOT::Math::XYZVector interpolate(unsigned int ir, unsigned int iphi, unsigned int iz, double wr, double wphi, double wz) const;
+    template<bool DOUBLE_PRECISION> ROOT::Math::XYZVector interpolate(unsigned int ir, unsigned int iphi, unsigned int iz, double wr, double wphi, double wz) const;
 
     /** The filename of the magnetic field map. */
     std::string m_mapFilename{""};
-    /** The memory buffer for the magnetic field map. */
-    std::vector<ROOT::Math::XYZVector> m_bmap;
+    /** The magnetic field map: Br for all grid points, ordered by z, r and phi */
+    std::vector<float> m_bmapR;
+    /** The magnetic field map: Bphi for all grid points, ordered by z, r and phi */
+    std::vector<float> m_bmapPhi;
+    /** The magnetic field map: Bz for all grid points, ordered by z, r and phi */
+    std::vector<float> m_bmapZ;
+    /** The magnetic field map in double precision, only filled by loadDoublePrecisionMap() */
+    std::vector<ROOT::Math::XYZVector> m_bmapDouble;
     /** Enable different dimension, \"rphiz\", \"rphi\", \"phiz\" or \"rz\" > */
     std::string m_mapEnable{"rphiz"};
     /** Flag to switch on/off interpolation > */
@@ -10,6 +10,8 @@
 
 #include <Math/Vector3D.h>
 
+#include <cstddef>
+
 namespace Belle2 {
 
   /**
@@ -54,6 +56,21 @@ namespace Belle2 {
      */
     virtual ROOT::Math::XYZVector calculate(const ROOT::Math::XYZVector& point) const = 0;
 
+    /**
+     * Calculates the magnetic field vectors at several space points.
+     *
+     * The default implementation calls calculate() for each point. Components
+     * which are evaluated very often can provide a vectorized implementation.
+     *
+     * @param n      The number of space points.
+     * @param points The space points in Cartesian coordinates (x,y,z) in [cm].
+     * @param fields Output array of size n for the magnetic field vectors at the given points in [T].
+     */
+    virtual void calculateBatch(size_t n, const ROOT::Math::XYZVector* points, ROOT::Math::XYZVector* fields) const
+    {
+      for (size_t i = 0; i < n; ++i) fields[i] = calculate(points[i]);
+    }
+
     /**
      * Terminates the magnetic field component.
      * This method should be used to close files that have
@@ -25,5 +25,11 @@ namespace Belle2 {
     {
       return BFieldMap::Instance().getBField(position) * Unit::T;
     }
+    /** evaluate the existing BFieldMap for many points at once */
+    virtual void getFieldBatch(size_t n, const ROOT::Math::XYZVector* position, ROOT::Math::XYZVector* field) const final override
+    {
+      BFieldMap::Instance().getBField(n, position, field);
+      for (size_t i = 0; i < n; ++i) field[i] *= Unit::T;
+    }
   };
 }
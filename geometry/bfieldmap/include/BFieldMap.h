@@ -43,6 +43,15 @@ namespace Belle2 {
      * @return A three vector of the magnetic field in [T] at the specified space point.
      */
     ROOT::Math::XYZVector getBField(const ROOT::Math::XYZVector& point) const;
+
+    /**
+     * Returns the magnetic field of the Belle II detector at several space points.
+     *
+     * @param n      The number of space points.
+     * @param points The space points in Cartesian coordinates in [cm].
+     * @param fields Output array of size n for the magnetic field vectors in [T].
+     */
+    void getBField(size_t n, const ROOT::Math::XYZVector* points, ROOT::Math::XYZVector* fields) const;
   public:
 
     /**
@@ -52,6 +61,12 @@ namespace Belle2 {
      */
     template<class BFIELDCOMP> BFIELDCOMP& addBFieldComponent();
 
+    /**
+     * Returns the first magnetic field component of the given class.
+     * @return A pointer to the component or nullptr if there is none.
+     */
+    template<class BFIELDCOMP> BFIELDCOMP* getBFieldComponent() const;
+
     /** Initialize the magnetic field after adding all components */
     void initialize();
 
@@ -98,6 +113,14 @@ namespace Belle2 {
     return *newComponent;
   }
 
+  template<class BFIELDCOMP> BFIELDCOMP* BFieldMap::getBFieldComponent() const
+  {
+    for (BFieldComponentAbs* comp : m_components) {
+      if (auto* found = dynamic_cast<BFIELDCOMP*>(comp)) return found;
+    }
+    return nullptr;
+  }
+
 
   inline ROOT::Math::XYZVector BFieldMap::getBField(const ROOT::Math::XYZVector& point) const
   {
@@ -18,6 +18,7 @@
 
 #include <TString.h>
 
+#include <algorithm>
 #include <cmath>
 
 using namespace std;
@@ -62,15 +63,43 @@ void BFieldComponent3d::initialize()
     B2DEBUG(100, Form("   map z excluded region: [%.2e, %.2e] cm",    m_exRegionZ[0], m_exRegionZ[1]));
   }
 
-  m_bmap.reserve(m_mapSize[0]*m_mapSize[1]*m_mapSize[2]);
+  const size_t mapSize = m_mapSize[0] * m_mapSize[1] * m_mapSize[2];
+  m_bmapR.clear();
+  m_bmapPhi.clear();
+  m_bmapZ.clear();
+  m_bmapR.reserve(mapSize);
+  m_bmapPhi.reserve(mapSize);
+  m_bmapZ.reserve(mapSize);
+  readMap(fullPath, [this](double Br, double Bphi, double Bz) {
+    m_bmapR.push_back(Br);
+    m_bmapPhi.push_back(Bphi);
+    m_bmapZ.push_back(Bz);
+  });
+
+  m_igridPitch[0] = 1 / m_gridPitch[0];
+  m_igridPitch[1] = 1 / m_gridPitch[1];
+  m_igridPitch[2] = 1 / m_gridPitch[2];
+
+  B2DEBUG(100, Form("BField3d:: final map region & pitch: r [%.2e,%.2e] %.2e, phi %.2e, z [%.2e,%.2e] %.2e",
+                    m_mapRegionR[0], m_mapRegionR[1], m_gridPitch[0], m_gridPitch[1],
+                    m_mapRegionZ[0], m_mapRegionZ[1], m_gridPitch[2]));
+  B2DEBUG(100, "Memory consumption: " << 3 * m_bmapR.size()*sizeof(float) / (1024 * 1024.) << " Mb");
+}
+
+template<class STORE> void BFieldComponent3d::readMap(const string& fullPath, STORE store) const
+{
   // Load B-field map file
   io::filtering_istream fieldMapFile;
   fieldMapFile.push(io::gzip_decompressor());
   fieldMapFile.push(io::file_source(fullPath));
 
+  // Introduce error on B field
+  const bool errRegion = m_errRegionR[0] != m_errRegionR[1];
   char tmp[256];
   for (int k = 0; k < m_mapSize[2]; k++) { // z
-    for (int i = 0; i < m_mapSize[0]; i++) { // r
+    double r = m_mapRegionR[0];
+    for (int i = 0; i < m_mapSize[0]; i++, r += m_gridPitch[0]) { // r
+      const bool scale = errRegion && r >= m_errRegionR[0] && r < m_errRegionR[1];
       for (int j = 0;  j < m_mapSize[1]; j++) { // phi
         double Br, Bz, Bphi;
         //r[m]  phi[deg]  z[m]  Br[T]  Bphi[T]  Bz[T]
@@ -80,36 +109,30 @@ void BFieldComponent3d::initialize()
         Br   = strtod(tmp + 33, &next);
         Bphi = strtod(next, &next);
         Bz   = strtod(next, nullptr);
-        m_bmap.emplace_back(-Br, -Bphi, -Bz);
-      }
-    }
-  }
-
-  // Introduce error on B field
-  if (m_errRegionR[0] != m_errRegionR[1]) {
-    auto it = m_bmap.begin();
-    for (int k = 0; k < m_mapSize[2]; k++) { // z
-      double r = m_mapRegionR[0];
-      for (int i = 0; i < m_mapSize[0]; i++, r += m_gridPitch[0]) { // r
-        if (!(r >= m_errRegionR[0] && r < m_errRegionR[1])) { it += m_mapSize[1];  continue;}
-        for (int j = 0;  j < m_mapSize[1]; j++) { // phi
-          ROOT::Math::XYZVector& B = *it;
-          B.SetX(B.X() * m_errB[0]);
-          B.SetY(B.Y() * m_errB[1]);
-          B.SetZ(B.Z() * m_errB[2]);
+        if (scale) {
+          Br *= m_errB[0];
+          Bphi *= m_errB[1];
+          Bz *= m_errB[2];
         }
+        store(-Br, -Bphi, -Bz);
       }
     }
   }
+}
 
-  m_igridPitch[0] = 1 / m_gridPitch[0];
-  m_igridPitch[1] = 1 / m_gridPitch[1];
-  m_igridPitch[2] = 1 / m_gridPitch[2];
-
-  B2DEBUG(100, Form("BField3d:: final map region & pitch: r [%.2e,%.2e] %.2e, phi %.2e, z [%.2e,%.2e] %.2e",
-                    m_mapRegionR[0], m_mapRegionR[1], m_gridPitch[0], m_gridPitch[1],
-                    m_mapRegionZ[0], m_mapRegionZ[1], m_gridPitch[2]));
-  B2DEBUG(100, "Memory consumption: " << m_bmap.size()*sizeof(ROOT::Math::XYZVector) / (1024 * 1024.) << " Mb");
+void BFieldComponent3d::loadDoublePrecisionMap()
+{
+  if (!m_bmapDouble.empty()) return;
+  if (m_bmapR.empty()) {
+    B2ERROR("The 3d magnetic field map has to be initialized before loading it in double precision");
+    return;
+  }
+  m_bmapDouble.reserve(m_bmapR.size());
+  readMap(FileSystem::findFile("/data/" + m_mapFilename), [this](double Br, double Bphi, double Bz) {
+    m_bmapDouble.emplace_back(Br, Bphi, Bz);
+  });
+  B2DEBUG(100, "Memory consumption of the double precision map: "
+          << m_bmapDouble.size()*sizeof(ROOT::Math::XYZVector) / (1024 * 1024.) << " Mb");
 }
 
 namespace {
@@ -182,9 +205,56 @@ namespace {
     phi = pi2 - copysign(phi, x);
     return copysign(phi, y);
   }
+
+  /** Trilinear interpolation of one field component between the grid point
+   * j000 and its neighbours in r, phi and z.
+   *
+   * @tparam T      float for a single field component or XYZVector for all three
+   * @param b        field values for all grid points
+   * @param j000     index of the lower grid point
+   * @param strideR  index difference between neighbours in r
+   * @param strideZ  index difference between neighbours in z
+   * @param wr1      weight of the upper grid point in r
+   * @param wphi1    weight of the upper grid point in phi
+   * @param wz1      weight of the upper grid point in z
+   */
+  template<class T> inline auto trilinear(const T* b, unsigned int j000, unsigned int strideR, unsigned int strideZ,
+                                          double wr1, double wphi1, double wz1)
+  {
+    const double wz0 = 1 - wz1, wr0 = 1 - wr1, wphi0 = 1 - wphi1;
+    const unsigned int j001 = j000 + 1;
+    const unsigned int j010 = j000 + strideR;
+    const unsigned int j011 = j001 + strideR;
+    const unsigned int j100 = j000 + strideZ;
+    const unsigned int j101 = j001 + strideZ;
+    const unsigned int j110 = j010 + strideZ;
+    const unsigned int j111 = j011 + strideZ;
+    const double w00 = wphi0 * wr0;
+    const double w10 = wphi0 * wr1;
+    const double w01 = wphi1 * wr0;
+    const double w11 = wphi1 * wr1;
+    return
+      (b[j000] * w00 + b[j001] * w01 + b[j010] * w10 + b[j011] * w11) * wz0 +
+      (b[j100] * w00 + b[j101] * w01 + b[j110] * w10 + b[j111] * w11) * wz1;
+  }
 }
 
 ROOT::Math::XYZVector BFieldComponent3d::calculate(const ROOT::Math::XYZVector& point) const
+{
+  return calculatePoint<false>(point);
+}
+
+ROOT::Math::XYZVector BFieldComponent3d::calculateDoublePrecision(const ROOT::Math::XYZVector& point) const
+{
+  if (m_bmapDouble.empty()) {
+    B2ERROR("The 3d magnetic field map has not been loaded in double precision, call loadDoublePrecisionMap() first");
+    return ROOT::Math::XYZVector(0, 0, 0);
+  }
+  return calculatePoint<true>(point);
+}
+
+template<bool DOUBLE_PRECISION>
+ROOT::Math::XYZVector BFieldComponent3d::calculatePoint(const ROOT::Math::XYZVector& point) const
 {
   auto getPhiIndexWeight = [this](double y, double x, double & wphi) -> unsigned int {
     double phi = fast_atan2_minimax<4>(y, x);
@@ -237,7 +307,7 @@ ROOT::Math::XYZVector BFieldComponent3d::calculate(const ROOT::Math::XYZVector&
     unsigned int iphi = getPhiIndexWeight(ay, point.X(), wphi);
 
     // Get B-field values from map
-    ROOT::Math::XYZVector b = interpolate(ir, iphi, iz, wr, wphi, wz); // in cylindrical system
+    ROOT::Math::XYZVector b = interpolate<DOUBLE_PRECISION>(ir, iphi, iz, wr, wphi, wz); // in cylindrical system
     double norm = 1 / r;
     double s = ay * norm, c = point.X() * norm;
     // Flip sign of By if y<0
@@ -246,7 +316,7 @@ ROOT::Math::XYZVector BFieldComponent3d::calculate(const ROOT::Math::XYZVector&
     B.SetXYZ(-(b.X() * c - b.Y() * s), -sgny * (b.X() * s + b.Y() * c), b.Z());
   } else {
     // Get B-field values from map in cartesian system assuming phi=0, so Bx = Br and By = Bphi
-    B = interpolate(0, 0, iz, 0, 0, wz);
+    B = interpolate<DOUBLE_PRECISION>(0, 0, iz, 0, 0, wz);
   }
 
   return B;
@@ -256,27 +326,98 @@ void BFieldComponent3d::terminate()
 {
 }
 
+template<bool DOUBLE_PRECISION>
 ROOT::Math::XYZVector BFieldComponent3d::interpolate(unsigned int ir, unsigned int iphi, unsigned int iz,
                                                      double wr1, double wphi1, double wz1) const
 {
   const unsigned int strideZ = m_mapSize[0] * m_mapSize[1];
   const unsigned int strideR = m_mapSize[1];
-
-  const double wz0 = 1 - wz1, wr0 = 1 - wr1, wphi0 = 1 - wphi1;
   const unsigned int j000 = iz * strideZ + ir * strideR + iphi;
-  const unsigned int j001 = j000 + 1;
-  const unsigned int j010 = j000 + strideR;
-  const unsigned int j011 = j001 + strideR;
-  const unsigned int j100 = j000 + strideZ;
-  const unsigned int j101 = j001 + strideZ;
-  const unsigned int j110 = j010 + strideZ;
-  const unsigned int j111 = j011 + strideZ;
-  const double w00 = wphi0 * wr0;
-  const double w10 = wphi0 * wr1;
-  const double w01 = wphi1 * wr0;
-  const double w11 = wphi1 * wr1;
-  const vector<ROOT::Math::XYZVector>& B = m_bmap;
-  return
-    (B[j000] * w00 + B[j001] * w01 + B[j010] * w10 + B[j011] * w11) * wz0 +
-    (B[j100] * w00 + B[j101] * w01 + B[j110] * w10 + B[j111] * w11) * wz1;
+  if constexpr(DOUBLE_PRECISION) {
+    return trilinear(m_bmapDouble.data(), j000, strideR, strideZ, wr1, wphi1, wz1);
+  }
+  return ROOT::Math::XYZVector(trilinear(m_bmapR.data(), j000, strideR, strideZ, wr1, wphi1, wz1),
+                               trilinear(m_bmapPhi.data(), j000, strideR, strideZ, wr1, wphi1, wz1),
+                               trilinear(m_bmapZ.data(), j000, strideR, strideZ, wr1, wphi1, wz1));
+}
+
+void BFieldComponent3d::calculateBatch(size_t n, const ROOT::Math::XYZVector* points, ROOT::Math::XYZVector* fields) const
+{
+  // The points are processed in blocks: first the grid indices and weights of
+  // all points in a block are calculated, then the map values are gathered
+  // and interpolated. Both loops are free of branches so the compiler can
+  // vectorize them. Points outside of the map get the weight 0.
+  constexpr size_t blockSize = 64;
+  const BFieldComponentBeamline& beamline = BFieldComponentBeamline::Instance();
+  const unsigned int strideZ = m_mapSize[0] * m_mapSize[1];
+  const unsigned int strideR = m_mapSize[1];
+  // local copies of all members used in the loops so the compiler knows they don't change
+  const double minZ = m_mapRegionZ[0], maxZ = m_mapRegionZ[1], minR = m_mapRegionR[0];
+  const double minR2 = m_mapRegionR[0] * m_mapRegionR[0], maxR2 = m_mapRegionR[1] * m_mapRegionR[1];
+  const bool exRegion = m_exRegion;
+  const double exMinZ = m_exRegionZ[0], exMaxZ = m_exRegionZ[1];
+  const double exMinR2 = m_exRegionR[0] * m_exRegionR[0], exMaxR2 = m_exRegionR[1] * m_exRegionR[1];
+  const double invPitchR = m_igridPitch[0], invPitchPhi = m_igridPitch[1], invPitchZ = m_igridPitch[2];
+  const int maxIR = m_mapSize[0] - 2, maxIPhi = m_mapSize[1] - 2, maxIZ = m_mapSize[2] - 2;
+  const float* bR = m_bmapR.data();
+  const float* bPhi = m_bmapPhi.data();
+  const float* bZ = m_bmapZ.data();
+
+  unsigned int index[blockSize];
+  double wr[blockSize], wphi[blockSize], wz[blockSize];
+  double cosPhi[blockSize], sinPhi[blockSize], signY[blockSize], weight[blockSize];
+  for (size_t start = 0; start < n; start += blockSize) {
+    const size_t size = std::min(blockSize, n - start);
+    const ROOT::Math::XYZVector* point = points + start;
+    ROOT::Math::XYZVector* field = fields + start;
+
+    // '3d' component returns zero field where 'Beamline' component is defined, see calculate()
+    for (size_t i = 0; i < size; ++i) {
+      weight[i] = beamline.isInRange(point[i]) ? 0. : 1.;
+    }
+
+    #pragma omp simd
+    for (size_t i = 0; i < size; ++i) {
+      const double x = point[i].X(), y = point[i].Y(), z = point[i].Z();
+      const double r2 = x * x + y * y;
+      const bool excluded = exRegion & (z >= exMinZ) & (z < exMaxZ) & (r2 >= exMinR2) & (r2 < exMaxR2);
+      // masks are kept as doubles, selecting between floating point expressions prevents vectorization
+      const double inside = ((z >= minZ) & (z <= maxZ) & (r2 >= minR2) & (r2 < maxR2) & !excluded) ? 1. : 0.;
+      const double onAxis = r2 > 0 ? 0. : 1.;
+      const double useR = inside * (1 - onAxis);
+      weight[i] *= inside;
+
+      // Note that z coordinate is inverted to match ANSYS frame.
+      // The max() calls have the 0 first so that NaN (atan2 on the axis) becomes 0.
+      const double fz = std::max(0., (maxZ - z) * invPitchZ * inside);
+      const int iz = std::min(static_cast<int>(fz), maxIZ);
+      wz[i] = fz - iz;
+
+      const double r = std::sqrt(r2);
+      const double fr = std::max(0., (r - minR) * invPitchR * useR);
+      const int ir = std::min(static_cast<int>(fr), maxIR);
+      wr[i] = fr - ir;
+
+      const double ay = std::abs(y);
+      const double fphi = std::max(0., fast_atan2_minimax<4>(ay, x) * invPitchPhi * useR);
+      const int iphi = std::min(static_cast<int>(fphi), maxIPhi);
+      wphi[i] = fphi - iphi;
+      index[i] = iz * strideZ + ir * strideR + iphi;
+
+      // on the axis the map values are used as cartesian components, see calculate()
+      const double norm = 1 / (r + onAxis);
+      cosPhi[i] = x * norm - onAxis;
+      sinPhi[i] = ay * norm;
+      signY[i] = y < 0 ? -1. : 1.;
+    }
+
+    #pragma omp simd
+    for (size_t i = 0; i < size; ++i) {
+      const double br = trilinear(bR, index[i], strideR, strideZ, wr[i], wphi[i], wz[i]);
+      const double bphi = trilinear(bPhi, index[i], strideR, strideZ, wr[i], wphi[i], wz[i]);
+      const double bz = trilinear(bZ, index[i], strideR, strideZ, wr[i], wphi[i], wz[i]);
+      const double w = weight[i];
+      field[i].SetXYZ(-w * (br * cosPhi[i] - bphi * sinPhi[i]), -w * signY[i] * (br * sinPhi[i] + bphi * cosPhi[i]), w * bz);
+    }
+  }
 }
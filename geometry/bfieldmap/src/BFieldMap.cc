@@ -9,6 +9,9 @@
 #include <geometry/bfieldmap/BFieldMap.h>
 #include <framework/logging/Logger.h>
 
+#include <cmath>
+#include <vector>
+
 using namespace std;
 using namespace Belle2;
 
@@ -37,6 +40,30 @@ void BFieldMap::clear()
   m_components.clear();
 }
 
+void BFieldMap::getBField(size_t n, const ROOT::Math::XYZVector* points, ROOT::Math::XYZVector* fields) const
+{
+  for (size_t i = 0; i < n; ++i) {
+    const ROOT::Math::XYZVector& point = points[i];
+    if (std::isnan(point.X()) || std::isnan(point.Y()) || std::isnan(point.Z())) {
+      // rare error case, let the single point version handle it
+      for (size_t j = 0; j < n; ++j) fields[j] = getBField(points[j]);
+      return;
+    }
+  }
+
+  if (m_components.size() == 1) {
+    m_components.front()->calculateBatch(n, points, fields);
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) fields[i].SetXYZ(0, 0, 0);
+  thread_local std::vector<ROOT::Math::XYZVector> componentFields;
+  componentFields.resize(n);
+  for (const BFieldComponentAbs* comp : m_components) {
+    comp->calculateBatch(n, points, componentFields.data());
+    for (size_t i = 0; i < n; ++i) fields[i] += componentFields[i];
+  }
+}
+
 //====================================================================
 //                          Private methods
 //====================================================================
@@ -0,0 +1,40 @@
+#!/usr/bin/env python3
+
+##########################################################################
+# basf2 (Belle II Analysis Software Framework)                           #
+# Author: The Belle II Collaboration                                     #
+#                                                                        #
+# See git log for contributors and copyright holders.                    #
+# This file is licensed under LGPL-3.0, see LICENSE.md.                  #
+##########################################################################
+
+##############################################################################
+# This steering file compares the evaluation of the Belle II magnetic field
+# map one point at a time with the batched evaluation, for points along random
+# helices from the origin. The 3d field map is also compared with a double
+# precision copy of the same map. The time per point and the largest
+# differences between the methods are printed.
+##############################################################################
+
+from basf2 import Path, process, set_random_seed
+
+set_random_seed(42)
+
+path = Path()
+path.add_module("EventInfoSetter")
+# use the 3d field map from the geometry description instead of the database
+path.add_module("Gearbox")
+path.add_module("Geometry", components=["MagneticField"], useDB=False)
+path.add_module("BenchmarkFieldMap", **{
+    # number of helices
+    "nTracks": 2000,
+    # number of points along each helix
+    "nSteps": 500,
+    # distance between the points in cm
+    "stepLength": 0.5,
+    # minimal transverse momentum of the helices in GeV
+    "minPt": 0.1,
+    # number of times each evaluation is repeated
+    "nRepetitions": 5,
+})
+process(path)
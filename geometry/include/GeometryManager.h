@@ -13,6 +13,7 @@
 #include <string>
 #include <memory>
 #include <map>
+#include <utility>
 
 class G4VPhysicalVolume;
 class G4VisAttributes;
@@ -162,6 +163,16 @@ namespace Belle2 {
        */
       G4VisAttributes* newVisAttributes();
 
+      /**
+       * Return the time in ms spent in each phase of the last geometry creation:
+       * opening the Gearbox, creating the materials, each component, closing the
+       * geometry and the conversion to TGeo if it was done.
+       */
+      const std::vector<std::pair<std::string, double>>& getTimingReport() const { return m_timingReport; }
+
+      /** Print the timing report of the last geometry creation */
+      void printTimingReport() const;
+
     private:
       /** Default constructor declared private since class is a Singleton. */
       GeometryManager(): m_topVolume(0) {};
@@ -190,6 +201,8 @@ namespace Belle2 {
       bool m_assignRegions {false};
       /** List of visualization attributes */
       std::vector<G4VisAttributes*> m_VisAttributes;
+      /** Time in ms spent in each phase of the last geometry creation */
+      std::vector<std::pair<std::string, double>> m_timingReport;
       /** Allow destruction of instance */
       friend struct std::default_delete<GeometryManager>;
     };
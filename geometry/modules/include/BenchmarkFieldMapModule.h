@@ -0,0 +1,51 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#pragma once
+
+#include <framework/core/Module.h>
+
+namespace Belle2 {
+  class BFieldComponent3d;
+
+  /**
+   * Compare the evaluation of the magnetic field one point at a time with the
+   * batched evaluation for points along random helices from the origin. The
+   * single precision 3d field map is also compared with a double precision
+   * copy of the same map for accuracy and speed.
+   */
+  class BenchmarkFieldMapModule : public Module {
+
+  public:
+    /**
+     * Constructor: Sets the description, the properties and the parameters of
+     * the module.
+     */
+    BenchmarkFieldMapModule();
+
+    /** Check input parameters and load the double precision map */
+    virtual void initialize() override;
+
+    /** Run the benchmark */
+    virtual void beginRun() override;
+
+  private:
+    /** number of helices */
+    int m_nTracks{1000};
+    /** number of points along each helix */
+    int m_nSteps{500};
+    /** distance between the points along each helix */
+    double m_stepLength{0.5};
+    /** minimal transverse momentum of the helices */
+    double m_minPt{0.1};
+    /** number of times each evaluation is repeated */
+    int m_nRepetitions{5};
+    /** the 3d field map component, nullptr if there is none */
+    BFieldComponent3d* m_component{nullptr};
+  };
+}
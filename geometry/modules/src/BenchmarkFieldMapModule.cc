@@ -0,0 +1,134 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+
+#include <geometry/modules/BenchmarkFieldMapModule.h>
+#include <geometry/bfieldmap/BFieldComponent3d.h>
+#include <geometry/bfieldmap/BFieldMap.h>
+#include <framework/geometry/BFieldManager.h>
+#include <framework/gearbox/Const.h>
+#include <framework/gearbox/Unit.h>
+#include <framework/utilities/Utils.h>
+
+#include <Math/Vector3D.h>
+#include <TRandom.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace Belle2;
+
+//-----------------------------------------------------------------
+//                 Register the Module
+//-----------------------------------------------------------------
+REG_MODULE(BenchmarkFieldMap);
+
+//-----------------------------------------------------------------
+//                 Implementation
+//-----------------------------------------------------------------
+BenchmarkFieldMapModule::BenchmarkFieldMapModule() : Module()
+{
+  // Set module properties
+  setDescription("Compare speed and result of evaluating the magnetic field one point at a time "
+                 "and in batches for points along random helices starting at the origin. The 3d "
+                 "field map is also compared with a double precision copy of the map. This needs "
+                 "the field from the geometry description, i.e. the Geometry module with useDB=False");
+
+  // Parameter definitions
+  addParam("nTracks", m_nTracks, "number of helices", m_nTracks);
+  addParam("nSteps", m_nSteps, "number of points along each helix", m_nSteps);
+  addParam("stepLength", m_stepLength, "distance between the points along each helix in cm", m_stepLength);
+  addParam("minPt", m_minPt, "minimal transverse momentum of the helices in GeV", m_minPt);
+  addParam("nRepetitions", m_nRepetitions, "number of times each evaluation is repeated", m_nRepetitions);
+}
+
+void BenchmarkFieldMapModule::initialize()
+{
+  if (m_nTracks <= 0 || m_nSteps <= 0 || m_nRepetitions <= 0) {
+    B2ERROR("Number of tracks, steps and repetitions have to be positive");
+  }
+  if (m_stepLength <= 0 || m_minPt <= 0) {
+    B2ERROR("Step length and minimal transverse momentum have to be positive");
+  }
+  m_component = BFieldMap::Instance().getBFieldComponent<BFieldComponent3d>();
+  if (!m_component) {
+    B2ERROR("There is no 3d magnetic field map, please add the Geometry module with useDB=False before this module");
+    return;
+  }
+  m_component->loadDoublePrecisionMap();
+}
+
+void BenchmarkFieldMapModule::beginRun()
+{
+  // Helices with the curvature given by the nominal field so that they
+  // stay in the tracking volume for low momenta
+  const double bz = BFieldManager::getFieldInTesla(ROOT::Math::XYZVector(0, 0, 0)).Z();
+  std::vector<ROOT::Math::XYZVector> points;
+  points.reserve(m_nTracks * m_nSteps);
+  for (int track = 0; track < m_nTracks; ++track) {
+    const double pt = m_minPt / gRandom->Uniform(0, 1);
+    const double radius = pt / (Const::speedOfLight * 1e-4 * std::max(std::abs(bz), 0.1)) * Unit::cm;
+    const double phi0 = gRandom->Uniform(0, 2 * M_PI);
+    const double tanLambda = std::tan(gRandom->Uniform(-1.2, 1.2));
+    const double charge = gRandom->Uniform(-1, 1) > 0 ? 1 : -1;
+    for (int step = 0; step < m_nSteps; ++step) {
+      const double s = step * m_stepLength / std::sqrt(1 + tanLambda * tanLambda);
+      const double alpha = charge * s / radius;
+      points.emplace_back(charge * radius * (std::sin(phi0 + alpha) - std::sin(phi0)),
+                          -charge * radius * (std::cos(phi0 + alpha) - std::cos(phi0)),
+                          tanLambda * s);
+    }
+  }
+
+  const size_t n = points.size();
+  std::vector<ROOT::Math::XYZVector> single(n), batch(n), reference(n), map(n), mapBatch(n);
+  // first evaluation to make sure everything is loaded
+  BFieldManager::getField(points, batch);
+
+  double singleTime{0}, batchTime{0}, referenceTime{0}, mapTime{0}, mapBatchTime{0};
+  for (int repetition = 0; repetition < m_nRepetitions; ++repetition) {
+    double start = Utils::getClock();
+    for (size_t i = 0; i < n; ++i) single[i] = BFieldManager::getField(points[i]);
+    singleTime += Utils::getClock() - start;
+    start = Utils::getClock();
+    BFieldManager::getField(points, batch);
+    batchTime += Utils::getClock() - start;
+    if (!m_component) continue;
+    start = Utils::getClock();
+    for (size_t i = 0; i < n; ++i) reference[i] = m_component->calculateDoublePrecision(points[i]);
+    referenceTime += Utils::getClock() - start;
+    start = Utils::getClock();
+    for (size_t i = 0; i < n; ++i) map[i] = m_component->calculate(points[i]);
+    mapTime += Utils::getClock() - start;
+    start = Utils::getClock();
+    m_component->calculateBatch(n, points.data(), mapBatch.data());
+    mapBatchTime += Utils::getClock() - start;
+  }
+
+  double maxDiff{0}, maxField{0}, maxMapDiff{0}, maxMapBatchDiff{0};
+  for (size_t i = 0; i < n; ++i) {
+    maxDiff = std::max(maxDiff, (single[i] - batch[i]).R());
+    maxField = std::max(maxField, single[i].R());
+    maxMapDiff = std::max(maxMapDiff, (map[i] - reference[i]).R());
+    maxMapBatchDiff = std::max(maxMapBatchDiff, (mapBatch[i] - reference[i]).R());
+  }
+  const double nEvaluations = n * m_nRepetitions;
+  B2INFO("Magnetic field evaluation along helices"
+         << LogVar("points", n)
+         << LogVar("single point [ns/point]", singleTime / nEvaluations / Unit::ns)
+         << LogVar("batch [ns/point]", batchTime / nEvaluations / Unit::ns)
+         << LogVar("max |B| [T]", maxField / Unit::T)
+         << LogVar("max |B(single) - B(batch)| [T]", maxDiff / Unit::T));
+  if (!m_component) return;
+  B2INFO("3d field map compared with the double precision map"
+         << LogVar("double precision [ns/point]", referenceTime / nEvaluations / Unit::ns)
+         << LogVar("single precision [ns/point]", mapTime / nEvaluations / Unit::ns)
+         << LogVar("single precision batch [ns/point]", mapBatchTime / nEvaluations / Unit::ns)
+         << LogVar("max |B(single precision) - B(double precision)| [T]", maxMapDiff / Unit::T)
+         << LogVar("max |B(single precision batch) - B(double precision)| [T]", maxMapBatchDiff / Unit::T));
+}
@@ -49,6 +49,9 @@ GeometryModule::GeometryModule()
   addParam("payloadIov", m_payloadIov, "Payload IoV when creating a geometry configuration", m_payloadIov);
   addParam("createPayloads", m_createGeometryPayload, "If true create a "
            "Geometry payload with the given configuration", m_createGeometryPayload);
+  addParam("printTimingReport", m_printTimingReport, "If true print the time "
+           "spent opening the Gearbox, creating the materials and each component "
+           "and closing the geometry", m_printTimingReport);
 }
 
 void GeometryModule::initialize()
@@ -107,6 +110,7 @@ void GeometryModule::initialize()
     // Make sure that we abort as soon as the geometry changes
     m_geometryConfig->addCallback([]() {B2FATAL("Geometry cannot change during processing, aborting");});
     geoManager.createGeometry(**m_geometryConfig);
+    if (m_printTimingReport) geoManager.printTimingReport();
   } else {
     StoreObjPtr<EventMetaData> evtMeta;
     if (!evtMeta.isValid() or not(evtMeta->getExperiment() == 0 and evtMeta->getRun() == 0)) {
@@ -141,6 +145,7 @@ void GeometryModule::initialize()
 
     YOU HAVE BEEN WARNED!)RAW");
     geoManager.createGeometry(GearDir(m_geometryPath), geometry::FullGeometry);
+    if (m_printTimingReport) geoManager.printTimingReport();
   }
 }
 
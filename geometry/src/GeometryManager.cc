@@ -8,6 +8,8 @@
 
 #include <framework/logging/Logger.h>
 #include <framework/gearbox/GearDir.h>
+#include <framework/gearbox/Gearbox.h>
+#include <framework/utilities/Utils.h>
 #include <framework/database/IntervalOfValidity.h>
 #include <geometry/GeometryManager.h>
 #include <geometry/Materials.h>
@@ -43,7 +45,9 @@
 #include "VGM/volumes/IPlacement.h"
 #include "TGeoManager.h"
 
+#include <iomanip>
 #include <memory>
+#include <sstream>
 
 using namespace std;
 
@@ -223,6 +227,19 @@ namespace Belle2 {
       // remove the old geometry
       clear();
 
+      // keep track of the time spent in each phase, starting with the gearbox which was opened before
+      m_timingReport.clear();
+      const Gearbox& gearbox = Gearbox::getInstance();
+      if (gearbox.isOpen()) {
+        m_timingReport.emplace_back(gearbox.isUsingCache() ? "Gearbox (query cache)" : "Gearbox (xml parsing)", gearbox.getOpenTime());
+      }
+      double phaseStart = Utils::getClock();
+      auto endPhase = [this, &phaseStart](const std::string & name) {
+        const double now = Utils::getClock();
+        m_timingReport.emplace_back(name, (now - phaseStart) / Unit::ms);
+        phaseStart = now;
+      };
+
       // if we don't use the DB make sure the magnetic field is properly set
       // by adding it as a fake database payload
       BFieldMap::Instance().clear();
@@ -244,6 +261,7 @@ namespace Belle2 {
       for (const GeoMaterial& mat : config.getMaterials()) {
         materials.createMaterial(mat);
       }
+      endPhase("Materials");
 
       //Now set Top volume. Be aware that Geant4 uses "half size" so the size
       //will be in each direction even though the member name suggests a total size
@@ -306,6 +324,7 @@ namespace Belle2 {
           m_creators.push_back(creator);
           //Done creating things, please reset density scaling
           Materials::getInstance().resetDensityScale();
+          endPhase(component.getName());
           if (m_assignRegions) {
             //Automatically assign a region with the creator name to all volumes
             G4Region* region {nullptr};
@@ -339,6 +358,7 @@ namespace Belle2 {
 
       B2DEBUG(50, "Optimizing geometry and creating lookup tables ...");
       G4GeometryManager::GetInstance()->CloseGeometry(true, LogSystem::Instance().isLevelEnabled(LogConfig::c_Debug, 200, PACKAGENAME()));
+      endPhase("Close geometry");
     }
 
     void GeometryManager::createTGeoRepresentation()
@@ -348,6 +368,7 @@ namespace Belle2 {
         return;
       }
 
+      const double start = Utils::getClock();
       Geant4GM::Factory g4Factory;
       if (LogSystem::Instance().isLevelEnabled(LogConfig::c_Debug, 200, PACKAGENAME())) {
         g4Factory.SetDebug(1);
@@ -362,6 +383,20 @@ namespace Belle2 {
       gGeoManager->CloseGeometry();
       delete g4Factory.Top();
       delete rtFactory.Top();
+      m_timingReport.emplace_back("TGeo conversion", (Utils::getClock() - start) / Unit::ms);
+    }
+
+    void GeometryManager::printTimingReport() const
+    {
+      double total{0};
+      std::stringstream report;
+      report << "Geometry creation time per phase:" << std::fixed << std::setprecision(1);
+      for (const auto& [name, time] : m_timingReport) {
+        report << std::endl << "  " << std::left << std::setw(30) << name << std::right << std::setw(12) << time << " ms";
+        total += time;
+      }
+      report << std::endl << "  " << std::left << std::setw(30) << "Total" << std::right << std::setw(12) << total << " ms";
+      B2INFO(report.str());
     }
 
     G4VisAttributes* GeometryManager::newVisAttributes()
@@ -0,0 +1,180 @@
+/**************************************************************************
+ * basf2 (Belle II Analysis Software Framework)                           *
+ * Author: The Belle II Collaboration                                     *
+ *                                                                        *
+ * See git log for contributors and copyright holders.                    *
+ * This file is licensed under LGPL-3.0, see LICENSE.md.                  *
+ **************************************************************************/
+#include <geometry/bfieldmap/BFieldComponent3d.h>
+#include <framework/utilities/TestHelpers.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/device/file.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+namespace io = boost::iostreams;
+
+namespace Belle2 {
+  namespace {
+    /** Test fixture writing a small 3d field map with a known field into a temporary directory.
+     *
+     * The field in the map is B_r = alpha * r and B_z = beta + gamma * z,
+     * so the trilinear interpolation reproduces it exactly and the result
+     * can be compared to the analytic field.
+     */
+    class BFieldComponent3dTest : public ::testing::Test {
+    protected:
+      /** Write the map and set up the component */
+      void SetUp() override
+      {
+        // the map is searched in $BELLE2_LOCAL_DIR/data
+        const char* localDir = getenv("BELLE2_LOCAL_DIR");
+        m_hadLocalDir = localDir != nullptr;
+        if (m_hadLocalDir) m_oldLocalDir = localDir;
+        setenv("BELLE2_LOCAL_DIR", m_tempDir.getTempDir().c_str(), 1);
+        std::filesystem::create_directory("data");
+
+        io::filtering_ostream mapFile;
+        mapFile.push(io::gzip_compressor());
+        mapFile.push(io::file_sink("data/testmap.dat.gz"));
+        char line[256];
+        for (int k = 0; k < c_sizeZ; k++) { // z, inverted as in the ANSYS frame
+          const double z = c_maxZ - k * c_pitchZ;
+          for (int i = 0; i < c_sizeR; i++) { // r
+            const double r = i * c_pitchR;
+            for (int j = 0; j < c_sizePhi; j++) { // phi
+              // the values start at column 33, see BFieldComponent3d::initialize()
+              snprintf(line, sizeof(line), "%10.4f %10.4f %10.4f %.9g %.9g %.9g\n", r / 100, j * 15., z / 100,
+                       c_alpha * r, 0., c_beta + c_gamma * z);
+              mapFile << line;
+            }
+          }
+        }
+        mapFile.reset();
+
+        m_component.setMapFilename("testmap.dat.gz");
+        m_component.setMapSize(c_sizeR, c_sizePhi, c_sizeZ);
+        m_component.setMapRegionZ(-c_maxZ, c_maxZ, 0);
+        m_component.setMapRegionR(0, (c_sizeR - 1) * c_pitchR);
+        m_component.setGridPitch(c_pitchR, M_PI / (c_sizePhi - 1), c_pitchZ);
+        m_component.setExcludeRegionR(0, 20);
+        m_component.setExcludeRegionZ(-20, 20);
+        m_component.initialize();
+      }
+
+      /** Restore the environment */
+      void TearDown() override
+      {
+        if (m_hadLocalDir) setenv("BELLE2_LOCAL_DIR", m_oldLocalDir.c_str(), 1);
+        else unsetenv("BELLE2_LOCAL_DIR");
+      }
+
+      /** Random points covering the map, the region outside and the excluded region */
+      vector<ROOT::Math::XYZVector> getPoints(size_t n) const
+      {
+        mt19937 generator(42);
+        uniform_real_distribution<double> uniform(-220, 220);
+        vector<ROOT::Math::XYZVector> points(n);
+        for (auto& p : points) p.SetXYZ(uniform(generator), uniform(generator), uniform(generator));
+        // on the axis, on the x axis for both signs of x and in the excluded region
+        points[0].SetXYZ(0, 0, 50);
+        points[1].SetXYZ(50, 0, -30);
+        points[2].SetXYZ(-50, 0, 30);
+        points[3].SetXYZ(10, -5, 0);
+        return points;
+      }
+
+      /** number of grid points in r */
+      static constexpr int c_sizeR = 21;
+      /** number of grid points in phi */
+      static constexpr int c_sizePhi = 13;
+      /** number of grid points in z */
+      static constexpr int c_sizeZ = 31;
+      /** grid pitch in r [cm] */
+      static constexpr double c_pitchR = 10;
+      /** grid pitch in z [cm] */
+      static constexpr double c_pitchZ = 10;
+      /** upper end of the map in z [cm] */
+      static constexpr double c_maxZ = 150;
+      /** B_r = alpha * r */
+      static constexpr double c_alpha = 1e-3;
+      /** B_z = beta + gamma * z */
+      static constexpr double c_beta = 1.5;
+      /** B_z = beta + gamma * z */
+      static constexpr double c_gamma = 2e-4;
+
+      /** temporary directory for the map */
+      TestHelpers::TempDirCreator m_tempDir;
+      /** whether BELLE2_LOCAL_DIR was set before the test */
+      bool m_hadLocalDir{false};
+      /** previous value of BELLE2_LOCAL_DIR */
+      string m_oldLocalDir;
+      /** the field component to test */
+      BFieldComponent3d m_component;
+    };
+
+    /** Check that the interpolation reproduces the field in the map */
+    TEST_F(BFieldComponent3dTest, Interpolation)
+    {
+      for (const auto& p : getPoints(10000)) {
+        const ROOT::Math::XYZVector b = m_component.calculate(p);
+        const double r = p.Rho();
+        const bool inside = std::abs(p.Z()) <= c_maxZ and r < (c_sizeR - 1) * c_pitchR and
+                            not(std::abs(p.Z()) < 20 and r < 20);
+        if (!inside) {
+          EXPECT_EQ(b.Mag2(), 0);
+          continue;
+        }
+        // the map stores the field in single precision
+        EXPECT_NEAR(b.X(), c_alpha * p.X(), 1e-6);
+        EXPECT_NEAR(b.Y(), c_alpha * p.Y(), 1e-6);
+        EXPECT_NEAR(b.Z(), -(c_beta + c_gamma * p.Z()), 1e-6);
+      }
+    }
+
+    /** Check that the batched evaluation gives the same result as the single point one */
+    TEST_F(BFieldComponent3dTest, Batch)
+    {
+      // more than one block and a partial block
+      const vector<ROOT::Math::XYZVector> points = getPoints(1000);
+      vector<ROOT::Math::XYZVector> fields(points.size());
+      m_component.calculateBatch(points.size(), points.data(), fields.data());
+      for (size_t i = 0; i < points.size(); ++i) {
+        const ROOT::Math::XYZVector expected = m_component.calculate(points[i]);
+        EXPECT_NEAR(fields[i].X(), expected.X(), 1e-12) << "point " << i;
+        EXPECT_NEAR(fields[i].Y(), expected.Y(), 1e-12) << "point " << i;
+        EXPECT_NEAR(fields[i].Z(), expected.Z(), 1e-12) << "point " << i;
+      }
+    }
+
+    /** Check that the single precision map agrees with the double precision reference */
+    TEST_F(BFieldComponent3dTest, DoublePrecision)
+    {
+      m_component.loadDoublePrecisionMap();
+      for (const auto& p : getPoints(10000)) {
+        const ROOT::Math::XYZVector reference = m_component.calculateDoublePrecision(p);
+        const ROOT::Math::XYZVector b = m_component.calculate(p);
+        EXPECT_NEAR(b.X(), reference.X(), 1e-6);
+        EXPECT_NEAR(b.Y(), reference.Y(), 1e-6);
+        EXPECT_NEAR(b.Z(), reference.Z(), 1e-6);
+      }
+      // the double precision map reproduces the field exactly up to rounding
+      const ROOT::Math::XYZVector p(60, 40, 70);
+      const ROOT::Math::XYZVector reference = m_component.calculateDoublePrecision(p);
+      EXPECT_NEAR(reference.X(), c_alpha * p.X(), 1e-9);
+      EXPECT_NEAR(reference.Y(), c_alpha * p.Y(), 1e-9);
+      EXPECT_NEAR(reference.Z(), -(c_beta + c_gamma * p.Z()), 1e-9);
+    }
+  }
+}
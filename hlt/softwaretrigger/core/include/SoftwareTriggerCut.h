@@ -95,9 +95,11 @@ namespace Belle2 {
        * Return both the prescaled and the non-prescaled result. This function should only be use experts, you basically always want to
        * use the checkPreScaled function.
        * Returns a pair [prescaled, non-prescaled]
+       * The optional variable cache can be shared between all cuts checked on the same object,
+       * so each variable is only looked up once.
        */
       std::pair<SoftwareTriggerCutResult, SoftwareTriggerCutResult> check(const SoftwareTriggerVariableManager::Object& prefilledObject,
-          uint32_t* counter = nullptr)
+          uint32_t* counter = nullptr, GeneralCut<SoftwareTriggerVariableManager>::VariableCache* cache = nullptr)
       const;
 
     private:
@@ -18,7 +18,8 @@ namespace Belle2 {
         unsigned int prescaleFactor,
         const bool rejectCut)
     {
-      auto compiledGeneralCut = GeneralCut<SoftwareTriggerVariableManager>::compile(cut_string);
+      // the variables are plain lookups in the prefilled object, so the clauses can be reordered freely
+      auto compiledGeneralCut = GeneralCut<SoftwareTriggerVariableManager>::compile(cut_string, true);
       std::unique_ptr<SoftwareTriggerCut> compiledSoftwareTriggerCut(new SoftwareTriggerCut(std::move(compiledGeneralCut),
           prescaleFactor, rejectCut));
 
@@ -26,12 +27,13 @@ namespace Belle2 {
     }
 
     std::pair<SoftwareTriggerCutResult, SoftwareTriggerCutResult> SoftwareTriggerCut::check(const
-        SoftwareTriggerVariableManager::Object& prefilledObject, uint32_t* counter) const
+        SoftwareTriggerVariableManager::Object& prefilledObject, uint32_t* counter,
+        GeneralCut<SoftwareTriggerVariableManager>::VariableCache* cache) const
     {
       if (not m_cut) {
         B2FATAL("Software Trigger is not initialized!");
       }
-      const bool cutCondition = m_cut->check(&prefilledObject);
+      const bool cutCondition = cache ? m_cut->check(&prefilledObject, *cache) : m_cut->check(&prefilledObject);
 
       // If the cut is a reject cut, return false if the cut is true and false if the cut is true.
       if (isRejectCut()) {
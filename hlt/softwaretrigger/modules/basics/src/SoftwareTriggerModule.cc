@@ -159,6 +159,8 @@ void SoftwareTriggerModule::makeCut(const SoftwareTriggerObject& prefilledObject
   // Define the pointer to the counter and the index of each counter in m_counters.
   uint32_t* counter{nullptr};
   size_t counterIndex{0};
+  // Most variables are used by several cuts, look them up only once
+  GeneralCut<SoftwareTriggerVariableManager>::VariableCache variableCache;
   // Check all cuts with the prefilled object and write them back into the data store.
   for (const auto& cutWithName : m_dbHandler->getCutsWithNames()) {
     const std::string& cutIdentifier = cutWithName.first;
@@ -167,7 +169,7 @@ void SoftwareTriggerModule::makeCut(const SoftwareTriggerObject& prefilledObject
     if (not m_param_useRandomNumbersForPreScale) {
       counter = &m_counters.at(counterIndex++);
     }
-    const auto& [prescaledCutResult, nonPrescaledCutResult] = cut->check(prefilledObject, counter);
+    const auto& [prescaledCutResult, nonPrescaledCutResult] = cut->check(prefilledObject, counter, &variableCache);
     m_resultStoreObjectPointer->addResult(cutIdentifier, prescaledCutResult, nonPrescaledCutResult);
   }
 
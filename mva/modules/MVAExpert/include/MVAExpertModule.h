@@ -83,9 +83,9 @@ namespace Belle2 {
     void fillDataset(const Particle*);
 
     /**
-     * Set the extra info field.
+     * Set the extra info field with the given key, see ParticleExtraInfoMap::getKey().
      */
-    void setExtraInfoField(Particle*, std::string, float);
+    void setExtraInfoField(Particle*, int, float);
 
     /**
      * Set the event extra info field.
@@ -106,6 +106,8 @@ namespace Belle2 {
     std::vector<std::string> m_targetListNames; /**< input particle list names after decay descriptor*/
     std::string m_identifier; /**< weight-file */
     std::string m_extraInfoName; /**< Name under which the SignalProbability is stored in the extraInfo of the Particle object. */
+    int m_extraInfoKey = -1; /**< Key of m_extraInfoName in the extraInfo of the Particle object. */
+    std::vector<int> m_classExtraInfoKeys; /**< Keys of the extraInfo names for the outputs of a multiclass expert. */
     double m_signal_fraction_override; /**< Signal Fraction which should be used. < 0 means use signal fraction of training sample */
 
     std::vector<const Variable::Manager::Var*> m_feature_variables; /**< Pointers to the feature variables */
@@ -71,6 +71,7 @@ void MVAExpertModule::initialize()
   } else {
     StoreObjPtr<ParticleExtraInfoMap> extraInfo("", DataStore::c_Event);
     extraInfo.isRequired();
+    m_extraInfoKey = ParticleExtraInfoMap::getKey(m_extraInfoName);
   }
 
   if (not(boost::ends_with(m_identifier, ".root") or boost::ends_with(m_identifier, ".xml"))) {
@@ -122,6 +123,12 @@ void MVAExpertModule::init_mva(MVA::Weightfile& weightfile)
   dummy.resize(m_feature_variables.size(), 0);
   m_dataset = std::make_unique<MVA::SingleDataset>(general_options, dummy, 0);
   m_nClasses = general_options.m_nClasses;
+
+  m_classExtraInfoKeys.clear();
+  if (m_nClasses > 2 and not m_listNames.empty()) {
+    for (unsigned int iClass = 0; iClass < m_nClasses; iClass++)
+      m_classExtraInfoKeys.push_back(ParticleExtraInfoMap::getKey(m_extraInfoName + "_" + std::to_string(iClass)));
+  }
 }
 
 void MVAExpertModule::fillDataset(const Particle* particle)
@@ -158,26 +165,26 @@ std::vector<float> MVAExpertModule::analyseMulticlass(const Particle* particle)
   return m_expert->applyMulticlass(*m_dataset)[0];
 }
 
-void MVAExpertModule::setExtraInfoField(Particle* particle, std::string extraInfoName, float responseValue)
+void MVAExpertModule::setExtraInfoField(Particle* particle, int extraInfoKey, float responseValue)
 {
-  if (particle->hasExtraInfo(extraInfoName)) {
-    if (particle->getExtraInfo(extraInfoName) != responseValue) {
+  if (particle->hasExtraInfo(extraInfoKey)) {
+    if (particle->getExtraInfo(extraInfoKey) != responseValue) {
       m_existGivenExtraInfo = true;
-      double current = particle->getExtraInfo(extraInfoName);
+      double current = particle->getExtraInfo(extraInfoKey);
       if (m_overwriteExistingExtraInfo == -1) {
-        if (responseValue < current) particle->setExtraInfo(extraInfoName, responseValue);
+        if (responseValue < current) particle->setExtraInfo(extraInfoKey, responseValue);
       } else if (m_overwriteExistingExtraInfo == 0) {
         // don't overwrite!
       } else if (m_overwriteExistingExtraInfo == 1) {
-        if (responseValue > current) particle->setExtraInfo(extraInfoName, responseValue);
+        if (responseValue > current) particle->setExtraInfo(extraInfoKey, responseValue);
       } else if (m_overwriteExistingExtraInfo == 2) {
-        particle->setExtraInfo(extraInfoName, responseValue);
+        particle->setExtraInfo(extraInfoKey, responseValue);
       } else {
         B2FATAL("m_overwriteExistingExtraInfo must be one of {-1,0,1,2}. Received '" << m_overwriteExistingExtraInfo << "'.");
       }
     }
   } else {
-    particle->addExtraInfo(extraInfoName, responseValue);
+    particle->addExtraInfo(extraInfoKey, responseValue);
   }
 }
 
@@ -214,7 +221,7 @@ void MVAExpertModule::event()
       const Particle* particle = (nSelectedDaughters > 0) ? dd.getSelectionParticles(list->getParticle(i))[0] : list->getParticle(i);
       if (m_nClasses == 2) {
         float responseValue = analyse(particle);
-        setExtraInfoField(m_particles[particle->getArrayIndex()], m_extraInfoName, responseValue);
+        setExtraInfoField(m_particles[particle->getArrayIndex()], m_extraInfoKey, responseValue);
       } else if (m_nClasses > 2) {
         std::vector<float> responseValues = analyseMulticlass(particle);
         if (responseValues.size() != m_nClasses) {
@@ -222,7 +229,7 @@ void MVAExpertModule::event()
                   ") does not match the declared number of classes (" << m_nClasses << ").");
         }
         for (unsigned int iClass = 0; iClass < m_nClasses; iClass++) {
-          setExtraInfoField(m_particles[particle->getArrayIndex()], m_extraInfoName + "_" + std::to_string(iClass), responseValues[iClass]);
+          setExtraInfoField(m_particles[particle->getArrayIndex()], m_classExtraInfoKeys[iClass], responseValues[iClass]);
         }
       } else {
         B2ERROR("Received a value of " << m_nClasses <<
@@ -11,6 +11,8 @@
 #include <framework/gearbox/Unit.h>
 #include <genfit/AbsBField.h>
 
+#include <vector>
+
 /** Interface of the Belle II B-field with GenFit.
  */
 class GFGeant4Field : public genfit::AbsBField {
@@ -33,5 +35,26 @@ public:
     static double conversion{1. / Belle2::Unit::kGauss};
     return Belle2::B2Vector3D(Belle2::BFieldManager::getField(ROOT::Math::XYZVector(position)) * conversion);
   }
+
+  /** Getter for the magnetic field at several positions at once.
+   *
+   *  Uses the batched evaluation of the BFieldManager.
+   *  @param n          Number of positions.
+   *  @param positions  Array of 3*n coordinates of the positions.
+   *  @param fields     Array of 3*n field values in kGauss.
+   */
+  void getBatch(unsigned int n, const double* positions, double* fields) const override
+  {
+    static double conversion{1. / Belle2::Unit::kGauss};
+    thread_local std::vector<ROOT::Math::XYZVector> pos, field;
+    pos.resize(n);
+    for (unsigned int i = 0; i < n; ++i) pos[i].SetXYZ(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]);
+    Belle2::BFieldManager::getField(pos, field);
+    for (unsigned int i = 0; i < n; ++i) {
+      fields[3 * i] = field[i].X() * conversion;
+      fields[3 * i + 1] = field[i].Y() * conversion;
+      fields[3 * i + 2] = field[i].Z() * conversion;
+    }
+  }
 };
 
@@ -62,6 +62,12 @@ namespace Belle2 {
      * length was taken.
      */
     bool m_takingFullStep = false;
+
+    /** material of the last call to getMaterialParameters() */
+    const class G4Material* lastMaterial_ = nullptr;
+
+    /** parameters of lastMaterial_ */
+    genfit::Material lastMaterialParameters_;
   };
 
 }
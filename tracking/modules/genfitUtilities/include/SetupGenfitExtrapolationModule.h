@@ -53,6 +53,8 @@ namespace Belle2 {
     std::string m_mscModel = "Highland";
     /// Use VXD alignment from database?
     bool m_useVXDAlignment = true;
+    /// Evaluate the field at the midpoint and end point of each Runge-Kutta step in one call?
+    bool m_batchedFieldEvaluation = false;
     /// DB object with VXD alignment
     DBObjPtr<VXDAlignment> m_vxdAlignment;
   };
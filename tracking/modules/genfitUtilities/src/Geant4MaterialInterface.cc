@@ -306,6 +306,8 @@ Geant4MaterialInterface::getMaterialParameters()
   assert(currentVolume_);
 
   const G4Material* mat = currentVolume_->GetLogicalVolume()->GetMaterial();
+  // consecutive steps are mostly in the same material, so only calculate the parameters if it changed
+  if (mat == lastMaterial_) return lastMaterialParameters_;
 
   double density, Z, A, radiationLength, mEE;
   if (mat->GetNumberOfElements() == 1) {
@@ -326,7 +328,9 @@ Geant4MaterialInterface::getMaterialParameters()
   A *= CLHEP::mole / CLHEP::g;
   radiationLength = mat->GetRadlen() / CLHEP::cm;
   mEE = mat->GetIonisation()->GetMeanExcitationEnergy() / CLHEP::eV;
-  return genfit::Material(density, Z, A, radiationLength, mEE);
+  lastMaterial_ = mat;
+  lastMaterialParameters_ = genfit::Material(density, Z, A, radiationLength, mEE);
+  return lastMaterialParameters_;
 }
 
 
@@ -101,6 +101,10 @@ SetupGenfitExtrapolationModule::SetupGenfitExtrapolationModule() :
            "Multiple scattering model", m_mscModel);
   addParam("useVXDAlignment", m_useVXDAlignment,
            "Use VXD alignment from database?", m_useVXDAlignment);
+  addParam("batchedFieldEvaluation", m_batchedFieldEvaluation,
+           "Evaluate the magnetic field at the midpoint and the end point of each Runge-Kutta step in one call. "
+           "The end point is then predicted with the field at the start point, which changes the result slightly.",
+           m_batchedFieldEvaluation);
 }
 
 void SetupGenfitExtrapolationModule::initialize()
@@ -118,6 +122,7 @@ void SetupGenfitExtrapolationModule::initialize()
 
   genfit::FieldManager::getInstance()->init(new GFGeant4Field());
   genfit::FieldManager::getInstance()->useCache();
+  genfit::FieldManager::getInstance()->useBatchedStepping(m_batchedFieldEvaluation);
 
   if (!geometry::GeometryManager::getInstance().getTopVolume()) {
     B2FATAL("No geometry set up so far. Load the geometry module.");